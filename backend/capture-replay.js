@@ -0,0 +1,231 @@
+// Raw IMU Capture Replay
+// Reads .uadcap files recorded by the dashboard (dashboard/src/services/CaptureRecorder.js)
+// Frame layout: src/ble/capture_stream.h
+//
+// Usage: node capture-replay.js <file.uadcap>                   summary + gaps
+//        node capture-replay.js <file.uadcap> --csv out.csv     one row per sample
+//        node capture-replay.js <file.uadcap> --jsonl [--realtime]
+//            samples as JSON lines on stdout, paced like the recording with --realtime
+
+const fs = require('fs');
+
+const FRAME_START = 0x10;
+const FRAME_IMU = 0x11;
+const FRAME_AUDIO = 0x12;
+const FRAME_STOP = 0x13;
+const IMU_HEADER_LEN = 6;
+const SAMPLE_LEN = 12;
+const FILE_MAGIC = 'UADCAP';
+const FILE_VERSION = 1;
+
+const STOP_REASONS = ['REQUESTED', 'DISCONNECTED', 'UNSUBSCRIBED'];
+
+// ═══════════════════════════════════════════════════════════════════════════
+// FILE + FRAME PARSING
+// ═══════════════════════════════════════════════════════════════════════════
+
+function parseCaptureFile(buf) {
+    if (buf.length < 12 || buf.toString('latin1', 0, 6) !== FILE_MAGIC) {
+        throw new Error('Not a .uadcap file');
+    }
+    const version = buf.readUInt16LE(6);
+    if (version !== FILE_VERSION) throw new Error(`Unsupported .uadcap version ${version}`);
+
+    const metaLen = buf.readUInt32LE(8);
+    const meta = JSON.parse(buf.toString('utf8', 12, 12 + metaLen));
+
+    const records = [];
+    let pos = 12 + metaLen;
+    while (pos + 6 <= buf.length) {
+        const t = buf.readUInt32LE(pos);
+        const len = buf.readUInt16LE(pos + 4);
+        if (pos + 6 + len > buf.length) throw new Error(`Truncated record at offset ${pos}`);
+        records.push({ t, frame: buf.subarray(pos + 6, pos + 6 + len) });
+        pos += 6 + len;
+    }
+    return { meta, records };
+}
+
+function decodeCaptureFrame(f) {
+    switch (f[0]) {
+        case FRAME_START:
+            return {
+                type: 'start',
+                version: f[1],
+                odr: f.readUInt16LE(2),
+                accelLsbPerG: f.readUInt16LE(4),
+                gyroLsbPerDps: f.readUInt16LE(6) / 10,
+                t0Us: f.readUInt32LE(8),
+                audio: (f[12] & 0x01) !== 0
+            };
+
+        case FRAME_IMU: {
+            const count = f[1];
+            if (f.length !== IMU_HEADER_LEN + count * SAMPLE_LEN) {
+                throw new Error(`Capture frame length ${f.length} does not match ${count} samples`);
+            }
+            const samples = [];
+            for (let i = 0; i < count; i++) {
+                const p = IMU_HEADER_LEN + i * SAMPLE_LEN;
+                samples.push([0, 2, 4, 6, 8, 10].map(o => f.readInt16LE(p + o)));
+            }
+            return { type: 'imu', first: f.readUInt32LE(2), samples };
+        }
+
+        case FRAME_AUDIO:
+            return {
+                type: 'audio',
+                musical: (f[1] & 0x01) !== 0,
+                speech: (f[1] & 0x02) !== 0,
+                index: f.readUInt32LE(2),
+                dominantHz: f.readUInt16LE(6),
+                centroidHz: f.readUInt16LE(8),
+                harmonic: f.readUInt16LE(10) / 1000,
+                energy: f.readUInt16LE(12)
+            };
+
+        case FRAME_STOP:
+            return {
+                type: 'stop',
+                reason: STOP_REASONS[f[1]] || `0x${f[1].toString(16)}`,
+                captured: f.readUInt32LE(2),
+                lost: f.readUInt32LE(6)
+            };
+
+        default:
+            return { type: 'unknown', id: f[0] };
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// REPLAY
+// Calls onSample({ index, t, ax, ay, az, gx, gy, gz }) in g and deg/s,
+// t in seconds since the first sample (index / odr: the IMU is the clock)
+// ═══════════════════════════════════════════════════════════════════════════
+
+function replay(capture, onSample, onAudio) {
+    const summary = { start: null, stop: null, samples: 0, gaps: [], missing: 0, audio: 0, bad: 0 };
+    let expected = 0;
+
+    for (const { t, frame } of capture.records) {
+        let msg;
+        try {
+            msg = decodeCaptureFrame(frame);
+        } catch (e) {
+            summary.bad++;
+            continue;
+        }
+
+        if (msg.type === 'start') {
+            summary.start = msg;
+        } else if (msg.type === 'imu') {
+            const info = summary.start;
+            if (!info) {
+                summary.bad++;
+                continue;
+            }
+            if (msg.first > expected) {
+                summary.gaps.push({ index: expected, count: msg.first - expected, t: expected / info.odr });
+                summary.missing += msg.first - expected;
+            }
+            msg.samples.forEach((s, i) => {
+                const index = msg.first + i;
+                if (onSample) {
+                    onSample({
+                        index,
+                        t: index / info.odr,
+                        rx_ms: t,
+                        ax: s[0] / info.accelLsbPerG,
+                        ay: s[1] / info.accelLsbPerG,
+                        az: s[2] / info.accelLsbPerG,
+                        gx: s[3] / info.gyroLsbPerDps,
+                        gy: s[4] / info.gyroLsbPerDps,
+                        gz: s[5] / info.gyroLsbPerDps
+                    });
+                }
+            });
+            expected = msg.first + msg.samples.length;
+            summary.samples += msg.samples.length;
+        } else if (msg.type === 'audio') {
+            summary.audio++;
+            if (onAudio) onAudio(msg);
+        } else if (msg.type === 'stop') {
+            summary.stop = msg;
+        } else {
+            summary.bad++;
+        }
+    }
+    return summary;
+}
+
+function printSummary(meta, s) {
+    const odr = s.start ? s.start.odr : 0;
+    console.log(`[CAPTURE] "${meta.label}" from ${meta.device || '?'} at ${meta.started}`);
+    console.log(`[CAPTURE] ${odr} Hz, ${s.samples} samples (${odr ? (s.samples / odr).toFixed(1) : '?'} s), ` +
+                `${s.missing} missing in ${s.gaps.length} gap(s), ${s.audio} audio frame(s)`);
+    for (const g of s.gaps.slice(0, 10)) {
+        console.log(`[CAPTURE]   gap at #${g.index} (${g.t.toFixed(3)} s): ${g.count} sample(s)`);
+    }
+    if (s.gaps.length > 10) console.log(`[CAPTURE]   ... ${s.gaps.length - 10} more`);
+    if (s.stop) {
+        console.log(`[CAPTURE] Device: ${s.stop.captured} captured, ${s.stop.lost} lost, stop ${s.stop.reason}`);
+    } else {
+        console.log('[CAPTURE] ⚠️ No STOP frame: the recording ended before the device finished');
+    }
+    if (s.bad) console.log(`[CAPTURE] ⚠️ ${s.bad} undecodable frame(s)`);
+}
+
+if (require.main === module) {
+    const args = process.argv.slice(2);
+    const file = args.find(a => !a.startsWith('--'));
+    if (!file) {
+        console.error('Usage: node capture-replay.js <file.uadcap> [--csv out.csv | --jsonl [--realtime]]');
+        process.exit(1);
+    }
+
+    let capture;
+    try {
+        capture = parseCaptureFile(fs.readFileSync(file));
+    } catch (err) {
+        console.error(`[CAPTURE] ❌ ${err.message}`);
+        process.exit(1);
+    }
+
+    const csvIdx = args.indexOf('--csv');
+    if (csvIdx >= 0) {
+        const out = fs.createWriteStream(args[csvIdx + 1]);
+        out.write('index,t,ax_g,ay_g,az_g,gx_dps,gy_dps,gz_dps,label\n');
+        const label = capture.meta.label;
+        const summary = replay(capture, (s) => {
+            out.write(`${s.index},${s.t.toFixed(6)},${s.ax.toFixed(5)},${s.ay.toFixed(5)},${s.az.toFixed(5)},` +
+                      `${s.gx.toFixed(3)},${s.gy.toFixed(3)},${s.gz.toFixed(3)},${label}\n`);
+        });
+        out.end();
+        printSummary(capture.meta, summary);
+    } else if (args.includes('--jsonl')) {
+        // Summary to stderr, stdout stays machine readable
+        const lines = [];
+        const summary = replay(capture, (s) => lines.push(s));
+        console.log = console.error;
+        printSummary(capture.meta, summary);
+
+        if (!args.includes('--realtime')) {
+            for (const s of lines) process.stdout.write(JSON.stringify(s) + '\n');
+        } else {
+            // Same pace as the phone received them
+            const begin = Date.now();
+            let i = 0;
+            const tick = () => {
+                while (i < lines.length && lines[i].rx_ms <= Date.now() - begin) {
+                    process.stdout.write(JSON.stringify(lines[i++]) + '\n');
+                }
+                if (i < lines.length) setTimeout(tick, 5);
+            };
+            tick();
+        }
+    } else {
+        printSummary(capture.meta, replay(capture));
+    }
+}
+
+module.exports = { parseCaptureFile, decodeCaptureFrame, replay };
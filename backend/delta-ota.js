@@ -0,0 +1,285 @@
+// Delta OTA Patches
+// Binary diff of a new firmware against the one a device runs (format:
+// src/ota_delta.h). A mode switch only swaps current_module.h, so the new
+// image is mostly the old one with code moved: new bytes are aligned to old
+// ones through a hash index of 8-byte runs, aligned bytes travel as
+// differences (runs without difference become COPY), the rest as INSERT.
+//
+// Usage: node delta-ota.js <old.bin> <new.bin> [out.patch]
+//            patch size, ratio and a round trip check
+
+const crypto = require('crypto');
+const fs = require('fs');
+const path = require('path');
+
+const MAGIC = 'UADD';
+const VERSION = 1;
+const HEADER_LEN = 45;
+const OP_END = 0x00;
+const OP_COPY = 0x01;
+const OP_ADD = 0x02;
+const OP_INSERT = 0x03;
+const OP_SEEK = 0x04;
+
+const K = 8;                // Bytes per index entry
+const WINDOW = 16;          // Alignment holds while half of the next WINDOW bytes match
+const MIN_COPY = 4;         // Shorter zero runs stay inside ADD
+const TABLE_BITS = 22;
+
+const sha256 = (buf) => crypto.createHash('sha256').update(buf).digest();
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ENCODER
+// ═══════════════════════════════════════════════════════════════════════════
+
+class PatchWriter {
+    constructor() {
+        this.buf = Buffer.alloc(65536);
+        this.len = 0;
+    }
+
+    reserve(n) {
+        if (this.len + n <= this.buf.length) return;
+        const next = Buffer.alloc(Math.max(this.buf.length * 2, this.len + n));
+        this.buf.copy(next, 0, 0, this.len);
+        this.buf = next;
+    }
+
+    byte(b) {
+        this.reserve(1);
+        this.buf[this.len++] = b;
+    }
+
+    varint(v) {
+        do {
+            const b = v & 0x7F;
+            v = Math.floor(v / 128);
+            this.byte(v ? b | 0x80 : b);
+        } while (v);
+    }
+
+    bytes(src) {
+        this.reserve(src.length);
+        for (let i = 0; i < src.length; i++) this.buf[this.len++] = src[i];
+    }
+
+    result() {
+        return this.buf.subarray(0, this.len);
+    }
+}
+
+function hashAt(buf, p) {
+    const a = buf.readUInt32LE(p);
+    const b = buf.readUInt32LE(p + 4);
+    return (Math.imul(a, 0x9E3779B1) ^ Math.imul(b ^ (a >>> 15), 0x85EBCA6B)) >>> (32 - TABLE_BITS);
+}
+
+// First occurrence of every K-byte run of the old image
+function buildIndex(oldBuf) {
+    const table = new Int32Array(1 << TABLE_BITS).fill(-1);
+    for (let p = 0; p + K <= oldBuf.length; p++) {
+        const h = hashAt(oldBuf, p);
+        if (table[h] < 0) table[h] = p;
+    }
+    return table;
+}
+
+function makePatch(oldBuf, newBuf) {
+    const table = buildIndex(oldBuf);
+    const out = new PatchWriter();
+
+    const header = Buffer.alloc(HEADER_LEN);
+    header.write(MAGIC, 0, 'latin1');
+    header[4] = VERSION;
+    header.writeUInt32LE(newBuf.length, 5);
+    header.writeUInt32LE(oldBuf.length, 9);
+    sha256(oldBuf).copy(header, 13);
+    out.bytes(header);
+
+    let devicePos = 0;          // Old position the device is at
+    let diff = [];              // Aligned bytes: new - old
+    let diffStart = 0;
+    let literal = [];
+
+    const flushLiteral = () => {
+        if (!literal.length) return;
+        out.byte(OP_INSERT);
+        out.varint(literal.length);
+        out.bytes(literal);
+        literal = [];
+    };
+
+    const flushAligned = () => {
+        if (!diff.length) return;
+        if (diffStart !== devicePos) {
+            const delta = diffStart - devicePos;
+            out.byte(OP_SEEK);
+            out.varint(delta >= 0 ? delta * 2 : -delta * 2 - 1);
+        }
+        let k = 0;
+        while (k < diff.length) {
+            let e = k;
+            if (diff[k] === 0) {
+                while (e < diff.length && diff[e] === 0) e++;
+                out.byte(OP_COPY);
+                out.varint(e - k);
+            } else {
+                // Until a zero run long enough to pay for COPY + a new ADD
+                while (e < diff.length) {
+                    if (diff[e] !== 0) {
+                        e++;
+                        continue;
+                    }
+                    let z = e;
+                    while (z < diff.length && diff[z] === 0) z++;
+                    if (z - e >= MIN_COPY || z === diff.length) break;
+                    e = z;
+                }
+                out.byte(OP_ADD);
+                out.varint(e - k);
+                out.bytes(diff.slice(k, e));
+            }
+            k = e;
+        }
+        devicePos = diffStart + diff.length;
+        diff = [];
+    };
+
+    const aligned = (i, j) => {
+        const w = Math.min(WINDOW, newBuf.length - i, oldBuf.length - j);
+        if (w <= 0) return false;
+        let matches = 0;
+        for (let k = 0; k < w; k++) if (newBuf[i + k] === oldBuf[j + k]) matches++;
+        return matches > 0 && matches * 2 >= w;
+    };
+
+    const lookup = (i) => {
+        if (i + K > newBuf.length) return -1;
+        const p = table[hashAt(newBuf, i)];
+        if (p < 0) return -1;
+        for (let k = 0; k < K; k++) if (newBuf[i + k] !== oldBuf[p + k]) return -1;
+        return p;
+    };
+
+    let i = 0;
+    let j = 0;
+    while (i < newBuf.length) {
+        if (aligned(i, j)) {
+            flushLiteral();
+            if (!diff.length) diffStart = j;
+            diff.push((newBuf[i] - oldBuf[j]) & 0xFF);
+            i++;
+            j++;
+            continue;
+        }
+        const p = lookup(i);
+        if (p >= 0 && p !== j) {
+            flushAligned();
+            j = p;
+            continue;
+        }
+        flushAligned();
+        literal.push(newBuf[i]);
+        i++;
+    }
+    flushAligned();
+    flushLiteral();
+    out.byte(OP_END);
+    return Buffer.from(out.result());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DECODER (round trip check, same rules as DeltaPatcher)
+// ═══════════════════════════════════════════════════════════════════════════
+
+function applyPatch(oldBuf, patch) {
+    if (patch.toString('latin1', 0, 4) !== MAGIC || patch[4] !== VERSION) throw new Error('Not a delta patch');
+    if (patch.readUInt32LE(9) !== oldBuf.length || !sha256(oldBuf).equals(patch.subarray(13, HEADER_LEN))) {
+        throw new Error('Patch made for another base image');
+    }
+    const out = Buffer.alloc(patch.readUInt32LE(5));
+    let p = HEADER_LEN;
+    let o = 0;
+    let pos = 0;
+    const varint = () => {
+        let v = 0;
+        let mul = 1;
+        for (;;) {
+            const b = patch[p++];
+            v += (b & 0x7F) * mul;
+            if (!(b & 0x80)) return v;
+            mul *= 128;
+        }
+    };
+    for (;;) {
+        const op = patch[p++];
+        if (op === OP_END) break;
+        const n = varint();
+        if (op === OP_SEEK) {
+            pos += n & 1 ? -(n + 1) / 2 : n / 2;
+        } else if (op === OP_COPY) {
+            oldBuf.copy(out, o, pos, pos + n);
+            pos += n;
+            o += n;
+        } else if (op === OP_ADD) {
+            for (let k = 0; k < n; k++) out[o++] = (oldBuf[pos++] + patch[p++]) & 0xFF;
+        } else if (op === OP_INSERT) {
+            patch.copy(out, o, p, p + n);
+            p += n;
+            o += n;
+        } else {
+            throw new Error(`Bad op 0x${op.toString(16)} at ${p - 1}`);
+        }
+    }
+    if (o !== out.length) throw new Error('Patch ended early');
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BASE LOOKUP (every image the backend ever built is a possible base)
+// ═══════════════════════════════════════════════════════════════════════════
+
+const shaCache = new Map();     // file → { mtime, sha }
+
+function findImageBySha(dir, shaHex) {
+    if (!shaHex || !fs.existsSync(dir)) return null;
+    shaHex = shaHex.toLowerCase();
+    for (const name of fs.readdirSync(dir)) {
+        if (!name.endsWith('.bin')) continue;
+        const file = path.join(dir, name);
+        const mtime = fs.statSync(file).mtimeMs;
+        let entry = shaCache.get(file);
+        if (!entry || entry.mtime !== mtime) {
+            entry = { mtime, sha: sha256(fs.readFileSync(file)).toString('hex') };
+            shaCache.set(file, entry);
+        }
+        if (entry.sha === shaHex) return file;
+    }
+    return null;
+}
+
+module.exports = { makePatch, applyPatch, findImageBySha, sha256 };
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════
+
+if (require.main === module) {
+    const [oldFile, newFile, outFile] = process.argv.slice(2);
+    if (!oldFile || !newFile) {
+        console.log('Usage: node delta-ota.js <old.bin> <new.bin> [out.patch]');
+        process.exit(1);
+    }
+    const oldBuf = fs.readFileSync(oldFile);
+    const newBuf = fs.readFileSync(newFile);
+    const start = Date.now();
+    const patch = makePatch(oldBuf, newBuf);
+    const ms = Date.now() - start;
+    if (!applyPatch(oldBuf, patch).equals(newBuf)) {
+        console.error('❌ Round trip failed');
+        process.exit(1);
+    }
+    console.log(`${newFile}: ${newBuf.length} bytes → patch ${patch.length} bytes ` +
+                `(${(patch.length * 100 / newBuf.length).toFixed(1)}%), ${ms} ms`);
+    if (outFile) fs.writeFileSync(outFile, patch);
+}
@@ -0,0 +1,284 @@
+// Telemetry Schema Codecs
+// GENERATED by backend/schema-codegen.js from backend/schemas/*.json - do not edit
+// Decodes FRAME_SCHEMA uplinks (src/lora/schema_frame.h) for every schema version
+
+const FRAME_SCHEMA = 0xA2;
+const SCHEMA_HEADER_LEN = 8;
+const SCHEMA_MAX_PAYLOAD = 222;
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BIT STREAM (MSB first, mirrors src/lora/schema_frame.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class BitWriter {
+    constructor(buf, start) {
+        this.buf = buf;
+        this.pos = start * 8;
+    }
+
+    writeBits(v, bits) {
+        if (this.pos + bits > this.buf.length * 8) throw new RangeError('Schema frame full');
+        for (let i = bits - 1; i >= 0; i--) {
+            if (Math.floor(v / 2 ** i) % 2) this.buf[this.pos >> 3] |= 0x80 >> (this.pos & 7);
+            this.pos++;
+        }
+    }
+
+    writeBool(v) {
+        this.writeBits(v ? 1 : 0, 1);
+    }
+
+    writeVarint(v, group) {
+        do {
+            this.writeBits(v % 2 ** group, group);
+            v = Math.floor(v / 2 ** group);
+            this.writeBits(v ? 1 : 0, 1);
+        } while (v);
+    }
+
+    byteLength() {
+        return (this.pos + 7) >> 3;
+    }
+}
+
+class BitReader {
+    constructor(buf, start) {
+        this.buf = buf;
+        this.pos = start * 8;
+        this.end = buf.length * 8;
+    }
+
+    readBits(bits) {
+        if (this.pos + bits > this.end) throw new Error('Truncated schema frame');
+        let v = 0;
+        for (let i = 0; i < bits; i++) {
+            v = v * 2 + ((this.buf[this.pos >> 3] >> (7 - (this.pos & 7))) & 1);
+            this.pos++;
+        }
+        return v;
+    }
+
+    readBool() {
+        return this.readBits(1) === 1;
+    }
+
+    readVarint(group) {
+        let v = 0;
+        for (let shift = 0; shift < 32; shift += group) {
+            v += this.readBits(group) * 2 ** shift;
+            if (!this.readBits(1)) return v;
+        }
+        throw new Error('Overlong varint in schema frame');
+    }
+
+    // Only zero padding may follow the last record
+    atEnd() {
+        return this.end - this.pos < 8;
+    }
+}
+
+function quantize(v, min, step, maxQ) {
+    const q = Math.floor((v - min) / step + 0.5);
+    if (!(q >= 0)) return 0;
+    return q > maxQ ? maxQ : q;
+}
+
+function zigzag(v) {
+    return v >= 0 ? v * 2 : -v * 2 - 1;
+}
+
+function unzigzag(v) {
+    return (v % 2) ? -((v + 1) / 2) : v / 2;
+}
+
+function enumIndex(values, v, name) {
+    const i = typeof v === 'number' ? v : values.indexOf(v);
+    if (!(i >= 0 && i < values.length)) throw new Error(`Bad value for ${name}: ${v}`);
+    return i;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// SCHEMA REGISTRY
+// ═══════════════════════════════════════════════════════════════════════════
+
+const SCHEMAS = [
+    // tracker v1 (id 1): 23..142 bits per record
+    {
+        name: 'tracker',
+        id: 1,
+        version: 1,
+        fields: [
+            {"name":"state","type":"enum","values":["IDLE","ACTIVE","MONITORING","ALERT","LOW_POWER"]},
+            {"name":"battery","type":"scaled","min":0,"max":100,"step":0.5,"unit":"%"},
+            {"name":"alert","type":"bool"},
+            {"name":"motion","type":"scaled","min":0,"max":4,"step":0.01,"unit":"g"},
+            {"name":"gps_valid","type":"bool"},
+            {"name":"latitude","type":"delta","min":-90,"max":90,"step":0.00001,"unit":"deg","when":"gps_valid"},
+            {"name":"longitude","type":"delta","min":-180,"max":180,"step":0.00001,"unit":"deg","when":"gps_valid"},
+            {"name":"speed","type":"scaled","min":0,"max":255,"step":0.5,"unit":"km/h","when":"gps_valid"},
+            {"name":"heading","type":"scaled","min":0,"max":360,"step":1.5,"unit":"deg","when":"gps_valid"},
+            {"name":"parked","type":"bool"},
+            {"name":"parked_latitude","type":"delta","min":-90,"max":90,"step":0.00001,"unit":"deg","when":"parked"},
+            {"name":"parked_longitude","type":"delta","min":-180,"max":180,"step":0.00001,"unit":"deg","when":"parked"}
+        ],
+        encode(w, r, s) {
+            w.writeBits(enumIndex(["IDLE","ACTIVE","MONITORING","ALERT","LOW_POWER"], r.state, 'state'), 3);
+            w.writeBits(quantize(r.battery, 0, 0.5, 200), 8);
+            w.writeBool(r.alert);
+            w.writeBits(quantize(r.motion, 0, 0.01, 400), 9);
+            w.writeBool(r.gps_valid);
+            if (r.gps_valid) {
+                const latitude = quantize(r.latitude, -90, 0.00001, 18000000);
+                if ('latitude' in s) w.writeVarint(zigzag(latitude - s.latitude), 7);
+                else w.writeBits(latitude, 25);
+                s.latitude = latitude;
+                const longitude = quantize(r.longitude, -180, 0.00001, 36000000);
+                if ('longitude' in s) w.writeVarint(zigzag(longitude - s.longitude), 7);
+                else w.writeBits(longitude, 26);
+                s.longitude = longitude;
+                w.writeBits(quantize(r.speed, 0, 0.5, 510), 9);
+                w.writeBits(quantize(r.heading, 0, 1.5, 240), 8);
+            }
+            w.writeBool(r.parked);
+            if (r.parked) {
+                const parked_latitude = quantize(r.parked_latitude, -90, 0.00001, 18000000);
+                if ('parked_latitude' in s) w.writeVarint(zigzag(parked_latitude - s.parked_latitude), 7);
+                else w.writeBits(parked_latitude, 25);
+                s.parked_latitude = parked_latitude;
+                const parked_longitude = quantize(r.parked_longitude, -180, 0.00001, 36000000);
+                if ('parked_longitude' in s) w.writeVarint(zigzag(parked_longitude - s.parked_longitude), 7);
+                else w.writeBits(parked_longitude, 26);
+                s.parked_longitude = parked_longitude;
+            }
+        },
+        decode(rd, s) {
+            const r = {};
+            r.state = ["IDLE","ACTIVE","MONITORING","ALERT","LOW_POWER"][rd.readBits(3)];
+            if (r.state === undefined) throw new Error('Bad state in schema frame');
+            r.battery = +(rd.readBits(8) * 0.5).toFixed(1);
+            r.alert = rd.readBool();
+            r.motion = +(rd.readBits(9) * 0.01).toFixed(2);
+            r.gps_valid = rd.readBool();
+            if (r.gps_valid) {
+                const latitude = ('latitude' in s) ? s.latitude + unzigzag(rd.readVarint(7)) : rd.readBits(25);
+                s.latitude = latitude;
+                r.latitude = +(-90 + latitude * 0.00001).toFixed(5);
+                const longitude = ('longitude' in s) ? s.longitude + unzigzag(rd.readVarint(7)) : rd.readBits(26);
+                s.longitude = longitude;
+                r.longitude = +(-180 + longitude * 0.00001).toFixed(5);
+                r.speed = +(rd.readBits(9) * 0.5).toFixed(1);
+                r.heading = +(rd.readBits(8) * 1.5).toFixed(1);
+            } else {
+                r.latitude = null;
+                r.longitude = null;
+                r.speed = null;
+                r.heading = null;
+            }
+            r.parked = rd.readBool();
+            if (r.parked) {
+                const parked_latitude = ('parked_latitude' in s) ? s.parked_latitude + unzigzag(rd.readVarint(7)) : rd.readBits(25);
+                s.parked_latitude = parked_latitude;
+                r.parked_latitude = +(-90 + parked_latitude * 0.00001).toFixed(5);
+                const parked_longitude = ('parked_longitude' in s) ? s.parked_longitude + unzigzag(rd.readVarint(7)) : rd.readBits(26);
+                s.parked_longitude = parked_longitude;
+                r.parked_longitude = +(-180 + parked_longitude * 0.00001).toFixed(5);
+            } else {
+                r.parked_latitude = null;
+                r.parked_longitude = null;
+            }
+            return r;
+        }
+    },
+    // vehicle v1 (id 2): 12..20 bits per record
+    {
+        name: 'vehicle',
+        id: 2,
+        version: 1,
+        fields: [
+            {"name":"vibration","type":"scaled","min":0,"max":8,"step":0.01,"unit":"g"},
+            {"name":"idle","type":"bool"},
+            {"name":"crash","type":"bool"},
+            {"name":"crash_peak","type":"scaled","min":0,"max":16,"step":0.1,"unit":"g","when":"crash"}
+        ],
+        encode(w, r, s) {
+            w.writeBits(quantize(r.vibration, 0, 0.01, 800), 10);
+            w.writeBool(r.idle);
+            w.writeBool(r.crash);
+            if (r.crash) {
+                w.writeBits(quantize(r.crash_peak, 0, 0.1, 160), 8);
+            }
+        },
+        decode(rd, s) {
+            const r = {};
+            r.vibration = +(rd.readBits(10) * 0.01).toFixed(2);
+            r.idle = rd.readBool();
+            r.crash = rd.readBool();
+            if (r.crash) {
+                r.crash_peak = +(rd.readBits(8) * 0.1).toFixed(1);
+            } else {
+                r.crash_peak = null;
+            }
+            return r;
+        }
+    }
+];
+
+// ═══════════════════════════════════════════════════════════════════════════
+// FRAMES
+// ═══════════════════════════════════════════════════════════════════════════
+
+function findSchema(id, version) {
+    return SCHEMAS.find(s => s.id === id && s.version === version) || null;
+}
+
+function decodeSchemaFrame(buf) {
+    if (buf.length < SCHEMA_HEADER_LEN || buf[0] !== FRAME_SCHEMA) {
+        throw new Error('Not a schema frame');
+    }
+
+    const schema = findSchema(buf[5], buf[6]);
+    if (!schema) throw new Error(`Unknown schema id ${buf[5]} version ${buf[6]}`);
+
+    const reader = new BitReader(buf, SCHEMA_HEADER_LEN);
+    const state = {};
+    const records = [];
+    for (let i = 0; i < buf[7]; i++) records.push(schema.decode(reader, state));
+
+    if (!reader.atEnd()) throw new Error('Trailing bytes in schema frame');
+
+    return {
+        type: 'schema',
+        schema: schema.name,
+        schemaId: schema.id,
+        version: schema.version,
+        deviceId: buf[1] | (buf[2] << 8),
+        seq: buf[3] | (buf[4] << 8),
+        records
+    };
+}
+
+// Latest version of the named schema; throws if the records do not fit
+function encodeSchemaFrame(name, deviceId, seq, records, maxLen = SCHEMA_MAX_PAYLOAD) {
+    const versions = SCHEMAS.filter(s => s.name === name);
+    if (!versions.length) throw new Error(`Unknown schema ${name}`);
+    const schema = versions[versions.length - 1];
+    if (records.length > 255) throw new RangeError('Too many records');
+
+    const buf = new Uint8Array(maxLen);
+    buf.set([FRAME_SCHEMA, deviceId & 0xFF, deviceId >> 8, seq & 0xFF, seq >> 8,
+             schema.id, schema.version, records.length]);
+
+    const writer = new BitWriter(buf, SCHEMA_HEADER_LEN);
+    const state = {};
+    for (const r of records) schema.encode(writer, r, state);
+    return buf.slice(0, writer.byteLength());
+}
+
+module.exports = {
+    FRAME_SCHEMA,
+    SCHEMA_HEADER_LEN,
+    SCHEMAS,
+    findSchema,
+    decodeSchemaFrame,
+    encodeSchemaFrame
+};
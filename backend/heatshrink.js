@@ -0,0 +1,166 @@
+// Heatshrink (LZSS) Compression
+// Bit stream of the heatshrink format, decoded on the device with a
+// 2^windowBits byte window (src/ota_heatshrink.h):
+//   1 + 8 bits           literal byte
+//   0 + W bits + L bits  copy (count + 1) bytes from (index + 1) back
+// MSB first, the last byte zero padded. No header: both sides use the same
+// windowBits / lookaheadBits.
+//
+// Usage: node heatshrink.js <firmware.bin> [windowBits] [lookaheadBits]
+//            compressed size, compress / decompress time, round trip check
+//            (device decoder throughput: test/test_ota_delta [BENCH])
+
+const MIN_MATCH_CHAIN = 64;     // Hash chain entries tried per position
+
+class BitWriter {
+    constructor(capacity) {
+        this.buf = Buffer.alloc(Math.max(16, capacity));
+        this.len = 0;
+        this.acc = 0;
+        this.bits = 0;
+    }
+
+    put(value, count) {
+        for (let i = count - 1; i >= 0; i--) {
+            this.acc = (this.acc << 1) | ((value >> i) & 1);
+            if (++this.bits === 8) this.flushByte();
+        }
+    }
+
+    flushByte() {
+        if (this.len === this.buf.length) {
+            const next = Buffer.alloc(this.buf.length * 2);
+            this.buf.copy(next);
+            this.buf = next;
+        }
+        this.buf[this.len++] = this.acc & 0xFF;
+        this.acc = 0;
+        this.bits = 0;
+    }
+
+    finish() {
+        if (this.bits) {
+            this.acc <<= 8 - this.bits;
+            this.flushByte();
+        }
+        return Buffer.from(this.buf.subarray(0, this.len));
+    }
+}
+
+function compress(input, windowBits, lookaheadBits) {
+    const windowSize = 1 << windowBits;
+    const maxLen = 1 << lookaheadBits;
+    // A copy must cost fewer bits than the literals it replaces
+    const minLen = Math.floor((1 + windowBits + lookaheadBits) / 9) + 1;
+
+    const out = new BitWriter(input.length >> 1);
+    const head = new Int32Array(1 << 16).fill(-1);
+    const prev = new Int32Array(input.length);
+    const hash = (i) => (input[i] << 8) | input[i + 1];
+
+    let i = 0;
+    const insert = (p) => {
+        if (p + 1 >= input.length) return;
+        const h = hash(p);
+        prev[p] = head[h];
+        head[h] = p;
+    };
+
+    while (i < input.length) {
+        let bestLen = 0;
+        let bestPos = 0;
+        if (i + 1 < input.length) {
+            let cand = head[hash(i)];
+            let tries = MIN_MATCH_CHAIN;
+            const limit = Math.min(maxLen, input.length - i);
+            while (cand >= 0 && i - cand <= windowSize && tries-- > 0) {
+                let len = 0;
+                while (len < limit && input[cand + len] === input[i + len]) len++;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestPos = cand;
+                    if (len === limit) break;
+                }
+                cand = prev[cand];
+            }
+        }
+
+        if (bestLen >= minLen) {
+            out.put(0, 1);
+            out.put(i - bestPos - 1, windowBits);
+            out.put(bestLen - 1, lookaheadBits);
+            for (let k = 0; k < bestLen; k++) insert(i + k);
+            i += bestLen;
+        } else {
+            out.put(1, 1);
+            out.put(input[i], 8);
+            insert(i);
+            i++;
+        }
+    }
+    return out.finish();
+}
+
+function decompress(input, windowBits, lookaheadBits) {
+    const out = [];
+    let pos = 0;
+    let acc = 0;
+    let bits = 0;
+    const get = (count) => {
+        let v = 0;
+        for (let k = 0; k < count; k++) {
+            if (bits === 0) {
+                if (pos >= input.length) return -1;
+                acc = input[pos++];
+                bits = 8;
+            }
+            v = (v << 1) | ((acc >> --bits) & 1);
+        }
+        return v;
+    };
+    for (;;) {
+        const tag = get(1);
+        if (tag < 0) break;
+        if (tag) {
+            const b = get(8);
+            if (b < 0) break;
+            out.push(b);
+        } else {
+            const index = get(windowBits);
+            const count = index < 0 ? -1 : get(lookaheadBits);
+            if (count < 0) break;
+            for (let k = 0; k <= count; k++) out.push(out[out.length - index - 1]);
+        }
+    }
+    return Buffer.from(out);
+}
+
+module.exports = { compress, decompress };
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════
+
+if (require.main === module) {
+    const [file, w = '10', l = '5'] = process.argv.slice(2);
+    if (!file) {
+        console.log('Usage: node heatshrink.js <firmware.bin> [windowBits] [lookaheadBits]');
+        process.exit(1);
+    }
+    const input = require('fs').readFileSync(file);
+    const windowBits = Number(w);
+    const lookaheadBits = Number(l);
+    let start = Date.now();
+    const packed = compress(input, windowBits, lookaheadBits);
+    const compressMs = Date.now() - start;
+    start = Date.now();
+    const unpacked = decompress(packed, windowBits, lookaheadBits);
+    const decompressMs = Date.now() - start;
+    if (!unpacked.equals(input)) {
+        console.error('❌ Round trip failed');
+        process.exit(1);
+    }
+    console.log(`${file}: ${input.length} → ${packed.length} bytes ` +
+                `(${(packed.length * 100 / input.length).toFixed(1)}%), W${windowBits} L${lookaheadBits}, ` +
+                `compress ${compressMs} ms, decompress ${decompressMs} ms`);
+}
@@ -0,0 +1,189 @@
+// LoRa Frame Decoder (gateway side)
+// Mirrors src/lora/telemetry_frame.h and the legacy UAD_Packet in include/types.h
+// Schema frames are decoded by generated_schemas/ (node schema-codegen.js)
+
+const { FRAME_SCHEMA, decodeSchemaFrame } = require('./generated_schemas');
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CONSTANTS (keep in sync with include/types.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+const FRAME_TELEMETRY = 0xA1;
+const FRAME_MESH = 0xB0;
+const MESH_HEADER_LEN = 7;
+const TELEMETRY_HEADER_LEN = 14;
+const LEGACY_PACKET_LEN = 6;
+
+const STATUS_NAMES = ['OK', 'SOS', 'LOW_BATT', 'FALL', 'IMPACT', 'THEFT'];
+const CONTEXT_NAMES = ['UNKNOWN', 'HELMET', 'BICYCLE', 'ASSET', 'VEHICLE'];
+const PRIORITY_NAMES = ['ALERT', 'STATUS', 'ROUTINE'];
+
+// ═══════════════════════════════════════════════════════════════════════════
+// VARINT HELPERS
+// ═══════════════════════════════════════════════════════════════════════════
+
+function readVarint(buf, pos) {
+    let value = 0;
+    for (let i = 0; i < 5 && pos + i < buf.length; i++) {
+        const b = buf[pos + i];
+        value += (b & 0x7F) * 2 ** (7 * i);
+        if (!(b & 0x80)) return { value, size: i + 1 };
+    }
+    throw new Error(`Truncated varint at offset ${pos}`);
+}
+
+function unzigzag(v) {
+    return (v % 2) ? -((v + 1) / 2) : v / 2;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// LEGACY 6-BYTE PACKET
+// ═══════════════════════════════════════════════════════════════════════════
+
+function decodeLegacyPacket(buf) {
+    return {
+        type: 'packet',
+        deviceId: buf[0],
+        context: CONTEXT_NAMES[buf[1]] || buf[1],
+        status: STATUS_NAMES[buf[2]] || buf[2],
+        value: buf.readUInt16LE(3),
+        battery: buf[5]
+    };
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BATCHED TELEMETRY FRAME
+// ═══════════════════════════════════════════════════════════════════════════
+
+function decodeTelemetryFrame(buf) {
+    if (buf.length < TELEMETRY_HEADER_LEN || buf[0] !== FRAME_TELEMETRY) {
+        throw new Error('Not a telemetry frame');
+    }
+
+    const frame = {
+        type: 'telemetry',
+        deviceId: buf.readUInt16LE(1),
+        seq: buf.readUInt16LE(3),
+        context: CONTEXT_NAMES[buf[5]] || buf[5],
+        battery: buf[6],
+        t0: buf.readUInt32LE(7),
+        periodMs: buf.readUInt16LE(11),
+        samples: [],
+        events: []
+    };
+
+    const count = buf[13];
+    let pos = TELEMETRY_HEADER_LEN;
+    let prev = 0;
+    let slot = 0;
+
+    for (let i = 0; i < count; i++) {
+        const tag = readVarint(buf, pos);
+        pos += tag.size;
+        const t = frame.t0 + slot * frame.periodMs;
+
+        if (tag.value % 2) {
+            const status = buf[pos++];
+            const val = readVarint(buf, pos);
+            pos += val.size;
+            frame.events.push({ t, status: STATUS_NAMES[status] || status, value: val.value });
+        } else {
+            prev = (prev + unzigzag(tag.value / 2)) & 0xFFFF;
+            frame.samples.push({ t, value: prev });
+            slot++;
+        }
+    }
+
+    if (pos !== buf.length) {
+        throw new Error(`Trailing bytes in telemetry frame (${buf.length - pos})`);
+    }
+    return frame;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// MESH RELAY HEADER (src/lora/mesh_relay.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+function decodeMeshHeader(buf) {
+    return {
+        origin: buf.readUInt16LE(1),
+        seq: buf.readUInt16LE(3),
+        ttl: buf[5] & 0x0F,
+        hops: buf[5] >> 4,
+        priority: PRIORITY_NAMES[buf[6] & 0x03] || buf[6] & 0x03,
+        attempt: (buf[6] >> 4) & 0x07,
+        confirm: (buf[6] & 0x80) !== 0
+    };
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ENTRY POINT: any uplink payload
+// ═══════════════════════════════════════════════════════════════════════════
+
+function decodeFrame(payload) {
+    const buf = Buffer.isBuffer(payload) ? payload : Buffer.from(payload, 'hex');
+
+    if (buf.length > MESH_HEADER_LEN && buf[0] === FRAME_MESH) {
+        const mesh = decodeMeshHeader(buf);
+        return { ...decodeFrame(buf.subarray(MESH_HEADER_LEN)), mesh };
+    }
+
+    if (buf.length === LEGACY_PACKET_LEN) return decodeLegacyPacket(buf);
+    if (buf[0] === FRAME_TELEMETRY) return decodeTelemetryFrame(buf);
+    if (buf[0] === FRAME_SCHEMA) return decodeSchemaFrame(buf);
+
+    throw new Error(`Unknown frame type 0x${buf[0].toString(16)}`);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// GATEWAY OUTPUT (src/gateway_main.cpp): JSON lines or 0xA5 binary records
+// ═══════════════════════════════════════════════════════════════════════════
+
+const GATEWAY_RECORD = 0xA5;
+const GATEWAY_RECORD_HEADER_LEN = 9;
+
+// One UDP datagram / serial chunk -> [{ us, dev, seq, hops, rssi, snr, st, gap, payload }]
+// (dev..gap only in JSON lines; binary records carry radio metadata only)
+function parseGatewayRecords(data) {
+    const buf = Buffer.isBuffer(data) ? data : Buffer.from(data);
+    const records = [];
+
+    if (buf.length > 0 && buf[0] === GATEWAY_RECORD) {
+        let pos = 0;
+        while (pos + GATEWAY_RECORD_HEADER_LEN <= buf.length && buf[pos] === GATEWAY_RECORD) {
+            const len = buf[pos + 1];
+            if (pos + GATEWAY_RECORD_HEADER_LEN + len > buf.length) break;   // Cut record
+            records.push({
+                us: buf.readUInt32LE(pos + 2),
+                rssi: buf.readInt16LE(pos + 6),
+                snr: buf.readInt8(pos + 8) / 4,
+                payload: buf.subarray(pos + GATEWAY_RECORD_HEADER_LEN, pos + GATEWAY_RECORD_HEADER_LEN + len)
+            });
+            pos += GATEWAY_RECORD_HEADER_LEN + len;
+        }
+        return records;
+    }
+
+    for (const line of buf.toString('utf8').split('\n')) {
+        if (!line.startsWith('{')) continue;   // Gateway diagnostics, partial lines
+        try {
+            const { hex, ...meta } = JSON.parse(line);
+            if (typeof hex === 'string') records.push({ ...meta, payload: Buffer.from(hex, 'hex') });
+        } catch (e) {
+            // Corrupt line: skip, the next one is independent
+        }
+    }
+    return records;
+}
+
+module.exports = {
+    FRAME_TELEMETRY,
+    FRAME_MESH,
+    FRAME_SCHEMA,
+    decodeFrame,
+    decodeTelemetryFrame,
+    decodeSchemaFrame,
+    decodeLegacyPacket,
+    decodeMeshHeader,
+    parseGatewayRecords
+};
@@ -0,0 +1,878 @@
+// Module Script Compiler
+// backend/vm_modules/*.uadm (restricted C-like module logic) → bytecode for
+// the device's module VM (format and instruction set: src/vm/vm_program.h).
+// A module compiled this way is swapped in over BLE in milliseconds instead
+// of going through compileAndFlash and a reboot.
+//
+//   module helmet_vm context helmet;
+//   param int impact_mg = 2500 in 1000..16000 id 2;    // PARAM_SET / PARAM_GET
+//   state float last_impact = 0.0;                     // kept between calls
+//   update { float g = sqrt(ax * ax + ay * ay + az * az) / 9.81; ... }
+//   telemetry { value = int(last_impact * 100); status = STATUS_OK; }
+//
+// Types: int (32-bit, wraps, x / 0 = 0) and float, C promotion rules.
+// Statements: int / float locals, = += -= *= /=, if / else, while (the
+// device stops a call after VM_STEP_LIMIT instructions), return,
+// log(x), led(on), alert(). Expressions: C operators without bitwise ones,
+// ?:, sqrt abs min max int float. Inputs: ax ay az gx gy gz temp (float),
+// now (int ms). Telemetry assigns value and status.
+//
+// Usage: node module-compiler.js <module.uadm> [out.bin]
+//            [--dis]              print the bytecode
+//            [--header <out.h>]   C array of the program (host tests)
+
+const fs = require('fs');
+const path = require('path');
+
+const MAGIC = 'UADM';
+const VERSION = 1;
+const HEADER_LEN = 32;
+const NAME_LEN = 16;
+const PARAM_LEN = 12;
+const PROGRAM_MAX = 4096;       // VM_PROGRAM_MAX
+const REGISTERS = 16;           // VM_REGISTERS
+const STATE_MAX = 64;           // VM_STATE_MAX
+const PARAMS_MAX = 16;          // VM_PARAMS_MAX
+
+// VmOp order (src/vm/vm_program.h)
+const OPS = ['RET', 'MOV', 'LDK', 'LDI', 'LDS', 'STS', 'LDIN', 'OUT',
+             'ADDI', 'SUBI', 'MULI', 'DIVI', 'MODI', 'ADDF', 'SUBF', 'MULF', 'DIVF',
+             'LTI', 'LEI', 'EQI', 'NEI', 'LTF', 'LEF', 'EQF', 'NEF',
+             'MINI', 'MAXI', 'MINF', 'MAXF',
+             'NEGI', 'NEGF', 'NOT', 'I2F', 'F2I', 'ABSI', 'ABSF', 'SQRTF',
+             'JMP', 'JZ', 'JNZ', 'SYS'];
+const OP = Object.fromEntries(OPS.map((name, i) => [name, i]));
+const BC_OPS = new Set([OP.LDK, OP.LDI, OP.JMP, OP.JZ, OP.JNZ]);
+
+const INPUTS = { ax: 0, ay: 1, az: 2, gx: 3, gy: 4, gz: 5, temp: 6, now: 7 };
+const OUTPUTS = { value: 0, status: 1 };
+const SYS = { LOG_INT: 0, LOG_FLOAT: 1, LED: 2, ALERT: 3 };
+const CONTEXTS = { unknown: 0, helmet: 1, bicycle: 2, asset: 3, vehicle: 4 };     // include/types.h
+const STATUS = { STATUS_OK: 0, STATUS_SOS: 1, STATUS_LOW_BATT: 2, STATUS_FALL: 3,
+                 STATUS_IMPACT: 4, STATUS_THEFT: 5 };
+
+class CompileError extends Error {
+    constructor(message, tok) {
+        super(tok ? `${tok.line}:${tok.col}: ${message}` : message);
+        this.name = 'CompileError';
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// LEXER
+// ═══════════════════════════════════════════════════════════════════════════
+
+const PUNCT = ['&&', '||', '==', '!=', '<=', '>=', '+=', '-=', '*=', '/=', '..',
+               '+', '-', '*', '/', '%', '<', '>', '!', '?', ':', '(', ')', '{', '}', ';', '=', ','];
+
+function tokenize(src) {
+    const tokens = [];
+    let i = 0;
+    let line = 1;
+    let lineStart = 0;
+    const at = () => ({ line, col: i - lineStart + 1 });
+
+    while (i < src.length) {
+        const ch = src[i];
+        if (ch === '\n') {
+            line++;
+            lineStart = ++i;
+            continue;
+        }
+        if (/\s/.test(ch)) {
+            i++;
+            continue;
+        }
+        if (src.startsWith('//', i)) {
+            while (i < src.length && src[i] !== '\n') i++;
+            continue;
+        }
+        if (src.startsWith('/*', i)) {
+            const end = src.indexOf('*/', i + 2);
+            if (end < 0) throw new CompileError('Unterminated comment', at());
+            for (let k = i; k < end; k++) {
+                if (src[k] === '\n') {
+                    line++;
+                    lineStart = k + 1;
+                }
+            }
+            i = end + 2;
+            continue;
+        }
+
+        const pos = at();
+        if (/[0-9]/.test(ch)) {
+            let m = /^0x[0-9a-fA-F]+/.exec(src.slice(i));
+            let isFloat = false;
+            if (!m) {
+                // "50..1000" is a range, not a float
+                m = /^[0-9]+(\.[0-9]+)?([eE][-+]?[0-9]+)?f?/.exec(src.slice(i));
+                isFloat = m[1] !== undefined || m[2] !== undefined || m[0].endsWith('f');
+            }
+            const text = m[0].replace(/f$/, '');
+            tokens.push({ t: 'num', v: isFloat ? parseFloat(text) : Number(text), isFloat, ...pos });
+            i += m[0].length;
+            continue;
+        }
+        if (/[A-Za-z_]/.test(ch)) {
+            const m = /^[A-Za-z_][A-Za-z0-9_]*/.exec(src.slice(i));
+            tokens.push({ t: 'id', v: m[0], ...pos });
+            i += m[0].length;
+            continue;
+        }
+        const p = PUNCT.find((s) => src.startsWith(s, i));
+        if (!p) throw new CompileError(`Unexpected '${ch}'`, pos);
+        tokens.push({ t: p, ...pos });
+        i += p.length;
+    }
+    tokens.push({ t: 'eof', line, col: i - lineStart + 1 });
+    return tokens;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// PARSER (recursive descent → AST)
+// ═══════════════════════════════════════════════════════════════════════════
+
+const BINARY = [            // Lowest precedence first
+    ['||'], ['&&'], ['==', '!='], ['<', '<=', '>', '>='], ['+', '-'], ['*', '/', '%']
+];
+
+class Parser {
+    constructor(tokens) {
+        this.tokens = tokens;
+        this.pos = 0;
+    }
+
+    peek(offset = 0) { return this.tokens[this.pos + offset]; }
+    next() { return this.tokens[this.pos++]; }
+    is(t, v) {
+        const tok = this.peek();
+        return tok.t === t && (v === undefined || tok.v === v);
+    }
+    accept(t, v) {
+        if (!this.is(t, v)) return null;
+        return this.next();
+    }
+    expect(t, v) {
+        const tok = this.accept(t, v);
+        if (!tok) throw new CompileError(`Expected ${v || t}, found ${this.peek().v || this.peek().t}`, this.peek());
+        return tok;
+    }
+
+    module() {
+        const mod = { name: null, context: 0, params: [], state: [], update: null, telemetry: null };
+        while (!this.is('eof')) {
+            const kw = this.expect('id');
+            if (kw.v === 'module') {
+                mod.name = this.expect('id').v;
+                if (this.accept('id', 'context')) {
+                    const ctx = this.next();
+                    mod.context = ctx.t === 'num' ? ctx.v : CONTEXTS[ctx.v];
+                    if (mod.context === undefined) throw new CompileError(`Unknown context '${ctx.v}'`, ctx);
+                }
+                this.expect(';');
+            } else if (kw.v === 'param') {
+                this.expect('id', 'int');
+                const name = this.expect('id');
+                this.expect('=');
+                const def = this.intLiteral();
+                this.expect('id', 'in');
+                const min = this.intLiteral();
+                this.expect('..');
+                const max = this.intLiteral();
+                this.expect('id', 'id');
+                const id = this.intLiteral();
+                this.expect(';');
+                mod.params.push({ name: name.v, tok: name, def, min, max, id });
+            } else if (kw.v === 'state') {
+                const type = this.expect('id');
+                if (type.v !== 'int' && type.v !== 'float') throw new CompileError('state is int or float', type);
+                const name = this.expect('id');
+                let init = 0;
+                if (this.accept('=')) {
+                    const neg = this.accept('-');
+                    const lit = this.expect('num');
+                    init = neg ? -lit.v : lit.v;
+                }
+                this.expect(';');
+                mod.state.push({ name: name.v, tok: name, type: type.v, init });
+            } else if (kw.v === 'update' || kw.v === 'telemetry') {
+                if (mod[kw.v]) throw new CompileError(`Second ${kw.v} block`, kw);
+                mod[kw.v] = this.block();
+            } else {
+                throw new CompileError(`Unexpected '${kw.v}'`, kw);
+            }
+        }
+        if (!mod.name) throw new CompileError('Missing "module <name>;"');
+        if (!mod.update) throw new CompileError('Missing update block');
+        return mod;
+    }
+
+    intLiteral() {
+        const neg = this.accept('-');
+        const tok = this.expect('num');
+        if (tok.isFloat) throw new CompileError('Integer expected', tok);
+        return neg ? -tok.v : tok.v;
+    }
+
+    block() {
+        const open = this.expect('{');
+        const body = [];
+        while (!this.accept('}')) {
+            if (this.is('eof')) throw new CompileError('Unclosed block', open);
+            body.push(this.statement());
+        }
+        return { k: 'block', body, tok: open };
+    }
+
+    statement() {
+        const tok = this.peek();
+        if (this.is('{')) return this.block();
+        if (this.is(';')) {
+            this.next();
+            return { k: 'block', body: [], tok };
+        }
+        if (tok.t === 'id' && (tok.v === 'int' || tok.v === 'float') && this.peek(1).t === 'id') {
+            this.next();
+            const name = this.expect('id');
+            this.expect('=');
+            const init = this.expr();
+            this.expect(';');
+            return { k: 'local', type: tok.v, name: name.v, init, tok: name };
+        }
+        if (this.accept('id', 'if')) {
+            this.expect('(');
+            const cond = this.expr();
+            this.expect(')');
+            const then = this.statement();
+            const otherwise = this.accept('id', 'else') ? this.statement() : null;
+            return { k: 'if', cond, then, otherwise, tok };
+        }
+        if (this.accept('id', 'while')) {
+            this.expect('(');
+            const cond = this.expr();
+            this.expect(')');
+            return { k: 'while', cond, body: this.statement(), tok };
+        }
+        if (this.accept('id', 'return')) {
+            this.expect(';');
+            return { k: 'return', tok };
+        }
+        if (tok.t === 'id' && ['=', '+=', '-=', '*=', '/='].includes(this.peek(1).t)) {
+            this.next();
+            const op = this.next().t;
+            const value = this.expr();
+            this.expect(';');
+            return { k: 'assign', name: tok.v, op, value, tok };
+        }
+        const e = this.expr();
+        this.expect(';');
+        if (e.k !== 'call') throw new CompileError('Statement has no effect', tok);
+        return { k: 'exprStmt', e, tok };
+    }
+
+    expr() {
+        const cond = this.binary(0);
+        const q = this.accept('?');
+        if (!q) return cond;
+        const a = this.expr();
+        this.expect(':');
+        const b = this.expr();
+        return { k: 'tern', cond, a, b, tok: q };
+    }
+
+    binary(level) {
+        if (level === BINARY.length) return this.unary();
+        let left = this.binary(level + 1);
+        while (BINARY[level].includes(this.peek().t)) {
+            const tok = this.next();
+            left = { k: 'bin', op: tok.t, l: left, r: this.binary(level + 1), tok };
+        }
+        return left;
+    }
+
+    unary() {
+        const tok = this.peek();
+        if (this.accept('-')) return { k: 'un', op: '-', e: this.unary(), tok };
+        if (this.accept('!')) return { k: 'un', op: '!', e: this.unary(), tok };
+        if (this.accept('+')) return this.unary();
+        return this.primary();
+    }
+
+    primary() {
+        const tok = this.next();
+        if (tok.t === 'num') return { k: 'num', v: tok.v, isFloat: tok.isFloat, tok };
+        if (tok.t === '(') {
+            const e = this.expr();
+            this.expect(')');
+            return e;
+        }
+        if (tok.t === 'id') {
+            if (this.accept('(')) {
+                const args = [];
+                if (!this.accept(')')) {
+                    do args.push(this.expr()); while (this.accept(','));
+                    this.expect(')');
+                }
+                return { k: 'call', name: tok.v, args, tok };
+            }
+            return { k: 'id', name: tok.v, tok };
+        }
+        throw new CompileError(`Unexpected ${tok.v || tok.t}`, tok);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CODE GENERATION (register allocation per entry, temporaries freed eagerly)
+// ═══════════════════════════════════════════════════════════════════════════
+
+const f32 = new Float32Array(1);
+const u32 = new Uint32Array(f32.buffer);
+const floatBits = (v) => {
+    f32[0] = v;
+    return u32[0];
+};
+
+class CodeGen {
+    constructor(mod) {
+        this.mod = mod;
+        this.code = [];
+        this.consts = [];
+        this.constIndex = new Map();
+        this.globals = new Map();       // name → { kind, type, index }
+        this.cells = [];                // initial cell values (bits)
+        this.params = [];
+        this.maxRegs = 0;
+
+        for (const p of mod.params) {
+            if (p.min > p.max || p.def < p.min || p.def > p.max) {
+                throw new CompileError(`Param ${p.name}: default outside ${p.min}..${p.max}`, p.tok);
+            }
+            if (p.id < 1 || p.id > 255 || this.params.some((q) => q.id === p.id)) {
+                throw new CompileError(`Param ${p.name}: id must be unique, 1..255`, p.tok);
+            }
+            this.declareGlobal(p.name, { kind: 'param', type: 'int', index: this.cells.length }, p.tok);
+            this.params.push({ id: p.id, cell: this.cells.length, min: p.min, max: p.max });
+            this.cells.push(p.def | 0);
+        }
+        for (const s of mod.state) {
+            this.declareGlobal(s.name, { kind: 'state', type: s.type, index: this.cells.length }, s.tok);
+            this.cells.push(s.type === 'float' ? floatBits(s.init) : s.init | 0);
+        }
+        if (this.cells.length > STATE_MAX) throw new CompileError(`More than ${STATE_MAX} state cells`);
+        if (this.params.length > PARAMS_MAX) throw new CompileError(`More than ${PARAMS_MAX} params`);
+    }
+
+    declareGlobal(name, info, tok) {
+        if (this.globals.has(name) || name in INPUTS || name in STATUS || name in OUTPUTS) {
+            throw new CompileError(`'${name}' already defined`, tok);
+        }
+        this.globals.set(name, info);
+    }
+
+    // ── Entries
+
+    entry(block, isTelemetry) {
+        const start = this.code.length;
+        this.used = new Array(REGISTERS).fill(false);
+        this.scopes = [new Map()];
+        this.isTelemetry = isTelemetry;
+        if (block) this.statement(block);
+        this.emit(OP.RET);
+        return start;
+    }
+
+    // ── Emission
+
+    emit(op, a = 0, b = 0, c = 0) {
+        this.code.push((op | (a << 8) | (b << 16) | (c << 24)) >>> 0);
+        return this.code.length - 1;
+    }
+
+    emitBC(op, a, bc) {
+        return this.emit(op, a, bc & 0xFF, (bc >> 8) & 0xFF);
+    }
+
+    jumpHere(at, tok) {
+        this.jumpTo(at, this.code.length, tok);
+    }
+
+    jumpTo(at, target, tok) {
+        const offset = target - (at + 1);
+        if (offset < -32768 || offset > 32767) throw new CompileError('Jump too far', tok);
+        const w = this.code[at];
+        this.code[at] = ((w & 0xFFFF) | ((offset & 0xFFFF) << 16)) >>> 0;
+    }
+
+    constant(bits) {
+        if (!this.constIndex.has(bits)) {
+            if (this.consts.length >= 255) throw new CompileError('More than 255 constants');
+            this.constIndex.set(bits, this.consts.length);
+            this.consts.push(bits);
+        }
+        return this.constIndex.get(bits);
+    }
+
+    // ── Registers
+
+    alloc(tok) {
+        const r = this.used.indexOf(false);
+        if (r < 0) throw new CompileError(`Out of registers (${REGISTERS}): split the expression`, tok);
+        this.used[r] = true;
+        this.maxRegs = Math.max(this.maxRegs, r + 1);
+        return r;
+    }
+
+    release(v) {
+        if (v.owned) this.used[v.reg] = false;
+    }
+
+    // Register the result may go to: an operand's temporary or a new one
+    target(tok, ...vals) {
+        const t = vals.find((v) => v.owned);
+        return t ? t.reg : this.alloc(tok);
+    }
+
+    lookup(name) {
+        for (let i = this.scopes.length - 1; i >= 0; i--) {
+            if (this.scopes[i].has(name)) return this.scopes[i].get(name);
+        }
+        return this.globals.get(name);
+    }
+
+    // ── Statements
+
+    statement(s) {
+        switch (s.k) {
+            case 'block': {
+                this.scopes.push(new Map());
+                for (const st of s.body) this.statement(st);
+                for (const local of this.scopes.pop().values()) this.used[local.reg] = false;
+                break;
+            }
+            case 'local': {
+                const scope = this.scopes[this.scopes.length - 1];
+                if (scope.has(s.name) || this.globals.has(s.name) || s.name in INPUTS) {
+                    throw new CompileError(`'${s.name}' already defined`, s.tok);
+                }
+                const v = this.convert(this.expr(s.init), s.type, s.tok);
+                let reg = v.reg;
+                if (!v.owned) {
+                    reg = this.alloc(s.tok);
+                    this.emit(OP.MOV, reg, v.reg);
+                }
+                scope.set(s.name, { kind: 'local', type: s.type, reg });
+                break;
+            }
+            case 'assign': this.assign(s); break;
+            case 'if': {
+                const skip = this.condJump(s.cond);
+                this.statement(s.then);
+                if (s.otherwise) {
+                    const end = this.emitBC(OP.JMP, 0, 0);
+                    this.jumpHere(skip, s.tok);
+                    this.statement(s.otherwise);
+                    this.jumpHere(end, s.tok);
+                } else {
+                    this.jumpHere(skip, s.tok);
+                }
+                break;
+            }
+            case 'while': {
+                const top = this.code.length;
+                const exit = this.condJump(s.cond);
+                this.statement(s.body);
+                this.jumpTo(this.emitBC(OP.JMP, 0, 0), top, s.tok);
+                this.jumpHere(exit, s.tok);
+                break;
+            }
+            case 'return': this.emit(OP.RET); break;
+            case 'exprStmt': this.callStatement(s.e); break;
+        }
+    }
+
+    assign(s) {
+        let value = s.value;
+        if (s.op !== '=') value = { k: 'bin', op: s.op[0], l: { k: 'id', name: s.name, tok: s.tok }, r: s.value, tok: s.tok };
+
+        if (s.name in OUTPUTS) {
+            if (!this.isTelemetry) throw new CompileError(`'${s.name}' is set in telemetry`, s.tok);
+            const v = this.convert(this.expr(value), 'int', s.tok);
+            this.emit(OP.OUT, OUTPUTS[s.name], v.reg);
+            this.release(v);
+            return;
+        }
+        const dest = this.lookup(s.name);
+        if (!dest) throw new CompileError(`Unknown variable '${s.name}'`, s.tok);
+        if (dest.kind === 'param') throw new CompileError(`Param '${s.name}' is read-only (PARAM_SET)`, s.tok);
+        const v = this.convert(this.expr(value), dest.type, s.tok);
+        if (dest.kind === 'state') {
+            this.emit(OP.STS, dest.index, v.reg);
+        } else if (v.reg !== dest.reg) {
+            this.emit(OP.MOV, dest.reg, v.reg);
+        }
+        this.release(v);
+    }
+
+    callStatement(e) {
+        if (e.name === 'log' && e.args.length === 1) {
+            const v = this.expr(e.args[0]);
+            this.emit(OP.SYS, v.type === 'float' ? SYS.LOG_FLOAT : SYS.LOG_INT, v.reg);
+            this.release(v);
+        } else if (e.name === 'led' && e.args.length === 1) {
+            const v = this.truth(this.expr(e.args[0]), e.tok);
+            this.emit(OP.SYS, SYS.LED, v.reg);
+            this.release(v);
+        } else if (e.name === 'alert' && e.args.length === 0) {
+            this.emit(OP.SYS, SYS.ALERT, 0);
+        } else {
+            throw new CompileError(`'${e.name}' is not a statement (log(x), led(on), alert())`, e.tok);
+        }
+    }
+
+    // JZ placeholder taken when cond is false
+    condJump(cond) {
+        const v = this.truth(this.expr(cond), cond.tok);
+        const at = this.emitBC(OP.JZ, v.reg, 0);
+        this.release(v);
+        return at;
+    }
+
+    // int that is nonzero when v is (floats compared with 0.0)
+    truth(v, tok) {
+        if (v.type === 'int') return v;
+        const zero = this.alloc(tok);
+        this.emitBC(OP.LDI, zero, 0);
+        const dest = v.owned ? v.reg : this.alloc(tok);
+        this.emit(OP.NEF, dest, v.reg, zero);
+        this.used[zero] = false;
+        return { reg: dest, type: 'int', owned: true };
+    }
+
+    convert(v, type, tok) {
+        if (v.type === type) return v;
+        const dest = v.owned ? v.reg : this.alloc(tok);
+        this.emit(type === 'float' ? OP.I2F : OP.F2I, dest, v.reg);
+        return { reg: dest, type, owned: true };
+    }
+
+    // ── Expressions: { reg, type, owned }
+
+    expr(e) {
+        switch (e.k) {
+            case 'num': return this.literal(e.v, e.isFloat ? 'float' : 'int', e.tok);
+            case 'id': return this.identifier(e);
+            case 'un': return this.unaryOp(e);
+            case 'bin': return this.binaryOp(e);
+            case 'tern': return this.ternary(e);
+            case 'call': return this.call(e);
+        }
+        throw new CompileError('Bad expression', e.tok);
+    }
+
+    literal(value, type, tok) {
+        const reg = this.alloc(tok);
+        if (type === 'int') {
+            if (!Number.isInteger(value) || value > 0xFFFFFFFF || value < -0x80000000) {
+                throw new CompileError(`Integer out of range: ${value}`, tok);
+            }
+            if (value >= -32768 && value <= 32767) this.emitBC(OP.LDI, reg, value);
+            else this.emitBC(OP.LDK, reg, this.constant(value >>> 0));
+        } else {
+            this.emitBC(OP.LDK, reg, this.constant(floatBits(value)));
+        }
+        return { reg, type, owned: true };
+    }
+
+    identifier(e) {
+        if (e.name in INPUTS) {
+            const reg = this.alloc(e.tok);
+            this.emit(OP.LDIN, reg, INPUTS[e.name]);
+            return { reg, type: e.name === 'now' ? 'int' : 'float', owned: true };
+        }
+        if (e.name in STATUS) return this.literal(STATUS[e.name], 'int', e.tok);
+        const v = this.lookup(e.name);
+        if (!v) throw new CompileError(`Unknown variable '${e.name}'`, e.tok);
+        if (v.kind === 'local') return { reg: v.reg, type: v.type, owned: false };
+        const reg = this.alloc(e.tok);
+        this.emit(OP.LDS, reg, v.index);
+        return { reg, type: v.type, owned: true };
+    }
+
+    unaryOp(e) {
+        const v = this.expr(e.e);
+        if (e.op === '!') {
+            const t = this.truth(v, e.tok);
+            const dest = this.target(e.tok, t);
+            this.emit(OP.NOT, dest, t.reg);
+            return { reg: dest, type: 'int', owned: true };
+        }
+        const dest = this.target(e.tok, v);
+        this.emit(v.type === 'float' ? OP.NEGF : OP.NEGI, dest, v.reg);
+        return { reg: dest, type: v.type, owned: true };
+    }
+
+    // Both to float if either is
+    unify(l, r, tok) {
+        if (l.type === r.type) return [l, r, l.type];
+        return [this.convert(l, 'float', tok), this.convert(r, 'float', tok), 'float'];
+    }
+
+    binaryOp(e) {
+        if (e.op === '&&' || e.op === '||') return this.logical(e);
+        let l = this.expr(e.l);
+        let r = this.expr(e.r);
+        let type;
+        [l, r, type] = this.unify(l, r, e.tok);
+        if (e.op === '%' && type === 'float') throw new CompileError('% needs ints', e.tok);
+
+        const f = type === 'float';
+        let op;
+        let swap = false;
+        let resultType = 'int';
+        switch (e.op) {
+            case '+': op = f ? OP.ADDF : OP.ADDI; resultType = type; break;
+            case '-': op = f ? OP.SUBF : OP.SUBI; resultType = type; break;
+            case '*': op = f ? OP.MULF : OP.MULI; resultType = type; break;
+            case '/': op = f ? OP.DIVF : OP.DIVI; resultType = type; break;
+            case '%': op = OP.MODI; break;
+            case '<': op = f ? OP.LTF : OP.LTI; break;
+            case '<=': op = f ? OP.LEF : OP.LEI; break;
+            case '>': op = f ? OP.LTF : OP.LTI; swap = true; break;
+            case '>=': op = f ? OP.LEF : OP.LEI; swap = true; break;
+            case '==': op = f ? OP.EQF : OP.EQI; break;
+            case '!=': op = f ? OP.NEF : OP.NEI; break;
+        }
+        const dest = this.target(e.tok, l, r);
+        this.emit(op, dest, swap ? r.reg : l.reg, swap ? l.reg : r.reg);
+        if (l.owned && l.reg !== dest) this.release(l);
+        if (r.owned && r.reg !== dest) this.release(r);
+        return { reg: dest, type: resultType, owned: true };
+    }
+
+    // Short circuit, result 0 / 1
+    logical(e) {
+        const dest = this.alloc(e.tok);
+        const bool = (node) => {
+            const v = this.truth(this.expr(node), node.tok);
+            this.emit(OP.NOT, dest, v.reg);
+            this.emit(OP.NOT, dest, dest);
+            if (v.reg !== dest) this.release(v);
+        };
+        bool(e.l);
+        const skip = this.emitBC(e.op === '&&' ? OP.JZ : OP.JNZ, dest, 0);
+        bool(e.r);
+        this.jumpHere(skip, e.tok);
+        return { reg: dest, type: 'int', owned: true };
+    }
+
+    ternary(e) {
+        const types = [this.typeOf(e.a), this.typeOf(e.b)];
+        const type = types.includes('float') ? 'float' : 'int';
+        const dest = this.alloc(e.tok);
+        const branch = (node) => {
+            const v = this.convert(this.expr(node), type, node.tok);
+            if (v.reg !== dest) this.emit(OP.MOV, dest, v.reg);
+            this.release(v);
+        };
+        const skip = this.condJump(e.cond);
+        branch(e.a);
+        const end = this.emitBC(OP.JMP, 0, 0);
+        this.jumpHere(skip, e.tok);
+        branch(e.b);
+        this.jumpHere(end, e.tok);
+        return { reg: dest, type, owned: true };
+    }
+
+    // Static type of an expression (no code)
+    typeOf(e) {
+        switch (e.k) {
+            case 'num': return e.isFloat ? 'float' : 'int';
+            case 'id': {
+                if (e.name in INPUTS) return e.name === 'now' ? 'int' : 'float';
+                if (e.name in STATUS) return 'int';
+                const v = this.lookup(e.name);
+                if (!v) throw new CompileError(`Unknown variable '${e.name}'`, e.tok);
+                return v.type;
+            }
+            case 'un': return e.op === '!' ? 'int' : this.typeOf(e.e);
+            case 'bin':
+                if (['+', '-', '*', '/'].includes(e.op)) {
+                    return this.typeOf(e.l) === 'float' || this.typeOf(e.r) === 'float' ? 'float' : 'int';
+                }
+                return 'int';
+            case 'tern': return this.typeOf(e.a) === 'float' || this.typeOf(e.b) === 'float' ? 'float' : 'int';
+            case 'call':
+                if (e.name === 'sqrt' || e.name === 'float') return 'float';
+                if (e.name === 'int') return 'int';
+                return e.args.some((a) => this.typeOf(a) === 'float') ? 'float' : 'int';
+        }
+        return 'int';
+    }
+
+    call(e) {
+        const argc = { sqrt: 1, abs: 1, int: 1, float: 1, min: 2, max: 2 }[e.name];
+        if (argc === undefined) throw new CompileError(`Unknown function '${e.name}'`, e.tok);
+        if (e.args.length !== argc) throw new CompileError(`${e.name}() takes ${argc} argument(s)`, e.tok);
+
+        if (argc === 2) {
+            let [l, r, type] = this.unify(this.expr(e.args[0]), this.expr(e.args[1]), e.tok);
+            const f = type === 'float';
+            const op = e.name === 'min' ? (f ? OP.MINF : OP.MINI) : (f ? OP.MAXF : OP.MAXI);
+            const dest = this.target(e.tok, l, r);
+            this.emit(op, dest, l.reg, r.reg);
+            if (l.owned && l.reg !== dest) this.release(l);
+            if (r.owned && r.reg !== dest) this.release(r);
+            return { reg: dest, type, owned: true };
+        }
+
+        const v = this.expr(e.args[0]);
+        if (e.name === 'int') return this.convert(v, 'int', e.tok);
+        if (e.name === 'float') return this.convert(v, 'float', e.tok);
+        if (e.name === 'sqrt') {
+            const x = this.convert(v, 'float', e.tok);
+            const dest = this.target(e.tok, x);
+            this.emit(OP.SQRTF, dest, x.reg);
+            return { reg: dest, type: 'float', owned: true };
+        }
+        const dest = this.target(e.tok, v);
+        this.emit(v.type === 'float' ? OP.ABSF : OP.ABSI, dest, v.reg);
+        return { reg: dest, type: v.type, owned: true };
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// PROGRAM IMAGE
+// ═══════════════════════════════════════════════════════════════════════════
+
+const CRC_TABLE = (() => {
+    const t = new Uint32Array(256);
+    for (let n = 0; n < 256; n++) {
+        let c = n;
+        for (let k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320 ^ (c >>> 1) : c >>> 1;
+        t[n] = c >>> 0;
+    }
+    return t;
+})();
+
+function crc32(buf) {
+    let crc = 0xFFFFFFFF;
+    for (let i = 0; i < buf.length; i++) crc = CRC_TABLE[(crc ^ buf[i]) & 0xFF] ^ (crc >>> 8);
+    return (crc ^ 0xFFFFFFFF) >>> 0;
+}
+
+function compile(source) {
+    const mod = new Parser(tokenize(source)).module();
+    if (Buffer.byteLength(mod.name) > NAME_LEN) throw new CompileError(`Module name over ${NAME_LEN} bytes`);
+    const gen = new CodeGen(mod);
+    const updateEntry = gen.entry(mod.update, false);
+    const telemetryEntry = gen.entry(mod.telemetry, true);
+
+    const size = HEADER_LEN + 4 * (gen.consts.length + gen.cells.length) + PARAM_LEN * gen.params.length +
+                 4 * gen.code.length + 4;
+    if (size > PROGRAM_MAX) throw new CompileError(`Program is ${size} bytes, over ${PROGRAM_MAX}`);
+
+    const out = Buffer.alloc(size);
+    out.write(MAGIC, 0, 'latin1');
+    out[4] = VERSION;
+    out[5] = mod.context;
+    out[6] = gen.consts.length;
+    out[7] = gen.cells.length;
+    out[8] = gen.params.length;
+    out.writeUInt16LE(gen.code.length, 10);
+    out.writeUInt16LE(updateEntry, 12);
+    out.writeUInt16LE(telemetryEntry, 14);
+    out.write(mod.name, 16, 'latin1');
+    let at = HEADER_LEN;
+    for (const k of gen.consts) at = out.writeUInt32LE(k >>> 0, at);
+    for (const c of gen.cells) at = out.writeUInt32LE(c >>> 0, at);
+    for (const p of gen.params) {
+        out[at] = p.id;
+        out[at + 1] = p.cell;
+        out.writeInt32LE(p.min, at + 4);
+        out.writeInt32LE(p.max, at + 8);
+        at += PARAM_LEN;
+    }
+    for (const w of gen.code) at = out.writeUInt32LE(w, at);
+    out.writeUInt32LE(crc32(out.subarray(0, at)), at);
+
+    return {
+        program: out,
+        name: mod.name,
+        context: mod.context,
+        instructions: gen.code.length,
+        registers: gen.maxRegs,
+        cells: gen.cells.length,
+        params: mod.params.map((p) => ({ name: p.name, id: p.id, min: p.min, max: p.max, default: p.def }))
+    };
+}
+
+function disassemble(program) {
+    const codeLen = program.readUInt16LE(10);
+    const codeAt = HEADER_LEN + 4 * (program[6] + program[7]) + PARAM_LEN * program[8];
+    const entries = { [program.readUInt16LE(12)]: 'update:', [program.readUInt16LE(14)]: 'telemetry:' };
+    const lines = [];
+    for (let pc = 0; pc < codeLen; pc++) {
+        const w = program.readUInt32LE(codeAt + 4 * pc);
+        const op = OPS[w & 0xFF] || '?';
+        const a = (w >> 8) & 0xFF;
+        const bc = (w >> 16) << 16 >> 16;
+        if (entries[pc]) lines.push(entries[pc]);
+        let args;
+        if (BC_OPS.has(w & 0xFF)) {
+            const target = op.startsWith('J') ? ` → ${pc + 1 + bc}` : '';
+            args = op === 'JMP' ? `${bc}${target}` : `r${a}, ${bc}${target}`;
+        } else {
+            args = `${a}, ${(w >> 16) & 0xFF}, ${w >>> 24}`;
+        }
+        lines.push(`  ${String(pc).padStart(4)}  ${op.padEnd(6)} ${args}`);
+    }
+    return lines.join('\n');
+}
+
+function toHeader(result, sourceName) {
+    const id = result.name.toUpperCase().replace(/[^A-Z0-9]/g, '_');
+    const bytes = [];
+    for (let i = 0; i < result.program.length; i += 12) {
+        bytes.push('    ' + Array.from(result.program.subarray(i, i + 12), (b) => `0x${b.toString(16).padStart(2, '0')}`).join(', ') + ',');
+    }
+    return `// GENERATED by backend/module-compiler.js from ${sourceName}\n` +
+           `// ${result.program.length} bytes, ${result.instructions} instructions, ${result.registers} registers\n\n` +
+           `#pragma once\n#include <stdint.h>\n\n` +
+           `alignas(4) static const uint8_t ${id}_PROGRAM[] = {\n${bytes.join('\n')}\n};\n`;
+}
+
+module.exports = { compile, disassemble, CompileError, OPS };
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════
+
+if (require.main === module) {
+    const args = process.argv.slice(2);
+    const flag = (name) => {
+        const i = args.indexOf(name);
+        if (i < 0) return null;
+        return args.splice(i, 2)[1] || '';
+    };
+    const dis = args.includes('--dis');
+    if (dis) args.splice(args.indexOf('--dis'), 1);
+    const headerOut = flag('--header');
+    const [file, outFile] = args;
+    if (!file) {
+        console.log('Usage: node module-compiler.js <module.uadm> [out.bin] [--dis] [--header <out.h>]');
+        process.exit(1);
+    }
+    try {
+        const result = compile(fs.readFileSync(file, 'utf8'));
+        console.log(`${result.name}: ${result.program.length} bytes, ${result.instructions} instructions, ` +
+                    `${result.registers} registers, ${result.cells} cells, ${result.params.length} params`);
+        if (dis) console.log(disassemble(result.program));
+        if (outFile) fs.writeFileSync(outFile, result.program);
+        if (headerOut) fs.writeFileSync(headerOut, toHeader(result, path.relative(path.join(__dirname, '..'), path.resolve(file))));
+    } catch (e) {
+        if (!(e instanceof CompileError)) throw e;
+        console.error(`❌ ${file}:${e.message}`);
+        process.exit(1);
+    }
+}
@@ -0,0 +1,129 @@
+// Module Contract Check
+// The checks of src/modules/module_contract.h, run on a module header's
+// source so a generated module that cannot build is rejected in
+// milliseconds instead of after a full PlatformIO build:
+//
+//   void init();
+//   void update(const SensorData& data);       // const reference, not a copy
+//   TelemetryData getTelemetry();
+//   uint32_t getSampleInterval();              // optional
+//   void updateBatch(const SensorData* samples, size_t n);   // optional
+//
+// SensorData, TelemetryData, ContextType and StatusCode come from
+// include/types.h; a module that defines its own is rejected. A header
+// injected as src/current_module.h must also provide CurrentModule (the
+// class itself, or `using CurrentModule = SomeModule;`).
+//
+// This is a source scan, not a compiler: it catches the contract mistakes
+// generated code makes, the build still has the last word.
+//
+// Usage: node module-contract.js <module.h> [ClassName] [--current]
+
+const fs = require('fs');
+
+const SHARED_TYPES = [
+    { name: 'SensorData', re: /\b(struct|class)\s+SensorData\s*\{/ },
+    { name: 'TelemetryData', re: /\b(struct|class)\s+TelemetryData\s*\{/ },
+    { name: 'ContextType', re: /\benum\s+(class\s+)?ContextType\b/ },
+    { name: 'StatusCode', re: /\benum\s+(class\s+)?StatusCode\b/ },
+    { name: 'TYPES_H', re: /#\s*define\s+TYPES_H\b/ }
+];
+
+// Comments and string / char literals blanked, line structure kept
+function stripSource(code) {
+    return code.replace(/\/\*[\s\S]*?\*\/|\/\/[^\n]*|"(?:\\.|[^"\\\n])*"|'(?:\\.|[^'\\\n])*'/g,
+        (m) => (m[0] === '"' || m[0] === '\'') ? m[0] + m[0] : m.replace(/[^\n]/g, ' '));
+}
+
+// Body of `class Name ... { ... };` (between the braces), null if absent
+function classBody(src, name) {
+    const re = new RegExp(`\\b(?:class|struct)\\s+${name}\\b[^;{]*\\{`, 'g');
+    const m = re.exec(src);
+    if (!m) return null;
+    let depth = 1;
+    for (let i = m.index + m[0].length; i < src.length; i++) {
+        if (src[i] === '{') depth++;
+        else if (src[i] === '}' && --depth === 0) return src.slice(m.index + m[0].length, i);
+    }
+    return null;
+}
+
+// { ok, errors: [...], className }
+// options.className: class to check (default: CurrentModule's target, or
+// the first *Module class). options.current: header goes in as current_module.h
+function checkModule(code, options = {}) {
+    const src = stripSource(code);
+    const errors = [];
+
+    for (const t of SHARED_TYPES) {
+        if (t.re.test(src)) {
+            errors.push(`redefines ${t.name}: use the one from include/types.h`);
+        }
+    }
+
+    const alias = src.match(/\busing\s+CurrentModule\s*=\s*(\w+)\s*;|\btypedef\s+(\w+)\s+CurrentModule\s*;/);
+    const hasCurrent = alias !== null || /\b(class|struct)\s+CurrentModule\b[^;]*\{/.test(src);
+    if (options.current && !hasCurrent) {
+        errors.push('no CurrentModule: add `using CurrentModule = <YourModule>;`');
+    }
+
+    let className = options.className;
+    if (!className) {
+        if (alias) className = alias[1] || alias[2];
+        else if (hasCurrent) className = 'CurrentModule';
+        else {
+            const first = src.match(/\b(?:class|struct)\s+(\w+Module)\b[^;{]*\{/);
+            className = first ? first[1] : null;
+        }
+    }
+    const body = className ? classBody(src, className) : null;
+    if (!body) {
+        errors.push(className ? `class ${className} not found` : 'no module class found');
+        return { ok: false, errors, className };
+    }
+
+    if (!/\bvoid\s+init\s*\(\s*(void)?\s*\)/.test(body)) {
+        errors.push('missing void init()');
+    }
+    if (/\bvoid\s+update\s*\(\s*SensorData\s+\w*\s*\)/.test(body)) {
+        errors.push('update takes SensorData by value: use update(const SensorData& data)');
+    } else if (!/\bvoid\s+update\s*\(\s*const\s+SensorData\s*&\s*\w*\s*\)/.test(body)) {
+        errors.push('missing void update(const SensorData& data)');
+    }
+    if (!/\bTelemetryData\s+getTelemetry\s*\(\s*(void)?\s*\)/.test(body)) {
+        errors.push('missing TelemetryData getTelemetry()');
+    }
+    if (/\bgetSampleInterval\s*\(/.test(body) &&
+        !/\b(uint32_t|uint16_t|unsigned\s+long|unsigned\s+int|unsigned)\s+getSampleInterval\s*\(\s*(void)?\s*\)/.test(body)) {
+        errors.push('getSampleInterval() takes no arguments and returns ms (uint32_t)');
+    }
+    if (/\bupdateBatch\s*\(/.test(body) &&
+        !/\bvoid\s+updateBatch\s*\(\s*const\s+SensorData\s*\*\s*\w*\s*,\s*size_t\s+\w*\s*\)/.test(body)) {
+        errors.push('updateBatch takes (const SensorData* samples, size_t n)');
+    }
+
+    return { ok: errors.length === 0, errors, className };
+}
+
+module.exports = { checkModule };
+
+// ═══════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════
+
+if (require.main === module) {
+    const args = process.argv.slice(2);
+    const current = args.includes('--current');
+    const [file, className] = args.filter((a) => a !== '--current');
+    if (!file) {
+        console.log('Usage: node module-contract.js <module.h> [ClassName] [--current]');
+        process.exit(1);
+    }
+    const result = checkModule(fs.readFileSync(file, 'utf8'), { className, current });
+    if (result.ok) {
+        console.log(`${file}: ${result.className} meets the module contract`);
+    } else {
+        for (const e of result.errors) console.error(`${file}: ${e}`);
+        process.exit(2);
+    }
+}
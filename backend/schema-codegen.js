@@ -0,0 +1,747 @@
+// Telemetry Schema Codegen
+// backend/schemas/*.json → src/lora/schemas/<name>_schema.h (device encoder)
+//                        → generated_schemas/index.js (backend decoder)
+//                        → test/test_schema_frame/schema_vectors.h (frames
+//                          encoded here, decoded and re-encoded by the C++
+//                          codec in the host test: both sides must agree)
+// Wire format: src/lora/schema_frame.h
+//
+// Usage: node schema-codegen.js           regenerate everything
+//        node schema-codegen.js --check   exit 1 if any output is stale
+
+const fs = require('fs');
+const path = require('path');
+
+const SCHEMA_DIR = path.join(__dirname, 'schemas');
+const CPP_DIR = path.join(__dirname, '..', 'src', 'lora', 'schemas');
+const BACKEND_OUT = path.join(__dirname, 'generated_schemas', 'index.js');
+const VECTORS_OUT = path.join(__dirname, '..', 'test', 'test_schema_frame', 'schema_vectors.h');
+
+const FIELD_TYPES = ['bool', 'enum', 'uint', 'scaled', 'varint', 'delta'];
+const DEFAULT_GROUP = 7;
+const MAX_PAYLOAD = 222;     // LORA_MAX_PAYLOAD
+const HEADER_LEN = 8;        // SCHEMA_HEADER_LEN
+
+// ═══════════════════════════════════════════════════════════════════════════
+// LOAD + VALIDATE
+// ═══════════════════════════════════════════════════════════════════════════
+
+function bitsFor(maxValue) {
+    let bits = 1;
+    while (2 ** bits - 1 < maxValue) bits++;
+    return bits;
+}
+
+function decimalsOf(step) {
+    const [mantissa, exp] = String(step).split('e');
+    const frac = (mantissa.split('.')[1] || '').length;
+    return Math.max(0, frac - Number(exp || 0));
+}
+
+function resolveField(f, prior, where) {
+    if (!/^[a-z][a-z0-9_]*$/.test(f.name || '')) throw new Error(`${where}: bad field name "${f.name}"`);
+    if (prior.some(p => p.name === f.name)) throw new Error(`${where}: duplicate field "${f.name}"`);
+    if (!FIELD_TYPES.includes(f.type)) throw new Error(`${where}.${f.name}: unknown type "${f.type}"`);
+
+    const field = { ...f };
+
+    if (f.when !== undefined) {
+        const flag = prior.find(p => p.name === f.when);
+        if (!flag || flag.type !== 'bool') {
+            throw new Error(`${where}.${f.name}: "when" must name an earlier bool field`);
+        }
+    }
+
+    switch (f.type) {
+        case 'bool':
+            field.bits = 1;
+            break;
+        case 'enum':
+            if (!Array.isArray(f.values) || f.values.length < 2 || f.values.length > 256) {
+                throw new Error(`${where}.${f.name}: enum needs 2..256 values`);
+            }
+            field.bits = bitsFor(f.values.length - 1);
+            break;
+        case 'uint':
+            if (!(f.bits >= 1 && f.bits <= 32)) throw new Error(`${where}.${f.name}: uint needs bits 1..32`);
+            break;
+        case 'varint':
+            field.group = f.group || DEFAULT_GROUP;
+            break;
+        case 'scaled':
+        case 'delta':
+            if (!(f.max > f.min) || !(f.step > 0)) {
+                throw new Error(`${where}.${f.name}: needs min < max and step > 0`);
+            }
+            field.maxQ = Math.round((f.max - f.min) / f.step);
+            if (field.maxQ > 0xFFFFFFFF) throw new Error(`${where}.${f.name}: more than 32 bits`);
+            field.bits = bitsFor(field.maxQ);
+            field.decimals = decimalsOf(f.step);
+            if (f.type === 'delta') field.group = f.group || DEFAULT_GROUP;
+            break;
+    }
+    if (field.group !== undefined && !(field.group >= 1 && field.group <= 16)) {
+        throw new Error(`${where}.${f.name}: group must be 1..16`);
+    }
+    return field;
+}
+
+function loadSchemas() {
+    const files = fs.readdirSync(SCHEMA_DIR).filter(f => f.endsWith('.json')).sort();
+    const schemas = [];
+
+    for (const file of files) {
+        const s = JSON.parse(fs.readFileSync(path.join(SCHEMA_DIR, file), 'utf8'));
+        if (!/^[a-z][a-z0-9_]*$/.test(s.name || '')) throw new Error(`${file}: bad schema name`);
+        if (!(s.id >= 1 && s.id <= 255)) throw new Error(`${file}: id must be 1..255`);
+        if (schemas.some(o => o.id === s.id)) throw new Error(`${file}: schema id ${s.id} already used`);
+        if (!Array.isArray(s.versions) || s.versions.length === 0) throw new Error(`${file}: no versions`);
+
+        let last = 0;
+        s.versions = s.versions.map(v => {
+            if (!(v.version > last && v.version <= 255)) throw new Error(`${file}: versions must ascend, 1..255`);
+            last = v.version;
+            const fields = [];
+            for (const f of v.fields) fields.push(resolveField(f, fields, `${s.name} v${v.version}`));
+            return { version: v.version, fields };
+        });
+        schemas.push(s);
+    }
+    return schemas;
+}
+
+// Bits of the first record with every field present (deltas absolute)
+function fullRecordBits(fields) {
+    return fields.reduce((n, f) => n + (f.type === 'varint' ? f.group + 1 : f.bits), 0);
+}
+
+function minRecordBits(fields) {
+    return fields.filter(f => f.when === undefined)
+        .reduce((n, f) => n + (f.type === 'varint' ? f.group + 1 : f.bits), 0);
+}
+
+const pascal = name => name.split('_').map(w => w[0].toUpperCase() + w.slice(1)).join('');
+
+// Method body at 8 spaces. Consecutive fields gated by the same flag share
+// one if (r.flag) block; on decode, `absent` is assigned when the flag is off.
+// Deltas declare a local, so an ungated one gets its own scope.
+function emitBody(fields, emit, absent) {
+    const out = [];
+    for (let i = 0; i < fields.length;) {
+        const f = fields[i];
+        if (!f.when) {
+            const lines = emit(f);
+            if (f.type === 'delta') {
+                out.push('        {', ...lines.map(l => `            ${l}`), '        }');
+            } else {
+                out.push(...lines.map(l => `        ${l}`));
+            }
+            i++;
+            continue;
+        }
+
+        const group = [];
+        while (i < fields.length && fields[i].when === f.when) group.push(fields[i++]);
+        out.push(`        if (r.${f.when}) {`);
+        for (const g of group) out.push(...emit(g).map(l => `            ${l}`));
+        if (absent !== undefined) {
+            out.push('        } else {');
+            for (const g of group) out.push(`            r.${g.name} = ${absent};`);
+        }
+        out.push('        }');
+    }
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// C++ EMITTER (latest version only: a device speaks one version)
+// ═══════════════════════════════════════════════════════════════════════════
+
+function cppDouble(v) {
+    const s = String(v);
+    return /[.e]/.test(s) ? s : `${s}.0`;
+}
+
+function cppType(f) {
+    switch (f.type) {
+        case 'bool': return 'bool';
+        case 'enum': return 'uint8_t';
+        case 'uint': return f.bits <= 8 ? 'uint8_t' : f.bits <= 16 ? 'uint16_t' : 'uint32_t';
+        case 'varint': return 'int32_t';
+        // More steps than a float mantissa resolves (GPS at 1e-5 deg)
+        default: return f.maxQ >= 2 ** 24 ? 'double' : 'float';
+    }
+}
+
+function cppComment(f) {
+    let c;
+    switch (f.type) {
+        case 'bool': c = 'bool'; break;
+        case 'enum': c = f.values.join(', '); break;
+        case 'uint': c = `${f.bits} bits`; break;
+        case 'varint': c = `zigzag varint (${f.group}+1 bit groups)`; break;
+        default: c = `${f.min}..${f.max} step ${f.step}${f.type === 'delta' ? ', delta' : ''}`;
+    }
+    if (f.unit) c += ` [${f.unit}]`;
+    if (f.when) c += `, if ${f.when}`;
+    return c;
+}
+
+function cppEncode(f) {
+    const v = `r.${f.name}`;
+    switch (f.type) {
+        case 'bool': return [`w.writeBool(${v});`];
+        case 'enum':
+        case 'uint': return [`w.writeBits(${v}, ${f.bits});`];
+        case 'varint': return [`w.writeVarint(Varint::zigzag(${v}), ${f.group});`];
+        case 'scaled':
+            return [`w.writeScaled(${v}, ${cppDouble(f.min)}, ${cppDouble(f.step)}, ${f.maxQ}, ${f.bits});`];
+        case 'delta':
+            return [
+                `int32_t ${f.name} = (int32_t)BitWriter::quantize(${v}, ${cppDouble(f.min)}, ${cppDouble(f.step)}, ${f.maxQ});`,
+                `if (s.has_${f.name}) w.writeVarint(Varint::zigzag(${f.name} - s.${f.name}), ${f.group});`,
+                `else w.writeBits((uint32_t)${f.name}, ${f.bits});`,
+                `s.${f.name} = ${f.name};`,
+                `s.has_${f.name} = true;`
+            ];
+    }
+}
+
+function cppDecode(f) {
+    const v = `r.${f.name}`;
+    switch (f.type) {
+        case 'bool': return [`${v} = rd.readBool();`];
+        case 'enum':
+            return [`${v} = (uint8_t)rd.readBits(${f.bits});`, `if (${v} >= ${f.values.length}) return false;`];
+        case 'uint': return [`${v} = (${cppType(f)})rd.readBits(${f.bits});`];
+        case 'varint': return [`${v} = Varint::unzigzag(rd.readVarint(${f.group}));`];
+        case 'scaled':
+            return [`${v} = (${cppType(f)})rd.readScaled(${cppDouble(f.min)}, ${cppDouble(f.step)}, ${f.bits});`];
+        case 'delta':
+            return [
+                `int32_t ${f.name} = s.has_${f.name} ? s.${f.name} + Varint::unzigzag(rd.readVarint(${f.group}))`,
+                `${' '.repeat(`int32_t ${f.name} = s.has_${f.name} `.length)}: (int32_t)rd.readBits(${f.bits});`,
+                `s.${f.name} = ${f.name};`,
+                `s.has_${f.name} = true;`,
+                `${v} = (${cppType(f)})(${cppDouble(f.min)} + ${f.name} * ${cppDouble(f.step)});`
+            ];
+    }
+}
+
+function emitCpp(schema) {
+    const latest = schema.versions[schema.versions.length - 1];
+    const fields = latest.fields;
+    const P = pascal(schema.name);
+    const guard = `${schema.name.toUpperCase()}_SCHEMA_H`;
+    const deltas = fields.filter(f => f.type === 'delta');
+    const title = `${schema.name.toUpperCase().replace(/_/g, ' ')} SCHEMA - Generated Telemetry Codec`;
+    const width = Math.max(...fields.map(f => cppType(f).length + f.name.length + 2));
+
+    const L = [];
+    L.push('/*');
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(` *                    ${title}`);
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(' * ');
+    L.push(` * GENERATED by backend/schema-codegen.js from backend/schemas/${schema.name}.json`);
+    L.push(' * Do not edit: change the schema (new version for a new layout) and rerun');
+    L.push(' * ');
+    if (schema.description) L.push(` * ${schema.description}`);
+    L.push(` * Schema id ${schema.id}, version ${latest.version}: ${minRecordBits(fields)}..${fullRecordBits(fields)} bits per record`);
+    L.push(` * (${Math.floor((MAX_PAYLOAD - HEADER_LEN) * 8 / fullRecordBits(fields))}+ full records per ${MAX_PAYLOAD}-byte frame)`);
+    L.push(' * ');
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(' */');
+    L.push('');
+    L.push(`#ifndef ${guard}`);
+    L.push(`#define ${guard}`);
+    L.push('');
+    L.push('#include "../schema_frame.h"');
+    L.push('');
+
+    for (const f of fields.filter(f => f.type === 'enum')) {
+        const prefix = `${schema.name}_${f.name}`.toUpperCase();
+        L.push(`enum ${P}${pascal(f.name)} : uint8_t {`);
+        f.values.forEach((v, i) => {
+            L.push(`    ${prefix}_${v.toUpperCase()} = ${i}${i < f.values.length - 1 ? ',' : ''}`);
+        });
+        L.push('};');
+        L.push('');
+    }
+
+    L.push(`struct ${P}Record {`);
+    for (const f of fields) {
+        const decl = `${cppType(f)} ${f.name};`;
+        L.push(`    ${decl.padEnd(width + 1)}   // ${cppComment(f)}`);
+    }
+    L.push('};');
+    L.push('');
+    L.push(`class ${P}Schema {`);
+    L.push('public:');
+    L.push(`    typedef ${P}Record Record;`);
+    L.push('    ');
+    L.push(`    static const uint8_t ID = ${schema.id};`);
+    L.push(`    static const uint8_t VERSION = ${latest.version};`);
+    L.push('    ');
+    L.push('    // Delta references, reset at the start of every frame');
+    L.push('    struct State {');
+    for (const f of deltas) L.push(`        int32_t ${f.name} = 0;`);
+    for (const f of deltas) L.push(`        bool has_${f.name} = false;`);
+    L.push('    };');
+    L.push('    ');
+    L.push(`    static void encode(BitWriter& w, const Record& r, State& s) {`);
+    if (!deltas.length) L.push('        (void)s;');
+    L.push(...emitBody(fields, cppEncode));
+    L.push('    }');
+    L.push('    ');
+    L.push('    // False on an out-of-range enum (wrong schema or corrupt frame)');
+    L.push(`    static bool decode(BitReader& rd, Record& r, State& s) {`);
+    if (!deltas.length) L.push('        (void)s;');
+    L.push(...emitBody(fields, cppDecode, '0'));
+    L.push('        return !rd.overran();');
+    L.push('    }');
+    L.push('};');
+    L.push('');
+    L.push(`#endif // ${guard}`);
+    L.push('');
+    return L.join('\n');
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// JS EMITTER (every version: old devices keep decoding after an upgrade)
+// CommonJS for the backend. Works on Buffer and Uint8Array.
+// ═══════════════════════════════════════════════════════════════════════════
+const JS_RUNTIME = `const FRAME_SCHEMA = 0xA2;
+const SCHEMA_HEADER_LEN = ${HEADER_LEN};
+const SCHEMA_MAX_PAYLOAD = ${MAX_PAYLOAD};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BIT STREAM (MSB first, mirrors src/lora/schema_frame.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class BitWriter {
+    constructor(buf, start) {
+        this.buf = buf;
+        this.pos = start * 8;
+    }
+
+    writeBits(v, bits) {
+        if (this.pos + bits > this.buf.length * 8) throw new RangeError('Schema frame full');
+        for (let i = bits - 1; i >= 0; i--) {
+            if (Math.floor(v / 2 ** i) % 2) this.buf[this.pos >> 3] |= 0x80 >> (this.pos & 7);
+            this.pos++;
+        }
+    }
+
+    writeBool(v) {
+        this.writeBits(v ? 1 : 0, 1);
+    }
+
+    writeVarint(v, group) {
+        do {
+            this.writeBits(v % 2 ** group, group);
+            v = Math.floor(v / 2 ** group);
+            this.writeBits(v ? 1 : 0, 1);
+        } while (v);
+    }
+
+    byteLength() {
+        return (this.pos + 7) >> 3;
+    }
+}
+
+class BitReader {
+    constructor(buf, start) {
+        this.buf = buf;
+        this.pos = start * 8;
+        this.end = buf.length * 8;
+    }
+
+    readBits(bits) {
+        if (this.pos + bits > this.end) throw new Error('Truncated schema frame');
+        let v = 0;
+        for (let i = 0; i < bits; i++) {
+            v = v * 2 + ((this.buf[this.pos >> 3] >> (7 - (this.pos & 7))) & 1);
+            this.pos++;
+        }
+        return v;
+    }
+
+    readBool() {
+        return this.readBits(1) === 1;
+    }
+
+    readVarint(group) {
+        let v = 0;
+        for (let shift = 0; shift < 32; shift += group) {
+            v += this.readBits(group) * 2 ** shift;
+            if (!this.readBits(1)) return v;
+        }
+        throw new Error('Overlong varint in schema frame');
+    }
+
+    // Only zero padding may follow the last record
+    atEnd() {
+        return this.end - this.pos < 8;
+    }
+}
+
+function quantize(v, min, step, maxQ) {
+    const q = Math.floor((v - min) / step + 0.5);
+    if (!(q >= 0)) return 0;
+    return q > maxQ ? maxQ : q;
+}
+
+function zigzag(v) {
+    return v >= 0 ? v * 2 : -v * 2 - 1;
+}
+
+function unzigzag(v) {
+    return (v % 2) ? -((v + 1) / 2) : v / 2;
+}
+
+function enumIndex(values, v, name) {
+    const i = typeof v === 'number' ? v : values.indexOf(v);
+    if (!(i >= 0 && i < values.length)) throw new Error(\`Bad value for \${name}: \${v}\`);
+    return i;
+}
+`;
+
+const JS_FRAME = `// ═══════════════════════════════════════════════════════════════════════════
+// FRAMES
+// ═══════════════════════════════════════════════════════════════════════════
+
+function findSchema(id, version) {
+    return SCHEMAS.find(s => s.id === id && s.version === version) || null;
+}
+
+function decodeSchemaFrame(buf) {
+    if (buf.length < SCHEMA_HEADER_LEN || buf[0] !== FRAME_SCHEMA) {
+        throw new Error('Not a schema frame');
+    }
+
+    const schema = findSchema(buf[5], buf[6]);
+    if (!schema) throw new Error(\`Unknown schema id \${buf[5]} version \${buf[6]}\`);
+
+    const reader = new BitReader(buf, SCHEMA_HEADER_LEN);
+    const state = {};
+    const records = [];
+    for (let i = 0; i < buf[7]; i++) records.push(schema.decode(reader, state));
+
+    if (!reader.atEnd()) throw new Error('Trailing bytes in schema frame');
+
+    return {
+        type: 'schema',
+        schema: schema.name,
+        schemaId: schema.id,
+        version: schema.version,
+        deviceId: buf[1] | (buf[2] << 8),
+        seq: buf[3] | (buf[4] << 8),
+        records
+    };
+}
+
+// Latest version of the named schema; throws if the records do not fit
+function encodeSchemaFrame(name, deviceId, seq, records, maxLen = SCHEMA_MAX_PAYLOAD) {
+    const versions = SCHEMAS.filter(s => s.name === name);
+    if (!versions.length) throw new Error(\`Unknown schema \${name}\`);
+    const schema = versions[versions.length - 1];
+    if (records.length > 255) throw new RangeError('Too many records');
+
+    const buf = new Uint8Array(maxLen);
+    buf.set([FRAME_SCHEMA, deviceId & 0xFF, deviceId >> 8, seq & 0xFF, seq >> 8,
+             schema.id, schema.version, records.length]);
+
+    const writer = new BitWriter(buf, SCHEMA_HEADER_LEN);
+    const state = {};
+    for (const r of records) schema.encode(writer, r, state);
+    return buf.slice(0, writer.byteLength());
+}
+`;
+
+const jsOffset = f => (f.min ? `${f.min} + ` : '');
+
+function jsEncode(f) {
+    const v = `r.${f.name}`;
+    switch (f.type) {
+        case 'bool': return [`w.writeBool(${v});`];
+        case 'enum': return [`w.writeBits(enumIndex(${JSON.stringify(f.values)}, ${v}, '${f.name}'), ${f.bits});`];
+        case 'uint': return [`w.writeBits(${v} % ${2 ** f.bits}, ${f.bits});`];
+        case 'varint': return [`w.writeVarint(zigzag(${v}), ${f.group});`];
+        case 'scaled': return [`w.writeBits(quantize(${v}, ${f.min}, ${f.step}, ${f.maxQ}), ${f.bits});`];
+        case 'delta':
+            return [
+                `const ${f.name} = quantize(${v}, ${f.min}, ${f.step}, ${f.maxQ});`,
+                `if ('${f.name}' in s) w.writeVarint(zigzag(${f.name} - s.${f.name}), ${f.group});`,
+                `else w.writeBits(${f.name}, ${f.bits});`,
+                `s.${f.name} = ${f.name};`
+            ];
+    }
+}
+
+function jsDecode(f) {
+    const v = `r.${f.name}`;
+    switch (f.type) {
+        case 'bool': return [`${v} = rd.readBool();`];
+        case 'enum': {
+            return [
+                `${v} = ${JSON.stringify(f.values)}[rd.readBits(${f.bits})];`,
+                `if (${v} === undefined) throw new Error('Bad ${f.name} in schema frame');`
+            ];
+        }
+        case 'uint': return [`${v} = rd.readBits(${f.bits});`];
+        case 'varint': return [`${v} = unzigzag(rd.readVarint(${f.group}));`];
+        case 'scaled':
+            return [`${v} = +(${jsOffset(f)}rd.readBits(${f.bits}) * ${f.step}).toFixed(${f.decimals});`];
+        case 'delta':
+            return [
+                `const ${f.name} = ('${f.name}' in s) ? s.${f.name} + unzigzag(rd.readVarint(${f.group})) : rd.readBits(${f.bits});`,
+                `s.${f.name} = ${f.name};`,
+                `${v} = +(${jsOffset(f)}${f.name} * ${f.step}).toFixed(${f.decimals});`
+            ];
+    }
+}
+
+function emitJsCodec(schema, v) {
+    const meta = v.fields.map(f => {
+        const m = { name: f.name, type: f.type };
+        for (const k of ['values', 'min', 'max', 'step', 'unit', 'when']) if (f[k] !== undefined) m[k] = f[k];
+        return m;
+    });
+
+    const L = [];
+    L.push(`// ${schema.name} v${v.version} (id ${schema.id}): ${minRecordBits(v.fields)}..${fullRecordBits(v.fields)} bits per record`);
+    L.push('{');
+    L.push(`    name: '${schema.name}',`);
+    L.push(`    id: ${schema.id},`);
+    L.push(`    version: ${v.version},`);
+    L.push('    fields: [');
+    meta.forEach((m, i) => L.push(`        ${JSON.stringify(m)}${i < meta.length - 1 ? ',' : ''}`));
+    L.push('    ],');
+    L.push('    encode(w, r, s) {');
+    L.push(...emitBody(v.fields, jsEncode));
+    L.push('    },');
+    L.push('    decode(rd, s) {');
+    L.push('        const r = {};');
+    L.push(...emitBody(v.fields, jsDecode, 'null'));
+    L.push('        return r;');
+    L.push('    }');
+    L.push('}');
+    return L;
+}
+
+function emitJs(schemas) {
+    const L = [];
+    L.push('// Telemetry Schema Codecs');
+    L.push('// GENERATED by backend/schema-codegen.js from backend/schemas/*.json - do not edit');
+    L.push('// Decodes FRAME_SCHEMA uplinks (src/lora/schema_frame.h) for every schema version');
+    L.push('');
+    L.push(JS_RUNTIME);
+    L.push('// ═══════════════════════════════════════════════════════════════════════════');
+    L.push('// SCHEMA REGISTRY');
+    L.push('// ═══════════════════════════════════════════════════════════════════════════');
+    L.push('');
+    L.push('const SCHEMAS = [');
+    const codecs = [];
+    for (const s of schemas) for (const v of s.versions) codecs.push(emitJsCodec(s, v));
+    codecs.forEach((lines, i) => {
+        lines.forEach((l, j) => {
+            const last = j === lines.length - 1 && i < codecs.length - 1;
+            L.push(`    ${l}${last ? ',' : ''}`);
+        });
+    });
+    L.push('];');
+    L.push('');
+    L.push(JS_FRAME);
+    const names = ['FRAME_SCHEMA', 'SCHEMA_HEADER_LEN', 'SCHEMAS', 'findSchema', 'decodeSchemaFrame', 'encodeSchemaFrame'];
+    L.push(`module.exports = {\n${names.map(n => `    ${n}`).join(',\n')}\n};`);
+    L.push('');
+    return L.join('\n').replace(/[ \t]+$/gm, '');
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// TEST VECTORS (JS-encoded frames for the C++ host test)
+// Pseudo-random records (fixed seed per schema) on the quantization grid,
+// so both codecs must produce the same bits
+// ═══════════════════════════════════════════════════════════════════════════
+
+function vectorRecords(fields, count, rnd, walk) {
+    const records = [];
+    for (let k = 0; k < count; k++) {
+        const r = {};
+        for (const f of fields) {
+            switch (f.type) {
+                case 'bool':
+                    // Gate flags mostly on, so gated fields are exercised
+                    r[f.name] = fields.some(g => g.when === f.name) ? rnd() % 4 !== 0 : rnd() % 2 === 1;
+                    break;
+                case 'enum': r[f.name] = rnd() % f.values.length; break;
+                case 'uint': r[f.name] = rnd() % 2 ** f.bits; break;
+                case 'varint': r[f.name] = rnd() % 2001 - 1000; break;
+                case 'scaled': r[f.name] = f.min + (rnd() % (f.maxQ + 1)) * f.step; break;
+                case 'delta': {
+                    // Random walk: small steps after the first record
+                    const q = f.name in walk ? walk[f.name] + rnd() % 201 - 100 : rnd() % (f.maxQ + 1);
+                    walk[f.name] = Math.min(f.maxQ, Math.max(0, q));
+                    r[f.name] = f.min + walk[f.name] * f.step;
+                    break;
+                }
+            }
+        }
+        records.push(r);
+    }
+    return records;
+}
+
+function cppValue(f, v) {
+    if (v === null) return f.type === 'bool' ? 'false' : '0';
+    switch (f.type) {
+        case 'bool': return v ? 'true' : 'false';
+        case 'enum': return String(f.values.indexOf(v));
+        case 'uint':
+        case 'varint': return String(v);
+        default: return cppType(f) === 'double' ? cppDouble(v) : `${cppDouble(v)}f`;
+    }
+}
+
+function cppBytes(bytes) {
+    const L = [];
+    for (let i = 0; i < bytes.length; i += 16) {
+        const row = Array.from(bytes.slice(i, i + 16), b => `0x${b.toString(16).padStart(2, '0')}`);
+        L.push(`    ${row.join(', ')}${i + 16 < bytes.length ? ',' : ''}`);
+    }
+    return L;
+}
+
+function emitVectors(schemas, js) {
+    // The codec just generated, not the one on disk
+    const mod = { exports: {} };
+    new Function('module', 'exports', js)(mod, mod.exports);
+    const codec = mod.exports;
+
+    const L = [];
+    L.push('/*');
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(' *                    SCHEMA VECTORS - JS-Encoded Reference Frames');
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(' * ');
+    L.push(' * GENERATED by backend/schema-codegen.js from every schema in backend/schemas/');
+    L.push(' * Frames built by the JS codec (generated_schemas/index.js) and the records');
+    L.push(' * the JS decoder reads back; test_schema_frame decodes and re-encodes them');
+    L.push(' * with the C++ codec and expects the same bytes');
+    L.push(' * ');
+    L.push(' * ═══════════════════════════════════════════════════════════════════════════');
+    L.push(' */');
+    L.push('');
+    L.push('#ifndef SCHEMA_VECTORS_H');
+    L.push('#define SCHEMA_VECTORS_H');
+    L.push('');
+    L.push('#include <stdint.h>');
+    L.push('#include <stddef.h>');
+    for (const s of schemas) L.push(`#include "lora/schemas/${s.name}_schema.h"`);
+    L.push('');
+    L.push('template <class Schema>');
+    L.push('struct SchemaVector {');
+    L.push('    const uint8_t* frame;');
+    L.push('    size_t length;');
+    L.push('    const typename Schema::Record* records;');
+    L.push('    uint8_t count;');
+    L.push('};');
+
+    for (const s of schemas) {
+        const latest = s.versions[s.versions.length - 1];
+        const P = pascal(s.name);
+        const U = s.name.toUpperCase();
+        let seed = 0x9E3779B9 ^ s.id;
+        const rnd = () => {
+            seed ^= seed << 13;
+            seed ^= seed >>> 17;
+            seed ^= seed << 5;
+            return seed >>> 0;
+        };
+
+        // One record, a few, and as many as fit in a frame
+        const frames = [];
+        for (const count of [1, 6, 255]) {
+            const walk = {};
+            let records = vectorRecords(latest.fields, count, rnd, walk);
+            let frame = null;
+            while (!frame) {
+                try {
+                    frame = codec.encodeSchemaFrame(s.name, 7, 100 + frames.length, records);
+                } catch (err) {
+                    if (!(err instanceof RangeError)) throw err;
+                    records = records.slice(0, -1);
+                }
+            }
+            frames.push({ frame, decoded: codec.decodeSchemaFrame(frame).records });
+        }
+
+        L.push('');
+        L.push(`// ${s.name} v${latest.version}`);
+        frames.forEach(({ frame, decoded }, i) => {
+            L.push(`static const uint8_t ${U}_FRAME_${i}[] = {`);
+            L.push(...cppBytes(frame));
+            L.push('};');
+            L.push(`static const ${P}Record ${U}_RECORDS_${i}[] = {`);
+            decoded.forEach((r, j) => {
+                const values = latest.fields.map(f => cppValue(f, r[f.name]));
+                L.push(`    {${values.join(', ')}}${j < decoded.length - 1 ? ',' : ''}`);
+            });
+            L.push('};');
+        });
+        L.push(`static const SchemaVector<${P}Schema> ${U}_VECTORS[] = {`);
+        frames.forEach(({ decoded }, i) => {
+            L.push(`    {${U}_FRAME_${i}, sizeof(${U}_FRAME_${i}), ${U}_RECORDS_${i}, ${decoded.length}}${i < frames.length - 1 ? ',' : ''}`);
+        });
+        L.push('};');
+    }
+    L.push('');
+    L.push('#endif // SCHEMA_VECTORS_H');
+    L.push('');
+    return L.join('\n');
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// MAIN
+// ═══════════════════════════════════════════════════════════════════════════
+
+function outputs() {
+    const schemas = loadSchemas();
+    const files = schemas.map(s => [path.join(CPP_DIR, `${s.name}_schema.h`), emitCpp(s)]);
+    const js = emitJs(schemas);
+    files.push([BACKEND_OUT, js]);
+    files.push([VECTORS_OUT, emitVectors(schemas, js)]);
+    return { schemas, files };
+}
+
+if (require.main === module) {
+    const check = process.argv.includes('--check');
+    let result;
+    try {
+        result = outputs();
+    } catch (err) {
+        console.error(`[SCHEMA] ❌ ${err.message}`);
+        process.exit(1);
+    }
+
+    let stale = 0;
+    for (const [file, content] of result.files) {
+        const current = fs.existsSync(file) ? fs.readFileSync(file, 'utf8') : null;
+        if (current === content) continue;
+        stale++;
+        if (check) {
+            console.error(`[SCHEMA] ❌ Stale: ${path.relative(process.cwd(), file)}`);
+        } else {
+            fs.mkdirSync(path.dirname(file), { recursive: true });
+            fs.writeFileSync(file, content);
+            console.log(`[SCHEMA] ✅ Wrote ${path.relative(process.cwd(), file)}`);
+        }
+    }
+
+    const versions = result.schemas.reduce((n, s) => n + s.versions.length, 0);
+    console.log(`[SCHEMA] ${result.schemas.length} schema(s), ${versions} version(s), ${stale} file(s) ${check ? 'stale' : 'updated'}`);
+    if (check && stale) process.exit(1);
+}
+
+module.exports = { loadSchemas, emitCpp, emitJs, emitVectors };
@@ -3,8 +3,15 @@
 
 const express = require('express');
 const { exec } = require('child_process');
+const crypto = require('crypto');
 const fs = require('fs');
 const path = require('path');
+const deltaOta = require('./delta-ota');
+const heatshrink = require('./heatshrink');
+const moduleCompiler = require('./module-compiler');
+const moduleContract = require('./module-contract');
+const loraFrames = require('./lora-frames');
+const dgram = require('dgram');
 const { GoogleGenerativeAI } = require('@google/generative-ai');
 require('dotenv').config(); // Ensure you have dotenv installed
 
@@ -62,7 +69,8 @@ const jobs = new Map();
 // Enable CORS Manually (No dependency needed)
 app.use((req, res, next) => {
     res.header("Access-Control-Allow-Origin", "*");
-    res.header("Access-Control-Allow-Headers", "Origin, X-Requested-With, Content-Type, Accept");
+    res.header("Access-Control-Allow-Headers", "Origin, X-Requested-With, Content-Type, Accept, X-Delta-Base, X-Image-Accept");
+    res.header("Access-Control-Expose-Headers", "X-Image-SHA256, X-Image-Signature, X-Image-Encoding, X-Image-Size, X-Module-Name");
     res.header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
     if (req.method === 'OPTIONS') {
         return res.sendStatus(200);
@@ -223,8 +231,12 @@ async function compileAndFlash(sourceHeaderPath, smartName) {
     }
 
     try {
-        // 2. Inject new code
+        // 2. Inject new code (after the contract check: fails in ms, not after a build)
         const headerContent = fs.readFileSync(sourceHeaderPath, 'utf-8');
+        const contract = moduleContract.checkModule(headerContent, { current: true });
+        if (!contract.ok) {
+            throw new Error(`Module contract: ${contract.errors.join('; ')}`);
+        }
         fs.writeFileSync(targetPath, headerContent);
 
         // 3. Run Compilation (PlatformIO)
@@ -235,9 +247,11 @@ async function compileAndFlash(sourceHeaderPath, smartName) {
         // We assume it's in PATH. If not, user might need to adjust.
         // On Windows cmd, 'platformio' or 'pio'
         const buildCmd = 'platformio run -e uad_main';
+        // The injected module replaces the module registry (include/config.h)
+        const buildEnv = { ...process.env, PLATFORMIO_BUILD_FLAGS: '-D MODULE_REGISTRY_ENABLED=0' };
 
         await new Promise((resolve, reject) => {
-            exec(buildCmd, { cwd: projectRoot }, (error, stdout, stderr) => {
+            exec(buildCmd, { cwd: projectRoot, env: buildEnv }, (error, stdout, stderr) => {
                 if (error) {
                     console.error(`[BUILD] Error: ${error.message}`);
                     return reject(new Error(stdout || stderr || error.message)); // capture compiler output
@@ -716,9 +730,16 @@ public:
     }
 };
 
+using CurrentModule = ${className};
+
 #endif
 \`\`\`
 
+Use SensorData and TelemetryData from "../include/types.h" as they are: do
+NOT define your own. update() takes \`const SensorData&\`. Optional:
+\`uint32_t getSampleInterval()\` (ms between update() calls) and
+\`void updateBatch(const SensorData* samples, size_t n)\`.
+
 ═══════════════════════════════════════════════════════════════════════════════
 TINYML / AI CAPABILITIES (TensorFlow Lite Micro)
 ═══════════════════════════════════════════════════════════════════════════════
@@ -762,6 +783,12 @@ OUTPUT RULES
         const modulePath = `./generated_modules/${smartName}_module.h`;
         fs.writeFileSync(modulePath, fixedCppCode);
 
+        // Same checks as the firmware's static_asserts, before any build (the file stays for inspection)
+        const contract = moduleContract.checkModule(fixedCppCode, { className, current: true });
+        if (!contract.ok) {
+            throw new Error(`Module contract: ${contract.errors.join('; ')}`);
+        }
+
         // Update Job Status
         jobs.set(jobId, { status: 'compiling', device_type: deviceType, smart_name: smartName });
 
@@ -832,6 +859,84 @@ app.get('/api/modules/status', (req, res) => {
     res.json(job);
 });
 
+// ═══════════════════════════════════════════════════════════════════════════
+// OTA SIGNING KEY
+// OTA_SIGNING_KEY: path to an EC P-256 private key (PEM). Its public half
+// goes into the firmware as OTA_SIGNING_PUBKEY (include/config.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+let otaSigningKey = null;
+if (process.env.OTA_SIGNING_KEY) {
+    try {
+        otaSigningKey = crypto.createPrivateKey(fs.readFileSync(process.env.OTA_SIGNING_KEY));
+        console.log('[OTA] Signing module downloads');
+    } catch (e) {
+        console.error(`[OTA] ❌ Cannot load OTA_SIGNING_KEY: ${e.message}`);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ENCODED DOWNLOADS
+// A device lists what it decodes (X-Image-Accept: "delta, heatshrink",
+// src/ota_decoder.h) and names its running image (X-Delta-Base: SHA-256
+// hex). If that image is one we served (kept in SERVED_DIR by SHA, since a
+// rebuild overwrites compiled_modules) or built, a compressed patch against
+// it travels; otherwise the compressed image. Either only when it saves
+// enough to be worth decoding
+// ═══════════════════════════════════════════════════════════════════════════
+
+const OTA_HS_WINDOW_BITS = 10;      // include/config.h
+const OTA_HS_LOOKAHEAD_BITS = 5;
+const ENCODED_MAX_RATIO = 0.9;      // Bigger: the raw image is as good
+const ENCODED_CACHE_SIZE = 16;
+const SERVED_DIR = './compiled_modules/served';
+const encodedCache = new Map();     // "<base sha | ->:<image sha>" → Buffer (or null)
+
+function cachedEncoding(key, make) {
+    if (encodedCache.has(key)) return encodedCache.get(key);
+    const body = make();
+    if (encodedCache.size >= ENCODED_CACHE_SIZE) encodedCache.delete(encodedCache.keys().next().value);
+    encodedCache.set(key, body);
+    return body;
+}
+
+function compressImage(raw, image, label) {
+    const start = Date.now();
+    const packed = heatshrink.compress(raw, OTA_HS_WINDOW_BITS, OTA_HS_LOOKAHEAD_BITS);
+    console.log(`[OTA] ${label}: ${image.length} → ${packed.length} bytes ` +
+                `(${(packed.length * 100 / image.length).toFixed(1)}%), ${Date.now() - start} ms`);
+    return packed.length < image.length * ENCODED_MAX_RATIO ? packed : null;
+}
+
+function deltaFor(baseSha, image, imageSha) {
+    return cachedEncoding(`${baseSha}:${imageSha}`, () => {
+        const served = path.join(SERVED_DIR, `${baseSha}.bin`);
+        const baseFile = baseSha !== imageSha &&
+                         (fs.existsSync(served) ? served : deltaOta.findImageBySha('./compiled_modules', baseSha));
+        if (!baseFile) return null;
+        const patch = deltaOta.makePatch(fs.readFileSync(baseFile), image);
+        return compressImage(patch, image, `Delta from ${path.basename(baseFile)}`);
+    });
+}
+
+function compressedFor(image, imageSha) {
+    return cachedEncoding(`-:${imageSha}`, () => compressImage(image, image, 'Heatshrink'));
+}
+
+// Firmware from before X-Image-Accept sent only X-Delta-Base, and decoded both stages
+function acceptedEncodings(req) {
+    const header = req.get('X-Image-Accept');
+    if (header === undefined) return new Set(req.get('X-Delta-Base') ? ['delta', 'heatshrink'] : []);
+    return new Set(header.split(',').map((e) => e.trim().toLowerCase()));
+}
+
+function keepServedImage(image, imageSha) {
+    const file = path.join(SERVED_DIR, `${imageSha}.bin`);
+    if (fs.existsSync(file)) return;
+    fs.mkdirSync(SERVED_DIR, { recursive: true });
+    fs.writeFileSync(file, image);
+}
+
 // ═══════════════════════════════════════════════════════════════════════════
 // API: DOWNLOAD MODULE
 // ═══════════════════════════════════════════════════════════════════════════
@@ -845,7 +950,97 @@ app.get('/api/modules/download', (req, res) => {
         return;
     }
 
-    res.sendFile(path.resolve(modulePath));
+    // The device checks both before Update.end() (src/ota_writer.h).
+    // Always over the full image, whatever travels
+    const image = fs.readFileSync(modulePath);
+    const imageSha = deltaOta.sha256(image).toString('hex');
+    res.set('X-Image-SHA256', imageSha);
+    keepServedImage(image, imageSha);
+    if (otaSigningKey) {
+        res.set('X-Image-Signature', crypto.sign('sha256', image, otaSigningKey).toString('hex'));
+    }
+    res.set('Content-Type', 'application/octet-stream');
+
+    const accepted = acceptedEncodings(req);
+    const baseSha = (req.get('X-Delta-Base') || '').toLowerCase();
+    let encoding = 'raw';
+    let body = null;
+    if (accepted.has('heatshrink') && accepted.has('delta') && /^[0-9a-f]{64}$/.test(baseSha)) {
+        body = deltaFor(baseSha, image, imageSha);
+        encoding = 'delta+heatshrink';
+    }
+    if (!body && accepted.has('heatshrink')) {
+        body = compressedFor(image, imageSha);
+        encoding = 'heatshrink';
+    }
+    if (body) {
+        res.set('X-Image-Encoding', encoding);
+        res.set('X-Image-Size', String(image.length));
+        res.send(body);
+        return;
+    }
+    res.send(image);
+});
+
+// ═══════════════════════════════════════════════════════════════════════════
+// API: BYTECODE MODULES (module-compiler.js → src/managers/vm_module_manager.h)
+// Milliseconds to swap in over BLE (MODULE_WRITE / MODULE_COMMIT) instead
+// of compileAndFlash and a reboot
+// ═══════════════════════════════════════════════════════════════════════════
+
+const VM_MODULES_DIR = './vm_modules';
+
+function compileModule(source, res) {
+    try {
+        return moduleCompiler.compile(source);
+    } catch (e) {
+        if (!(e instanceof moduleCompiler.CompileError)) throw e;
+        res.status(400).json({ error: e.message });
+        return null;
+    }
+}
+
+function moduleInfo(result) {
+    return {
+        name: result.name,
+        context: result.context,
+        size: result.program.length,
+        instructions: result.instructions,
+        registers: result.registers,
+        params: result.params
+    };
+}
+
+app.get('/api/modules/vm', (req, res) => {
+    const names = fs.existsSync(VM_MODULES_DIR) ?
+        fs.readdirSync(VM_MODULES_DIR).filter((f) => f.endsWith('.uadm')).map((f) => f.slice(0, -5)) : [];
+    res.json({ modules: names });
+});
+
+app.get('/api/modules/vm/:name', (req, res) => {
+    const file = path.join(VM_MODULES_DIR, `${path.basename(req.params.name)}.uadm`);
+    if (!fs.existsSync(file)) {
+        res.status(404).json({ error: 'Module not found' });
+        return;
+    }
+    const result = compileModule(fs.readFileSync(file, 'utf8'), res);
+    if (!result) return;
+    res.set('Content-Type', 'application/octet-stream');
+    res.set('X-Module-Name', result.name);
+    res.send(result.program);
+});
+
+// { source } → program (base64) or { error: "line:col: message" }
+app.post('/api/modules/vm/compile', (req, res) => {
+    const { source } = req.body || {};
+    if (typeof source !== 'string') {
+        res.status(400).json({ error: 'source required' });
+        return;
+    }
+    const result = compileModule(source, res);
+    if (!result) return;
+    console.log(`[VM] Compiled ${result.name}: ${result.program.length} bytes, ${result.instructions} instructions`);
+    res.json({ ...moduleInfo(result), program: result.program.toString('base64') });
 });
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -1443,6 +1638,53 @@ function generateSmartName(userInput) {
     return sanitized.substring(0, 8);
 }
 
+// ═══════════════════════════════════════════════════════════════════════════
+// LORA GATEWAY INGEST
+// The gateway (src/gateway_main.cpp, -D GATEWAY_UDP_HOST) sends its records
+// as UDP datagrams. Every uplink is decoded here (telemetry, schema and
+// legacy frames, lora-frames.js); the dashboard reads the decoded JSON
+// ═══════════════════════════════════════════════════════════════════════════
+
+const GATEWAY_UDP_PORT = parseInt(process.env.GATEWAY_UDP_PORT || '1700', 10);
+const TELEMETRY_KEEP = 100;   // Decoded frames kept per device
+
+const telemetry = new Map();  // device id -> newest first
+let ingestErrors = 0;
+
+function ingestGatewayDatagram(msg) {
+    for (const record of loraFrames.parseGatewayRecords(msg)) {
+        const { payload, ...radio } = record;
+        let frame;
+        try {
+            frame = loraFrames.decodeFrame(payload);
+        } catch (e) {
+            ingestErrors++;
+            console.warn(`[LORA] ⚠️ Undecodable uplink (${payload.length} bytes): ${e.message}`);
+            continue;
+        }
+
+        const dev = frame.deviceId ?? radio.dev ?? 'unknown';
+        const list = telemetry.get(dev) || [];
+        list.unshift({ received: Date.now(), radio, frame });
+        if (list.length > TELEMETRY_KEEP) list.length = TELEMETRY_KEEP;
+        telemetry.set(dev, list);
+    }
+}
+
+// Latest decoded frame of every device
+app.get('/api/telemetry', (req, res) => {
+    const devices = [...telemetry.entries()].map(([dev, list]) => ({ dev, frames: list.length, latest: list[0] }));
+    res.json({ devices, errors: ingestErrors });
+});
+
+// Recent decoded frames of one device (?limit=n)
+app.get('/api/telemetry/:dev', (req, res) => {
+    const list = telemetry.get(Number(req.params.dev)) || telemetry.get(req.params.dev);
+    if (!list) return res.status(404).json({ error: 'No frames from this device' });
+    const limit = Math.min(parseInt(req.query.limit || TELEMETRY_KEEP, 10) || TELEMETRY_KEEP, TELEMETRY_KEEP);
+    res.json({ dev: req.params.dev, frames: list.slice(0, limit) });
+});
+
 // ═══════════════════════════════════════════════════════════════════════════
 // START SERVER
 // ═══════════════════════════════════════════════════════════════════════════
@@ -1459,4 +1701,11 @@ app.listen(PORT, () => {
     console.log(`📁 Generated modules: ./generated_modules`);
     console.log(`📦 Compiled binaries: ./compiled_modules`);
     console.log(`🎨 Generated widgets: ./generated_widgets`);
+});
+
+const gatewaySocket = dgram.createSocket('udp4');
+gatewaySocket.on('message', ingestGatewayDatagram);
+gatewaySocket.on('error', (e) => console.error(`[LORA] ❌ Gateway UDP: ${e.message}`));
+gatewaySocket.bind(GATEWAY_UDP_PORT, () => {
+    console.log(`📡 LoRa gateway records on UDP ${GATEWAY_UDP_PORT}`);
 });
\ No newline at end of file
@@ -4,13 +4,145 @@ import { Capacitor } from '@capacitor/core';
 // UAD BLE Service UUIDs
 const SERVICE_UUID = '4fafc201-1fb5-459e-8fcc-c5c9c331914b';
 const TX_CHARACTERISTIC = 'beb5483e-36e1-4688-b7f5-ea07361b26a8';  // Device → Phone
-const RX_CHARACTERISTIC = 'beb5483e-36e1-4688-b7f5-ea07361b26a9';  // Phone → Device
+const RX_CHARACTERISTIC = 'beb5483e-36e1-4688-b7f5-ea07361b26a9';  // Phone → Device (commands + replies)
+const STREAM_CHARACTERISTIC = 'beb5483e-36e1-4688-b7f5-ea07361b26aa';  // Device → Phone (binary)
+const OTA_CHARACTERISTIC = 'beb5483e-36e1-4688-b7f5-ea07361b26ab';  // Phone → Device (firmware image)
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BINARY STREAM DECODER (mirrors src/ble/ble_stream.h)
+// ═══════════════════════════════════════════════════════════════════════════
+
+const BLE_FRAME_IMU = 0x01;
+const BLE_FRAME_STATUS = 0x02;
+const STREAM_HEADER_LEN = 8;
+const IMU_SAMPLE_LEN = 13;
+
+// Raw capture frames (0x10..0x13) are decoded by CaptureRecorder.js
+const CAPTURE_FRAME_FIRST = 0x10;
+const CAPTURE_FRAME_LAST = 0x13;
+
+// value: DataView of one notification
+export function decodeStreamFrame(value) {
+    const type = value.getUint8(0);
+
+    if (type === BLE_FRAME_STATUS) {
+        return {
+            type: 'status',
+            context: value.getUint8(1),
+            status: value.getUint8(2),
+            value: value.getUint16(3, true),
+            battery: value.getUint8(5)
+        };
+    }
+
+    if (type !== BLE_FRAME_IMU) throw new Error(`Unknown stream frame 0x${type.toString(16)}`);
+
+    const count = value.getUint8(1);
+    if (value.byteLength !== STREAM_HEADER_LEN + count * IMU_SAMPLE_LEN) {
+        throw new Error(`IMU frame length ${value.byteLength} does not match ${count} samples`);
+    }
+
+    const samples = [];
+    let t = value.getUint32(4, true);
+    let pos = STREAM_HEADER_LEN;
+    for (let i = 0; i < count; i++) {
+        t += value.getUint8(pos);
+        samples.push({
+            t,
+            ax: value.getInt16(pos + 1, true) / 1000,    // g
+            ay: value.getInt16(pos + 3, true) / 1000,
+            az: value.getInt16(pos + 5, true) / 1000,
+            gx: value.getInt16(pos + 7, true) / 10,      // deg/s
+            gy: value.getInt16(pos + 9, true) / 10,
+            gz: value.getInt16(pos + 11, true) / 10
+        });
+        pos += IMU_SAMPLE_LEN;
+    }
+
+    return { type: 'imu', seq: value.getUint16(2, true), samples };
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BINARY COMMANDS (mirrors src/ble/ble_command.h)
+// command [opcode][length][payload], reply [opcode | 0x80][1 + n][status][data]
+// ═══════════════════════════════════════════════════════════════════════════
+
+export const CMD = {
+    PING: 0x01,
+    GET_INFO: 0x02,
+    PARAM_SET: 0x10,
+    PARAM_GET: 0x11,
+    CALIBRATE: 0x12,
+    CAPTURE_START: 0x20,
+    CAPTURE_STOP: 0x21,
+    OTA_BEGIN: 0x30,
+    OTA_STATUS: 0x31,
+    OTA_END: 0x32,
+    OTA_ACTIVATE: 0x33,
+    OTA_ABORT: 0x34,
+    OTA_BASE: 0x35,
+    MODULE_WRITE: 0x40,
+    MODULE_COMMIT: 0x41,
+    MODULE_UNLOAD: 0x42,
+    MODULE_INFO: 0x43,
+    MODULE_SELECT: 0x44
+};
+
+export const CMD_STATUS = ['OK', 'UNKNOWN', 'BAD_LENGTH', 'BAD_VALUE', 'BUSY', 'UNSUPPORTED', 'MALFORMED'];
+
+const CMD_REPLY_FLAG = 0x80;
+const CMD_ERROR_OPCODE = 0xFF;
+const CMD_TIMEOUT_MS = 2000;
+
+// Helmet module parameters (HelmetModule::Param)
+export const HELMET_PARAM = {
+    FREEFALL_MG: 1,
+    IMPACT_MG: 2,
+    FALL_WINDOW_MS: 3
+};
+
+// MODULE_COMMIT reply: why the device rejected a program (src/vm/vm_program.h VmError)
+export const VM_ERRORS = ['OK', 'HEADER', 'SIZE', 'CRC', 'OPERAND', 'JUMP', 'FALLTHROUGH', 'PARAM', 'STEPS'];
+
+export function encodeCommand(opcode, payload = new Uint8Array(0)) {
+    if (payload.length > 255) throw new Error(`Command payload too long (${payload.length})`);
+    const out = new Uint8Array(2 + payload.length);
+    out[0] = opcode;
+    out[1] = payload.length;
+    out.set(payload, 2);
+    return out;
+}
+
+// value: DataView of one RX notification (may hold several replies)
+export function decodeReplies(value) {
+    const replies = [];
+    let pos = 0;
+    while (pos + 3 <= value.byteLength) {
+        const len = value.getUint8(pos + 1);
+        if (len < 1 || pos + 2 + len > value.byteLength) break;
+        const opcode = value.getUint8(pos);
+        const status = value.getUint8(pos + 2);
+        replies.push({
+            opcode: opcode === CMD_ERROR_OPCODE ? opcode : opcode & ~CMD_REPLY_FLAG,
+            status,
+            statusName: CMD_STATUS[status] || `0x${status.toString(16)}`,
+            data: new DataView(value.buffer, value.byteOffset + pos + 3, len - 1)
+        });
+        pos += 2 + len;
+    }
+    return replies;
+}
 
 class BLEService {
     constructor() {
         this.device = null;
         this.isConnected = false;
         this.onDataCallback = null;
+        this.onImuCallback = null;
+        this.onCaptureCallback = null;
+        this.streaming = false;
+        this.streamStats = { frames: 0, samples: 0, lostFrames: 0, lastSeq: null };
+        this.pendingReplies = new Map();   // opcode → [{ resolve, timer }]
     }
 
     // ═══════════════════════════════════════════════════════════════════════
@@ -51,6 +183,8 @@ class BLEService {
             await BleClient.connect(device.deviceId, (deviceId) => {
                 console.log('[BLE] ❌ Disconnected from', deviceId);
                 this.isConnected = false;
+                this.streaming = false;
+                this.failPendingReplies();
             });
 
             this.device = device;
@@ -99,6 +233,121 @@ class BLEService {
         } catch (error) {
             console.error('[BLE] Failed to start notifications:', error);
         }
+
+        try {
+            await BleClient.startNotifications(
+                this.device.deviceId,
+                SERVICE_UUID,
+                RX_CHARACTERISTIC,
+                (value) => this.handleReplies(value)
+            );
+        } catch (error) {
+            console.error('[BLE] Failed to subscribe to command replies:', error);
+        }
+    }
+
+    // ═══════════════════════════════════════════════════════════════════════
+    // BINARY STREAM (live IMU chart)
+    // Subscribing switches the device to binary telemetry at BLE_IMU_RATE_HZ
+    // and a fast link; unsubscribe when the chart closes to save its battery
+    // ═══════════════════════════════════════════════════════════════════════
+
+    async startStream(onImu) {
+        if (!this.device) return false;
+        if (onImu) this.onImuCallback = onImu;
+
+        try {
+            // Android: short connection interval (the MTU is requested on connect)
+            if (Capacitor.getPlatform() === 'android') {
+                await BleClient.requestConnectionPriority(this.device.deviceId, 1);
+            }
+        } catch (error) {
+            console.warn('[BLE] Connection priority not changed:', error);
+        }
+
+        try {
+            this.streamStats = { frames: 0, samples: 0, lostFrames: 0, lastSeq: null };
+            await BleClient.startNotifications(
+                this.device.deviceId,
+                SERVICE_UUID,
+                STREAM_CHARACTERISTIC,
+                (value) => this.handleStreamFrame(value)
+            );
+            this.streaming = true;
+            console.log('[BLE] 📈 Stream started');
+            return true;
+        } catch (error) {
+            // Firmware without the stream characteristic keeps sending JSON
+            console.error('[BLE] Failed to start stream:', error);
+            return false;
+        }
+    }
+
+    async stopStream() {
+        if (!this.device || !this.streaming) return;
+
+        try {
+            await BleClient.stopNotifications(this.device.deviceId, SERVICE_UUID, STREAM_CHARACTERISTIC);
+            if (Capacitor.getPlatform() === 'android') {
+                await BleClient.requestConnectionPriority(this.device.deviceId, 0);
+            }
+        } catch (error) {
+            console.error('[BLE] Failed to stop stream:', error);
+        }
+        this.streaming = false;
+        console.log('[BLE] 📉 Stream stopped');
+    }
+
+    handleStreamFrame(value) {
+        const type = value.getUint8(0);
+        if (type >= CAPTURE_FRAME_FIRST && type <= CAPTURE_FRAME_LAST) {
+            if (this.onCaptureCallback) this.onCaptureCallback(value);
+            return;
+        }
+
+        let frame;
+        try {
+            frame = decodeStreamFrame(value);
+        } catch (e) {
+            console.error('[BLE] Bad stream frame:', e);
+            return;
+        }
+
+        if (frame.type === 'status') {
+            if (this.onDataCallback) this.onDataCallback(frame);
+            return;
+        }
+
+        const stats = this.streamStats;
+        if (stats.lastSeq !== null) stats.lostFrames += (frame.seq - stats.lastSeq - 1) & 0xFFFF;
+        stats.lastSeq = frame.seq;
+        stats.frames++;
+        stats.samples += frame.samples.length;
+
+        if (this.onImuCallback) this.onImuCallback(frame.samples);
+    }
+
+    // ═══════════════════════════════════════════════════════════════════════
+    // RAW CAPTURE (every IMU sample at the full ODR, see CaptureRecorder.js)
+    // The live IMU batches pause on the device until the capture stops
+    // ═══════════════════════════════════════════════════════════════════════
+
+    async startCapture({ odr = 1000, audio = false } = {}, onFrame) {
+        if (!this.streaming && !(await this.startStream())) return false;
+        this.onCaptureCallback = onFrame;
+        const payload = new Uint8Array([odr & 0xFF, odr >> 8, audio ? 0x01 : 0x00]);
+        const reply = await this.sendBinaryCommand(CMD.CAPTURE_START, payload);
+        return reply.status === 0;
+    }
+
+    // The device answers with its STOP frame once the queue is drained
+    async stopCapture() {
+        const reply = await this.sendBinaryCommand(CMD.CAPTURE_STOP);
+        return reply.status === 0;
+    }
+
+    endCapture() {
+        this.onCaptureCallback = null;
     }
 
     // ═══════════════════════════════════════════════════════════════════════
@@ -131,6 +380,233 @@ class BLEService {
         }
     }
 
+    // ═══════════════════════════════════════════════════════════════════════
+    // BINARY COMMANDS
+    // Resolves with { status, statusName, data } of the matching reply;
+    // status is null when the device did not answer in time
+    // ═══════════════════════════════════════════════════════════════════════
+
+    async sendBinaryCommand(opcode, payload) {
+        if (!this.device || !this.isConnected) {
+            console.error('[BLE] Not connected');
+            return { opcode, status: null, statusName: 'NOT_CONNECTED', data: null };
+        }
+
+        const bytes = encodeCommand(opcode, payload);
+        const reply = new Promise((resolve) => {
+            const entry = { resolve };
+            entry.timer = setTimeout(() => {
+                this.takePending(opcode, entry);
+                resolve({ opcode, status: null, statusName: 'TIMEOUT', data: null });
+            }, CMD_TIMEOUT_MS);
+            if (!this.pendingReplies.has(opcode)) this.pendingReplies.set(opcode, []);
+            this.pendingReplies.get(opcode).push(entry);
+        });
+
+        try {
+            await BleClient.writeWithoutResponse(
+                this.device.deviceId,
+                SERVICE_UUID,
+                RX_CHARACTERISTIC,
+                new DataView(bytes.buffer)
+            );
+        } catch (error) {
+            console.error('[BLE] Failed to send command:', error);
+            this.resolvePending(opcode, { opcode, status: null, statusName: 'WRITE_FAILED', data: null });
+        }
+
+        const result = await reply;
+        if (result.status !== 0) {
+            console.warn(`[BLE] Command 0x${opcode.toString(16)}: ${result.statusName}`);
+        }
+        return result;
+    }
+
+    handleReplies(value) {
+        for (const reply of decodeReplies(value)) {
+            if (reply.opcode === CMD_ERROR_OPCODE) {
+                console.error('[BLE] Device could not parse a command write');
+                continue;
+            }
+            this.resolvePending(reply.opcode, reply);
+        }
+    }
+
+    // Replies come back in command order: the oldest waiter gets it
+    resolvePending(opcode, reply) {
+        const queue = this.pendingReplies.get(opcode);
+        if (!queue || queue.length === 0) return;
+        const entry = queue.shift();
+        clearTimeout(entry.timer);
+        entry.resolve(reply);
+    }
+
+    takePending(opcode, entry) {
+        const queue = this.pendingReplies.get(opcode);
+        const i = queue ? queue.indexOf(entry) : -1;
+        if (i >= 0) queue.splice(i, 1);
+    }
+
+    failPendingReplies() {
+        for (const [opcode, queue] of this.pendingReplies) {
+            for (const entry of queue) {
+                clearTimeout(entry.timer);
+                entry.resolve({ opcode, status: null, statusName: 'DISCONNECTED', data: null });
+            }
+        }
+        this.pendingReplies.clear();
+    }
+
+    // Round trip in ms, null on timeout
+    async ping() {
+        const start = performance.now();
+        const reply = await this.sendBinaryCommand(CMD.PING, new Uint8Array([0x55, 0xAA]));
+        return reply.status === 0 ? performance.now() - start : null;
+    }
+
+    async getInfo() {
+        const reply = await this.sendBinaryCommand(CMD.GET_INFO);
+        if (reply.status !== 0 || reply.data.byteLength < 5) return null;
+        return {
+            protocol: reply.data.getUint8(0),
+            deviceId: reply.data.getUint16(1, true),
+            context: reply.data.getUint8(3),
+            capturing: (reply.data.getUint8(4) & 0x01) !== 0
+        };
+    }
+
+    // id: module parameter (e.g. HELMET_PARAM.IMPACT_MG), value: int32
+    async setModuleParam(id, value) {
+        const payload = new Uint8Array(5);
+        payload[0] = id;
+        new DataView(payload.buffer).setInt32(1, value, true);
+        const reply = await this.sendBinaryCommand(CMD.PARAM_SET, payload);
+        return reply.status === 0;
+    }
+
+    async getModuleParam(id) {
+        const reply = await this.sendBinaryCommand(CMD.PARAM_GET, new Uint8Array([id]));
+        return reply.status === 0 ? reply.data.getInt32(0, true) : null;
+    }
+
+    // Running image (delta OTA base): { size, sha } with sha as hex, null if unknown
+    async getOtaBase() {
+        const reply = await this.sendBinaryCommand(CMD.OTA_BASE);
+        if (reply.status !== 0 || reply.data.byteLength < 36) return null;
+        let sha = '';
+        for (let i = 4; i < 36; i++) sha += reply.data.getUint8(i).toString(16).padStart(2, '0');
+        return { size: reply.data.getUint32(0, true), sha };
+    }
+
+    // ═══════════════════════════════════════════════════════════════════════
+    // BYTECODE MODULE (backend /api/modules/vm, no reflash or reboot)
+    // ═══════════════════════════════════════════════════════════════════════
+
+    // program: Uint8Array from module-compiler.js → { ok, error }
+    async loadVmModule(program) {
+        const chunk = Math.min(await this.getWritePayload() - 4, 240);
+        for (let offset = 0; offset < program.length; offset += chunk) {
+            const part = program.subarray(offset, offset + chunk);
+            const payload = new Uint8Array(2 + part.length);
+            new DataView(payload.buffer).setUint16(0, offset, true);
+            payload.set(part, 2);
+            const reply = await this.sendBinaryCommand(CMD.MODULE_WRITE, payload);
+            if (reply.status !== 0) return { ok: false, error: reply.statusName };
+        }
+        const size = new Uint8Array(2);
+        new DataView(size.buffer).setUint16(0, program.length, true);
+        const reply = await this.sendBinaryCommand(CMD.MODULE_COMMIT, size);
+        if (reply.status === 0) return { ok: true, error: null };
+        const vmError = reply.data && reply.data.byteLength > 0 ? VM_ERRORS[reply.data.getUint8(0)] : null;
+        return { ok: false, error: vmError || reply.statusName };
+    }
+
+    async unloadVmModule() {
+        const reply = await this.sendBinaryCommand(CMD.MODULE_UNLOAD);
+        return reply.status === 0;
+    }
+
+    // { loaded, running, swapping, context, fault, size, crc, swapUs, name }, null if unsupported
+    async getVmModule() {
+        const reply = await this.sendBinaryCommand(CMD.MODULE_INFO);
+        if (reply.status !== 0 || reply.data.byteLength < 11) return null;
+        const d = reply.data;
+        const flags = d.getUint8(0);
+        const name = new TextDecoder().decode(new Uint8Array(d.buffer, d.byteOffset + 11, d.byteLength - 11));
+        return {
+            loaded: (flags & 0x01) !== 0,
+            running: (flags & 0x02) !== 0,
+            swapping: (flags & 0x04) !== 0,
+            context: d.getUint8(1),
+            fault: VM_ERRORS[d.getUint8(2)],
+            size: d.getUint16(3, true),
+            crc: d.getUint32(5, true),
+            swapUs: d.getUint16(9, true),
+            name
+        };
+    }
+
+    // Compiled-in module for a context (module registry firmware) → status name
+    async selectModule(context) {
+        const reply = await this.sendBinaryCommand(CMD.MODULE_SELECT, new Uint8Array([context]));
+        return reply.statusName;
+    }
+
+    // ═══════════════════════════════════════════════════════════════════════
+    // FIRMWARE UPDATE TRANSPORT (protocol in OtaSender.js)
+    // ═══════════════════════════════════════════════════════════════════════
+
+    async startOtaNotifications(onMessage) {
+        if (!this.device) return false;
+        try {
+            await BleClient.startNotifications(this.device.deviceId, SERVICE_UUID, OTA_CHARACTERISTIC, onMessage);
+            return true;
+        } catch (error) {
+            // Firmware without BLE OTA
+            console.error('[BLE] OTA characteristic not available:', error);
+            return false;
+        }
+    }
+
+    async stopOtaNotifications() {
+        if (!this.device || !this.isConnected) return;
+        try {
+            await BleClient.stopNotifications(this.device.deviceId, SERVICE_UUID, OTA_CHARACTERISTIC);
+        } catch (error) {
+            console.error('[BLE] Failed to stop OTA notifications:', error);
+        }
+    }
+
+    // bytes: Uint8Array, [offset u32 LE][image bytes]
+    async writeOta(bytes) {
+        await BleClient.writeWithoutResponse(
+            this.device.deviceId,
+            SERVICE_UUID,
+            OTA_CHARACTERISTIC,
+            new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength)
+        );
+    }
+
+    // Largest write payload the link takes (ATT MTU - 3)
+    async getWritePayload() {
+        try {
+            const mtu = await BleClient.getMtu(this.device.deviceId);
+            return Math.min(mtu - 3, 244);
+        } catch (error) {
+            return 182;   // iOS default MTU of 185
+        }
+    }
+
+    // Android: high connection priority (the device asks for its interval too)
+    async requestFastLink(fast) {
+        if (!this.device || Capacitor.getPlatform() !== 'android') return;
+        try {
+            await BleClient.requestConnectionPriority(this.device.deviceId, fast ? 1 : 0);
+        } catch (error) {
+            console.warn('[BLE] Connection priority not changed:', error);
+        }
+    }
+
     // ═══════════════════════════════════════════════════════════════════════
     // CONTROL COMMANDS
     // ═══════════════════════════════════════════════════════════════════════
@@ -154,7 +630,8 @@ class BLEService {
     }
 
     async calibrateSensors() {
-        return this.sendCommand({ type: 'calibrate' });
+        const reply = await this.sendBinaryCommand(CMD.CALIBRATE);
+        return reply.status === 0;
     }
 
     async configureDevice(config) {
@@ -178,6 +655,8 @@ class BLEService {
             }
             this.device = null;
             this.isConnected = false;
+            this.streaming = false;
+            this.failPendingReplies();
         }
     }
 
@@ -188,6 +667,10 @@ class BLEService {
     onData(callback) {
         this.onDataCallback = callback;
     }
+
+    onImu(callback) {
+        this.onImuCallback = callback;
+    }
 }
 
 export default new BLEService();
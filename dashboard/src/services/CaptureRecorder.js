@@ -0,0 +1,212 @@
+import BLEService from './BLEService';
+
+// ═══════════════════════════════════════════════════════════════════════════
+// RAW IMU CAPTURE (mirrors src/ble/capture_stream.h)
+// Records every notification of a capture into a .uadcap file:
+//   [0..5]   "UADCAP"
+//   [6..7]   file version (u16 LE)
+//   [8..11]  metadata length M (u32 LE)
+//   [12..]   metadata, UTF-8 JSON (label, device, summary)
+//   records: rx_ms (u32 LE, since recording start), length (u16 LE),
+//            the notification bytes unchanged
+// backend/capture-replay.js reads it back (summary, CSV, JSON lines)
+// ═══════════════════════════════════════════════════════════════════════════
+
+export const CAPTURE_FRAME_START = 0x10;
+export const CAPTURE_FRAME_IMU = 0x11;
+export const CAPTURE_FRAME_AUDIO = 0x12;
+export const CAPTURE_FRAME_STOP = 0x13;
+
+const IMU_HEADER_LEN = 6;
+const SAMPLE_LEN = 12;
+const FILE_MAGIC = 'UADCAP';
+const FILE_VERSION = 1;
+const STOP_TIMEOUT_MS = 5000;
+
+export function isCaptureFrame(type) {
+    return type >= CAPTURE_FRAME_START && type <= CAPTURE_FRAME_STOP;
+}
+
+// value: DataView of one notification
+export function decodeCaptureFrame(value) {
+    const type = value.getUint8(0);
+
+    switch (type) {
+        case CAPTURE_FRAME_START:
+            return {
+                type: 'start',
+                version: value.getUint8(1),
+                odr: value.getUint16(2, true),
+                accelLsbPerG: value.getUint16(4, true),
+                gyroLsbPerDps: value.getUint16(6, true) / 10,
+                t0Us: value.getUint32(8, true),
+                audio: (value.getUint8(12) & 0x01) !== 0
+            };
+
+        case CAPTURE_FRAME_IMU: {
+            const count = value.getUint8(1);
+            if (value.byteLength !== IMU_HEADER_LEN + count * SAMPLE_LEN) {
+                throw new Error(`Capture frame length ${value.byteLength} does not match ${count} samples`);
+            }
+            // Raw counts: scale with the START frame's LSB values
+            const samples = new Int16Array(count * 6);
+            for (let i = 0; i < count * 6; i++) {
+                samples[i] = value.getInt16(IMU_HEADER_LEN + i * 2, true);
+            }
+            return { type: 'imu', first: value.getUint32(2, true), count, samples };
+        }
+
+        case CAPTURE_FRAME_AUDIO:
+            return {
+                type: 'audio',
+                musical: (value.getUint8(1) & 0x01) !== 0,
+                speech: (value.getUint8(1) & 0x02) !== 0,
+                index: value.getUint32(2, true),
+                dominantHz: value.getUint16(6, true),
+                centroidHz: value.getUint16(8, true),
+                harmonic: value.getUint16(10, true) / 1000,
+                energy: value.getUint16(12, true)
+            };
+
+        case CAPTURE_FRAME_STOP:
+            return {
+                type: 'stop',
+                reason: value.getUint8(1),
+                captured: value.getUint32(2, true),
+                lost: value.getUint32(6, true)
+            };
+
+        default:
+            throw new Error(`Unknown capture frame 0x${type.toString(16)}`);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// RECORDER
+// ═══════════════════════════════════════════════════════════════════════════
+
+class CaptureRecorder {
+    constructor() {
+        this.reset();
+    }
+
+    reset() {
+        this.recording = false;
+        this.records = [];
+        this.bytes = 0;
+        this.startedAt = 0;
+        this.info = null;
+        this.stop = null;
+        this.stats = { samples: 0, gaps: [], missing: 0, audio: 0, expected: 0 };
+        this.onStop = null;
+    }
+
+    // options: { label, odr, audio }, onProgress(stats) is called per IMU frame
+    async start(options = {}, onProgress = null) {
+        if (this.recording) return false;
+        this.reset();
+        this.label = options.label || 'unlabelled';
+        this.onProgress = onProgress;
+        this.startedAt = Date.now();
+        this.recording = true;
+
+        const ok = await BLEService.startCapture(
+            { odr: options.odr || 1000, audio: !!options.audio },
+            (value) => this.handleFrame(value)
+        );
+        if (!ok) this.recording = false;
+        return ok;
+    }
+
+    // Resolves once the device sent its STOP frame (all samples delivered)
+    async stopAndSave() {
+        if (!this.recording) return null;
+
+        const stopped = new Promise((resolve) => {
+            this.onStop = resolve;
+            setTimeout(resolve, STOP_TIMEOUT_MS);
+        });
+        await BLEService.stopCapture();
+        await stopped;
+
+        this.recording = false;
+        BLEService.endCapture();
+        return this.toBlob();
+    }
+
+    handleFrame(value) {
+        if (!this.recording) return;
+
+        const bytes = new Uint8Array(value.buffer, value.byteOffset, value.byteLength).slice();
+        this.records.push({ t: Date.now() - this.startedAt, bytes });
+        this.bytes += bytes.length + 6;
+
+        let frame;
+        try {
+            frame = decodeCaptureFrame(value);
+        } catch (e) {
+            console.error('[CAPTURE] Bad frame:', e);
+            return;
+        }
+
+        const stats = this.stats;
+        if (frame.type === 'start') {
+            this.info = frame;
+        } else if (frame.type === 'imu') {
+            // Gap: the first index is past the one we expected
+            if (frame.first > stats.expected) {
+                stats.gaps.push({ index: stats.expected, count: frame.first - stats.expected });
+                stats.missing += frame.first - stats.expected;
+            }
+            stats.expected = frame.first + frame.count;
+            stats.samples += frame.count;
+            if (this.onProgress) this.onProgress(stats);
+        } else if (frame.type === 'audio') {
+            stats.audio++;
+        } else if (frame.type === 'stop') {
+            this.stop = frame;
+            if (this.onStop) this.onStop();
+        }
+    }
+
+    toBlob() {
+        const meta = new TextEncoder().encode(JSON.stringify({
+            label: this.label,
+            device: BLEService.device ? BLEService.device.name : null,
+            started: new Date(this.startedAt).toISOString(),
+            odr: this.info ? this.info.odr : null,
+            samples: this.stats.samples,
+            missing: this.stats.missing,
+            gaps: this.stats.gaps.length,
+            complete: !!this.stop
+        }));
+
+        const out = new Uint8Array(12 + meta.length + this.bytes);
+        const view = new DataView(out.buffer);
+        out.set(new TextEncoder().encode(FILE_MAGIC), 0);
+        view.setUint16(6, FILE_VERSION, true);
+        view.setUint32(8, meta.length, true);
+        out.set(meta, 12);
+
+        let pos = 12 + meta.length;
+        for (const r of this.records) {
+            view.setUint32(pos, r.t, true);
+            view.setUint16(pos + 4, r.bytes.length, true);
+            out.set(r.bytes, pos + 6);
+            pos += 6 + r.bytes.length;
+        }
+        return new Blob([out], { type: 'application/octet-stream' });
+    }
+
+    download(blob, filename) {
+        const name = filename || `${this.label}-${new Date(this.startedAt).toISOString().replace(/[:.]/g, '-')}.uadcap`;
+        const url = URL.createObjectURL(blob);
+        const a = document.createElement('a');
+        a.href = url;
+        a.download = name;
+        a.click();
+        setTimeout(() => URL.revokeObjectURL(url), 1000);
+    }
+}
+
+export default new CaptureRecorder();
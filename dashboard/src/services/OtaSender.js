@@ -0,0 +1,233 @@
+import BLEService, { CMD } from './BLEService';
+
+// ═══════════════════════════════════════════════════════════════════════════
+// FIRMWARE UPDATE OVER BLE (mirrors src/ble/ota_transfer.h)
+// The device ACKs the bytes it holds in order; we keep at most OTA_WINDOW
+// bytes past the last ACK in flight, rewind on a NACK or when ACKs stop.
+// After a disconnect, send() with the same image resumes where the device
+// is: its first ACK after OTA_BEGIN is the resume offset.
+// What travels may be a delta patch and/or compressed (src/ota_decoder.h):
+// offsets and ACKs count transfer bytes, the SHA-256 is the image's
+// ═══════════════════════════════════════════════════════════════════════════
+
+const OTA_MSG_ACK = 0x01;
+const OTA_MSG_NACK = 0x02;
+const OTA_MSG_RESULT = 0x03;
+const OTA_DATA_HEADER_LEN = 4;
+const OTA_WINDOW = 8192;            // include/config.h OTA_WINDOW
+const OTA_BEGIN_SIG_MAX = 72;       // DER ECDSA P-256 (src/ble/ota_transfer.h)
+
+const BEGIN_TIMEOUT_MS = 5000;      // Update.begin erases nothing, the first ACK is quick
+const STALL_MS = 1000;              // No ACK progress: resend from the last ACK
+const VERIFY_TIMEOUT_MS = 15000;    // Last blocks + SHA-256 + Update.end
+
+export const OTA_ENCODINGS = { raw: 0, delta: 1, heatshrink: 2, 'delta+heatshrink': 3 };
+export const OTA_RESULTS = ['OK', 'HASH_MISMATCH', 'FLASH_ERROR', 'ABORTED', 'TIMEOUT', 'BAD_SIGNATURE', 'BAD_PATCH'];
+
+class OtaSender {
+    constructor() {
+        this.running = false;
+        this.reset();
+    }
+
+    reset() {
+        this.next = 0;
+        this.acked = 0;
+        this.started = false;       // First ACK seen
+        this.result = null;
+        this.lastProgress = 0;
+        this.wake = null;
+        this.stats = { sent: 0, nacks: 0, stalls: 0, resumedAt: 0 };
+    }
+
+    // Asks the backend for the module image: a delta against the running
+    // image when it has that one, else compressed. Resolves with send()'s arguments
+    async fetchUpdate(backendUrl, deviceType) {
+        const base = await BLEService.getOtaBase();
+        const headers = { 'X-Image-Accept': 'delta, heatshrink' };
+        if (base) headers['X-Delta-Base'] = base.sha;
+        const response = await fetch(`${backendUrl}/api/modules/download?device_type=${encodeURIComponent(deviceType)}`,
+                                     { headers });
+        if (!response.ok) throw new Error(`Download failed: HTTP ${response.status}`);
+        const payload = new Uint8Array(await response.arrayBuffer());
+        const encodingName = response.headers.get('X-Image-Encoding') || 'raw';
+        const encoding = OTA_ENCODINGS[encodingName];
+        if (encoding === undefined) throw new Error(`Unknown image encoding '${encodingName}'`);
+        const shaHex = response.headers.get('X-Image-SHA256');
+        const sha = shaHex ? Uint8Array.from(shaHex.match(/../g), (h) => parseInt(h, 16)) : null;
+        const size = Number(response.headers.get('X-Image-Size')) || payload.length;
+        const sigHex = response.headers.get('X-Image-Signature');
+        const signature = sigHex ? Uint8Array.from(sigHex.match(/../g), (h) => parseInt(h, 16)) : null;
+        return { payload, image: { encoding, size, sha, signature } };
+    }
+
+    // payload: ArrayBuffer or Uint8Array, the image unless image.encoding says
+    // otherwise ({ encoding, size, sha, signature }: see fetchUpdate). Resolves with
+    // { ok, result, bytes, seconds, kbps }; onProgress({ acked, size, kbps }) is called per ACK
+    async send(payload, onProgress = null, image = null) {
+        if (this.running) throw new Error('OTA already running');
+        const bytes = payload instanceof Uint8Array ? payload : new Uint8Array(payload);
+        const size = bytes.length;
+        const encoding = image ? image.encoding : OTA_ENCODINGS.raw;
+        if (encoding !== OTA_ENCODINGS.raw && !(image.sha && image.size)) {
+            throw new Error('Encoded transfers need the image size and SHA-256');
+        }
+
+        this.running = true;
+        this.reset();
+        const startedAt = Date.now();
+
+        try {
+            const sha = image && image.sha ? image.sha : new Uint8Array(await crypto.subtle.digest('SHA-256', bytes));
+            if (!(await BLEService.startOtaNotifications((value) => this.handleMessage(value)))) {
+                throw new Error('Device has no BLE OTA');
+            }
+            await BLEService.requestFastLink(true);
+            const chunk = (await BLEService.getWritePayload()) - OTA_DATA_HEADER_LEN;
+
+            // [size][sha] ([encoding][image size] ([signature length][signature]))
+            const signature = image && image.signature ? image.signature : null;
+            if (signature && signature.length > OTA_BEGIN_SIG_MAX) throw new Error('Image signature too long');
+            const begin = new Uint8Array(signature ? 42 + signature.length : encoding === OTA_ENCODINGS.raw ? 36 : 41);
+            new DataView(begin.buffer).setUint32(0, size, true);
+            begin.set(sha, 4);
+            if (begin.length > 36) {
+                begin[36] = encoding;
+                new DataView(begin.buffer).setUint32(37, image.size || size, true);
+            }
+            if (signature) {
+                begin[41] = signature.length;
+                begin.set(signature, 42);
+            }
+            const reply = await BLEService.sendBinaryCommand(CMD.OTA_BEGIN, begin);
+            if (reply.status !== 0) throw new Error(`OTA_BEGIN refused: ${reply.statusName}`);
+
+            await this.waitUntil(() => this.started || this.result !== null, BEGIN_TIMEOUT_MS);
+            this.checkFailed();
+            if (!this.started) throw new Error('Device did not start the transfer');
+            if (this.acked > 0) {
+                this.stats.resumedAt = this.acked;
+                console.log(`[OTA] ▶️ Resuming at ${this.acked} / ${size} bytes`);
+            }
+
+            // ── Window pump
+            let lastReported = -1;
+            while (this.acked < size) {
+                if (!BLEService.isConnected) throw new Error('Disconnected: send the same image again to resume');
+                this.checkFailed();
+
+                const canSend = () => this.next < size && this.next < this.acked + OTA_WINDOW;
+                if (canSend()) {
+                    const offset = this.next;
+                    const n = Math.min(chunk, size - offset, this.acked + OTA_WINDOW - offset);
+                    const packet = new Uint8Array(OTA_DATA_HEADER_LEN + n);
+                    new DataView(packet.buffer).setUint32(0, offset, true);
+                    packet.set(bytes.subarray(offset, offset + n), OTA_DATA_HEADER_LEN);
+                    this.next = offset + n;
+                    this.stats.sent += n;
+                    await BLEService.writeOta(packet);
+                } else {
+                    await this.waitUntil(() => canSend() || this.acked >= size || this.result !== null, 50);
+                    if (Date.now() - this.lastProgress > STALL_MS) {
+                        this.stats.stalls++;
+                        this.next = this.acked;
+                        this.lastProgress = Date.now();
+                    }
+                }
+
+                if (onProgress && this.acked !== lastReported) {
+                    lastReported = this.acked;
+                    onProgress({ acked: this.acked, size, kbps: this.kbps(this.acked - this.stats.resumedAt, startedAt) });
+                }
+            }
+
+            // ── Verify on the device
+            const end = await BLEService.sendBinaryCommand(CMD.OTA_END);
+            if (end.status !== 0) throw new Error(`OTA_END refused: ${end.statusName}`);
+            await this.waitUntil(() => this.result !== null, VERIFY_TIMEOUT_MS);
+            if (this.result === null) throw new Error('No verification result from the device');
+
+            const seconds = (Date.now() - startedAt) / 1000;
+            const summary = {
+                ok: this.result.code === 0,
+                result: this.result.name,
+                bytes: size,
+                imageBytes: image ? image.size : size,
+                seconds,
+                kbps: this.kbps(size - this.stats.resumedAt, startedAt),
+                resent: this.stats.sent - (size - this.stats.resumedAt),
+                nacks: this.stats.nacks,
+                stalls: this.stats.stalls
+            };
+            console.log('[OTA] Transfer finished:', summary);
+            return summary;
+        } finally {
+            this.running = false;
+            await BLEService.requestFastLink(false);
+        }
+    }
+
+    // Reboot into the verified image (the link drops)
+    async activate() {
+        const reply = await BLEService.sendBinaryCommand(CMD.OTA_ACTIVATE);
+        return reply.status === 0;
+    }
+
+    async abort() {
+        this.result = { code: 3, name: OTA_RESULTS[3] };
+        const reply = await BLEService.sendBinaryCommand(CMD.OTA_ABORT);
+        return reply.status === 0;
+    }
+
+    handleMessage(value) {
+        const type = value.getUint8(0);
+        if (type === OTA_MSG_RESULT) {
+            const code = value.getUint8(1);
+            this.result = { code, name: OTA_RESULTS[code] || `0x${code.toString(16)}`, flashed: value.getUint32(2, true) };
+        } else {
+            const offset = value.getUint32(1, true);
+            if (type === OTA_MSG_ACK) {
+                if (!this.started) {
+                    this.started = true;
+                    this.acked = this.next = offset;
+                } else if (offset > this.acked) {
+                    this.acked = offset;
+                }
+                if (this.next < this.acked) this.next = this.acked;
+                this.lastProgress = Date.now();
+            } else if (type === OTA_MSG_NACK && this.started && offset < this.next) {
+                this.stats.nacks++;
+                this.next = offset;
+            }
+        }
+        if (this.wake) this.wake();
+    }
+
+    checkFailed() {
+        if (this.result && this.result.code !== 0) throw new Error(`OTA failed: ${this.result.name}`);
+    }
+
+    // Resolves when cond() holds after a device message, or after ms
+    waitUntil(cond, ms) {
+        if (cond()) return Promise.resolve();
+        return new Promise((resolve) => {
+            const timer = setTimeout(done, ms);
+            const self = this;
+            function done() {
+                clearTimeout(timer);
+                self.wake = null;
+                resolve();
+            }
+            this.wake = () => {
+                if (cond()) done();
+            };
+        });
+    }
+
+    kbps(bytes, since) {
+        const secs = (Date.now() - since) / 1000;
+        return secs > 0 ? bytes / 1024 / secs : 0;
+    }
+}
+
+export default new OtaSender();
@@ -1,7 +1,9 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 // ═══════════════════════════════════════════════════════════════════════════
 // HARDWARE DEFINITIONS (Heltec WiFi LoRa 32 V3)
@@ -52,6 +54,8 @@
 
 // Context Detection
 #define IMPACT_THRESHOLD      4.0f   // G-force
+#define FREEFALL_THRESHOLD    0.4f   // G-force below which the helmet is falling
+#define FALL_WINDOW_MS        1000   // Free-fall → impact within this counts as a fall
 #define STATIONARY_VARIANCE   0.05f  // Accel variance
 #define WALKING_FREQ_MIN      1.0f   // Hz
 #define WALKING_FREQ_MAX      3.0f   // Hz
@@ -59,11 +63,189 @@
 
 // Power Management
 #define SLEEP_TIMEOUT_MS      300000 // 5 minutes inactivity
-#define BATTERY_CHECK_INT_MS  30000
+#define BATTERY_CHECK_INT_MS  30000  // ADC reading period, cached in between
+#define IDLE_TIMEOUT          60000  // ms without activity before POWER_IDLE
+#define MOTION_THRESHOLD      0.1f   // Average |total g - 1| that counts as moving
+
+// Light Sleep & CPU Clock (esp_pm locks, src/managers/power_profile.h)
+#define POWER_LIGHT_SLEEP_ENABLED 1    // Needs CONFIG_PM_ENABLE + CONFIG_FREERTOS_USE_TICKLESS_IDLE, else clock scaling only
+#define POWER_FULL_MHZ          160    // CPU clock while loop() runs, per PowerMode
+#define POWER_IDLE_MHZ          80
+#define POWER_SLEEP_MHZ         80
+#define POWER_ALERT_MHZ         240    // And no light sleep while an alert is handled
+#define POWER_MIN_MHZ           40     // Clock with no lock held (XTAL)
+#define POWER_BOARD_MA          6.0f   // Regulator, SX1262 listening, OLED off
+#define POWER_CPU_BASE_MA       18.0f  // ESP32-S3 active, radio off: base + per MHz
+#define POWER_CPU_MA_PER_MHZ    0.14f
+#define POWER_LIGHT_SLEEP_MA    0.24f
+
+// Energy Ledger & Battery (src/managers/energy_ledger.h)
+#define BATTERY_CAPACITY_MAH    1000   // LiPo cell on the JST connector
+#define BATT_VOLTAGE_DIVIDER    4.9f   // Heltec V3: 390k / 100k on BAT_ADC_PIN
+#define BATT_ADC_SAMPLES        15     // Per reading, median kept (odd; calibrated with esp_adc_cal)
+#define BATT_SETTLE_US          200    // Divider settling after BAT_READ_CTRL goes LOW
+#define BATT_VOLTAGE_ALPHA      0.3f   // EMA over readings
+#define ENERGY_SOC_BLEND        0.05f  // Pull of each voltage reading on the coulomb count
+#define ENERGY_CURRENT_ALPHA    0.2f   // EMA of the average current (runtime estimate)
+#define ENERGY_IMU_MA           3.8f   // MPU6050 accel + gyro on (any rate)
+#define ENERGY_DISPLAY_MA       12.0f  // SSD1306 on, typical content
+// Expected average draw: board, IMU, CPU idling at the lowest clock (~33 mA, ~30 h)
+#define ENERGY_BASELINE_MA      (POWER_BOARD_MA + ENERGY_IMU_MA + POWER_CPU_BASE_MA + POWER_CPU_MA_PER_MHZ * POWER_MIN_MHZ)
+#define ENERGY_LOW_RUNTIME_FRAC      0.25f  // Runtime below this x full battery at the baseline: intervals x2
+#define ENERGY_CRITICAL_RUNTIME_FRAC 0.10f  // Below this: telemetry intervals x4
+
+// BLE Telemetry Stream (binary characteristic, see src/ble/ble_stream.h)
+#define BLE_MTU                 247    // Requested ATT MTU (244-byte notifications, one LL packet with DLE)
+#define BLE_IMU_RATE_HZ         100    // IMU samples streamed while the phone is subscribed
+#define BLE_STREAM_QUEUE        128    // Samples buffered under backpressure (~1.3 s at 100 Hz)
+#define BLE_STREAM_LATENCY_MS   100    // Oldest queued sample waits at most this long
+#define BLE_CONN_STREAM_MIN     12     // Streaming connection interval, 1.25 ms units (15 ms)
+#define BLE_CONN_STREAM_MAX     24     // (30 ms)
+#define BLE_CONN_IDLE_MIN       80     // Idle connection interval (100 ms)
+#define BLE_CONN_IDLE_MAX       160    // (200 ms)
+#define BLE_CONN_IDLE_LATENCY   4      // Connection events the device may skip when idle
+#define BLE_CONN_TIMEOUT        500    // Supervision timeout, 10 ms units (5 s)
+#define BLE_SECURE              1      // 1: commands and OTA need a bonded, MITM-protected (passkey) link
+#define BLE_PASSKEY             123456 // Static 6-digit pairing passkey typed on the phone (set per fleet)
+
+// Raw IMU Capture (training data over the stream characteristic, src/ble/capture_stream.h)
+#define CAPTURE_ODR_HZ          1000   // MPU6050 sample rate while capturing (1 kHz / n)
+#define CAPTURE_QUEUE           2048   // Samples between FIFO task and BLE (~2 s at 1 kHz)
+#define CAPTURE_POLL_MS         10     // FIFO drain period (the 1 KB FIFO holds 85 ms at 1 kHz)
+#define CAPTURE_FIFO_BURST      64     // Samples read per poll at most
+#define CAPTURE_LATENCY_MS      50     // A partial frame goes out after this long (low ODRs)
+#define CAPTURE_TASK_CORE       1      // Same core as loop(), the BLE controller runs on core 0
+
+// BLE OTA (src/ble/ota_transfer.h, src/managers/ble_ota_manager.h)
+#define OTA_BLOCK_SIZE          4096   // Flash sector: one Update.write per block
+#define OTA_RING_SIZE           16384  // Receive ring (power of two, whole blocks)
+#define OTA_WINDOW              8192   // Bytes the phone may send past the last ACK
+#define OTA_ACK_STEP            2048   // ACK at least this often while the ring has room
+#define OTA_RESUME_TIMEOUT_MS   600000 // Session kept this long after a disconnect
+#define OTA_CONN_MIN            6      // Connection interval during a transfer (7.5 ms)
+#define OTA_CONN_MAX            12     // (15 ms)
+#define OTA_TASK_CORE           1      // Flash writer task (the BLE controller runs on core 0)
+
+// WiFi OTA (src/ota_handler.h)
+#define OTA_HTTP_BUFFERS        2      // OTA_BLOCK_SIZE buffers between download and flash tasks
+#define OTA_HTTP_TIMEOUT_MS     10000  // No data for this long aborts the download
+#define OTA_SIGNATURE_MAX       256    // DER signature bytes (ECDSA P-256 needs 72)
+#ifndef OTA_REQUIRE_SIGNATURE          // Host tests pass their own
+#define OTA_REQUIRE_SIGNATURE   0      // 1: refuse unsigned images even without a key (implied by a key)
+#endif
+#ifndef OTA_SIGNING_PUBKEY
+#define OTA_SIGNING_PUBKEY      ""     // PEM of the backend's OTA_SIGNING_KEY, "" = unsigned images accepted
+#endif
+
+// OTA encodings (src/ota_decoder.h: delta patches, heatshrink)
+#define OTA_HS_WINDOW_BITS      10     // 1 KB decoder window (must match backend/heatshrink.js)
+#define OTA_HS_LOOKAHEAD_BITS   5      // Copies up to 32 bytes
+#define OTA_DECODE_CHUNK        256    // Decompressed patch between the two decoder stages
+#define OTA_ENCODED_INPUT       1024   // Socket reads of an encoded download
+#define OTA_DECODER_RAM_MAX     2048   // Bytes per OtaDecoder (window + stage buffer + state)
+
+// Module VM (src/vm: bytecode modules swapped in without a reflash)
+#define VM_PROGRAM_MAX          4096   // Bytes per program (header, tables, code, CRC)
+#define VM_REGISTERS            16     // Per call: locals + temporaries
+#define VM_STATE_MAX            64     // Cells kept between calls (state + params)
+#define VM_PARAMS_MAX           16
+#define VM_STEP_LIMIT           2000   // Instructions per call before the module is stopped
+#define VM_PARTITION_LABEL      "uadmod"  // Data partition with the loaded program (partitions.csv)
+#define VM_PARTITION_SUBTYPE    0x40
+
+// Module Registry (src/modules/module_registry.h: all modules in one image)
+#ifndef MODULE_REGISTRY_ENABLED        // Backend mode builds pass 0 (compileAndFlash)
+#define MODULE_REGISTRY_ENABLED 1      // 0 = the single CurrentModule of current_module.h
+#endif
+#define MODULE_REGISTRY_ARENA   0      // 1 = modules share one buffer, state reset on a switch
+
+// Module Batches (updateBatch over MPU6050 FIFO bursts, src/modules/batch_kernels.h)
+#define MODULE_BATCH_ENABLED    1      // 0 = one update() per loop with the newest sample
+#define MODULE_BATCH_ODR_HZ     100    // FIFO rate feeding the module (1 kHz / n; 1 KB FIFO = 850 ms)
+#define MODULE_BATCH_MAX        32     // Samples per updateBatch() call
+
+// Adaptive Sampling (module getSampleInterval -> FIFO rate and loop sleep, src/managers/sampling_policy.h)
+#define SAMPLING_ADAPTIVE_ENABLED 1    // 0 = FIFO fixed at MODULE_BATCH_ODR_HZ, loop every SAMPLING_POLL_MS
+#define SAMPLING_MIN_ODR_HZ     4      // Slowest FIFO rate (1 kHz / 250)
+#define SAMPLING_POLL_MS        10     // Loop period at full rate or while radio / BLE / capture are busy
+#define SAMPLING_MAX_SLEEP_MS   1000   // Longest loop sleep (telemetry samples, LoRa RX)
+#define SAMPLING_FIFO_FILL      70     // % of the FIFO a batch may fill before the loop wakes
+#define SAMPLING_BOOST_MS       3000   // Full rate after a trigger (shock, alert)
+#define SAMPLING_TRIGGER_G      0.5    // |total g - 1| that counts as a shock
+#define HELMET_SAMPLE_MS        20     // Helmet upright: 50 Hz finds a free-fall, full rate while falling
+#define VEHICLE_IDLE_SAMPLE_MS  100    // Vehicle idle or parked; full rate while driving (crash peaks)
+#define BICYCLE_SAMPLE_MS       50     // Bicycle moving (lean, speed)
+#define BICYCLE_STOPPED_SAMPLE_MS 500  // Bicycle standing
+#define ASSET_SAMPLE_MS         1000   // Asset at rest (a shock boosts the rate anyway)
+#define ASSET_ALARM_SAMPLE_MS   100    // Asset moving / alarm on
+#define BUNDLE_SAMPLE_MS        100    // Default bundle (level display at 10 Hz)
 
 // LoRa Mesh
 #define LORA_FREQ            868.0  // MHz (Israel/EU Standard)
 #define LORA_BW              125.0  // kHz
 #define LORA_SF              7      // Spreading Factor
+#define LORA_CR              5      // Coding rate 4/5
+#define LORA_SYNC_WORD       0x12   // Private network
+#define LORA_TX_POWER        14     // dBm (EU868 ERP limit)
+#define LORA_PREAMBLE_LEN    8      // Symbols
+#define LORA_MAX_PAYLOAD     222    // Bytes (EU868 SF7 limit)
+#define LORA_TX_QUEUE_LEN    4      // Frames buffered by the async driver
+
+// LoRa Listen-Before-Talk (CAD) & Channel Hopping
+#define LORA_LBT_ENABLED        1      // Channel activity detection before every TX
+#define LORA_LBT_BACKOFF_MS     100    // First busy backoff window (~ one frame)
+#define LORA_LBT_MAX_TRIES      6      // Busy CADs in a row before sending anyway
+#define LORA_HOPPING            0      // Random TX channel per frame (multi-channel gateway only)
+#define LORA_CHANNELS           {868.1f, 868.3f, 868.5f}  // EU868 g1, one duty-cycle sub-band
+#define LORA_CHANNEL_COUNT      3
+
+// LoRa TDMA (optional, single-hop sites with a beaconing gateway)
+#define TDMA_ENABLED            0      // Slotted uplink once a gateway beacon is heard
+#define TDMA_BEACON_PERIOD_MS   15000  // Superframe length (beacon to beacon)
+#define TDMA_FIRST_SLOT_MS      250    // Beacon window before slot 0
+#define TDMA_SLOT_MS            140    // 51-byte frame at SF7 + guards + loop latency
+#define TDMA_SLOT_COUNT         96     // Slots end at 13.7 s, the rest is contention
+#define TDMA_GUARD_MS           10     // Timing guard at each end of a slot
+#define TDMA_MAX_DRIFT_PPM      50     // Residual clock error assumed after correction
+#define TDMA_MAX_MISSED_BEACONS 6      // Silent superframes before sync is dropped
+#define TDMA_MAX_OVERRIDES      8      // Slot reassignments carried per beacon
+
+// LoRa Scheduler (EU868 duty cycle)
+#define LORA_SCHED_QUEUE_LEN    8      // Frames waiting for their TX slot
+#define LORA_DC_ALERT_RESERVE   0.2f   // Share of the duty-cycle budget kept for alerts
+#define LORA_TX_JITTER_MS       2000   // Random delay spread for routine frames
+#define LORA_ROUTINE_MAX_AGE_MS 60000  // Routine frames older than this are dropped
+#define TELEMETRY_SAMPLE_MS     1000   // One sample per slot in the batch frame
+#define TELEMETRY_INTERVAL_MS   30000  // Batch frame flush period (or when full)
+
+// LoRa Adaptive Data Rate (TX power only, SF stays at LORA_SF)
+#define LORA_ADR_MIN_POWER      2      // dBm
+#define LORA_ADR_MARGIN_DB      10.0f  // Installation margin kept above demod floor
+#define LORA_ADR_LOSS_LIMIT     3      // Consecutive losses before stepping back up
+
+// LoRa Mesh Relay (managed flooding)
+#define MESH_DEFAULT_TTL        5      // Hops a frame may travel (origin included)
+#define MESH_DUP_CACHE_SETS     16     // x4 ways = 64 recent (origin, seq) pairs
+#define MESH_RELAY_QUEUE_LEN    4      // Rebroadcasts waiting for their backoff
+#define MESH_RELAY_BACKOFF_MS   2000   // Random backoff window (halved for alerts)
+#define MESH_SUPPRESS_COUNT     2      // Overheard relays that cancel ours
+#define MESH_RELAY_MIN_BATT     30     // % below which a node stops relaying
+
+// Confirmed Alerts (ACK + retry)
+#define ALERT_ACK_WINDOW_MS     4000   // Wait for the ACK after TX end (covers mesh hops)
+#define ALERT_RETRY_BASE_MS     2000   // First retry backoff, doubled per attempt
+#define ALERT_RETRY_MAX_MS      30000  // Backoff cap
+#define ALERT_MAX_ATTEMPTS      6      // Transmissions before giving up
+#define ALERT_CONFIRM_SLOTS     4      // Alerts awaiting an ACK at once
+
+// Gateway Mode (env:uad_gateway)
+#define GATEWAY_BAUD            921600
+#define GATEWAY_MAX_DEVICES     512    // Per-device table (power of two)
+#define GATEWAY_RX_RING_LEN     32     // Frames buffered between radio and forwarder
+#define GATEWAY_FLUSH_MS        50     // Max time a forwarded line waits in the batch
+#define GATEWAY_DUP_WINDOW_MS   2000   // Legacy packets (no seq): same payload = duplicate
+#define GATEWAY_UDP_PORT        1700   // Used when GATEWAY_UDP_HOST is defined
+#define GATEWAY_NODE_ID         0xFFFE // Mesh origin of gateway downlinks (ACKs)
+#define GATEWAY_REACK_MS        1000   // Same alert again after this = our ACK was lost
 
 #endif // CONFIG_H
@@ -70,13 +70,26 @@ struct __attribute__((packed)) UAD_Packet {
     uint8_t battery_pct;      // 0-100%
 };
 
+// ═══════════════════════════════════════════════════════════════════════════
+// LORA FRAME TYPES (first byte of every frame except the legacy UAD_Packet,
+// which is recognised by its 6-byte length)
+// ═══════════════════════════════════════════════════════════════════════════
+
+enum FrameType {
+    FRAME_TELEMETRY   = 0xA1,   // Batched samples + events (telemetry_frame.h)
+    FRAME_SCHEMA      = 0xA2,   // Bit-packed module records (schema_frame.h)
+    FRAME_MESH        = 0xB0,   // Relay header around another frame (mesh_relay.h)
+    FRAME_ACK         = 0xC0,   // Gateway confirms an alert (confirmed_uplink.h)
+    FRAME_BEACON      = 0xD0    // Gateway time base + TDMA slot plan (tdma_sync.h)
+};
+
 // ═══════════════════════════════════════════════════════════════════════════
 // SENSOR DATA (raw readings)
 // ═══════════════════════════════════════════════════════════════════════════
 
 struct SensorData {
-    float accel_x, accel_y, accel_z;   // Accelerometer (g)
-    float gyro_x, gyro_y, gyro_z;      // Gyroscope (deg/s)
+    float accel_x, accel_y, accel_z;   // Accelerometer (m/s^2)
+    float gyro_x, gyro_y, gyro_z;      // Gyroscope (rad/s)
     float temperature;                  // Celsius
     unsigned long timestamp;            // millis()
 };
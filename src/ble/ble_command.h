@@ -0,0 +1,272 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE COMMANDS - Binary Control Protocol
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Phone → device commands on the RX characteristic, replies notified on
+ * the same characteristic. BLEManager runs the dispatcher straight on the
+ * stack's write buffer:
+ * - No copies: a command is (opcode, length, pointer into the write)
+ * - One write may carry several commands back to back
+ * - Static dispatch: the table lives in flash, opcode → entry is one
+ *   array lookup, lengths are checked before the handler runs
+ * - Handlers run in the BLE task and must not block: they validate,
+ *   hand the work to loop() and reply. One whose answer needs loop()
+ *   returns BLE_CMD_DEFERRED: nothing is sent now, loop() sends the
+ *   reply later (buildReply)
+ * 
+ * LAYOUT:
+ *   command  [0] opcode (0x00..0x7E)  [1] payload length  [2..] payload
+ *   reply    [0] opcode | 0x80  [1] length (1 + data)  [2] status  [3..] data
+ *   A truncated command stops parsing: reply opcode 0xFF, status
+ *   MALFORMED, data = offset of the bad command. Reply data that does
+ *   not fit the notification is cut off
+ *   Multi-byte values are little endian
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BLE_COMMAND_H
+#define BLE_COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BLE_CMD_PROTOCOL_VERSION 1
+#define BLE_CMD_HEADER_LEN       2
+#define BLE_CMD_REPLY_HEADER_LEN 3
+#define BLE_CMD_REPLY_FLAG       0x80
+#define BLE_CMD_ERROR_OPCODE     0xFF
+#define BLE_CMD_OPCODE_LIMIT     0x7F   // Opcodes below this; 0x7F | 0x80 is the error reply
+
+// ═══════════════════════════════════════════════════════════════════════════
+// OPCODES
+// ═══════════════════════════════════════════════════════════════════════════
+
+enum BleOpcode : uint8_t {
+    // Link
+    BLE_CMD_PING = 0x01,            // payload echoed back (latency probe)
+    BLE_CMD_GET_INFO = 0x02,        // → version, device id, context, flags
+    
+    // Active module
+    BLE_CMD_PARAM_SET = 0x10,       // [0] param id  [1..4] i32 value; replied by loop()
+    BLE_CMD_PARAM_GET = 0x11,       // [0] param id  → i32 value; replied by loop()
+    BLE_CMD_CALIBRATE = 0x12,       // IMU offsets (device must be still)
+    
+    // Raw IMU capture (src/ble/capture_stream.h)
+    BLE_CMD_CAPTURE_START = 0x20,   // [0..1] odr Hz (0 = default)  [2] bit0 audio
+    BLE_CMD_CAPTURE_STOP = 0x21,
+    
+    // OTA control (0x30..0x3F, src/ble/ota_transfer.h)
+    BLE_CMD_OTA_BEGIN = 0x30,       // [0..3] transfer size  [4..35] image SHA-256
+                                    // ([36] encoding  [37..40] image size
+                                    //  ([41] signature length  [42..] DER signature))
+                                    // → ACK on OTA char.
+    BLE_CMD_OTA_STATUS = 0x31,      // → state, transfer size, received, flashed (u32s)
+    BLE_CMD_OTA_END = 0x32,         // Verify once all is flashed → RESULT on OTA char.
+    BLE_CMD_OTA_ACTIVATE = 0x33,    // Reboot into the verified image
+    BLE_CMD_OTA_ABORT = 0x34,
+    BLE_CMD_OTA_BASE = 0x35,        // → running image size (u32), SHA-256 (delta base)
+    
+    // Modules (0x40..0x4F, src/managers/vm_module_manager.h, src/modules/module_registry.h)
+    BLE_CMD_MODULE_WRITE = 0x40,    // [0..1] offset  [2..] program bytes
+    BLE_CMD_MODULE_COMMIT = 0x41,   // [0..1] program size → VmError; swapped in by loop()
+    BLE_CMD_MODULE_UNLOAD = 0x42,   // Back to the compiled-in module
+    BLE_CMD_MODULE_INFO = 0x43,     // → flags, context, fault, size, CRC-32, swap µs, name
+    BLE_CMD_MODULE_SELECT = 0x44    // [0] context → compiled-in module, switched by loop()
+};
+
+enum BleCmdStatus : uint8_t {
+    BLE_CMD_OK = 0,
+    BLE_CMD_UNKNOWN = 1,            // No handler for the opcode
+    BLE_CMD_BAD_LENGTH = 2,         // Payload length outside the table's range
+    BLE_CMD_BAD_VALUE = 3,          // Handler rejected a value
+    BLE_CMD_BUSY = 4,               // Not now (e.g. capture running)
+    BLE_CMD_UNSUPPORTED = 5,        // Valid, but not on this firmware / module
+    BLE_CMD_MALFORMED = 6,          // Truncated header or payload
+    BLE_CMD_DEFERRED = 0xFF         // Handler only: reply comes from loop(), never on the wire
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// COMMAND VIEW (points into the write buffer)
+// ═══════════════════════════════════════════════════════════════════════════
+
+struct BleCommand {
+    uint8_t opcode;
+    uint8_t length;
+    const uint8_t* payload;
+    
+    // Lengths are checked against the table first, so handlers read freely
+    uint8_t u8(uint8_t i) const { return payload[i]; }
+    uint16_t u16(uint8_t i) const { return payload[i] | (payload[i + 1] << 8); }
+    uint32_t u32(uint8_t i) const {
+        return payload[i] | (payload[i + 1] << 8) | (payload[i + 2] << 16) |
+               ((uint32_t)payload[i + 3] << 24);
+    }
+    int32_t i32(uint8_t i) const { return (int32_t)u32(i); }
+};
+
+// Reply data, written in place into the notification buffer
+class BleReply {
+private:
+    uint8_t* buf;
+    uint8_t max;
+    uint8_t len = 0;
+    bool overflow = false;
+
+public:
+    BleReply(uint8_t* out, uint8_t max_len) : buf(out), max(max_len) {}
+    
+    void put8(uint8_t v) {
+        if (len >= max) {
+            overflow = true;
+            return;
+        }
+        buf[len++] = v;
+    }
+    
+    void put16(uint16_t v) {
+        put8(v & 0xFF);
+        put8(v >> 8);
+    }
+    
+    void put32(uint32_t v) {
+        put16(v & 0xFFFF);
+        put16(v >> 16);
+    }
+    
+    void putBytes(const uint8_t* data, size_t n) {
+        if (n > (size_t)(max - len)) {
+            n = max - len;
+            overflow = true;
+        }
+        memcpy(&buf[len], data, n);
+        len += n;
+    }
+    
+    uint8_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+};
+
+typedef BleCmdStatus (*BleCommandHandler)(const BleCommand& cmd, BleReply& reply);
+
+struct BleCommandSpec {
+    uint8_t opcode;
+    uint8_t min_len;
+    uint8_t max_len;
+    BleCommandHandler handler;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DISPATCHER
+// ═══════════════════════════════════════════════════════════════════════════
+
+class BleCommandDispatcher {
+private:
+    const BleCommandSpec* table;
+    uint8_t slot[BLE_CMD_OPCODE_LIMIT];    // opcode → table index + 1 (0 = none)
+    
+    // Statistics
+    uint32_t commands = 0;
+    uint32_t failed = 0;
+    uint32_t malformed = 0;
+    uint32_t repliesDropped = 0;
+
+public:
+    BleCommandDispatcher(const BleCommandSpec* commandTable, size_t count) : table(commandTable) {
+        memset(slot, 0, sizeof(slot));
+        for (size_t i = 0; i < count && i < 255; i++) {
+            if (table[i].opcode < BLE_CMD_OPCODE_LIMIT && table[i].handler) slot[table[i].opcode] = i + 1;
+        }
+    }
+    
+    // Runs every command in one write. Replies are appended to out, one per
+    // command (dropped and counted if out is full). Returns the reply length
+    size_t dispatch(const uint8_t* data, size_t len, uint8_t* out, size_t out_max) {
+        size_t pos = 0;
+        size_t outLen = 0;
+        
+        while (pos < len) {
+            if (len - pos < BLE_CMD_HEADER_LEN || len - pos - BLE_CMD_HEADER_LEN < data[pos + 1]) {
+                malformed++;
+                uint8_t offset = (pos > 255) ? 255 : (uint8_t)pos;
+                outLen = appendReply(out, out_max, outLen, BLE_CMD_ERROR_OPCODE,
+                                     BLE_CMD_MALFORMED, &offset, 1);
+                break;
+            }
+            
+            BleCommand cmd;
+            cmd.opcode = data[pos];
+            cmd.length = data[pos + 1];
+            cmd.payload = &data[pos + BLE_CMD_HEADER_LEN];
+            pos += BLE_CMD_HEADER_LEN + cmd.length;
+            commands++;
+            
+            // Reply data goes straight behind its header in out
+            size_t room = (outLen + BLE_CMD_REPLY_HEADER_LEN <= out_max) ?
+                          out_max - outLen - BLE_CMD_REPLY_HEADER_LEN : 0;
+            if (room > 254) room = 254;
+            uint8_t scratch;
+            BleReply reply(room ? &out[outLen + BLE_CMD_REPLY_HEADER_LEN] : &scratch, (uint8_t)room);
+            
+            BleCmdStatus status = run(cmd, reply);
+            if (status == BLE_CMD_DEFERRED) continue;
+            if (status != BLE_CMD_OK) failed++;
+            
+            if (outLen + BLE_CMD_REPLY_HEADER_LEN > out_max) {
+                repliesDropped++;
+                continue;
+            }
+            out[outLen] = cmd.opcode | BLE_CMD_REPLY_FLAG;
+            out[outLen + 1] = 1 + reply.length();
+            out[outLen + 2] = status;
+            outLen += BLE_CMD_REPLY_HEADER_LEN + reply.length();
+        }
+        return outLen;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // A reply sent outside dispatch() (BLE_CMD_DEFERRED). Returns its
+    // length, 0 if it does not fit
+    static size_t buildReply(uint8_t* out, size_t out_max, uint8_t opcode, BleCmdStatus status,
+                             const uint8_t* data, uint8_t n) {
+        if ((size_t)BLE_CMD_REPLY_HEADER_LEN + n > out_max) return 0;
+        out[0] = opcode | BLE_CMD_REPLY_FLAG;
+        out[1] = 1 + n;
+        out[2] = status;
+        if (n > 0) memcpy(&out[BLE_CMD_REPLY_HEADER_LEN], data, n);
+        return BLE_CMD_REPLY_HEADER_LEN + n;
+    }
+    
+    uint32_t getCommands() const { return commands; }
+    uint32_t getFailed() const { return failed; }
+    uint32_t getMalformed() const { return malformed; }
+    uint32_t getRepliesDropped() const { return repliesDropped; }
+
+private:
+    BleCmdStatus run(const BleCommand& cmd, BleReply& reply) {
+        if (cmd.opcode >= BLE_CMD_OPCODE_LIMIT || slot[cmd.opcode] == 0) return BLE_CMD_UNKNOWN;
+        const BleCommandSpec& spec = table[slot[cmd.opcode] - 1];
+        if (cmd.length < spec.min_len || cmd.length > spec.max_len) return BLE_CMD_BAD_LENGTH;
+        return spec.handler(cmd, reply);
+    }
+    
+    size_t appendReply(uint8_t* out, size_t out_max, size_t outLen, uint8_t opcode,
+                       uint8_t status, const uint8_t* data, uint8_t n) {
+        if (outLen + BLE_CMD_REPLY_HEADER_LEN + n > out_max) {
+            repliesDropped++;
+            return outLen;
+        }
+        out[outLen] = opcode;
+        out[outLen + 1] = 1 + n;
+        out[outLen + 2] = status;
+        memcpy(&out[outLen + BLE_CMD_REPLY_HEADER_LEN], data, n);
+        return outLen + BLE_CMD_REPLY_HEADER_LEN + n;
+    }
+};
+
+#endif // BLE_COMMAND_H
@@ -0,0 +1,199 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE STREAM - Binary Telemetry Notifications
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Packs IMU samples for the stream characteristic, BLEManager does the
+ * radio work:
+ * - Samples are queued and sent many per notification (one notification
+ *   per connection event instead of one JSON string per reading)
+ * - A notification goes out when it is full or its oldest sample has
+ *   waited BLE_STREAM_LATENCY_MS
+ * - Backpressure: a frame is only removed from the queue once the stack
+ *   accepted it; a full queue drops the oldest samples (counted)
+ * 
+ * LAYOUT (little endian):
+ *   IMU frame, 8-byte header + 13 bytes per sample:
+ *     [0]     BLE_FRAME_IMU
+ *     [1]     sample count
+ *     [2..3]  frame sequence number
+ *     [4..7]  t0: device millis() of the first sample
+ *     sample: dt_ms (u8, since the previous sample, 0 for the first)
+ *             accel x,y,z (i16, mg), gyro x,y,z (i16, 0.1 deg/s)
+ *   Status frame (6 bytes, replaces the JSON telemetry message):
+ *     [0] BLE_FRAME_STATUS  [1] context_id  [2] status  [3..4] value  [5] battery
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BLE_STREAM_H
+#define BLE_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/config.h"
+#include "../include/types.h"
+
+#define BLE_FRAME_IMU          0x01
+#define BLE_FRAME_STATUS       0x02
+#define BLE_STREAM_HEADER_LEN  8
+#define BLE_IMU_SAMPLE_LEN     13
+#define BLE_STATUS_LEN         6
+
+// SensorData is SI (m/s^2, rad/s), the wire is mg and 0.1 deg/s
+#define BLE_MS2_TO_MG          (1000.0f / 9.81f)
+#define BLE_RADS_TO_DECIDEG    (1800.0f / 3.14159265f)
+
+struct ImuSample {
+    uint32_t t_ms;
+    int16_t accel[3];         // mg
+    int16_t gyro[3];          // 0.1 deg/s
+};
+
+class BleStreamPacker {
+private:
+    ImuSample queue[BLE_STREAM_QUEUE];
+    uint16_t head = 0;
+    uint16_t count = 0;
+    uint16_t seq = 0;
+    uint16_t built = 0;       // Samples in the frame awaiting commit()
+    
+    // Statistics
+    uint32_t pushed = 0;
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+    uint32_t frames = 0;
+    uint16_t highWater = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // PRODUCER (sensor loop)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static ImuSample fromSensor(const SensorData& d, uint32_t t_ms) {
+        ImuSample s;
+        s.t_ms = t_ms;
+        s.accel[0] = clamp16(d.accel_x * BLE_MS2_TO_MG);
+        s.accel[1] = clamp16(d.accel_y * BLE_MS2_TO_MG);
+        s.accel[2] = clamp16(d.accel_z * BLE_MS2_TO_MG);
+        s.gyro[0] = clamp16(d.gyro_x * BLE_RADS_TO_DECIDEG);
+        s.gyro[1] = clamp16(d.gyro_y * BLE_RADS_TO_DECIDEG);
+        s.gyro[2] = clamp16(d.gyro_z * BLE_RADS_TO_DECIDEG);
+        return s;
+    }
+    
+    void push(const ImuSample& s) {
+        if (count == BLE_STREAM_QUEUE) {
+            // Oldest first: the live chart cares about now
+            head = (head + 1) % BLE_STREAM_QUEUE;
+            count--;
+            if (built) built--;
+            dropped++;
+        }
+        queue[(head + count) % BLE_STREAM_QUEUE] = s;
+        count++;
+        pushed++;
+        if (count > highWater) highWater = count;
+    }
+    
+    void clear() {
+        head = 0;
+        count = 0;
+        built = 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONSUMER (BLE side)
+    // max_len = notification payload (negotiated MTU - 3)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static uint16_t samplesPerFrame(size_t max_len) {
+        if (max_len < BLE_STREAM_HEADER_LEN + BLE_IMU_SAMPLE_LEN) return 0;
+        size_t n = (max_len - BLE_STREAM_HEADER_LEN) / BLE_IMU_SAMPLE_LEN;
+        return (n > 255) ? 255 : (uint16_t)n;
+    }
+    
+    bool shouldFlush(uint32_t now_ms, size_t max_len) const {
+        if (count == 0) return false;
+        if (count >= samplesPerFrame(max_len)) return true;
+        return now_ms - queue[head].t_ms >= BLE_STREAM_LATENCY_MS;
+    }
+    
+    // Builds the next frame; the samples stay queued until commit()
+    size_t build(uint8_t* out, size_t max_len) {
+        uint16_t n = samplesPerFrame(max_len);
+        if (n > count) n = count;
+        if (n == 0) return 0;
+        
+        uint32_t t0 = queue[head].t_ms;
+        out[0] = BLE_FRAME_IMU;
+        out[1] = (uint8_t)n;
+        out[2] = seq & 0xFF;
+        out[3] = seq >> 8;
+        out[4] = t0 & 0xFF;
+        out[5] = (t0 >> 8) & 0xFF;
+        out[6] = (t0 >> 16) & 0xFF;
+        out[7] = t0 >> 24;
+        
+        size_t len = BLE_STREAM_HEADER_LEN;
+        uint32_t prev = t0;
+        for (uint16_t i = 0; i < n; i++) {
+            const ImuSample& s = queue[(head + i) % BLE_STREAM_QUEUE];
+            uint32_t dt = s.t_ms - prev;
+            out[len++] = (dt > 255) ? 255 : (uint8_t)dt;
+            prev = s.t_ms;
+            for (int a = 0; a < 3; a++) {
+                out[len++] = (uint16_t)s.accel[a] & 0xFF;
+                out[len++] = (uint16_t)s.accel[a] >> 8;
+            }
+            for (int a = 0; a < 3; a++) {
+                out[len++] = (uint16_t)s.gyro[a] & 0xFF;
+                out[len++] = (uint16_t)s.gyro[a] >> 8;
+            }
+        }
+        built = n;
+        return len;
+    }
+    
+    // The stack accepted the last built frame
+    void commit() {
+        head = (head + built) % BLE_STREAM_QUEUE;
+        count -= built;
+        sent += built;
+        built = 0;
+        seq++;
+        frames++;
+    }
+    
+    static size_t encodeStatus(uint8_t* out, uint8_t context_id, uint8_t status,
+                               uint16_t value, uint8_t battery) {
+        out[0] = BLE_FRAME_STATUS;
+        out[1] = context_id;
+        out[2] = status;
+        out[3] = value & 0xFF;
+        out[4] = value >> 8;
+        out[5] = battery;
+        return BLE_STATUS_LEN;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t pending() const { return count; }
+    uint32_t getPushed() const { return pushed; }
+    uint32_t getSent() const { return sent; }
+    uint32_t getDropped() const { return dropped; }
+    uint32_t getFrames() const { return frames; }
+    uint16_t getHighWater() const { return highWater; }
+
+private:
+    static int16_t clamp16(float v) {
+        if (v != v) return 0;
+        if (v > 32767.0f) return 32767;
+        if (v < -32768.0f) return -32768;
+        return (int16_t)(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+};
+
+#endif // BLE_STREAM_H
@@ -0,0 +1,250 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    CAPTURE STREAM - Raw IMU Frames for Data Collection
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Carries every MPU6050 FIFO sample to the phone while a capture runs
+ * (training data for the classifiers), CaptureManager does the I/O:
+ * - Samples are numbered at the IMU's ODR; the number IS the timestamp
+ *   (t0_us + index * 1e6 / odr), so the host needs no per-sample clock
+ * - Any loss shows up as a jump in the index: FIFO overflow (the producer
+ *   skips the samples it missed) or a full ring (index spent, sample gone)
+ * - A frame never spans a gap, the receiver just compares each frame's
+ *   first index with the one it expected
+ * - Single producer (FIFO task) / single consumer (BLE loop), no heap
+ * 
+ * LAYOUT (little endian, stream characteristic):
+ *   START [0] 0x10  [1] version  [2..3] odr_hz  [4..5] accel LSB/g
+ *         [6..7] gyro LSB/(0.1 deg/s)  [8..11] t0_us  [12] flags (bit0 audio)
+ *   IMU   [0] 0x11  [1] count  [2..5] index of the first sample
+ *         sample: accel x,y,z, gyro x,y,z (i16 raw counts) = 12 bytes
+ *   AUDIO [0] 0x12  [1] flags (bit0 musical, bit1 speech)  [2..5] IMU index
+ *         [6..7] dominant Hz  [8..9] centroid Hz  [10..11] harmonic x1000
+ *         [12..13] energy
+ *   STOP  [0] 0x13  [1] reason  [2..5] samples captured  [6..9] samples lost
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef CAPTURE_STREAM_H
+#define CAPTURE_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/config.h"
+
+#define BLE_FRAME_CAPTURE_START  0x10
+#define BLE_FRAME_CAPTURE_IMU    0x11
+#define BLE_FRAME_CAPTURE_AUDIO  0x12
+#define BLE_FRAME_CAPTURE_STOP   0x13
+
+#define CAPTURE_VERSION          1
+#define CAPTURE_START_LEN        13
+#define CAPTURE_IMU_HEADER_LEN   6
+#define CAPTURE_SAMPLE_LEN       12
+#define CAPTURE_AUDIO_LEN        14
+#define CAPTURE_STOP_LEN         10
+
+enum CaptureStopReason {
+    CAPTURE_STOP_REQUESTED = 0,
+    CAPTURE_STOP_DISCONNECTED = 1,
+    CAPTURE_STOP_UNSUBSCRIBED = 2
+};
+
+struct RawImuSample {
+    int16_t accel[3];         // Raw counts, see accel_lsb_per_g
+    int16_t gyro[3];
+};
+
+struct CaptureInfo {
+    uint16_t odr_hz;
+    uint16_t accel_lsb_per_g;
+    uint16_t gyro_lsb_per_dps_x10;
+    uint32_t t0_us;
+    bool audio;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// RING (FIFO task → BLE loop)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class CaptureRing {
+private:
+    struct Slot {
+        uint32_t index;
+        RawImuSample sample;
+    };
+    
+    Slot slots[CAPTURE_QUEUE];
+    volatile uint16_t head = 0;   // Next write
+    volatile uint16_t tail = 0;   // Next read
+    uint32_t nextIndex = 0;       // Producer side
+    uint16_t built = 0;           // Samples in the frame awaiting commit()
+    
+    // Statistics
+    uint32_t lostFull = 0;
+    uint32_t lostOverflow = 0;
+    uint32_t sent = 0;
+    uint32_t frames = 0;
+    uint16_t highWater = 0;
+
+public:
+    // Only while neither side runs
+    void reset() {
+        head = 0;
+        tail = 0;
+        nextIndex = 0;
+        built = 0;
+        lostFull = 0;
+        lostOverflow = 0;
+        sent = 0;
+        frames = 0;
+        highWater = 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PRODUCER (FIFO task)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // False when the ring is full: the sample is lost, its index is not
+    bool push(const RawImuSample& s) {
+        uint32_t index = nextIndex++;
+        uint16_t next = (head + 1) % CAPTURE_QUEUE;
+        if (next == tail) {
+            lostFull++;
+            return false;
+        }
+        slots[head].index = index;
+        slots[head].sample = s;
+        head = next;
+        
+        uint16_t used = available();
+        if (used > highWater) highWater = used;
+        return true;
+    }
+    
+    // Samples the IMU produced but we never read (FIFO overflow)
+    void skip(uint32_t n) {
+        nextIndex += n;
+        lostOverflow += n;
+    }
+    
+    uint32_t producedCount() const { return nextIndex; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONSUMER (BLE loop)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t available() const {
+        return (uint16_t)((head + CAPTURE_QUEUE - tail) % CAPTURE_QUEUE);
+    }
+    
+    static uint16_t samplesPerFrame(size_t max_len) {
+        if (max_len < CAPTURE_IMU_HEADER_LEN + CAPTURE_SAMPLE_LEN) return 0;
+        size_t n = (max_len - CAPTURE_IMU_HEADER_LEN) / CAPTURE_SAMPLE_LEN;
+        return (n > 255) ? 255 : (uint16_t)n;
+    }
+    
+    // Next frame (stops at a gap); the samples stay queued until commit()
+    size_t build(uint8_t* out, size_t max_len) {
+        uint16_t avail = available();
+        uint16_t n = samplesPerFrame(max_len);
+        if (n > avail) n = avail;
+        if (n == 0) return 0;
+        
+        uint32_t first = slots[tail].index;
+        out[0] = BLE_FRAME_CAPTURE_IMU;
+        out[2] = first & 0xFF;
+        out[3] = (first >> 8) & 0xFF;
+        out[4] = (first >> 16) & 0xFF;
+        out[5] = first >> 24;
+        
+        size_t len = CAPTURE_IMU_HEADER_LEN;
+        uint16_t i = 0;
+        for (; i < n; i++) {
+            const Slot& slot = slots[(tail + i) % CAPTURE_QUEUE];
+            if (slot.index != first + i) break;
+            for (int a = 0; a < 3; a++) {
+                out[len++] = (uint16_t)slot.sample.accel[a] & 0xFF;
+                out[len++] = (uint16_t)slot.sample.accel[a] >> 8;
+            }
+            for (int a = 0; a < 3; a++) {
+                out[len++] = (uint16_t)slot.sample.gyro[a] & 0xFF;
+                out[len++] = (uint16_t)slot.sample.gyro[a] >> 8;
+            }
+        }
+        out[1] = (uint8_t)i;
+        built = i;
+        return len;
+    }
+    
+    // The stack accepted the last built frame
+    void commit() {
+        tail = (tail + built) % CAPTURE_QUEUE;
+        sent += built;
+        built = 0;
+        frames++;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONTROL FRAMES
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static size_t encodeStart(uint8_t* out, const CaptureInfo& info) {
+        out[0] = BLE_FRAME_CAPTURE_START;
+        out[1] = CAPTURE_VERSION;
+        put16(&out[2], info.odr_hz);
+        put16(&out[4], info.accel_lsb_per_g);
+        put16(&out[6], info.gyro_lsb_per_dps_x10);
+        put32(&out[8], info.t0_us);
+        out[12] = info.audio ? 0x01 : 0x00;
+        return CAPTURE_START_LEN;
+    }
+    
+    static size_t encodeAudio(uint8_t* out, uint32_t imu_index, uint16_t dominant_hz,
+                              uint16_t centroid_hz, uint16_t harmonic_x1000, uint16_t energy,
+                              bool musical, bool speech) {
+        out[0] = BLE_FRAME_CAPTURE_AUDIO;
+        out[1] = (musical ? 0x01 : 0) | (speech ? 0x02 : 0);
+        put32(&out[2], imu_index);
+        put16(&out[6], dominant_hz);
+        put16(&out[8], centroid_hz);
+        put16(&out[10], harmonic_x1000);
+        put16(&out[12], energy);
+        return CAPTURE_AUDIO_LEN;
+    }
+    
+    size_t encodeStop(uint8_t* out, uint8_t reason) const {
+        out[0] = BLE_FRAME_CAPTURE_STOP;
+        out[1] = reason;
+        put32(&out[2], nextIndex);
+        put32(&out[6], getLost());
+        return CAPTURE_STOP_LEN;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t getLost() const { return lostFull + lostOverflow; }
+    uint32_t getLostFull() const { return lostFull; }
+    uint32_t getLostOverflow() const { return lostOverflow; }
+    uint32_t getSent() const { return sent; }
+    uint32_t getFrames() const { return frames; }
+    uint16_t getHighWater() const { return highWater; }
+
+private:
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+    
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+        p[2] = (v >> 16) & 0xFF;
+        p[3] = v >> 24;
+    }
+};
+
+#endif // CAPTURE_STREAM_H
@@ -0,0 +1,270 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE OTA - Chunked Image Transfer with Resume
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Firmware image from the phone over the OTA characteristic (the dashboard
+ * sends, BleOtaManager flashes):
+ * - Every write carries its image offset: a lost or reordered write is seen
+ *   at once, the device NACKs with the offset it expects and the sender
+ *   rewinds to it
+ * - Windowed flow control: the sender keeps at most OTA_WINDOW bytes past
+ *   the last ACK in flight. An ACK is only sent once the ring can take a
+ *   whole window past it, so a slow flash erase never drops a write
+ * - The ring is addressed by image offset and OTA_BLOCK_SIZE aligned: the
+ *   flash writer takes whole blocks straight out of it, one Update.write
+ *   per flash sector, no copy
+ * - Resume: the session outlives a disconnect. OTA_BEGIN with the same
+ *   size and hash answers with an ACK at the first byte still missing
+ * - Single producer (BLE task) / single consumer (OTA task), no heap
+ * 
+ * LAYOUT (little endian):
+ *   data   phone → device, write without response
+ *          [0..3] image offset  [4..] bytes
+ *   ACK    [0] 0x01  [1..4] bytes received in order (the sender may send
+ *          up to this + OTA_WINDOW)
+ *   NACK   [0] 0x02  [1..4] offset the device expects next
+ *   RESULT [0] 0x03  [1] OtaResult  [2..5] bytes flashed
+ * 
+ * Control commands (src/ble/ble_command.h): OTA_BEGIN size + SHA-256
+ * (+ encoding, + the backend's signature), OTA_STATUS, OTA_END (verify, RESULT follows), OTA_ACTIVATE (reboot into
+ * the verified image), OTA_ABORT
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef OTA_TRANSFER_H
+#define OTA_TRANSFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../include/config.h"
+
+#define OTA_MSG_ACK         0x01
+#define OTA_MSG_NACK        0x02
+#define OTA_MSG_RESULT      0x03
+
+#define OTA_DATA_HEADER_LEN 4
+#define OTA_ACK_LEN         5
+#define OTA_RESULT_LEN      6
+#define OTA_SHA256_LEN      32
+#define OTA_BEGIN_SIG_MAX   72      // DER ECDSA P-256 signature carried by OTA_BEGIN
+
+static_assert((OTA_RING_SIZE & (OTA_RING_SIZE - 1)) == 0, "OTA_RING_SIZE must be a power of two");
+static_assert(OTA_RING_SIZE % OTA_BLOCK_SIZE == 0, "OTA ring must hold whole flash blocks");
+static_assert(OTA_WINDOW + OTA_BLOCK_SIZE <= OTA_RING_SIZE, "OTA window leaves no room for a partial block");
+static_assert(OTA_ACK_STEP <= OTA_WINDOW, "OTA ACK step larger than the window");
+
+enum OtaResult {
+    OTA_RESULT_OK = 0,              // Hash matched, image ready to activate
+    OTA_RESULT_HASH_MISMATCH = 1,
+    OTA_RESULT_FLASH_ERROR = 2,     // Update.begin / write / end failed
+    OTA_RESULT_ABORTED = 3,         // OTA_ABORT, a new image, or the download broke off
+    OTA_RESULT_TIMEOUT = 4,         // Phone did not come back in time
+    OTA_RESULT_BAD_SIGNATURE = 5,   // Hash matched, signature did not (OTA_SIGNING_PUBKEY)
+    OTA_RESULT_BAD_PATCH = 6        // Delta for another base image, corrupt or cut short
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// TRANSFER (ring + window bookkeeping)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class OtaTransfer {
+private:
+    uint8_t ring[OTA_RING_SIZE];
+    uint32_t size = 0;
+    uint8_t sha[OTA_SHA256_LEN];
+    bool active = false;
+    
+    volatile uint32_t received = 0;     // Producer: contiguous bytes in the ring
+    volatile uint32_t flashed = 0;      // Consumer: bytes handed to the flash
+    uint32_t acked = 0;                 // Consumer: last ACK sent
+    volatile bool announce = false;     // Next ACK goes out even without progress
+    
+    // NACK (set by the producer, sent by the consumer)
+    volatile bool nackPending = false;
+    volatile uint32_t nackOffset = 0;
+    uint32_t lastNack = 0xFFFFFFFF;
+    uint32_t sinceNack = 0;             // Out-of-order bytes since lastNack
+    
+    // Statistics
+    uint32_t packets = 0;
+    uint32_t duplicates = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t overruns = 0;
+    uint32_t nacks = 0;
+    uint32_t resumes = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // SESSION (OTA task, while the producer ignores writes: see isActive)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Same image as the running session: keep everything, the ACK tells the
+    // sender where to continue. Returns true when resuming
+    bool begin(uint32_t image_size, const uint8_t* image_sha) {
+        if (active && image_size == size && memcmp(image_sha, sha, OTA_SHA256_LEN) == 0) {
+            resumes++;
+            nackPending = false;
+            lastNack = 0xFFFFFFFF;
+            announce = true;
+            return true;
+        }
+        
+        active = false;             // The BLE task drops writes meanwhile
+        size = image_size;
+        memcpy(sha, image_sha, OTA_SHA256_LEN);
+        received = 0;
+        flashed = 0;
+        acked = 0;
+        nackPending = false;
+        lastNack = 0xFFFFFFFF;
+        sinceNack = 0;
+        packets = 0;
+        duplicates = 0;
+        outOfOrder = 0;
+        overruns = 0;
+        nacks = 0;
+        resumes = 0;
+        announce = true;
+        active = true;
+        return false;
+    }
+    
+    void end() {
+        active = false;
+    }
+    
+    bool isActive() const { return active; }
+    uint32_t imageSize() const { return size; }
+    const uint8_t* imageSha() const { return sha; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PRODUCER (BLE write callback)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // One data write. False if nothing new was taken
+    bool onPacket(const uint8_t* data, size_t len) {
+        if (!active || len <= OTA_DATA_HEADER_LEN) return false;
+        packets++;
+        
+        uint32_t offset = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+        const uint8_t* bytes = data + OTA_DATA_HEADER_LEN;
+        uint32_t n = len - OTA_DATA_HEADER_LEN;
+        uint32_t at = received;
+        
+        // A gap: ask for the missing bytes once per window of stray packets
+        if (offset > at) {
+            outOfOrder++;
+            sinceNack += n;
+            if (lastNack != at || sinceNack >= OTA_WINDOW) {
+                lastNack = at;
+                sinceNack = 0;
+                nackOffset = at;
+                nackPending = true;
+            }
+            return false;
+        }
+        
+        // Retransmission after a rewind: keep only the part we lack
+        if (offset + n <= at) {
+            duplicates++;
+            return false;
+        }
+        uint32_t skip = at - offset;
+        bytes += skip;
+        n -= skip;
+        if (n > size - at) n = size - at;
+        
+        // Only a sender ignoring the window gets here
+        if (at + n - flashed > OTA_RING_SIZE) {
+            overruns++;
+            return false;
+        }
+        
+        uint32_t pos = at & (OTA_RING_SIZE - 1);
+        uint32_t first = OTA_RING_SIZE - pos;
+        if (first > n) first = n;
+        memcpy(&ring[pos], bytes, first);
+        memcpy(&ring[0], bytes + first, n - first);
+        received = at + n;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONSUMER (OTA task)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // A whole block (or the image's tail) ready for flash, 0 if none yet.
+    // Blocks never wrap: flashed stays block aligned and the ring holds
+    // whole blocks
+    size_t readyBlock(const uint8_t** block) const {
+        uint32_t avail = received - flashed;
+        if (avail < OTA_BLOCK_SIZE && received != size) return 0;
+        if (avail > OTA_BLOCK_SIZE) avail = OTA_BLOCK_SIZE;
+        *block = &ring[flashed & (OTA_RING_SIZE - 1)];
+        return avail;
+    }
+    
+    void release(size_t n) {
+        flashed += n;
+    }
+    
+    // ACK every OTA_ACK_STEP bytes, but only when a full window past it fits
+    size_t takeAck(uint8_t* out) {
+        uint32_t at = received;
+        bool done = (at == size);
+        if (!announce && (at == acked || (at - acked < OTA_ACK_STEP && !done))) return 0;
+        if (!done && at + OTA_WINDOW > flashed + OTA_RING_SIZE) return 0;
+        
+        announce = false;
+        acked = at;
+        return encode(out, OTA_MSG_ACK, at);
+    }
+    
+    size_t takeNack(uint8_t* out) {
+        if (!nackPending) return 0;
+        nackPending = false;
+        nacks++;
+        return encode(out, OTA_MSG_NACK, nackOffset);
+    }
+    
+    bool complete() const { return active && flashed == size; }
+    
+    static size_t encodeResult(uint8_t* out, OtaResult result, uint32_t flashedBytes) {
+        out[0] = OTA_MSG_RESULT;
+        out[1] = (uint8_t)result;
+        put32(&out[2], flashedBytes);
+        return OTA_RESULT_LEN;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t getReceived() const { return received; }
+    uint32_t getFlashed() const { return flashed; }
+    uint32_t getPackets() const { return packets; }
+    uint32_t getDuplicates() const { return duplicates; }
+    uint32_t getOutOfOrder() const { return outOfOrder; }
+    uint32_t getOverruns() const { return overruns; }
+    uint32_t getNacks() const { return nacks; }
+    uint32_t getResumes() const { return resumes; }
+
+private:
+    static size_t encode(uint8_t* out, uint8_t type, uint32_t offset) {
+        out[0] = type;
+        put32(&out[1], offset);
+        return OTA_ACK_LEN;
+    }
+    
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+        p[2] = (v >> 16) & 0xFF;
+        p[3] = v >> 24;
+    }
+};
+
+#endif // OTA_TRANSFER_H
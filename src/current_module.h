@@ -23,6 +23,11 @@ private:
     bool fallDetected = false;
     float lastImpact = 0;
     
+    // Tunable over BLE (PARAM_SET / PARAM_GET)
+    float freefallG = FREEFALL_THRESHOLD;
+    float impactG = IMPACT_THRESHOLD;
+    unsigned long fallWindowMs = FALL_WINDOW_MS;
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // INITIALIZATION
@@ -48,7 +53,7 @@ public:
     // UPDATE (call in main loop with sensor data)
     // ───────────────────────────────────────────────────────────────────────
     
-    void update(SensorData data) {
+    void update(const SensorData& data) {
         float magnitude = sqrt(
             data.accel_x * data.accel_x +
             data.accel_y * data.accel_y +
@@ -58,17 +63,17 @@ public:
         // Fall detection state machine
         if (!inFreeFall) {
             // Check for free-fall (weightlessness)
-            if (magnitude < FREEFALL_THRESHOLD) {
+            if (magnitude < freefallG) {
                 inFreeFall = true;
                 freeFallStart = millis();
                 Serial.println("[HELMET] ⚠️ Free-fall detected!");
             }
         } else {
             // In free-fall, check for impact
-            if (magnitude > IMPACT_THRESHOLD) {
-                if (millis() - freeFallStart < FALL_WINDOW_MS) {
+            if (magnitude > impactG) {
+                if (millis() - freeFallStart < fallWindowMs) {
                     // FALL DETECTED!
-                    fall Detected = true;
+                    fallDetected = true;
                     lastImpact = magnitude;
                     Serial.printf("[HELMET] 🚨 FALL DETECTED! Impact: %.2fg\n", magnitude);
                     triggerAlert();
@@ -76,7 +81,7 @@ public:
                 inFreeFall = false;
             }
             // Timeout - wasn't a fall
-            else if (millis() - freeFallStart > FALL_WINDOW_MS) {
+            else if (millis() - freeFallStart > fallWindowMs) {
                 inFreeFall = false;
             }
         }
@@ -138,6 +143,54 @@ public:
         return false;
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // SAMPLING (SamplingPolicy: FIFO rate and loop sleep)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Free-fall lasts hundreds of ms, the impact peak only a few: every
+    // sample once falling
+    uint32_t getSampleInterval() {
+        return inFreeFall ? 0 : HELMET_SAMPLE_MS;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PARAMETERS (g values in milli-g; false = unknown id or out of range)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    enum Param : uint8_t {
+        PARAM_FREEFALL_MG = 1,
+        PARAM_IMPACT_MG = 2,
+        PARAM_FALL_WINDOW_MS = 3
+    };
+    
+    bool setParam(uint8_t id, int32_t value) {
+        switch (id) {
+            case PARAM_FREEFALL_MG:
+                if (value < 50 || value > 1000) return false;
+                freefallG = value / 1000.0f;
+                return true;
+            case PARAM_IMPACT_MG:
+                if (value < 1000 || value > 16000) return false;
+                impactG = value / 1000.0f;
+                return true;
+            case PARAM_FALL_WINDOW_MS:
+                if (value < 100 || value > 5000) return false;
+                fallWindowMs = value;
+                return true;
+            default:
+                return false;
+        }
+    }
+    
+    bool getParam(uint8_t id, int32_t& value) {
+        switch (id) {
+            case PARAM_FREEFALL_MG:    value = (int32_t)(freefallG * 1000.0f + 0.5f); return true;
+            case PARAM_IMPACT_MG:      value = (int32_t)(impactG * 1000.0f + 0.5f); return true;
+            case PARAM_FALL_WINDOW_MS: value = (int32_t)fallWindowMs; return true;
+            default:                   return false;
+        }
+    }
+    
     // ───────────────────────────────────────────────────────────────────────
     // DEBUG
     // ───────────────────────────────────────────────────────────────────────
@@ -149,4 +202,7 @@ public:
     }
 };
 
+// main.cpp's entry point when the module registry is off (MODULE_REGISTRY_ENABLED 0)
+using CurrentModule = HelmetModule;
+
 #endif // HELMET_MODULE_H
@@ -0,0 +1,375 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    UAD GATEWAY - LoRa to USB Serial / WiFi Bridge
+ *                   Build: pio run -e uad_gateway
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Stays in continuous RX and forwards every uplink from any number of UAD
+ * devices:
+ * 1. DIO1 ISR timestamps the packet (micros)
+ * 2. update() drains the radio into the RX ring right away
+ * 3. loop() demultiplexes by device_id (gap / duplicate detection) and
+ *    batches one line per frame into the output buffer
+ * 4. The buffer goes out over USB serial every GATEWAY_FLUSH_MS or when
+ *    full, and optionally as one UDP datagram per batch (every record
+ *    once, whatever the serial port took)
+ * 5. Confirmed alerts are ACKed over the mesh (duplicates too: a retry
+ *    means the device missed our ACK)
+ * 6. With TDMA_ENABLED, a beacon opens every superframe: time base plus
+ *    slot reassignments for active devices whose DEVICE_ID slots collide
+ * 
+ * Output (default): JSON lines
+ *   {"us":123,"dev":7,"seq":42,"hops":0,"rssi":-97,"snr":7.5,"st":"ok","gap":0,"hex":"a107..."}
+ * With -D GATEWAY_BINARY_OUTPUT: records 0xA5 len ts(4) rssi(2) snr*4(1) payload
+ * 
+ * The serial port only ever gets whole records. The status report goes
+ * out between records (JSON lines only, a host skips lines without '{');
+ * binary output carries no text after setup()
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#include "managers/lora_manager.h"
+#include "lora/rx_ring.h"
+#include "lora/gateway_table.h"
+#include "lora/confirmed_uplink.h"
+#include "lora/tdma_sync.h"
+
+// ═══════════════════════════════════════════════════════════════════════════
+// GLOBAL SERVICES
+// ═══════════════════════════════════════════════════════════════════════════
+
+LoRaManager lora;
+LoRaRxRing rxRing;
+GatewayTable devices;
+MeshRelay ackMesh(GATEWAY_NODE_ID);   // Wraps ACK downlinks
+AirtimeLedger ackLedger;              // Duty cycle of the gateway's own TX
+
+// Optional UDP forward: define GATEWAY_UDP_HOST "a.b.c.d" in build_flags
+#ifdef GATEWAY_UDP_HOST
+const char* WIFI_SSID = "YOUR_WIFI_SSID";
+const char* WIFI_PASS = "YOUR_WIFI_PASS";
+WiFiUDP udp;
+#endif
+
+// Output batch (one line/record per frame)
+static char outBuf[2048];
+static size_t outLen = 0;
+static size_t udpFrom = 0;   // Records before this already went to UDP
+static unsigned long lastFlushMs = 0;
+
+// Stats
+static uint32_t framesForwarded = 0;
+static uint32_t duplicatesDropped = 0;
+static uint32_t outputOverruns = 0;
+static uint32_t acksSent = 0;
+static uint32_t acksSkipped = 0;
+
+// TDMA beacons (superframe grid on the gateway clock)
+static TdmaBeacon beacon;
+static unsigned long nextBeaconMs = 0;
+static uint32_t beaconsSent = 0;
+static uint32_t beaconsSkipped = 0;
+static uint16_t slotsShared = 0;
+
+static const char* ingestName(IngestResult r) {
+    switch (r) {
+        case INGEST_NEW:       return "new";
+        case INGEST_OK:        return "ok";
+        case INGEST_GAP:       return "gap";
+        case INGEST_LATE:      return "late";
+        case INGEST_DUPLICATE: return "dup";
+        case INGEST_RESTART:   return "restart";
+        case INGEST_UNKNOWN:   return "unknown";
+        default:               return "full";
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// RX PATH (runs inside lora.update(), keep it short)
+// ═══════════════════════════════════════════════════════════════════════════
+
+// No Serial here: a line could land inside a record. A full ring counts
+// the drop (printStatus: overflows)
+void onGatewayRx(const uint8_t* data, size_t len, int16_t rssi, float snr) {
+    rxRing.push(data, len, rssi, snr, lora.getRxTimestampUs());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// OUTPUT
+// ═══════════════════════════════════════════════════════════════════════════
+
+// Bytes of the leading records that fit in limit, never part of one
+static size_t wholeRecords(size_t limit) {
+    size_t n = 0;
+#ifdef GATEWAY_BINARY_OUTPUT
+    while (n < outLen && n + 9 + (uint8_t)outBuf[n + 1] <= limit) {
+        n += 9 + (uint8_t)outBuf[n + 1];
+    }
+#else
+    for (size_t i = 0; i < outLen && i < limit; i++) {
+        if (outBuf[i] == '\n') n = i + 1;
+    }
+#endif
+    return n;
+}
+
+void flushOutput() {
+    if (outLen == 0) return;
+
+#ifdef GATEWAY_UDP_HOST
+    // Records appended since the last flush, whole: the serial backpressure
+    // below only decides what stays queued for the UART
+    if (udpFrom < outLen && WiFi.status() == WL_CONNECTED) {
+        udp.beginPacket(GATEWAY_UDP_HOST, GATEWAY_UDP_PORT);
+        udp.write((const uint8_t*)outBuf + udpFrom, outLen - udpFrom);
+        udp.endPacket();
+    }
+#endif
+
+    // Never block the loop on a slow host: write the whole records the UART
+    // buffer takes, the rest goes on the next pass
+    size_t n = wholeRecords(Serial.availableForWrite());
+    if (n > 0) {
+        Serial.write((const uint8_t*)outBuf, n);
+    }
+
+    memmove(outBuf, outBuf + n, outLen - n);
+    outLen -= n;
+    udpFrom = outLen;
+    lastFlushMs = millis();
+}
+
+// Worst-case space one frame needs in outBuf
+static size_t recordSize(const RxFrame& f) {
+#ifdef GATEWAY_BINARY_OUTPUT
+    return 9 + f.length;
+#else
+    return 120 + 2 * f.length;
+#endif
+}
+
+void appendRecord(const RxFrame& f, int32_t dev, uint16_t seq, uint8_t hops,
+                  IngestResult r, uint16_t gap) {
+#ifdef GATEWAY_BINARY_OUTPUT
+    uint8_t* p = (uint8_t*)&outBuf[outLen];
+    int8_t snr4 = (int8_t)(f.snr * 4);
+    p[0] = 0xA5;
+    p[1] = f.length;
+    memcpy(&p[2], &f.timestamp_us, 4);
+    memcpy(&p[6], &f.rssi, 2);
+    p[8] = (uint8_t)snr4;
+    memcpy(&p[9], f.data, f.length);
+    outLen += 9 + f.length;
+#else
+    int n = snprintf(&outBuf[outLen], sizeof(outBuf) - outLen,
+                     "{\"us\":%lu,\"dev\":%ld,\"seq\":%u,\"hops\":%u,\"rssi\":%d,\"snr\":%.1f,"
+                     "\"st\":\"%s\",\"gap\":%u,\"hex\":\"",
+                     (unsigned long)f.timestamp_us, (long)dev, seq, hops, f.rssi, f.snr,
+                     ingestName(r), gap);
+    outLen += n;
+    
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for (uint8_t i = 0; i < f.length; i++) {
+        outBuf[outLen++] = HEX_DIGITS[f.data[i] >> 4];
+        outBuf[outLen++] = HEX_DIGITS[f.data[i] & 0x0F];
+    }
+    outLen += snprintf(&outBuf[outLen], sizeof(outBuf) - outLen, "\"}\n");
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ACK DOWNLINK (flooded through the mesh to the device)
+// ═══════════════════════════════════════════════════════════════════════════
+
+void sendAck(uint16_t device_id, uint16_t seq) {
+    uint8_t ack[ACK_FRAME_LEN];
+    uint8_t frame[MESH_HEADER_LEN + ACK_FRAME_LEN];
+    ConfirmedUplink::buildAck(ack, device_id, seq);
+    size_t len = ackMesh.wrap(ack, sizeof(ack), LORA_PRIO_ALERT, frame, sizeof(frame));
+    
+    // The gateway is bound by the same duty cycle; a skipped ACK is
+    // recovered by the device's retry
+    uint32_t airtime_ms = lora.estimateAirtimeUs(len) / 1000 + 1;
+    if (!ackLedger.canTransmit(LORA_FREQ, airtime_ms, millis())) {
+        acksSkipped++;
+        return;
+    }
+    
+    if (lora.queueFrame(frame, len)) {
+        ackLedger.charge(LORA_FREQ, airtime_ms, millis());
+        acksSent++;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// TDMA BEACON (on the superframe grid; a late beacon says how late it is)
+// ═══════════════════════════════════════════════════════════════════════════
+
+void sendBeacon() {
+    unsigned long now = millis();
+    if ((long)(now - nextBeaconMs) < 0) return;
+    
+    // Too late to still fit before slot 0: skip this superframe
+    if (now - nextBeaconMs > TDMA_FIRST_SLOT_MS / 2) {
+        nextBeaconMs += TDMA_BEACON_PERIOD_MS;
+        beaconsSkipped++;
+        return;
+    }
+    if (lora.isBusy()) return;  // ACK on air, next pass
+    
+    // Devices heard in the last few superframes get a slot of their own
+    static uint16_t active[GATEWAY_MAX_DEVICES];
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < devices.capacity(); i++) {
+        const DeviceStats& d = devices.slot(i);
+        if (d.used && now - d.last_seen_ms < 4UL * TDMA_BEACON_PERIOD_MS) active[n++] = d.device_id;
+    }
+    slotsShared = beacon.plan(active, n);
+    
+    uint8_t frame[TDMA_BEACON_MAX_LEN];
+    beacon.superframe_ms = nextBeaconMs;
+    beacon.tx_delay_ms = (uint8_t)(millis() - nextBeaconMs);
+    size_t len = beacon.encode(frame, sizeof(frame));
+    nextBeaconMs += TDMA_BEACON_PERIOD_MS;
+    
+    uint32_t airtime_ms = lora.estimateAirtimeUs(len) / 1000 + 1;
+    if (!ackLedger.canTransmit(LORA_FREQ, airtime_ms, millis())) {
+        beaconsSkipped++;
+        return;
+    }
+    
+    // Immediate: on air before this returns, so tx_delay_ms holds
+    if (lora.queueFrame(frame, len, LORA_TX_IMMEDIATE)) {
+        ackLedger.charge(LORA_FREQ, airtime_ms, millis());
+        beaconsSent++;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// FORWARDER (drains the ring, bounded per pass so RX is never starved)
+// ═══════════════════════════════════════════════════════════════════════════
+
+void forwardFrames() {
+    for (int budget = 8; budget > 0; budget--) {
+        const RxFrame* f = rxRing.peek();
+        if (!f) break;
+        
+        if (outLen + recordSize(*f) > sizeof(outBuf)) {
+            // Host not keeping up: the ring absorbs the burst meanwhile
+            outputOverruns++;
+            break;
+        }
+        
+        // Mesh frames: unwrap for the inner sequence and relay count
+        const uint8_t* inner = f->data;
+        size_t innerLen = f->length;
+        MeshPacket mesh;
+        bool isMesh = MeshRelay::parse(f->data, f->length, mesh);
+        if (isMesh) {
+            inner = mesh.payload;
+            innerLen = mesh.length;
+        }
+        
+        // Our own ACKs relayed back by the devices
+        if (isMesh && mesh.origin == GATEWAY_NODE_ID) {
+            rxRing.pop();
+            continue;
+        }
+        
+        int32_t dev;
+        uint16_t gap;
+        IngestResult r = devices.ingestPayload(f->data, f->length, millis(),
+                                               f->rssi, f->snr, &dev, &gap);
+        uint16_t seq = (innerLen >= 5 && (inner[0] == FRAME_TELEMETRY || inner[0] == FRAME_SCHEMA))
+                       ? (inner[3] | (inner[4] << 8)) : 0;
+        
+        // Duplicates of a confirmed alert still get ACKed (retry = lost ACK)
+        if (isMesh && mesh.confirm && dev >= 0 &&
+            devices.shouldAck(dev, seq, mesh.attempt, millis())) {
+            sendAck(dev, seq);
+        }
+        
+        if (r == INGEST_DUPLICATE) {
+            duplicatesDropped++;
+        } else {
+            appendRecord(*f, dev, seq, isMesh ? mesh.hops : 0, r, gap);
+            framesForwarded++;
+        }
+        rxRing.pop();
+    }
+}
+
+void printStatus() {
+    Serial.println("\n[GW] ═══ Gateway Status ═══");
+    Serial.printf("  Devices: %d\n", devices.size());
+    Serial.printf("  Forwarded: %lu, duplicates dropped: %lu\n",
+                  (unsigned long)framesForwarded, (unsigned long)duplicatesDropped);
+    Serial.printf("  RX ring: high water %d/%d, overflows %lu\n",
+                  rxRing.getHighWater(), GATEWAY_RX_RING_LEN, (unsigned long)rxRing.getOverflows());
+    Serial.printf("  Output overruns: %lu\n", (unsigned long)outputOverruns);
+    Serial.printf("  ACKs sent: %lu, skipped (duty cycle): %lu\n",
+                  (unsigned long)acksSent, (unsigned long)acksSkipped);
+#if TDMA_ENABLED
+    Serial.printf("  Beacons: %lu sent, %lu skipped | %u slot overrides, %u devices sharing\n",
+                  (unsigned long)beaconsSent, (unsigned long)beaconsSkipped,
+                  beacon.override_count, slotsShared);
+#endif
+    Serial.println("════════════════════════════\n");
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// SETUP
+// ═══════════════════════════════════════════════════════════════════════════
+
+void setup() {
+    Serial.setTxBufferSize(4096);
+    Serial.begin(GATEWAY_BAUD);
+    delay(500);
+    Serial.println("\n[GW] 🚀 UAD Gateway starting...");
+    
+    if (!lora.begin()) {
+        Serial.println("[GW] ❌ Radio init failed, halting");
+        while (true) delay(1000);
+    }
+    
+    lora.setRxCallback(onGatewayRx);
+    lora.getLbt().seed(esp_random());
+    lora.startReceive();
+
+#ifdef GATEWAY_UDP_HOST
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    Serial.printf("[GW] 📡 Forwarding to udp://%s:%d\n", GATEWAY_UDP_HOST, GATEWAY_UDP_PORT);
+#endif
+
+    Serial.println("[GW] ✅ Listening");
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// MAIN LOOP
+// ═══════════════════════════════════════════════════════════════════════════
+
+void loop() {
+    lora.update();
+    forwardFrames();
+#if TDMA_ENABLED
+    sendBeacon();
+#endif
+
+    if (outLen > sizeof(outBuf) / 2 || millis() - lastFlushMs >= GATEWAY_FLUSH_MS) {
+        flushOutput();
+    }
+    
+    // Text between records only: wait until the batch has drained
+#ifndef GATEWAY_BINARY_OUTPUT
+    static unsigned long lastStatus = 0;
+    if (millis() - lastStatus > 60000 && outLen == 0) {
+        lastStatus = millis();
+        printStatus();
+    }
+#endif
+}
@@ -0,0 +1,245 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    CONFIRMED UPLINK - ACK, Retry & Backoff for Alerts
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Alert frames (SOS / FALL / THEFT / IMPACT) must reach someone:
+ * 1. The frame is tracked by its telemetry sequence number
+ * 2. When its TX completes an ACK window opens (ALERT_ACK_WINDOW_MS);
+ *    time spent queued or in listen-before-talk backoff is not counted
+ * 3. No ACK: retry after ALERT_RETRY_BASE_MS * 2^n (+-25% jitter, capped)
+ * 4. ALERT_MAX_ATTEMPTS without ACK: give up and report it
+ * 
+ * Retries carry the same sequence number, so the gateway forwards the
+ * alert once and simply ACKs again. Routine telemetry is never tracked.
+ * 
+ * ACK LAYOUT (5 bytes, usually inside a mesh header from the gateway):
+ *   [0]    FRAME_ACK
+ *   [1..2] device_id being confirmed
+ *   [3..4] telemetry sequence number
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef CONFIRMED_UPLINK_H
+#define CONFIRMED_UPLINK_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+
+#define ACK_FRAME_LEN 5
+
+// Delivery statistics (this device)
+struct ConfirmStats {
+    uint32_t tracked;
+    uint32_t delivered;
+    uint32_t failed;
+    uint32_t retries;
+    uint32_t latency_min_ms;
+    uint32_t latency_max_ms;
+    uint32_t latency_sum_ms;
+    uint32_t attempts_hist[ALERT_MAX_ATTEMPTS];   // Delivered on attempt n+1
+    
+    uint32_t averageLatencyMs() const {
+        return delivered ? latency_sum_ms / delivered : 0;
+    }
+};
+
+class ConfirmedUplink {
+public:
+    enum ActionType { ACTION_RETRY, ACTION_GIVE_UP };
+    
+    // Returned by poll(): retransmit (after delay_ms) or report a failure
+    struct Action {
+        ActionType type;
+        const uint8_t* data;
+        uint8_t length;
+        uint16_t seq;
+        uint8_t attempt;          // Attempt number of the retransmission
+        uint32_t delay_ms;
+    };
+
+private:
+    enum EntryState { WAIT_TX, WAIT_ACK };
+    
+    struct Entry {
+        uint8_t data[LORA_MAX_PAYLOAD];
+        uint8_t length;
+        uint16_t seq;
+        uint8_t attempts;         // Transmissions so far
+        EntryState state;
+        uint32_t first_ms;        // Alert raised
+        uint32_t deadline_ms;
+        bool used;
+    };
+    
+    Entry entries[ALERT_CONFIRM_SLOTS];
+    ConfirmStats stats;
+    uint32_t rng = 0x1B873593;
+
+public:
+    ConfirmedUplink() {
+        memset(entries, 0, sizeof(entries));
+        memset(&stats, 0, sizeof(stats));
+    }
+    
+    void seed(uint32_t s) { if (s) rng = s; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // ACK FRAME HELPERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static size_t buildAck(uint8_t* out, uint16_t device_id, uint16_t seq) {
+        out[0] = FRAME_ACK;
+        out[1] = device_id & 0xFF;
+        out[2] = device_id >> 8;
+        out[3] = seq & 0xFF;
+        out[4] = seq >> 8;
+        return ACK_FRAME_LEN;
+    }
+    
+    static bool parseAck(const uint8_t* data, size_t len, uint16_t& device_id, uint16_t& seq) {
+        if (len < ACK_FRAME_LEN || data[0] != FRAME_ACK) return false;
+        device_id = data[1] | (data[2] << 8);
+        seq = data[3] | (data[4] << 8);
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // TRACK (alert submitted for its first transmission)
+    // Evicts the oldest entry when full: a newer alert matters more
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void track(const uint8_t* data, size_t len, uint16_t seq, uint32_t now_ms) {
+        Entry* slot = nullptr;
+        for (int i = 0; i < ALERT_CONFIRM_SLOTS; i++) {
+            Entry& e = entries[i];
+            if (!e.used) { slot = &e; break; }
+            if (!slot || (int32_t)(e.first_ms - slot->first_ms) < 0) slot = &e;
+        }
+        if (slot->used) stats.failed++;
+        
+        if (len > sizeof(slot->data)) len = sizeof(slot->data);
+        memcpy(slot->data, data, len);
+        slot->length = (uint8_t)len;
+        slot->seq = seq;
+        slot->attempts = 0;
+        slot->state = WAIT_TX;
+        slot->first_ms = now_ms;
+        slot->deadline_ms = now_ms + ALERT_RETRY_MAX_MS;   // Never made it on air
+        slot->used = true;
+        stats.tracked++;
+    }
+    
+    bool isTracked(uint16_t seq) { return find(seq) != nullptr; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // TRANSMITTED (TX done callback: the frame left the radio at tx_end_ms)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void onTransmit(uint16_t seq, uint32_t tx_end_ms) {
+        Entry* e = find(seq);
+        if (!e) return;
+        
+        e->attempts++;
+        e->state = WAIT_ACK;
+        e->deadline_ms = tx_end_ms + ALERT_ACK_WINDOW_MS;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // ACK RECEIVED (returns false for unknown / already confirmed seq)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool onAck(uint16_t seq, uint32_t now_ms) {
+        Entry* e = find(seq);
+        if (!e) return false;
+        
+        uint32_t latency = now_ms - e->first_ms;
+        if (stats.delivered == 0 || latency < stats.latency_min_ms) stats.latency_min_ms = latency;
+        if (latency > stats.latency_max_ms) stats.latency_max_ms = latency;
+        stats.latency_sum_ms += latency;
+        stats.delivered++;
+        
+        uint8_t n = e->attempts ? e->attempts - 1 : 0;
+        if (n >= ALERT_MAX_ATTEMPTS) n = ALERT_MAX_ATTEMPTS - 1;
+        stats.attempts_hist[n]++;
+        
+        e->used = false;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // POLL (call from loop; one action per call)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool poll(uint32_t now_ms, Action& action) {
+        for (int i = 0; i < ALERT_CONFIRM_SLOTS; i++) {
+            Entry& e = entries[i];
+            if (!e.used || (int32_t)(now_ms - e.deadline_ms) < 0) continue;
+            
+            // WAIT_TX timing out means the scheduler dropped it: counts as lost
+            if (e.state == WAIT_TX) e.attempts++;
+            
+            action.data = e.data;
+            action.length = e.length;
+            action.seq = e.seq;
+            action.attempt = e.attempts;
+            
+            if (e.attempts >= ALERT_MAX_ATTEMPTS) {
+                action.type = ACTION_GIVE_UP;
+                action.delay_ms = 0;
+                stats.failed++;
+                e.used = false;
+                return true;
+            }
+            
+            action.type = ACTION_RETRY;
+            action.delay_ms = backoff(e.attempts);
+            stats.retries++;
+            
+            // The caller resubmits now; the window restarts on onTransmit()
+            e.state = WAIT_TX;
+            e.deadline_ms = now_ms + action.delay_ms + ALERT_RETRY_MAX_MS;
+            return true;
+        }
+        return false;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    const ConfirmStats& getStats() { return stats; }
+    
+    int pendingCount() {
+        int n = 0;
+        for (int i = 0; i < ALERT_CONFIRM_SLOTS; i++) if (entries[i].used) n++;
+        return n;
+    }
+    
+    // Backoff before retransmission n+1 (n >= 1 transmissions done)
+    uint32_t backoff(uint8_t attempts) {
+        uint32_t base = ALERT_RETRY_BASE_MS;
+        for (uint8_t i = 1; i < attempts && base < ALERT_RETRY_MAX_MS; i++) base *= 2;
+        if (base > ALERT_RETRY_MAX_MS) base = ALERT_RETRY_MAX_MS;
+        
+        // xorshift32, +-25% so devices that lost the same ACK spread out
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        uint32_t delay = base - base / 4 + rng % (base / 2 + 1);
+        return (delay > ALERT_RETRY_MAX_MS) ? ALERT_RETRY_MAX_MS : delay;
+    }
+
+private:
+    Entry* find(uint16_t seq) {
+        for (int i = 0; i < ALERT_CONFIRM_SLOTS; i++) {
+            if (entries[i].used && entries[i].seq == seq) return &entries[i];
+        }
+        return nullptr;
+    }
+};
+
+#endif // CONFIRMED_UPLINK_H
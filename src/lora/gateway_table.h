@@ -0,0 +1,266 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    GATEWAY TABLE - Per-Device Link Bookkeeping
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * One entry per device_id heard by the gateway:
+ * - last seen, RSSI/SNR
+ * - sequence tracking with a 32-frame window: gaps, late arrivals,
+ *   duplicates (e.g. the same frame relayed twice) and device restarts
+ * - legacy 6-byte packets carry no sequence: an identical payload inside
+ *   GATEWAY_DUP_WINDOW_MS is treated as a duplicate
+ * 
+ * Open addressing, fixed capacity, no heap
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef GATEWAY_TABLE_H
+#define GATEWAY_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "mesh_relay.h"
+
+enum IngestResult {
+    INGEST_NEW,         // First frame from this device
+    INGEST_OK,          // In order
+    INGEST_GAP,         // In order after missing frames (see gap)
+    INGEST_LATE,        // Out of order, fills an earlier gap
+    INGEST_DUPLICATE,   // Already seen
+    INGEST_RESTART,     // Sequence jumped back: device rebooted
+    INGEST_UNKNOWN,     // Not a recognised frame, forwarded raw
+    INGEST_TABLE_FULL
+};
+
+struct DeviceStats {
+    uint16_t device_id;
+    bool used;
+    
+    uint32_t first_seen_ms;
+    uint32_t last_seen_ms;
+    int16_t last_rssi;
+    float last_snr;
+    
+    uint16_t last_seq;
+    uint32_t seen_mask;       // bit n = (last_seq - n) received
+    uint32_t legacy_hash;     // Last legacy payload (no sequence numbers)
+    
+    uint32_t frames;
+    uint32_t lost;
+    uint32_t duplicates;
+    uint32_t restarts;
+    
+    // Confirmed alerts
+    uint32_t alerts;            // Distinct alerts ACKed
+    uint32_t alert_attempts;    // Sum of the attempt number they arrived on
+    uint16_t last_ack_seq;
+    uint32_t last_ack_ms;
+};
+
+class GatewayTable {
+private:
+    DeviceStats entries[GATEWAY_MAX_DEVICES];
+    uint16_t deviceCount = 0;
+
+public:
+    GatewayTable() { clear(); }
+    
+    void clear() {
+        memset(entries, 0, sizeof(entries));
+        deviceCount = 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // INGEST (frame with sequence number)
+    // gap receives the number of frames missed when INGEST_GAP is returned
+    // ───────────────────────────────────────────────────────────────────────
+    
+    IngestResult ingest(uint16_t device_id, uint16_t seq, uint32_t now_ms,
+                        int16_t rssi, float snr, uint16_t* gap = nullptr) {
+        bool created;
+        DeviceStats* d = lookup(device_id, true, &created);
+        if (!d) return INGEST_TABLE_FULL;
+        
+        touch(d, now_ms, rssi, snr);
+        if (gap) *gap = 0;
+        
+        if (created) {
+            d->first_seen_ms = now_ms;
+            d->last_seq = seq;
+            d->seen_mask = 1;
+            d->frames = 1;
+            return INGEST_NEW;
+        }
+        
+        int16_t delta = (int16_t)(seq - d->last_seq);
+        
+        if (delta > 0) {
+            uint16_t missed = delta - 1;
+            d->lost += missed;
+            d->seen_mask = (delta >= 32) ? 1 : (d->seen_mask << delta) | 1;
+            d->last_seq = seq;
+            d->frames++;
+            if (gap) *gap = missed;
+            return missed ? INGEST_GAP : INGEST_OK;
+        }
+        
+        uint16_t back = (uint16_t)(-delta);
+        if (back < 32) {
+            uint32_t bit = 1UL << back;
+            if (d->seen_mask & bit) {
+                d->duplicates++;
+                return INGEST_DUPLICATE;
+            }
+            d->seen_mask |= bit;
+            if (d->lost) d->lost--;   // Counted as lost when the gap opened
+            d->frames++;
+            return INGEST_LATE;
+        }
+        
+        // Far behind: the device restarted its counter
+        d->restarts++;
+        d->last_seq = seq;
+        d->seen_mask = 1;
+        d->frames++;
+        return INGEST_RESTART;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // INGEST (legacy UAD_Packet, no sequence number)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    IngestResult ingestLegacy(uint16_t device_id, const uint8_t* payload, size_t len,
+                              uint32_t now_ms, int16_t rssi, float snr) {
+        bool created;
+        DeviceStats* d = lookup(device_id, true, &created);
+        if (!d) return INGEST_TABLE_FULL;
+        
+        uint32_t hash = fnv1a(payload, len);
+        bool recent = !created && (now_ms - d->last_seen_ms) < GATEWAY_DUP_WINDOW_MS;
+        
+        touch(d, now_ms, rssi, snr);
+        
+        if (recent && hash == d->legacy_hash) {
+            d->duplicates++;
+            return INGEST_DUPLICATE;
+        }
+        
+        d->legacy_hash = hash;
+        d->frames++;
+        if (created) d->first_seen_ms = now_ms;
+        return created ? INGEST_NEW : INGEST_OK;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // DEMULTIPLEX (raw uplink payload)
+    // device_id receives the sender, -1 for frames that carry no id
+    // ───────────────────────────────────────────────────────────────────────
+    
+    IngestResult ingestPayload(const uint8_t* payload, size_t len, uint32_t now_ms,
+                               int16_t rssi, float snr, int32_t* device_id,
+                               uint16_t* gap = nullptr) {
+        if (gap) *gap = 0;
+        
+        // Mesh relays: the inner frame carries the identity that matters,
+        // copies arriving over several paths are caught as duplicates there
+        while (len > MESH_HEADER_LEN && payload[0] == FRAME_MESH) {
+            payload += MESH_HEADER_LEN;
+            len -= MESH_HEADER_LEN;
+        }
+        
+        if (len == sizeof(UAD_Packet)) {
+            if (device_id) *device_id = payload[0];
+            return ingestLegacy(payload[0], payload, len, now_ms, rssi, snr);
+        }
+        
+        if (len >= 5 && (payload[0] == FRAME_TELEMETRY || payload[0] == FRAME_SCHEMA)) {
+            uint16_t dev = payload[1] | (payload[2] << 8);
+            uint16_t seq = payload[3] | (payload[4] << 8);
+            if (device_id) *device_id = dev;
+            return ingest(dev, seq, now_ms, rssi, snr, gap);
+        }
+        
+        if (device_id) *device_id = -1;
+        return INGEST_UNKNOWN;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONFIRMED ALERTS
+    // True when an ACK should go out: first copy of the alert, or a retry
+    // arriving after GATEWAY_REACK_MS (our previous ACK was lost).
+    // Copies relayed over several paths get one ACK.
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool shouldAck(uint16_t device_id, uint16_t seq, uint8_t attempt, uint32_t now_ms) {
+        DeviceStats* d = lookup(device_id, false, nullptr);
+        if (!d) return false;
+        
+        bool same = d->alerts > 0 && d->last_ack_seq == seq;
+        if (same && now_ms - d->last_ack_ms < GATEWAY_REACK_MS) return false;
+        
+        if (!same) {
+            d->alerts++;
+            d->alert_attempts += attempt + 1;
+        }
+        d->last_ack_seq = seq;
+        d->last_ack_ms = now_ms;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // QUERIES
+    // ───────────────────────────────────────────────────────────────────────
+    
+    const DeviceStats* find(uint16_t device_id) {
+        return lookup(device_id, false, nullptr);
+    }
+    
+    uint16_t size() const { return deviceCount; }
+    
+    // Iteration: walk 0..capacity() and skip entries that are not used
+    const DeviceStats& slot(uint16_t i) const { return entries[i]; }
+    static uint16_t capacity() { return GATEWAY_MAX_DEVICES; }
+    
+    static uint32_t fnv1a(const uint8_t* data, size_t len) {
+        uint32_t h = 2166136261UL;
+        for (size_t i = 0; i < len; i++) {
+            h ^= data[i];
+            h *= 16777619UL;
+        }
+        return h;
+    }
+
+private:
+    void touch(DeviceStats* d, uint32_t now_ms, int16_t rssi, float snr) {
+        d->last_seen_ms = now_ms;
+        d->last_rssi = rssi;
+        d->last_snr = snr;
+    }
+    
+    DeviceStats* lookup(uint16_t device_id, bool create, bool* created) {
+        if (created) *created = false;
+        
+        // Linear probing from a multiplicative hash of the id
+        uint16_t idx = (uint16_t)((device_id * 40503u) & (GATEWAY_MAX_DEVICES - 1));
+        for (uint16_t probe = 0; probe < GATEWAY_MAX_DEVICES; probe++) {
+            DeviceStats& e = entries[idx];
+            if (e.used && e.device_id == device_id) return &e;
+            if (!e.used) {
+                if (!create) return nullptr;
+                memset(&e, 0, sizeof(e));
+                e.used = true;
+                e.device_id = device_id;
+                deviceCount++;
+                if (created) *created = true;
+                return &e;
+            }
+            idx = (idx + 1) & (GATEWAY_MAX_DEVICES - 1);
+        }
+        return nullptr;
+    }
+};
+
+#endif // GATEWAY_TABLE_H
@@ -0,0 +1,116 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LISTEN BEFORE TALK - CAD Backoff & Channel Hopping
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Policy side of collision avoidance, LoRaManager does the radio work:
+ * - Each frame waits a short random delay, then runs SX1262 CAD
+ *   (channel activity detection) on its TX channel
+ * - Channel busy: binary exponential backoff (window doubles per busy
+ *   CAD, capped at 16x), radio listens meanwhile
+ * - LORA_LBT_MAX_TRIES busy results in a row: transmit anyway, an alert
+ *   must not starve behind a chatty neighbour
+ * - Optional hopping: each frame goes out on a random channel from
+ *   LORA_CHANNELS (needs a multi-channel gateway; RX stays on LORA_FREQ)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef LISTEN_BEFORE_TALK_H
+#define LISTEN_BEFORE_TALK_H
+
+#include <stdint.h>
+#include "../include/config.h"
+
+class ListenBeforeTalk {
+public:
+    enum Decision { LBT_TRANSMIT, LBT_BACKOFF };
+
+private:
+    float channels[LORA_CHANNEL_COUNT] = LORA_CHANNELS;
+    
+    bool hopping = LORA_HOPPING;
+    uint8_t busyCount = 0;
+    uint8_t lastChannel = 0;
+    uint32_t rng = 0x68E31DA4;
+    
+    // Statistics
+    uint32_t cadRuns = 0;
+    uint32_t cadBusy = 0;
+    uint32_t forced = 0;
+
+public:
+    void seed(uint32_t s) { if (s) rng = s; }
+    void setHopping(bool enabled) { hopping = enabled; }
+    bool isHopping() { return hopping; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // FRAME READY: random delay before the first CAD, so devices woken by
+    // the same event don't all find the channel free at the same instant
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t initialDelayMs() {
+        busyCount = 0;
+        return next() % (LORA_LBT_BACKOFF_MS / 4 + 1);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CAD RESULT
+    // wait_ms receives the backoff when LBT_BACKOFF is returned
+    // ───────────────────────────────────────────────────────────────────────
+    
+    Decision onCadResult(bool busy, uint32_t& wait_ms) {
+        cadRuns++;
+        wait_ms = 0;
+        
+        if (!busy) {
+            busyCount = 0;
+            return LBT_TRANSMIT;
+        }
+        
+        cadBusy++;
+        if (++busyCount >= LORA_LBT_MAX_TRIES) {
+            busyCount = 0;
+            forced++;
+            return LBT_TRANSMIT;
+        }
+        
+        uint8_t exp = (busyCount - 1 < 4) ? busyCount - 1 : 4;
+        uint32_t window = (uint32_t)LORA_LBT_BACKOFF_MS << exp;
+        wait_ms = 1 + next() % window;
+        return LBT_BACKOFF;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CHANNEL for the next frame (LORA_FREQ unless hopping)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    float nextChannel() {
+        if (!hopping || LORA_CHANNEL_COUNT < 2) return LORA_FREQ;
+        
+        // Never the same channel twice in a row
+        uint8_t ch = next() % (LORA_CHANNEL_COUNT - 1);
+        if (ch >= lastChannel) ch++;
+        lastChannel = ch;
+        return channels[ch];
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t getCadRuns() { return cadRuns; }
+    uint32_t getCadBusy() { return cadBusy; }
+    uint32_t getForced() { return forced; }
+
+private:
+    uint32_t next() {
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+};
+
+#endif // LISTEN_BEFORE_TALK_H
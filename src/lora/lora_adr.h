@@ -0,0 +1,145 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA ADR - Adaptive Data Rate Engine
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Picks the lowest TX power that keeps link margin
+ * - Link quality comes from gateway ACKs / downlink beacons (RSSI + SNR)
+ * - Surplus margin is spent in 3 dB power steps down to LORA_ADR_MIN_POWER
+ * - Consecutive uplink losses go straight back to full power
+ * 
+ * The spreading factor stays at LORA_SF: the gateway and mesh neighbours
+ * only listen there, and a node on another SF would no longer hear the
+ * ACKs and beacons it needs to come back (no SF negotiation yet)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef LORA_ADR_H
+#define LORA_ADR_H
+
+#include <stdint.h>
+#include <math.h>
+#include "../include/config.h"
+
+class LoRaADR {
+private:
+    static const int HISTORY = 8;
+    static const int STEP_DB = 3;
+    
+    int8_t txPower = LORA_TX_POWER;
+    
+    float snrHistory[HISTORY];
+    int historyCount = 0;
+    int historyIndex = 0;
+    int16_t lastRssi = 0;
+    
+    uint8_t consecutiveLosses = 0;
+    bool changed = false;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // DEMODULATION FLOOR (SX1262, BW125)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static float requiredSnr(uint8_t spreading_factor) {
+        // SF7: -7.5 dB ... SF12: -20 dB
+        return -7.5f - 2.5f * (spreading_factor - 7);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // LINK REPORT (ACK or beacon received)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void onLinkReport(int16_t rssi, float snr) {
+        lastRssi = rssi;
+        snrHistory[historyIndex] = snr;
+        historyIndex = (historyIndex + 1) % HISTORY;
+        if (historyCount < HISTORY) historyCount++;
+        
+        consecutiveLosses = 0;
+        recompute();
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // UPLINK RESULT (confirmed frame ACKed or not)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void onUplinkResult(bool delivered) {
+        if (delivered) {
+            consecutiveLosses = 0;
+            return;
+        }
+        
+        if (++consecutiveLosses < LORA_ADR_LOSS_LIMIT) return;
+        consecutiveLosses = 0;
+        
+        // Old SNR samples describe a link that no longer works
+        historyCount = 0;
+        historyIndex = 0;
+        
+        if (txPower < LORA_TX_POWER) {
+            txPower = LORA_TX_POWER;
+            changed = true;
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // APPLY (returns true once per change so the caller reconfigures the radio)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool takeChange() {
+        bool c = changed;
+        changed = false;
+        return c;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint8_t getSpreadingFactor() { return LORA_SF; }
+    int8_t getTxPower() { return txPower; }
+    int16_t getLastRssi() { return lastRssi; }
+    
+    float getAverageSnr() {
+        if (historyCount == 0) return 0;
+        float sum = 0;
+        for (int i = 0; i < historyCount; i++) sum += snrHistory[i];
+        return sum / historyCount;
+    }
+    
+    // Surplus over demodulation floor + installation margin (dB)
+    // Downlink SNR is measured against full power, so backed-off power
+    // counts against the margin (link reciprocity assumed)
+    float getMargin() {
+        return getAverageSnr() - requiredSnr(LORA_SF) - LORA_ADR_MARGIN_DB
+               - (LORA_TX_POWER - txPower);
+    }
+
+private:
+    void recompute() {
+        // Wait for a few samples before trading margin away
+        if (historyCount < HISTORY / 2) return;
+        
+        int8_t newPower = txPower;
+        int steps = (int)floorf(getMargin() / STEP_DB);
+        
+        while (steps > 0 && newPower - STEP_DB >= LORA_ADR_MIN_POWER) {
+            newPower -= STEP_DB;
+            steps--;
+        }
+        // Negative margin: buy it back with power
+        while (steps < 0 && newPower < LORA_TX_POWER) {
+            newPower = (newPower + STEP_DB > LORA_TX_POWER) ? LORA_TX_POWER : newPower + STEP_DB;
+            steps++;
+        }
+        
+        if (newPower != txPower) {
+            txPower = newPower;
+            changed = true;
+        }
+    }
+};
+
+#endif // LORA_ADR_H
@@ -0,0 +1,68 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA AIRTIME - Time-on-Air Calculator
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Semtech SX126x time-on-air formula (AN1200.13) for explicit-header LoRa
+ * Pure math, no radio access: usable for budgeting before a TX is started
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef LORA_AIRTIME_H
+#define LORA_AIRTIME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class LoRaAirtime {
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // SYMBOL TIME (µs) = 2^SF / BW
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static uint32_t symbolTimeUs(uint8_t sf, float bw_khz) {
+        return (uint32_t)((float)(1UL << sf) * 1000.0f / bw_khz);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // TIME ON AIR (µs)
+    // cr is the coding rate denominator (5..8 → 4/5..4/8)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static uint32_t timeOnAirUs(size_t payload_len, uint8_t sf, float bw_khz,
+                                uint8_t cr = 5, uint16_t preamble_len = 8,
+                                bool crc = true) {
+        uint32_t t_sym = symbolTimeUs(sf, bw_khz);
+        
+        // Low data rate optimisation is mandatory above 16 ms symbols
+        int de = (t_sym > 16000) ? 1 : 0;
+        
+        int num = 8 * (int)payload_len - 4 * sf + 28 + (crc ? 16 : 0);
+        int den = 4 * (sf - 2 * de);
+        int blocks = (num > 0) ? (num + den - 1) / den : 0;
+        uint32_t payload_symbols = 8 + blocks * cr;
+        
+        // Preamble: n_preamble + 4.25 symbols (kept in quarter-symbols)
+        uint32_t preamble_us = ((uint32_t)(preamble_len * 4 + 17) * t_sym) / 4;
+        
+        return preamble_us + payload_symbols * t_sym;
+    }
+    
+    static uint32_t timeOnAirMs(size_t payload_len, uint8_t sf, float bw_khz,
+                                uint8_t cr = 5, uint16_t preamble_len = 8) {
+        return (timeOnAirUs(payload_len, sf, bw_khz, cr, preamble_len) + 999) / 1000;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // MAX PAYLOAD PER SF (EU868 regional limits, BW125)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static size_t maxPayload(uint8_t sf) {
+        if (sf <= 8) return 222;
+        if (sf == 9) return 115;
+        return 51;
+    }
+};
+
+#endif // LORA_AIRTIME_H
@@ -0,0 +1,315 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA SCHEDULER - Priority & Duty-Cycle Control
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Decides WHEN a frame may go on air, LoRaManager decides HOW
+ * - Priority classes: alerts (SOS/FALL/THEFT/IMPACT) jump the queue
+ * - Rolling 1-hour airtime ledger per EU868 sub-band (ETSI EN 300 220)
+ * - Routine telemetry is jittered and may only use part of the budget,
+ *   the rest is reserved so alerts always stay legal
+ * - A newer routine frame replaces a stale one with the same key
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef LORA_SCHEDULER_H
+#define LORA_SCHEDULER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "lora_airtime.h"
+
+// Priority classes (lower value = more urgent)
+enum LoRaPriority {
+    LORA_PRIO_ALERT   = 0,  // SOS, FALL, THEFT, IMPACT
+    LORA_PRIO_STATUS  = 1,  // LOW_BATT and other state changes
+    LORA_PRIO_ROUTINE = 2   // Periodic telemetry
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// AIRTIME LEDGER (rolling window per sub-band)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class AirtimeLedger {
+public:
+    static const int SUB_BANDS = 6;
+    static const int BUCKETS = 60;                      // 1 minute each
+    static const uint32_t BUCKET_MS = 60000;
+    static const uint32_t WINDOW_MS = BUCKETS * BUCKET_MS;
+
+private:
+    struct SubBand {
+        float min_mhz;
+        float max_mhz;
+        uint16_t duty_permille;   // 10 = 1%
+    };
+    
+    // EU868 sub-bands (SRD860, ERC Rec 70-03 annex 1)
+    const SubBand bands[SUB_BANDS] = {
+        {863.00f, 865.00f,   1},    // 0.1%
+        {865.00f, 868.00f,  10},    // 1%
+        {868.00f, 868.60f,  10},    // 1%   (g1, LORA_FREQ lives here)
+        {868.70f, 869.20f,   1},    // 0.1% (g2)
+        {869.40f, 869.65f, 100},    // 10%  (g3)
+        {869.70f, 870.00f,  10}     // 1%   (g4)
+    };
+    
+    uint32_t used_ms[SUB_BANDS][BUCKETS];
+    uint32_t bucket_epoch[SUB_BANDS][BUCKETS];   // Which minute a bucket holds
+
+public:
+    AirtimeLedger() {
+        memset(used_ms, 0, sizeof(used_ms));
+        memset(bucket_epoch, 0, sizeof(bucket_epoch));
+    }
+    
+    int subBandFor(float freq_mhz) const {
+        for (int i = 0; i < SUB_BANDS; i++) {
+            if (freq_mhz >= bands[i].min_mhz && freq_mhz < bands[i].max_mhz) return i;
+        }
+        return -1;
+    }
+    
+    // Airtime allowed per rolling hour
+    uint32_t budgetMs(float freq_mhz) const {
+        int b = subBandFor(freq_mhz);
+        if (b < 0) return 0;
+        return (WINDOW_MS / 1000) * bands[b].duty_permille;
+    }
+    
+    void charge(float freq_mhz, uint32_t airtime_ms, uint32_t now_ms) {
+        int b = subBandFor(freq_mhz);
+        if (b < 0) return;
+        
+        uint32_t epoch = now_ms / BUCKET_MS;
+        int idx = epoch % BUCKETS;
+        if (bucket_epoch[b][idx] != epoch) {
+            bucket_epoch[b][idx] = epoch;
+            used_ms[b][idx] = 0;
+        }
+        used_ms[b][idx] += airtime_ms;
+    }
+    
+    uint32_t usedMs(float freq_mhz, uint32_t now_ms) const {
+        int b = subBandFor(freq_mhz);
+        if (b < 0) return 0;
+        
+        uint32_t epoch = now_ms / BUCKET_MS;
+        uint32_t total = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            if (epoch - bucket_epoch[b][i] < BUCKETS) total += used_ms[b][i];
+        }
+        return total;
+    }
+    
+    // share: fraction of the legal budget this caller may consume (0..1)
+    bool canTransmit(float freq_mhz, uint32_t airtime_ms, uint32_t now_ms, float share = 1.0f) const {
+        uint32_t limit = (uint32_t)(budgetMs(freq_mhz) * share);
+        return usedMs(freq_mhz, now_ms) + airtime_ms <= limit;
+    }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// SCHEDULER
+// ═══════════════════════════════════════════════════════════════════════════
+
+class LoRaScheduler {
+public:
+    struct Frame {
+        uint8_t data[LORA_MAX_PAYLOAD];
+        uint8_t length;
+        LoRaPriority priority;
+        uint8_t key;              // Coalescing key (0 = never coalesce)
+        uint32_t enqueued_ms;
+        uint32_t due_ms;
+        bool used;
+    };
+
+private:
+    Frame pending[LORA_SCHED_QUEUE_LEN];
+    AirtimeLedger ledger;
+    
+    uint8_t sf = LORA_SF;
+    uint32_t rng = 0x2545F491;
+    
+    // Statistics
+    uint32_t coalesced = 0;
+    uint32_t dropped = 0;
+    uint32_t deferred = 0;
+
+public:
+    LoRaScheduler() {
+        memset(pending, 0, sizeof(pending));
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONFIGURATION
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void seed(uint32_t s) { if (s) rng = s; }
+    
+    static LoRaPriority priorityFor(StatusCode status) {
+        switch (status) {
+            case STATUS_SOS:
+            case STATUS_FALL:
+            case STATUS_THEFT:
+            case STATUS_IMPACT:
+                return LORA_PRIO_ALERT;
+            case STATUS_LOW_BATT:
+                return LORA_PRIO_STATUS;
+            default:
+                return LORA_PRIO_ROUTINE;
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // SUBMIT (alerts are due now, routine frames get a random delay)
+    // delay_ms >= 0 overrides the jitter (mesh relays did their own backoff)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool submit(const uint8_t* data, size_t len, LoRaPriority priority,
+                uint32_t now_ms, uint8_t key = 0, int32_t delay_ms = -1) {
+        if (len == 0 || len > LORA_MAX_PAYLOAD) return false;
+        
+        // Replace a stale routine frame with the same key, keep its slot time
+        if (priority == LORA_PRIO_ROUTINE && key != 0) {
+            for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+                Frame& f = pending[i];
+                if (f.used && f.priority == LORA_PRIO_ROUTINE && f.key == key) {
+                    memcpy(f.data, data, len);
+                    f.length = (uint8_t)len;
+                    f.enqueued_ms = now_ms;
+                    coalesced++;
+                    return true;
+                }
+            }
+        }
+        
+        Frame* slot = freeSlot(priority);
+        if (!slot) {
+            dropped++;
+            return false;
+        }
+        
+        memcpy(slot->data, data, len);
+        slot->length = (uint8_t)len;
+        slot->priority = priority;
+        slot->key = key;
+        slot->enqueued_ms = now_ms;
+        if (delay_ms >= 0) {
+            slot->due_ms = now_ms + delay_ms;
+        } else {
+            slot->due_ms = (priority == LORA_PRIO_ROUTINE) ? now_ms + jitter() : now_ms;
+        }
+        slot->used = true;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // POP NEXT FRAME ALLOWED ON AIR (charges the ledger)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool pop(uint32_t now_ms, float freq_mhz, Frame& out) {
+        expireStale(now_ms);
+        
+        Frame* best = nullptr;
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+            Frame& f = pending[i];
+            if (!f.used || (int32_t)(now_ms - f.due_ms) < 0) continue;
+            
+            if (!best || f.priority < best->priority ||
+                (f.priority == best->priority && (int32_t)(f.due_ms - best->due_ms) < 0)) {
+                best = &f;
+            }
+        }
+        if (!best) return false;
+        
+        uint32_t airtime_ms = LoRaAirtime::timeOnAirMs(best->length, sf, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+        float share = (best->priority == LORA_PRIO_ALERT) ? 1.0f : 1.0f - LORA_DC_ALERT_RESERVE;
+        
+        if (!ledger.canTransmit(freq_mhz, airtime_ms, now_ms, share)) {
+            // Hold it; routine frames are retried later and keep coalescing
+            best->due_ms = now_ms + AirtimeLedger::BUCKET_MS / 4 + jitter() / 4;
+            deferred++;
+            return false;
+        }
+        
+        ledger.charge(freq_mhz, airtime_ms, now_ms);
+        out = *best;
+        best->used = false;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    AirtimeLedger& getLedger() { return ledger; }
+    uint32_t getCoalesced() { return coalesced; }
+    uint32_t getDropped() { return dropped; }
+    uint32_t getDeferred() { return deferred; }
+    
+    int pendingCount() {
+        int n = 0;
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) if (pending[i].used) n++;
+        return n;
+    }
+    
+    bool hasPendingAlert() {
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+            if (pending[i].used && pending[i].priority == LORA_PRIO_ALERT) return true;
+        }
+        return false;
+    }
+    
+    // An alert pop() would hand out right now (retries wait for their backoff)
+    bool hasDueAlert(uint32_t now_ms) {
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+            const Frame& f = pending[i];
+            if (f.used && f.priority == LORA_PRIO_ALERT && (int32_t)(now_ms - f.due_ms) >= 0) return true;
+        }
+        return false;
+    }
+
+private:
+    // Free slot, or evict the oldest less-urgent frame
+    Frame* freeSlot(LoRaPriority priority) {
+        Frame* victim = nullptr;
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+            Frame& f = pending[i];
+            if (!f.used) return &f;
+            
+            if (f.priority > priority &&
+                (!victim || f.priority > victim->priority ||
+                 (f.priority == victim->priority && (int32_t)(f.enqueued_ms - victim->enqueued_ms) < 0))) {
+                victim = &f;
+            }
+        }
+        if (victim) dropped++;
+        return victim;
+    }
+    
+    void expireStale(uint32_t now_ms) {
+        for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+            Frame& f = pending[i];
+            if (f.used && f.priority == LORA_PRIO_ROUTINE &&
+                now_ms - f.enqueued_ms > LORA_ROUTINE_MAX_AGE_MS) {
+                f.used = false;
+                dropped++;
+            }
+        }
+    }
+    
+    uint32_t jitter() {
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % (LORA_TX_JITTER_MS + 1);
+    }
+};
+
+#endif // LORA_SCHEDULER_H
@@ -0,0 +1,322 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MESH RELAY - Managed Flooding over LoRa
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Lets devices out of gateway range reach it through their neighbours
+ * - Every frame is wrapped in a 7-byte mesh header (origin, seq, TTL)
+ * - A node rebroadcasts a frame it has not seen before after a random
+ *   backoff; nodes that heard the sender strongly wait longer, so the
+ *   ones at the edge of its range (which cover new ground) go first
+ * - Managed flood: if MESH_SUPPRESS_COUNT other relays of the same frame
+ *   are overheard during the backoff, our copy is cancelled
+ * - Duplicates are suppressed by a small set-associative (origin, seq) cache
+ * - Relaying stops below MESH_RELAY_MIN_BATT (with hysteresis)
+ * 
+ * LAYOUT:
+ *   [0]    FRAME_MESH
+ *   [1..2] origin device_id
+ *   [3..4] origin sequence number
+ *   [5]    TTL (low nibble) | hops so far (high nibble)
+ *   [6]    LoRaPriority (bits 0-1) | attempt (bits 4-6) | confirm (bit 7)
+ *   [7..]  inner frame (telemetry frame or legacy UAD_Packet)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MESH_RELAY_H
+#define MESH_RELAY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "lora_scheduler.h"
+
+#define MESH_HEADER_LEN    7
+#define MESH_FLAG_CONFIRM  0x80   // Origin expects a FRAME_ACK from the gateway
+
+// Parsed mesh header + inner payload
+struct MeshPacket {
+    uint16_t origin;
+    uint16_t seq;
+    uint8_t ttl;
+    uint8_t hops;
+    LoRaPriority priority;
+    bool confirm;
+    uint8_t attempt;          // 0 = first transmission
+    const uint8_t* payload;
+    size_t length;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DUPLICATE CACHE (origin, seq) - set-associative, LRU within a set
+// ═══════════════════════════════════════════════════════════════════════════
+
+class MeshDupCache {
+private:
+    static const int WAYS = 4;
+    
+    uint32_t keys[MESH_DUP_CACHE_SETS][WAYS];
+    uint32_t stamps[MESH_DUP_CACHE_SETS][WAYS];   // 0 = empty
+    uint32_t clock = 0;
+
+public:
+    MeshDupCache() { clear(); }
+    
+    void clear() {
+        memset(keys, 0, sizeof(keys));
+        memset(stamps, 0, sizeof(stamps));
+        clock = 0;
+    }
+    
+    static uint32_t keyFor(uint16_t origin, uint16_t seq) {
+        return ((uint32_t)origin << 16) | seq;
+    }
+    
+    // True if the key was already cached; inserts it otherwise
+    bool checkAndInsert(uint32_t key) {
+        uint32_t set = (key * 2654435761UL) % MESH_DUP_CACHE_SETS;
+        int victim = 0;
+        
+        for (int w = 0; w < WAYS; w++) {
+            if (stamps[set][w] && keys[set][w] == key) {
+                stamps[set][w] = ++clock;
+                return true;
+            }
+            if (stamps[set][w] < stamps[set][victim]) victim = w;
+        }
+        
+        keys[set][victim] = key;
+        stamps[set][victim] = ++clock;
+        return false;
+    }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// RELAY
+// ═══════════════════════════════════════════════════════════════════════════
+
+class MeshRelay {
+public:
+    // A rebroadcast waiting for its backoff to expire
+    struct PendingRelay {
+        uint8_t data[LORA_MAX_PAYLOAD];
+        uint8_t length;
+        uint32_t key;
+        LoRaPriority priority;
+        uint32_t due_ms;
+        uint8_t heard;            // Copies overheard from other relays
+        bool used;
+    };
+
+private:
+    uint16_t nodeId;
+    uint16_t seq = 0;
+    MeshDupCache cache;
+    PendingRelay pending[MESH_RELAY_QUEUE_LEN];
+    
+    bool relayEnabled = true;
+    uint8_t suppressCount = MESH_SUPPRESS_COUNT;
+    uint32_t rng = 0x9E3779B9;
+    
+    // Statistics
+    uint32_t relayed = 0;
+    uint32_t suppressed = 0;
+    uint32_t duplicates = 0;
+    uint32_t skipped = 0;        // Not relayed: TTL, battery or queue full
+
+public:
+    explicit MeshRelay(uint16_t node_id = DEVICE_ID) : nodeId(node_id) {
+        memset(pending, 0, sizeof(pending));
+    }
+    
+    void seed(uint32_t s) { if (s) rng = s; }
+    
+    // 0 = never suppress (plain flooding)
+    void setSuppressCount(uint8_t count) { suppressCount = count; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // ORIGINATE (wrap one of our own frames)
+    // flags: MESH_FLAG_CONFIRM | (attempt << 4)
+    // Returns the wrapped length, 0 if it does not fit
+    // ───────────────────────────────────────────────────────────────────────
+    
+    size_t wrap(const uint8_t* payload, size_t len, LoRaPriority priority,
+                uint8_t* out, size_t out_max, uint8_t ttl = MESH_DEFAULT_TTL,
+                uint8_t flags = 0) {
+        if (len + MESH_HEADER_LEN > out_max) return 0;
+        
+        uint16_t s = seq++;
+        out[0] = FRAME_MESH;
+        out[1] = nodeId & 0xFF;
+        out[2] = nodeId >> 8;
+        out[3] = s & 0xFF;
+        out[4] = s >> 8;
+        out[5] = ttl & 0x0F;
+        out[6] = (uint8_t)priority | (flags & 0xF0);
+        memcpy(&out[MESH_HEADER_LEN], payload, len);
+        
+        // Our own frame echoed back by a neighbour must not be relayed
+        cache.checkAndInsert(MeshDupCache::keyFor(nodeId, s));
+        return len + MESH_HEADER_LEN;
+    }
+    
+    static bool parse(const uint8_t* data, size_t len, MeshPacket& pkt) {
+        if (len <= MESH_HEADER_LEN || data[0] != FRAME_MESH) return false;
+        
+        pkt.origin = data[1] | (data[2] << 8);
+        pkt.seq = data[3] | (data[4] << 8);
+        pkt.ttl = data[5] & 0x0F;
+        pkt.hops = data[5] >> 4;
+        uint8_t prio = data[6] & 0x03;
+        pkt.priority = (prio <= LORA_PRIO_ROUTINE) ? (LoRaPriority)prio : LORA_PRIO_ROUTINE;
+        pkt.confirm = (data[6] & MESH_FLAG_CONFIRM) != 0;
+        pkt.attempt = (data[6] >> 4) & 0x07;
+        pkt.payload = &data[MESH_HEADER_LEN];
+        pkt.length = len - MESH_HEADER_LEN;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RECEIVE (any mesh frame heard on air)
+    // rssi: stronger = closer to the sender = longer backoff
+    // Returns true the first time a frame is seen (deliver it locally)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool onReceive(const uint8_t* data, size_t len, int16_t rssi, uint32_t now_ms,
+                   MeshPacket* out = nullptr) {
+        MeshPacket pkt;
+        if (!parse(data, len, pkt)) return false;
+        if (out) *out = pkt;
+        
+        uint32_t key = MeshDupCache::keyFor(pkt.origin, pkt.seq);
+        
+        if (cache.checkAndInsert(key)) {
+            duplicates++;
+            
+            // Someone else relayed it: maybe ours is no longer needed
+            PendingRelay* p = findPending(key);
+            if (p && suppressCount && ++p->heard >= suppressCount) {
+                p->used = false;
+                suppressed++;
+            }
+            return false;
+        }
+        
+        if (pkt.origin == nodeId) return false;
+        
+        if (pkt.ttl <= 1 || !relayEnabled) {
+            skipped++;
+            return true;
+        }
+        
+        PendingRelay* slot = freeSlot(pkt.priority);
+        if (!slot) {
+            skipped++;
+            return true;
+        }
+        
+        memcpy(slot->data, data, len);
+        slot->length = (uint8_t)len;
+        slot->data[5] = (uint8_t)((pkt.ttl - 1) | ((pkt.hops + 1) << 4));
+        slot->key = key;
+        slot->priority = pkt.priority;
+        slot->due_ms = now_ms + backoff(rssi, pkt.priority);
+        slot->heard = 0;
+        slot->used = true;
+        return true;
+    }
+    
+    // Stop flooding a frame that reached its destination (e.g. our own ACK)
+    void cancel(uint16_t origin, uint16_t seq) {
+        PendingRelay* p = findPending(MeshDupCache::keyFor(origin, seq));
+        if (p) p->used = false;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // POLL (one relay whose backoff expired, most urgent first)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool pollRelay(uint32_t now_ms, PendingRelay& out) {
+        PendingRelay* best = nullptr;
+        for (int i = 0; i < MESH_RELAY_QUEUE_LEN; i++) {
+            PendingRelay& p = pending[i];
+            if (!p.used || (int32_t)(now_ms - p.due_ms) < 0) continue;
+            if (!best || p.priority < best->priority) best = &p;
+        }
+        if (!best) return false;
+        
+        out = *best;
+        best->used = false;
+        relayed++;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // BATTERY GATE (hysteresis so a node near the limit doesn't flap)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void updateBattery(int battery_pct) {
+        if (relayEnabled && battery_pct < MESH_RELAY_MIN_BATT) {
+            relayEnabled = false;
+            for (int i = 0; i < MESH_RELAY_QUEUE_LEN; i++) pending[i].used = false;
+        } else if (!relayEnabled && battery_pct >= MESH_RELAY_MIN_BATT + 10) {
+            relayEnabled = true;
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool isRelayEnabled() { return relayEnabled; }
+    uint16_t getNodeId() { return nodeId; }
+    uint32_t getRelayed() { return relayed; }
+    uint32_t getSuppressed() { return suppressed; }
+    uint32_t getDuplicates() { return duplicates; }
+    uint32_t getSkipped() { return skipped; }
+    
+    int pendingCount() {
+        int n = 0;
+        for (int i = 0; i < MESH_RELAY_QUEUE_LEN; i++) if (pending[i].used) n++;
+        return n;
+    }
+
+private:
+    PendingRelay* findPending(uint32_t key) {
+        for (int i = 0; i < MESH_RELAY_QUEUE_LEN; i++) {
+            if (pending[i].used && pending[i].key == key) return &pending[i];
+        }
+        return nullptr;
+    }
+    
+    // Free slot, or the least urgent pending relay below this priority
+    PendingRelay* freeSlot(LoRaPriority priority) {
+        PendingRelay* victim = nullptr;
+        for (int i = 0; i < MESH_RELAY_QUEUE_LEN; i++) {
+            PendingRelay& p = pending[i];
+            if (!p.used) return &p;
+            if (p.priority > priority && (!victim || p.priority > victim->priority)) victim = &p;
+        }
+        return victim;
+    }
+    
+    uint32_t backoff(int16_t rssi, LoRaPriority priority) {
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        
+        uint32_t window = (priority == LORA_PRIO_ALERT) ? MESH_RELAY_BACKOFF_MS / 2 : MESH_RELAY_BACKOFF_MS;
+        
+        // -120 dBm (edge of range) → no extra wait, -40 dBm (next door) → +window
+        int32_t strength = rssi + 120;
+        if (strength < 0) strength = 0;
+        if (strength > 80) strength = 80;
+        
+        return (rng % (window + 1)) + (uint32_t)strength * window / 80;
+    }
+};
+
+#endif // MESH_RELAY_H
@@ -0,0 +1,86 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA RX RING - Frame Buffer for Gateway Mode
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Decouples the radio (must be emptied within one packet time) from the
+ * forwarder (serial/WiFi, may stall for tens of ms)
+ * Single producer / single consumer, fixed size, no heap
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef RX_RING_H
+#define RX_RING_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+
+struct RxFrame {
+    uint8_t data[LORA_MAX_PAYLOAD];
+    uint8_t length;
+    int16_t rssi;
+    float snr;
+    uint32_t timestamp_us;    // Latched in the DIO1 ISR
+};
+
+class LoRaRxRing {
+private:
+    RxFrame frames[GATEWAY_RX_RING_LEN];
+    volatile uint16_t head = 0;   // Next write
+    volatile uint16_t tail = 0;   // Next read
+    uint32_t overflows = 0;
+    uint16_t highWater = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // PRODUCER (radio side)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool push(const uint8_t* data, size_t len, int16_t rssi, float snr, uint32_t timestamp_us) {
+        uint16_t next = (head + 1) % GATEWAY_RX_RING_LEN;
+        if (next == tail) {
+            overflows++;
+            return false;
+        }
+        
+        RxFrame& f = frames[head];
+        if (len > sizeof(f.data)) len = sizeof(f.data);
+        memcpy(f.data, data, len);
+        f.length = (uint8_t)len;
+        f.rssi = rssi;
+        f.snr = snr;
+        f.timestamp_us = timestamp_us;
+        head = next;
+        
+        uint16_t depth = count();
+        if (depth > highWater) highWater = depth;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONSUMER (forwarder side): peek, process, then pop
+    // ───────────────────────────────────────────────────────────────────────
+    
+    const RxFrame* peek() const {
+        return (head == tail) ? nullptr : &frames[tail];
+    }
+    
+    void pop() {
+        if (head != tail) tail = (tail + 1) % GATEWAY_RX_RING_LEN;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t count() const {
+        return (head + GATEWAY_RX_RING_LEN - tail) % GATEWAY_RX_RING_LEN;
+    }
+    
+    uint32_t getOverflows() const { return overflows; }
+    uint16_t getHighWater() const { return highWater; }
+};
+
+#endif // RX_RING_H
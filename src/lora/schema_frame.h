@@ -0,0 +1,294 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    SCHEMA FRAME - Bit-Packed Module Telemetry
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Carries the records of any module whose telemetry is described by a
+ * schema in backend/schemas/. backend/schema-codegen.js turns each schema
+ * into a header in src/lora/schemas/ (record struct + encode/decode) and
+ * the matching JS decoder for the backend (lora-frames.js).
+ * 
+ * LAYOUT (little endian, 8-byte header):
+ *   [0]     FRAME_SCHEMA
+ *   [1..2]  device_id
+ *   [3..4]  sequence number
+ *   [5]     schema id
+ *   [6]     schema version
+ *   [7]     record count
+ *   [8..]   records, bit-packed MSB first, last byte zero-padded
+ * 
+ * FIELD TYPES (quantized, no byte alignment between fields):
+ *   bool / enum / uint   fixed width
+ *   scaled               round((v - min) / step) in just enough bits
+ *   varint               zigzag, groups of N bits + continuation bit
+ *   delta                first record of a frame absolute (as scaled),
+ *                        later ones as a varint step from the previous
+ *   when: <bool field>   field only present if that flag is set
+ * 
+ * Deltas only reference earlier records of the same frame, so one lost
+ * frame never corrupts the next.
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef SCHEMA_FRAME_H
+#define SCHEMA_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "telemetry_frame.h"
+
+#define SCHEMA_HEADER_LEN 8
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BIT WRITER (MSB first, never writes past its buffer)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class BitWriter {
+private:
+    uint8_t* buf = nullptr;
+    size_t capacityBits = 0;
+    size_t pos = 0;
+    bool overflow = false;
+
+public:
+    void begin(uint8_t* out, size_t max_bytes) {
+        buf = out;
+        capacityBits = max_bytes * 8;
+        pos = 0;
+        overflow = false;
+        memset(out, 0, max_bytes);
+    }
+    
+    void writeBits(uint32_t v, uint8_t bits) {
+        if (overflow || pos + bits > capacityBits) {
+            overflow = true;
+            return;
+        }
+        while (bits > 0) {
+            uint8_t room = 8 - (pos & 7);
+            uint8_t take = (bits < room) ? bits : room;
+            uint8_t chunk = (uint8_t)((v >> (bits - take)) & ((1u << take) - 1));
+            buf[pos >> 3] |= (uint8_t)(chunk << (room - take));
+            pos += take;
+            bits -= take;
+        }
+    }
+    
+    void writeBool(bool v) { writeBits(v ? 1 : 0, 1); }
+    
+    // Groups of `group` bits, least significant first, each followed by a
+    // continuation bit
+    void writeVarint(uint32_t v, uint8_t group) {
+        do {
+            writeBits(v & ((1u << group) - 1), group);
+            v >>= group;
+            writeBits(v ? 1 : 0, 1);
+        } while (v && !overflow);
+    }
+    
+    void writeScaled(double v, double min, double step, uint32_t max_q, uint8_t bits) {
+        writeBits(quantize(v, min, step, max_q), bits);
+    }
+    
+    // Clamps to [0, max_q]; NaN maps to 0
+    static uint32_t quantize(double v, double min, double step, uint32_t max_q) {
+        double q = (v - min) / step + 0.5;
+        if (!(q >= 0)) return 0;
+        if (q >= (double)max_q) return max_q;
+        return (uint32_t)q;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // ROLLBACK (a record that does not fit is removed again)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    size_t mark() const { return pos; }
+    
+    void rewind(size_t mark_pos) {
+        size_t end = (pos + 7) >> 3;
+        if (mark_pos & 7) buf[mark_pos >> 3] &= (uint8_t)(0xFF << (8 - (mark_pos & 7)));
+        size_t first = (mark_pos + 7) >> 3;
+        if (end > first) memset(&buf[first], 0, end - first);
+        pos = mark_pos;
+        overflow = false;
+    }
+    
+    bool overflowed() const { return overflow; }
+    size_t bitLength() const { return pos; }
+    size_t byteLength() const { return (pos + 7) >> 3; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BIT READER
+// ═══════════════════════════════════════════════════════════════════════════
+
+class BitReader {
+private:
+    const uint8_t* buf = nullptr;
+    size_t lengthBits = 0;
+    size_t pos = 0;
+    bool overrun = false;
+
+public:
+    void begin(const uint8_t* data, size_t len) {
+        buf = data;
+        lengthBits = len * 8;
+        pos = 0;
+        overrun = false;
+    }
+    
+    uint32_t readBits(uint8_t bits) {
+        if (pos + bits > lengthBits) {
+            overrun = true;
+            return 0;
+        }
+        uint32_t v = 0;
+        while (bits > 0) {
+            uint8_t room = 8 - (pos & 7);
+            uint8_t take = (bits < room) ? bits : room;
+            uint8_t chunk = (buf[pos >> 3] >> (room - take)) & ((1u << take) - 1);
+            v = (v << take) | chunk;
+            pos += take;
+            bits -= take;
+        }
+        return v;
+    }
+    
+    bool readBool() { return readBits(1) != 0; }
+    
+    uint32_t readVarint(uint8_t group) {
+        uint32_t v = 0;
+        for (uint8_t shift = 0; shift < 32 && !overrun; shift += group) {
+            v |= readBits(group) << shift;
+            if (!readBits(1)) return v;
+        }
+        overrun = true;   // Overlong
+        return 0;
+    }
+    
+    double readScaled(double min, double step, uint8_t bits) {
+        return min + readBits(bits) * step;
+    }
+    
+    bool overran() const { return overrun; }
+    
+    // Only zero padding may follow the last record
+    bool atEnd() const { return !overrun && lengthBits - pos < 8; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ENCODER (device side)
+// Schema = a generated class from src/lora/schemas/
+// ═══════════════════════════════════════════════════════════════════════════
+
+template <class Schema>
+class SchemaFrameBuilder {
+private:
+    uint8_t buf[LORA_MAX_PAYLOAD];
+    BitWriter bits;
+    typename Schema::State state;
+    uint8_t records = 0;
+
+public:
+    void begin(uint16_t device_id, uint16_t seq, size_t max_len) {
+        size_t limit = (max_len < sizeof(buf)) ? max_len : sizeof(buf);
+        
+        buf[0] = FRAME_SCHEMA;
+        buf[1] = device_id & 0xFF;
+        buf[2] = device_id >> 8;
+        buf[3] = seq & 0xFF;
+        buf[4] = seq >> 8;
+        buf[5] = Schema::ID;
+        buf[6] = Schema::VERSION;
+        buf[7] = 0;
+        
+        bits.begin(&buf[SCHEMA_HEADER_LEN], limit - SCHEMA_HEADER_LEN);
+        state = typename Schema::State();
+        records = 0;
+    }
+    
+    // False when the frame is full: flush it and begin a new one
+    bool add(const typename Schema::Record& rec) {
+        if (records == 255) return false;
+        
+        size_t m = bits.mark();
+        typename Schema::State saved = state;
+        Schema::encode(bits, rec, state);
+        if (bits.overflowed()) {
+            bits.rewind(m);
+            state = saved;
+            return false;
+        }
+        
+        buf[7] = ++records;
+        return true;
+    }
+    
+    const uint8_t* data() const { return buf; }
+    size_t length() const { return SCHEMA_HEADER_LEN + bits.byteLength(); }
+    uint8_t recordCount() const { return records; }
+    bool isEmpty() const { return records == 0; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DECODER (gateway side / host tools)
+// ═══════════════════════════════════════════════════════════════════════════
+
+struct SchemaFrameHeader {
+    uint16_t device_id;
+    uint16_t seq;
+    uint8_t schema_id;
+    uint8_t version;
+    uint8_t record_count;
+};
+
+// Header only, for code that routes frames without knowing the schema
+inline bool parseSchemaHeader(const uint8_t* data, size_t len, SchemaFrameHeader& hdr) {
+    if (len < SCHEMA_HEADER_LEN || data[0] != FRAME_SCHEMA) return false;
+    
+    hdr.device_id = data[1] | (data[2] << 8);
+    hdr.seq = data[3] | (data[4] << 8);
+    hdr.schema_id = data[5];
+    hdr.version = data[6];
+    hdr.record_count = data[7];
+    return true;
+}
+
+template <class Schema>
+class SchemaFrameReader {
+private:
+    BitReader bits;
+    typename Schema::State state;
+    SchemaFrameHeader hdr;
+    uint8_t remaining = 0;
+
+public:
+    // False for another schema or another version of this one
+    bool open(const uint8_t* data, size_t len) {
+        if (!parseSchemaHeader(data, len, hdr)) return false;
+        if (hdr.schema_id != Schema::ID || hdr.version != Schema::VERSION) return false;
+        
+        bits.begin(&data[SCHEMA_HEADER_LEN], len - SCHEMA_HEADER_LEN);
+        state = typename Schema::State();
+        remaining = hdr.record_count;
+        return true;
+    }
+    
+    const SchemaFrameHeader& header() const { return hdr; }
+    
+    // False at end of frame or on malformed data (check isComplete())
+    bool next(typename Schema::Record& rec) {
+        if (remaining == 0) return false;
+        if (!Schema::decode(bits, rec, state) || bits.overran()) return false;
+        remaining--;
+        return true;
+    }
+    
+    bool isComplete() const { return remaining == 0 && bits.atEnd(); }
+};
+
+#endif // SCHEMA_FRAME_H
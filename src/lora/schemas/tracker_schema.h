@@ -0,0 +1,145 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    TRACKER SCHEMA - Generated Telemetry Codec
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * GENERATED by backend/schema-codegen.js from backend/schemas/tracker.json
+ * Do not edit: change the schema (new version for a new layout) and rerun
+ * 
+ * Car GPS tracker (generated_modules/tracker_module.h)
+ * Schema id 1, version 1: 23..142 bits per record
+ * (12+ full records per 222-byte frame)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef TRACKER_SCHEMA_H
+#define TRACKER_SCHEMA_H
+
+#include "../schema_frame.h"
+
+enum TrackerState : uint8_t {
+    TRACKER_STATE_IDLE = 0,
+    TRACKER_STATE_ACTIVE = 1,
+    TRACKER_STATE_MONITORING = 2,
+    TRACKER_STATE_ALERT = 3,
+    TRACKER_STATE_LOW_POWER = 4
+};
+
+struct TrackerRecord {
+    uint8_t state;              // IDLE, ACTIVE, MONITORING, ALERT, LOW_POWER
+    float battery;              // 0..100 step 0.5 [%]
+    bool alert;                 // bool
+    float motion;               // 0..4 step 0.01 [g]
+    bool gps_valid;             // bool
+    double latitude;            // -90..90 step 0.00001, delta [deg], if gps_valid
+    double longitude;           // -180..180 step 0.00001, delta [deg], if gps_valid
+    float speed;                // 0..255 step 0.5 [km/h], if gps_valid
+    float heading;              // 0..360 step 1.5 [deg], if gps_valid
+    bool parked;                // bool
+    double parked_latitude;     // -90..90 step 0.00001, delta [deg], if parked
+    double parked_longitude;    // -180..180 step 0.00001, delta [deg], if parked
+};
+
+class TrackerSchema {
+public:
+    typedef TrackerRecord Record;
+    
+    static const uint8_t ID = 1;
+    static const uint8_t VERSION = 1;
+    
+    // Delta references, reset at the start of every frame
+    struct State {
+        int32_t latitude = 0;
+        int32_t longitude = 0;
+        int32_t parked_latitude = 0;
+        int32_t parked_longitude = 0;
+        bool has_latitude = false;
+        bool has_longitude = false;
+        bool has_parked_latitude = false;
+        bool has_parked_longitude = false;
+    };
+    
+    static void encode(BitWriter& w, const Record& r, State& s) {
+        w.writeBits(r.state, 3);
+        w.writeScaled(r.battery, 0.0, 0.5, 200, 8);
+        w.writeBool(r.alert);
+        w.writeScaled(r.motion, 0.0, 0.01, 400, 9);
+        w.writeBool(r.gps_valid);
+        if (r.gps_valid) {
+            int32_t latitude = (int32_t)BitWriter::quantize(r.latitude, -90.0, 0.00001, 18000000);
+            if (s.has_latitude) w.writeVarint(Varint::zigzag(latitude - s.latitude), 7);
+            else w.writeBits((uint32_t)latitude, 25);
+            s.latitude = latitude;
+            s.has_latitude = true;
+            int32_t longitude = (int32_t)BitWriter::quantize(r.longitude, -180.0, 0.00001, 36000000);
+            if (s.has_longitude) w.writeVarint(Varint::zigzag(longitude - s.longitude), 7);
+            else w.writeBits((uint32_t)longitude, 26);
+            s.longitude = longitude;
+            s.has_longitude = true;
+            w.writeScaled(r.speed, 0.0, 0.5, 510, 9);
+            w.writeScaled(r.heading, 0.0, 1.5, 240, 8);
+        }
+        w.writeBool(r.parked);
+        if (r.parked) {
+            int32_t parked_latitude = (int32_t)BitWriter::quantize(r.parked_latitude, -90.0, 0.00001, 18000000);
+            if (s.has_parked_latitude) w.writeVarint(Varint::zigzag(parked_latitude - s.parked_latitude), 7);
+            else w.writeBits((uint32_t)parked_latitude, 25);
+            s.parked_latitude = parked_latitude;
+            s.has_parked_latitude = true;
+            int32_t parked_longitude = (int32_t)BitWriter::quantize(r.parked_longitude, -180.0, 0.00001, 36000000);
+            if (s.has_parked_longitude) w.writeVarint(Varint::zigzag(parked_longitude - s.parked_longitude), 7);
+            else w.writeBits((uint32_t)parked_longitude, 26);
+            s.parked_longitude = parked_longitude;
+            s.has_parked_longitude = true;
+        }
+    }
+    
+    // False on an out-of-range enum (wrong schema or corrupt frame)
+    static bool decode(BitReader& rd, Record& r, State& s) {
+        r.state = (uint8_t)rd.readBits(3);
+        if (r.state >= 5) return false;
+        r.battery = (float)rd.readScaled(0.0, 0.5, 8);
+        r.alert = rd.readBool();
+        r.motion = (float)rd.readScaled(0.0, 0.01, 9);
+        r.gps_valid = rd.readBool();
+        if (r.gps_valid) {
+            int32_t latitude = s.has_latitude ? s.latitude + Varint::unzigzag(rd.readVarint(7))
+                                              : (int32_t)rd.readBits(25);
+            s.latitude = latitude;
+            s.has_latitude = true;
+            r.latitude = (double)(-90.0 + latitude * 0.00001);
+            int32_t longitude = s.has_longitude ? s.longitude + Varint::unzigzag(rd.readVarint(7))
+                                                : (int32_t)rd.readBits(26);
+            s.longitude = longitude;
+            s.has_longitude = true;
+            r.longitude = (double)(-180.0 + longitude * 0.00001);
+            r.speed = (float)rd.readScaled(0.0, 0.5, 9);
+            r.heading = (float)rd.readScaled(0.0, 1.5, 8);
+        } else {
+            r.latitude = 0;
+            r.longitude = 0;
+            r.speed = 0;
+            r.heading = 0;
+        }
+        r.parked = rd.readBool();
+        if (r.parked) {
+            int32_t parked_latitude = s.has_parked_latitude ? s.parked_latitude + Varint::unzigzag(rd.readVarint(7))
+                                                            : (int32_t)rd.readBits(25);
+            s.parked_latitude = parked_latitude;
+            s.has_parked_latitude = true;
+            r.parked_latitude = (double)(-90.0 + parked_latitude * 0.00001);
+            int32_t parked_longitude = s.has_parked_longitude ? s.parked_longitude + Varint::unzigzag(rd.readVarint(7))
+                                                              : (int32_t)rd.readBits(26);
+            s.parked_longitude = parked_longitude;
+            s.has_parked_longitude = true;
+            r.parked_longitude = (double)(-180.0 + parked_longitude * 0.00001);
+        } else {
+            r.parked_latitude = 0;
+            r.parked_longitude = 0;
+        }
+        return !rd.overran();
+    }
+};
+
+#endif // TRACKER_SCHEMA_H
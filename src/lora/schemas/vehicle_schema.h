@@ -0,0 +1,64 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    VEHICLE SCHEMA - Generated Telemetry Codec
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * GENERATED by backend/schema-codegen.js from backend/schemas/vehicle.json
+ * Do not edit: change the schema (new version for a new layout) and rerun
+ * 
+ * Vehicle driving pattern (src/modules/vehicle_module.h)
+ * Schema id 2, version 1: 12..20 bits per record
+ * (85+ full records per 222-byte frame)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef VEHICLE_SCHEMA_H
+#define VEHICLE_SCHEMA_H
+
+#include "../schema_frame.h"
+
+struct VehicleRecord {
+    float vibration;     // 0..8 step 0.01 [g]
+    bool idle;           // bool
+    bool crash;          // bool
+    float crash_peak;    // 0..16 step 0.1 [g], if crash
+};
+
+class VehicleSchema {
+public:
+    typedef VehicleRecord Record;
+    
+    static const uint8_t ID = 2;
+    static const uint8_t VERSION = 1;
+    
+    // Delta references, reset at the start of every frame
+    struct State {
+    };
+    
+    static void encode(BitWriter& w, const Record& r, State& s) {
+        (void)s;
+        w.writeScaled(r.vibration, 0.0, 0.01, 800, 10);
+        w.writeBool(r.idle);
+        w.writeBool(r.crash);
+        if (r.crash) {
+            w.writeScaled(r.crash_peak, 0.0, 0.1, 160, 8);
+        }
+    }
+    
+    // False on an out-of-range enum (wrong schema or corrupt frame)
+    static bool decode(BitReader& rd, Record& r, State& s) {
+        (void)s;
+        r.vibration = (float)rd.readScaled(0.0, 0.01, 10);
+        r.idle = rd.readBool();
+        r.crash = rd.readBool();
+        if (r.crash) {
+            r.crash_peak = (float)rd.readScaled(0.0, 0.1, 8);
+        } else {
+            r.crash_peak = 0;
+        }
+        return !rd.overran();
+    }
+};
+
+#endif // VEHICLE_SCHEMA_H
@@ -0,0 +1,357 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    TDMA SYNC - Beacon-Timed Uplink Slots
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Optional slotted uplink for dense single-hop sites (TDMA_ENABLED):
+ * - The gateway beacons once per superframe: its clock, the slot layout
+ *   and a few explicit slot reassignments
+ * - A device's slot is DEVICE_ID % slot_count unless the beacon moves it
+ *   (two active devices landing on the same slot)
+ * - Local clock drift against the gateway is measured over a long beacon
+ *   baseline and corrected when predicting slot times, so missed beacons
+ *   don't walk us into a neighbour's slot
+ * - Guard time widens with the time since the last beacon heard
+ * - TDMA_MAX_MISSED_BEACONS silent superframes: sync is dropped and the
+ *   device falls back to listen-before-talk
+ * 
+ * SUPERFRAME (gateway clock):
+ *   | beacon | slot 0 | slot 1 | ... | slot n-1 | contention | next beacon
+ *   0        first_slot_ms                                    period_ms
+ * 
+ * BEACON LAYOUT:
+ *   [0]      FRAME_BEACON
+ *   [1..4]   superframe start, gateway clock (ms)
+ *   [5..6]   superframe period (ms)
+ *   [7..8]   slot length (ms)
+ *   [9..10]  slot count
+ *   [11..12] slot 0 offset from superframe start (ms)
+ *   [13]     beacon TX start after superframe start (ms)
+ *   [14]     override count n
+ *   [15..]   n x (device_id, slot), u16 each
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef TDMA_SYNC_H
+#define TDMA_SYNC_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../include/config.h"
+#include "../include/types.h"
+
+#define TDMA_BEACON_HEADER_LEN  15
+#define TDMA_OVERRIDE_LEN       4
+#define TDMA_BEACON_MAX_LEN     (TDMA_BEACON_HEADER_LEN + TDMA_MAX_OVERRIDES * TDMA_OVERRIDE_LEN)
+
+struct TdmaSlotOverride {
+    uint16_t device_id;
+    uint16_t slot;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// BEACON (schedule for one superframe)
+// ═══════════════════════════════════════════════════════════════════════════
+
+struct TdmaBeacon {
+    uint32_t superframe_ms;
+    uint16_t period_ms;
+    uint16_t slot_ms;
+    uint16_t slot_count;
+    uint16_t first_slot_ms;
+    uint8_t tx_delay_ms;
+    uint8_t override_count;
+    TdmaSlotOverride overrides[TDMA_MAX_OVERRIDES];
+    
+    TdmaBeacon() : superframe_ms(0), period_ms(TDMA_BEACON_PERIOD_MS), slot_ms(TDMA_SLOT_MS),
+                   slot_count(TDMA_SLOT_COUNT), first_slot_ms(TDMA_FIRST_SLOT_MS),
+                   tx_delay_ms(0), override_count(0) {}
+    
+    size_t encode(uint8_t* out, size_t max) const {
+        size_t len = TDMA_BEACON_HEADER_LEN + override_count * TDMA_OVERRIDE_LEN;
+        if (len > max) return 0;
+        
+        out[0] = FRAME_BEACON;
+        put16(&out[1], superframe_ms & 0xFFFF);
+        put16(&out[3], superframe_ms >> 16);
+        put16(&out[5], period_ms);
+        put16(&out[7], slot_ms);
+        put16(&out[9], slot_count);
+        put16(&out[11], first_slot_ms);
+        out[13] = tx_delay_ms;
+        out[14] = override_count;
+        for (uint8_t i = 0; i < override_count; i++) {
+            put16(&out[TDMA_BEACON_HEADER_LEN + i * TDMA_OVERRIDE_LEN], overrides[i].device_id);
+            put16(&out[TDMA_BEACON_HEADER_LEN + i * TDMA_OVERRIDE_LEN + 2], overrides[i].slot);
+        }
+        return len;
+    }
+    
+    bool decode(const uint8_t* data, size_t len) {
+        if (len < TDMA_BEACON_HEADER_LEN || data[0] != FRAME_BEACON) return false;
+        
+        uint8_t n = data[14];
+        if (n > TDMA_MAX_OVERRIDES || len < (size_t)(TDMA_BEACON_HEADER_LEN + n * TDMA_OVERRIDE_LEN)) return false;
+        
+        uint16_t period = get16(&data[5]);
+        uint16_t slot = get16(&data[7]);
+        uint16_t count = get16(&data[9]);
+        uint16_t first = get16(&data[11]);
+        
+        // A schedule that doesn't fit its superframe is not usable
+        if (slot == 0 || count == 0 || (uint32_t)first + (uint32_t)slot * count > period) return false;
+        
+        superframe_ms = get16(&data[1]) | ((uint32_t)get16(&data[3]) << 16);
+        period_ms = period;
+        slot_ms = slot;
+        slot_count = count;
+        first_slot_ms = first;
+        tx_delay_ms = data[13];
+        override_count = n;
+        for (uint8_t i = 0; i < n; i++) {
+            overrides[i].device_id = get16(&data[TDMA_BEACON_HEADER_LEN + i * TDMA_OVERRIDE_LEN]);
+            overrides[i].slot = get16(&data[TDMA_BEACON_HEADER_LEN + i * TDMA_OVERRIDE_LEN + 2]) % count;
+        }
+        return true;
+    }
+    
+    uint16_t slotFor(uint16_t device_id) const {
+        for (uint8_t i = 0; i < override_count; i++) {
+            if (overrides[i].device_id == device_id) return overrides[i].slot;
+        }
+        return device_id % slot_count;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PLAN (gateway): the lowest device_id keeps a contested home slot, the
+    // others move to the next free slot while overrides last
+    // Returns the number of devices left sharing a slot
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t plan(const uint16_t* ids, uint16_t count) {
+        static const uint16_t FREE = 0xFFFF;
+        uint16_t owner[TDMA_SLOT_COUNT];
+        uint16_t slots = (slot_count < TDMA_SLOT_COUNT) ? slot_count : TDMA_SLOT_COUNT;
+        uint16_t shared = 0;
+        
+        override_count = 0;
+        for (uint16_t s = 0; s < slots; s++) owner[s] = FREE;
+        
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t home = ids[i] % slot_count;
+            if (home < slots && (owner[home] == FREE || ids[i] < owner[home])) owner[home] = ids[i];
+        }
+        
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t home = ids[i] % slot_count;
+            if (home < slots && owner[home] == ids[i]) continue;
+            
+            int target = -1;
+            for (uint16_t step = 1; step < slots && target < 0; step++) {
+                uint16_t s = (home + step) % slots;
+                if (owner[s] == FREE) target = s;
+            }
+            if (target < 0 || override_count >= TDMA_MAX_OVERRIDES) {
+                shared++;
+                continue;
+            }
+            owner[target] = ids[i];
+            overrides[override_count].device_id = ids[i];
+            overrides[override_count].slot = (uint16_t)target;
+            override_count++;
+        }
+        return shared;
+    }
+
+private:
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+    
+    static uint16_t get16(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DEVICE SYNC (local clock ↔ gateway clock, our slot)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class TdmaSync {
+private:
+    static const uint32_t DRIFT_BASELINE_MS = 60000;   // Min span for a drift estimate
+    static const int32_t DRIFT_LIMIT_PPM = 500;        // Anything beyond is a bad sample
+    
+    uint16_t deviceId;
+    TdmaBeacon schedule;
+    uint16_t slot = 0;
+    bool synced = false;
+    
+    // Latest beacon: superframe start on both clocks
+    uint32_t lastGw = 0;
+    uint32_t lastLocal = 0;
+    
+    // Drift baseline (first beacon of the current measurement span)
+    uint32_t anchorGw = 0;
+    uint32_t anchorLocal = 0;
+    int32_t driftPpm = 0;          // + = local clock runs fast
+    
+    // Statistics
+    uint32_t beacons = 0;
+    uint32_t resyncs = 0;
+    int32_t lastErrorMs = 0;       // Predicted vs actual superframe start
+    uint32_t maxErrorMs = 0;
+
+public:
+    explicit TdmaSync(uint16_t device_id = DEVICE_ID) : deviceId(device_id) {}
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // BEACON RECEIVED
+    // local_start_ms: local clock when the beacon started on air
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool onBeacon(const uint8_t* data, size_t len, uint32_t local_start_ms) {
+        TdmaBeacon b;
+        if (!b.decode(data, len)) return false;
+        
+        uint32_t gw = b.superframe_ms;
+        uint32_t local = local_start_ms - b.tx_delay_ms;
+        
+        // Gateway restarted, or silent for too long to trust the baseline
+        bool restart = !synced;
+        if (synced) {
+            int32_t step = (int32_t)(gw - lastGw);
+            if (step <= 0 || step > (int32_t)(TDMA_MAX_MISSED_BEACONS + 1) * schedule.period_ms) {
+                restart = true;
+                resyncs++;
+            } else {
+                lastErrorMs = (int32_t)(local - gwToLocal(gw));
+                uint32_t err = (lastErrorMs < 0) ? -lastErrorMs : lastErrorMs;
+                if (err > maxErrorMs) maxErrorMs = err;
+            }
+        }
+        
+        if (restart) {
+            anchorGw = gw;
+            anchorLocal = local;
+        } else {
+            uint32_t span = gw - anchorGw;
+            if (span >= DRIFT_BASELINE_MS) {
+                int32_t diff = (int32_t)((local - anchorLocal) - span);
+                int32_t ppm = (int32_t)((int64_t)diff * 1000000 / span);
+                if (ppm > -DRIFT_LIMIT_PPM && ppm < DRIFT_LIMIT_PPM) driftPpm = ppm;
+            }
+            
+            // Restart the span now and then so the estimate follows
+            // temperature; driftPpm is kept until the new span is long enough
+            if (span >= 10 * DRIFT_BASELINE_MS) {
+                anchorGw = gw;
+                anchorLocal = local;
+            }
+        }
+        
+        schedule = b;
+        slot = b.slotFor(deviceId);
+        lastGw = gw;
+        lastLocal = local;
+        synced = true;
+        beacons++;
+        return true;
+    }
+    
+    // Drops sync after TDMA_MAX_MISSED_BEACONS silent superframes
+    bool isSynced(uint32_t now_ms) {
+        if (synced && (int32_t)(now_ms - lastLocal) > (int32_t)(TDMA_MAX_MISSED_BEACONS + 1) * schedule.period_ms) {
+            synced = false;
+        }
+        return synced;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CLOCK CONVERSION (drift-corrected, relative to the last beacon)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t gwToLocal(uint32_t gw_ms) {
+        int32_t d = (int32_t)(gw_ms - lastGw);
+        return lastLocal + d + (int32_t)((int64_t)d * driftPpm / 1000000);
+    }
+    
+    uint32_t localToGw(uint32_t local_ms) {
+        int32_t d = (int32_t)(local_ms - lastLocal);
+        return lastGw + d - (int32_t)((int64_t)d * driftPpm / 1000000);
+    }
+    
+    // Residual error grows with the time since the last beacon
+    uint32_t guardMs(uint32_t now_ms) {
+        int32_t since = (int32_t)(now_ms - lastLocal);
+        if (since < 0) since = 0;
+        return TDMA_GUARD_MS + (uint32_t)((uint64_t)since * TDMA_MAX_DRIFT_PPM / 1000000);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // SLOTS (local clock)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Our slot in the current superframe, or the next one if it is over
+    void slotWindow(uint32_t now_ms, uint32_t& start_ms, uint32_t& end_ms) {
+        uint32_t sf = superframeAt(now_ms);
+        uint32_t s = sf + schedule.first_slot_ms + (uint32_t)slot * schedule.slot_ms;
+        if ((int32_t)(localToGw(now_ms) - (s + schedule.slot_ms)) >= 0) s += schedule.period_ms;
+        
+        start_ms = gwToLocal(s);
+        end_ms = gwToLocal(s + schedule.slot_ms);
+    }
+    
+    // A frame of this airtime fits a slot at all (else: contention)
+    bool fitsSlot(uint32_t airtime_ms, uint32_t now_ms) {
+        return airtime_ms + 2 * guardMs(now_ms) <= schedule.slot_ms;
+    }
+    
+    // Inside our slot with room for the whole frame plus the end guard
+    bool canTransmit(uint32_t now_ms, uint32_t airtime_ms) {
+        uint32_t start, end;
+        slotWindow(now_ms, start, end);
+        uint32_t guard = guardMs(now_ms);
+        
+        if ((int32_t)(now_ms - (start + guard)) < 0) return false;
+        return (int32_t)(end - guard - now_ms) >= (int32_t)airtime_ms;
+    }
+    
+    // Radio must be in RX: beacon window (unless that beacon was heard)
+    bool shouldListen(uint32_t now_ms) {
+        if (!synced) return true;
+        
+        uint32_t guard = guardMs(now_ms);
+        uint32_t sf = superframeAt(now_ms);
+        
+        // Current superframe's beacon not heard yet (late or lost)
+        if (sf != lastGw && localToGw(now_ms) - sf < (uint32_t)schedule.first_slot_ms + guard) return true;
+        
+        // Next beacon about to start
+        return (int32_t)(gwToLocal(sf + schedule.period_ms) - guard - now_ms) <= 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // GETTERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t getSlot() { return slot; }
+    int32_t getDriftPpm() { return driftPpm; }
+    uint32_t getBeacons() { return beacons; }
+    uint32_t getResyncs() { return resyncs; }
+    int32_t getLastErrorMs() { return lastErrorMs; }
+    uint32_t getMaxErrorMs() { return maxErrorMs; }
+    const TdmaBeacon& getSchedule() { return schedule; }
+
+private:
+    // Start (gateway clock) of the superframe containing now_ms
+    uint32_t superframeAt(uint32_t now_ms) {
+        int32_t since = (int32_t)(localToGw(now_ms) - lastGw);
+        if (since < 0) return lastGw;
+        return lastGw + (uint32_t)since / schedule.period_ms * schedule.period_ms;
+    }
+};
+
+#endif // TDMA_SYNC_H
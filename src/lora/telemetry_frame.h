@@ -0,0 +1,229 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    TELEMETRY FRAME - Batched LoRa Uplink Format
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Packs many readings into one LoRa frame instead of one UAD_Packet each
+ * 
+ * LAYOUT (little endian, 14-byte header):
+ *   [0]     FRAME_TELEMETRY (type + version)
+ *   [1..2]  device_id
+ *   [3..4]  sequence number
+ *   [5]     context_id
+ *   [6]     battery_pct
+ *   [7..10] t0: device millis() of the first sample
+ *   [11..12] sample period (ms)
+ *   [13]    entry count
+ *   entries:
+ *     sample: varint(zigzag(val - prev) << 1)       → 1 byte typical
+ *     event:  varint(1) + status byte + varint(val)  → at the current slot
+ * 
+ * Sample i is at t0 + i * period. Frames grow up to the SF payload limit.
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/config.h"
+#include "../include/types.h"
+
+#define TELEMETRY_HEADER_LEN 14
+
+// ═══════════════════════════════════════════════════════════════════════════
+// VARINT HELPERS (LEB128 + zigzag)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class Varint {
+public:
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+    
+    static size_t size(uint32_t v) {
+        size_t n = 1;
+        while (v >= 0x80) { v >>= 7; n++; }
+        return n;
+    }
+    
+    static size_t write(uint8_t* out, uint32_t v) {
+        size_t n = 0;
+        while (v >= 0x80) {
+            out[n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        out[n++] = (uint8_t)v;
+        return n;
+    }
+    
+    // Returns bytes consumed, 0 on truncated/overlong input
+    static size_t read(const uint8_t* in, size_t avail, uint32_t& v) {
+        v = 0;
+        for (size_t i = 0; i < avail && i < 5; i++) {
+            v |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+            if (!(in[i] & 0x80)) return i + 1;
+        }
+        return 0;
+    }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// ENCODER (device side)
+// ═══════════════════════════════════════════════════════════════════════════
+
+class TelemetryFrameBuilder {
+private:
+    uint8_t buf[LORA_MAX_PAYLOAD];
+    size_t len = 0;
+    size_t limit = 0;
+    uint16_t prevVal = 0;
+    uint8_t entries = 0;
+
+public:
+    void begin(uint16_t device_id, uint16_t seq, uint8_t context_id, uint8_t battery,
+               uint32_t t0_ms, uint16_t period_ms, size_t max_len) {
+        limit = (max_len < sizeof(buf)) ? max_len : sizeof(buf);
+        
+        buf[0] = FRAME_TELEMETRY;
+        buf[1] = device_id & 0xFF;
+        buf[2] = device_id >> 8;
+        buf[3] = seq & 0xFF;
+        buf[4] = seq >> 8;
+        buf[5] = context_id;
+        buf[6] = battery;
+        buf[7] = t0_ms & 0xFF;
+        buf[8] = (t0_ms >> 8) & 0xFF;
+        buf[9] = (t0_ms >> 16) & 0xFF;
+        buf[10] = t0_ms >> 24;
+        buf[11] = period_ms & 0xFF;
+        buf[12] = period_ms >> 8;
+        buf[13] = 0;
+        
+        len = TELEMETRY_HEADER_LEN;
+        prevVal = 0;
+        entries = 0;
+    }
+    
+    // False when the frame is full: flush it and begin a new one
+    bool addSample(uint16_t val) {
+        int32_t delta = (int32_t)val - (int32_t)prevVal;
+        uint32_t tag = Varint::zigzag(delta) << 1;
+        if (entries == 255 || len + Varint::size(tag) > limit) return false;
+        
+        len += Varint::write(&buf[len], tag);
+        prevVal = val;
+        buf[13] = ++entries;
+        return true;
+    }
+    
+    bool addEvent(uint8_t status, uint16_t val) {
+        if (entries == 255 || len + 1 + 1 + Varint::size(val) > limit) return false;
+        
+        buf[len++] = 0x01;   // Varint(1): event tag
+        buf[len++] = status;
+        len += Varint::write(&buf[len], val);
+        buf[13] = ++entries;
+        return true;
+    }
+    
+    void setBattery(uint8_t battery) { buf[6] = battery; }
+    
+    const uint8_t* data() const { return buf; }
+    size_t length() const { return len; }
+    uint8_t entryCount() const { return entries; }
+    bool isEmpty() const { return entries == 0; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// DECODER (gateway side)
+// ═══════════════════════════════════════════════════════════════════════════
+
+struct TelemetryFrameHeader {
+    uint16_t device_id;
+    uint16_t seq;
+    uint8_t context_id;
+    uint8_t battery_pct;
+    uint32_t t0_ms;
+    uint16_t period_ms;
+    uint8_t entry_count;
+};
+
+struct TelemetryEntry {
+    bool is_event;
+    uint8_t status;       // Events only
+    uint16_t value;
+    uint32_t time_ms;     // Device clock
+};
+
+class TelemetryFrameReader {
+private:
+    const uint8_t* buf = nullptr;
+    size_t len = 0;
+    size_t pos = 0;
+    uint8_t remaining = 0;
+    uint16_t prevVal = 0;
+    uint32_t slot = 0;
+    TelemetryFrameHeader hdr;
+
+public:
+    bool open(const uint8_t* data, size_t length) {
+        if (length < TELEMETRY_HEADER_LEN || data[0] != FRAME_TELEMETRY) return false;
+        
+        buf = data;
+        len = length;
+        hdr.device_id = data[1] | (data[2] << 8);
+        hdr.seq = data[3] | (data[4] << 8);
+        hdr.context_id = data[5];
+        hdr.battery_pct = data[6];
+        hdr.t0_ms = (uint32_t)data[7] | ((uint32_t)data[8] << 8) |
+                    ((uint32_t)data[9] << 16) | ((uint32_t)data[10] << 24);
+        hdr.period_ms = data[11] | (data[12] << 8);
+        hdr.entry_count = data[13];
+        
+        pos = TELEMETRY_HEADER_LEN;
+        remaining = hdr.entry_count;
+        prevVal = 0;
+        slot = 0;
+        return true;
+    }
+    
+    const TelemetryFrameHeader& header() const { return hdr; }
+    
+    // False at end of frame or on malformed data (check isComplete())
+    bool next(TelemetryEntry& e) {
+        if (remaining == 0) return false;
+        
+        uint32_t tag;
+        size_t n = Varint::read(&buf[pos], len - pos, tag);
+        if (n == 0) return false;
+        pos += n;
+        
+        e.time_ms = hdr.t0_ms + slot * hdr.period_ms;
+        
+        if (tag & 1) {
+            uint32_t val;
+            if (pos >= len) return false;
+            e.is_event = true;
+            e.status = buf[pos++];
+            n = Varint::read(&buf[pos], len - pos, val);
+            if (n == 0) return false;
+            pos += n;
+            e.value = (uint16_t)val;
+        } else {
+            e.is_event = false;
+            e.status = STATUS_OK;
+            prevVal = (uint16_t)(prevVal + Varint::unzigzag(tag >> 1));
+            e.value = prevVal;
+            slot++;
+        }
+        
+        remaining--;
+        return true;
+    }
+    
+    bool isComplete() const { return remaining == 0 && pos == len; }
+};
+
+#endif // TELEMETRY_FRAME_H
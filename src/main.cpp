@@ -11,7 +11,10 @@
  * 3. A container for ONE "Active Module" at a time
  * 
  * To change the device purpose, the AI generates a new "current_module.h"
- * and recompiles this shell.
+ * and recompiles this shell, or a bytecode module (backend/vm_modules) is
+ * loaded over BLE and runs in its place without a reflash. With the module
+ * registry (MODULE_REGISTRY_ENABLED) all compiled-in modules share the
+ * image and the context picks the active one at runtime.
  * 
  * ═══════════════════════════════════════════════════════════════════════════
  */
@@ -26,6 +29,18 @@
 #include "managers/power_manager.h"
 #include "managers/ble_manager.h"
 #include "managers/display_manager.h" // Added Display Manager
+#include "managers/capture_manager.h"
+#include "managers/ble_ota_manager.h"
+#include "managers/vm_module_manager.h"
+#include "managers/sampling_policy.h"
+#include "ble/ble_command.h"
+#include "lora/lora_scheduler.h"
+#include "lora/lora_adr.h"
+#include "lora/telemetry_frame.h"
+#include "lora/schema_frame.h"
+#include "lora/mesh_relay.h"
+#include "lora/confirmed_uplink.h"
+#include "lora/tdma_sync.h"
 
 // ═══════════════════════════════════════════════════════════════════════════
 // GLOBAL SERVICES
@@ -36,6 +51,18 @@ LoRaManager lora;
 PowerManager power;
 BLEManager ble;
 DisplayManager display; // Global OLED instance
+LoRaScheduler loraScheduler; // Priority + duty-cycle gate in front of the radio
+LoRaADR loraAdr;             // TX power from link reports (SF stays LORA_SF)
+MeshRelay mesh;              // Wraps our frames, relays our neighbours'
+ConfirmedUplink confirmed;   // ACK / retry tracking for alert frames
+TdmaSync tdma;               // Slot timing from gateway beacons (TDMA_ENABLED)
+CaptureManager capture(sensor, ble); // Raw IMU recording over the BLE stream
+BleOtaManager bleOta(ble);           // Firmware images from the phone
+VmModuleManager vmModule;            // Bytecode module swapped in over BLE
+SamplingPolicy sampling;             // IMU rate and loop sleep from the module
+
+// Context the active module reports under (UAD_Packet.context_id)
+ContextType activeContext = CTX_UNKNOWN;
 
 // WiFi Credentials (TODO: Move to secrets or BLE-provisioning)
 const char* WIFI_SSID = "YOUR_WIFI_SSID";
@@ -44,27 +71,470 @@ const char* BACKEND_URL = "http://192.168.1.100:3000"; // Your PC IP
 // ═══════════════════════════════════════════════════════════════════════════
 // DYNAMIC MODULE INJECTION
 // ═══════════════════════════════════════════════════════════════════════════
+#if MODULE_REGISTRY_ENABLED
+// Every purpose in one image: switchModule() activates the one for a
+// context in microseconds, calls stay statically bound (no vtable)
+#include "modules/helmet_module.h"
+#include "modules/bicycle_module.h"
+#include "modules/asset_module.h"
+#include "modules/vehicle_module.h"
+#include "modules/module_registry.h"
+
+using CurrentModule = ModuleRegistry<MODULE_REGISTRY_ARENA ? ModuleStorage::ARENA : ModuleStorage::RESIDENT,
+                                     HelmetModule, BicycleModule, AssetModule, VehicleModule>;
+#else
 // The AI overwrites this file before compilation
 #include "current_module.h"
+#endif
+
+#include "modules/module_contract.h"
 
 // ⚠️ ARCHITECTURE CONSTRAINT:
 // The file "current_module.h" MUST define a class named "CurrentModule"
 // or a typedef: "using CurrentModule = SpecificClassName;"
 // This allows main.cpp to be completely agnostic of what logic is running.
+// Its methods are checked here (src/modules/module_contract.h), and the
+// backend runs the same checks before a build (backend/module-contract.js)
+static_assert(ModuleContract<CurrentModule>::value, "CurrentModule meets the module contract");
 
 CurrentModule currentModule;
 
+// Module registries report and switch the context they run under
+template <typename M>
+auto moduleContext(M& m, ContextType fallback, int) -> decltype(m.getContext()) {
+    return m.getContext();
+}
+template <typename M>
+ContextType moduleContext(M&, ContextType fallback, long) { return fallback; }
+
+template <typename M>
+auto moduleCanSwitch(M& m, ContextType ctx, int) -> decltype(m.activateContext(ctx), BleCmdStatus()) {
+    return M::indexOf(ctx) != M::NONE ? BLE_CMD_OK : BLE_CMD_BAD_VALUE;
+}
+template <typename M>
+BleCmdStatus moduleCanSwitch(M&, ContextType, long) { return BLE_CMD_UNSUPPORTED; }
+
+template <typename M>
+auto moduleSwitch(M& m, ContextType ctx, int) -> decltype(m.activateContext(ctx)) {
+    return m.activateContext(ctx);
+}
+template <typename M>
+bool moduleSwitch(M&, ContextType, long) { return false; }
+
+// ContextClassifier result or MODULE_SELECT, between two updates (loop())
+void switchModule(ContextType ctx) {
+    uint32_t start = micros();
+    bool ok = moduleSwitch(currentModule, ctx, 0);
+    uint32_t elapsed = micros() - start;
+    if (ok) Serial.printf("[OS] 🔀 Module for context %u active after %lu us\n", (unsigned)ctx, (unsigned long)elapsed);
+    else Serial.printf("[OS] ⚠️ No module for context %u\n", (unsigned)ctx);
+}
+
+// A loaded bytecode module runs instead of CurrentModule (no reflash)
+bool vmActive() {
+    return vmModule.isRunning();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// LORA CALLBACKS
+// ═══════════════════════════════════════════════════════════════════════════
+
+// Our confirmed frame just left the radio: open its ACK window (queueing
+// and LBT backoff before it are not taken out of ALERT_ACK_WINDOW_MS)
+void notifyTransmit(const uint8_t* data, size_t len) {
+    MeshPacket pkt;
+    if (!MeshRelay::parse(data, len, pkt) || !pkt.confirm || pkt.origin != DEVICE_ID) return;
+    if (pkt.length < 5 || pkt.payload[0] != FRAME_TELEMETRY) return;
+    
+    uint16_t seq = pkt.payload[3] | (pkt.payload[4] << 8);
+    confirmed.onTransmit(seq, millis());
+}
+
+void onLoRaTxDone(const LoRaTxResult& result) {
+    power.chargeTx(result.airtime_us, lora.getTxPower());
+    if (result.success) {
+        notifyTransmit(result.data, result.length);
+        Serial.printf("[LORA] ✅ TX %d bytes, airtime %lu us, queued %lu ms\n",
+                      result.length, (unsigned long)result.airtime_us, millis() - result.queued_ms);
+    } else {
+        Serial.printf("[LORA] ❌ TX of %d bytes failed\n", result.length);
+    }
+}
+
+// True if the frame was an ACK for one of our alerts
+bool handleAck(const uint8_t* data, size_t len) {
+    uint16_t device_id, seq;
+    if (!ConfirmedUplink::parseAck(data, len, device_id, seq)) return false;
+    if (device_id != DEVICE_ID) return false;
+    
+    if (confirmed.onAck(seq, millis())) {
+        loraAdr.onUplinkResult(true);
+        Serial.printf("[LORA] ✅ Alert #%u confirmed (avg latency %lu ms)\n",
+                      seq, (unsigned long)confirmed.getStats().averageLatencyMs());
+    }
+    return true;
+}
+
+// Mesh traffic goes through the relay (ACKs for us stop flooding there).
+// Direct downlinks from the gateway are link-quality samples for ADR.
+void onLoRaRxDone(const uint8_t* data, size_t len, int16_t rssi, float snr) {
+    if (len > 0 && data[0] == FRAME_BEACON) {
+        tdma.onBeacon(data, len, lora.getRxStartMs());
+        loraAdr.onLinkReport(rssi, snr);
+        return;
+    }
+    if (len > 0 && data[0] == FRAME_MESH) {
+        MeshPacket pkt;
+        if (mesh.onReceive(data, len, rssi, millis(), &pkt) && handleAck(pkt.payload, pkt.length)) {
+            mesh.cancel(pkt.origin, pkt.seq);
+            if (pkt.hops == 0) loraAdr.onLinkReport(rssi, snr);
+        }
+        return;
+    }
+    handleAck(data, len);
+    loraAdr.onLinkReport(rssi, snr);
+}
+
+// Push ADR decisions to the radio (power only: the SF is the gateway's)
+void applyAdr() {
+    if (!loraAdr.takeChange()) return;
+    
+    lora.setTxPower(loraAdr.getTxPower());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// TELEMETRY UPLINK
+// ═══════════════════════════════════════════════════════════════════════════
+
+// Readings are batched: one frame carries a header plus delta-encoded
+// samples and events instead of one UAD_Packet per reading
+TelemetryFrameBuilder telemetryBatch;
+bool batchOpen = false;
+uint16_t uplinkSeq = 0;
+uint8_t energyDegrade = 0;   // Telemetry intervals x (1 << level) when runtime runs low
+
+// Modules with a telemetry schema send their samples as bit-packed
+// FRAME_SCHEMA batches (src/lora/schema_frame.h) on the same cadence;
+// events and alerts stay in the telemetry batch
+void (*flushSchema)() = nullptr;   // The open schema batch, if any
+
+template <class Schema>
+SchemaFrameBuilder<Schema>& schemaBatch() {
+    static SchemaFrameBuilder<Schema> batch;
+    return batch;
+}
+
+template <class Schema>
+void flushSchemaBatch() {
+    SchemaFrameBuilder<Schema>& batch = schemaBatch<Schema>();
+    flushSchema = nullptr;
+    if (batch.isEmpty()) return;
+    
+    uint8_t frame[LORA_MAX_PAYLOAD];
+    size_t len = mesh.wrap(batch.data(), batch.length(), LORA_PRIO_ROUTINE, frame, sizeof(frame));
+    loraScheduler.submit(frame, len, LORA_PRIO_ROUTINE, millis());
+}
+
+template <class Schema>
+void addSchemaRecord(const typename Schema::Record& rec) {
+    SchemaFrameBuilder<Schema>& batch = schemaBatch<Schema>();
+    if (flushSchema != &flushSchemaBatch<Schema>) {
+        if (flushSchema) flushSchema();   // Another module's schema
+        batch.begin(DEVICE_ID, uplinkSeq++, LoRaAirtime::maxPayload(LORA_SF) - MESH_HEADER_LEN);
+        flushSchema = &flushSchemaBatch<Schema>;
+    }
+    if (batch.add(rec)) return;
+    
+    // Full: send it, the record opens the next one
+    flushSchema();
+    batch.begin(DEVICE_ID, uplinkSeq++, LoRaAirtime::maxPayload(LORA_SF) - MESH_HEADER_LEN);
+    flushSchema = &flushSchemaBatch<Schema>;
+    batch.add(rec);
+}
+
+// typedef XSchema Schema + getSchemaRecord(XSchema::Record&): true if sent
+template <typename M>
+auto moduleSchemaSample(M& m, int) -> decltype(m.getSchemaRecord(std::declval<typename M::Schema::Record&>()), bool()) {
+    typename M::Schema::Record rec;
+    m.getSchemaRecord(rec);
+    addSchemaRecord<typename M::Schema>(rec);
+    return true;
+}
+template <typename M>
+bool moduleSchemaSample(M&, long) { return false; }
+
+// A registry asks its active module, a single CurrentModule is asked directly
+template <typename M>
+auto currentSchemaSample(M& reg, int) -> decltype(reg.activateContext(CTX_UNKNOWN), bool()) {
+    bool sent = false;
+    reg.dispatch([&](auto& m) { sent = moduleSchemaSample(m, 0); });
+    return sent;
+}
+template <typename M>
+bool currentSchemaSample(M& m, long) { return moduleSchemaSample(m, 0); }
+
+TelemetryFrameBuilder& openBatch() {
+    if (!batchOpen) {
+        // Sized for LORA_SF (mesh header included)
+        telemetryBatch.begin(DEVICE_ID, uplinkSeq++, (uint8_t)activeContext,
+                             power.getBatteryPercent(), millis(), TELEMETRY_SAMPLE_MS << energyDegrade,
+                             LoRaAirtime::maxPayload(LORA_SF) - MESH_HEADER_LEN);
+        batchOpen = true;
+    }
+    return telemetryBatch;
+}
+
+void flushBatch(LoRaPriority prio) {
+    if (flushSchema) flushSchema();
+    if (!batchOpen || telemetryBatch.isEmpty()) return;
+    
+    telemetryBatch.setBattery(power.getBatteryPercent());
+    
+    // Alerts are confirmed: tracked until the gateway ACKs their sequence
+    uint8_t flags = 0;
+    if (prio == LORA_PRIO_ALERT) {
+        uint16_t seq = telemetryBatch.data()[3] | (telemetryBatch.data()[4] << 8);
+        confirmed.track(telemetryBatch.data(), telemetryBatch.length(), seq, millis());
+        flags = MESH_FLAG_CONFIRM;
+    }
+    
+    uint8_t frame[LORA_MAX_PAYLOAD];
+    size_t len = mesh.wrap(telemetryBatch.data(), telemetryBatch.length(), prio,
+                           frame, sizeof(frame), MESH_DEFAULT_TTL, flags);
+    loraScheduler.submit(frame, len, prio, millis());
+    batchOpen = false;
+}
+
+void addTelemetrySample(uint16_t val) {
+    if (!openBatch().addSample(val)) {
+        flushBatch(LORA_PRIO_ROUTINE);
+        openBatch().addSample(val);
+    }
+}
+
+void addTelemetryEvent(StatusCode status, uint16_t val) {
+    if (!openBatch().addEvent(status, val)) {
+        flushBatch(LORA_PRIO_ROUTINE);
+        openBatch().addEvent(status, val);
+    }
+}
+
+// Retransmit unconfirmed alerts (fresh mesh seq so relays forward it again,
+// same telemetry seq so the gateway forwards it only once)
+void serviceConfirmed() {
+    ConfirmedUplink::Action action;
+    if (!confirmed.poll(millis(), action)) return;
+    
+    loraAdr.onUplinkResult(false);
+    
+    if (action.type == ConfirmedUplink::ACTION_GIVE_UP) {
+        Serial.printf("[LORA] ❌ Alert #%u not confirmed after %d attempts\n",
+                      action.seq, action.attempt);
+        return;
+    }
+    
+    uint8_t frame[LORA_MAX_PAYLOAD];
+    size_t len = mesh.wrap(action.data, action.length, LORA_PRIO_ALERT, frame, sizeof(frame),
+                           MESH_DEFAULT_TTL, MESH_FLAG_CONFIRM | (action.attempt << 4));
+    loraScheduler.submit(frame, len, LORA_PRIO_ALERT, millis(), 0, action.delay_ms);
+    Serial.printf("[LORA] 🔁 Alert #%u retry %d in %lu ms\n",
+                  action.seq, action.attempt, (unsigned long)action.delay_ms);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// PHONE COMMANDS (binary, src/ble/ble_command.h)
+// Handlers run in the BLE task: they check and hand work to loop()
+// ═══════════════════════════════════════════════════════════════════════════
+
+volatile bool calibrateRequested = false;
+volatile bool selectRequested = false;
+volatile ContextType selectContext = CTX_UNKNOWN;
+
+// PARAM_SET / PARAM_GET: the module may be mid-swap, loop() applies and replies
+volatile bool paramRequested = false;
+volatile uint8_t paramOpcode = BLE_CMD_PARAM_GET;
+volatile uint8_t paramId = 0;
+volatile int32_t paramValue = 0;
+
+// Modules may offer bool setParam(id, value) / getParam(id, value&)
+template <typename M>
+auto moduleSetParam(M& m, uint8_t id, int32_t value, int) -> decltype(m.setParam(id, value), BleCmdStatus()) {
+    return m.setParam(id, value) ? BLE_CMD_OK : BLE_CMD_BAD_VALUE;
+}
+template <typename M>
+BleCmdStatus moduleSetParam(M&, uint8_t, int32_t, long) { return BLE_CMD_UNSUPPORTED; }
+
+template <typename M>
+auto moduleGetParam(M& m, uint8_t id, int32_t& value, int) -> decltype(m.getParam(id, value), BleCmdStatus()) {
+    return m.getParam(id, value) ? BLE_CMD_OK : BLE_CMD_BAD_VALUE;
+}
+template <typename M>
+BleCmdStatus moduleGetParam(M&, uint8_t, int32_t&, long) { return BLE_CMD_UNSUPPORTED; }
+
+BleCmdStatus cmdPing(const BleCommand& cmd, BleReply& reply) {
+    reply.putBytes(cmd.payload, cmd.length);
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdGetInfo(const BleCommand& cmd, BleReply& reply) {
+    reply.put8(BLE_CMD_PROTOCOL_VERSION);
+    reply.put16(DEVICE_ID);
+    reply.put8((uint8_t)activeContext);
+    reply.put8((capture.isActive() ? 0x01 : 0x00) | (bleOta.isActive() ? 0x02 : 0x00));
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus requestParam(uint8_t opcode, uint8_t id, int32_t value) {
+    if (paramRequested) return BLE_CMD_BUSY;
+    paramOpcode = opcode;
+    paramId = id;
+    paramValue = value;
+    paramRequested = true;
+    return BLE_CMD_DEFERRED;
+}
+
+BleCmdStatus cmdParamSet(const BleCommand& cmd, BleReply& reply) {
+    return requestParam(BLE_CMD_PARAM_SET, cmd.u8(0), cmd.i32(1));
+}
+
+BleCmdStatus cmdParamGet(const BleCommand& cmd, BleReply& reply) {
+    return requestParam(BLE_CMD_PARAM_GET, cmd.u8(0), 0);
+}
+
+// loop(): the queued PARAM_SET / PARAM_GET, answered on RX
+void applyParamRequest() {
+    uint8_t data[4];
+    BleReply reply(data, sizeof(data));
+    BleCmdStatus status;
+    if (paramOpcode == BLE_CMD_PARAM_SET) {
+        status = vmActive() ? moduleSetParam(vmModule, paramId, paramValue, 0)
+                            : moduleSetParam(currentModule, paramId, paramValue, 0);
+    } else {
+        int32_t value = 0;
+        status = vmActive() ? moduleGetParam(vmModule, paramId, value, 0)
+                            : moduleGetParam(currentModule, paramId, value, 0);
+        if (status == BLE_CMD_OK) reply.put32((uint32_t)value);
+    }
+    ble.sendCommandReply(paramOpcode, status, data, reply.length());
+}
+
+BleCmdStatus cmdCalibrate(const BleCommand& cmd, BleReply& reply) {
+    if (capture.isActive() || bleOta.isActive()) return BLE_CMD_BUSY;
+    calibrateRequested = true;   // ~1 s of sampling, done in loop()
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdCaptureStart(const BleCommand& cmd, BleReply& reply) {
+    if (capture.isActive() || bleOta.isActive()) return BLE_CMD_BUSY;
+    uint16_t odr = cmd.u16(0);
+    if (odr > 1000) return BLE_CMD_BAD_VALUE;
+    capture.requestStart(odr ? odr : CAPTURE_ODR_HZ, cmd.length > 2 && (cmd.u8(2) & 0x01));
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdCaptureStop(const BleCommand& cmd, BleReply& reply) {
+    if (!capture.isActive()) return BLE_CMD_BAD_VALUE;
+    capture.requestStop();
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdOtaBegin(const BleCommand& cmd, BleReply& reply) {
+    if (capture.isActive()) return BLE_CMD_BUSY;
+    if (cmd.length == 36) return bleOta.requestBegin(cmd.u32(0), &cmd.payload[4]);
+    if (cmd.length == 41) return bleOta.requestBegin(cmd.u32(0), &cmd.payload[4], cmd.u8(36), cmd.u32(37));
+    if (cmd.length < 42 || cmd.length != 42 + cmd.u8(41)) return BLE_CMD_BAD_LENGTH;
+    return bleOta.requestBegin(cmd.u32(0), &cmd.payload[4], cmd.u8(36), cmd.u32(37),
+                               &cmd.payload[42], cmd.u8(41));
+}
+
+BleCmdStatus cmdOtaStatus(const BleCommand& cmd, BleReply& reply) {
+    bleOta.status(reply);
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdOtaEnd(const BleCommand& cmd, BleReply& reply) {
+    return bleOta.requestEnd();
+}
+
+BleCmdStatus cmdOtaActivate(const BleCommand& cmd, BleReply& reply) {
+    return bleOta.requestActivate();
+}
+
+BleCmdStatus cmdOtaAbort(const BleCommand& cmd, BleReply& reply) {
+    return bleOta.requestAbort();
+}
+
+BleCmdStatus cmdOtaBase(const BleCommand& cmd, BleReply& reply) {
+    return bleOta.base(reply);
+}
+
+BleCmdStatus cmdModuleWrite(const BleCommand& cmd, BleReply& reply) {
+    return vmModule.write(cmd.u16(0), &cmd.payload[2], cmd.length - 2);
+}
+
+BleCmdStatus cmdModuleCommit(const BleCommand& cmd, BleReply& reply) {
+    return vmModule.commit(cmd.u16(0), reply);
+}
+
+BleCmdStatus cmdModuleUnload(const BleCommand& cmd, BleReply& reply) {
+    return vmModule.requestUnload();
+}
+
+BleCmdStatus cmdModuleInfo(const BleCommand& cmd, BleReply& reply) {
+    vmModule.info(reply);
+    return BLE_CMD_OK;
+}
+
+BleCmdStatus cmdModuleSelect(const BleCommand& cmd, BleReply& reply) {
+    ContextType ctx = (ContextType)cmd.u8(0);
+    BleCmdStatus status = moduleCanSwitch(currentModule, ctx, 0);
+    if (status != BLE_CMD_OK) return status;
+    if (selectRequested) return BLE_CMD_BUSY;
+    selectContext = ctx;
+    selectRequested = true;
+    return BLE_CMD_OK;
+}
+
+// Image data on the OTA characteristic (BLE task)
+void onOtaPacket(const uint8_t* data, size_t len) {
+    bleOta.onPacket(data, len);
+}
+
+// opcode, payload length min / max, handler
+const BleCommandSpec COMMANDS[] = {
+    { BLE_CMD_PING,          0, 32, cmdPing },
+    { BLE_CMD_GET_INFO,      0, 0,  cmdGetInfo },
+    { BLE_CMD_PARAM_SET,     5, 5,  cmdParamSet },
+    { BLE_CMD_PARAM_GET,     1, 1,  cmdParamGet },
+    { BLE_CMD_CALIBRATE,     0, 0,  cmdCalibrate },
+    { BLE_CMD_CAPTURE_START, 2, 3,  cmdCaptureStart },
+    { BLE_CMD_CAPTURE_STOP,  0, 0,  cmdCaptureStop },
+    { BLE_CMD_OTA_BEGIN,     36, 42 + OTA_BEGIN_SIG_MAX, cmdOtaBegin },
+    { BLE_CMD_OTA_STATUS,    0, 0,  cmdOtaStatus },
+    { BLE_CMD_OTA_END,       0, 0,  cmdOtaEnd },
+    { BLE_CMD_OTA_ACTIVATE,  0, 0,  cmdOtaActivate },
+    { BLE_CMD_OTA_ABORT,     0, 0,  cmdOtaAbort },
+    { BLE_CMD_OTA_BASE,      0, 0,  cmdOtaBase },
+    { BLE_CMD_MODULE_WRITE,  3, 242, cmdModuleWrite },
+    { BLE_CMD_MODULE_COMMIT, 2, 2,  cmdModuleCommit },
+    { BLE_CMD_MODULE_UNLOAD, 0, 0,  cmdModuleUnload },
+    { BLE_CMD_MODULE_INFO,   0, 0,  cmdModuleInfo },
+    { BLE_CMD_MODULE_SELECT, 1, 1,  cmdModuleSelect },
+};
+
+BleCommandDispatcher commands(COMMANDS, sizeof(COMMANDS) / sizeof(COMMANDS[0]));
+
 // ═══════════════════════════════════════════════════════════════════════════
 // OTA UPDATE LOGIC
 // ═══════════════════════════════════════════════════════════════════════════
 
 void checkForUpdates() {
     if (WiFi.status() != WL_CONNECTED) return;
-
+    
     HTTPClient http;
     http.begin(String(BACKEND_URL) + "/api/firmware/check?device_id=" + String(DEVICE_ID));
     int code = http.GET();
-
+    
     if (code == 200) {
         String payload = http.getString();
         // If update available... logic here
@@ -81,11 +551,11 @@ void checkForUpdates() {
 void setup() {
     Serial.begin(DEBUG_BAUD);
     delay(1000); // safety delay
-
+    
     Serial.println("\n\n╔════════════════════════════════════════════════╗");
     Serial.println("║         UAD: ADAPTIVE SHELL OS v2.0            ║");
     Serial.println("╚════════════════════════════════════════════════╝");
-
+    
     // 1. Initialize Hardware Abstraction Layer
     Serial.println("[OS] 🛠️ Initializing Hardware...");
     
@@ -98,19 +568,40 @@ void setup() {
         while(1) delay(100);
     }
     
+#if MODULE_BATCH_ENABLED
+    sensor.beginStream(MODULE_BATCH_ODR_HZ);   // Every sample reaches the module, in bursts
+#endif
     power.begin();
+    power.setLoad(RAIL_SENSOR, ENERGY_IMU_MA);
     lora.begin();
+    lora.setTxCallback(onLoRaTxDone);
+    lora.setRxCallback(onLoRaRxDone);
+    lora.setIrqWake(PowerManager::wakeFromISR);
+    power.enableRadioWake(LORA_DIO1);
+    loraScheduler.seed(esp_random());
+    mesh.seed(esp_random());
+    confirmed.seed(esp_random());
+    lora.getLbt().seed(esp_random());
+#if TDMA_ENABLED
+    lora.setTdma(&tdma);
+#endif
+    lora.startReceive();  // Listen between frames for neighbours to relay
     ble.begin("UAD-Device");
-
+    ble.setCommandDispatcher(&commands);
+    ble.setEventHandler(PowerManager::wake);
+    ble.setOtaHandler(onOtaPacket);
+    if (!bleOta.begin()) Serial.println("[OS] ⚠️ BLE OTA task not started");
+    
     // 2. Connect to Connectivity Layer (Optional)
     // Serial.println("[OS] 📡 Connecting to WiFi...");
     // WiFi.begin(WIFI_SSID, WIFI_PASS); 
     // (Skipping blocking wait to ensure device works offline)
-
+    
     // 3. Initialize The Active Module
     Serial.println("[OS] 🚀 Booting Active Module...");
     currentModule.init();
-
+    vmModule.begin();    // Runs instead if a bytecode module was kept in flash
+    
     Serial.println("[OS] ✅ Boot Complete. Handing control to Module.\n");
 }
 
@@ -121,45 +612,199 @@ void setup() {
 void loop() {
     // 1. System Maintenance
     ble.update();
+    capture.update();  // Raw IMU frames first: they have the tightest budget
+    bleOta.update();
+    vmModule.update();   // Module swap between two updates
+    if (selectRequested) {
+        switchModule(selectContext);
+        selectRequested = false;
+    }
+    if (paramRequested) {
+        applyParamRequest();
+        paramRequested = false;
+    }
+    if (calibrateRequested) {
+        calibrateRequested = false;
+        // capture.update() may just have started a capture: it owns the sensor now
+        if (capture.isActive() || bleOta.isActive()) {
+            Serial.println("[OS] ⚠️ Calibration skipped, capture or OTA running");
+        } else {
+            sensor.calibrate();
+        }
+    }
+    lora.update();  // Async radio state machine (never blocks)
     
     // 2. Read Fresh Data
     SensorData data;
     sensor.readSensorData(data); // Fill struct with Accel/Gyro/Temp
-
+    
+    // Live IMU chart: queued at a fixed rate while the phone is subscribed,
+    // BLEManager sends them in batches (paused during a raw capture)
+    static unsigned long lastImu = 0;
+    const unsigned long imuPeriod = 1000 / BLE_IMU_RATE_HZ;
+    if (ble.isStreaming() && millis() - lastImu >= imuPeriod) {
+        ble.pushImu(data);
+        // Keep the rate exact, but don't replay a stall
+        lastImu = (millis() - lastImu >= 2 * imuPeriod) ? millis() : lastImu + imuPeriod;
+    }
+    
     // Wake Screen on Motion (Simple threshold > 1.2g or < 0.8g)
     float totalG = sqrt(data.accel_x*data.accel_x + data.accel_y*data.accel_y + data.accel_z*data.accel_z)/9.81;
     if (totalG > 1.2 || totalG < 0.8) {
         display.wake();
     }
-
+    power.registerMotion(fabs(totalG - 1.0f));
+    
     // 3. Run Active Module Logic
-    // The device IS the module now. No switching.
-    currentModule.update(data);
+    // The device IS the module now: the compiled-in one, or a bytecode
+    // module loaded over BLE (falls back here if it faults)
+    static ContextType nativeContext = activeContext;
+    bool useVm = vmActive();
+    activeContext = useVm ? vmModule.getContext() : moduleContext(currentModule, nativeContext, 0);
+    static unsigned long lastModuleUpdate = 0;
+    if (sensor.isStreaming()) {
+        // The module's interval sets the FIFO rate and how long the loop
+        // sleeps between bursts; a shock brings the full rate back
+        uint32_t interval = (SAMPLING_ADAPTIVE_ENABLED && !useVm) ? moduleSampleInterval(currentModule) : 0;
+        bool rateChanged = sampling.plan(interval, millis());
+        if (rateChanged || sampling.batchDue(millis())) {
+            // FIFO samples since the last batch, one call per burst
+            SensorData burst[MODULE_BATCH_MAX];
+            size_t n;
+            do {
+                n = sensor.readBurst(burst, MODULE_BATCH_MAX);
+                if (n == 0) break;
+                if (SamplingPolicy::isShock(burst, n)) sampling.trigger(millis());
+                if (useVm) {
+                    for (size_t i = 0; i < n; i++) vmModule.update(burst[i]);
+                } else {
+                    moduleUpdateBatch(currentModule, burst, n);
+                }
+            } while (n == MODULE_BATCH_MAX);
+            sampling.batchDone(millis());
+            if (rateChanged) sensor.setStreamRate(sampling.getOdr());
+        }
+    } else if (useVm) vmModule.update(data);
+    else if (millis() - lastModuleUpdate >= moduleSampleInterval(currentModule)) {
+        currentModule.update(data);   // As often as the module asks (every loop by default)
+        lastModuleUpdate = millis();
+    }
     
     // Auto-dim check
     display.checkPowerSave();
-
+    power.setLoad(RAIL_DISPLAY, display.screenOn ? ENERGY_DISPLAY_MA : 0);
+    
     // 4. Handle System-Level Telemetry (LoRa/BLE)
+    TelemetryData telem = useVm ? vmModule.getTelemetry() : currentModule.getTelemetry();
+    
+    // Alerts bypass the telemetry timer: on every status change the event
+    // is appended and the batch (with its history) goes out right away
+    static StatusCode lastStatus = STATUS_OK;
+    if (telem.status != lastStatus) {
+        if (telem.status != STATUS_OK) {
+            addTelemetryEvent(telem.status, telem.sensor_val);
+            flushBatch(LoRaScheduler::priorityFor(telem.status));
+            sampling.trigger(millis());   // Full rate while the alert plays out
+        }
+        power.setMode(telem.status != STATUS_OK ? POWER_ALERT : POWER_FULL);
+        lastStatus = telem.status;
+    }
+    if (ble.isConnected() || sampling.isBoosted()) power.registerActivity();
+    power.update();   // FULL <-> IDLE on inactivity / motion (clock per mode)
+    
+    // Battery runtime running low: sample and report less often. The open
+    // batch goes out first so its period stays right
+    uint8_t degrade = power.getDegradeLevel();
+    if (degrade != energyDegrade) {
+        flushBatch(LORA_PRIO_ROUTINE);
+        energyDegrade = degrade;
+        Serial.printf("[ENERGY] %.0f h left: telemetry every %lu s\n", power.getRemainingHours(),
+                      (unsigned long)((TELEMETRY_INTERVAL_MS << energyDegrade) / 1000));
+    }
+    
+    static unsigned long lastSample = 0;
+    if (millis() - lastSample >= (TELEMETRY_SAMPLE_MS << energyDegrade)) {
+        bool schema = !useVm && currentSchemaSample(currentModule, 0);
+        if (!schema) addTelemetrySample(telem.sensor_val);
+        lastSample = millis();
+    }
+    
     static unsigned long lastTx = 0;
-    if (millis() - lastTx > 5000) {
-        TelemetryData telem = currentModule.getTelemetry();
+    if (millis() - lastTx > (TELEMETRY_INTERVAL_MS << energyDegrade)) {
+        // Routine report (jittered by the scheduler)
+        flushBatch(LORA_PRIO_ROUTINE);
         
-        // Inject system stats (Battery)
-        uint8_t batt = power.getBatteryPercent();
-
         // Broadcast current state
         if (ble.isConnected()) {
-             // ble.sendTelemetry(...) 
+            ble.sendTelemetry((uint8_t)activeContext, telem.status, telem.sensor_val,
+                              power.getBatteryPercent());
         }
         
         // Log for debug
-        currentModule.printDebug();
+        if (useVm) vmModule.printDebug();
+        else currentModule.printDebug();
+        if (ble.isConnected()) ble.printStatus();
+        capture.printStatus();
+        bleOta.printStatus();
+        power.printProfile();
+        power.printEnergy();
+        if (sensor.isStreaming()) {
+            Serial.printf("[SAMPLE] %u Hz, batch %lu ms (%lu samples)%s, %lu wakeups, %lu triggers\n",
+                          sampling.getOdr(), (unsigned long)sampling.getPeriod(),
+                          (unsigned long)sampling.getWatermark(), sampling.isBoosted() ? " boosted" : "",
+                          (unsigned long)sampling.getWakeups(), (unsigned long)sampling.getTriggers());
+        }
+        
+        const ConfirmStats& alerts = confirmed.getStats();
+        if (alerts.tracked > 0) {
+            Serial.printf("[LORA] Alerts: %lu confirmed, %lu failed, %lu retries, latency %lu/%lu/%lu ms\n",
+                          (unsigned long)alerts.delivered, (unsigned long)alerts.failed,
+                          (unsigned long)alerts.retries, (unsigned long)alerts.latency_min_ms,
+                          (unsigned long)alerts.averageLatencyMs(), (unsigned long)alerts.latency_max_ms);
+        }
         
         lastTx = millis();
     }
     
+    // Mesh: rebroadcasts whose backoff expired go through the same
+    // duty-cycle gate as our own frames (no extra jitter)
+    MeshRelay::PendingRelay relay;
+    if (mesh.pollRelay(millis(), relay)) {
+        loraScheduler.submit(relay.data, relay.length, relay.priority, millis(), 0, 0);
+    }
+    
+    serviceConfirmed();
+    
+    // Battery: one filtered ADC reading per BATTERY_CHECK_INT_MS, every
+    // getBatteryPercent() in between is the cached value
+    if (power.serviceBattery(millis())) {
+        mesh.updateBattery(power.getBatteryPercent());
+    }
+    
+    // Hand the radio one frame at a time so an alert never queues behind
+    // more than the frame already on air. A TDMA frame waiting for its slot
+    // is passed: alerts contend right away instead of waiting a superframe
+    bool radioFree = !lora.isBusy();
+    if (radioFree) applyAdr();  // Only between frames, never mid-TX
+    
+    if (radioFree || (loraScheduler.hasDueAlert(millis()) && lora.getQueuedFrames() < LORA_TX_QUEUE_LEN)) {
+        LoRaScheduler::Frame frame;
+        if (loraScheduler.pop(millis(), LORA_FREQ, frame)) {
+            lora.queueFrame(frame.data, frame.length,
+                            frame.priority == LORA_PRIO_ALERT ? LORA_TX_CONTEND : LORA_TX_SCHEDULED);
+        }
+    }
+    
     // 5. Check for OTA (Periodically or on BLE Command)
     // ...
-
-    delay(10); // Stability
+    
+    // 6. Sleep until the next batch is due. Only this task waits (BLE,
+    // capture and OTA have their own); short polls while the radio, a
+    // phone or a queued frame needs the loop. With no task runnable the
+    // CPU light-sleeps until the batch timer, a radio IRQ or a BLE event
+    bool busy = !sensor.isStreaming() || lora.isBusy() || ble.isConnected() || capture.isActive() ||
+                bleOta.isActive() || loraScheduler.pendingCount() > 0 || mesh.pendingCount() > 0 ||
+                confirmed.pendingCount() > 0;
+    power.holdAwake(lora.isBusy() || capture.isActive() || bleOta.isActive());
+    power.idle(sampling.sleepMs(millis(), busy));
 }
@@ -0,0 +1,74 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BATTERY FILTER - Timed, Filtered Battery Readings
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * The battery voltage as every consumer sees it, read once per timer:
+ * - due(): one reading per BATTERY_CHECK_INT_MS (the first one at once).
+ *   PowerManager only powers the divider (BAT_READ_CTRL) for that burst,
+ *   so the 390k / 100k divider does not drain the cell in between
+ * - median(): BATT_ADC_SAMPLES conversions, median kept. A radio TX or a
+ *   display refresh during the burst spikes a few samples, not the middle
+ * - add(): EMA over readings (BATT_VOLTAGE_ALPHA), the cached value
+ * No Arduino calls: the host tests run it as is
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BATTERY_FILTER_H
+#define BATTERY_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/config.h"
+
+class BatteryFilter {
+private:
+    float volts = 0;
+    bool sampled = false;
+    uint32_t lastRead = 0;
+    uint32_t readings = 0;
+
+public:
+    // Median of n samples (sorts in place, n small)
+    static uint32_t median(uint32_t* mv, size_t n) {
+        for (size_t i = 1; i < n; i++) {
+            uint32_t v = mv[i];
+            size_t j = i;
+            while (j > 0 && mv[j - 1] > v) {
+                mv[j] = mv[j - 1];
+                j--;
+            }
+            mv[j] = v;
+        }
+        return n ? mv[n / 2] : 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // READINGS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool due(uint32_t now_ms) {
+        return !sampled || now_ms - lastRead >= BATTERY_CHECK_INT_MS;
+    }
+    
+    // A new reading (volts at the cell): filtered value
+    float add(float v, uint32_t now_ms) {
+        volts = sampled ? volts + BATT_VOLTAGE_ALPHA * (v - volts) : v;
+        sampled = true;
+        lastRead = now_ms;
+        readings++;
+        return volts;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATUS (cached, no ADC)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool hasReading() { return sampled; }
+    float getVolts() { return volts; }
+    uint32_t getLastRead() { return lastRead; }
+    uint32_t getReadings() { return readings; }
+};
+
+#endif // BATTERY_FILTER_H
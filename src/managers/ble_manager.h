@@ -7,6 +7,23 @@
  * Phone acts as internet gateway for AI features
  * LoRa used only for UAD-to-UAD mesh communication
  * 
+ * Characteristics:
+ * - RX: binary commands from the phone, replies notified back on it
+ *   (src/ble/ble_command.h), dispatched in the write callback
+ * - TX: JSON messages (AI / module requests, telemetry for old dashboards)
+ * - STREAM: binary telemetry + batched IMU samples (src/ble/ble_stream.h).
+ *   While the phone is subscribed the link asks for a short connection
+ *   interval, afterwards it falls back to a slow one with slave latency.
+ *   During a raw capture (CaptureManager) the live IMU batches pause and
+ *   the capture frames (src/ble/capture_stream.h) use the characteristic
+ * - OTA: firmware image writes + ACK/NACK/RESULT notifications
+ *   (src/ble/ota_transfer.h), handed to BleOtaManager; a transfer gets
+ *   the shortest connection interval
+ * 
+ * Security (BLE_SECURE): RX and OTA, and their notification descriptors,
+ * need an encrypted link bonded with the BLE_PASSKEY passkey. The phone's
+ * OS pairs on the first write; STREAM and TX stay readable without it
+ * 
  * ═══════════════════════════════════════════════════════════════════════════
  */
 
@@ -17,23 +34,60 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <BLESecurity.h>
+#include <esp_gap_ble_api.h>
+#include "../ble/ble_stream.h"
+#include "../ble/ble_command.h"
 
 // UUIDs for UAD BLE Service
 #define SERVICE_UUID           "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define CHARACTERISTIC_UUID_TX "beb5483e-36e1-4688-b7f5-ea07361b26a8"  // Device → Phone
 #define CHARACTERISTIC_UUID_RX "beb5483e-36e1-4688-b7f5-ea07361b26a9"  // Phone → Device
+#define CHARACTERISTIC_UUID_STREAM "beb5483e-36e1-4688-b7f5-ea07361b26aa"  // Device → Phone (binary)
+#define CHARACTERISTIC_UUID_OTA "beb5483e-36e1-4688-b7f5-ea07361b26ab"  // Phone → Device (image)
+
+#define BLE_MAX_NOTIFY_PER_UPDATE 4   // Stream notifications handed to the stack per loop
 
 class BLEManager {
 private:
     BLEServer* pServer = nullptr;
     BLECharacteristic* pTxCharacteristic = nullptr;
     BLECharacteristic* pRxCharacteristic = nullptr;
+    BLECharacteristic* pStreamCharacteristic = nullptr;
+    BLE2902* pStreamCccd = nullptr;
+    BLE2902* pRxCccd = nullptr;
+    BLECharacteristic* pOtaCharacteristic = nullptr;
+    BLE2902* pOtaCccd = nullptr;
     
     bool deviceConnected = false;
     bool oldDeviceConnected = false;
     
-    // Callbacks
-    void (*onDataReceived)(String data) = nullptr;
+    // Link (set from the BLE task in the server callbacks)
+    uint16_t connId = 0;
+    esp_bd_addr_t peerAddr;
+    volatile uint16_t mtu = 23;
+    
+    // Binary stream
+    BleStreamPacker stream;
+    uint8_t streamBuf[BLE_MTU - 3];
+    bool streaming = false;
+    bool capturing = false;      // Capture frames own the characteristic
+    uint32_t congested = 0;
+    uint32_t statusSent = 0;
+    
+    // Commands (written by the BLE task)
+    BleCommandDispatcher* dispatcher = nullptr;
+    uint8_t replyBuf[BLE_MTU - 3];
+    volatile uint32_t cmdWrites = 0;
+    volatile uint32_t cmdTotalUs = 0;
+    volatile uint32_t cmdMaxUs = 0;
+    
+    // OTA image writes (BLE task → BleOtaManager)
+    void (*otaHandler)(const uint8_t* data, size_t len) = nullptr;
+    bool otaMode = false;
+    
+    // Connect / disconnect / command (BLE task): loop() should look now
+    void (*eventHandler)() = nullptr;
     
     // Server callbacks
     class ServerCallbacks: public BLEServerCallbacks {
@@ -41,14 +95,27 @@ private:
     public:
         ServerCallbacks(BLEManager* mgr) : manager(mgr) {}
         
-        void onConnect(BLEServer* pServer) {
+        void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+            manager->connId = param->connect.conn_id;
+            memcpy(manager->peerAddr, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+            manager->mtu = 23;
             manager->deviceConnected = true;
+            
+            // Data length extension: a 244-byte notification in one LL packet
+            esp_ble_gap_set_pkt_data_len(param->connect.remote_bda, 251);
             Serial.println("[BLE] 📱 Phone connected!");
+            if (manager->eventHandler) manager->eventHandler();
         }
         
         void onDisconnect(BLEServer* pServer) {
             manager->deviceConnected = false;
             Serial.println("[BLE] 📱 Phone disconnected");
+            if (manager->eventHandler) manager->eventHandler();
+        }
+        
+        // The phone starts the MTU exchange, we only advertise BLE_MTU
+        void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+            manager->mtu = param->mtu.mtu;
         }
     };
     
@@ -58,19 +125,57 @@ private:
     public:
         CharacteristicCallbacks(BLEManager* mgr) : manager(mgr) {}
         
+        // Parsed in place on the stack's buffer, no copy and no logging
+        void onWrite(BLECharacteristic* pCharacteristic) {
+            if (!manager->dispatcher || pCharacteristic->getLength() == 0) return;
+            
+            uint32_t start = micros();
+            size_t len = manager->dispatcher->dispatch(pCharacteristic->getData(),
+                                                       pCharacteristic->getLength(),
+                                                       manager->replyBuf, manager->maxNotify());
+            uint32_t us = micros() - start;
+            manager->cmdWrites++;
+            manager->cmdTotalUs += us;
+            if (us > manager->cmdMaxUs) manager->cmdMaxUs = us;
+            
+            if (len > 0 && manager->pRxCccd->getNotifications()) {
+                pCharacteristic->setValue(manager->replyBuf, len);
+                pCharacteristic->notify();
+            }
+            if (manager->eventHandler) manager->eventHandler();   // Requests are applied in loop()
+        }
+    };
+    
+    // OTA characteristic: straight into the transfer ring
+    class OtaCallbacks: public BLECharacteristicCallbacks {
+        BLEManager* manager;
+    public:
+        OtaCallbacks(BLEManager* mgr) : manager(mgr) {}
+        
         void onWrite(BLECharacteristic* pCharacteristic) {
-            std::string value = pCharacteristic->getValue();
-            if (value.length() > 0) {
-                String data = String(value.c_str());
-                Serial.printf("[BLE] ⬇️ Received: %s\n", data.c_str());
-                
-                if (manager->onDataReceived) {
-                    manager->onDataReceived(data);
-                }
+            if (manager->otaHandler) {
+                manager->otaHandler(pCharacteristic->getData(), pCharacteristic->getLength());
             }
         }
     };
     
+    // Passkey pairing with bonding: the phone shows a prompt, the user types
+    // BLE_PASSKEY. setStaticPIN() picks SC-only, the mode is set after it
+    void initSecurity() {
+        BLEDevice::setEncryptionLevel(ESP_BLE_SEC_ENCRYPT_MITM);
+        BLESecurity* security = new BLESecurity();
+        security->setStaticPIN(BLE_PASSKEY);
+        security->setCapability(ESP_IO_CAP_OUT);
+        security->setAuthenticationMode(ESP_LE_AUTH_REQ_SC_MITM_BOND);
+        security->setInitEncryptionKey(ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK);
+    }
+    
+    // Writes and subscriptions only over a bonded, MITM-protected link
+    static void requireBond(BLECharacteristic* characteristic, BLE2902* cccd) {
+        characteristic->setAccessPermissions(ESP_GATT_PERM_READ_ENC_MITM | ESP_GATT_PERM_WRITE_ENC_MITM);
+        cccd->setAccessPermissions(ESP_GATT_PERM_READ_ENC_MITM | ESP_GATT_PERM_WRITE_ENC_MITM);
+    }
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // INITIALIZATION
@@ -81,6 +186,8 @@ public:
         
         // Initialize BLE
         BLEDevice::init(deviceName.c_str());
+        BLEDevice::setMTU(BLE_MTU);
+        if (BLE_SECURE) initSecurity();
         
         // Create BLE Server
         pServer = BLEDevice::createServer();
@@ -96,12 +203,34 @@ public:
         );
         pTxCharacteristic->addDescriptor(new BLE2902());
         
-        // Create RX Characteristic (Phone → Device)
+        // Create RX Characteristic (Phone → Device commands, replies notified)
         pRxCharacteristic = pService->createCharacteristic(
             CHARACTERISTIC_UUID_RX,
-            BLECharacteristic::PROPERTY_WRITE
+            BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR |
+            BLECharacteristic::PROPERTY_NOTIFY
         );
+        pRxCccd = new BLE2902();
+        pRxCharacteristic->addDescriptor(pRxCccd);
         pRxCharacteristic->setCallbacks(new CharacteristicCallbacks(this));
+        if (BLE_SECURE) requireBond(pRxCharacteristic, pRxCccd);
+        
+        // Create Stream Characteristic (Device → Phone, binary)
+        pStreamCharacteristic = pService->createCharacteristic(
+            CHARACTERISTIC_UUID_STREAM,
+            BLECharacteristic::PROPERTY_NOTIFY
+        );
+        pStreamCccd = new BLE2902();
+        pStreamCharacteristic->addDescriptor(pStreamCccd);
+        
+        // Create OTA Characteristic (Phone → Device image, ACKs notified)
+        pOtaCharacteristic = pService->createCharacteristic(
+            CHARACTERISTIC_UUID_OTA,
+            BLECharacteristic::PROPERTY_WRITE_NR | BLECharacteristic::PROPERTY_NOTIFY
+        );
+        pOtaCccd = new BLE2902();
+        pOtaCharacteristic->addDescriptor(pOtaCccd);
+        pOtaCharacteristic->setCallbacks(new OtaCallbacks(this));
+        if (BLE_SECURE) requireBond(pOtaCharacteristic, pOtaCccd);
         
         // Start service
         pService->start();
@@ -137,14 +266,72 @@ public:
         return true;
     }
     
-    // Send telemetry packet to phone (JSON format)
+    // Send telemetry packet to phone: 6-byte binary frame on the stream
+    // characteristic, JSON on TX for dashboards that don't subscribe to it
     bool sendTelemetry(uint8_t context_id, uint8_t status, uint16_t sensor_val, uint8_t battery) {
+        if (streaming) {
+            uint8_t frame[BLE_STATUS_LEN];
+            size_t len = BleStreamPacker::encodeStatus(frame, context_id, status, sensor_val, battery);
+            if (!canNotify()) {
+                congested++;
+                return false;
+            }
+            pStreamCharacteristic->setValue(frame, len);
+            pStreamCharacteristic->notify();
+            statusSent++;
+            return true;
+        }
+        
+        if (!deviceConnected) return false;
+        
         String json = "{\"context\":" + String(context_id) + 
                      ",\"status\":" + String(status) +
                      ",\"value\":" + String(sensor_val) +
                      ",\"battery\":" + String(battery) + "}";
         
-        return sendToPhone(json);
+        // Periodic: not echoed to Serial like the one-off requests below
+        pTxCharacteristic->setValue(json.c_str());
+        pTxCharacteristic->notify();
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // IMU STREAM (queued here, sent from update() in batches)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void pushImu(const SensorData& data) {
+        if (!streaming || capturing) return;
+        stream.push(BleStreamPacker::fromSensor(data, millis()));
+    }
+    
+    bool isStreaming() {
+        return streaming;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RAW NOTIFICATIONS (capture frames built by CaptureManager)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void setCaptureMode(bool on) {
+        capturing = on;
+        stream.clear();
+    }
+    
+    // Notification payload for the negotiated MTU
+    size_t streamPayload() {
+        return maxNotify();
+    }
+    
+    // False under backpressure (nothing sent, the caller keeps the frame)
+    bool notifyStream(const uint8_t* data, size_t len) {
+        if (!streaming) return false;
+        if (!canNotify()) {
+            congested++;
+            return false;
+        }
+        pStreamCharacteristic->setValue((uint8_t*)data, len);
+        pStreamCharacteristic->notify();
+        return true;
     }
     
     // ───────────────────────────────────────────────────────────────────────
@@ -175,11 +362,53 @@ public:
     }
     
     // ───────────────────────────────────────────────────────────────────────
-    // SET CALLBACKS
+    // COMMANDS (handlers run in the BLE task, see src/ble/ble_command.h)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void setCommandDispatcher(BleCommandDispatcher* commandDispatcher) {
+        dispatcher = commandDispatcher;
+    }
+    
+    // Called from the BLE task on connect, disconnect and every command
+    void setEventHandler(void (*handler)()) {
+        eventHandler = handler;
+    }
+    
+    // Reply to a command whose handler returned BLE_CMD_DEFERRED (loop())
+    bool sendCommandReply(uint8_t opcode, BleCmdStatus status, const uint8_t* data = nullptr,
+                          uint8_t n = 0) {
+        if (!deviceConnected || !pRxCccd->getNotifications()) return false;
+        uint8_t out[BLE_CMD_REPLY_HEADER_LEN + 255];
+        size_t len = BleCommandDispatcher::buildReply(out, maxNotify(), opcode, status, data, n);
+        if (len == 0) return false;
+        pRxCharacteristic->setValue(out, len);
+        pRxCharacteristic->notify();
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // OTA (see src/managers/ble_ota_manager.h)
     // ───────────────────────────────────────────────────────────────────────
     
-    void setDataCallback(void (*callback)(String data)) {
-        onDataReceived = callback;
+    void setOtaHandler(void (*handler)(const uint8_t* data, size_t len)) {
+        otaHandler = handler;
+    }
+    
+    // Called from the OTA task; false under backpressure or without a subscriber
+    bool notifyOta(const uint8_t* data, size_t len) {
+        if (!deviceConnected || !pOtaCccd->getNotifications()) return false;
+        if (!canNotify()) {
+            congested++;
+            return false;
+        }
+        pOtaCharacteristic->setValue((uint8_t*)data, len);
+        pOtaCharacteristic->notify();
+        return true;
+    }
+    
+    void setOtaMode(bool on) {
+        otaMode = on;
+        if (deviceConnected) applyLinkMode();
     }
     
     // ───────────────────────────────────────────────────────────────────────
@@ -197,7 +426,18 @@ public:
         
         if (deviceConnected && !oldDeviceConnected) {
             oldDeviceConnected = deviceConnected;
+            if (otaMode) applyLinkMode();   // Phone back to resume a transfer
+        }
+        
+        // Subscription to the stream characteristic switches the link mode
+        bool subscribed = deviceConnected && pStreamCccd && pStreamCccd->getNotifications();
+        if (subscribed != streaming) {
+            streaming = subscribed;
+            stream.clear();
+            if (deviceConnected) applyLinkMode();
         }
+        
+        if (streaming && !capturing) drainStream();
     }
     
     bool isConnected() {
@@ -210,6 +450,70 @@ public:
     
     void printStatus() {
         Serial.printf("[BLE] Status: %s\n", deviceConnected ? "CONNECTED" : "DISCONNECTED");
+        if (stream.getPushed() > 0) {
+            Serial.printf("[BLE] Stream: MTU %u, %lu samples in %lu notifications, %lu dropped, "
+                          "%lu congested, queue peak %u\n",
+                          mtu, (unsigned long)stream.getSent(), (unsigned long)stream.getFrames(),
+                          (unsigned long)stream.getDropped(), (unsigned long)congested,
+                          stream.getHighWater());
+        }
+        if (dispatcher && cmdWrites > 0) {
+            Serial.printf("[BLE] Commands: %lu in %lu writes, %lu failed, %lu malformed, "
+                          "handling avg %lu us / max %lu us\n",
+                          (unsigned long)dispatcher->getCommands(), (unsigned long)cmdWrites,
+                          (unsigned long)dispatcher->getFailed(),
+                          (unsigned long)dispatcher->getMalformed(),
+                          (unsigned long)(cmdTotalUs / cmdWrites), (unsigned long)cmdMaxUs);
+        }
+    }
+
+private:
+    // Notification payload for the negotiated MTU
+    size_t maxNotify() {
+        size_t len = (mtu > 3) ? mtu - 3 : 0;
+        return (len < sizeof(streamBuf)) ? len : sizeof(streamBuf);
+    }
+    
+    // Backpressure: the controller has no free ACL buffer for this link
+    bool canNotify() {
+        return esp_ble_get_cur_sendable_packets_num(connId) > 0;
+    }
+    
+    void drainStream() {
+        size_t maxLen = maxNotify();
+        for (int i = 0; i < BLE_MAX_NOTIFY_PER_UPDATE; i++) {
+            if (!stream.shouldFlush(millis(), maxLen)) return;
+            if (!canNotify()) {
+                congested++;
+                return;   // Samples stay queued, the oldest go first if it fills
+            }
+            size_t len = stream.build(streamBuf, maxLen);
+            pStreamCharacteristic->setValue(streamBuf, len);
+            pStreamCharacteristic->notify();
+            stream.commit();
+        }
+    }
+    
+    // Shortest interval for an OTA transfer, short while streaming, long
+    // interval + slave latency otherwise
+    void applyLinkMode() {
+        if (otaMode) {
+            pServer->updateConnParams(peerAddr, OTA_CONN_MIN, OTA_CONN_MAX, 0, BLE_CONN_TIMEOUT);
+#ifdef CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+            // 2M PHY halves the air time of every packet (phone permitting)
+            esp_ble_gap_set_prefered_phy(peerAddr, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                         ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+            Serial.printf("[BLE] 📶 OTA transfer, fastest link (MTU %u)\n", mtu);
+            return;
+        }
+        if (streaming) {
+            pServer->updateConnParams(peerAddr, BLE_CONN_STREAM_MIN, BLE_CONN_STREAM_MAX, 0, BLE_CONN_TIMEOUT);
+        } else {
+            pServer->updateConnParams(peerAddr, BLE_CONN_IDLE_MIN, BLE_CONN_IDLE_MAX,
+                                      BLE_CONN_IDLE_LATENCY, BLE_CONN_TIMEOUT);
+        }
+        Serial.printf("[BLE] 📶 Stream %s (MTU %u)\n", streaming ? "ON, fast link" : "OFF, slow link", mtu);
     }
 };
 
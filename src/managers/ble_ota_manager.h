@@ -0,0 +1,394 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE OTA MANAGER - Firmware Updates from the Phone
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Field devices have BLE to the phone but rarely WiFi: the dashboard sends
+ * the image over the OTA characteristic (src/ble/ota_transfer.h)
+ * - The BLE task only copies writes into the ring and wakes the OTA task
+ * - The OTA task flashes whole 4 KB blocks (OtaWriter: Update + SHA-256)
+ *   and sends the ACKs, so a 30-50 ms sector erase never blocks the BLE
+ *   stack or loop()
+ * - While a transfer runs the link asks for the shortest connection
+ *   interval (and 2M PHY where the controller has it)
+ * - A disconnect keeps the session for OTA_RESUME_TIMEOUT_MS; the phone
+ *   sends OTA_BEGIN again and continues at the ACKed offset
+ * - The hash is checked before the partition is closed, the device only
+ *   reboots into the image on OTA_ACTIVATE
+ * - The transfer may be a delta patch and/or compressed (src/ota_decoder.h):
+ *   the OTA task decodes each received block against the running image and
+ *   flashes the output in whole blocks. OTA_BASE tells the phone which
+ *   image the patch has to be made for
+ * 
+ * Modules are compiled into the firmware (src/current_module.h), so a
+ * module update is a firmware image like any other
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BLE_OTA_MANAGER_H
+#define BLE_OTA_MANAGER_H
+
+#include <Arduino.h>
+#include "../include/config.h"
+#include "../ble/ota_transfer.h"
+#include "../ble/ble_command.h"
+#include "../ota_writer.h"
+#include "../ota_decoder.h"
+#include "ble_manager.h"
+
+class BleOtaManager {
+public:
+    enum State {
+        OTA_IDLE = 0,
+        OTA_RECEIVING = 1,
+        OTA_VERIFIED = 2        // Waiting for OTA_ACTIVATE
+    };
+
+private:
+    BLEManager& ble;
+    OtaTransfer transfer;
+    OtaWriter writer;
+    OtaDecoder decoder;
+    volatile State state = OTA_IDLE;
+    
+    // Decoded image bytes waiting for a whole block
+    uint8_t imageBlock[OTA_BLOCK_SIZE];
+    size_t imageFill = 0;
+    uint8_t encoding = OTA_ENCODING_RAW;
+    uint32_t imageSize = 0;
+    
+    // Running image, hashed once when the task starts
+    uint8_t baseSha[OTA_SHA256_LEN];
+    uint32_t baseSize = 0;
+    volatile bool baseReady = false;
+    
+    TaskHandle_t task = nullptr;
+    
+    // Requests from the BLE task
+    volatile bool beginRequested = false;
+    volatile bool endRequested = false;
+    volatile bool abortRequested = false;
+    volatile bool restartRequested = false;
+    volatile OtaResult abortReason = OTA_RESULT_ABORTED;
+    uint32_t requestedSize = 0;
+    uint8_t requestedSha[OTA_SHA256_LEN];
+    uint8_t requestedEncoding = OTA_ENCODING_RAW;
+    uint32_t requestedImageSize = 0;
+    uint8_t requestedSig[OTA_BEGIN_SIG_MAX];
+    uint8_t requestedSigLen = 0;
+    
+    // Backend's signature over the image, checked by writer.finish()
+    uint8_t signature[OTA_BEGIN_SIG_MAX];
+    uint8_t signatureLen = 0;
+    
+    // Notifications waiting for a free controller buffer (OTA task)
+    uint8_t ackMsg[OTA_ACK_LEN];
+    uint8_t nackMsg[OTA_ACK_LEN];
+    uint8_t resultMsg[OTA_RESULT_LEN];
+    bool ackPending = false;
+    bool nackPending = false;
+    bool resultPending = false;
+    
+    // loop() side
+    bool fastLink = false;
+    uint32_t disconnectedAt = 0;
+    uint32_t restartAt = 0;
+    uint32_t startMs = 0;
+    uint32_t lastFlashed = 0;
+
+public:
+    BleOtaManager(BLEManager& bleManager) : ble(bleManager) {}
+    
+    // Writer task, idle until the first OTA_BEGIN
+    bool begin() {
+        return xTaskCreatePinnedToCore(taskEntry, "ota", 6144, this, 4, &task,
+                                       OTA_TASK_CORE) == pdPASS;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // COMMANDS (BLE task: record and wake the OTA task)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // size: bytes transferred. image_size: after decoding (raw: the same).
+    // sig: DER signature of the image (OTA_SIGNING_PUBKEY), nullptr = unsigned
+    BleCmdStatus requestBegin(uint32_t size, const uint8_t* sha, uint8_t enc = OTA_ENCODING_RAW,
+                              uint32_t image_size = 0, const uint8_t* sig = nullptr, uint8_t sig_len = 0) {
+        if (!task || !OtaDecoder::supported(enc)) return BLE_CMD_UNSUPPORTED;
+        if ((enc & OTA_ENCODING_DELTA) && !baseReady) return BLE_CMD_BUSY;
+        if (beginRequested) return BLE_CMD_BUSY;
+        if (enc == OTA_ENCODING_RAW) image_size = size;
+        if (size == 0 || image_size == 0) return BLE_CMD_BAD_VALUE;
+        if (sig_len > OTA_BEGIN_SIG_MAX) return BLE_CMD_BAD_LENGTH;
+        if (sig_len == 0 && OtaWriter::signatureRequired()) return BLE_CMD_BAD_VALUE;   // Refused now, not after the transfer
+        requestedSize = size;
+        memcpy(requestedSha, sha, OTA_SHA256_LEN);
+        requestedEncoding = enc;
+        requestedImageSize = image_size;
+        if (sig_len > 0) memcpy(requestedSig, sig, sig_len);
+        requestedSigLen = sig_len;
+        beginRequested = true;
+        wake();
+        return BLE_CMD_OK;   // ACK (or RESULT on failure) follows on the OTA characteristic
+    }
+    
+    BleCmdStatus requestEnd() {
+        if (state != OTA_RECEIVING) return BLE_CMD_BAD_VALUE;
+        endRequested = true;
+        wake();
+        return BLE_CMD_OK;
+    }
+    
+    BleCmdStatus requestActivate() {
+        if (state != OTA_VERIFIED) return BLE_CMD_BAD_VALUE;
+        restartRequested = true;
+        return BLE_CMD_OK;
+    }
+    
+    BleCmdStatus requestAbort() {
+        if (state == OTA_IDLE && !beginRequested) return BLE_CMD_BAD_VALUE;
+        abortReason = OTA_RESULT_ABORTED;
+        abortRequested = true;
+        wake();
+        return BLE_CMD_OK;
+    }
+    
+    // [0] state  [1..4] image size  [5..8] received  [9..12] flashed
+    void status(BleReply& reply) {
+        reply.put8((uint8_t)state);
+        reply.put32(transfer.imageSize());
+        reply.put32(transfer.getReceived());
+        reply.put32(transfer.getFlashed());
+    }
+    
+    // [0..3] running image size  [4..35] its SHA-256
+    BleCmdStatus base(BleReply& reply) {
+        if (!baseReady) return task ? BLE_CMD_BUSY : BLE_CMD_UNSUPPORTED;
+        reply.put32(baseSize);
+        reply.putBytes(baseSha, OTA_SHA256_LEN);
+        return BLE_CMD_OK;
+    }
+    
+    // Data write on the OTA characteristic (BLE task)
+    void onPacket(const uint8_t* data, size_t len) {
+        transfer.onPacket(data, len);
+        wake();
+    }
+    
+    bool isActive() {
+        return state == OTA_RECEIVING || beginRequested;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // UPDATE (loop): link mode, resume timeout, reboot
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void update() {
+        bool fast = (state == OTA_RECEIVING);
+        if (fast != fastLink) {
+            fastLink = fast;
+            ble.setOtaMode(fast);
+        }
+        
+        if (state == OTA_RECEIVING && !ble.isConnected()) {
+            if (disconnectedAt == 0) {
+                disconnectedAt = millis() | 1;
+                Serial.printf("[OTA] ⏸️ Phone gone at %lu / %lu bytes, session kept %lu s\n",
+                              (unsigned long)transfer.getReceived(), (unsigned long)transfer.imageSize(),
+                              (unsigned long)(OTA_RESUME_TIMEOUT_MS / 1000));
+            } else if (millis() - disconnectedAt > OTA_RESUME_TIMEOUT_MS && !abortRequested) {
+                abortReason = OTA_RESULT_TIMEOUT;
+                abortRequested = true;
+                wake();
+            }
+        } else {
+            disconnectedAt = 0;
+        }
+        
+        // Give the OTA_ACTIVATE reply time to leave before the restart
+        if (restartRequested) {
+            if (restartAt == 0) {
+                restartAt = millis() + 500;
+                Serial.println("[OTA] 🔄 Activating new firmware...");
+            } else if ((int32_t)(millis() - restartAt) >= 0) {
+                ESP.restart();
+            }
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // DEBUG
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void printStatus() {
+        if (state != OTA_RECEIVING) return;
+        uint32_t flashed = transfer.getFlashed();
+        uint32_t secs = (millis() - startMs) / 1000;
+        Serial.printf("[OTA] %lu / %lu bytes (%lu%%), %lu B/s, %lu image bytes, %lu packets, %lu duplicate, "
+                      "%lu out of order, %lu NACKs, %lu overruns, %lu resumes\n",
+                      (unsigned long)flashed, (unsigned long)transfer.imageSize(),
+                      (unsigned long)((uint64_t)flashed * 100 / transfer.imageSize()),
+                      (unsigned long)(secs ? flashed / secs : flashed), (unsigned long)writer.getWritten(),
+                      (unsigned long)transfer.getPackets(), (unsigned long)transfer.getDuplicates(),
+                      (unsigned long)transfer.getOutOfOrder(), (unsigned long)transfer.getNacks(),
+                      (unsigned long)transfer.getOverruns(), (unsigned long)transfer.getResumes());
+    }
+
+private:
+    void wake() {
+        if (task) xTaskNotifyGive(task);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // OTA TASK (consumer)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static void taskEntry(void* arg) {
+        static_cast<BleOtaManager*>(arg)->taskLoop();
+    }
+    
+    void taskLoop() {
+        baseReady = OtaWriter::runningImage(baseSha, &baseSize);
+        
+        while (true) {
+            // Idle: sleep until a command. Pending notifications retry soon
+            TickType_t wait = (ackPending || nackPending || resultPending) ? pdMS_TO_TICKS(5) :
+                              (state == OTA_RECEIVING) ? pdMS_TO_TICKS(50) : portMAX_DELAY;
+            ulTaskNotifyTake(pdTRUE, wait);
+            
+            if (abortRequested) {
+                abortRequested = false;
+                beginRequested = false;
+                if (state == OTA_RECEIVING) Serial.println("[OTA] ⏹️ Transfer aborted");
+                fail(abortReason);
+            }
+            if (beginRequested) {
+                startTransfer();
+                beginRequested = false;
+            }
+            if (state == OTA_RECEIVING) service();
+            flushMessages();
+        }
+    }
+    
+    void startTransfer() {
+        bool same = (state == OTA_RECEIVING && transfer.imageSize() == requestedSize &&
+                     memcmp(transfer.imageSha(), requestedSha, OTA_SHA256_LEN) == 0 &&
+                     encoding == requestedEncoding && imageSize == requestedImageSize);
+        endRequested = false;
+        memcpy(signature, requestedSig, requestedSigLen);
+        signatureLen = requestedSigLen;
+        
+        if (same) {
+            transfer.begin(requestedSize, requestedSha);
+            Serial.printf("[OTA] ▶️ Resuming at %lu / %lu bytes\n",
+                          (unsigned long)transfer.getReceived(), (unsigned long)requestedSize);
+            return;
+        }
+        
+        // A different image replaces whatever was in progress
+        transfer.end();
+        writer.abort();
+        state = OTA_IDLE;
+        if (!writer.begin(requestedImageSize)) {
+            queueResult(OTA_RESULT_FLASH_ERROR, 0);
+            return;
+        }
+        encoding = requestedEncoding;
+        imageSize = requestedImageSize;
+        imageFill = 0;
+        decoder.begin(encoding, OtaWriter::readRunning, baseSha, baseSize);
+        transfer.begin(requestedSize, requestedSha);
+        startMs = millis();
+        lastFlashed = 0;
+        state = OTA_RECEIVING;
+        Serial.printf("[OTA] 📥 Receiving %lu bytes over BLE (%s, %lu byte image)\n",
+                      (unsigned long)requestedSize, OtaDecoder::name(encoding), (unsigned long)imageSize);
+    }
+    
+    void service() {
+        queueAck();
+        
+        const uint8_t* block;
+        size_t n;
+        while ((n = transfer.readyBlock(&block)) > 0) {
+            OtaResult err = flashTransfer(block, n);
+            if (err != OTA_RESULT_OK) {
+                fail(err);
+                return;
+            }
+            transfer.release(n);
+            queueAck();          // The freed block opens the window at once
+            flushMessages();
+        }
+        
+        uint32_t flashed = transfer.getFlashed();
+        if (flashed / 102400 != lastFlashed / 102400) printStatus();
+        lastFlashed = flashed;
+        
+        if (endRequested && transfer.complete()) {
+            endRequested = false;
+            OtaResult result = writer.finish(transfer.imageSha(), signatureLen ? signature : nullptr, signatureLen);
+            transfer.end();
+            state = (result == OTA_RESULT_OK) ? OTA_VERIFIED : OTA_IDLE;
+            queueResult(result, flashed);
+        }
+    }
+    
+    // Transfer bytes → image bytes → flash, whole blocks except the last
+    OtaResult flashTransfer(const uint8_t* data, size_t len) {
+        if (encoding == OTA_ENCODING_RAW) {
+            return writer.write(data, len) ? OTA_RESULT_OK : OTA_RESULT_FLASH_ERROR;
+        }
+        while (true) {
+            imageFill += decoder.run(&data, &len, &imageBlock[imageFill], OTA_BLOCK_SIZE - imageFill);
+            if (decoder.failed()) {
+                Serial.printf("[OTA] ❌ Patch rejected (error %d) at %lu bytes\n", decoder.getError(),
+                              (unsigned long)(writer.getWritten() + imageFill));
+                return OTA_RESULT_BAD_PATCH;
+            }
+            bool last = imageFill > 0 && writer.getWritten() + imageFill >= imageSize;
+            if (imageFill < OTA_BLOCK_SIZE && !last) return OTA_RESULT_OK;   // Needs more transfer
+            if (!writer.write(imageBlock, imageFill)) return OTA_RESULT_FLASH_ERROR;
+            imageFill = 0;
+        }
+    }
+    
+    void fail(OtaResult result) {
+        uint32_t flashed = transfer.getFlashed();
+        transfer.end();
+        writer.abort();
+        endRequested = false;
+        if (state != OTA_IDLE) queueResult(result, flashed);
+        state = OTA_IDLE;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // NOTIFICATIONS (OTA task only)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void queueAck() {
+        if (transfer.takeAck(ackMsg)) ackPending = true;   // A newer ACK replaces an unsent one
+        if (transfer.takeNack(nackMsg)) nackPending = true;
+    }
+    
+    void queueResult(OtaResult result, uint32_t flashed) {
+        OtaTransfer::encodeResult(resultMsg, result, flashed);
+        resultPending = true;
+        ackPending = false;
+        nackPending = false;
+    }
+    
+    // Nothing is kept for a phone that left: it asks with OTA_STATUS / OTA_BEGIN
+    void flushMessages() {
+        if (!ble.isConnected()) {
+            ackPending = nackPending = resultPending = false;
+            return;
+        }
+        if (nackPending && ble.notifyOta(nackMsg, OTA_ACK_LEN)) nackPending = false;
+        if (ackPending && ble.notifyOta(ackMsg, OTA_ACK_LEN)) ackPending = false;
+        if (resultPending && ble.notifyOta(resultMsg, OTA_RESULT_LEN)) resultPending = false;
+    }
+};
+
+#endif // BLE_OTA_MANAGER_H
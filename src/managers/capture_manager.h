@@ -0,0 +1,291 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    CAPTURE MANAGER - Raw IMU Recording over BLE
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Streams every IMU sample at the full ODR to the phone so labelled raw
+ * data can be recorded for training (the dashboard writes a .uadcap file,
+ * backend/capture-replay.js reads it back)
+ * 
+ * - A FreeRTOS task drains the MPU6050 FIFO every CAPTURE_POLL_MS into a
+ *   ring (src/ble/capture_stream.h): display refreshes, LoRa work or a slow
+ *   loop() never make the 85 ms FIFO overflow
+ * - loop() sends the ring in MTU-sized notifications; a congested link
+ *   only grows the ring (~2 s of slack at 1 kHz)
+ * - Samples carry their index, a FIFO overflow skips indices by the time
+ *   that passed, so the phone sees exactly which samples are missing
+ * - Start / stop arrive from the BLE task, they are applied in update()
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef CAPTURE_MANAGER_H
+#define CAPTURE_MANAGER_H
+
+#include <Arduino.h>
+#include "../include/config.h"
+#include "../ble/capture_stream.h"
+#include "sensor_manager.h"
+#include "ble_manager.h"
+
+class CaptureManager {
+private:
+    enum State {
+        CAPTURE_IDLE,
+        CAPTURE_RUNNING,
+        CAPTURE_DRAINING      // Task stopped, the ring still has samples
+    };
+    
+    SensorManager& sensor;
+    BLEManager& ble;
+    
+    CaptureRing ring;
+    CaptureInfo info;
+    State state = CAPTURE_IDLE;
+    
+    // FIFO task
+    TaskHandle_t task = nullptr;
+    SemaphoreHandle_t taskStopped = nullptr;   // Given by the task once it left the FIFO
+    volatile bool taskRun = false;
+    bool taskActive = false;                    // Started, exit not yet taken (loop() side)
+    
+    // Requests from the BLE task
+    volatile bool startRequested = false;
+    volatile bool stopRequested = false;
+    volatile uint16_t requestedOdr = CAPTURE_ODR_HZ;
+    volatile bool requestedAudio = false;
+    
+    // Frames waiting for a free controller buffer
+    uint8_t frame[BLE_MTU - 3];
+    bool startPending = false;
+    uint8_t audioFrame[CAPTURE_AUDIO_LEN];
+    bool audioPending = false;
+    uint32_t lastFrameMs = 0;
+    uint32_t startMs = 0;
+
+public:
+    CaptureManager(SensorManager& sensorManager, BLEManager& bleManager)
+        : sensor(sensorManager), ble(bleManager) {}
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // CONTROL (safe from the BLE callback)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void requestStart(uint16_t odr_hz, bool audio) {
+        requestedOdr = odr_hz;
+        requestedAudio = audio;
+        startRequested = true;
+    }
+    
+    void requestStop() {
+        stopRequested = true;
+    }
+    
+    bool isActive() {
+        return state != CAPTURE_IDLE;
+    }
+    
+    // Optional audio features (SoundDSP), stamped with the current IMU index
+    void pushAudio(float dominant_hz, float centroid_hz, float harmonic, float energy,
+                   bool musical, bool speech) {
+        if (state != CAPTURE_RUNNING || !info.audio) return;
+        CaptureRing::encodeAudio(audioFrame, ring.producedCount(), clampU16(dominant_hz),
+                                 clampU16(centroid_hz), clampU16(harmonic * 1000.0f),
+                                 clampU16(energy), musical, speech);
+        audioPending = true;   // Newer features replace unsent ones
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // UPDATE (loop): apply requests, send frames
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void update() {
+        if (startRequested) {
+            startRequested = false;
+            start(requestedOdr, requestedAudio);
+        }
+        if (stopRequested) {
+            stopRequested = false;
+            if (state == CAPTURE_RUNNING) {
+                taskRun = false;
+                state = CAPTURE_DRAINING;
+            }
+        }
+        if (state == CAPTURE_IDLE) return;
+        
+        if (!ble.isStreaming()) {
+            abort(ble.isConnected() ? CAPTURE_STOP_UNSUBSCRIBED : CAPTURE_STOP_DISCONNECTED);
+            return;
+        }
+        
+        // The FIFO is released only after the task stopped reading it
+        if (state == CAPTURE_DRAINING && taskActive && xSemaphoreTake(taskStopped, 0) == pdTRUE) {
+            taskActive = false;
+            sensor.endCapture();
+        }
+        
+        if (!drain()) return;   // Congested
+        
+        if (state == CAPTURE_DRAINING && !taskActive && ring.available() == 0) {
+            size_t len = ring.encodeStop(frame, CAPTURE_STOP_REQUESTED);
+            if (ble.notifyStream(frame, len)) finish();
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // DEBUG
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void printStatus() {
+        if (state == CAPTURE_IDLE) return;
+        uint32_t secs = (millis() - startMs) / 1000;
+        Serial.printf("[CAPTURE] %lu s, %lu samples sent in %lu notifications, %lu lost "
+                      "(%lu FIFO overflow, %lu queue full), queue %u / peak %u\n",
+                      (unsigned long)secs, (unsigned long)ring.getSent(),
+                      (unsigned long)ring.getFrames(), (unsigned long)ring.getLost(),
+                      (unsigned long)ring.getLostOverflow(), (unsigned long)ring.getLostFull(),
+                      ring.available(), ring.getHighWater());
+    }
+
+private:
+    bool start(uint16_t odr_hz, bool audio) {
+        if (state != CAPTURE_IDLE) return false;
+        if (!ble.isStreaming()) {
+            Serial.println("[CAPTURE] ❌ Phone is not subscribed to the stream");
+            return false;
+        }
+        
+        // The MPU6050 divides 1 kHz: report the rate it really runs at
+        if (odr_hz == 0 || odr_hz > 1000) odr_hz = CAPTURE_ODR_HZ;
+        odr_hz = 1000 / (1000 / odr_hz);
+        
+        if (!taskStopped) taskStopped = xSemaphoreCreateBinary();
+        if (!taskStopped) return false;
+        
+        ring.reset();
+        if (!sensor.beginCapture(odr_hz)) return false;
+        
+        info.odr_hz = odr_hz;
+        info.accel_lsb_per_g = MPU_ACCEL_LSB_4G;
+        info.gyro_lsb_per_dps_x10 = MPU_GYRO_LSB_500;
+        info.t0_us = micros();
+        info.audio = audio;
+        
+        ble.setCaptureMode(true);
+        startPending = true;
+        audioPending = false;
+        startMs = millis();
+        lastFrameMs = startMs;
+        state = CAPTURE_RUNNING;
+        
+        taskRun = true;
+        if (xTaskCreatePinnedToCore(taskEntry, "capture", 4096, this, 5, &task,
+                                    CAPTURE_TASK_CORE) != pdPASS) {
+            abort(CAPTURE_STOP_REQUESTED);
+            return false;
+        }
+        taskActive = true;
+        
+        Serial.printf("[CAPTURE] 🎥 Started: %u Hz, %u samples per notification%s\n", odr_hz,
+                      CaptureRing::samplesPerFrame(ble.streamPayload()), audio ? ", audio" : "");
+        return true;
+    }
+    
+    // Sends pending control frames and IMU frames; false if the link is congested
+    bool drain() {
+        size_t maxLen = ble.streamPayload();
+        uint16_t perFrame = CaptureRing::samplesPerFrame(maxLen);
+        
+        for (int i = 0; i < BLE_MAX_NOTIFY_PER_UPDATE; i++) {
+            if (startPending) {
+                size_t len = CaptureRing::encodeStart(frame, info);
+                if (!ble.notifyStream(frame, len)) return false;
+                startPending = false;
+                continue;
+            }
+            if (audioPending) {
+                if (!ble.notifyStream(audioFrame, CAPTURE_AUDIO_LEN)) return false;
+                audioPending = false;
+                continue;
+            }
+            
+            // Full notifications while running, partial ones at low ODR or when draining
+            uint16_t avail = ring.available();
+            if (avail == 0) return true;
+            if (avail < perFrame && state == CAPTURE_RUNNING &&
+                millis() - lastFrameMs < CAPTURE_LATENCY_MS) return true;
+            
+            size_t len = ring.build(frame, maxLen);
+            if (len == 0) return true;   // MTU not negotiated yet
+            if (!ble.notifyStream(frame, len)) return false;
+            ring.commit();
+            lastFrameMs = millis();
+        }
+        return true;
+    }
+    
+    // The link is gone: nothing more can be delivered. Waits for the task
+    // to finish its FIFO read (one I2C burst at most) before ending capture
+    void abort(uint8_t reason) {
+        taskRun = false;
+        if (taskActive) {
+            xSemaphoreTake(taskStopped, portMAX_DELAY);
+            taskActive = false;
+        }
+        sensor.endCapture();
+        
+        const char* why = (reason == CAPTURE_STOP_DISCONNECTED) ? "phone disconnected" :
+                          (reason == CAPTURE_STOP_UNSUBSCRIBED) ? "stream unsubscribed" : "start failed";
+        Serial.printf("[CAPTURE] ❌ Aborted (%s)\n", why);
+        finish();
+    }
+    
+    void finish() {
+        printStatus();
+        ble.setCaptureMode(false);
+        state = CAPTURE_IDLE;
+        Serial.printf("[CAPTURE] ⏹️ Stopped: %lu samples, %lu lost\n",
+                      (unsigned long)ring.producedCount(), (unsigned long)ring.getLost());
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // FIFO TASK (producer)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static void taskEntry(void* arg) {
+        static_cast<CaptureManager*>(arg)->taskLoop();
+    }
+    
+    void taskLoop() {
+        RawImuSample buf[CAPTURE_FIFO_BURST];
+        
+        while (taskRun) {
+            bool overflow;
+            size_t n = sensor.readFifo(buf, CAPTURE_FIFO_BURST, overflow);
+            if (overflow) resync();
+            for (size_t i = 0; i < n; i++) ring.push(buf[i]);
+            
+            // A full burst means the FIFO has more: read again right away
+            if (n < CAPTURE_FIFO_BURST) vTaskDelay(pdMS_TO_TICKS(CAPTURE_POLL_MS));
+        }
+        
+        xSemaphoreGive(taskStopped);
+        vTaskDelete(nullptr);
+    }
+    
+    // After a FIFO reset: skip the indices of the samples we never read, so
+    // the next sample keeps its place on the t0 + index / odr time line
+    void resync() {
+        uint64_t expected = (uint64_t)(micros() - info.t0_us) * info.odr_hz / 1000000;
+        uint32_t produced = ring.producedCount();
+        if (expected > produced) ring.skip((uint32_t)(expected - produced));
+    }
+    
+    static uint16_t clampU16(float v) {
+        if (!(v > 0.0f)) return 0;
+        if (v > 65535.0f) return 65535;
+        return (uint16_t)(v + 0.5f);
+    }
+};
+
+#endif // CAPTURE_MANAGER_H
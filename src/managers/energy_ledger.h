@@ -0,0 +1,199 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    ENERGY LEDGER - Charge per Rail & Battery Runtime
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Where the battery goes and how long it lasts:
+ * - Rails: time and charge per consumer. CPU by clock / light sleep
+ *   (PowerManager::idle), board floor, IMU, display, and LoRa TX charged
+ *   per frame from airtime x the SX1262 current at the TX power
+ * - State of charge: the LiPo discharge curve on the first reading, then
+ *   coulomb counting, pulled towards the curve by ENERGY_SOC_BLEND on
+ *   every new voltage (the curve is noisy under load, the count drifts)
+ * - Runtime: remaining charge / recent average current. degradeLevel()
+ *   lets the telemetry scheduler stretch its intervals when it runs low
+ *   compared to a full battery at the expected draw (ENERGY_BASELINE_MA),
+ *   so a full battery never degrades and heavy use degrades earlier
+ * Charge is kept in nC (mA x us) in 64 bits: no float rounding as small
+ * loop increments pile up over weeks. No Arduino calls (host tests)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef ENERGY_LEDGER_H
+#define ENERGY_LEDGER_H
+
+#include <stdint.h>
+#include "../include/config.h"
+
+enum EnergyRail {
+    RAIL_CPU,        // ESP32-S3 core: mode clock, light sleep
+    RAIL_BOARD,      // Regulator, SX1262 listening / asleep
+    RAIL_LORA_TX,    // SX1262 PA, per frame
+    RAIL_SENSOR,     // MPU6050
+    RAIL_DISPLAY     // SSD1306 while on
+};
+
+#define ENERGY_RAILS 5
+
+struct CurvePoint {
+    float x;
+    float y;
+};
+
+// Linear interpolation over points sorted by x, clamped at both ends
+inline float curveLookup(const CurvePoint* curve, int n, float x) {
+    if (x <= curve[0].x) return curve[0].y;
+    for (int i = 1; i < n; i++) {
+        if (x <= curve[i].x) {
+            float t = (x - curve[i - 1].x) / (curve[i].x - curve[i - 1].x);
+            return curve[i - 1].y + t * (curve[i].y - curve[i - 1].y);
+        }
+    }
+    return curve[n - 1].y;
+}
+
+// Single-cell LiPo at rest: volts -> % (typical 1C discharge curve)
+inline float lipoPercent(float volts) {
+    static const CurvePoint curve[] = {
+        {3.27f, 0},  {3.61f, 5},  {3.69f, 10}, {3.71f, 15}, {3.73f, 20}, {3.75f, 25}, {3.77f, 30},
+        {3.79f, 35}, {3.80f, 40}, {3.82f, 45}, {3.84f, 50}, {3.85f, 55}, {3.87f, 60}, {3.91f, 65},
+        {3.95f, 70}, {3.98f, 75}, {4.02f, 80}, {4.08f, 85}, {4.11f, 90}, {4.15f, 95}, {4.20f, 100}
+    };
+    return curveLookup(curve, sizeof(curve) / sizeof(curve[0]), volts);
+}
+
+// SX1262 supply current while transmitting at dbm (HP PA, 3.3 V, datasheet)
+inline float loraTxMa(int8_t dbm) {
+    static const CurvePoint curve[] = {
+        {2, 26}, {8, 36}, {14, 58}, {17, 80}, {20, 102}, {22, 118}
+    };
+    return curveLookup(curve, sizeof(curve) / sizeof(curve[0]), dbm);
+}
+
+class EnergyLedger {
+private:
+    uint64_t timeUs[ENERGY_RAILS] = {};
+    uint64_t chargeNc[ENERGY_RAILS] = {};
+    uint32_t txFrames = 0;
+    
+    // Battery: SoC anchored at the last voltage reading, counted down since
+    bool haveVoltage = false;
+    float volts = 0;
+    float anchorPercent = 100;
+    uint64_t anchorNc = 0;
+    
+    // Average current between readings (EMA)
+    float avgMa = 0;
+    uint64_t lastNc = 0;
+    uint32_t lastMs = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // CHARGE
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void charge(EnergyRail rail, uint32_t us, float ma) {
+        timeUs[rail] += us;
+        if (ma > 0) chargeNc[rail] += (uint64_t)(ma * us + 0.5f);
+    }
+    
+    // One frame on air (successful or not, the PA ran)
+    void chargeTx(uint32_t airtime_us, int8_t dbm) {
+        charge(RAIL_LORA_TX, airtime_us, loraTxMa(dbm));
+        txFrames++;
+    }
+    
+    uint64_t getTotalNc() {
+        uint64_t total = 0;
+        for (int i = 0; i < ENERGY_RAILS; i++) total += chargeNc[i];
+        return total;
+    }
+    
+    float getChargeMah(EnergyRail rail) {
+        return chargeNc[rail] / 3.6e9f;
+    }
+    
+    float getTotalMah() {
+        return getTotalNc() / 3.6e9f;
+    }
+    
+    uint64_t getTimeUs(EnergyRail rail) {
+        return timeUs[rail];
+    }
+    
+    uint32_t getTxFrames() {
+        return txFrames;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // BATTERY (onVoltage on every filtered reading)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void onVoltage(float v, uint32_t now_ms) {
+        uint64_t total = getTotalNc();
+        if (!haveVoltage) {
+            haveVoltage = true;
+            anchorPercent = lipoPercent(v);
+        } else {
+            float counted = getSocPercent();
+            anchorPercent = counted + ENERGY_SOC_BLEND * (lipoPercent(v) - counted);
+            
+            uint32_t dt = now_ms - lastMs;
+            if (dt > 0) {
+                float ma = (float)(total - lastNc) / (dt * 1000.0f);
+                avgMa = avgMa > 0 ? avgMa + ENERGY_CURRENT_ALPHA * (ma - avgMa) : ma;
+            }
+        }
+        volts = v;
+        anchorNc = total;
+        lastNc = total;
+        lastMs = now_ms;
+    }
+    
+    bool hasBattery() {
+        return haveVoltage;
+    }
+    
+    float getVoltage() {
+        return volts;
+    }
+    
+    // Coulomb count since the last reading (O(1), no ADC)
+    float getSocPercent() {
+        float used = (float)(getTotalNc() - anchorNc) / 3.6e9f / BATTERY_CAPACITY_MAH * 100.0f;
+        float soc = anchorPercent - used;
+        return soc < 0 ? 0 : (soc > 100 ? 100 : soc);
+    }
+    
+    float getRemainingMah() {
+        return getSocPercent() / 100.0f * BATTERY_CAPACITY_MAH;
+    }
+    
+    float getAverageMa() {
+        return avgMa;
+    }
+    
+    // Hours left at the recent average current, -1 until known
+    float getRemainingHours() {
+        if (!haveVoltage || avgMa <= 0) return -1;
+        return getRemainingMah() / avgMa;
+    }
+    
+    // What a full battery lasts at ENERGY_BASELINE_MA
+    static float getBaselineHours() {
+        return BATTERY_CAPACITY_MAH / ENERGY_BASELINE_MA;
+    }
+    
+    // 0 = normal, 1 / 2 = runtime below ENERGY_LOW_RUNTIME_FRAC /
+    // ENERGY_CRITICAL_RUNTIME_FRAC of getBaselineHours()
+    uint8_t degradeLevel() {
+        float hours = getRemainingHours();
+        if (hours < 0) return 0;
+        if (hours < ENERGY_CRITICAL_RUNTIME_FRAC * getBaselineHours()) return 2;
+        if (hours < ENERGY_LOW_RUNTIME_FRAC * getBaselineHours()) return 1;
+        return 0;
+    }
+};
+
+#endif // ENERGY_LEDGER_H
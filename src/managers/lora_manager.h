@@ -6,6 +6,17 @@
  * Handles LoRa initialization, packet transmission, and power management
  * Adapted from SmartHelmetClip and assetTracker LoRa implementations
  * 
+ * ASYNC DRIVER:
+ * - TX/RX are started with startTransmit/startReceive and completed from
+ *   the DIO1 interrupt, so no call here waits for time-on-air
+ * - Outgoing frames sit in a small TX queue; update() drives the state
+ *   machine from loop() and fires the completion callbacks
+ * - Every TX is charged its computed time-on-air for airtime budgeting
+ * - Listen-before-talk: CAD on the TX channel before every frame, random
+ *   backoff while it is busy (policy in lora/listen_before_talk.h)
+ * - TDMA (optional): once synced to gateway beacons, scheduled frames wait
+ *   for our slot and the radio sleeps outside the beacon/ACK windows
+ * 
  * ═══════════════════════════════════════════════════════════════════════════
  */
 
@@ -15,14 +26,104 @@
 #include <RadioLib.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "../lora/lora_airtime.h"
+#include "../lora/listen_before_talk.h"
+#include "../lora/tdma_sync.h"
+
+// Radio state machine
+enum LoRaRadioState {
+    LORA_STATE_IDLE,    // Standby, nothing in flight
+    LORA_STATE_TX,      // Transmission in flight (waiting for TX_DONE)
+    LORA_STATE_RX,      // Continuous receive (waiting for RX_DONE)
+    LORA_STATE_CAD,     // Channel activity detection before a TX (CAD_DONE)
+    LORA_STATE_SLEEP    // TDMA: radio asleep between windows
+};
+
+// How a queued frame gets on air
+enum LoRaTxMode {
+    LORA_TX_SCHEDULED,  // TDMA slot when synced, listen-before-talk otherwise
+    LORA_TX_CONTEND,    // Front of the queue, listen-before-talk (alerts skip the slot)
+    LORA_TX_IMMEDIATE   // Front of the queue, on air now without CAD (gateway beacons)
+};
+
+// Result handed to the TX completion callback
+struct LoRaTxResult {
+    bool success;
+    const uint8_t* data;      // The frame (valid during the callback)
+    uint8_t length;           // Payload bytes
+    uint32_t airtime_us;      // Time-on-air charged for this frame
+    unsigned long queued_ms;  // millis() when the frame was queued
+};
+
+// DIO1 fires for TX_DONE, RX_DONE, CAD_DONE and timeouts; the ISR only raises a flag
+// and latches the time so RX timestamps don't include loop() latency
+static volatile bool loraIrqFlag = false;
+static volatile uint32_t loraIrqMicros = 0;
+static void (*volatile loraIrqWake)() = nullptr;   // IRAM: wakes loop() out of its wait
+
+static void IRAM_ATTR onLoRaDio1() {
+    loraIrqMicros = micros();
+    loraIrqFlag = true;
+    if (loraIrqWake) loraIrqWake();
+}
 
 class LoRaManager {
 private:
-    SX1262 radio = new Module(LORA_CS, LORA_IRQ, LORA_RST, LORA_BUSY);
+    SX1262 radio = new Module(LORA_SS, LORA_DIO1, LORA_RST, LORA_BUSY);
     bool initialized = false;
     int16_t last_rssi = 0;
     float last_snr = 0;
+    uint8_t spreadingFactor = LORA_SF;
+    int8_t txPower = LORA_TX_POWER;
+    
+    LoRaRadioState state = LORA_STATE_IDLE;
+    bool listening = false;   // Return to RX when the TX queue drains
+    
+    // TX queue (ring buffer of raw frames)
+    struct TxFrame {
+        uint8_t data[LORA_MAX_PAYLOAD];
+        uint8_t length;
+        LoRaTxMode mode;
+        unsigned long queued_ms;
+    };
+    TxFrame txQueue[LORA_TX_QUEUE_LEN];
+    uint8_t txHead = 0;
+    uint8_t txCount = 0;
     
+    // Frame currently on air (copied: its queue slot may be reused meanwhile)
+    uint8_t inflightData[LORA_MAX_PAYLOAD];
+    uint8_t inflightLength = 0;
+    unsigned long inflightQueuedMs = 0;
+    unsigned long txStartMs = 0;
+    uint32_t inflightAirtimeUs = 0;
+    
+    // Listen-before-talk
+    ListenBeforeTalk lbt;
+    unsigned long txHoldUntilMs = 0;   // Initial delay / busy backoff
+    unsigned long cadStartMs = 0;
+    float txFreq = LORA_FREQ;          // Channel of the next/current frame
+    float currentFreq = LORA_FREQ;     // Channel the radio is tuned to
+    
+    // TDMA (nullptr = disabled)
+    TdmaSync* tdma = nullptr;
+    unsigned long listenUntilMs = 0;   // ACK window after a contention frame
+    
+    // Last received frame (mailbox for receivePacket)
+    uint8_t rxBuffer[LORA_MAX_PAYLOAD];
+    uint8_t rxLength = 0;
+    bool rxPending = false;
+    uint32_t rxTimestampUs = 0;
+    
+    // Airtime accounting
+    uint32_t txSent = 0;
+    uint32_t txFailures = 0;
+    uint64_t totalAirtimeUs = 0;
+    uint32_t maxAirtimeUs = 0;
+    
+    // Callbacks
+    void (*onTxDone)(const LoRaTxResult& result) = nullptr;
+    void (*onRxDone)(const uint8_t* data, size_t len, int16_t rssi, float snr) = nullptr;
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // INITIALIZATION
@@ -31,54 +132,91 @@ public:
     bool begin() {
         Serial.println("[LORA] 🔄 Initializing SX1262...");
         
-        int state = radio.begin(
-            LORA_FREQUENCY,
-            LORA_BANDWIDTH,
-            LORA_SPREADING_FACTOR,
-            LORA_CODING_RATE,
+        int result = radio.begin(
+            LORA_FREQ,
+            LORA_BW,
+            LORA_SF,
+            LORA_CR,
             LORA_SYNC_WORD,
-            LORA_TX_POWER
+            LORA_TX_POWER,
+            LORA_PREAMBLE_LEN
         );
         
-        if (state != RADIOLIB_ERR_NONE) {
-            Serial.printf("[LORA] ❌ Failed to initialize (error %d)\n", state);
+        if (result != RADIOLIB_ERR_NONE) {
+            Serial.printf("[LORA] ❌ Failed to initialize (error %d)\n", result);
             return false;
         }
         
+        radio.setDio1Action(onLoRaDio1);
+        
         initialized = true;
-        Serial.printf("[LORA] ✅ Initialized at %.1f MHz, SF%d, BW%.0f kHz, %d dBm\n",
-                      LORA_FREQUENCY, LORA_SPREADING_FACTOR, 
-                      LORA_BANDWIDTH, LORA_TX_POWER);
+        Serial.printf("[LORA] ✅ Initialized at %.1f MHz, SF%d, BW%.0f kHz, %d dBm (async)\n",
+                      LORA_FREQ, LORA_SF, LORA_BW, LORA_TX_POWER);
         
         return true;
     }
     
     // ───────────────────────────────────────────────────────────────────────
-    // SEND PACKET (6-byte binary payload)
+    // QUEUE RAW FRAME (non-blocking, returns false if queue is full)
     // ───────────────────────────────────────────────────────────────────────
     
-    bool sendPacket(UAD_Packet &packet) {
-        if (!initialized) return false;
+    bool queueFrame(const uint8_t* data, size_t len, LoRaTxMode mode = LORA_TX_SCHEDULED) {
+        if (!initialized || len == 0 || len > LORA_MAX_PAYLOAD) return false;
+        if (len > LoRaAirtime::maxPayload(spreadingFactor)) {
+            Serial.printf("[LORA] ❌ %d bytes exceeds SF%d payload limit\n", (int)len, spreadingFactor);
+            return false;
+        }
         
-        // Transmit binary data
-        int state = radio.transmit((uint8_t*)&packet, sizeof(UAD_Packet));
+        if (txCount >= LORA_TX_QUEUE_LEN) {
+            Serial.println("[LORA] ⚠️ TX queue full, frame dropped");
+            return false;
+        }
         
-        if (state == RADIOLIB_ERR_NONE) {
-            Serial.printf("[LORA] ✅ TX: ID=%d, CTX=%d, STS=%d, VAL=%d, BATT=%d%%\n",
-                          packet.device_id, packet.context_id, packet.status_code,
-                          packet.sensor_val, packet.battery_pct);
+        if (mode != LORA_TX_SCHEDULED) {
+            // Jumps the queue (a TDMA frame may be waiting for its slot)
+            txHead = (txHead + LORA_TX_QUEUE_LEN - 1) % LORA_TX_QUEUE_LEN;
+            TxFrame& slot = txQueue[txHead];
+            memcpy(slot.data, data, len);
+            slot.length = (uint8_t)len;
+            slot.mode = mode;
+            slot.queued_ms = millis();
+            txCount++;
+            
+            if (state != LORA_STATE_TX && state != LORA_STATE_CAD) {
+                prepareTx();
+                if (mode == LORA_TX_IMMEDIATE) {
+                    tuneTo(txFreq);
+                    startNextTx();
+                }
+            }
             return true;
-        } else {
-            Serial.printf("[LORA] ❌ TX failed (error %d)\n", state);
-            return false;
         }
+        
+        TxFrame& slot = txQueue[(txHead + txCount) % LORA_TX_QUEUE_LEN];
+        memcpy(slot.data, data, len);
+        slot.length = (uint8_t)len;
+        slot.mode = mode;
+        slot.queued_ms = millis();
+        txCount++;
+        
+        // New head of queue: update() runs CAD once its random delay expires
+        if (txCount == 1 && state != LORA_STATE_TX && state != LORA_STATE_CAD) prepareTx();
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // SEND PACKET (6-byte binary payload, queued)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool sendPacket(UAD_Packet &packet) {
+        return queueFrame((const uint8_t*)&packet, sizeof(UAD_Packet));
     }
     
     // ───────────────────────────────────────────────────────────────────────
     // SEND PACKET (convenience wrapper)
     // ───────────────────────────────────────────────────────────────────────
     
-    bool sendPacket(uint8_t device_id, ContextType context, StatusCode status, 
+    bool sendPacket(uint8_t device_id, ContextType context, StatusCode status,
                     uint16_t sensor_val, uint8_t battery_pct) {
         UAD_Packet packet;
         packet.device_id = device_id;
@@ -91,66 +229,108 @@ public:
     }
     
     // ───────────────────────────────────────────────────────────────────────
-    // RECEIVE PACKET (for gateway mode)
+    // RECEIVE PACKET (non-blocking poll of the RX mailbox)
     // ───────────────────────────────────────────────────────────────────────
     
     bool receivePacket(UAD_Packet &packet) {
-        if (!initialized) return false;
-        
-        uint8_t buffer[sizeof(UAD_Packet)];
-        int state = radio.receive(buffer, sizeof(UAD_Packet));
+        if (!rxPending || rxLength != sizeof(UAD_Packet)) return false;
         
-        if (state == RADIOLIB_ERR_NONE) {
-            memcpy(&packet, buffer, sizeof(UAD_Packet));
-            
-            last_rssi = radio.getRSSI();
-            last_snr = radio.getSNR();
-            
-            Serial.printf("[LORA] ✅ RX: ID=%d, CTX=%d, STS=%d, VAL=%d, BATT=%d%% | RSSI=%d dBm, SNR=%.1f dB\n",
-                          packet.device_id, packet.context_id, packet.status_code,
-                          packet.sensor_val, packet.battery_pct,
-                          last_rssi, last_snr);
-            
-            return true;
-        } else if (state == RADIOLIB_ERR_RX_TIMEOUT) {
-            // Normal timeout, not an error
-            return false;
-        } else {
-            Serial.printf("[LORA] ❌ RX failed (error %d)\n", state);
-            return false;
-        }
+        memcpy(&packet, rxBuffer, sizeof(UAD_Packet));
+        rxPending = false;
+        return true;
     }
     
     // ───────────────────────────────────────────────────────────────────────
-    // START LISTENING (for gateway mode)
+    // START LISTENING (for gateway mode, radio stays in RX between TX)
     // ───────────────────────────────────────────────────────────────────────
     
     bool startReceive() {
         if (!initialized) return false;
         
-        int state = radio.startReceive();
-        if (state == RADIOLIB_ERR_NONE) {
-            Serial.println("[LORA] 👂 Started listening...");
-            return true;
-        } else {
-            Serial.printf("[LORA] ❌ Failed to start RX (error %d)\n", state);
-            return false;
+        listening = true;
+        if (state == LORA_STATE_TX) return true;  // Resumes after TX_DONE
+        
+        return enterReceive();
+    }
+    
+    void stopReceive() {
+        listening = false;
+        if (state == LORA_STATE_RX) standby();
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATE MACHINE (call every loop, never blocks)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void update() {
+        if (!initialized) return;
+        
+        // An RX_DONE edge during light sleep can miss the ISR: DIO1 stays
+        // high until the IRQ is cleared
+        if (!loraIrqFlag && state == LORA_STATE_RX && digitalRead(LORA_DIO1) == HIGH) {
+            loraIrqMicros = micros();
+            loraIrqFlag = true;
+        }
+        
+        if (loraIrqFlag) {
+            loraIrqFlag = false;
+            rxTimestampUs = loraIrqMicros;
+            
+            if (state == LORA_STATE_TX) {
+                finishTx(true);
+            } else if (state == LORA_STATE_RX) {
+                handleRxDone();
+            } else if (state == LORA_STATE_CAD) {
+                handleCadDone(false);
+            }
+        } else if (state == LORA_STATE_CAD) {
+            // CAD takes a few symbols; no CAD_DONE means a stuck radio
+            if (millis() - cadStartMs > 100) handleCadDone(true);
+        } else if (state == LORA_STATE_TX) {
+            // Watchdog: TX_DONE never arrived (2x airtime + margin)
+            unsigned long limit_ms = (inflightAirtimeUs / 500) + 100;
+            if (millis() - txStartMs > limit_ms) {
+                Serial.println("[LORA] ❌ TX timeout, resetting radio");
+                finishTx(false);
+            }
+        }
+        
+        if (state != LORA_STATE_TX && state != LORA_STATE_CAD) {
+            if (txCount > 0 && (long)(millis() - txHoldUntilMs) >= 0 && slotOpen()) {
+                startChannelCheck();
+            } else if (listening) {
+                if (radioMaySleep()) {
+                    if (state != LORA_STATE_SLEEP) enterSleep();
+                } else if (state != LORA_STATE_RX) {
+                    enterReceive();
+                }
+            }
         }
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // TDMA (beacons are handed to the TdmaSync by the RX callback owner)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void setTdma(TdmaSync* sync) { tdma = sync; }
+    
+    bool tdmaSynced() { return tdma && tdma->isSynced(millis()); }
+    
     // ───────────────────────────────────────────────────────────────────────
     // POWER MANAGEMENT
     // ───────────────────────────────────────────────────────────────────────
     
     bool sleep() {
         if (!initialized) return false;
+        if (state == LORA_STATE_TX) return false;  // Let the frame finish
         
-        int state = radio.sleep();
-        if (state == RADIOLIB_ERR_NONE) {
+        int result = radio.sleep();
+        if (result == RADIOLIB_ERR_NONE) {
+            state = LORA_STATE_IDLE;
             Serial.println("[LORA] 😴 Radio sleeping");
             return true;
         } else {
-            Serial.printf("[LORA] ❌ Failed to sleep (error %d)\n", state);
+            Serial.printf("[LORA] ❌ Failed to sleep (error %d)\n", result);
             return false;
         }
     }
@@ -158,8 +338,9 @@ public:
     bool standby() {
         if (!initialized) return false;
         
-        int state = radio.standby();
-        if (state == RADIOLIB_ERR_NONE) {
+        int result = radio.standby();
+        if (result == RADIOLIB_ERR_NONE) {
+            state = LORA_STATE_IDLE;
             Serial.println("[LORA] ⏸️ Radio standby");
             return true;
         }
@@ -175,16 +356,286 @@ public:
         
         power = constrain(power, 2, 22);  // SX1262 limits
         radio.setOutputPower(power);
+        txPower = power;
         Serial.printf("[LORA] 🔋 TX power set to %d dBm\n", power);
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // CALLBACKS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void setTxCallback(void (*callback)(const LoRaTxResult& result)) {
+        onTxDone = callback;
+    }
+    
+    void setRxCallback(void (*callback)(const uint8_t* data, size_t len, int16_t rssi, float snr)) {
+        onRxDone = callback;
+    }
+    
+    // Called from the DIO1 ISR (must be IRAM_ATTR), e.g. PowerManager::wakeFromISR
+    void setIrqWake(void (*isr)()) {
+        loraIrqWake = isr;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // AIRTIME ACCOUNTING
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint32_t estimateAirtimeUs(size_t len) {
+        return LoRaAirtime::timeOnAirUs(len, spreadingFactor, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+    }
+    
+    uint64_t getTotalAirtimeUs() { return totalAirtimeUs; }
+    uint32_t getMaxAirtimeUs() { return maxAirtimeUs; }
+    uint32_t getTxCount() { return txSent; }
+    uint32_t getTxFailures() { return txFailures; }
+    
     // ───────────────────────────────────────────────────────────────────────
     // GETTERS
     // ───────────────────────────────────────────────────────────────────────
     
     int16_t getRSSI() { return last_rssi; }
+    uint32_t getRxTimestampUs() { return rxTimestampUs; }  // micros() at RX_DONE
+    
+    // millis() at which the last received frame started on air
+    uint32_t getRxStartMs() {
+        uint32_t age_us = (micros() - rxTimestampUs) + estimateAirtimeUs(rxLength);
+        return millis() - age_us / 1000;
+    }
     float getSNR() { return last_snr; }
+    uint8_t getSpreadingFactor() { return spreadingFactor; }
+    int8_t getTxPower() { return txPower; }
     bool isInitialized() { return initialized; }
+    bool isBusy() { return state == LORA_STATE_TX || state == LORA_STATE_CAD || txCount > 0; }
+    LoRaRadioState getState() { return state; }
+    uint8_t getQueuedFrames() { return txCount; }
+    ListenBeforeTalk& getLbt() { return lbt; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // DEBUG
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void printStatus() {
+        const char* stateNames[] = {"IDLE", "TX", "RX", "CAD", "SLEEP"};
+        uint32_t avg_ms = txSent ? (uint32_t)(totalAirtimeUs / txSent / 1000) : 0;
+        Serial.printf("[LORA] State: %s | Queue: %d | TX: %lu (%lu failed) | Airtime: %lu ms total, %lu ms avg, %lu ms max\n",
+                      stateNames[state], txCount, (unsigned long)txSent, (unsigned long)txFailures,
+                      (unsigned long)(totalAirtimeUs / 1000), (unsigned long)avg_ms,
+                      (unsigned long)(maxAirtimeUs / 1000));
+        Serial.printf("[LORA] LBT: %lu CAD, %lu busy, %lu forced%s\n",
+                      (unsigned long)lbt.getCadRuns(), (unsigned long)lbt.getCadBusy(),
+                      (unsigned long)lbt.getForced(), lbt.isHopping() ? " | hopping" : "");
+        if (tdma) {
+            Serial.printf("[LORA] TDMA: %s | slot %u | %lu beacons, %lu resyncs | drift %ld ppm | error %ld ms (max %lu)\n",
+                          tdmaSynced() ? "synced" : "searching", tdma->getSlot(),
+                          (unsigned long)tdma->getBeacons(), (unsigned long)tdma->getResyncs(),
+                          (long)tdma->getDriftPpm(), (long)tdma->getLastErrorMs(),
+                          (unsigned long)tdma->getMaxErrorMs());
+        }
+    }
+
+private:
+    // ───────────────────────────────────────────────────────────────────────
+    // LISTEN BEFORE TALK
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // New head-of-queue frame: pick its channel and initial random delay
+    void prepareTx() {
+        if (txQueue[txHead].mode == LORA_TX_IMMEDIATE || inSlot()) {
+            // Beacons and TDMA slots: fixed channel, no random delay
+            txFreq = LORA_FREQ;
+            txHoldUntilMs = millis();
+            return;
+        }
+        txFreq = lbt.nextChannel();
+        txHoldUntilMs = millis() + (LORA_LBT_ENABLED ? lbt.initialDelayMs() : 0);
+    }
+    
+    // Immediate frames, and slotted ones (the slot is ours alone)
+    bool skipCad() {
+        return !LORA_LBT_ENABLED || (txCount > 0 && txQueue[txHead].mode == LORA_TX_IMMEDIATE) || inSlot();
+    }
+    
+    // Head frame goes in our TDMA slot (synced, scheduled, and it fits)
+    bool inSlot() {
+        if (txCount == 0 || txQueue[txHead].mode != LORA_TX_SCHEDULED || !tdmaSynced()) return false;
+        return tdma->fitsSlot(estimateAirtimeUs(txQueue[txHead].length) / 1000 + 1, millis());
+    }
+    
+    bool slotOpen() {
+        if (!inSlot()) return true;
+        return tdma->canTransmit(millis(), estimateAirtimeUs(txQueue[txHead].length) / 1000 + 1);
+    }
+    
+    // TDMA: nothing to hear outside the beacon window and our ACK window
+    bool radioMaySleep() {
+        if (!tdmaSynced() || (long)(millis() - listenUntilMs) < 0) return false;
+        return !tdma->shouldListen(millis());
+    }
+    
+    bool tuneTo(float freq) {
+        if (freq == currentFreq) return true;
+        int result = radio.setFrequency(freq);
+        if (result != RADIOLIB_ERR_NONE) {
+            Serial.printf("[LORA] ❌ Failed to tune to %.1f MHz (error %d)\n", freq, result);
+            return false;
+        }
+        currentFreq = freq;
+        return true;
+    }
+    
+    void startChannelCheck() {
+        tuneTo(txFreq);
+        
+        if (skipCad()) {
+            startNextTx();
+            return;
+        }
+        
+        loraIrqFlag = false;
+        int result = radio.startChannelScan();
+        if (result != RADIOLIB_ERR_NONE) {
+            // No CAD available: fall back to plain ALOHA
+            startNextTx();
+            return;
+        }
+        state = LORA_STATE_CAD;
+        cadStartMs = millis();
+    }
+    
+    void handleCadDone(bool timedOut) {
+        bool busy = timedOut || radio.getChannelScanResult() == RADIOLIB_LORA_DETECTED;
+        state = LORA_STATE_IDLE;
+        
+        // An immediate frame jumped the queue while we were scanning
+        if (txQueue[txHead].mode == LORA_TX_IMMEDIATE) {
+            startNextTx();
+            return;
+        }
+        
+        uint32_t wait_ms;
+        if (lbt.onCadResult(busy, wait_ms) == ListenBeforeTalk::LBT_TRANSMIT) {
+            startNextTx();
+        } else {
+            // Listen while backing off (update() re-enters RX)
+            txHoldUntilMs = millis() + wait_ms;
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // TX PATH
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void startNextTx() {
+        if (txCount == 0) return;
+        
+        TxFrame& frame = txQueue[txHead];
+        txHead = (txHead + 1) % LORA_TX_QUEUE_LEN;
+        txCount--;
+        
+        memcpy(inflightData, frame.data, frame.length);
+        inflightLength = frame.length;
+        inflightQueuedMs = frame.queued_ms;
+        inflightAirtimeUs = estimateAirtimeUs(frame.length);
+        
+        loraIrqFlag = false;
+        int result = radio.startTransmit(frame.data, frame.length);
+        
+        if (result != RADIOLIB_ERR_NONE) {
+            Serial.printf("[LORA] ❌ TX start failed (error %d)\n", result);
+            state = LORA_STATE_IDLE;
+            if (txCount > 0) prepareTx();
+            reportTx(false);
+            return;
+        }
+        
+        state = LORA_STATE_TX;
+        txStartMs = millis();
+        
+        // Alerts expect an ACK: keep the receiver up even between TDMA windows
+        if (frame.mode == LORA_TX_CONTEND) {
+            listenUntilMs = txStartMs + inflightAirtimeUs / 1000 + ALERT_ACK_WINDOW_MS;
+        }
+    }
+    
+    void finishTx(bool done) {
+        bool success = done && (radio.finishTransmit() == RADIOLIB_ERR_NONE);
+        if (!done) radio.standby();
+        
+        state = LORA_STATE_IDLE;
+        if (txCount > 0) prepareTx();
+        
+        if (success) {
+            txSent++;
+            totalAirtimeUs += inflightAirtimeUs;
+            if (inflightAirtimeUs > maxAirtimeUs) maxAirtimeUs = inflightAirtimeUs;
+        }
+        
+        reportTx(success);
+    }
+    
+    void reportTx(bool success) {
+        if (!success) txFailures++;
+        
+        if (onTxDone) {
+            LoRaTxResult result;
+            result.success = success;
+            result.data = inflightData;
+            result.length = inflightLength;
+            result.airtime_us = success ? inflightAirtimeUs : 0;
+            result.queued_ms = inflightQueuedMs;
+            onTxDone(result);
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RX PATH
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void enterSleep() {
+        if (radio.sleep() == RADIOLIB_ERR_NONE) state = LORA_STATE_SLEEP;
+    }
+    
+    bool enterReceive() {
+        tuneTo(LORA_FREQ);  // Hopping only applies to our own TX
+        loraIrqFlag = false;
+        int result = radio.startReceive();
+        if (result == RADIOLIB_ERR_NONE) {
+            state = LORA_STATE_RX;
+            return true;
+        } else {
+            Serial.printf("[LORA] ❌ Failed to start RX (error %d)\n", result);
+            state = LORA_STATE_IDLE;
+            return false;
+        }
+    }
+    
+    void handleRxDone() {
+        size_t len = radio.getPacketLength();
+        if (len > LORA_MAX_PAYLOAD) len = LORA_MAX_PAYLOAD;
+        
+        int result = radio.readData(rxBuffer, len);
+        
+        // SX1262 stays in continuous RX after a packet, re-arm defensively
+        state = LORA_STATE_IDLE;
+        if (listening) enterReceive();
+        
+        if (result != RADIOLIB_ERR_NONE) {
+            if (result != RADIOLIB_ERR_CRC_MISMATCH) {
+                Serial.printf("[LORA] ❌ RX failed (error %d)\n", result);
+            }
+            return;
+        }
+        
+        last_rssi = radio.getRSSI();
+        last_snr = radio.getSNR();
+        rxLength = (uint8_t)len;
+        rxPending = true;
+        
+        if (onRxDone) {
+            onRxDone(rxBuffer, len, last_rssi, last_snr);
+        }
+    }
 };
 
 #endif // LORA_MANAGER_H
@@ -6,6 +6,19 @@
  * Manages deep sleep, battery monitoring, and adaptive power modes
  * Adapted from SmartHelmetClip power_manager.h
  * 
+ * Light sleep (ESP-IDF power management): loop() holds a CPU lock while
+ * it runs and waits in idle(); with no lock held and no task runnable the
+ * idle task sleeps until the next timer (the sample batch), a LoRa DIO1
+ * edge or a BLE event. Each PowerMode sets the clock esp_pm may use.
+ * PowerProfile keeps the residency and average current per mode
+ * 
+ * Energy: EnergyLedger charges every rail (CPU, board, IMU, display, LoRa
+ * TX) from the same residency. The battery is read through esp_adc_cal
+ * once per BATTERY_CHECK_INT_MS (serviceBattery, divider powered only
+ * for the burst), median- and EMA-filtered (BatteryFilter) and cached;
+ * state of charge is the LiPo curve corrected by the coulomb count, and
+ * the remaining runtime follows from it
+ * 
  * ═══════════════════════════════════════════════════════════════════════════
  */
 
@@ -14,16 +27,13 @@
 
 #include <Arduino.h>
 #include <esp_sleep.h>
+#include <esp_pm.h>
 #include <driver/rtc_io.h>
+#include <esp_adc_cal.h>
 #include "../include/config.h"
-
-// Power modes
-enum PowerMode {
-    POWER_FULL,     // All systems active (~150mA)
-    POWER_IDLE,     // Reduced polling (~80mA)
-    POWER_SLEEP,    // Deep sleep (~5mA)
-    POWER_ALERT     // Emergency mode (~200mA)
-};
+#include "power_profile.h"
+#include "energy_ledger.h"
+#include "battery_filter.h"
 
 class PowerManager {
 private:
@@ -38,6 +48,26 @@ private:
     float motionHistory[MOTION_SAMPLES];
     int motionIndex = 0;
     
+    // Light sleep: loop() holds cpuLock while it runs; awakeLock keeps the
+    // CPU out of light sleep (radio TX, transfers, alerts)
+    PowerSaving saving = PM_NONE;
+    esp_pm_lock_handle_t cpuLock = nullptr;
+    esp_pm_lock_handle_t awakeLock = nullptr;
+    bool holdingAwake = false;
+    bool alertAwake = false;
+    uint32_t awakeSince = 0;
+    uint32_t earlyWakes = 0;
+    PowerProfile profile;
+    
+    // Energy: per-rail loads charged over loop() time (CPU from the profile)
+    EnergyLedger ledger;
+    float loadMa[ENERGY_RAILS] = {};
+    esp_adc_cal_characteristics_t adcChars;
+    BatteryFilter battery;
+    
+    // Task waiting in idle(), woken early by radio / BLE events
+    static inline TaskHandle_t loopTask = nullptr;
+    
 public:
     // ───────────────────────────────────────────────────────────────────────
     // INITIALIZATION
@@ -49,7 +79,20 @@ public:
         memset(motionHistory, 0, sizeof(motionHistory));
         
         // Configure wake-up sources
-        esp_sleep_enable_ext0_wakeup((gpio_num_t)BTN_PIN, 0);  // Button wake
+        esp_sleep_enable_ext0_wakeup((gpio_num_t)EXT_BTN_PIN, 0);  // Button wake
+        
+        loopTask = xTaskGetCurrentTaskHandle();
+        beginLightSleep();
+        awakeSince = micros();
+        
+        // Battery divider on ADC1 (calibrated from eFuse), off between reads
+        pinMode(BAT_READ_CTRL, OUTPUT);
+        digitalWrite(BAT_READ_CTRL, HIGH);
+        analogReadResolution(12);
+        analogSetPinAttenuation(BAT_ADC_PIN, ADC_11db);
+        esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adcChars);
+        loadMa[RAIL_BOARD] = POWER_BOARD_MA;
+        serviceBattery(millis());
         
         Serial.println("[POWER] ✅ Power manager initialized");
         Serial.println("[POWER] Wake sources: button, timer, IMU interrupt");
@@ -59,22 +102,60 @@ public:
     // BATTERY MONITORING
     // ───────────────────────────────────────────────────────────────────────
     
-    int getBatteryPercent() {
-        // Read ADC voltage
-        int raw = analogRead(BATT_SENSE_PIN);
-        float voltage = (raw / 4095.0) * 3.3 * BATT_VOLTAGE_DIVIDER;
+    // Once per loop: a new reading when BATTERY_CHECK_INT_MS has passed
+    // (divider on, median of the burst, EMA, into the ledger). True if read
+    bool serviceBattery(uint32_t now_ms) {
+        if (!battery.due(now_ms)) return false;
         
-        // Map voltage to percentage (3.0V = 0%, 4.2V = 100%)
-        float percent = ((voltage - BATT_MIN_VOLTAGE) / 
-                        (BATT_MAX_VOLTAGE - BATT_MIN_VOLTAGE)) * 100.0;
+        uint32_t mv[BATT_ADC_SAMPLES];
+        digitalWrite(BAT_READ_CTRL, LOW);
+        delayMicroseconds(BATT_SETTLE_US);
+        for (int i = 0; i < BATT_ADC_SAMPLES; i++) {
+            mv[i] = esp_adc_cal_raw_to_voltage(analogRead(BAT_ADC_PIN), &adcChars);
+        }
+        digitalWrite(BAT_READ_CTRL, HIGH);
         
-        batteryPercent = constrain((int)percent, 0, 100);
+        float volts = BatteryFilter::median(mv, BATT_ADC_SAMPLES) / 1000.0f * BATT_VOLTAGE_DIVIDER;
+        ledger.onVoltage(battery.add(volts, now_ms), now_ms);
+        batteryPercent = (int)(ledger.getSocPercent() + 0.5f);
+        return true;
+    }
+    
+    // Cached at the last reading (no ADC)
+    int getBatteryPercent() {
         return batteryPercent;
     }
     
     float getBatteryVoltage() {
-        int raw = analogRead(BATT_SENSE_PIN);
-        return (raw / 4095.0) * 3.3 * BATT_VOLTAGE_DIVIDER;
+        return battery.getVolts();
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // ENERGY LEDGER
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Current a rail draws from now on (IMU, display on/off, ...)
+    void setLoad(EnergyRail rail, float ma) {
+        loadMa[rail] = ma;
+    }
+    
+    // One LoRa frame on air at dbm
+    void chargeTx(uint32_t airtime_us, int8_t dbm) {
+        ledger.chargeTx(airtime_us, dbm);
+    }
+    
+    // Hours of battery left at the recent average current (-1 = unknown)
+    float getRemainingHours() {
+        return ledger.getRemainingHours();
+    }
+    
+    // 0 normal, 1 low, 2 critical runtime: how far to stretch intervals
+    uint8_t getDegradeLevel() {
+        return ledger.degradeLevel();
+    }
+    
+    EnergyLedger& getLedger() {
+        return ledger;
     }
     
     // ───────────────────────────────────────────────────────────────────────
@@ -112,22 +193,16 @@ public:
     void setMode(PowerMode mode) {
         if (mode == currentMode) return;
         
+        // Residency up to now goes to the mode being left
+        uint32_t now = micros();
+        account(now - awakeSince, 0);
+        awakeSince = now;
         currentMode = mode;
+        applyClock();
         
-        switch (mode) {
-            case POWER_FULL:
-                Serial.println("[POWER] Mode: FULL (~150mA)");
-                break;
-            case POWER_IDLE:
-                Serial.println("[POWER] Mode: IDLE (~80mA)");
-                break;
-            case POWER_SLEEP:
-                Serial.println("[POWER] Mode: SLEEP (~5mA)");
-                break;
-            case POWER_ALERT:
-                Serial.println("[POWER] Mode: ALERT (~200mA)");
-                break;
-        }
+        Serial.printf("[POWER] Mode: %s (%u MHz, measured avg %.1f mA)\n",
+                      PowerProfile::modeName(mode), PowerProfile::modeMhz(mode),
+                      profile.averageMa(mode, saving));
     }
     
     PowerMode getMode() {
@@ -162,6 +237,64 @@ public:
         Serial.printf("[POWER] ✅ IMU wake enabled on GPIO%d\n", pin);
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // LIGHT SLEEP (automatic, between sample batches)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Radio DIO1 (RX_DONE) wakes the CPU from light sleep. RTC IO wake
+    // registers only: the pin keeps its digital edge interrupt
+    void enableRadioWake(uint8_t pin) {
+        if (saving != PM_LIGHT_SLEEP) return;
+        rtc_gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_HIGH_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+        Serial.printf("[POWER] ✅ Radio wake enabled on GPIO%d\n", pin);
+    }
+    
+    // Ends idle() early: BLE callbacks (BLE task) and radio ISR
+    static void wake() {
+        if (loopTask) xTaskNotifyGive(loopTask);
+    }
+    
+    static void IRAM_ATTR wakeFromISR() {
+        if (!loopTask) return;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+    
+    // Keeps the CPU out of light sleep while the radio is on air or a
+    // transfer runs (their deadlines are shorter than a wake-up)
+    void holdAwake(bool hold) {
+        if (hold == holdingAwake) return;
+        holdingAwake = hold;
+        if (!awakeLock || alertAwake) return;
+        if (hold) esp_pm_lock_acquire(awakeLock);
+        else esp_pm_lock_release(awakeLock);
+    }
+    
+    // loop()'s wait: releases the CPU lock for up to ms, back early on
+    // wake(). Replaces delay(); the residency goes to the current mode
+    void idle(uint32_t ms) {
+        uint32_t start = micros();
+        uint32_t awake = start - awakeSince;
+        
+        if (cpuLock) esp_pm_lock_release(cpuLock);
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0) earlyWakes++;
+        if (cpuLock) esp_pm_lock_acquire(cpuLock);
+        
+        awakeSince = micros();
+        profile.addIdle(currentMode, awakeSince - start);
+        account(awake, awakeSince - start);
+    }
+    
+    PowerSaving getSaving() {
+        return saving;
+    }
+    
+    PowerProfile& getProfile() {
+        return profile;
+    }
+    
     // ───────────────────────────────────────────────────────────────────────
     // AUTO POWER MANAGEMENT
     // ───────────────────────────────────────────────────────────────────────
@@ -172,8 +305,18 @@ public:
         // Don't auto-sleep during alerts
         if (currentMode == POWER_ALERT) return;
         
+        // Force power save on critical battery (cached: update() runs
+        // every loop, the ADC is read by serviceBattery on its timer)
+        if (batteryPercent <= 10) {
+            if (currentMode != POWER_IDLE) {
+                Serial.println("[POWER] ⚠️ CRITICAL BATTERY - forcing idle");
+                setMode(POWER_IDLE);
+            }
+            return;
+        }
+        
         // Auto transitions
-        if (currentMode == POWER_FULL && inactiveTime > IDLE_TIMEOUT) {
+        if (currentMode == POWER_FULL && inactiveTime > IDLE_TIMEOUT && !isMoving) {
             setMode(POWER_IDLE);
         }
         
@@ -181,28 +324,100 @@ public:
         if (currentMode != POWER_FULL && isMoving) {
             setMode(POWER_FULL);
         }
-        
-        // Force power save on critical battery
-        int batt = getBatteryPercent();
-        if (batt <= 10 && currentMode != POWER_ALERT) {
-            Serial.println("[POWER] ⚠️ CRITICAL BATTERY - forcing idle");
-            setMode(POWER_IDLE);
-        }
     }
     
     // ───────────────────────────────────────────────────────────────────────
     // DEBUG
     // ───────────────────────────────────────────────────────────────────────
     
+    // Where the charge went and what is left
+    void printEnergy() {
+        static const char* railNames[ENERGY_RAILS] = {"cpu", "board", "tx", "imu", "display"};
+        Serial.printf("[ENERGY] %.2f mAh used:", ledger.getTotalMah());
+        for (int i = 0; i < ENERGY_RAILS; i++) {
+            Serial.printf(" %s %.2f", railNames[i], ledger.getChargeMah((EnergyRail)i));
+        }
+        Serial.printf(" (%lu frames)\n", (unsigned long)ledger.getTxFrames());
+        float hours = ledger.getRemainingHours();
+        Serial.printf("[ENERGY] Battery %d%% (%.2f V, %.0f mAh), avg %.1f mA, %s%.0f h left%s\n",
+                      batteryPercent, battery.getVolts(), ledger.getRemainingMah(), ledger.getAverageMa(),
+                      hours < 0 ? "? " : "", hours < 0 ? 0.0f : hours,
+                      ledger.degradeLevel() ? " (degraded)" : "");
+    }
+    
+    // Measured residency and average current per mode
+    void printProfile() {
+        static const char* savingNames[] = {"off", "clock scaling", "light sleep"};
+        Serial.printf("[POWER] Saving: %s, avg %.1f mA, %lu early wakes\n", savingNames[saving],
+                      profile.averageMa(saving), (unsigned long)earlyWakes);
+        for (int i = 0; i < POWER_MODES; i++) {
+            PowerMode mode = (PowerMode)i;
+            if (profile.getTimeUs(mode) == 0) continue;
+            Serial.printf("[POWER]   %-5s %3u MHz: %lus, awake %.1f%%, %lu wakeups, avg %.1f mA\n",
+                          PowerProfile::modeName(mode), PowerProfile::modeMhz(mode),
+                          (unsigned long)(profile.getTimeUs(mode) / 1000000),
+                          profile.awakeFraction(mode) * 100.0f, (unsigned long)profile.getWakeups(mode),
+                          profile.averageMa(mode, saving));
+        }
+    }
+    
     void printStatus() {
-        const char* modeNames[] = {"FULL", "IDLE", "SLEEP", "ALERT"};
         Serial.printf("[POWER] Mode: %s | Battery: %d%% (%.2fV) | Moving: %s | Inactive: %lus\n",
-                      modeNames[currentMode],
+                      PowerProfile::modeName(currentMode),
                       getBatteryPercent(),
                       getBatteryVoltage(),
                       isMoving ? "YES" : "NO",
                       (millis() - lastActivity) / 1000);
     }
+
+private:
+    // esp_pm with the mode's clock and light sleep, falling back to clock
+    // scaling when the core has no tickless idle, to nothing without PM
+    void beginLightSleep() {
+        saving = configureClock(POWER_LIGHT_SLEEP_ENABLED) ? PM_LIGHT_SLEEP :
+                 configureClock(false) ? PM_CLOCK : PM_NONE;
+        if (saving == PM_NONE) {
+            Serial.println("[POWER] ⚠️ No esp_pm in this core (CONFIG_PM_ENABLE): fixed clock");
+            return;
+        }
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "loop", &cpuLock);
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &awakeLock);
+        if (cpuLock) esp_pm_lock_acquire(cpuLock);   // loop() is running
+        Serial.printf("[POWER] ✅ %s, %u-%u MHz\n",
+                      saving == PM_LIGHT_SLEEP ? "Automatic light sleep" : "Clock scaling (no tickless idle)",
+                      POWER_MIN_MHZ, PowerProfile::modeMhz(currentMode));
+    }
+    
+    bool configureClock(bool lightSleep) {
+        esp_pm_config_esp32s3_t config = {};
+        config.max_freq_mhz = PowerProfile::modeMhz(currentMode);
+        config.min_freq_mhz = POWER_MIN_MHZ;
+        config.light_sleep_enable = lightSleep;
+        return esp_pm_configure(&config) == ESP_OK;
+    }
+    
+    // loop() time since the last call: awake residency for the mode, charge
+    // for every rail (CPU at the mode clock awake, light sleep / lowest clock idle)
+    void account(uint32_t awakeUs, uint32_t idleUs) {
+        profile.addAwake(currentMode, awakeUs);
+        ledger.charge(RAIL_CPU, awakeUs, PowerProfile::activeMa(PowerProfile::modeMhz(currentMode)) - POWER_BOARD_MA);
+        ledger.charge(RAIL_CPU, idleUs, PowerProfile::idleMa(currentMode, saving) - POWER_BOARD_MA);
+        for (int i = RAIL_BOARD; i < ENERGY_RAILS; i++) {
+            if (i != RAIL_LORA_TX) ledger.charge((EnergyRail)i, awakeUs + idleUs, loadMa[i]);
+        }
+    }
+    
+    // New mode: its clock, and alerts stay out of light sleep
+    void applyClock() {
+        if (saving == PM_NONE) return;
+        configureClock(saving == PM_LIGHT_SLEEP);
+        bool alert = currentMode == POWER_ALERT;
+        if (!awakeLock || alert == alertAwake) return;
+        alertAwake = alert;
+        if (holdingAwake) return;   // Already held for the radio / a transfer
+        if (alert) esp_pm_lock_acquire(awakeLock);
+        else esp_pm_lock_release(awakeLock);
+    }
 };
 
 #endif // POWER_MANAGER_H
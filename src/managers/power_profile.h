@@ -0,0 +1,140 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    POWER PROFILE - Per-Mode Clock, Residency & Current
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * What each PowerMode costs, measured on the device:
+ * - Clock: the CPU frequency PowerManager gives esp_pm for the mode
+ *   (POWER_*_MHZ); with no lock held it drops to POWER_MIN_MHZ or sleeps
+ * - Residency: time loop() spent awake and waiting, per mode
+ * - Average current: residency weighted by the datasheet current of each
+ *   state (awake at the mode clock, waiting in light sleep). The board has
+ *   no current sense: BLE / capture tasks running while loop() waits are
+ *   not counted, so this is a lower bound
+ * No Arduino calls: the host tests run it as is
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef POWER_PROFILE_H
+#define POWER_PROFILE_H
+
+#include <stdint.h>
+#include "../include/config.h"
+
+// Power modes
+enum PowerMode {
+    POWER_FULL,     // All systems active, light sleep between batches
+    POWER_IDLE,     // Reduced clock, light sleep between batches
+    POWER_SLEEP,    // Lowest clock before deep sleep
+    POWER_ALERT     // Emergency mode: full clock, no light sleep
+};
+
+#define POWER_MODES 4
+
+// What esp_pm accepted at boot (depends on the sdkconfig of the core)
+enum PowerSaving {
+    PM_NONE,          // No CONFIG_PM_ENABLE: fixed clock, idle task spins in waiti
+    PM_CLOCK,         // Frequency scaling only (no tickless idle)
+    PM_LIGHT_SLEEP    // Frequency scaling + automatic light sleep
+};
+
+class PowerProfile {
+private:
+    struct Residency {
+        uint64_t awake_us;
+        uint64_t idle_us;
+        uint32_t wakeups;
+    };
+    
+    Residency modes[POWER_MODES] = {};
+
+public:
+    static const char* modeName(PowerMode mode) {
+        static const char* names[POWER_MODES] = {"FULL", "IDLE", "SLEEP", "ALERT"};
+        return names[mode];
+    }
+    
+    static uint16_t modeMhz(PowerMode mode) {
+        switch (mode) {
+            case POWER_IDLE:  return POWER_IDLE_MHZ;
+            case POWER_SLEEP: return POWER_SLEEP_MHZ;
+            case POWER_ALERT: return POWER_ALERT_MHZ;
+            default:          return POWER_FULL_MHZ;
+        }
+    }
+    
+    // Alerts keep the CPU out of light sleep (interrupt latency)
+    static bool modeLightSleeps(PowerMode mode) {
+        return POWER_LIGHT_SLEEP_ENABLED && mode != POWER_ALERT;
+    }
+    
+    // Board current with the CPU running at mhz (ESP32-S3, radio off)
+    static float activeMa(uint16_t mhz) {
+        return POWER_BOARD_MA + POWER_CPU_BASE_MA + POWER_CPU_MA_PER_MHZ * mhz;
+    }
+    
+    // Board current while loop() waits: light sleep, else the lowest clock
+    // esp_pm may pick, else the mode clock
+    static float idleMa(PowerMode mode, PowerSaving saving) {
+        if (saving == PM_LIGHT_SLEEP && modeLightSleeps(mode)) return POWER_BOARD_MA + POWER_LIGHT_SLEEP_MA;
+        return activeMa(saving == PM_NONE ? modeMhz(mode) : POWER_MIN_MHZ);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RESIDENCY (PowerManager::idle() around every wait)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void addAwake(PowerMode mode, uint32_t us) {
+        modes[mode].awake_us += us;
+    }
+    
+    void addIdle(PowerMode mode, uint32_t us) {
+        modes[mode].idle_us += us;
+        modes[mode].wakeups++;
+    }
+    
+    void reset() {
+        for (int i = 0; i < POWER_MODES; i++) modes[i] = Residency{};
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint64_t getTimeUs(PowerMode mode) {
+        return modes[mode].awake_us + modes[mode].idle_us;
+    }
+    
+    uint32_t getWakeups(PowerMode mode) {
+        return modes[mode].wakeups;
+    }
+    
+    // Share of the mode's time loop() was awake (0..1)
+    float awakeFraction(PowerMode mode) {
+        uint64_t total = getTimeUs(mode);
+        return total ? (float)modes[mode].awake_us / total : 0.0f;
+    }
+    
+    // Average current in a mode (0 if never entered)
+    float averageMa(PowerMode mode, PowerSaving saving) {
+        uint64_t total = getTimeUs(mode);
+        if (total == 0) return 0.0f;
+        float awake = awakeFraction(mode);
+        return awake * activeMa(modeMhz(mode)) + (1.0f - awake) * idleMa(mode, saving);
+    }
+    
+    // Average over every mode, weighted by time
+    float averageMa(PowerSaving saving) {
+        uint64_t total = 0;
+        float charge = 0;
+        for (int i = 0; i < POWER_MODES; i++) {
+            uint64_t t = getTimeUs((PowerMode)i);
+            total += t;
+            charge += averageMa((PowerMode)i, saving) * (float)t;
+        }
+        return total ? charge / total : 0.0f;
+    }
+};
+
+#endif // POWER_PROFILE_H
@@ -0,0 +1,140 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    SAMPLING POLICY - Module-Driven IMU Rate & Loop Sleep
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Turns the module's getSampleInterval() into what the shell programs:
+ * - FIFO rate: the slowest MPU6050 rate (1 kHz / n, n dividing 1000 so
+ *   burst timestamps stay exact) that still gives one sample per interval,
+ *   between SAMPLING_MIN_ODR_HZ and MODULE_BATCH_ODR_HZ
+ * - Batch period: how long loop() may sleep before draining the FIFO, at
+ *   most SAMPLING_FIFO_FILL % of it. The MPU6050 has no FIFO watermark
+ *   interrupt (only data-ready and overflow), so the watermark is this
+ *   period: getWatermark() samples are queued when the loop wakes
+ * - Triggers (a shock in a burst, an alert) run the full rate for
+ *   SAMPLING_BOOST_MS whatever the module asked
+ * Interval 0 (no hook, VM modules, a falling helmet, a moving vehicle)
+ * keeps the full rate and the SAMPLING_POLL_MS loop. No Arduino calls: the host tests run it as is
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef SAMPLING_POLICY_H
+#define SAMPLING_POLICY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "../modules/batch_kernels.h"
+
+#define MPU_FIFO_SAMPLES    (1024 / 12)   // Accel + gyro frames in the 1 KB FIFO
+
+class SamplingPolicy {
+private:
+    uint16_t odrHz = 0;
+    uint32_t periodMs = SAMPLING_POLL_MS;
+    uint32_t lastBatch = 0;
+    bool boosted = false;
+    uint32_t boostUntil = 0;
+    
+    // Stats
+    uint32_t rateChanges = 0;
+    uint32_t triggers = 0;
+    uint32_t wakeups = 0;
+
+public:
+    // Slowest exact FIFO rate with at least one sample per interval
+    static uint16_t odrFor(uint32_t interval_ms) {
+        uint32_t need = interval_ms == 0 ? MODULE_BATCH_ODR_HZ : (1000 + interval_ms - 1) / interval_ms;
+        for (uint16_t d = 1000 / SAMPLING_MIN_ODR_HZ; d > 1000 / MODULE_BATCH_ODR_HZ; d--) {
+            if (1000 % d == 0 && 1000 / d >= need) return 1000 / d;
+        }
+        return MODULE_BATCH_ODR_HZ;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PLAN (once per loop, before the FIFO is read)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // interval_ms: the module's getSampleInterval(), 0 = every sample.
+    // True when the FIFO rate changed: drain the FIFO, then reprogram it
+    bool plan(uint32_t interval_ms, uint32_t now_ms) {
+        if (boosted && (int32_t)(now_ms - boostUntil) >= 0) boosted = false;
+        if (boosted) interval_ms = 0;
+        
+        uint16_t odr = odrFor(interval_ms);
+        uint32_t period = interval_ms == 0 ? SAMPLING_POLL_MS : interval_ms;
+        uint32_t fifoMs = (uint32_t)MPU_FIFO_SAMPLES * SAMPLING_FIFO_FILL / 100 * 1000 / odr;
+        if (period > fifoMs) period = fifoMs;
+        if (period < SAMPLING_POLL_MS) period = SAMPLING_POLL_MS;
+        periodMs = period;
+        
+        if (odr == odrHz) return false;
+        odrHz = odr;
+        rateChanges++;
+        return true;
+    }
+    
+    // Full rate for SAMPLING_BOOST_MS (extended by every trigger)
+    void trigger(uint32_t now_ms) {
+        boosted = true;
+        boostUntil = now_ms + SAMPLING_BOOST_MS;
+        triggers++;
+    }
+    
+    // A sample SAMPLING_TRIGGER_G or more away from 1 g (shock or free-fall)
+    static bool isShock(const SensorData* samples, size_t n) {
+        float magSq[MODULE_BATCH_MAX];
+        const float hi = (1.0f + SAMPLING_TRIGGER_G) * 9.81f;
+        const float lo = SAMPLING_TRIGGER_G < 1.0f ? (1.0f - SAMPLING_TRIGGER_G) * 9.81f : 0.0f;
+        while (n > 0) {
+            size_t chunk = n < MODULE_BATCH_MAX ? n : MODULE_BATCH_MAX;
+            accelMagnitudeSq(samples, chunk, magSq);
+            if (firstAbove(magSq, chunk, hi * hi) < chunk) return true;
+            if (firstBelow(magSq, chunk, lo * lo) < chunk) return true;
+            samples += chunk;
+            n -= chunk;
+        }
+        return false;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // BATCHES & SLEEP
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool batchDue(uint32_t now_ms) {
+        return now_ms - lastBatch >= periodMs;
+    }
+    
+    void batchDone(uint32_t now_ms) {
+        lastBatch = now_ms;
+    }
+    
+    // How long loop() sleeps: until the next batch, at most
+    // SAMPLING_MAX_SLEEP_MS. busy (radio, phone, transfer) = SAMPLING_POLL_MS
+    uint32_t sleepMs(uint32_t now_ms, bool busy) {
+        wakeups++;
+        if (busy) return SAMPLING_POLL_MS;
+        uint32_t elapsed = now_ms - lastBatch;
+        uint32_t wait = elapsed >= periodMs ? 1 : periodMs - elapsed;
+        return wait < SAMPLING_MAX_SLEEP_MS ? wait : SAMPLING_MAX_SLEEP_MS;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATUS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint16_t getOdr() { return odrHz; }
+    uint32_t getPeriod() { return periodMs; }
+    uint32_t getWatermark() {
+        uint32_t n = periodMs * odrHz / 1000;
+        return n > 0 ? n : 1;
+    }
+    bool isBoosted() { return boosted; }
+    uint32_t getRateChanges() { return rateChanges; }
+    uint32_t getTriggers() { return triggers; }
+    uint32_t getWakeups() { return wakeups; }
+};
+
+#endif // SAMPLING_POLICY_H
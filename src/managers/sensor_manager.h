@@ -17,12 +17,37 @@
 #include <Adafruit_Sensor.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "../ble/capture_stream.h"
+
+// MPU6050 registers used directly for FIFO capture
+#define MPU_ADDR            0x68
+#define MPU_REG_FIFO_EN     0x23
+#define MPU_REG_INT_STATUS  0x3A
+#define MPU_REG_USER_CTRL   0x6A
+#define MPU_REG_FIFO_COUNT  0x72
+#define MPU_REG_FIFO_RW     0x74
+#define MPU_FIFO_ACCEL_GYRO 0x78    // XG, YG, ZG, ACCEL: 12 bytes per sample
+#define MPU_FIFO_FRAME      12
+#define MPU_USER_FIFO_EN    0x40
+#define MPU_USER_FIFO_RESET 0x04
+#define MPU_INT_FIFO_OFLOW  0x10
+#define MPU_ACCEL_LSB_4G    8192    // LSB per g at ±4 g
+#define MPU_GYRO_LSB_500    655     // LSB per 10 deg/s at ±500 deg/s
 
 class SensorManager {
 private:
     Adafruit_MPU6050 mpu;
     bool initialized = false;
     
+    // FIFO capture (the capture task owns the I2C reads while it runs)
+    volatile bool capturing = false;
+    RawImuSample lastRaw = {{0, 0, 0}, {0, 0, 0}};
+    
+    // Module stream: FIFO bursts for updateBatch() while no capture runs
+    uint16_t streamOdr = 0;
+    uint32_t streamOverflows = 0;
+    float lastTemperature = 0;
+    
     // Calibration offsets
     float axOffset = 0, ayOffset = 0, azOffset = 0;
     float gxOffset = 0, gyOffset = 0, gzOffset = 0;
@@ -103,6 +128,13 @@ public:
     bool readSensorData(SensorData &data) {
         if (!initialized) return false;
         
+        // While capturing, the FIFO is the only reader: modules see its newest sample
+        if (capturing) {
+            toSensorData(lastRaw, data);
+            data.timestamp = millis();
+            return true;
+        }
+        
         sensors_event_t a, g, temp;
         mpu.getEvent(&a, &g, &temp);
         
@@ -117,10 +149,174 @@ public:
         
         data.temperature = temp.temperature;
         data.timestamp = millis();
+        lastTemperature = temp.temperature;
+        
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // FIFO CAPTURE (raw samples at the full ODR, see CaptureManager)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool beginCapture(uint16_t odr_hz) {
+        if (!initialized || odr_hz == 0 || odr_hz > 1000) return false;
         
+        // 184 Hz DLPF keeps the internal rate at 1 kHz, the divider sets the ODR
+        mpu.setFilterBandwidth(MPU6050_BAND_184_HZ);
+        startFifo(odr_hz);
+        
+        capturing = true;
+        Serial.printf("[SENSOR] 🎥 FIFO capture at %u Hz\n", odr_hz);
         return true;
     }
     
+    // Reads whole samples from the FIFO. On overflow the FIFO is reset
+    // (its contents are misaligned) and nothing is returned
+    size_t readFifo(RawImuSample* out, size_t max, bool& overflow) {
+        overflow = false;
+        if (!capturing) return 0;
+        size_t done = drainFifo(out, max, overflow);
+        if (done > 0) lastRaw = out[done - 1];
+        return done;
+    }
+    
+    void endCapture() {
+        if (!capturing) return;
+        capturing = false;
+        
+        if (streamOdr) {
+            // The module stream gets the FIFO back
+            mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
+            startFifo(streamOdr);
+            Serial.println("[SENSOR] 🎥 FIFO capture stopped, module stream resumed");
+            return;
+        }
+        writeReg(MPU_REG_FIFO_EN, 0);
+        writeReg(MPU_REG_USER_CTRL, MPU_USER_FIFO_RESET);
+        mpu.setSampleRateDivisor(0);
+        mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
+        Serial.println("[SENSOR] 🎥 FIFO capture stopped");
+    }
+    
+    bool isCapturing() {
+        return capturing;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // MODULE STREAM (every sample at odr_hz for updateBatch, read by loop())
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool beginStream(uint16_t odr_hz) {
+        if (!initialized || odr_hz == 0 || odr_hz > 1000) return false;
+        streamOdr = odr_hz;
+        if (!capturing) startFifo(odr_hz);   // Else taken over after the capture
+        Serial.printf("[SENSOR] 📥 Module stream at %u Hz\n", odr_hz);
+        return true;
+    }
+    
+    // New stream rate (SamplingPolicy). The FIFO restarts empty: read the
+    // burst queued at the old rate first
+    bool setStreamRate(uint16_t odr_hz) {
+        if (!streamOdr || odr_hz == 0 || odr_hz > 1000) return false;
+        if (odr_hz == streamOdr) return true;
+        streamOdr = odr_hz;
+        if (!capturing) startFifo(odr_hz);   // Else taken over after the capture
+        Serial.printf("[SENSOR] 📥 Module stream now %u Hz\n", odr_hz);
+        return true;
+    }
+    
+    uint16_t getStreamRate() {
+        return streamOdr;
+    }
+    
+    // False while a capture owns the FIFO (modules get readSensorData())
+    bool isStreaming() {
+        return streamOdr != 0 && !capturing;
+    }
+    
+    // Samples queued since the last call, oldest first. Timestamps are
+    // spread back from now at the stream rate
+    size_t readBurst(SensorData* out, size_t max) {
+        if (!isStreaming()) return 0;
+        RawImuSample raw[MODULE_BATCH_MAX];
+        bool overflow;
+        size_t n = drainFifo(raw, max < MODULE_BATCH_MAX ? max : MODULE_BATCH_MAX, overflow);
+        if (overflow) {
+            streamOverflows++;
+            Serial.println("[SENSOR] ⚠️ Module stream overflow: loop() stalled, samples lost");
+        }
+        
+        unsigned long now = millis();
+        for (size_t i = 0; i < n; i++) {
+            toSensorData(raw[i], out[i]);
+            out[i].timestamp = now - (unsigned long)((n - 1 - i) * 1000 / streamOdr);
+        }
+        return n;
+    }
+    
+    uint32_t getStreamOverflows() {
+        return streamOverflows;
+    }
+
+private:
+    // FIFO on at odr_hz (1 kHz internal rate / divider), emptied
+    void startFifo(uint16_t odr_hz) {
+        mpu.setSampleRateDivisor((uint8_t)(1000 / odr_hz - 1));
+        writeReg(MPU_REG_USER_CTRL, MPU_USER_FIFO_RESET);
+        writeReg(MPU_REG_FIFO_EN, MPU_FIFO_ACCEL_GYRO);
+        writeReg(MPU_REG_USER_CTRL, MPU_USER_FIFO_EN);
+        readReg(MPU_REG_INT_STATUS);   // Clears a stale overflow flag
+    }
+    
+    size_t drainFifo(RawImuSample* out, size_t max, bool& overflow) {
+        overflow = false;
+        if (readReg(MPU_REG_INT_STATUS) & MPU_INT_FIFO_OFLOW) {
+            writeReg(MPU_REG_USER_CTRL, MPU_USER_FIFO_EN | MPU_USER_FIFO_RESET);
+            overflow = true;
+            return 0;
+        }
+        
+        uint8_t count[2];
+        if (!readRegs(MPU_REG_FIFO_COUNT, count, 2)) return 0;
+        size_t n = ((count[0] << 8) | count[1]) / MPU_FIFO_FRAME;
+        if (n > max) n = max;
+        
+        // Wire buffers 128 bytes: 10 samples per transaction
+        uint8_t buf[10 * MPU_FIFO_FRAME];
+        size_t done = 0;
+        while (done < n) {
+            size_t chunk = n - done;
+            if (chunk > 10) chunk = 10;
+            if (!readRegs(MPU_REG_FIFO_RW, buf, chunk * MPU_FIFO_FRAME)) break;
+            
+            // Big endian, accel x,y,z then gyro x,y,z
+            for (size_t i = 0; i < chunk; i++) {
+                const uint8_t* p = &buf[i * MPU_FIFO_FRAME];
+                RawImuSample& s = out[done + i];
+                for (int a = 0; a < 3; a++) {
+                    s.accel[a] = (int16_t)((p[a * 2] << 8) | p[a * 2 + 1]);
+                    s.gyro[a] = (int16_t)((p[6 + a * 2] << 8) | p[6 + a * 2 + 1]);
+                }
+            }
+            done += chunk;
+        }
+        return done;
+    }
+    
+    // Raw counts → calibrated SensorData (no timestamp)
+    void toSensorData(const RawImuSample& s, SensorData& data) {
+        const float g = 9.81f / MPU_ACCEL_LSB_4G;
+        const float dps = 10.0f / MPU_GYRO_LSB_500 * (PI / 180.0f);  // Adafruit reports rad/s
+        data.accel_x = s.accel[0] * g - axOffset;
+        data.accel_y = s.accel[1] * g - ayOffset;
+        data.accel_z = s.accel[2] * g - azOffset;
+        data.gyro_x = s.gyro[0] * dps - gxOffset;
+        data.gyro_y = s.gyro[1] * dps - gyOffset;
+        data.gyro_z = s.gyro[2] * dps - gzOffset;
+        data.temperature = lastTemperature;   // Not in the FIFO
+    }
+
+public:
     // ───────────────────────────────────────────────────────────────────────
     // GET ACCELERATION MAGNITUDE (in g's)
     // ───────────────────────────────────────────────────────────────────────
@@ -238,6 +434,29 @@ private:
         return zero_crossings / (2.0 * duration);
     }
     
+    // Raw register access (FIFO capture; the Adafruit driver has no FIFO API)
+    void writeReg(uint8_t reg, uint8_t value) {
+        Wire.beginTransmission(MPU_ADDR);
+        Wire.write(reg);
+        Wire.write(value);
+        Wire.endTransmission();
+    }
+    
+    uint8_t readReg(uint8_t reg) {
+        uint8_t value = 0;
+        readRegs(reg, &value, 1);
+        return value;
+    }
+    
+    bool readRegs(uint8_t reg, uint8_t* out, size_t len) {
+        Wire.beginTransmission(MPU_ADDR);
+        Wire.write(reg);
+        if (Wire.endTransmission(false) != 0) return false;
+        if (Wire.requestFrom((uint8_t)MPU_ADDR, (uint8_t)len) != len) return false;
+        for (size_t i = 0; i < len; i++) out[i] = Wire.read();
+        return true;
+    }
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // DEBUG
@@ -0,0 +1,249 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    VM MODULE MANAGER - Modules Without a Reflash
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Runs a bytecode module (src/vm, compiled by backend/module-compiler.js)
+ * in place of the compiled-in CurrentModule:
+ * - The phone writes the program in pieces (MODULE_WRITE) and commits it;
+ *   the BLE task only fills the spare buffer and verifies it
+ * - loop() swaps it in between two updates: a pointer flip and a state
+ *   reset, no reboot. The time is logged in µs
+ * - The program is kept in the "uadmod" data partition (partitions.csv)
+ *   and loaded again at boot; MODULE_UNLOAD erases it and the native
+ *   module takes over again
+ * - A module that faults (step limit) is stopped and the native module
+ *   runs instead until another program is loaded
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef VM_MODULE_MANAGER_H
+#define VM_MODULE_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "../include/config.h"
+#include "../include/types.h"
+#include "../ble/ble_command.h"
+#include "../vm/module_vm.h"
+
+class VmModuleManager {
+private:
+    ModuleVm vm;
+    
+    // One buffer runs, the other receives the next program
+    alignas(4) uint8_t buffers[2][VM_PROGRAM_MAX];
+    uint8_t activeBuf = 0;
+    const esp_partition_t* partition = nullptr;
+    
+    // Requests from the BLE task
+    volatile bool swapRequested = false;
+    volatile bool unloadRequested = false;
+    uint16_t stagedLen = 0;
+    
+    // Alert pattern (3 pulses) without blocking the loop
+    uint32_t alertStart = 0;
+    bool alertActive = false;
+    
+    bool faultReported = false;
+    uint32_t lastSwapUs = 0;
+    uint32_t swaps = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // INITIALIZATION (program from the partition, if one was kept)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void begin() {
+        pinMode(LED_PIN, OUTPUT);
+        pinMode(VIB_MOTOR_PIN, OUTPUT);
+        vm.setSyscall(onSyscall, this);
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                             (esp_partition_subtype_t)VM_PARTITION_SUBTYPE,
+                                             VM_PARTITION_LABEL);
+        if (!partition) {
+            Serial.println("[VM] ⚠️ No '" VM_PARTITION_LABEL "' partition: modules are not kept over a reboot");
+            return;
+        }
+        
+        uint8_t* buf = buffers[activeBuf];
+        if (esp_partition_read(partition, 0, buf, VM_HEADER_LEN) != ESP_OK) return;
+        size_t size = vmProgramSize(buf);
+        if (size == 0) return;   // Erased: no module kept
+        
+        VmError err = VM_ERR_SIZE;
+        if (size <= VM_PROGRAM_MAX && esp_partition_read(partition, 0, buf, size) == ESP_OK) {
+            err = vm.load(buf, size);
+        }
+        if (err != VM_OK) {
+            Serial.printf("[VM] ❌ Kept module rejected: %s\n", vmErrorName(err));
+            return;
+        }
+        Serial.printf("[VM] ✅ Module '%s' loaded from flash (%u bytes)\n",
+                      vm.getProgram().name, (unsigned)size);
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // COMMANDS (BLE task: fill the spare buffer, hand the swap to loop())
+    // ───────────────────────────────────────────────────────────────────────
+    
+    BleCmdStatus write(uint16_t offset, const uint8_t* data, size_t len) {
+        if (swapRequested || unloadRequested) return BLE_CMD_BUSY;
+        if (offset + len > VM_PROGRAM_MAX) return BLE_CMD_BAD_VALUE;
+        memcpy(&buffers[activeBuf ^ 1][offset], data, len);
+        return BLE_CMD_OK;
+    }
+    
+    // size: whole program. Reply: [0] VmError
+    BleCmdStatus commit(uint16_t size, BleReply& reply) {
+        if (swapRequested || unloadRequested) return BLE_CMD_BUSY;
+        VmProgram p;
+        VmError err = size > VM_PROGRAM_MAX ? VM_ERR_SIZE : vmVerify(buffers[activeBuf ^ 1], size, p);
+        reply.put8(err);
+        if (err != VM_OK) return BLE_CMD_BAD_VALUE;
+        stagedLen = size;
+        swapRequested = true;
+        return BLE_CMD_OK;
+    }
+    
+    BleCmdStatus requestUnload() {
+        if (!vm.isLoaded() || swapRequested) return BLE_CMD_BAD_VALUE;
+        unloadRequested = true;
+        return BLE_CMD_OK;
+    }
+    
+    // [0] bit0 loaded, bit1 running, bit2 swap pending  [1] context  [2] fault
+    // [3..4] size  [5..8] CRC-32  [9..10] last swap µs  [11..] name
+    void info(BleReply& reply) {
+        const VmProgram& p = vm.getProgram();
+        bool loaded = vm.isLoaded();
+        reply.put8((loaded ? 0x01 : 0) | (vm.isRunning() ? 0x02 : 0) | (swapRequested ? 0x04 : 0));
+        reply.put8(loaded ? p.context : 0);
+        reply.put8(vm.getFault());
+        reply.put16(loaded ? p.size : 0);
+        reply.put32(loaded ? p.crc : 0);
+        reply.put16(lastSwapUs > 0xFFFF ? 0xFFFF : lastSwapUs);
+        if (loaded) reply.putBytes((const uint8_t*)p.name, strlen(p.name));
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // UPDATE (loop): swap, persist, alert pattern
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void update() {
+        if (swapRequested) swap();
+        if (unloadRequested) {
+            vm.unload();
+            if (partition) esp_partition_erase_range(partition, 0, 4096);   // Header gone: nothing loads at boot
+            unloadRequested = false;
+            Serial.println("[VM] ⏏️ Module unloaded, native module active");
+        }
+        
+        if (vm.isLoaded() && !vm.isRunning() && !faultReported) {
+            faultReported = true;
+            Serial.printf("[VM] ❌ Module '%s' stopped: %s after %lu instructions, native module active\n",
+                          vm.getProgram().name, vmErrorName(vm.getFault()), (unsigned long)vm.getLastSteps());
+        }
+        
+        if (alertActive) {
+            uint32_t t = millis() - alertStart;
+            bool on = t < 1500 && t % 500 < 300;
+            analogWrite(VIB_MOTOR_PIN, on ? 255 : 0);
+            digitalWrite(LED_PIN, on ? HIGH : LOW);
+            if (t >= 1500) alertActive = false;
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // MODULE INTERFACE (as CurrentModule)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool isRunning() const { return vm.isRunning(); }
+    
+    ContextType getContext() const { return (ContextType)vm.getProgram().context; }
+    
+    void update(const SensorData& data) {
+        VmCell in[VM_INPUTS];
+        in[VM_IN_AX].f = data.accel_x;
+        in[VM_IN_AY].f = data.accel_y;
+        in[VM_IN_AZ].f = data.accel_z;
+        in[VM_IN_GX].f = data.gyro_x;
+        in[VM_IN_GY].f = data.gyro_y;
+        in[VM_IN_GZ].f = data.gyro_z;
+        in[VM_IN_TEMP].f = data.temperature;
+        in[VM_IN_NOW].i = (int32_t)millis();
+        vm.update(in);
+    }
+    
+    TelemetryData getTelemetry() {
+        TelemetryData data = {0, STATUS_OK};
+        int32_t value, status;
+        if (vm.telemetry(value, status)) {
+            data.sensor_val = value < 0 ? 0 : value > 0xFFFF ? 0xFFFF : value;
+            data.status = (StatusCode)status;
+        }
+        return data;
+    }
+    
+    bool setParam(uint8_t id, int32_t value) { return vm.setParam(id, value); }
+    bool getParam(uint8_t id, int32_t& value) { return vm.getParam(id, value); }
+    
+    void printDebug() {
+        Serial.printf("[VM] '%s': %lu / %lu instructions per call (last / max), %lu swaps\n",
+                      vm.getProgram().name, (unsigned long)vm.getLastSteps(),
+                      (unsigned long)vm.getMaxSteps(), (unsigned long)swaps);
+    }
+
+private:
+    void swap() {
+        uint8_t next = activeBuf ^ 1;
+        uint32_t start = micros();
+        VmError err = vm.load(buffers[next], stagedLen);
+        lastSwapUs = micros() - start;
+        if (err == VM_OK) {
+            activeBuf = next;
+            faultReported = false;
+            swaps++;
+            Serial.printf("[VM] 🔁 Module '%s' swapped in after %lu us (%u bytes)\n",
+                          vm.getProgram().name, (unsigned long)lastSwapUs, (unsigned)stagedLen);
+            persist();
+        } else {
+            Serial.printf("[VM] ❌ Module rejected: %s\n", vmErrorName(err));
+        }
+        swapRequested = false;
+    }
+    
+    // One sector erase + write (~50 ms), after the module already runs
+    void persist() {
+        if (!partition) return;
+        size_t sectors = (stagedLen + 4095) & ~(size_t)4095;
+        if (esp_partition_erase_range(partition, 0, sectors) != ESP_OK ||
+            esp_partition_write(partition, 0, buffers[activeBuf], stagedLen) != ESP_OK) {
+            Serial.println("[VM] ⚠️ Module not saved: the next boot runs the native module");
+        }
+    }
+    
+    static void onSyscall(VmSyscall id, VmCell arg, void* ctx) {
+        VmModuleManager* self = (VmModuleManager*)ctx;
+        switch (id) {
+            case VM_SYS_LOG_INT:
+                Serial.printf("[VM] %s: %ld\n", self->vm.getProgram().name, (long)arg.i);
+                break;
+            case VM_SYS_LOG_FLOAT:
+                Serial.printf("[VM] %s: %.3f\n", self->vm.getProgram().name, arg.f);
+                break;
+            case VM_SYS_LED:
+                digitalWrite(LED_PIN, arg.i ? HIGH : LOW);
+                break;
+            case VM_SYS_ALERT:
+                self->alertStart = millis();
+                self->alertActive = true;
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+#endif // VM_MODULE_MANAGER_H
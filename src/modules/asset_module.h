@@ -10,8 +10,13 @@
 #include <Arduino.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "module_base.h"
 
-class AssetModule {
+class AssetModule : public ModuleBase<AssetModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_ASSET;
+    static constexpr const char* NAME = "ASSET";
+    
 private:
     unsigned long stationaryStartTime = 0;
     unsigned int minutesStationary = 0;
@@ -32,15 +37,15 @@ public:
         digitalWrite(LED_PIN, LOW);
     }
     
-    void update(SensorData data) {
+    void update(const SensorData& data) {
         float magnitude = sqrt(
             data.accel_x * data.accel_x +
             data.accel_y * data.accel_y +
             data.accel_z * data.accel_z
         ) / 9.81;
         
-        // Check for motion (potential theft)
-        if (magnitude > motionThreshold) {
+        // Check for motion (potential theft): away from the 1 g of rest
+        if (fabs(magnitude - 1.0f) > motionThreshold) {
             Serial.println("[ASSET] ⚠️ MOTION DETECTED - Possible theft!");
             theftAlarm = true;
             stationaryStartTime = millis();  // Reset timer
@@ -62,6 +67,10 @@ public:
         return data;
     }
     
+    uint32_t getSampleInterval() {
+        return theftAlarm ? ASSET_ALARM_SAMPLE_MS : ASSET_SAMPLE_MS;
+    }
+    
     void handleAlert() {
         Serial.println("[ASSET] 🚨 Manual alert triggered");
     }
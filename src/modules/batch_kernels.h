@@ -0,0 +1,71 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BATCH KERNELS - Threshold Scans over Sample Bursts
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Building blocks for a module's updateBatch() (FIFO bursts):
+ * - accelMagnitudeSq: |a|² of every sample in one pass. Thresholds are
+ *   compared squared, so no sqrt per sample
+ * - firstBelow / firstAbove: blocks of 8 are OR-reduced without a branch
+ *   and only the block with a hit is searched. Quiet samples, the usual
+ *   case, cost a few arithmetic instructions each
+ * - maxOf: peak of a burst
+ * Plain loops the compiler unrolls (and vectorizes where the target has
+ * float SIMD); no intrinsics, so the host tests run the same code
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/types.h"
+
+#define BATCH_BLOCK 8
+
+// out[i] = ax² + ay² + az² ((m/s²)²)
+inline void accelMagnitudeSq(const SensorData* samples, size_t n, float* out) {
+    for (size_t i = 0; i < n; i++) {
+        const SensorData& s = samples[i];
+        out[i] = s.accel_x * s.accel_x + s.accel_y * s.accel_y + s.accel_z * s.accel_z;
+    }
+}
+
+// Index of the first v[i] < limit, n if none
+inline size_t firstBelow(const float* v, size_t n, float limit) {
+    size_t i = 0;
+    for (; i + BATCH_BLOCK <= n; i += BATCH_BLOCK) {
+        int hit = 0;
+        for (size_t k = 0; k < BATCH_BLOCK; k++) hit |= v[i + k] < limit;
+        if (hit) break;
+    }
+    for (; i < n; i++) {
+        if (v[i] < limit) return i;
+    }
+    return n;
+}
+
+// Index of the first v[i] > limit, n if none
+inline size_t firstAbove(const float* v, size_t n, float limit) {
+    size_t i = 0;
+    for (; i + BATCH_BLOCK <= n; i += BATCH_BLOCK) {
+        int hit = 0;
+        for (size_t k = 0; k < BATCH_BLOCK; k++) hit |= v[i + k] > limit;
+        if (hit) break;
+    }
+    for (; i < n; i++) {
+        if (v[i] > limit) return i;
+    }
+    return n;
+}
+
+// Largest v[i] (n > 0)
+inline float maxOf(const float* v, size_t n) {
+    float m = v[0];
+    for (size_t i = 1; i < n; i++) m = v[i] > m ? v[i] : m;
+    return m;
+}
+
+#endif // BATCH_KERNELS_H
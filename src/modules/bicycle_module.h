@@ -10,8 +10,13 @@
 #include <Arduino.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "module_base.h"
 
-class BicycleModule {
+class BicycleModule : public ModuleBase<BicycleModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_BICYCLE;
+    static constexpr const char* NAME = "BICYCLE";
+    
 private:
     float currentSpeed = 0;        // km/h
     float leanAngle = 0;           // degrees
@@ -33,7 +38,7 @@ public:
         }
     }
     
-    void update(SensorData data) {
+    void update(const SensorData& data) {
         // Estimate speed from acceleration integration (simplified)
         float accel_magnitude = sqrt(
             data.accel_x * data.accel_x +
@@ -65,6 +70,10 @@ public:
         return data;
     }
     
+    uint32_t getSampleInterval() {
+        return isMoving ? BICYCLE_SAMPLE_MS : BICYCLE_STOPPED_SAMPLE_MS;
+    }
+    
     void handleAlert() {
         Serial.println("[BICYCLE] ⚠️ Alert triggered");
     }
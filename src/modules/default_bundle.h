@@ -16,6 +16,7 @@
 #ifndef DEFAULT_BUNDLE_H
 #define DEFAULT_BUNDLE_H
 
+#include "../include/config.h"
 #include "../include/types.h"
 #include <Arduino.h>
 
@@ -75,6 +76,11 @@ public:
         }
     }
     
+    // A status screen and a 10 Hz level need no more
+    uint32_t getSampleInterval() {
+        return BUNDLE_SAMPLE_MS;
+    }
+    
     TelemetryData getTelemetry() {
         TelemetryData t;
         t.status = STATUS_OK;
@@ -15,14 +15,25 @@
 #include <Arduino.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "module_base.h"
+#include "batch_kernels.h"
 
-class HelmetModule {
+class HelmetModule : public ModuleBase<HelmetModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_HELMET;
+    static constexpr const char* NAME = "HELMET";
+    
 private:
     bool inFreeFall = false;
     unsigned long freeFallStart = 0;
     bool fallDetected = false;
     float lastImpact = 0;
     
+    // Tunable over BLE (PARAM_SET / PARAM_GET)
+    float freefallG = FREEFALL_THRESHOLD;
+    float impactG = IMPACT_THRESHOLD;
+    unsigned long fallWindowMs = FALL_WINDOW_MS;
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // INITIALIZATION
@@ -48,7 +59,7 @@ public:
     // UPDATE (call in main loop with sensor data)
     // ───────────────────────────────────────────────────────────────────────
     
-    void update(SensorData data) {
+    void update(const SensorData& data) {
         float magnitude = sqrt(
             data.accel_x * data.accel_x +
             data.accel_y * data.accel_y +
@@ -58,17 +69,17 @@ public:
         // Fall detection state machine
         if (!inFreeFall) {
             // Check for free-fall (weightlessness)
-            if (magnitude < FREEFALL_THRESHOLD) {
+            if (magnitude < freefallG) {
                 inFreeFall = true;
-                freeFallStart = millis();
+                freeFallStart = data.timestamp;
                 Serial.println("[HELMET] ⚠️ Free-fall detected!");
             }
         } else {
             // In free-fall, check for impact
-            if (magnitude > IMPACT_THRESHOLD) {
-                if (millis() - freeFallStart < FALL_WINDOW_MS) {
+            if (magnitude > impactG) {
+                if (data.timestamp - freeFallStart < fallWindowMs) {
                     // FALL DETECTED!
-                    fall Detected = true;
+                    fallDetected = true;
                     lastImpact = magnitude;
                     Serial.printf("[HELMET] 🚨 FALL DETECTED! Impact: %.2fg\n", magnitude);
                     triggerAlert();
@@ -76,12 +87,64 @@ public:
                 inFreeFall = false;
             }
             // Timeout - wasn't a fall
-            else if (millis() - freeFallStart > FALL_WINDOW_MS) {
+            else if (data.timestamp - freeFallStart > fallWindowMs) {
                 inFreeFall = false;
             }
         }
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // UPDATE BATCH (FIFO burst): same state machine as update(), but the
+    // burst is scanned for the next threshold crossing instead of stepping
+    // through every sample
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void updateBatch(const SensorData* samples, size_t n) {
+        float magSq[MODULE_BATCH_MAX];
+        const float freefallSq = (freefallG * 9.81f) * (freefallG * 9.81f);
+        const float impactSq = (impactG * 9.81f) * (impactG * 9.81f);
+        
+        while (n > 0) {
+            size_t chunk = n < MODULE_BATCH_MAX ? n : MODULE_BATCH_MAX;
+            accelMagnitudeSq(samples, chunk, magSq);
+            
+            size_t i = 0;
+            while (i < chunk) {
+                if (!inFreeFall) {
+                    i += firstBelow(&magSq[i], chunk - i, freefallSq);
+                    if (i == chunk) break;
+                    inFreeFall = true;
+                    freeFallStart = samples[i].timestamp;
+                    Serial.println("[HELMET] ⚠️ Free-fall detected!");
+                    i++;
+                    continue;
+                }
+                
+                // Impact, or the window running out before one
+                size_t hit = i + firstAbove(&magSq[i], chunk - i, impactSq);
+                size_t expiry = i;
+                while (expiry < hit && samples[expiry].timestamp - freeFallStart <= fallWindowMs) expiry++;
+                if (expiry < hit) {
+                    inFreeFall = false;
+                    i = expiry + 1;
+                } else if (hit < chunk) {
+                    if (samples[hit].timestamp - freeFallStart < fallWindowMs) {
+                        fallDetected = true;
+                        lastImpact = sqrt(magSq[hit]) / 9.81f;
+                        Serial.printf("[HELMET] 🚨 FALL DETECTED! Impact: %.2fg\n", lastImpact);
+                        triggerAlert();
+                    }
+                    inFreeFall = false;
+                    i = hit + 1;
+                } else {
+                    break;
+                }
+            }
+            samples += chunk;
+            n -= chunk;
+        }
+    }
+    
     // ───────────────────────────────────────────────────────────────────────
     // GET TELEMETRY DATA
     // ───────────────────────────────────────────────────────────────────────
@@ -138,6 +201,54 @@ public:
         return false;
     }
     
+    // ───────────────────────────────────────────────────────────────────────
+    // SAMPLING (SamplingPolicy: FIFO rate and loop sleep)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Free-fall lasts hundreds of ms, the impact peak only a few: every
+    // sample once falling
+    uint32_t getSampleInterval() {
+        return inFreeFall ? 0 : HELMET_SAMPLE_MS;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // PARAMETERS (g values in milli-g; false = unknown id or out of range)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    enum Param : uint8_t {
+        PARAM_FREEFALL_MG = 1,
+        PARAM_IMPACT_MG = 2,
+        PARAM_FALL_WINDOW_MS = 3
+    };
+    
+    bool setParam(uint8_t id, int32_t value) {
+        switch (id) {
+            case PARAM_FREEFALL_MG:
+                if (value < 50 || value > 1000) return false;
+                freefallG = value / 1000.0f;
+                return true;
+            case PARAM_IMPACT_MG:
+                if (value < 1000 || value > 16000) return false;
+                impactG = value / 1000.0f;
+                return true;
+            case PARAM_FALL_WINDOW_MS:
+                if (value < 100 || value > 5000) return false;
+                fallWindowMs = value;
+                return true;
+            default:
+                return false;
+        }
+    }
+    
+    bool getParam(uint8_t id, int32_t& value) {
+        switch (id) {
+            case PARAM_FREEFALL_MG:    value = (int32_t)(freefallG * 1000.0f + 0.5f); return true;
+            case PARAM_IMPACT_MG:      value = (int32_t)(impactG * 1000.0f + 0.5f); return true;
+            case PARAM_FALL_WINDOW_MS: value = (int32_t)fallWindowMs; return true;
+            default:                   return false;
+        }
+    }
+    
     // ───────────────────────────────────────────────────────────────────────
     // DEBUG
     // ───────────────────────────────────────────────────────────────────────
@@ -0,0 +1,67 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE BASE - Static Module Interface (CRTP)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * What ModuleRegistry calls on a module, bound at compile time:
+ *   class HelmetModule : public ModuleBase<HelmetModule> {
+ *       static constexpr ContextType CONTEXT = CTX_HELMET;
+ *       static constexpr const char* NAME = "HELMET";
+ *       void init();                           // once, at boot
+ *       void update(const SensorData& data);
+ *       TelemetryData getTelemetry();
+ *       ...                                    // optional: see below
+ *   };
+ * A module hides the defaults it implements; no vtable, every call is
+ * inlined into the registry's dispatch. The required methods and their
+ * signatures are checked by ModuleContract (module_contract.h)
+ * 
+ * LoRa samples as schema records (no default, detected by main.cpp):
+ *   typedef VehicleSchema Schema;                  // src/lora/schemas/
+ *   void getSchemaRecord(VehicleRecord& r);        // one per sample
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MODULE_BASE_H
+#define MODULE_BASE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+#include "../include/types.h"
+
+template <typename Derived>
+class ModuleBase {
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // OPTIONAL HOOKS (defaults)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // Becomes / stops being the active module (no blocking work: the
+    // classifier switches modules from loop())
+    void onActivate() {}
+    void onDeactivate() {}
+    
+    void handleAlert() {}
+    void printDebug() {}
+
+    // A FIFO burst, oldest first. Default: update() per sample; modules
+    // with a batch kernel (batch_kernels.h) scan the whole burst at once
+    void updateBatch(const SensorData* samples, size_t n) {
+        for (size_t i = 0; i < n; i++) static_cast<Derived*>(this)->update(samples[i]);
+    }
+    
+    // PARAM_SET / PARAM_GET: false = unknown id or out of range
+    bool setParam(uint8_t, int32_t) { return false; }
+    bool getParam(uint8_t, int32_t&) { return false; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // IDENTITY (from the module's constants)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static constexpr ContextType context() { return Derived::CONTEXT; }
+    static constexpr const char* name() { return Derived::NAME; }
+};
+
+#endif // MODULE_BASE_H
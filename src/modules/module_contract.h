@@ -0,0 +1,122 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE CONTRACT - What the Shell Calls on a Module
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Checked at compile time (static_assert, the toolchain is gnu++17):
+ *   void init();
+ *   void update(const SensorData& data);
+ *   TelemetryData getTelemetry();
+ * Optional, checked only when the module declares them:
+ *   uint32_t getSampleInterval();                          // ms between updates, 0 = every loop
+ *   void updateBatch(const SensorData* samples, size_t n); // FIFO bursts
+ * 
+ * SensorData / TelemetryData are the ones from include/types.h: a module
+ * that brings its own fails here with a message instead of deep inside
+ * main.cpp. backend/module-contract.js runs the same checks on generated
+ * sources before the firmware build
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MODULE_CONTRACT_H
+#define MODULE_CONTRACT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+#include "../include/types.h"
+
+namespace module_contract {
+
+template <typename...>
+using void_t = void;
+
+// ───────────────────────────────────────────────────────────────────────────
+// DETECTION (member callable with the contract's arguments)
+// ───────────────────────────────────────────────────────────────────────────
+
+template <typename M, typename = void>
+struct HasInit : std::false_type {};
+template <typename M>
+struct HasInit<M, void_t<decltype(std::declval<M&>().init())>> : std::true_type {};
+
+// Exactly update(const SensorData&): a by-value update copies the sample on every call
+template <typename M, typename = void>
+struct HasUpdate : std::false_type {};
+template <typename M>
+struct HasUpdate<M, void_t<decltype(static_cast<void (M::*)(const SensorData&)>(&M::update))>> : std::true_type {};
+
+template <typename M, typename = void>
+struct HasTelemetry : std::false_type {};
+template <typename M>
+struct HasTelemetry<M, void_t<decltype(std::declval<M&>().getTelemetry())>>
+    : std::is_same<decltype(std::declval<M&>().getTelemetry()), TelemetryData> {};
+
+// Optional hooks: declared at all (any signature) / declared as specified
+template <typename M, typename = void>
+struct DeclaresSampleInterval : std::false_type {};
+template <typename M>
+struct DeclaresSampleInterval<M, void_t<decltype(&M::getSampleInterval)>> : std::true_type {};
+
+template <typename M, typename = void>
+struct HasSampleInterval : std::false_type {};
+template <typename M>
+struct HasSampleInterval<M, void_t<decltype(std::declval<M&>().getSampleInterval())>>
+    : std::is_convertible<decltype(std::declval<M&>().getSampleInterval()), uint32_t> {};
+
+template <typename M, typename = void>
+struct DeclaresUpdateBatch : std::false_type {};
+template <typename M>
+struct DeclaresUpdateBatch<M, void_t<decltype(&M::updateBatch)>> : std::true_type {};
+
+template <typename M, typename = void>
+struct HasUpdateBatch : std::false_type {};
+template <typename M>
+struct HasUpdateBatch<M, void_t<decltype(std::declval<M&>().updateBatch(std::declval<const SensorData*>(),
+                                                                        std::declval<size_t>()))>>
+    : std::true_type {};
+
+} // namespace module_contract
+
+// ───────────────────────────────────────────────────────────────────────────
+// CONTRACT (static_assert(ModuleContract<M>::value) names what is missing)
+// ───────────────────────────────────────────────────────────────────────────
+
+template <typename M>
+struct ModuleContract {
+    static_assert(module_contract::HasInit<M>::value,
+                  "Module contract: missing void init()");
+    static_assert(module_contract::HasUpdate<M>::value,
+                  "Module contract: missing void update(const SensorData&) "
+                  "(SensorData from include/types.h, taken by const reference)");
+    static_assert(module_contract::HasTelemetry<M>::value,
+                  "Module contract: missing TelemetryData getTelemetry() (TelemetryData from include/types.h)");
+    static_assert(!module_contract::DeclaresSampleInterval<M>::value || module_contract::HasSampleInterval<M>::value,
+                  "Module contract: getSampleInterval() takes no arguments and returns ms (uint32_t)");
+    static_assert(!module_contract::DeclaresUpdateBatch<M>::value || module_contract::HasUpdateBatch<M>::value,
+                  "Module contract: updateBatch takes (const SensorData* samples, size_t n)");
+    
+    static constexpr bool value = true;
+    static constexpr bool hasSampleInterval = module_contract::HasSampleInterval<M>::value;
+    static constexpr bool hasUpdateBatch = module_contract::HasUpdateBatch<M>::value;
+};
+
+// Interval the module asks for (0 = every loop without the hook)
+template <typename M>
+uint32_t moduleSampleInterval(M& m) {
+    if constexpr (module_contract::HasSampleInterval<M>::value) return m.getSampleInterval();
+    else return 0;
+}
+
+// Burst of samples: the module's updateBatch, else update() per sample
+template <typename M>
+void moduleUpdateBatch(M& m, const SensorData* samples, size_t n) {
+    if constexpr (module_contract::HasUpdateBatch<M>::value) {
+        m.updateBatch(samples, n);
+    } else {
+        for (size_t i = 0; i < n; i++) m.update(samples[i]);
+    }
+}
+
+#endif // MODULE_CONTRACT_H
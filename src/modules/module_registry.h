@@ -0,0 +1,260 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE REGISTRY - Co-Resident Modules
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Several ModuleBase modules compiled into one firmware, one of them
+ * active. Switching (classifier result, BLE) takes microseconds instead of
+ * a reflash:
+ * - The module list is a template parameter pack: dispatch is a compare
+ *   chain over the index with every module call inlined, no virtual calls
+ * - RESIDENT: all modules live in a tuple, a module switched back to
+ *   resumes with its state
+ * - ARENA: the modules share one buffer the size of the largest; the
+ *   module switched to is constructed fresh there (RAM: max, not sum)
+ * - Every module's init() (pins, banner) runs once at boot, so a switch
+ *   never blocks
+ * - Drop-in for CurrentModule: init, update, updateBatch, getTelemetry,
+ *   printDebug, getSampleInterval, setParam / getParam reach the active
+ *   module
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MODULE_REGISTRY_H
+#define MODULE_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "../include/types.h"
+#include "module_base.h"
+#include "module_contract.h"
+
+enum class ModuleStorage : uint8_t {
+    RESIDENT,       // Sum of the module sizes, state kept across switches
+    ARENA           // Largest module size, state reset on every switch
+};
+
+template <ModuleStorage Storage, typename... Modules>
+class ModuleRegistry {
+    static_assert(sizeof...(Modules) > 0 && sizeof...(Modules) < 255, "1..254 modules");
+    static_assert((std::is_base_of<ModuleBase<Modules>, Modules>::value && ...),
+                  "Modules derive from ModuleBase<Module>");
+    static_assert((ModuleContract<Modules>::value && ...), "Modules meet the module contract");
+
+public:
+    static constexpr uint8_t COUNT = sizeof...(Modules);
+    static constexpr uint8_t NONE = 0xFF;
+    
+    template <size_t I>
+    using ModuleAt = typename std::tuple_element<I, std::tuple<Modules...>>::type;
+
+private:
+    typedef std::index_sequence_for<Modules...> Indices;
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STORAGE
+    // ───────────────────────────────────────────────────────────────────────
+    
+    struct Resident {
+        std::tuple<Modules...> modules;
+    };
+    struct Arena {
+        alignas(Modules...) uint8_t bytes[std::max({sizeof(Modules)...})];
+    };
+    typename std::conditional<Storage == ModuleStorage::RESIDENT, Resident, Arena>::type storage;
+    
+    uint8_t active = NONE;
+    uint32_t switches = 0;
+
+public:
+    ModuleRegistry() {}
+    ModuleRegistry(const ModuleRegistry&) = delete;
+    ModuleRegistry& operator=(const ModuleRegistry&) = delete;
+    
+    ~ModuleRegistry() {
+        if constexpr (Storage == ModuleStorage::ARENA) {
+            if (active != NONE) destroy(active, Indices());
+        }
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // INITIALIZATION (init() of every module, the first one active)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void init() {
+        initAll(Indices());
+        if constexpr (Storage == ModuleStorage::ARENA) construct(0, Indices());
+        active = 0;
+        dispatch([](auto& m) { m.onActivate(); });
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // SWITCHING
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // false: no such module (the active one stays)
+    bool activate(uint8_t index) {
+        if (index >= COUNT) return false;
+        if (index == active) return true;
+        if (active != NONE) {
+            dispatch([](auto& m) { m.onDeactivate(); });
+            if constexpr (Storage == ModuleStorage::ARENA) destroy(active, Indices());
+        }
+        if constexpr (Storage == ModuleStorage::ARENA) construct(index, Indices());
+        active = index;
+        dispatch([](auto& m) { m.onActivate(); });
+        switches++;
+        return true;
+    }
+    
+    // First module for the context (ContextClassifier result)
+    bool activateContext(ContextType ctx) {
+        return activate(indexOf(ctx));
+    }
+    
+    static constexpr uint8_t indexOf(ContextType ctx) {
+        const ContextType contexts[] = { Modules::CONTEXT... };
+        for (uint8_t i = 0; i < COUNT; i++) {
+            if (contexts[i] == ctx) return i;
+        }
+        return NONE;
+    }
+    
+    // The module when it is the active one, else nullptr
+    template <typename M>
+    M* getIf() {
+        constexpr uint8_t i = indexOfType<M>(Indices());
+        static_assert(i != NONE, "Module not in the registry");
+        return active == i ? &get<i>() : nullptr;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // MODULE INTERFACE (active module)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    void update(const SensorData& data) {
+        dispatch([&](auto& m) { m.update(data); });
+    }
+
+    // One dispatch per burst, the module's batch kernel (or its update()
+    // per sample) runs inside
+    void updateBatch(const SensorData* samples, size_t n) {
+        dispatch([&](auto& m) { m.updateBatch(samples, n); });
+    }
+    
+    TelemetryData getTelemetry() {
+        TelemetryData t = {0, STATUS_OK};
+        dispatch([&](auto& m) { t = m.getTelemetry(); });
+        return t;
+    }
+    
+    // Active module's interval (0 when it has no getSampleInterval())
+    uint32_t getSampleInterval() {
+        uint32_t ms = 0;
+        dispatch([&](auto& m) { ms = moduleSampleInterval(m); });
+        return ms;
+    }
+
+    void handleAlert() {
+        dispatch([](auto& m) { m.handleAlert(); });
+    }
+    
+    void printDebug() {
+        dispatch([](auto& m) { m.printDebug(); });
+    }
+    
+    bool setParam(uint8_t id, int32_t value) {
+        bool ok = false;
+        dispatch([&](auto& m) { ok = m.setParam(id, value); });
+        return ok;
+    }
+    
+    bool getParam(uint8_t id, int32_t& value) {
+        bool ok = false;
+        dispatch([&](auto& m) { ok = m.getParam(id, value); });
+        return ok;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATUS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    uint8_t getActive() const { return active; }
+    uint32_t getSwitches() const { return switches; }
+    
+    ContextType getContext() const {
+        const ContextType contexts[] = { Modules::CONTEXT... };
+        return active < COUNT ? contexts[active] : CTX_UNKNOWN;
+    }
+    
+    const char* getName() const {
+        const char* const names[] = { Modules::NAME... };
+        return active < COUNT ? names[active] : "NONE";
+    }
+    
+    static constexpr size_t storageBytes() { return sizeof(storage); }
+    
+    // f(module) on the active module, statically bound per index
+    template <typename F>
+    void dispatch(F&& f) {
+        dispatchAt(f, Indices());
+    }
+
+private:
+    template <size_t I>
+    ModuleAt<I>& get() {
+        if constexpr (Storage == ModuleStorage::RESIDENT) {
+            return std::get<I>(storage.modules);
+        } else {
+            return *std::launder(reinterpret_cast<ModuleAt<I>*>(storage.bytes));
+        }
+    }
+    
+    template <typename F, size_t... I>
+    void dispatchAt(F& f, std::index_sequence<I...>) {
+        (void)((active == I ? (f(get<I>()), true) : false) || ...);
+    }
+    
+    template <typename M, size_t... I>
+    static constexpr uint8_t indexOfType(std::index_sequence<I...>) {
+        uint8_t i = NONE;
+        (void)((std::is_same<M, Modules>::value ? (i = I, true) : false) || ...);
+        return i;
+    }
+    
+    // Arena: a module exists only while active
+    template <size_t... I>
+    void construct(uint8_t index, std::index_sequence<I...>) {
+        (void)((index == I ? (new (storage.bytes) ModuleAt<I>(), true) : false) || ...);
+    }
+    
+    template <size_t... I>
+    void destroy(uint8_t index, std::index_sequence<I...>) {
+        (void)((index == I ? (get<I>().~ModuleAt<I>(), true) : false) || ...);
+    }
+    
+    // Arena: each module is built for its init() (pins set there stay set)
+    template <size_t... I>
+    void initAll(std::index_sequence<I...>) {
+        (initOne<I>(), ...);
+    }
+    
+    template <size_t I>
+    void initOne() {
+        if constexpr (Storage == ModuleStorage::RESIDENT) {
+            get<I>().init();
+        } else {
+            ModuleAt<I>* m = new (storage.bytes) ModuleAt<I>();
+            m->init();
+            m->~ModuleAt<I>();
+        }
+    }
+};
+
+#endif // MODULE_REGISTRY_H
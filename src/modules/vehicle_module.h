@@ -10,12 +10,23 @@
 #include <Arduino.h>
 #include "../include/config.h"
 #include "../include/types.h"
+#include "module_base.h"
+#include "batch_kernels.h"
+#include "../lora/schemas/vehicle_schema.h"
 
-class VehicleModule {
+class VehicleModule : public ModuleBase<VehicleModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_VEHICLE;
+    static constexpr const char* NAME = "VEHICLE";
+    
+    // LoRa samples as bit-packed records (backend/schemas/vehicle.json)
+    typedef VehicleSchema Schema;
+    
 private:
     float engineVibration = 0;
     bool crashDetected = false;
     bool isIdle = false;
+    float crashPeak = 0;   // Largest crash force since the last record (g)
     
 public:
     void init() {
@@ -23,7 +34,7 @@ public:
         Serial.println("[VEHICLE] Features: Crash detection, driving pattern analysis");
     }
     
-    void update(SensorData data) {
+    void update(const SensorData& data) {
         float magnitude = sqrt(
             data.accel_x * data.accel_x +
             data.accel_y * data.accel_y +
@@ -33,6 +44,7 @@ public:
         // Crash detection (sudden deceleration > 5G)
         if (magnitude > 5.0) {
             crashDetected = true;
+            if (magnitude > crashPeak) crashPeak = magnitude;
             Serial.printf("[VEHICLE] 🚨 CRASH DETECTED! Force: %.2fg\n", magnitude);
         }
         
@@ -41,6 +53,30 @@ public:
         isIdle = (magnitude < 1.2 && magnitude > 0.8);
     }
     
+    // FIFO burst: one peak scan for the crash check, the newest sample
+    // for vibration and idle (as update() leaves them)
+    void updateBatch(const SensorData* samples, size_t n) {
+        float magSq[MODULE_BATCH_MAX];
+        while (n > 0) {
+            size_t chunk = n < MODULE_BATCH_MAX ? n : MODULE_BATCH_MAX;
+            accelMagnitudeSq(samples, chunk, magSq);
+            
+            float peak = maxOf(magSq, chunk);
+            if (peak > (5.0f * 9.81f) * (5.0f * 9.81f)) {
+                crashDetected = true;
+                float force = sqrt(peak) / 9.81f;
+                if (force > crashPeak) crashPeak = force;
+                Serial.printf("[VEHICLE] 🚨 CRASH DETECTED! Force: %.2fg\n", force);
+            }
+            
+            float magnitude = sqrt(magSq[chunk - 1]) / 9.81f;
+            engineVibration = magnitude;
+            isIdle = (magnitude < 1.2 && magnitude > 0.8);
+            samples += chunk;
+            n -= chunk;
+        }
+    }
+    
     TelemetryData getTelemetry() {
         TelemetryData data;
         data.sensor_val = (uint16_t)(engineVibration * 100);
@@ -51,6 +87,20 @@ public:
         return data;
     }
     
+    // One record per telemetry sample; a crash is reported in one record
+    void getSchemaRecord(VehicleRecord& r) {
+        r.vibration = engineVibration;
+        r.idle = isIdle;
+        r.crash = crashPeak > 0;
+        r.crash_peak = crashPeak;
+        crashPeak = 0;
+    }
+    
+    // Crash peaks are short: every sample unless idling or parked
+    uint32_t getSampleInterval() {
+        return isIdle ? VEHICLE_IDLE_SAMPLE_MS : 0;
+    }
+    
     void handleAlert() {
         Serial.println("[VEHICLE] 🚨 Emergency alert");
     }
@@ -0,0 +1,102 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA DECODER - Transfer Encoding → Image Bytes
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * What travels (WiFi download or BLE transfer) is the image itself, a delta
+ * patch against the running image, or either one heatshrink compressed:
+ *   transfer → [HeatshrinkDecoder] → [DeltaPatcher] → image bytes
+ * Both stages stream, so the same block loop feeds the flash whatever the
+ * encoding. The SHA-256 (OtaWriter) is always over the decoded image.
+ * RAM is fixed at compile time (OTA_DECODER_RAM_MAX): the heatshrink window,
+ * the stage buffer and a few words of state, nothing allocated per image.
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef OTA_DECODER_H
+#define OTA_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../include/config.h"
+#include "ota_delta.h"
+#include "ota_heatshrink.h"
+
+#define OTA_ENCODING_RAW        0x00
+#define OTA_ENCODING_DELTA      0x01    // Patch against the running image
+#define OTA_ENCODING_HEATSHRINK 0x02    // LZSS, OTA_HS_WINDOW_BITS / OTA_HS_LOOKAHEAD_BITS
+
+class OtaDecoder {
+private:
+    uint8_t encoding = OTA_ENCODING_RAW;
+    HeatshrinkDecoder inflater;
+    DeltaPatcher patcher;
+    
+    // Decompressed patch between the two stages
+    uint8_t mid[OTA_DECODE_CHUNK];
+    const uint8_t* midPos = mid;
+    size_t midLen = 0;
+
+public:
+    // reader / base: the running image, only used for OTA_ENCODING_DELTA
+    void begin(uint8_t enc, DeltaBaseReader reader = nullptr, const uint8_t* base_sha = nullptr,
+               uint32_t base_size = 0) {
+        encoding = enc;
+        inflater.begin();
+        patcher.begin(reader, base_sha, base_size);
+        midPos = mid;
+        midLen = 0;
+    }
+    
+    // Same contract as DeltaPatcher::run
+    size_t run(const uint8_t** in, size_t* inLen, uint8_t* out, size_t outCap) {
+        if (encoding == OTA_ENCODING_RAW) {
+            size_t n = *inLen < outCap ? *inLen : outCap;
+            memcpy(out, *in, n);
+            *in += n;
+            *inLen -= n;
+            return n;
+        }
+        if (encoding == OTA_ENCODING_HEATSHRINK) return inflater.run(in, inLen, out, outCap);
+        if (encoding == OTA_ENCODING_DELTA) return patcher.run(in, inLen, out, outCap);
+        
+        size_t written = 0;
+        while (written < outCap && !patcher.done() && !patcher.failed()) {
+            if (midLen == 0) {
+                midPos = mid;
+                midLen = inflater.run(in, inLen, mid, sizeof(mid));
+                if (midLen == 0) break;
+            }
+            written += patcher.run(&midPos, &midLen, out + written, outCap - written);
+        }
+        return written;
+    }
+    
+    bool failed() const { return (encoding & OTA_ENCODING_DELTA) && patcher.failed(); }
+    DeltaError getError() const { return patcher.getError(); }
+    uint8_t getEncoding() const { return encoding; }
+    
+    static bool supported(uint8_t enc) {
+        return enc <= (OTA_ENCODING_DELTA | OTA_ENCODING_HEATSHRINK);
+    }
+    
+    // What the backend may send (X-Image-Accept): any combination of both stages
+    static const char* accepted() {
+        return "delta, heatshrink";
+    }
+    
+    static const char* name(uint8_t enc) {
+        switch (enc) {
+            case OTA_ENCODING_RAW: return "raw";
+            case OTA_ENCODING_DELTA: return "delta";
+            case OTA_ENCODING_HEATSHRINK: return "heatshrink";
+            default: return "delta+heatshrink";
+        }
+    }
+};
+
+static_assert(sizeof(OtaDecoder) <= OTA_DECODER_RAM_MAX, "OtaDecoder over its RAM budget");
+
+#endif // OTA_DECODER_H
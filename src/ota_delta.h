@@ -0,0 +1,218 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA DELTA - Streaming Binary Patches
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * A mode switch only changes current_module.h, so most of the new firmware
+ * is the running one, shifted. The backend (backend/delta-ota.js) sends a
+ * patch against the running image instead of the whole image:
+ * - COPY / ADD take bytes from the running partition at the old position,
+ *   ADD adds a difference byte to each (moved addresses differ by a few
+ *   bits), long runs without difference are COPY and cost 2-3 bytes
+ * - INSERT carries new bytes, SEEK moves the old position
+ * - The patch is applied as it arrives, in any chunking: old bytes are read
+ *   straight into the caller's output buffer, the patcher itself holds
+ *   only its parse state (no heap, no window)
+ * 
+ * LAYOUT (little endian, lengths are LEB128 varints):
+ *   header  "UADD" [4] version  [5..8] image size  [9..12] base size
+ *           [13..44] base SHA-256 (must be the running image)
+ *   ops     0x01 COPY n | 0x02 ADD n + n bytes | 0x03 INSERT n + n bytes
+ *           0x04 SEEK zigzag(delta) | 0x00 END
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DELTA_MAGIC         "UADD"
+#define DELTA_VERSION       1
+#define DELTA_HEADER_LEN    45
+
+#define DELTA_OP_END        0x00
+#define DELTA_OP_COPY       0x01
+#define DELTA_OP_ADD        0x02
+#define DELTA_OP_INSERT     0x03
+#define DELTA_OP_SEEK       0x04
+
+enum DeltaError {
+    DELTA_OK = 0,
+    DELTA_BAD_HEADER,
+    DELTA_BASE_MISMATCH,    // Patch made for another firmware
+    DELTA_BAD_OP,
+    DELTA_OUT_OF_RANGE,     // Old position outside the base image
+    DELTA_OVERFLOW,         // More output than the header announced
+    DELTA_READ_FAILED
+};
+
+// Reads the running image (the patch base)
+typedef bool (*DeltaBaseReader)(uint32_t offset, uint8_t* out, size_t len);
+
+class DeltaPatcher {
+private:
+    enum State { HEADER, OP, VARINT, COPY, ADD, INSERT, DONE, FAILED };
+    
+    DeltaBaseReader readBase = nullptr;
+    const uint8_t* expectedSha = nullptr;
+    uint32_t expectedSize = 0;
+    
+    State state = HEADER;
+    DeltaError error = DELTA_OK;
+    uint8_t header[DELTA_HEADER_LEN];
+    size_t headerLen = 0;
+    uint32_t imageSize = 0;
+    
+    uint8_t op = 0;
+    uint32_t value = 0;             // Varint being parsed
+    uint8_t shift = 0;
+    uint32_t remaining = 0;         // Bytes left in the current op
+    uint32_t oldPos = 0;
+    uint32_t produced = 0;
+
+public:
+    // base_sha / base_size: the running image, checked against the header
+    void begin(DeltaBaseReader reader, const uint8_t* base_sha, uint32_t base_size) {
+        readBase = reader;
+        expectedSha = base_sha;
+        expectedSize = base_size;
+        state = HEADER;
+        error = DELTA_OK;
+        headerLen = 0;
+        imageSize = 0;
+        remaining = 0;
+        oldPos = 0;
+        produced = 0;
+    }
+    
+    // Consumes patch bytes from *in and writes image bytes to out. Returns
+    // the bytes written: stops when out is full, the input is used up or
+    // the patch ends (done() / failed())
+    size_t run(const uint8_t** in, size_t* inLen, uint8_t* out, size_t outCap) {
+        size_t written = 0;
+        
+        while (state != DONE && state != FAILED) {
+            if (state == COPY || state == ADD || state == INSERT) {
+                size_t n = remaining;
+                if (n > outCap - written) n = outCap - written;
+                if (state != COPY && n > *inLen) n = *inLen;
+                if (n == 0) break;
+                
+                uint8_t* dst = out + written;
+                if (state == INSERT) {
+                    memcpy(dst, *in, n);
+                } else {
+                    if (!readBase(oldPos, dst, n)) return fail(DELTA_READ_FAILED, written);
+                    if (state == ADD) {
+                        for (size_t i = 0; i < n; i++) dst[i] += (*in)[i];
+                    }
+                    oldPos += n;
+                }
+                if (state != COPY) {
+                    *in += n;
+                    *inLen -= n;
+                }
+                written += n;
+                produced += n;
+                remaining -= n;
+                if (remaining == 0) state = OP;
+                continue;
+            }
+            
+            if (*inLen == 0) break;
+            uint8_t b = **in;
+            (*in)++;
+            (*inLen)--;
+            
+            if (state == HEADER) {
+                header[headerLen++] = b;
+                if (headerLen == DELTA_HEADER_LEN && !parseHeader()) return written;
+            } else if (state == OP) {
+                if (b == DELTA_OP_END) {
+                    if (produced != imageSize) return fail(DELTA_BAD_OP, written);
+                    state = DONE;
+                } else if (b > DELTA_OP_SEEK) {
+                    return fail(DELTA_BAD_OP, written);
+                } else {
+                    op = b;
+                    value = 0;
+                    shift = 0;
+                    state = VARINT;
+                }
+            } else if (state == VARINT) {
+                if (shift > 28) return fail(DELTA_BAD_OP, written);
+                value |= (uint32_t)(b & 0x7F) << shift;
+                shift += 7;
+                if (b & 0x80) continue;
+                if (!startOp()) return written;
+            }
+        }
+        return written;
+    }
+    
+    bool done() const { return state == DONE; }
+    bool failed() const { return state == FAILED; }
+    DeltaError getError() const { return error; }
+    
+    // Valid once the header is in
+    uint32_t getImageSize() const { return imageSize; }
+    uint32_t getProduced() const { return produced; }
+
+private:
+    bool parseHeader() {
+        if (memcmp(header, DELTA_MAGIC, 4) != 0 || header[4] != DELTA_VERSION) {
+            fail(DELTA_BAD_HEADER, 0);
+            return false;
+        }
+        imageSize = get32(&header[5]);
+        uint32_t baseSize = get32(&header[9]);
+        if (baseSize != expectedSize || memcmp(&header[13], expectedSha, 32) != 0) {
+            fail(DELTA_BASE_MISMATCH, 0);
+            return false;
+        }
+        state = OP;
+        return true;
+    }
+    
+    bool startOp() {
+        if (op == DELTA_OP_SEEK) {
+            int32_t delta = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+            int64_t pos = (int64_t)oldPos + delta;
+            if (pos < 0 || pos > expectedSize) {
+                fail(DELTA_OUT_OF_RANGE, 0);
+                return false;
+            }
+            oldPos = (uint32_t)pos;
+            state = OP;
+            return true;
+        }
+        if (value > imageSize - produced) {
+            fail(DELTA_OVERFLOW, 0);
+            return false;
+        }
+        if (op != DELTA_OP_INSERT && value > expectedSize - oldPos) {
+            fail(DELTA_OUT_OF_RANGE, 0);
+            return false;
+        }
+        remaining = value;
+        state = (op == DELTA_OP_COPY) ? COPY : (op == DELTA_OP_ADD) ? ADD : INSERT;
+        if (remaining == 0) state = OP;
+        return true;
+    }
+    
+    size_t fail(DeltaError e, size_t written) {
+        error = e;
+        state = FAILED;
+        return written;
+    }
+    
+    static uint32_t get32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+};
+
+#endif // OTA_DELTA_H
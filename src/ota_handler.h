@@ -6,6 +6,16 @@
  * Downloads and installs AI-generated modules
  * Supports incremental updates (modules only, not full firmware)
  * 
+ * The image streams through OTA_BLOCK_SIZE buffers: this task reads the
+ * socket while a flash task hashes and writes the previous block
+ * (OtaWriter). The backend's SHA-256 and signature headers are checked
+ * before Update.end()
+ * 
+ * The request names the running image (X-Delta-Base) and the encodings
+ * this firmware decodes (X-Image-Accept). When the backend still has the
+ * running image only a compressed patch travels, otherwise the compressed
+ * image; the download task decodes either as it arrives (src/ota_decoder.h)
+ * 
  * ═══════════════════════════════════════════════════════════════════════════
  */
 
@@ -17,12 +27,45 @@
 #include <HTTPClient.h>
 #include <Update.h>
 #include <ArduinoJson.h>
+#include "../include/config.h"
+#include "ota_writer.h"
+#include "ota_decoder.h"
 
 class OTAHandler {
 private:
     String backend_url = "http://your-backend.com";  // TODO: Configure
     bool update_in_progress = false;
     
+    // One buffer handed between the tasks, len 0 ends the image
+    struct Block {
+        uint8_t* data;
+        size_t len;
+    };
+    
+    OtaWriter writer;
+    OtaDecoder decoder;
+    uint8_t baseSha[OTA_SHA256_LEN];
+    uint32_t baseSize = 0;
+    QueueHandle_t freeBlocks = nullptr;     // Flash task → download
+    QueueHandle_t fullBlocks = nullptr;     // Download → flash task
+    TaskHandle_t downloadTask = nullptr;
+    volatile bool flashFailed = false;
+    
+    // Encoded download: socket bytes not decoded yet
+    uint8_t* encodedIn = nullptr;
+    const uint8_t* encodedPos = nullptr;
+    size_t encodedLen = 0;
+    uint32_t lastData = 0;                  // Start of the current wait, 0 while data flows
+    
+    // Progress and metrics (current or last download)
+    volatile uint32_t bytesDownloaded = 0;  // Image bytes, after decoding
+    uint32_t bytesReceived = 0;             // Transfer bytes off the socket
+    uint32_t transferSize = 0;
+    uint32_t imageSize = 0;
+    uint32_t downloadMs = 0;
+    uint32_t flashWaitMs = 0;               // No free buffer: flash bound
+    uint32_t networkWaitMs = 0;             // Socket empty: network bound
+
 public:
     // ───────────────────────────────────────────────────────────────────────
     // CHECK FOR UPDATES
@@ -82,66 +125,38 @@ public:
         HTTPClient http;
         String url = backend_url + "/api/modules/download?device_type=" + device_type;
         http.begin(url);
+        http.addHeader("X-Image-Accept", OtaDecoder::accepted());
+        if (OtaWriter::runningImage(baseSha, &baseSize)) {
+            http.addHeader("X-Delta-Base", toHex(baseSha, OTA_SHA256_LEN));
+        } else {
+            baseSize = 0;
+        }
+        const char* headers[] = { "X-Image-SHA256", "X-Image-Signature", "X-Image-Encoding", "X-Image-Size" };
+        http.collectHeaders(headers, 4);
         
         int httpCode = http.GET();
+        OtaResult result = OTA_RESULT_FLASH_ERROR;
         
         if (httpCode == 200) {
             int contentLength = http.getSize();
-            Serial.printf("[OTA] 📦 Module size: %d bytes\n", contentLength);
-            
-            // Get update stream
-            WiFiClient* stream = http.getStreamPtr();
+            uint8_t sha[OTA_SHA256_LEN];
+            uint8_t signature[OTA_SIGNATURE_MAX];
+            size_t signatureLen = parseHex(http.header("X-Image-Signature"), signature, sizeof(signature));
+            int encoding = parseEncoding(http.header("X-Image-Encoding"));
+            long size = (encoding == OTA_ENCODING_RAW) ? contentLength :
+                        atol(http.header("X-Image-Size").c_str());
             
-            // Begin update
-            if (!Update.begin(contentLength)) {
-                Serial.println("[OTA] ❌ Not enough space for update");
-                http.end();
-                update_in_progress = false;
-                return false;
-            }
-            
-            // Write update with progress
-            size_t written = 0;
-            uint8_t buffer[128];
-            int lastProgress = 0;
-            
-            while (http.connected() && (written < contentLength)) {
-                size_t available = stream->available();
-                
-                if (available) {
-                    int bytesRead = stream->readBytes(buffer, 
-                                    min(sizeof(buffer), available));
-                    written += Update.write(buffer, bytesRead);
-                    
-                    int progress = (written * 100) / contentLength;
-                    if (progress != lastProgress && progress % 10 == 0) {
-                        Serial.printf("[OTA] 📊 Progress: %d%%\n", progress);
-                        lastProgress = progress;
-                    }
-                }
-                
-                delay(1);
-            }
-            
-            // Finalize update
-            if (Update.end()) {
-                if (Update.isFinished()) {
-                    Serial.println("[OTA] ✅ Update successful!");
-                    http.end();
-                    update_in_progress = false;
-                    
-                    // Reboot in 3 seconds
-                    Serial.println("[OTA] 🔄 Rebooting in 3 seconds...");
-                    delay(3000);
-                    ESP.restart();
-                    
-                    return true;
-                } else {
-                    Serial.println("[OTA] ❌ Update not finished");
-                }
+            if (contentLength <= 0 || size <= 0) {
+                Serial.println("[OTA] ❌ Download has no size");
+            } else if (parseHex(http.header("X-Image-SHA256"), sha, sizeof(sha)) != OTA_SHA256_LEN) {
+                Serial.println("[OTA] ❌ Download has no image hash");
+            } else if (encoding < 0 || ((encoding & OTA_ENCODING_DELTA) && baseSize == 0)) {
+                Serial.printf("[OTA] ❌ Unsupported encoding '%s'\n", http.header("X-Image-Encoding").c_str());
             } else {
-                Serial.printf("[OTA] ❌ Update failed: %s\n", 
-                             Update.errorString());
+                Serial.printf("[OTA] 📦 Module size: %ld bytes, %d over the air (%s, %s)\n", size,
+                              contentLength, OtaDecoder::name(encoding), signatureLen ? "signed" : "unsigned");
+                result = streamImage(http.getStreamPtr(), contentLength, size, encoding, sha,
+                                     signature, signatureLen);
             }
         } else {
             Serial.printf("[OTA] ❌ Download failed (HTTP %d)\n", httpCode);
@@ -149,7 +164,13 @@ public:
         
         http.end();
         update_in_progress = false;
-        return false;
+        if (result != OTA_RESULT_OK) return false;
+        
+        Serial.println("[OTA] ✅ Update successful!");
+        Serial.println("[OTA] 🔄 Rebooting in 3 seconds...");
+        delay(3000);
+        ESP.restart();
+        return true;
     }
     
     // ───────────────────────────────────────────────────────────────────────
@@ -252,6 +273,256 @@ public:
     void setBackendURL(String url) {
         backend_url = url;
     }
+    
+    uint8_t getProgress() {
+        return imageSize ? (uint64_t)bytesDownloaded * 100 / imageSize : 0;
+    }
+    
+    // Bytes per second of the last download
+    uint32_t getThroughput() {
+        return downloadMs ? (uint64_t)bytesDownloaded * 1000 / downloadMs : 0;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RESPONSE HEADERS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // "delta+heatshrink" → OTA_ENCODING_* bits, -1 if unknown
+    static int parseEncoding(const String& header) {
+        if (header.length() == 0 || header == "raw") return OTA_ENCODING_RAW;
+        if (header == "delta") return OTA_ENCODING_DELTA;
+        if (header == "heatshrink") return OTA_ENCODING_HEATSHRINK;
+        if (header == "delta+heatshrink") return OTA_ENCODING_DELTA | OTA_ENCODING_HEATSHRINK;
+        return -1;
+    }
+    
+    static String toHex(const uint8_t* data, size_t len) {
+        static const char digits[] = "0123456789abcdef";
+        char buf[2 * OTA_SHA256_LEN + 1];
+        if (len > OTA_SHA256_LEN) len = OTA_SHA256_LEN;
+        for (size_t i = 0; i < len; i++) {
+            buf[2 * i] = digits[data[i] >> 4];
+            buf[2 * i + 1] = digits[data[i] & 0x0F];
+        }
+        buf[2 * len] = 0;
+        return String(buf);
+    }
+    
+    // Hex header → bytes, 0 if missing or malformed
+    static size_t parseHex(const String& hex, uint8_t* out, size_t max) {
+        size_t len = hex.length();
+        if (len == 0 || len % 2 || len / 2 > max) return 0;
+        for (size_t i = 0; i < len; i++) {
+            char c = hex[i];
+            int v = (c >= '0' && c <= '9') ? c - '0' :
+                    (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                    (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (v < 0) return 0;
+            if (i % 2 == 0) out[i / 2] = v << 4;
+            else out[i / 2] |= v;
+        }
+        return len / 2;
+    }
+
+private:
+    // ───────────────────────────────────────────────────────────────────────
+    // STREAMING PIPELINE
+    // ───────────────────────────────────────────────────────────────────────
+    
+    OtaResult streamImage(WiFiClient* stream, uint32_t transfer, uint32_t size, uint8_t encoding,
+                          const uint8_t* sha, const uint8_t* signature, size_t signatureLen) {
+        // Held only while downloading (the last OTA_ENCODED_INPUT bytes take
+        // socket reads of an encoded image)
+        uint8_t* buffers = (uint8_t*)malloc(OTA_HTTP_BUFFERS * OTA_BLOCK_SIZE + OTA_ENCODED_INPUT);
+        freeBlocks = xQueueCreate(OTA_HTTP_BUFFERS, sizeof(Block));
+        fullBlocks = xQueueCreate(OTA_HTTP_BUFFERS + 1, sizeof(Block));
+        downloadTask = xTaskGetCurrentTaskHandle();
+        flashFailed = false;
+        
+        if (!buffers || !freeBlocks || !fullBlocks) {
+            Serial.println("[OTA] ❌ No memory for download buffers");
+            releasePipeline(buffers);
+            return OTA_RESULT_FLASH_ERROR;
+        }
+        if (!writer.begin(size)) {
+            releasePipeline(buffers);
+            return OTA_RESULT_FLASH_ERROR;
+        }
+        TaskHandle_t flashTask = nullptr;
+        if (xTaskCreatePinnedToCore(flashTaskEntry, "ota_flash", 4096, this, 2, &flashTask,
+                                    OTA_TASK_CORE) != pdPASS) {
+            Serial.println("[OTA] ❌ Flash task not started");
+            writer.abort();
+            releasePipeline(buffers);
+            return OTA_RESULT_FLASH_ERROR;
+        }
+        for (int i = 0; i < OTA_HTTP_BUFFERS; i++) {
+            Block b = { buffers + i * OTA_BLOCK_SIZE, 0 };
+            xQueueSend(freeBlocks, &b, 0);
+        }
+        
+        // Modem sleep caps TCP far below the link rate
+        bool sleep = WiFi.getSleep();
+        WiFi.setSleep(false);
+        
+        decoder.begin(encoding, OtaWriter::readRunning, baseSha, baseSize);
+        encodedIn = buffers + OTA_HTTP_BUFFERS * OTA_BLOCK_SIZE;
+        encodedLen = 0;
+        lastData = 0;
+        transferSize = transfer;
+        imageSize = size;
+        bytesDownloaded = 0;
+        bytesReceived = 0;
+        flashWaitMs = 0;
+        networkWaitMs = 0;
+        uint32_t start = millis();
+        int lastProgress = 0;
+        OtaResult streamError = OTA_RESULT_OK;
+        
+        while (bytesDownloaded < size) {
+            Block b;
+            uint32_t t = millis();
+            xQueueReceive(freeBlocks, &b, portMAX_DELAY);
+            flashWaitMs += millis() - t;
+            if (flashFailed) break;
+            
+            uint32_t left = size - bytesDownloaded;
+            b.len = left < OTA_BLOCK_SIZE ? left : OTA_BLOCK_SIZE;
+            streamError = (encoding == OTA_ENCODING_RAW) ? fillBlock(stream, b) : fillDecoded(stream, b);
+            if (streamError != OTA_RESULT_OK) break;
+            bytesDownloaded += b.len;
+            xQueueSend(fullBlocks, &b, portMAX_DELAY);
+            
+            int progress = (uint64_t)bytesDownloaded * 100 / size;
+            if (progress / 10 != lastProgress / 10) {
+                uint32_t ms = millis() - start;
+                Serial.printf("[OTA] 📊 Progress: %d%% (%lu KB/s)\n", progress,
+                              (unsigned long)(ms ? bytesDownloaded / ms : 0));
+                lastProgress = progress;
+            }
+        }
+        
+        // The flash task writes what is queued, then stops
+        Block last = { nullptr, 0 };
+        xQueueSend(fullBlocks, &last, portMAX_DELAY);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        WiFi.setSleep(sleep);
+        downloadMs = millis() - start;
+        
+        OtaResult result;
+        if (streamError != OTA_RESULT_OK || flashFailed) {
+            writer.abort();
+            result = flashFailed ? OTA_RESULT_FLASH_ERROR : streamError;
+        } else {
+            result = writer.finish(sha, signature, signatureLen);
+        }
+        releasePipeline(buffers);
+        
+        uint32_t secs10 = downloadMs / 100;
+        if (encoding != OTA_ENCODING_RAW) {
+            Serial.printf("[OTA] 📊 %s: %lu bytes received for %lu (%lu%%)\n", OtaDecoder::name(encoding),
+                          (unsigned long)bytesReceived, (unsigned long)bytesDownloaded,
+                          (unsigned long)(bytesDownloaded ? (uint64_t)bytesReceived * 100 / bytesDownloaded : 0));
+        }
+        Serial.printf("[OTA] 📊 %lu bytes in %lu.%lu s (%lu KB/s): flash %lu ms (slowest block %lu ms), "
+                      "waited %lu ms for flash, %lu ms for network\n",
+                      (unsigned long)bytesDownloaded, (unsigned long)(secs10 / 10),
+                      (unsigned long)(secs10 % 10), (unsigned long)(getThroughput() / 1024),
+                      (unsigned long)writer.getFlashMs(), (unsigned long)writer.getMaxBlockMs(),
+                      (unsigned long)flashWaitMs, (unsigned long)networkWaitMs);
+        return result;
+    }
+    
+    // Read straight into the block, sleeping only while the socket is empty
+    OtaResult fillBlock(WiFiClient* stream, Block& b) {
+        size_t fill = 0;
+        while (fill < b.len) {
+            int n = stream->read(b.data + fill, b.len - fill);
+            if (n > 0) {
+                fill += n;
+                bytesReceived += n;
+                lastData = 0;
+            } else if (!waitForData(stream, bytesDownloaded + fill)) {
+                return OTA_RESULT_ABORTED;
+            }
+        }
+        return OTA_RESULT_OK;
+    }
+    
+    // Socket → encodedIn → decoder → block. A patch can fill blocks with
+    // COPYs from the running image without reading anything
+    OtaResult fillDecoded(WiFiClient* stream, Block& b) {
+        size_t fill = 0;
+        while (fill < b.len) {
+            if (encodedLen == 0 && bytesReceived < transferSize) {
+                uint32_t left = transferSize - bytesReceived;
+                int n = stream->read(encodedIn, left < OTA_ENCODED_INPUT ? left : OTA_ENCODED_INPUT);
+                if (n > 0) {
+                    encodedPos = encodedIn;
+                    encodedLen = n;
+                    bytesReceived += n;
+                    lastData = 0;
+                } else if (!waitForData(stream, bytesReceived)) {
+                    return OTA_RESULT_ABORTED;
+                }
+            }
+            
+            size_t n = decoder.run(&encodedPos, &encodedLen, b.data + fill, b.len - fill);
+            fill += n;
+            if (decoder.failed()) {
+                Serial.printf("[OTA] ❌ Patch rejected (error %d) at %lu bytes\n", decoder.getError(),
+                              (unsigned long)(bytesDownloaded + fill));
+                return OTA_RESULT_BAD_PATCH;
+            }
+            if (n == 0 && (encodedLen > 0 || bytesReceived == transferSize)) {
+                Serial.printf("[OTA] ❌ Encoded image ended at %lu of %lu bytes\n",
+                              (unsigned long)(bytesDownloaded + fill), (unsigned long)imageSize);
+                return OTA_RESULT_BAD_PATCH;
+            }
+        }
+        return OTA_RESULT_OK;
+    }
+    
+    // Socket empty: sleep a tick, false once it closed or stalled
+    bool waitForData(WiFiClient* stream, uint32_t at) {
+        if (lastData == 0) lastData = millis();
+        if (!stream->connected() && !stream->available()) {
+            Serial.printf("[OTA] ❌ Connection closed at %lu bytes\n", (unsigned long)at);
+            return false;
+        }
+        if (millis() - lastData > OTA_HTTP_TIMEOUT_MS) {
+            Serial.printf("[OTA] ❌ Download stalled at %lu bytes\n", (unsigned long)at);
+            return false;
+        }
+        uint32_t t = millis();
+        vTaskDelay(1);
+        networkWaitMs += millis() - t;
+        return true;
+    }
+    
+    static void flashTaskEntry(void* arg) {
+        static_cast<OTAHandler*>(arg)->flashLoop();
+    }
+    
+    // Hash + flash each block, hand the buffer back; after a failure only
+    // recycles buffers so the download side notices and stops
+    void flashLoop() {
+        Block b;
+        while (xQueueReceive(fullBlocks, &b, portMAX_DELAY) == pdTRUE && b.len > 0) {
+            if (!flashFailed && !writer.write(b.data, b.len)) flashFailed = true;
+            xQueueSend(freeBlocks, &b, portMAX_DELAY);
+        }
+        xTaskNotifyGive(downloadTask);
+        vTaskDelete(nullptr);
+    }
+    
+    void releasePipeline(uint8_t* buffers) {
+        free(buffers);
+        if (freeBlocks) vQueueDelete(freeBlocks);
+        if (fullBlocks) vQueueDelete(fullBlocks);
+        freeBlocks = nullptr;
+        fullBlocks = nullptr;
+    }
 };
 
 #endif // OTA_HANDLER_H
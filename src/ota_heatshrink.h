@@ -0,0 +1,109 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA HEATSHRINK - Streaming LZSS Decoder
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Decoder for the heatshrink bit stream (encoder: backend/heatshrink.js):
+ *   1 + 8 bits           literal byte
+ *   0 + W bits + L bits  copy (count + 1) bytes from (index + 1) back
+ * W = OTA_HS_WINDOW_BITS, L = OTA_HS_LOOKAHEAD_BITS, MSB first
+ * - RAM is the 2^W byte window plus a few bytes of state
+ * - Any chunking of the input, output stops wherever the caller's buffer
+ *   ends and a copy continues on the next call
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef OTA_HEATSHRINK_H
+#define OTA_HEATSHRINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../include/config.h"
+
+static_assert(OTA_HS_LOOKAHEAD_BITS < OTA_HS_WINDOW_BITS, "Heatshrink lookahead must be below the window");
+static_assert(OTA_HS_WINDOW_BITS <= 15, "Heatshrink window too large");
+
+class HeatshrinkDecoder {
+private:
+    enum State { TAG, LITERAL, INDEX, COUNT, COPY };
+    static const uint16_t MASK = (1 << OTA_HS_WINDOW_BITS) - 1;
+    
+    uint8_t window[1 << OTA_HS_WINDOW_BITS];
+    uint16_t head = 0;              // Next write position in the window
+    
+    State state = TAG;
+    uint32_t bits = 0;              // Input bits not used yet (low bitCount bits)
+    uint8_t bitCount = 0;
+    uint16_t offset = 0;            // Copy source: offset bytes back
+    uint16_t count = 0;             // Bytes left to copy
+
+public:
+    void begin() {
+        memset(window, 0, sizeof(window));
+        head = 0;
+        state = TAG;
+        bits = 0;
+        bitCount = 0;
+        count = 0;
+    }
+    
+    // Consumes compressed bytes from *in, returns the bytes written to out
+    size_t run(const uint8_t** in, size_t* inLen, uint8_t* out, size_t outCap) {
+        size_t written = 0;
+        
+        while (written < outCap) {
+            if (state == COPY) {
+                size_t n = outCap - written;
+                if (n > count) n = count;
+                uint16_t from = (head - offset) & MASK;
+                for (size_t i = 0; i < n; i++) {
+                    uint8_t b = window[from];
+                    from = (from + 1) & MASK;
+                    out[written++] = b;
+                    window[head] = b;
+                    head = (head + 1) & MASK;
+                }
+                count -= n;
+                if (count == 0) state = TAG;
+                continue;
+            }
+            
+            uint8_t need = (state == TAG) ? 1 : (state == LITERAL) ? 8 :
+                           (state == INDEX) ? OTA_HS_WINDOW_BITS : OTA_HS_LOOKAHEAD_BITS;
+            while (bitCount < need) {
+                if (*inLen == 0) return written;
+                bits = (bits << 8) | **in;
+                bitCount += 8;
+                (*in)++;
+                (*inLen)--;
+            }
+            bitCount -= need;
+            uint16_t v = (bits >> bitCount) & ((1u << need) - 1);
+            
+            if (state == TAG) {
+                state = v ? LITERAL : INDEX;
+            } else if (state == LITERAL) {
+                emit(v, out, written);
+                state = TAG;
+            } else if (state == INDEX) {
+                offset = v + 1;
+                state = COUNT;
+            } else {
+                count = v + 1;
+                state = COPY;
+            }
+        }
+        return written;
+    }
+
+private:
+    void emit(uint8_t b, uint8_t* out, size_t& written) {
+        out[written++] = b;
+        window[head] = b;
+        head = (head + 1) & MASK;
+    }
+};
+
+#endif // OTA_HEATSHRINK_H
@@ -0,0 +1,201 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA WRITER - Verified Image Flashing
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Writes an image into the next OTA partition (Update) and hashes it on
+ * the way (SHA-256, hardware accelerated by mbedtls on the ESP32):
+ * - Blocks come in OTA_BLOCK_SIZE pieces: Update's sector buffer fills in
+ *   one memcpy and goes to flash right away
+ * - finish() compares the hash (and the backend's signature over it, see
+ *   OTA_SIGNING_PUBKEY) before Update.end(): an image that does not match
+ *   never becomes the boot partition
+ * - Nothing is activated here, the caller reboots when it is told to
+ * - The running image is the base of delta updates (src/ota_delta.h):
+ *   readRunning() / runningImage() give its bytes, size and SHA-256
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef OTA_WRITER_H
+#define OTA_WRITER_H
+
+#include <Arduino.h>
+#include <Update.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/pk.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "../include/config.h"
+#include "ble/ota_transfer.h"
+
+class OtaWriter {
+private:
+    mbedtls_sha256_context sha;
+    uint32_t size = 0;
+    uint32_t written = 0;
+    bool open = false;
+    
+    // Statistics
+    uint32_t startMs = 0;
+    uint32_t flashMs = 0;               // Time spent inside Update.write
+    uint32_t maxBlockMs = 0;
+
+public:
+    bool begin(uint32_t image_size) {
+        if (open) abort();
+        if (!Update.begin(image_size, U_FLASH)) {
+            Serial.printf("[OTA] ❌ Update.begin(%lu): %s\n", (unsigned long)image_size,
+                          Update.errorString());
+            return false;
+        }
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        size = image_size;
+        written = 0;
+        flashMs = 0;
+        maxBlockMs = 0;
+        startMs = millis();
+        open = true;
+        return true;
+    }
+    
+    bool write(const uint8_t* data, size_t len) {
+        if (!open) return false;
+        mbedtls_sha256_update(&sha, data, len);
+        
+        uint32_t t = millis();
+        size_t n = Update.write((uint8_t*)data, len);
+        t = millis() - t;
+        flashMs += t;
+        if (t > maxBlockMs) maxBlockMs = t;
+        
+        if (n != len) {
+            Serial.printf("[OTA] ❌ Flash write at %lu: %s\n", (unsigned long)written,
+                          Update.errorString());
+            return false;
+        }
+        written += len;
+        return true;
+    }
+    
+    // Verify, then close the partition (it boots on the next restart).
+    // signature: DER, over the SHA-256 of the image
+    OtaResult finish(const uint8_t* expected_sha, const uint8_t* signature = nullptr,
+                     size_t signature_len = 0) {
+        if (!open || written != size) return OTA_RESULT_FLASH_ERROR;
+        
+        uint8_t digest[OTA_SHA256_LEN];
+        mbedtls_sha256_finish(&sha, digest);
+        mbedtls_sha256_free(&sha);
+        open = false;
+        
+        if (memcmp(digest, expected_sha, OTA_SHA256_LEN) != 0) {
+            Update.abort();
+            Serial.println("[OTA] ❌ SHA-256 mismatch, image discarded");
+            return OTA_RESULT_HASH_MISMATCH;
+        }
+        if (!signatureValid(digest, signature, signature_len)) {
+            Update.abort();
+            return OTA_RESULT_BAD_SIGNATURE;
+        }
+        if (!Update.end()) {
+            Serial.printf("[OTA] ❌ Update.end: %s\n", Update.errorString());
+            return OTA_RESULT_FLASH_ERROR;
+        }
+        
+        uint32_t secs10 = (millis() - startMs) / 100;
+        Serial.printf("[OTA] ✅ %lu bytes verified in %lu.%lu s (flash %lu ms, slowest block %lu ms)\n",
+                      (unsigned long)size, (unsigned long)(secs10 / 10), (unsigned long)(secs10 % 10),
+                      (unsigned long)flashMs, (unsigned long)maxBlockMs);
+        return OTA_RESULT_OK;
+    }
+    
+    void abort() {
+        if (!open) return;
+        mbedtls_sha256_free(&sha);
+        Update.abort();
+        open = false;
+    }
+    
+    // finish() refuses images without a signature (a key, or OTA_REQUIRE_SIGNATURE)
+    static bool signatureRequired() {
+        return sizeof(OTA_SIGNING_PUBKEY) > 1 || OTA_REQUIRE_SIGNATURE;
+    }
+    
+    bool isOpen() const { return open; }
+    uint32_t getWritten() const { return written; }
+    uint32_t getFlashMs() const { return flashMs; }
+    uint32_t getMaxBlockMs() const { return maxBlockMs; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // RUNNING IMAGE (base of delta updates)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    static bool readRunning(uint32_t offset, uint8_t* out, size_t len) {
+        const esp_partition_t* part = esp_ota_get_running_partition();
+        return part && esp_partition_read(part, offset, out, len) == ESP_OK;
+    }
+    
+    // Same bytes and hash as the firmware.bin the backend built. Hashed
+    // once (~1 MB of flash), then cached
+    static bool runningImage(uint8_t* sha_out, uint32_t* size_out) {
+        static uint8_t sha[OTA_SHA256_LEN];
+        static uint32_t size = 0;
+        
+        if (size == 0) {
+            uint32_t imageSize = ESP.getSketchSize();
+            uint8_t chunk[512];
+            mbedtls_sha256_context ctx;
+            mbedtls_sha256_init(&ctx);
+            mbedtls_sha256_starts(&ctx, 0);
+            bool ok = imageSize > 0;
+            for (uint32_t pos = 0; ok && pos < imageSize; pos += sizeof(chunk)) {
+                size_t n = imageSize - pos < sizeof(chunk) ? imageSize - pos : sizeof(chunk);
+                ok = readRunning(pos, chunk, n);
+                if (ok) mbedtls_sha256_update(&ctx, chunk, n);
+            }
+            mbedtls_sha256_finish(&ctx, sha);
+            mbedtls_sha256_free(&ctx);
+            if (!ok) return false;
+            size = imageSize;
+        }
+        memcpy(sha_out, sha, OTA_SHA256_LEN);
+        *size_out = size;
+        return true;
+    }
+
+private:
+    // With a key configured every image must carry a valid signature;
+    // unsigned images are only accepted by builds without a key
+    bool signatureValid(const uint8_t* digest, const uint8_t* signature, size_t len) {
+        bool haveKey = sizeof(OTA_SIGNING_PUBKEY) > 1;
+        if (!signature || len == 0) {
+            if (!signatureRequired()) return true;
+            Serial.println("[OTA] ❌ Unsigned image refused");
+            return false;
+        }
+        if (!haveKey) {
+            Serial.println("[OTA] ⚠️ Image signed but no OTA_SIGNING_PUBKEY to check it");
+            return !OTA_REQUIRE_SIGNATURE;
+        }
+        
+        mbedtls_pk_context pk;
+        mbedtls_pk_init(&pk);
+        int err = mbedtls_pk_parse_public_key(&pk, (const unsigned char*)OTA_SIGNING_PUBKEY,
+                                              sizeof(OTA_SIGNING_PUBKEY));
+        if (err == 0) {
+            err = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, OTA_SHA256_LEN, signature, len);
+        }
+        mbedtls_pk_free(&pk);
+        
+        if (err != 0) {
+            Serial.printf("[OTA] ❌ Signature check failed (-0x%04x), image discarded\n", -err);
+            return false;
+        }
+        Serial.println("[OTA] 🔏 Signature valid");
+        return true;
+    }
+};
+
+#endif // OTA_WRITER_H
@@ -0,0 +1,237 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE VM - Bytecode Interpreter
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Runs a verified program (vm_program.h) in place of a compiled-in module:
+ * - update(inputs) once per loop, telemetry() for the LoRa / BLE report
+ * - 16 registers per call, state cells kept between calls, params are
+ *   cells PARAM_SET may write within the program's range
+ * - Fixed RAM: no heap, no stack growth with the program
+ * - A call that exceeds VM_STEP_LIMIT stops the module (fault) instead of
+ *   stalling the loop; integer overflow wraps, x / 0 = 0
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MODULE_VM_H
+#define MODULE_VM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "../include/config.h"
+#include "vm_program.h"
+
+class ModuleVm {
+public:
+    typedef void (*SyscallFn)(VmSyscall id, VmCell arg, void* ctx);
+
+private:
+    VmProgram prog;
+    bool loaded = false;
+    VmError fault = VM_OK;
+    
+    VmCell state[VM_STATE_MAX];
+    VmCell inputs[VM_INPUTS];
+    VmCell outputs[VM_OUTPUTS];
+    
+    SyscallFn syscall = nullptr;
+    void* syscallCtx = nullptr;
+    
+    uint32_t lastSteps = 0;
+    uint32_t maxSteps = 0;
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // PROGRAM
+    // ───────────────────────────────────────────────────────────────────────
+    
+    // data must stay valid and unchanged while loaded
+    VmError load(const uint8_t* data, size_t len) {
+        VmProgram p;
+        VmError err = vmVerify(data, len, p);
+        if (err != VM_OK) return err;
+        prog = p;
+        memset(state, 0, sizeof(state));
+        memcpy(state, prog.stateInit, prog.nState * sizeof(VmCell));
+        memset(inputs, 0, sizeof(inputs));
+        memset(outputs, 0, sizeof(outputs));
+        lastSteps = 0;
+        maxSteps = 0;
+        fault = VM_OK;
+        loaded = true;
+        return VM_OK;
+    }
+    
+    void unload() {
+        loaded = false;
+        fault = VM_OK;
+    }
+    
+    void setSyscall(SyscallFn fn, void* ctx) {
+        syscall = fn;
+        syscallCtx = ctx;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // MODULE INTERFACE
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool update(const VmCell in[VM_INPUTS]) {
+        if (!isRunning()) return false;
+        memcpy(inputs, in, sizeof(inputs));
+        return run(prog.updateEntry);
+    }
+    
+    // value / status: OUT of the telemetry entry (kept from the last call if not set)
+    bool telemetry(int32_t& value, int32_t& status) {
+        if (!isRunning() || !run(prog.telemetryEntry)) return false;
+        value = outputs[VM_OUT_VALUE].i;
+        status = outputs[VM_OUT_STATUS].i;
+        return true;
+    }
+    
+    // false: unknown id or value outside the program's range
+    bool setParam(uint8_t id, int32_t value) {
+        const VmParam* p = findParam(id);
+        if (!p || value < p->min || value > p->max) return false;
+        state[p->cell].i = value;
+        return true;
+    }
+    
+    bool getParam(uint8_t id, int32_t& value) const {
+        const VmParam* p = findParam(id);
+        if (!p) return false;
+        value = state[p->cell].i;
+        return true;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // STATUS
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool isLoaded() const { return loaded; }
+    bool isRunning() const { return loaded && fault == VM_OK; }
+    VmError getFault() const { return fault; }
+    const VmProgram& getProgram() const { return prog; }
+    uint32_t getLastSteps() const { return lastSteps; }
+    uint32_t getMaxSteps() const { return maxSteps; }
+    VmCell getCell(uint8_t i) const { return state[i < VM_STATE_MAX ? i : 0]; }
+
+private:
+    const VmParam* findParam(uint8_t id) const {
+        if (!loaded) return nullptr;
+        for (uint8_t i = 0; i < prog.nParam; i++) {
+            if (prog.params[i].id == id) return &prog.params[i];
+        }
+        return nullptr;
+    }
+    
+    static int32_t wrap(uint32_t v) { return (int32_t)v; }
+    
+    bool stepFault(uint32_t steps) {
+        fault = VM_ERR_STEPS;
+        lastSteps = steps;
+        return false;
+    }
+    
+    static int32_t toInt(float f) {
+        if (f != f) return 0;
+        if (f >= 2147483520.0f) return INT32_MAX;
+        if (f <= -2147483648.0f) return INT32_MIN;
+        return (int32_t)f;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // INTERPRETER (operands verified at load: no index checks here; the
+    // step count is only compared on backward jumps, straight code ends)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    bool run(uint16_t entry) {
+        VmCell r[VM_REGISTERS];
+        memset(r, 0, sizeof(r));
+        const uint32_t* code = prog.code;
+        const VmCell* k = prog.consts;
+        VmCell* s = state;
+        uint32_t pc = entry;
+        uint32_t steps = 0;
+        
+        for (;;) {
+            uint32_t w = code[pc++];
+            steps++;
+            uint8_t a = vmA(w), b = vmB(w), c = vmC(w);
+            switch (vmOp(w)) {
+                case VM_RET:
+                    lastSteps = steps;
+                    if (steps > maxSteps) maxSteps = steps;
+                    return true;
+                case VM_MOV:   r[a] = r[b]; break;
+                case VM_LDK:   r[a] = k[(uint16_t)vmBC(w)]; break;
+                case VM_LDI:   r[a].i = vmBC(w); break;
+                case VM_LDS:   r[a] = s[b]; break;
+                case VM_STS:   s[a] = r[b]; break;
+                case VM_LDIN:  r[a] = inputs[b]; break;
+                case VM_OUT:   outputs[a] = r[b]; break;
+                
+                case VM_ADDI:  r[a].i = wrap(r[b].u + r[c].u); break;
+                case VM_SUBI:  r[a].i = wrap(r[b].u - r[c].u); break;
+                case VM_MULI:  r[a].i = wrap(r[b].u * r[c].u); break;
+                case VM_DIVI:
+                    r[a].i = r[c].i == 0 ? 0 : r[c].i == -1 ? wrap(0u - r[b].u) : r[b].i / r[c].i;
+                    break;
+                case VM_MODI:
+                    r[a].i = (r[c].i == 0 || r[c].i == -1) ? 0 : r[b].i % r[c].i;
+                    break;
+                case VM_ADDF:  r[a].f = r[b].f + r[c].f; break;
+                case VM_SUBF:  r[a].f = r[b].f - r[c].f; break;
+                case VM_MULF:  r[a].f = r[b].f * r[c].f; break;
+                case VM_DIVF:  r[a].f = r[b].f / r[c].f; break;
+                
+                case VM_LTI:   r[a].i = r[b].i < r[c].i; break;
+                case VM_LEI:   r[a].i = r[b].i <= r[c].i; break;
+                case VM_EQI:   r[a].i = r[b].i == r[c].i; break;
+                case VM_NEI:   r[a].i = r[b].i != r[c].i; break;
+                case VM_LTF:   r[a].i = r[b].f < r[c].f; break;
+                case VM_LEF:   r[a].i = r[b].f <= r[c].f; break;
+                case VM_EQF:   r[a].i = r[b].f == r[c].f; break;
+                case VM_NEF:   r[a].i = r[b].f != r[c].f; break;
+                case VM_MINI:  r[a].i = r[b].i < r[c].i ? r[b].i : r[c].i; break;
+                case VM_MAXI:  r[a].i = r[b].i > r[c].i ? r[b].i : r[c].i; break;
+                case VM_MINF:  r[a].f = r[b].f < r[c].f ? r[b].f : r[c].f; break;
+                case VM_MAXF:  r[a].f = r[b].f > r[c].f ? r[b].f : r[c].f; break;
+                
+                case VM_NEGI:  r[a].i = wrap(0u - r[b].u); break;
+                case VM_NEGF:  r[a].f = -r[b].f; break;
+                case VM_NOT:   r[a].i = r[b].i == 0; break;
+                case VM_I2F:   r[a].f = (float)r[b].i; break;
+                case VM_F2I:   r[a].i = toInt(r[b].f); break;
+                case VM_ABSI:  r[a].i = r[b].i < 0 ? wrap(0u - r[b].u) : r[b].i; break;
+                case VM_ABSF:  r[a].f = fabsf(r[b].f); break;
+                case VM_SQRTF: r[a].f = sqrtf(r[b].f); break;
+                
+                case VM_JMP:
+                    pc += vmBC(w);
+                    if (vmBC(w) < 0 && steps > VM_STEP_LIMIT) return stepFault(steps);
+                    break;
+                case VM_JZ:
+                    if (r[a].i != 0) break;
+                    pc += vmBC(w);
+                    if (vmBC(w) < 0 && steps > VM_STEP_LIMIT) return stepFault(steps);
+                    break;
+                case VM_JNZ:
+                    if (r[a].i == 0) break;
+                    pc += vmBC(w);
+                    if (vmBC(w) < 0 && steps > VM_STEP_LIMIT) return stepFault(steps);
+                    break;
+                
+                case VM_SYS:
+                    if (syscall) syscall((VmSyscall)a, r[b], syscallCtx);
+                    break;
+            }
+        }
+    }
+};
+
+#endif // MODULE_VM_H
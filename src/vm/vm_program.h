@@ -0,0 +1,320 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE VM - Program Format & Verifier
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * A module as data instead of firmware: update() and getTelemetry() as
+ * bytecode (compiler: backend/module-compiler.js), kept in the "uadmod"
+ * partition and swapped in without a reflash or reboot (VmModuleManager).
+ * 
+ * LAYOUT (little endian, 4-byte aligned sections):
+ *   [0..3] "UADM"  [4] version  [5] context  [6] constants  [7] state cells
+ *   [8] params  [9] 0  [10..11] instructions  [12..13] update entry
+ *   [14..15] telemetry entry  [16..31] name (NUL padded)
+ *   constants      4 bytes each (i32 or f32 bits)
+ *   state cells    4 bytes each, initial values (params are cells too)
+ *   params         12 bytes each: [0] id  [1] cell  [2..3] 0  [4..7] min  [8..11] max
+ *   code           4 bytes each: [0] opcode  [1] a  [2] b  [3] c
+ *                  (b | c << 8: 16-bit constant index, immediate or jump)
+ *   CRC-32 of everything above
+ * 
+ * vmVerify() checks every operand once: register, constant, cell, input,
+ * output and syscall indices, jump targets, entries, param ranges, and
+ * that code cannot run off its end. The interpreter then indexes without
+ * checks; only the step budget is checked at run time.
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef VM_PROGRAM_H
+#define VM_PROGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../include/config.h"
+
+#define VM_MAGIC        "UADM"
+#define VM_VERSION      1
+#define VM_HEADER_LEN   32
+#define VM_NAME_LEN     16
+#define VM_PARAM_LEN    12
+
+// ═══════════════════════════════════════════════════════════════════════════
+// INSTRUCTION SET (register machine, 3-address, fixed 32-bit words)
+// ═══════════════════════════════════════════════════════════════════════════
+
+enum VmOp : uint8_t {
+    VM_RET = 0x00,      // End of the entry
+    VM_MOV,             // r[a] = r[b]
+    VM_LDK,             // r[a] = const[bc]
+    VM_LDI,             // r[a].i = (int16) bc
+    VM_LDS,             // r[a] = cell[b]
+    VM_STS,             // cell[a] = r[b]
+    VM_LDIN,            // r[a] = input[b] (VmInput)
+    VM_OUT,             // output[a] = r[b] (VmOutput)
+    
+    VM_ADDI, VM_SUBI, VM_MULI, VM_DIVI, VM_MODI,    // r[a] = r[b] op r[c] (x / 0 = 0)
+    VM_ADDF, VM_SUBF, VM_MULF, VM_DIVF,
+    VM_LTI, VM_LEI, VM_EQI, VM_NEI,                 // r[a].i = r[b] op r[c] ? 1 : 0
+    VM_LTF, VM_LEF, VM_EQF, VM_NEF,
+    VM_MINI, VM_MAXI, VM_MINF, VM_MAXF,
+    
+    VM_NEGI, VM_NEGF,   // r[a] = op r[b]
+    VM_NOT,             // r[a].i = !r[b].i
+    VM_I2F, VM_F2I,     // F2I truncates, saturates, NaN → 0
+    VM_ABSI, VM_ABSF, VM_SQRTF,
+    
+    VM_JMP,             // pc += (int16) bc (from the next instruction)
+    VM_JZ,              // if r[a].i == 0: pc += (int16) bc
+    VM_JNZ,
+    VM_SYS,             // host call a (VmSyscall) with r[b]
+    
+    VM_OP_COUNT
+};
+
+enum VmInput : uint8_t {
+    VM_IN_AX, VM_IN_AY, VM_IN_AZ,       // SensorData, floats
+    VM_IN_GX, VM_IN_GY, VM_IN_GZ,
+    VM_IN_TEMP,
+    VM_IN_NOW,                          // millis(), int (differences survive the wrap)
+    VM_INPUTS
+};
+
+enum VmOutput : uint8_t {
+    VM_OUT_VALUE,                       // TelemetryData.sensor_val (int)
+    VM_OUT_STATUS,                      // TelemetryData.status (StatusCode)
+    VM_OUTPUTS
+};
+
+enum VmSyscall : uint8_t {
+    VM_SYS_LOG_INT,                     // Serial log of r[b]
+    VM_SYS_LOG_FLOAT,
+    VM_SYS_LED,                         // LED on while r[b].i != 0
+    VM_SYS_ALERT,                       // Haptic + LED alert pattern
+    VM_SYSCALLS
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// OPERAND KINDS (what vmVerify checks per field)
+// ═══════════════════════════════════════════════════════════════════════════
+
+enum VmOperand : uint8_t {
+    VM_A_NONE,          // Must be 0
+    VM_A_REG,
+    VM_A_CELL,
+    VM_A_INPUT,
+    VM_A_OUTPUT,
+    VM_A_SYS,
+    VM_A_CONST,         // b + c: constant index
+    VM_A_IMM,           // b + c: any 16 bits
+    VM_A_JUMP           // b + c: target inside the code
+};
+
+struct VmOpSpec {
+    uint8_t a, b, c;    // VmOperand; c is VM_A_NONE when b is 16-bit
+};
+
+static const VmOpSpec VM_OP_SPECS[VM_OP_COUNT] = {
+    { VM_A_NONE, VM_A_NONE, VM_A_NONE },        // RET
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // MOV
+    { VM_A_REG, VM_A_CONST, VM_A_NONE },        // LDK
+    { VM_A_REG, VM_A_IMM, VM_A_NONE },          // LDI
+    { VM_A_REG, VM_A_CELL, VM_A_NONE },         // LDS
+    { VM_A_CELL, VM_A_REG, VM_A_NONE },         // STS
+    { VM_A_REG, VM_A_INPUT, VM_A_NONE },        // LDIN
+    { VM_A_OUTPUT, VM_A_REG, VM_A_NONE },       // OUT
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // ADDI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // SUBI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MULI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // DIVI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MODI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // ADDF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // SUBF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MULF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // DIVF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // LTI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // LEI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // EQI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // NEI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // LTF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // LEF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // EQF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // NEF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MINI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MAXI
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MINF
+    { VM_A_REG, VM_A_REG, VM_A_REG },           // MAXF
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // NEGI
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // NEGF
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // NOT
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // I2F
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // F2I
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // ABSI
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // ABSF
+    { VM_A_REG, VM_A_REG, VM_A_NONE },          // SQRTF
+    { VM_A_NONE, VM_A_JUMP, VM_A_NONE },        // JMP
+    { VM_A_REG, VM_A_JUMP, VM_A_NONE },         // JZ
+    { VM_A_REG, VM_A_JUMP, VM_A_NONE },         // JNZ
+    { VM_A_SYS, VM_A_REG, VM_A_NONE },          // SYS
+};
+
+// ═══════════════════════════════════════════════════════════════════════════
+// PROGRAM VIEW (points into the verified bytes, which must stay put)
+// ═══════════════════════════════════════════════════════════════════════════
+
+union VmCell {
+    int32_t i;
+    float f;
+    uint32_t u;
+};
+
+struct VmParam {
+    uint8_t id;
+    uint8_t cell;
+    uint16_t reserved;
+    int32_t min;
+    int32_t max;
+};
+
+struct VmProgram {
+    const uint32_t* code = nullptr;
+    const VmCell* consts = nullptr;
+    const VmCell* stateInit = nullptr;
+    const VmParam* params = nullptr;
+    uint16_t codeLen = 0;
+    uint16_t updateEntry = 0;
+    uint16_t telemetryEntry = 0;
+    uint8_t nConst = 0;
+    uint8_t nState = 0;
+    uint8_t nParam = 0;
+    uint8_t context = 0;
+    uint16_t size = 0;
+    uint32_t crc = 0;
+    char name[VM_NAME_LEN + 1] = "";
+};
+
+enum VmError : uint8_t {
+    VM_OK = 0,
+    VM_ERR_HEADER,          // Magic, version or alignment
+    VM_ERR_SIZE,            // Length does not match the tables, or over the limits
+    VM_ERR_CRC,
+    VM_ERR_OPERAND,         // Unknown opcode or index out of range
+    VM_ERR_JUMP,            // Jump or entry outside the code
+    VM_ERR_FALLTHROUGH,     // Last instruction neither RET nor JMP
+    VM_ERR_PARAM,           // Bad cell, range, duplicate id or default outside the range
+    VM_ERR_STEPS            // Run time: a call used up VM_STEP_LIMIT
+};
+
+inline const char* vmErrorName(VmError e) {
+    static const char* names[] = { "OK", "HEADER", "SIZE", "CRC", "OPERAND", "JUMP",
+                                   "FALLTHROUGH", "PARAM", "STEPS" };
+    return e <= VM_ERR_STEPS ? names[e] : "?";
+}
+
+// Instruction fields
+inline uint8_t vmOp(uint32_t w) { return w & 0xFF; }
+inline uint8_t vmA(uint32_t w) { return (w >> 8) & 0xFF; }
+inline uint8_t vmB(uint32_t w) { return (w >> 16) & 0xFF; }
+inline uint8_t vmC(uint32_t w) { return w >> 24; }
+inline int16_t vmBC(uint32_t w) { return (int16_t)(w >> 16); }
+
+inline uint32_t vmCrc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// Total program size from its header, 0 if the header is not a program's
+inline size_t vmProgramSize(const uint8_t* header) {
+    if (memcmp(header, VM_MAGIC, 4) != 0 || header[4] != VM_VERSION) return 0;
+    uint16_t codeLen = header[10] | (header[11] << 8);
+    return VM_HEADER_LEN + 4 * (header[6] + header[7]) + VM_PARAM_LEN * header[8] + 4 * codeLen + 4;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════
+// VERIFIER
+// ═══════════════════════════════════════════════════════════════════════════
+
+inline bool vmOperandValid(uint8_t kind, uint8_t v, const VmProgram& p) {
+    switch (kind) {
+        case VM_A_NONE:   return v == 0;
+        case VM_A_REG:    return v < VM_REGISTERS;
+        case VM_A_CELL:   return v < p.nState;
+        case VM_A_INPUT:  return v < VM_INPUTS;
+        case VM_A_OUTPUT: return v < VM_OUTPUTS;
+        case VM_A_SYS:    return v < VM_SYSCALLS;
+        default:          return false;
+    }
+}
+
+// data: 4-byte aligned, len: exactly the program
+inline VmError vmVerify(const uint8_t* data, size_t len, VmProgram& p) {
+    if (len < VM_HEADER_LEN || ((uintptr_t)data & 3)) return VM_ERR_HEADER;
+    size_t size = vmProgramSize(data);
+    if (size == 0 || data[9] != 0) return VM_ERR_HEADER;
+    if (size != len || size > VM_PROGRAM_MAX) return VM_ERR_SIZE;
+    
+    VmProgram v;
+    v.context = data[5];
+    v.nConst = data[6];
+    v.nState = data[7];
+    v.nParam = data[8];
+    v.codeLen = data[10] | (data[11] << 8);
+    v.updateEntry = data[12] | (data[13] << 8);
+    v.telemetryEntry = data[14] | (data[15] << 8);
+    if (v.nState > VM_STATE_MAX || v.nParam > VM_PARAMS_MAX || v.codeLen == 0) return VM_ERR_SIZE;
+    
+    size_t body = len - 4;
+    uint32_t crc = data[body] | (data[body + 1] << 8) | (data[body + 2] << 16) | ((uint32_t)data[body + 3] << 24);
+    if (vmCrc32(data, body) != crc) return VM_ERR_CRC;
+    v.crc = crc;
+    v.size = len;
+    memcpy(v.name, data + 16, VM_NAME_LEN);
+    v.name[VM_NAME_LEN] = 0;
+    
+    const uint8_t* at = data + VM_HEADER_LEN;
+    v.consts = (const VmCell*)at;
+    at += 4 * v.nConst;
+    v.stateInit = (const VmCell*)at;
+    at += 4 * v.nState;
+    v.params = (const VmParam*)at;
+    at += VM_PARAM_LEN * v.nParam;
+    v.code = (const uint32_t*)at;
+    
+    for (uint16_t pc = 0; pc < v.codeLen; pc++) {
+        uint32_t w = v.code[pc];
+        if (vmOp(w) >= VM_OP_COUNT) return VM_ERR_OPERAND;
+        const VmOpSpec& spec = VM_OP_SPECS[vmOp(w)];
+        if (!vmOperandValid(spec.a, vmA(w), v)) return VM_ERR_OPERAND;
+        if (spec.b == VM_A_CONST) {
+            if ((uint16_t)vmBC(w) >= v.nConst) return VM_ERR_OPERAND;
+        } else if (spec.b == VM_A_JUMP) {
+            int32_t target = pc + 1 + vmBC(w);
+            if (target < 0 || target >= v.codeLen) return VM_ERR_JUMP;
+        } else if (spec.b != VM_A_IMM) {
+            if (!vmOperandValid(spec.b, vmB(w), v) || !vmOperandValid(spec.c, vmC(w), v)) return VM_ERR_OPERAND;
+        }
+    }
+    uint8_t last = vmOp(v.code[v.codeLen - 1]);
+    if (last != VM_RET && last != VM_JMP) return VM_ERR_FALLTHROUGH;
+    if (v.updateEntry >= v.codeLen || v.telemetryEntry >= v.codeLen) return VM_ERR_JUMP;
+    
+    for (uint8_t i = 0; i < v.nParam; i++) {
+        const VmParam& prm = v.params[i];
+        if (prm.id == 0 || prm.cell >= v.nState || prm.min > prm.max) return VM_ERR_PARAM;
+        int32_t value = v.stateInit[prm.cell].i;
+        if (value < prm.min || value > prm.max) return VM_ERR_PARAM;
+        for (uint8_t k = 0; k < i; k++) {
+            if (v.params[k].id == prm.id) return VM_ERR_PARAM;
+        }
+    }
+    
+    p = v;
+    return VM_OK;
+}
+
+#endif // VM_PROGRAM_H
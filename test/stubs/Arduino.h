@@ -0,0 +1,93 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    ARDUINO STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Just enough of the Arduino core for the modules to compile on the host
+ * (pio test -e native), so tests run the shipped module code instead of a
+ * copy of it:
+ * - Serial swallows output (set stubSerialEcho to see it)
+ * - Pins only remember their last level, delay() advances millis() without
+ *   sleeping
+ * - String is a std::string, ESP counts restarts and has no sketch
+ * - FreeRTOS runs tasks on threads (freertos/FreeRTOS.h)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+inline bool stubSerialEcho = false;
+inline unsigned long stubMillis = 0;
+inline int stubPinLevel[64] = {};
+
+inline unsigned long millis() { return stubMillis; }
+inline void delay(unsigned long ms) { stubMillis += ms; }
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { stubPinLevel[pin & 63] = level; }
+inline int digitalRead(uint8_t pin) { return stubPinLevel[pin & 63]; }
+inline void analogWrite(uint8_t pin, int value) { stubPinLevel[pin & 63] = value; }
+
+template <typename T, typename L, typename H>
+inline T constrain(T x, L lo, H hi) { return x < lo ? (T)lo : (x > hi ? (T)hi : x); }
+
+struct StubSerial {
+    void begin(unsigned long) {}
+    
+    void print(const char* s) { if (stubSerialEcho) fputs(s, stdout); }
+    void println(const char* s = "") { if (stubSerialEcho) puts(s); }
+    
+    void printf(const char* fmt, ...) {
+        if (!stubSerialEcho) return;
+        va_list args;
+        va_start(args, fmt);
+        vprintf(fmt, args);
+        va_end(args);
+    }
+};
+
+inline StubSerial Serial;
+
+class String {
+private:
+    std::string s;
+
+public:
+    String(const char* c = "") : s(c ? c : "") {}
+    String(const std::string& str) : s(str) {}
+    
+    const char* c_str() const { return s.c_str(); }
+    size_t length() const { return s.length(); }
+    char operator[](size_t i) const { return i < s.length() ? s[i] : 0; }
+    bool operator==(const char* c) const { return s == c; }
+    bool operator==(const String& o) const { return s == o.s; }
+    String operator+(const String& o) const { return String(s + o.s); }
+    String& operator+=(const String& o) { s += o.s; return *this; }
+};
+
+inline int stubRestarts = 0;
+
+struct StubEsp {
+    uint32_t getSketchSize() { return 0; }
+    void restart() { stubRestarts++; }
+};
+
+inline StubEsp ESP;
+
+#endif // ARDUINO_STUB_H
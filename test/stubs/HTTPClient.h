@@ -0,0 +1,61 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    HTTP CLIENT STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Every request gets stubHttp: its status, response headers and body
+ * (stubHttp.stream). Request headers are kept for the test to check
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef HTTP_CLIENT_STUB_H
+#define HTTP_CLIENT_STUB_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <map>
+#include <string>
+
+struct StubHttp {
+    int status = 200;
+    std::map<std::string, std::string> headers;
+    std::map<std::string, std::string> requestHeaders;
+    std::string url;
+    WiFiClient stream;
+    
+    void reset() { *this = StubHttp(); }
+};
+
+inline StubHttp stubHttp;
+
+class HTTPClient {
+public:
+    bool begin(const String& url) {
+        stubHttp.url = url.c_str();
+        stubHttp.requestHeaders.clear();
+        return true;
+    }
+    
+    void addHeader(const String& name, const String& value) {
+        stubHttp.requestHeaders[name.c_str()] = value.c_str();
+    }
+    
+    void collectHeaders(const char* [], size_t) {}
+    
+    int GET() { return stubHttp.status; }
+    int POST(const String&) { return stubHttp.status; }
+    
+    int getSize() { return stubHttp.stream.body.size(); }
+    String getString() { return String(std::string(stubHttp.stream.body.begin(), stubHttp.stream.body.end())); }
+    WiFiClient* getStreamPtr() { return &stubHttp.stream; }
+    
+    String header(const char* name) {
+        auto it = stubHttp.headers.find(name);
+        return it == stubHttp.headers.end() ? String() : String(it->second);
+    }
+    
+    void end() {}
+};
+
+#endif // HTTP_CLIENT_STUB_H
@@ -0,0 +1,69 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    UPDATE STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * An OTA partition in memory: keeps the written image and whether the
+ * update was ended (would boot) or aborted. failWriteAt / failEnd make
+ * the flash fail
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef UPDATE_STUB_H
+#define UPDATE_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+#define U_FLASH 0
+
+class UpdateClass {
+public:
+    std::vector<uint8_t> image;
+    size_t size = 0;
+    size_t writes = 0;
+    size_t maxWrite = 0;
+    std::thread::id writer;             // Thread of the last write
+    bool began = false;
+    bool ended = false;
+    bool aborted = false;
+    
+    size_t failWriteAt = SIZE_MAX;      // A write past this offset fails
+    bool failEnd = false;
+    
+    void reset() { *this = UpdateClass(); }
+    
+    bool begin(size_t image_size, int) {
+        image.clear();
+        size = image_size;
+        began = true;
+        ended = false;
+        aborted = false;
+        return true;
+    }
+    
+    size_t write(uint8_t* data, size_t len) {
+        writer = std::this_thread::get_id();
+        writes++;
+        if (len > maxWrite) maxWrite = len;
+        if (image.size() + len > failWriteAt) return 0;
+        image.insert(image.end(), data, data + len);
+        return len;
+    }
+    
+    bool end() {
+        if (failEnd || image.size() != size) return false;
+        ended = true;
+        return true;
+    }
+    
+    void abort() { aborted = true; }
+    const char* errorString() { return "stub"; }
+};
+
+inline UpdateClass Update;
+
+#endif // UPDATE_STUB_H
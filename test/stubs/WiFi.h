@@ -0,0 +1,64 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    WIFI STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * WiFiClient plays back a response body the test sets:
+ * - read() returns at most `chunk` bytes, and nothing on every `emptyEvery`
+ *   call (the socket has not caught up)
+ * - The connection closes after `closeAt` bytes
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef WIFI_STUB_H
+#define WIFI_STUB_H
+
+#include <Arduino.h>
+#include <vector>
+
+class WiFiClient {
+public:
+    std::vector<uint8_t> body;
+    size_t pos = 0;
+    size_t chunk = 1460;
+    size_t emptyEvery = 0;
+    size_t closeAt = SIZE_MAX;
+    size_t reads = 0;
+    
+    void load(const std::vector<uint8_t>& data) {
+        body = data;
+        pos = 0;
+        reads = 0;
+        closeAt = SIZE_MAX;
+    }
+    
+    size_t end() const { return body.size() < closeAt ? body.size() : closeAt; }
+    
+    int read(uint8_t* out, size_t len) {
+        reads++;
+        if (emptyEvery && reads % emptyEvery == 0) return 0;
+        size_t n = end() - pos;
+        if (n > len) n = len;
+        if (n > chunk) n = chunk;
+        memcpy(out, body.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    
+    int available() { return end() - pos; }
+    bool connected() { return pos < end(); }
+};
+
+struct StubWiFi {
+    bool connected = true;
+    bool sleep = true;
+    
+    bool isConnected() { return connected; }
+    bool getSleep() { return sleep; }
+    void setSleep(bool on) { sleep = on; }
+};
+
+inline StubWiFi WiFi;
+
+#endif // WIFI_STUB_H
@@ -0,0 +1,21 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    ESP OTA OPS STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * No running partition unless the test sets one: the device has no base
+ * for delta updates
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef ESP_OTA_OPS_STUB_H
+#define ESP_OTA_OPS_STUB_H
+
+#include "esp_partition.h"
+
+inline const esp_partition_t* stubRunningPartition = nullptr;
+
+inline const esp_partition_t* esp_ota_get_running_partition() { return stubRunningPartition; }
+
+#endif // ESP_OTA_OPS_STUB_H
@@ -0,0 +1,34 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    ESP PARTITION STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * A partition is a byte array the test owns
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef ESP_PARTITION_STUB_H
+#define ESP_PARTITION_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK      0
+#define ESP_FAIL    -1
+
+struct esp_partition_t {
+    const uint8_t* data;
+    size_t size;
+};
+
+inline esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* out, size_t len) {
+    if (offset + len > part->size) return ESP_FAIL;
+    memcpy(out, part->data + offset, len);
+    return ESP_OK;
+}
+
+#endif // ESP_PARTITION_STUB_H
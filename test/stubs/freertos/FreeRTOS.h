@@ -0,0 +1,158 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    FREERTOS STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Tasks, queues and task notifications on std::thread, so the OTA download
+ * pipeline runs its two tasks for real on the host:
+ * - A task is a detached thread; vTaskDelete(nullptr) just returns
+ * - Queues copy items like FreeRTOS and block up to the given ticks
+ *   (1 tick = 1 ms)
+ * - vTaskDelay sleeps for real: millis() stays the test's clock
+ * 
+ * Included by the Arduino stub, as the ESP32 core does
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef FREERTOS_STUB_H
+#define FREERTOS_STUB_H
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       0xFFFFFFFFu
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+// ───────────────────────────────────────────────────────────────────────────
+// QUEUES
+// ───────────────────────────────────────────────────────────────────────────
+
+struct StubQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t itemSize;
+    size_t capacity;
+};
+
+typedef StubQueue* QueueHandle_t;
+
+// Wait for pred under lock, false once ticks ran out
+template <typename Pred>
+inline bool stubWait(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                     TickType_t ticks, Pred pred) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, pred);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return new StubQueue{{}, {}, {}, item_size, length};
+}
+
+inline void vQueueDelete(QueueHandle_t q) { delete q; }
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!stubWait(q->changed, lock, ticks, [q] { return q->items.size() < q->capacity; })) return pdFALSE;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!stubWait(q->changed, lock, ticks, [q] { return !q->items.empty(); })) return pdFALSE;
+    memcpy(out, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TASKS & NOTIFICATIONS
+// ───────────────────────────────────────────────────────────────────────────
+
+struct StubTask {
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t count = 0;
+};
+
+typedef StubTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+// Never freed: a handle stays valid after its thread returned
+inline std::list<StubTask> stubTasks;
+inline std::mutex stubTasksLock;
+
+inline StubTask* stubNewTask() {
+    std::lock_guard<std::mutex> guard(stubTasksLock);
+    stubTasks.emplace_back();
+    return &stubTasks.back();
+}
+
+inline StubTask*& stubCurrentTask() {
+    thread_local StubTask* self = nullptr;
+    return self;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (!stubCurrentTask()) stubCurrentTask() = stubNewTask();
+    return stubCurrentTask();
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    StubTask* task = stubNewTask();
+    if (handle) *handle = task;
+    std::thread([fn, arg, task] {
+        stubCurrentTask() = task;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t) {}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->count++;
+    task->notified.notify_all();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    StubTask* self = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(self->lock);
+    if (!stubWait(self->notified, lock, ticks, [self] { return self->count > 0; })) return 0;
+    uint32_t value = self->count;
+    self->count = clear ? 0 : value - 1;
+    return value;
+}
+
+#endif // FREERTOS_STUB_H
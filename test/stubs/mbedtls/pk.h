@@ -0,0 +1,44 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MBEDTLS PK STUB - Native Test Environment
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * No ECDSA on the host: any non-empty key parses, and a signature verifies
+ * when its bytes are the digest itself. Enough to test that the caller
+ * refuses what does not verify, not the cryptography
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MBEDTLS_PK_STUB_H
+#define MBEDTLS_PK_STUB_H
+
+#include <stddef.h>
+#include <string.h>
+
+#define MBEDTLS_ERR_PK_KEY_INVALID_FORMAT   -0x3D00
+#define MBEDTLS_ERR_ECP_VERIFY_FAILED       -0x4E00
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+typedef struct {
+    bool parsed;
+} mbedtls_pk_context;
+
+inline void mbedtls_pk_init(mbedtls_pk_context* ctx) { ctx->parsed = false; }
+inline void mbedtls_pk_free(mbedtls_pk_context* ctx) { ctx->parsed = false; }
+
+inline int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key, size_t len) {
+    ctx->parsed = key && len > 1;
+    return ctx->parsed ? 0 : MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+}
+
+inline int mbedtls_pk_verify(mbedtls_pk_context* ctx, mbedtls_md_type_t, const unsigned char* hash,
+                             size_t hash_len, const unsigned char* sig, size_t sig_len) {
+    if (!ctx->parsed || sig_len != hash_len || memcmp(sig, hash, hash_len) != 0) {
+        return MBEDTLS_ERR_ECP_VERIFY_FAILED;
+    }
+    return 0;
+}
+
+#endif // MBEDTLS_PK_STUB_H
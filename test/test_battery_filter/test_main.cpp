@@ -0,0 +1,114 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BATTERY FILTER - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Timed, filtered battery readings (src/managers/battery_filter.h):
+ * - First reading at once, then one per BATTERY_CHECK_INT_MS (millis wrap)
+ * - Median of a burst ignores spikes from a TX or display refresh
+ * - EMA over readings, cached in between
+ * - [SIM] ADC conversions: per-call reads vs the timer over an hour
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "managers/battery_filter.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TIMER
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_reading_timer() {
+    BatteryFilter filter;
+    TEST_ASSERT_FALSE(filter.hasReading());
+    TEST_ASSERT_TRUE(filter.due(12345));   // Boot: read at once
+    
+    filter.add(3.9f, 12345);
+    TEST_ASSERT_TRUE(filter.hasReading());
+    TEST_ASSERT_FALSE(filter.due(12345));
+    TEST_ASSERT_FALSE(filter.due(12345 + BATTERY_CHECK_INT_MS - 1));
+    TEST_ASSERT_TRUE(filter.due(12345 + BATTERY_CHECK_INT_MS));
+    
+    // Across the millis() wrap
+    BatteryFilter wrap;
+    wrap.add(3.9f, 0xFFFFFFFF - 1000);
+    TEST_ASSERT_FALSE(wrap.due(500));
+    TEST_ASSERT_TRUE(wrap.due(BATTERY_CHECK_INT_MS - 1001));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// FILTERS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_median_rejects_spikes() {
+    uint32_t mv[BATT_ADC_SAMPLES];
+    for (int i = 0; i < BATT_ADC_SAMPLES; i++) mv[i] = 790 + (i * 7) % 5;   // 790..794
+    mv[2] = 120;     // TX sag
+    mv[9] = 3100;    // Display refresh
+    mv[14] = 0;
+    uint32_t m = BatteryFilter::median(mv, BATT_ADC_SAMPLES);
+    TEST_ASSERT_TRUE(m >= 790 && m <= 794);
+    for (int i = 1; i < BATT_ADC_SAMPLES; i++) TEST_ASSERT_TRUE(mv[i - 1] <= mv[i]);
+    
+    uint32_t one[1] = {800};
+    TEST_ASSERT_EQUAL(800, BatteryFilter::median(one, 1));
+    uint32_t three[3] = {900, 100, 500};
+    TEST_ASSERT_EQUAL(500, BatteryFilter::median(three, 3));
+}
+
+void test_ema_and_cache() {
+    BatteryFilter filter;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, filter.add(4.0f, 0));   // First reading as is
+    float v = filter.add(3.0f, BATTERY_CHECK_INT_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f - BATT_VOLTAGE_ALPHA, v);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, v, filter.getVolts());
+    TEST_ASSERT_EQUAL(2, filter.getReadings());
+    TEST_ASSERT_EQUAL(BATTERY_CHECK_INT_MS, filter.getLastRead());
+    
+    // Settles on a steady voltage
+    for (int i = 0; i < 40; i++) filter.add(3.7f, BATTERY_CHECK_INT_MS * (i + 2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.7f, filter.getVolts());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIM
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_conversions_per_hour() {
+    // An hour of 10 ms loops; the old code read 16 conversions on every
+    // getBatteryPercent() (batch open, flush, BLE telemetry, 30 s check)
+    BatteryFilter filter;
+    uint32_t timed = 0;
+    uint32_t perCall = 0;
+    for (uint32_t now = 0; now < 3600000; now += 10) {
+        if (filter.due(now)) {
+            filter.add(3.8f, now);
+            timed += BATT_ADC_SAMPLES;
+        }
+        if (now % TELEMETRY_INTERVAL_MS == 0) perCall += 3 * 16;
+        if (now % BATTERY_CHECK_INT_MS == 0) perCall += 16;
+    }
+    printf("[SIM] ADC conversions per hour: %lu per call, %lu on the timer (%lu readings)\n",
+           (unsigned long)perCall, (unsigned long)timed, (unsigned long)filter.getReadings());
+    TEST_ASSERT_EQUAL(3600000 / BATTERY_CHECK_INT_MS, filter.getReadings());
+    TEST_ASSERT_TRUE(timed < perCall);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reading_timer);
+    RUN_TEST(test_median_rejects_spikes);
+    RUN_TEST(test_ema_and_cache);
+    RUN_TEST(test_conversions_per_hour);
+    return UNITY_END();
+}
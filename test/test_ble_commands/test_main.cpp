@@ -0,0 +1,368 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE COMMAND FUZZ - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * BleCommandDispatcher against a reference parser:
+ * - Unit cases: batches, unknown opcodes, bad lengths, truncated frames,
+ *   replies that do not fit the notification, replies deferred to loop()
+ * - 300k fuzzed writes (mutated valid batches + random bytes), each in an
+ *   exactly sized heap buffer (run with -fsanitize=address to catch
+ *   overreads); the reply buffer has a guard zone that must stay intact
+ * - Dispatch cost of a typical write (PARAM_SET + PING)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "ble/ble_command.h"
+
+static const size_t NOTIFY_LEN = 244;
+static const int FUZZ_RUNS = 300000;
+
+static uint32_t rngState;
+static int32_t lastParam = 0;
+static uint32_t handled = 0;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TEST TABLE
+// ───────────────────────────────────────────────────────────────────────────
+
+static BleCmdStatus hPing(const BleCommand& cmd, BleReply& reply) {
+    handled++;
+    reply.putBytes(cmd.payload, cmd.length);
+    return BLE_CMD_OK;
+}
+
+static BleCmdStatus hSet(const BleCommand& cmd, BleReply&) {
+    handled++;
+    if (cmd.u8(0) != 1) return BLE_CMD_BAD_VALUE;
+    lastParam = cmd.i32(1);
+    return BLE_CMD_OK;
+}
+
+static BleCmdStatus hGet(const BleCommand&, BleReply& reply) {
+    handled++;
+    reply.put32((uint32_t)lastParam);
+    return BLE_CMD_OK;
+}
+
+// Wants more reply room than a notification has
+static BleCmdStatus hDump(const BleCommand&, BleReply& reply) {
+    handled++;
+    for (int i = 0; i < 300; i++) reply.put8((uint8_t)i);
+    return BLE_CMD_OK;
+}
+
+static const BleCommandSpec TABLE[] = {
+    { BLE_CMD_PING,      0, 32, hPing },
+    { BLE_CMD_PARAM_SET, 5, 5,  hSet },
+    { BLE_CMD_PARAM_GET, 1, 1,  hGet },
+    { 0x40,              0, 0,  hDump },
+};
+
+static BleCommandDispatcher dispatcher(TABLE, sizeof(TABLE) / sizeof(TABLE[0]));
+
+// ───────────────────────────────────────────────────────────────────────────
+// REFERENCE MODEL
+// ───────────────────────────────────────────────────────────────────────────
+
+struct Reply {
+    uint8_t opcode;
+    uint8_t status;
+    std::vector<uint8_t> data;
+};
+
+static const BleCommandSpec* findSpec(uint8_t op) {
+    for (const BleCommandSpec& s : TABLE) {
+        if (s.opcode == op) return &s;
+    }
+    return nullptr;
+}
+
+// Replies the dispatcher should produce (before space limits)
+static std::vector<Reply> model(const uint8_t* d, size_t len) {
+    std::vector<Reply> out;
+    size_t pos = 0;
+    int32_t param = lastParam;
+    while (pos < len) {
+        if (len - pos < 2 || len - pos - 2 < d[pos + 1]) {
+            out.push_back({BLE_CMD_ERROR_OPCODE, BLE_CMD_MALFORMED, {(uint8_t)(pos > 255 ? 255 : pos)}});
+            break;
+        }
+        uint8_t op = d[pos], n = d[pos + 1];
+        const uint8_t* p = &d[pos + 2];
+        pos += 2 + n;
+        
+        Reply r = {(uint8_t)(op | 0x80), BLE_CMD_OK, {}};
+        const BleCommandSpec* spec = findSpec(op);
+        if (!spec) {
+            r.status = BLE_CMD_UNKNOWN;
+        } else if (n < spec->min_len || n > spec->max_len) {
+            r.status = BLE_CMD_BAD_LENGTH;
+        } else if (op == BLE_CMD_PING) {
+            r.data.assign(p, p + n);
+        } else if (op == BLE_CMD_PARAM_SET) {
+            if (p[0] != 1) r.status = BLE_CMD_BAD_VALUE;
+            else param = (int32_t)(p[1] | (p[2] << 8) | (p[3] << 16) | ((uint32_t)p[4] << 24));
+        } else if (op == BLE_CMD_PARAM_GET) {
+            for (int i = 0; i < 4; i++) r.data.push_back(((uint32_t)param >> (8 * i)) & 0xFF);
+        } else {
+            for (int i = 0; i < 300; i++) r.data.push_back((uint8_t)i);
+        }
+        out.push_back(r);
+    }
+    return out;
+}
+
+// Runs one write and checks the replies against the model
+static void checkWrite(const std::vector<uint8_t>& write, size_t outMax) {
+    std::vector<Reply> want = model(write.data(), write.size());
+    
+    // Exactly sized copy: any overread leaves the allocation
+    uint8_t* in = new uint8_t[write.size() ? write.size() : 1];
+    memcpy(in, write.data(), write.size());
+    uint8_t out[NOTIFY_LEN + 16];
+    memset(out, 0xA5, sizeof(out));
+    
+    size_t len = dispatcher.dispatch(write.size() ? in : nullptr, write.size(), out, outMax);
+    delete[] in;
+    
+    TEST_ASSERT_TRUE(len <= outMax);
+    for (size_t i = outMax; i < sizeof(out); i++) TEST_ASSERT_EQUAL_HEX8(0xA5, out[i]);
+    
+    // Walk the replies: same order, data cut only where space ran out
+    size_t pos = 0;
+    size_t k = 0;
+    while (pos < len) {
+        TEST_ASSERT_TRUE(k < want.size());
+        TEST_ASSERT_TRUE(pos + 3 <= len);
+        const Reply& r = want[k++];
+        TEST_ASSERT_EQUAL_HEX8(r.opcode, out[pos]);
+        TEST_ASSERT_EQUAL(r.status, out[pos + 2]);
+        size_t n = out[pos + 1] - 1;
+        TEST_ASSERT_TRUE(n <= r.data.size());
+        TEST_ASSERT_TRUE(pos + 3 + n <= len);
+        TEST_ASSERT_TRUE(n == r.data.size() || pos + 3 + n == outMax || n == 254);
+        TEST_ASSERT_TRUE(n == 0 || memcmp(&out[pos + 3], r.data.data(), n) == 0);
+        pos += 3 + n;
+    }
+    TEST_ASSERT_EQUAL(len, pos);
+    // Missing replies only when the next one had no room (MALFORMED carries its offset)
+    TEST_ASSERT_TRUE(k == want.size() || len + 3 + (want[k].opcode == BLE_CMD_ERROR_OPCODE) > outMax);
+}
+
+static std::vector<uint8_t> cmd(uint8_t op, std::vector<uint8_t> payload) {
+    std::vector<uint8_t> v = {op, (uint8_t)payload.size()};
+    v.insert(v.end(), payload.begin(), payload.end());
+    return v;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {}
+void tearDown() {}
+
+void test_batch_of_commands() {
+    std::vector<uint8_t> w = cmd(BLE_CMD_PARAM_SET, {1, 0x78, 0x56, 0x34, 0x12});
+    std::vector<uint8_t> get = cmd(BLE_CMD_PARAM_GET, {1});
+    std::vector<uint8_t> ping = cmd(BLE_CMD_PING, {'h', 'i'});
+    w.insert(w.end(), get.begin(), get.end());
+    w.insert(w.end(), ping.begin(), ping.end());
+    
+    uint8_t out[NOTIFY_LEN];
+    size_t len = dispatcher.dispatch(w.data(), w.size(), out, sizeof(out));
+    const uint8_t expect[] = {
+        0x90, 1, BLE_CMD_OK,
+        0x91, 5, BLE_CMD_OK, 0x78, 0x56, 0x34, 0x12,
+        0x81, 3, BLE_CMD_OK, 'h', 'i'
+    };
+    TEST_ASSERT_EQUAL(sizeof(expect), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expect, out, len);
+    TEST_ASSERT_EQUAL(0x12345678, lastParam);
+}
+
+void test_rejects_bad_commands() {
+    uint8_t out[NOTIFY_LEN];
+    
+    // Unknown opcode, then a length the table does not allow
+    std::vector<uint8_t> w = cmd(0x55, {});
+    std::vector<uint8_t> bad = cmd(BLE_CMD_PARAM_SET, {1, 2});
+    w.insert(w.end(), bad.begin(), bad.end());
+    size_t len = dispatcher.dispatch(w.data(), w.size(), out, sizeof(out));
+    const uint8_t expect[] = {0xD5, 1, BLE_CMD_UNKNOWN, 0x90, 1, BLE_CMD_BAD_LENGTH};
+    TEST_ASSERT_EQUAL(sizeof(expect), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expect, out, len);
+    
+    // Truncated payload: the good command before it still runs
+    std::vector<uint8_t> t = cmd(BLE_CMD_PING, {});
+    t.push_back(BLE_CMD_PING);
+    t.push_back(10);
+    t.push_back('x');
+    len = dispatcher.dispatch(t.data(), t.size(), out, sizeof(out));
+    const uint8_t expectTrunc[] = {0x81, 1, BLE_CMD_OK, 0xFF, 2, BLE_CMD_MALFORMED, 2};
+    TEST_ASSERT_EQUAL(sizeof(expectTrunc), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectTrunc, out, len);
+    
+    // Lone opcode byte
+    uint8_t lone = BLE_CMD_PING;
+    len = dispatcher.dispatch(&lone, 1, out, sizeof(out));
+    TEST_ASSERT_EQUAL(4, len);
+    TEST_ASSERT_EQUAL(BLE_CMD_MALFORMED, out[2]);
+    
+    // 0x7F and up are never commands (0xFF is the error reply)
+    std::vector<uint8_t> high = cmd(0x7F, {});
+    len = dispatcher.dispatch(high.data(), high.size(), out, sizeof(out));
+    TEST_ASSERT_EQUAL(BLE_CMD_UNKNOWN, out[2]);
+    
+    // Not even from a table entry: registration and lookup share the bound
+    static const BleCommandSpec highTable[] = { { 0x7F, 0, 0, hPing } };
+    BleCommandDispatcher highOnly(highTable, 1);
+    len = highOnly.dispatch(high.data(), high.size(), out, sizeof(out));
+    TEST_ASSERT_EQUAL(BLE_CMD_UNKNOWN, out[2]);
+    
+    TEST_ASSERT_EQUAL(0, dispatcher.dispatch(nullptr, 0, out, sizeof(out)));
+}
+
+void test_reply_space_is_bounded() {
+    uint32_t dropped = dispatcher.getRepliesDropped();
+    
+    // One reply larger than a notification is cut at the buffer end
+    std::vector<uint8_t> w = cmd(0x40, {});
+    checkWrite(w, NOTIFY_LEN);
+    checkWrite(w, 20);
+    
+    // 122 unknown commands need 366 reply bytes: the tail is dropped
+    w.clear();
+    for (int i = 0; i < 122; i++) {
+        w.push_back(0x60);
+        w.push_back(0);
+    }
+    checkWrite(w, NOTIFY_LEN);
+    TEST_ASSERT_EQUAL(dropped + 122 - NOTIFY_LEN / 3, dispatcher.getRepliesDropped());
+}
+
+// Work handed to loop(): no reply now, loop() builds it later
+static BleCmdStatus hDefer(const BleCommand&, BleReply&) {
+    handled++;
+    return BLE_CMD_DEFERRED;
+}
+
+void test_deferred_reply() {
+    static const BleCommandSpec deferTable[] = {
+        { BLE_CMD_PING,      0, 32, hPing },
+        { BLE_CMD_PARAM_GET, 1, 1,  hDefer },
+    };
+    BleCommandDispatcher d(deferTable, 2);
+    uint32_t failed = d.getFailed();
+    
+    std::vector<uint8_t> w = cmd(BLE_CMD_PARAM_GET, {1});
+    std::vector<uint8_t> ping = cmd(BLE_CMD_PING, {'h'});
+    w.insert(w.end(), ping.begin(), ping.end());
+    uint8_t out[NOTIFY_LEN];
+    size_t len = d.dispatch(w.data(), w.size(), out, sizeof(out));
+    const uint8_t expect[] = {0x81, 2, BLE_CMD_OK, 'h'};
+    TEST_ASSERT_EQUAL(sizeof(expect), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expect, out, len);
+    TEST_ASSERT_EQUAL(failed, d.getFailed());
+    
+    const uint8_t value[] = {0x78, 0x56, 0x34, 0x12};
+    const uint8_t expectLater[] = {0x91, 5, BLE_CMD_OK, 0x78, 0x56, 0x34, 0x12};
+    len = BleCommandDispatcher::buildReply(out, sizeof(out), BLE_CMD_PARAM_GET, BLE_CMD_OK, value, 4);
+    TEST_ASSERT_EQUAL(sizeof(expectLater), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectLater, out, len);
+    TEST_ASSERT_EQUAL(0, BleCommandDispatcher::buildReply(out, 6, BLE_CMD_PARAM_GET, BLE_CMD_OK, value, 4));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// FUZZ + TIMING
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_fuzz_against_model() {
+    rngState = 0x9E3779B9;
+    const uint8_t ops[] = {BLE_CMD_PING, BLE_CMD_PARAM_SET, BLE_CMD_PARAM_GET, 0x40, 0x02, 0x7F, 0xFF};
+    uint32_t commandsBefore = dispatcher.getCommands();
+    uint32_t malformedBefore = dispatcher.getMalformed();
+    
+    for (int run = 0; run < FUZZ_RUNS; run++) {
+        std::vector<uint8_t> w;
+        uint32_t mode = rnd() % 4;
+        
+        if (mode == 0) {
+            // Pure noise
+            size_t n = rnd() % (NOTIFY_LEN + 1);
+            for (size_t i = 0; i < n; i++) w.push_back(rnd() & 0xFF);
+        } else {
+            // Valid-looking batch, then mutations
+            int count = 1 + rnd() % 8;
+            for (int c = 0; c < count; c++) {
+                uint8_t op = ops[rnd() % sizeof(ops)];
+                size_t n = (rnd() % 4 == 0) ? rnd() % 40 : (op == BLE_CMD_PARAM_SET ? 5 : op == BLE_CMD_PARAM_GET ? 1 : rnd() % 8);
+                w.push_back(op);
+                w.push_back((uint8_t)n);
+                for (size_t i = 0; i < n; i++) w.push_back((rnd() % 3 == 0) ? 1 : rnd() & 0xFF);
+            }
+            if (mode >= 2 && !w.empty()) {
+                int flips = 1 + rnd() % 3;
+                for (int f = 0; f < flips; f++) w[rnd() % w.size()] ^= 1 << (rnd() % 8);
+            }
+            if (mode == 3 && !w.empty()) w.resize(rnd() % (w.size() + 1));
+            if (w.size() > NOTIFY_LEN) w.resize(NOTIFY_LEN);
+        }
+        
+        size_t outMax = (rnd() % 4 == 0) ? 3 + rnd() % 40 : NOTIFY_LEN;
+        checkWrite(w, outMax);
+    }
+    
+    printf("[FUZZ] %d writes: %lu commands dispatched, %lu handled, %lu malformed writes, "
+           "%lu replies dropped\n",
+           FUZZ_RUNS, (unsigned long)(dispatcher.getCommands() - commandsBefore),
+           (unsigned long)handled, (unsigned long)(dispatcher.getMalformed() - malformedBefore),
+           (unsigned long)dispatcher.getRepliesDropped());
+}
+
+void test_dispatch_cost() {
+    std::vector<uint8_t> w = cmd(BLE_CMD_PARAM_SET, {1, 1, 0, 0, 0});
+    std::vector<uint8_t> ping = cmd(BLE_CMD_PING, {1, 2, 3, 4, 5, 6, 7, 8});
+    w.insert(w.end(), ping.begin(), ping.end());
+    
+    uint8_t out[NOTIFY_LEN];
+    const int runs = 1000000;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        w[3] = (uint8_t)i;
+        total += dispatcher.dispatch(w.data(), w.size(), out, sizeof(out));
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+    
+    printf("[BENCH] PARAM_SET + PING write: %.0f ns per dispatch on the host (%lu reply bytes)\n",
+           ns, (unsigned long)(total / runs));
+    TEST_ASSERT_EQUAL(14, total / runs);
+    TEST_ASSERT_TRUE(ns < 2000);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_of_commands);
+    RUN_TEST(test_rejects_bad_commands);
+    RUN_TEST(test_reply_space_is_bounded);
+    RUN_TEST(test_deferred_reply);
+    RUN_TEST(test_fuzz_against_model);
+    RUN_TEST(test_dispatch_cost);
+    return UNITY_END();
+}
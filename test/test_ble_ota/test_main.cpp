@@ -0,0 +1,370 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE OTA TRANSFER - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * OtaTransfer unit cases plus a 1 ms step simulation of a full image:
+ * - Phone: OS write queue, window of OTA_WINDOW past the last ACK,
+ *   rewinds on NACK or after 1 s without progress (like OtaSender.js)
+ * - Link: 4 writes per 15 ms connection event (the slow end of the OTA
+ *   interval), notifications delivered at the next event
+ * - Device: the OTA task is blocked 35 ms per 4 KB block (sector erase +
+ *   write) and only sends ACKs between blocks
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "ble/ota_transfer.h"
+
+static const uint32_t CONN_INTERVAL_MS = 15;
+static const int WRITES_PER_EVENT = 4;
+static const uint32_t FLASH_BLOCK_MS = 35;
+static const size_t CHUNK = BLE_MTU - 3 - OTA_DATA_HEADER_LEN;   // 240
+static const size_t OS_QUEUE = 16;
+static const uint32_t STALL_MS = 1000;
+
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static OtaTransfer transfer;
+static uint8_t sha[OTA_SHA256_LEN];
+
+static std::vector<uint8_t> makeImage(size_t n) {
+    std::vector<uint8_t> img(n);
+    for (size_t i = 0; i < n; i++) img[i] = rnd() & 0xFF;
+    return img;
+}
+
+static std::vector<uint8_t> packet(const std::vector<uint8_t>& img, uint32_t offset, size_t n) {
+    std::vector<uint8_t> p(OTA_DATA_HEADER_LEN + n);
+    p[0] = offset & 0xFF;
+    p[1] = (offset >> 8) & 0xFF;
+    p[2] = (offset >> 16) & 0xFF;
+    p[3] = offset >> 24;
+    memcpy(&p[OTA_DATA_HEADER_LEN], &img[offset], n);
+    return p;
+}
+
+static uint32_t msgOffset(const uint8_t* m) {
+    return m[1] | (m[2] << 8) | (m[3] << 16) | ((uint32_t)m[4] << 24);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+struct SimConfig {
+    float loss = 0.0f;                  // Writes lost on the way (phone stack drops)
+    uint32_t disconnectAt = 0;          // Bytes ACKed when the link drops (0 = never)
+    uint32_t reconnectMs = 2000;
+    bool ignoreWindow = false;          // Misbehaving sender
+    uint32_t flashBlockMs = FLASH_BLOCK_MS;
+};
+
+struct SimResult {
+    bool done = false;
+    uint32_t ms = 0;
+    uint32_t bytesSent = 0;
+    uint32_t resumedAt = 0;
+    bool intact = false;                // Flash holds exactly the image
+};
+
+static SimResult simulate(const std::vector<uint8_t>& img, const SimConfig& cfg) {
+    SimResult res;
+    std::vector<uint8_t> flash(img.size(), 0);
+    std::deque<std::vector<uint8_t>> writes;            // Phone OS queue
+    std::deque<std::vector<uint8_t>> notifies;          // Device → phone
+    
+    const uint32_t size = img.size();
+    transfer.begin(size, sha);
+    
+    // Phone
+    uint32_t next = 0, acked = 0, lastProgress = 0;
+    bool waitAck = true;            // Sends only after the first ACK (resume point)
+    bool linkUp = true;
+    uint32_t downSince = 0;
+    bool dropped = false;
+    
+    // Device
+    bool flashing = false;
+    uint32_t flashDone = 0;
+    const uint8_t* block = nullptr;
+    size_t blockLen = 0;
+    uint32_t flashPos = 0;
+    
+    for (uint32_t now = 0; now < 600000; now++) {
+        // ── Link drop and return: everything in flight is lost
+        if (linkUp && cfg.disconnectAt && !dropped && acked >= cfg.disconnectAt) {
+            linkUp = false;
+            dropped = true;
+            downSince = now;
+            writes.clear();
+            notifies.clear();
+        }
+        if (!linkUp && now - downSince >= cfg.reconnectMs) {
+            linkUp = true;
+            transfer.begin(size, sha);      // OTA_BEGIN with the same image
+            waitAck = true;
+            lastProgress = now;
+        }
+        
+        // ── Connection event
+        if (linkUp && now % CONN_INTERVAL_MS == 0) {
+            for (int i = 0; i < WRITES_PER_EVENT && !writes.empty(); i++) {
+                std::vector<uint8_t> w = writes.front();
+                writes.pop_front();
+                if ((float)(rnd() % 10000) / 10000.0f < cfg.loss) continue;
+                transfer.onPacket(w.data(), w.size());
+            }
+            while (!notifies.empty()) {
+                const std::vector<uint8_t>& m = notifies.front();
+                uint32_t off = msgOffset(m.data());
+                if (m[0] == OTA_MSG_ACK) {
+                    if (waitAck) {
+                        waitAck = false;
+                        if (res.resumedAt == 0 && off > 0) res.resumedAt = off;
+                        next = acked = off;
+                        lastProgress = now;
+                    } else if (off > acked) {
+                        acked = off;
+                        lastProgress = now;
+                    }
+                    if (next < acked) next = acked;
+                } else if (m[0] == OTA_MSG_NACK && !waitAck && off < next) {
+                    next = off;
+                }
+                notifies.pop_front();
+            }
+        }
+        // OTA_END: the device answers once everything is on flash
+        if (acked == size && !waitAck && transfer.complete()) {
+            res.done = true;
+            res.ms = now;
+            break;
+        }
+        
+        // ── Phone: fill the OS queue within the window
+        if (linkUp && !waitAck) {
+            if (now - lastProgress > STALL_MS) {
+                next = acked;
+                lastProgress = now;
+            }
+            uint32_t limit = cfg.ignoreWindow ? size : acked + OTA_WINDOW;
+            while (writes.size() < OS_QUEUE && next < size && next < limit) {
+                size_t n = CHUNK;
+                if (n > size - next) n = size - next;
+                if (n > limit - next) n = limit - next;
+                writes.push_back(packet(img, next, n));
+                res.bytesSent += n;
+                next += n;
+            }
+        }
+        
+        // ── Device OTA task: blocked while a sector is written
+        if (flashing && now >= flashDone) {
+            memcpy(&flash[flashPos], block, blockLen);
+            transfer.release(blockLen);
+            flashing = false;
+        }
+        if (!flashing) {
+            uint8_t m[OTA_ACK_LEN];
+            if (linkUp && transfer.takeNack(m)) notifies.push_back(std::vector<uint8_t>(m, m + OTA_ACK_LEN));
+            if (linkUp && transfer.takeAck(m)) notifies.push_back(std::vector<uint8_t>(m, m + OTA_ACK_LEN));
+            blockLen = transfer.readyBlock(&block);
+            if (blockLen) {
+                flashPos = transfer.getFlashed();
+                flashing = true;
+                flashDone = now + cfg.flashBlockMs * blockLen / OTA_BLOCK_SIZE + 1;
+            }
+        }
+    }
+    
+    res.intact = transfer.complete() && memcmp(img.data(), flash.data(), img.size()) == 0;
+    return res;
+}
+
+static void report(const char* name, const std::vector<uint8_t>& img, const SimResult& r) {
+    printf("[SIM] %s: %u KB in %.2f s = %.1f KB/s, %.1f%% resent, %lu NACKs, %lu out of order, "
+           "%lu duplicates, %lu overruns\n",
+           name, (unsigned)(img.size() / 1024), r.ms / 1000.0, img.size() / 1024.0 / (r.ms / 1000.0),
+           100.0 * (r.bytesSent - img.size()) / img.size(), (unsigned long)transfer.getNacks(),
+           (unsigned long)transfer.getOutOfOrder(), (unsigned long)transfer.getDuplicates(),
+           (unsigned long)transfer.getOverruns());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {
+    rngState = 0x2545F491;
+    memset(sha, 0x5A, sizeof(sha));
+}
+void tearDown() {
+    transfer.end();
+}
+
+void test_packets_gaps_and_overlaps() {
+    std::vector<uint8_t> img = makeImage(10000);
+    transfer.begin(img.size(), sha);
+    
+    uint8_t m[OTA_ACK_LEN];
+    TEST_ASSERT_EQUAL(OTA_ACK_LEN, transfer.takeAck(m));     // Start announcement
+    TEST_ASSERT_EQUAL(OTA_MSG_ACK, m[0]);
+    TEST_ASSERT_EQUAL(0, msgOffset(m));
+    
+    std::vector<uint8_t> p = packet(img, 0, 240);
+    TEST_ASSERT_TRUE(transfer.onPacket(p.data(), p.size()));
+    
+    // Gap: NACKed once, not per stray packet
+    p = packet(img, 480, 240);
+    TEST_ASSERT_FALSE(transfer.onPacket(p.data(), p.size()));
+    p = packet(img, 720, 240);
+    TEST_ASSERT_FALSE(transfer.onPacket(p.data(), p.size()));
+    TEST_ASSERT_EQUAL(OTA_ACK_LEN, transfer.takeNack(m));
+    TEST_ASSERT_EQUAL(OTA_MSG_NACK, m[0]);
+    TEST_ASSERT_EQUAL(240, msgOffset(m));
+    TEST_ASSERT_EQUAL(0, transfer.takeNack(m));
+    
+    // Rewind overlapping what we have: only the new tail is taken
+    p = packet(img, 100, 400);
+    TEST_ASSERT_TRUE(transfer.onPacket(p.data(), p.size()));
+    TEST_ASSERT_EQUAL(500, transfer.getReceived());
+    p = packet(img, 0, 240);
+    TEST_ASSERT_FALSE(transfer.onPacket(p.data(), p.size()));
+    TEST_ASSERT_EQUAL(1, transfer.getDuplicates());
+    
+    // Header only / nothing
+    TEST_ASSERT_FALSE(transfer.onPacket(p.data(), OTA_DATA_HEADER_LEN));
+}
+
+void test_blocks_and_ack_window() {
+    std::vector<uint8_t> img = makeImage(3 * OTA_RING_SIZE + 100);
+    transfer.begin(img.size(), sha);
+    uint8_t m[OTA_ACK_LEN];
+    transfer.takeAck(m);
+    
+    const uint8_t* block;
+    std::vector<uint8_t> out;
+    uint32_t off = 0;
+    while (off < OTA_WINDOW) {
+        std::vector<uint8_t> p = packet(img, off, CHUNK);
+        transfer.onPacket(p.data(), p.size());
+        off += CHUNK;
+    }
+    
+    // A full window past this offset does not fit until a block is flashed
+    TEST_ASSERT_EQUAL(0, transfer.takeAck(m));
+    TEST_ASSERT_EQUAL(OTA_BLOCK_SIZE, transfer.readyBlock(&block));
+    TEST_ASSERT_EQUAL_MEMORY(&img[0], block, OTA_BLOCK_SIZE);
+    out.insert(out.end(), block, block + OTA_BLOCK_SIZE);
+    transfer.release(OTA_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(OTA_ACK_LEN, transfer.takeAck(m));
+    TEST_ASSERT_EQUAL(off, msgOffset(m));
+    
+    // Less than a step of progress: no ACK
+    std::vector<uint8_t> p = packet(img, off, CHUNK);
+    transfer.onPacket(p.data(), p.size());
+    off += CHUNK;
+    TEST_ASSERT_EQUAL(0, transfer.takeAck(m));
+    
+    // Every block comes out whole and in order across the ring wrap, then the tail
+    while (transfer.getFlashed() < img.size()) {
+        size_t n;
+        while ((n = transfer.readyBlock(&block)) > 0) {
+            out.insert(out.end(), block, block + n);
+            transfer.release(n);
+        }
+        uint32_t room = transfer.getFlashed() + OTA_RING_SIZE - transfer.getReceived();
+        size_t len = room < CHUNK ? room : CHUNK;
+        if (len > img.size() - off) len = img.size() - off;
+        if (len == 0) continue;
+        std::vector<uint8_t> p = packet(img, off, len);
+        TEST_ASSERT_TRUE(transfer.onPacket(p.data(), p.size()));
+        off += len;
+    }
+    TEST_ASSERT_EQUAL(img.size(), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(img.data(), out.data(), img.size());
+    TEST_ASSERT_TRUE(transfer.complete());
+    TEST_ASSERT_EQUAL(0, transfer.getOverruns());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TRANSFER SIMULATIONS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_clean_transfer_throughput() {
+    std::vector<uint8_t> img = makeImage(1200 * 1024);
+    SimResult r = simulate(img, SimConfig());
+    report("clean 1.2 MB", img, r);
+    TEST_ASSERT_TRUE(r.done);
+    TEST_ASSERT_TRUE(r.intact);
+    
+    // The link carries 4 x 240 bytes per 15 ms = 62.5 KB/s
+    double kbps = img.size() / 1024.0 / (r.ms / 1000.0);
+    TEST_ASSERT_TRUE(kbps > 0.85 * (WRITES_PER_EVENT * CHUNK / 1024.0) * (1000.0 / CONN_INTERVAL_MS));
+    TEST_ASSERT_EQUAL(img.size(), r.bytesSent);
+    TEST_ASSERT_EQUAL(0, transfer.getOverruns());
+}
+
+void test_lossy_transfer() {
+    std::vector<uint8_t> img = makeImage(400 * 1024);
+    SimConfig cfg;
+    cfg.loss = 0.01f;
+    SimResult r = simulate(img, cfg);
+    report("1% writes lost", img, r);
+    TEST_ASSERT_TRUE(r.done);
+    TEST_ASSERT_TRUE(r.intact);
+    TEST_ASSERT_TRUE(transfer.getNacks() > 0);
+    TEST_ASSERT_EQUAL(0, transfer.getOverruns());
+}
+
+void test_resume_after_disconnect() {
+    std::vector<uint8_t> img = makeImage(600 * 1024);
+    SimConfig cfg;
+    cfg.disconnectAt = 250 * 1024;
+    SimResult r = simulate(img, cfg);
+    report("disconnect at 250 KB", img, r);
+    TEST_ASSERT_TRUE(r.done);
+    TEST_ASSERT_TRUE(r.intact);
+    
+    // Continues where the ring ends, resends at most what was in flight
+    TEST_ASSERT_EQUAL(1, transfer.getResumes());
+    TEST_ASSERT_TRUE(r.resumedAt >= cfg.disconnectAt);
+    TEST_ASSERT_TRUE(r.bytesSent - img.size() <= OTA_WINDOW + OS_QUEUE * CHUNK);
+}
+
+void test_sender_ignoring_window() {
+    std::vector<uint8_t> img = makeImage(200 * 1024);
+    SimConfig cfg;
+    cfg.ignoreWindow = true;
+    cfg.flashBlockMs = 200;             // Flash slower than the link: the ring fills
+    SimResult r = simulate(img, cfg);
+    report("sender ignores window", img, r);
+    TEST_ASSERT_TRUE(r.done);
+    TEST_ASSERT_TRUE(r.intact);
+    TEST_ASSERT_TRUE(transfer.getOverruns() > 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_packets_gaps_and_overlaps);
+    RUN_TEST(test_blocks_and_ack_window);
+    RUN_TEST(test_clean_transfer_throughput);
+    RUN_TEST(test_lossy_transfer);
+    RUN_TEST(test_resume_after_disconnect);
+    RUN_TEST(test_sender_ignoring_window);
+    return UNITY_END();
+}
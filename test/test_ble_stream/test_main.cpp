@@ -0,0 +1,126 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    BLE STREAM - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * BleStreamPacker from SensorData to notification bytes, decoded the way
+ * the dashboard does it (dashboard/src/services/BLEService.js: mg / 1000
+ * = g, gyro / 10 = deg/s):
+ * - Unit conversion: SensorData is m/s^2 and rad/s
+ * - Frame layout, timestamps and saturation
+ * - Backpressure: nothing leaves the queue until commit()
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <math.h>
+
+#include "ble/ble_stream.h"
+
+static const size_t NOTIFY_LEN = 244;
+
+void setUp() {}
+void tearDown() {}
+
+static int16_t readI16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNITS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_sample_roundtrips_in_dashboard_units() {
+    // 1 g down, turning at 90, -45 and 3.6 deg/s
+    SensorData d = {};
+    d.accel_x = 0.0f;
+    d.accel_y = -4.905f;
+    d.accel_z = 9.81f;
+    d.gyro_x = 1.5707963f;
+    d.gyro_y = -0.7853982f;
+    d.gyro_z = 0.0628319f;
+    
+    BleStreamPacker p;
+    p.push(BleStreamPacker::fromSensor(d, 1000));
+    
+    uint8_t out[NOTIFY_LEN];
+    size_t len = p.build(out, sizeof(out));
+    TEST_ASSERT_EQUAL(BLE_STREAM_HEADER_LEN + BLE_IMU_SAMPLE_LEN, len);
+    
+    const uint8_t* s = &out[BLE_STREAM_HEADER_LEN];
+    TEST_ASSERT_EQUAL(0, s[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, readI16(&s[1]) / 1000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -0.5f, readI16(&s[3]) / 1000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, readI16(&s[5]) / 1000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 90.0f, readI16(&s[7]) / 10.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -45.0f, readI16(&s[9]) / 10.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 3.6f, readI16(&s[11]) / 10.0f);
+}
+
+void test_gyro_saturates_at_full_scale() {
+    // 60 rad/s is past the 3276.7 deg/s an int16 holds
+    SensorData d = {};
+    d.gyro_x = 60.0f;
+    d.gyro_y = -60.0f;
+    
+    ImuSample s = BleStreamPacker::fromSensor(d, 0);
+    TEST_ASSERT_EQUAL(32767, s.gyro[0]);
+    TEST_ASSERT_EQUAL(-32768, s.gyro[1]);
+    TEST_ASSERT_EQUAL(0, s.gyro[2]);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// FRAMING
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_frame_header_and_time_deltas() {
+    BleStreamPacker p;
+    SensorData d = {};
+    p.push(BleStreamPacker::fromSensor(d, 70000));
+    p.push(BleStreamPacker::fromSensor(d, 70010));
+    p.push(BleStreamPacker::fromSensor(d, 70400));   // Gap past 255 ms
+    
+    uint8_t out[NOTIFY_LEN];
+    size_t len = p.build(out, sizeof(out));
+    TEST_ASSERT_EQUAL(BLE_STREAM_HEADER_LEN + 3 * BLE_IMU_SAMPLE_LEN, len);
+    TEST_ASSERT_EQUAL_HEX8(BLE_FRAME_IMU, out[0]);
+    TEST_ASSERT_EQUAL(3, out[1]);
+    TEST_ASSERT_EQUAL(0, out[2] | (out[3] << 8));
+    TEST_ASSERT_EQUAL(70000, out[4] | (out[5] << 8) | (out[6] << 16) | ((uint32_t)out[7] << 24));
+    TEST_ASSERT_EQUAL(0, out[BLE_STREAM_HEADER_LEN]);
+    TEST_ASSERT_EQUAL(10, out[BLE_STREAM_HEADER_LEN + BLE_IMU_SAMPLE_LEN]);
+    TEST_ASSERT_EQUAL(255, out[BLE_STREAM_HEADER_LEN + 2 * BLE_IMU_SAMPLE_LEN]);
+}
+
+void test_samples_stay_queued_until_commit() {
+    BleStreamPacker p;
+    SensorData d = {};
+    for (uint32_t i = 0; i < 20; i++) p.push(BleStreamPacker::fromSensor(d, i));
+    
+    // 34-byte notification: two samples
+    uint8_t out[NOTIFY_LEN];
+    TEST_ASSERT_EQUAL(BLE_STREAM_HEADER_LEN + 2 * BLE_IMU_SAMPLE_LEN, p.build(out, 34));
+    TEST_ASSERT_EQUAL(20, p.pending());
+    
+    // Stack refused it: the retry after an MTU exchange starts at the same sample
+    size_t len = p.build(out, sizeof(out));
+    TEST_ASSERT_EQUAL(BLE_STREAM_HEADER_LEN + 18 * BLE_IMU_SAMPLE_LEN, len);
+    TEST_ASSERT_EQUAL(0, out[4]);
+    p.commit();
+    TEST_ASSERT_EQUAL(2, p.pending());
+    TEST_ASSERT_EQUAL(18, p.getSent());
+    
+    p.build(out, sizeof(out));
+    TEST_ASSERT_EQUAL(1, out[2]);
+    TEST_ASSERT_EQUAL(18, out[4]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_roundtrips_in_dashboard_units);
+    RUN_TEST(test_gyro_saturates_at_full_scale);
+    RUN_TEST(test_frame_header_and_time_deltas);
+    RUN_TEST(test_samples_stay_queued_until_commit);
+    return UNITY_END();
+}
@@ -0,0 +1,319 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    CAPTURE SIMULATION - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Raw IMU capture at 1 kHz for 60 simulated seconds, 1 ms steps:
+ * - MPU6050 FIFO holds 85 samples, the FIFO task polls it every
+ *   CAPTURE_POLL_MS (+ jitter) into the CaptureRing
+ * - loop() runs every 12-20 ms and stalls 150 ms every ~2 s (display,
+ *   LoRa, module work); it sends like CaptureManager::drain()
+ * - Link: 30 ms connection interval (the slowest the device asks for),
+ *   4 packets per connection event, 10% of events lost, 10 controller
+ *   buffers (esp_ble_get_cur_sendable_packets_num)
+ * 
+ * Checks: every sample arrives exactly once, in order, at its index; a
+ * forced FIFO overflow shows up as a gap of exactly the lost samples
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "ble/capture_stream.h"
+
+static const uint32_t SIM_MS = 60000;
+static const uint16_t ODR_HZ = 1000;
+static const int FIFO_SAMPLES = 1024 / CAPTURE_SAMPLE_LEN;
+static const uint32_t CONN_INTERVAL_MS = 30;
+static const int PACKETS_PER_EVENT = 4;
+static const int EVENT_LOSS_PCT = 10;
+static const int CONTROLLER_BUFFERS = 10;
+
+static CaptureRing ring;
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// Sample contents encode the true IMU index, so misplaced samples show
+static RawImuSample sampleFor(uint32_t i) {
+    RawImuSample s;
+    s.accel[0] = (int16_t)(i & 0x7FFF);
+    s.accel[1] = (int16_t)-(int32_t)(i % 4096);
+    s.accel[2] = (int16_t)(i >> 15);
+    s.gyro[0] = (int16_t)(i * 7);
+    s.gyro[1] = -32768;
+    s.gyro[2] = 32767;
+    return s;
+}
+
+static int16_t rd16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RECEIVER (same checks as the dashboard recorder)
+// ───────────────────────────────────────────────────────────────────────────
+
+struct Receiver {
+    uint32_t expected = 0;
+    uint32_t samples = 0;
+    uint32_t gaps = 0;
+    uint32_t missing = 0;
+    uint32_t misplaced = 0;
+    
+    void onFrame(const uint8_t* f, size_t len) {
+        if (len < CAPTURE_IMU_HEADER_LEN || f[0] != BLE_FRAME_CAPTURE_IMU) return;
+        uint8_t n = f[1];
+        uint32_t first = rd32(&f[2]);
+        TEST_ASSERT_EQUAL(CAPTURE_IMU_HEADER_LEN + n * CAPTURE_SAMPLE_LEN, len);
+        TEST_ASSERT_TRUE(first >= expected);   // Never a duplicate or reordering
+        if (first != expected) {
+            gaps++;
+            missing += first - expected;
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            RawImuSample want = sampleFor(first + i);
+            const uint8_t* p = &f[CAPTURE_IMU_HEADER_LEN + i * CAPTURE_SAMPLE_LEN];
+            bool ok = true;
+            for (int a = 0; a < 3; a++) {
+                ok = ok && rd16(&p[a * 2]) == want.accel[a] && rd16(&p[6 + a * 2]) == want.gyro[a];
+            }
+            if (!ok) misplaced++;
+        }
+        samples += n;
+        expected = first + n;
+    }
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+struct SimResult {
+    Receiver rx;
+    uint32_t produced;
+    uint32_t notifications;
+};
+
+static SimResult simulate(size_t maxNotify, uint32_t taskStallAt, uint32_t taskStallMs) {
+    SimResult r;
+    ring.reset();
+    rngState = 0x2545F491;
+    
+    std::deque<uint32_t> fifo;
+    bool fifoOverflow = false;
+    std::deque<std::vector<uint8_t>> controller;
+    uint8_t frame[BLE_MTU - 3];
+    
+    uint32_t nextTask = CAPTURE_POLL_MS;
+    uint32_t nextLoop = 15;
+    uint32_t nextStall = 2000;
+    uint32_t lastFrame = 0;
+    r.notifications = 0;
+    
+    for (uint32_t t = 0; t < SIM_MS; t++) {
+        // IMU: sample t is ready at t + 1 ms; a full FIFO drops the oldest
+        if (fifo.size() == (size_t)FIFO_SAMPLES) {
+            fifo.pop_front();
+            fifoOverflow = true;
+        }
+        fifo.push_back(t);
+        
+        // FIFO task (readFifo + CaptureManager::taskLoop / resync)
+        if (t >= nextTask) {
+            size_t n = 0;
+            if (fifoOverflow) {
+                fifo.clear();
+                fifoOverflow = false;
+                uint32_t expected = t + 1;
+                if (expected > ring.producedCount()) ring.skip(expected - ring.producedCount());
+            } else {
+                while (n < CAPTURE_FIFO_BURST && !fifo.empty()) {
+                    ring.push(sampleFor(fifo.front()));
+                    fifo.pop_front();
+                    n++;
+                }
+            }
+            nextTask = t + ((n < CAPTURE_FIFO_BURST) ? CAPTURE_POLL_MS + rnd() % 3 : 1);
+            if (t >= taskStallAt && t < taskStallAt + CAPTURE_POLL_MS) nextTask = t + taskStallMs;
+        }
+        
+        // loop(): CaptureManager::drain()
+        if (t >= nextLoop) {
+            uint16_t perFrame = CaptureRing::samplesPerFrame(maxNotify);
+            for (int i = 0; i < 4; i++) {
+                uint16_t avail = ring.available();
+                if (avail == 0) break;
+                if (avail < perFrame && t - lastFrame < CAPTURE_LATENCY_MS) break;
+                if (controller.size() >= (size_t)CONTROLLER_BUFFERS) break;
+                size_t len = ring.build(frame, maxNotify);
+                controller.push_back(std::vector<uint8_t>(frame, frame + len));
+                ring.commit();
+                lastFrame = t;
+            }
+            nextLoop = t + 12 + rnd() % 9;
+            if (t >= nextStall) {
+                nextLoop = t + 150;
+                nextStall = t + 1500 + rnd() % 1000;
+            }
+        }
+        
+        // Connection event
+        if (t % CONN_INTERVAL_MS == 0 && (int)(rnd() % 100) >= EVENT_LOSS_PCT) {
+            for (int i = 0; i < PACKETS_PER_EVENT && !controller.empty(); i++) {
+                r.rx.onFrame(controller.front().data(), controller.front().size());
+                controller.pop_front();
+                r.notifications++;
+            }
+        }
+    }
+    
+    r.produced = ring.producedCount();
+    return r;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {}
+void tearDown() {}
+
+void test_frame_layout() {
+    ring.reset();
+    for (uint32_t i = 0; i < 30; i++) ring.push(sampleFor(i));
+    
+    uint8_t buf[BLE_MTU - 3] = {0};
+    size_t len = ring.build(buf, 244);
+    TEST_ASSERT_EQUAL(19, CaptureRing::samplesPerFrame(244));
+    TEST_ASSERT_EQUAL(CAPTURE_IMU_HEADER_LEN + 19 * CAPTURE_SAMPLE_LEN, len);
+    TEST_ASSERT_EQUAL(BLE_FRAME_CAPTURE_IMU, buf[0]);
+    TEST_ASSERT_EQUAL(19, buf[1]);
+    TEST_ASSERT_EQUAL(0, rd32(&buf[2]));
+    TEST_ASSERT_EQUAL(-32768, rd16(&buf[CAPTURE_IMU_HEADER_LEN + 8]));
+    ring.commit();
+    
+    // Not committed: the same frame is built again
+    len = ring.build(buf, 244);
+    TEST_ASSERT_EQUAL(11, buf[1]);
+    len = ring.build(buf, 244);
+    TEST_ASSERT_EQUAL(19, rd32(&buf[2]));
+    TEST_ASSERT_EQUAL(19, rd16(&buf[CAPTURE_IMU_HEADER_LEN]));
+    ring.commit();
+    TEST_ASSERT_EQUAL(0, ring.available());
+    
+    CaptureInfo info = {1000, 8192, 655, 123456789, true};
+    TEST_ASSERT_EQUAL(CAPTURE_START_LEN, CaptureRing::encodeStart(buf, info));
+    TEST_ASSERT_EQUAL(1000, rd16(&buf[2]));
+    TEST_ASSERT_EQUAL(123456789, rd32(&buf[8]));
+    TEST_ASSERT_EQUAL(1, buf[12]);
+}
+
+void test_frames_stop_at_gaps() {
+    Receiver rx;
+    ring.reset();
+    for (uint32_t i = 0; i < 5; i++) ring.push(sampleFor(i));
+    ring.skip(3);                                          // FIFO overflow
+    for (uint32_t i = 8; i < 13; i++) ring.push(sampleFor(i));
+    
+    uint8_t buf[BLE_MTU - 3] = {0};
+    size_t len = ring.build(buf, 244);
+    TEST_ASSERT_EQUAL(5, buf[1]);
+    rx.onFrame(buf, len);
+    ring.commit();
+    len = ring.build(buf, 244);
+    TEST_ASSERT_EQUAL(8, rd32(&buf[2]));
+    rx.onFrame(buf, len);
+    ring.commit();
+    
+    TEST_ASSERT_EQUAL(1, rx.gaps);
+    TEST_ASSERT_EQUAL(3, rx.missing);
+    TEST_ASSERT_EQUAL(0, rx.misplaced);
+    TEST_ASSERT_EQUAL(3, ring.getLostOverflow());
+    
+    len = ring.encodeStop(buf, CAPTURE_STOP_REQUESTED);
+    TEST_ASSERT_EQUAL(13, rd32(&buf[2]));
+    TEST_ASSERT_EQUAL(3, rd32(&buf[6]));
+}
+
+// A full ring still spends the index: the receiver sees the loss
+void test_full_ring_is_a_gap() {
+    Receiver rx;
+    ring.reset();
+    for (uint32_t i = 0; i < CAPTURE_QUEUE - 1; i++) TEST_ASSERT_TRUE(ring.push(sampleFor(i)));
+    TEST_ASSERT_FALSE(ring.push(sampleFor(CAPTURE_QUEUE - 1)));
+    TEST_ASSERT_EQUAL(1, ring.getLostFull());
+    
+    uint8_t buf[BLE_MTU - 3] = {0};
+    while (ring.available()) {
+        rx.onFrame(buf, ring.build(buf, 244));
+        ring.commit();
+    }
+    ring.push(sampleFor(CAPTURE_QUEUE));
+    rx.onFrame(buf, ring.build(buf, 244));
+    ring.commit();
+    
+    TEST_ASSERT_EQUAL(1, rx.gaps);
+    TEST_ASSERT_EQUAL(1, rx.missing);
+    TEST_ASSERT_EQUAL(0, rx.misplaced);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIMULATION TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_full_odr_without_loss() {
+    size_t payloads[] = {244, 182};   // MTU 247 (Android), 185 (iOS)
+    for (size_t p : payloads) {
+        SimResult r = simulate(p, SIM_MS, 0);
+        printf("[SIM] Capture %u Hz, %u-byte notifications: %lu samples, %lu received in "
+               "%lu notifications, %lu lost, queue peak %u of %u\n",
+               ODR_HZ, (unsigned)p, (unsigned long)r.produced, (unsigned long)r.rx.samples,
+               (unsigned long)r.notifications, (unsigned long)ring.getLost(),
+               ring.getHighWater(), CAPTURE_QUEUE);
+        
+        TEST_ASSERT_EQUAL(0, ring.getLost());
+        TEST_ASSERT_EQUAL(0, r.rx.gaps);
+        TEST_ASSERT_EQUAL(0, r.rx.misplaced);
+        TEST_ASSERT_TRUE(r.produced >= SIM_MS - CAPTURE_POLL_MS - 3);
+        TEST_ASSERT_TRUE(r.rx.samples + CAPTURE_QUEUE / 2 >= r.produced);   // Rest is in flight
+        TEST_ASSERT_TRUE(ring.getHighWater() < CAPTURE_QUEUE / 2);
+    }
+}
+
+void test_fifo_overflow_is_reported_exactly() {
+    SimResult r = simulate(244, 20000, 200);   // Task starved for 200 ms
+    printf("[SIM] Task stall 200 ms: %lu lost to FIFO overflow, receiver saw %lu gap(s) "
+           "of %lu samples, %lu misplaced\n",
+           (unsigned long)ring.getLostOverflow(), (unsigned long)r.rx.gaps,
+           (unsigned long)r.rx.missing, (unsigned long)r.rx.misplaced);
+    
+    TEST_ASSERT_EQUAL(1, r.rx.gaps);
+    TEST_ASSERT_EQUAL(ring.getLost(), r.rx.missing);
+    TEST_ASSERT_TRUE(r.rx.missing >= 200 - FIFO_SAMPLES);
+    TEST_ASSERT_EQUAL(0, r.rx.misplaced);   // Samples after the gap keep their time
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_layout);
+    RUN_TEST(test_frames_stop_at_gaps);
+    RUN_TEST(test_full_ring_is_a_gap);
+    RUN_TEST(test_full_odr_without_loss);
+    RUN_TEST(test_fifo_overflow_is_reported_exactly);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    CONFIRMED UPLINK - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * ACK / retry tracking for alerts (src/lora/confirmed_uplink.h):
+ * - The ACK window opens at TX done: time queued or in LBT backoff is
+ *   never taken out of ALERT_ACK_WINDOW_MS
+ * - ACK in time: delivered, latency and attempt counted, no retry
+ * - No ACK: retries with doubling backoff (+-25%, capped)
+ * - ALERT_MAX_ATTEMPTS transmissions without ACK: give up once
+ * - A frame the scheduler never sent counts as an attempt
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "lora/confirmed_uplink.h"
+
+static const uint8_t FRAME[] = {FRAME_TELEMETRY, 0x07, 0x00, 0x2A, 0x00, 0x11, 0x22};
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// ACK FRAME
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_ack_frame_round_trip() {
+    uint8_t ack[ACK_FRAME_LEN];
+    TEST_ASSERT_EQUAL(ACK_FRAME_LEN, ConfirmedUplink::buildAck(ack, 0x1234, 0xBEEF));
+    uint16_t dev, seq;
+    TEST_ASSERT_TRUE(ConfirmedUplink::parseAck(ack, sizeof(ack), dev, seq));
+    TEST_ASSERT_EQUAL(0x1234, dev);
+    TEST_ASSERT_EQUAL(0xBEEF, seq);
+    TEST_ASSERT_FALSE(ConfirmedUplink::parseAck(ack, ACK_FRAME_LEN - 1, dev, seq));
+    ack[0] = FRAME_TELEMETRY;
+    TEST_ASSERT_FALSE(ConfirmedUplink::parseAck(ack, sizeof(ack), dev, seq));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TRACK & ACK
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_window_opens_at_tx_done() {
+    ConfirmedUplink cu;
+    ConfirmedUplink::Action action;
+    cu.track(FRAME, sizeof(FRAME), 42, 1000);
+    TEST_ASSERT_TRUE(cu.isTracked(42));
+    
+    // Queued behind other frames and backing off in LBT for 8 s
+    TEST_ASSERT_FALSE(cu.poll(9000, action));
+    cu.onTransmit(42, 9000);
+    
+    // The full window still runs from TX done
+    TEST_ASSERT_FALSE(cu.poll(9000 + ALERT_ACK_WINDOW_MS - 1, action));
+    TEST_ASSERT_TRUE(cu.onAck(42, 9000 + ALERT_ACK_WINDOW_MS - 1));
+    TEST_ASSERT_FALSE(cu.isTracked(42));
+    TEST_ASSERT_FALSE(cu.onAck(42, 9000 + ALERT_ACK_WINDOW_MS));   // Duplicate ACK
+    TEST_ASSERT_FALSE(cu.poll(100000, action));
+    
+    const ConfirmStats& s = cu.getStats();
+    TEST_ASSERT_EQUAL(1, s.tracked);
+    TEST_ASSERT_EQUAL(1, s.delivered);
+    TEST_ASSERT_EQUAL(0, s.retries);
+    TEST_ASSERT_EQUAL(1, s.attempts_hist[0]);
+    TEST_ASSERT_EQUAL(8000 + ALERT_ACK_WINDOW_MS - 1, s.averageLatencyMs());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BACKOFF & GIVE UP
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_backoff_then_ack() {
+    ConfirmedUplink cu;
+    ConfirmedUplink::Action action;
+    uint32_t now = 0;
+    cu.track(FRAME, sizeof(FRAME), 7, now);
+    
+    uint32_t base = ALERT_RETRY_BASE_MS;
+    for (int attempt = 1; attempt <= 3; attempt++) {
+        cu.onTransmit(7, now);
+        TEST_ASSERT_FALSE(cu.poll(now + ALERT_ACK_WINDOW_MS - 1, action));
+        now += ALERT_ACK_WINDOW_MS;
+        TEST_ASSERT_TRUE(cu.poll(now, action));
+        TEST_ASSERT_EQUAL(ConfirmedUplink::ACTION_RETRY, action.type);
+        TEST_ASSERT_EQUAL(7, action.seq);
+        TEST_ASSERT_EQUAL(attempt, action.attempt);
+        TEST_ASSERT_EQUAL(sizeof(FRAME), action.length);
+        TEST_ASSERT_EQUAL_MEMORY(FRAME, action.data, sizeof(FRAME));
+        TEST_ASSERT_TRUE(action.delay_ms >= base - base / 4);
+        TEST_ASSERT_TRUE(action.delay_ms <= base + base / 4 && action.delay_ms <= ALERT_RETRY_MAX_MS);
+        base *= 2;
+        
+        // Waiting for its slot again: no second retry meanwhile
+        TEST_ASSERT_FALSE(cu.poll(now + action.delay_ms, action));
+        now += action.delay_ms;
+    }
+    
+    cu.onTransmit(7, now);
+    TEST_ASSERT_TRUE(cu.onAck(7, now + 500));
+    TEST_ASSERT_EQUAL(3, cu.getStats().retries);
+    TEST_ASSERT_EQUAL(1, cu.getStats().attempts_hist[3]);
+    TEST_ASSERT_EQUAL(0, cu.pendingCount());
+}
+
+void test_give_up_and_lost_in_queue() {
+    ConfirmedUplink cu;
+    ConfirmedUplink::Action action;
+    uint32_t now = 0;
+    cu.track(FRAME, sizeof(FRAME), 9, now);
+    
+    int retries = 0;
+    bool gaveUp = false;
+    for (int i = 0; i < 100 && !gaveUp; i++) {
+        cu.onTransmit(9, now);
+        now += ALERT_ACK_WINDOW_MS;
+        TEST_ASSERT_TRUE(cu.poll(now, action));
+        if (action.type == ConfirmedUplink::ACTION_GIVE_UP) gaveUp = true;
+        else retries++;
+        now += action.delay_ms;
+    }
+    TEST_ASSERT_TRUE(gaveUp);
+    TEST_ASSERT_EQUAL(ALERT_MAX_ATTEMPTS, action.attempt);
+    TEST_ASSERT_EQUAL(ALERT_MAX_ATTEMPTS - 1, retries);
+    TEST_ASSERT_EQUAL(1, cu.getStats().failed);
+    TEST_ASSERT_FALSE(cu.isTracked(9));
+    TEST_ASSERT_FALSE(cu.poll(now + 100000, action));
+    
+    // Never made it on air (scheduler dropped it): retried after the cap
+    cu.track(FRAME, sizeof(FRAME), 10, now);
+    TEST_ASSERT_FALSE(cu.poll(now + ALERT_RETRY_MAX_MS - 1, action));
+    TEST_ASSERT_TRUE(cu.poll(now + ALERT_RETRY_MAX_MS, action));
+    TEST_ASSERT_EQUAL(ConfirmedUplink::ACTION_RETRY, action.type);
+    TEST_ASSERT_EQUAL(1, action.attempt);
+}
+
+void test_eviction_when_full() {
+    ConfirmedUplink cu;
+    for (int i = 0; i < ALERT_CONFIRM_SLOTS; i++) cu.track(FRAME, sizeof(FRAME), 100 + i, 1000 + i);
+    TEST_ASSERT_EQUAL(ALERT_CONFIRM_SLOTS, cu.pendingCount());
+    
+    // The oldest alert makes room for the new one
+    cu.track(FRAME, sizeof(FRAME), 200, 5000);
+    TEST_ASSERT_EQUAL(ALERT_CONFIRM_SLOTS, cu.pendingCount());
+    TEST_ASSERT_FALSE(cu.isTracked(100));
+    TEST_ASSERT_TRUE(cu.isTracked(101));
+    TEST_ASSERT_TRUE(cu.isTracked(200));
+    TEST_ASSERT_EQUAL(1, cu.getStats().failed);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ack_frame_round_trip);
+    RUN_TEST(test_window_opens_at_tx_done);
+    RUN_TEST(test_backoff_then_ack);
+    RUN_TEST(test_give_up_and_lost_in_queue);
+    RUN_TEST(test_eviction_when_full);
+    return UNITY_END();
+}
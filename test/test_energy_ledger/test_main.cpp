@@ -0,0 +1,175 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    ENERGY LEDGER - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Charge accounting and battery runtime (src/managers/energy_ledger.h):
+ * - LiPo curve and SX1262 TX current lookups
+ * - Rails add up exactly, even from millions of small loop increments
+ * - LoRa TX charge = airtime x current at the TX power
+ * - State of charge: curve first, coulomb count after, blended readings
+ * - Runtime and degrade levels from the average current, relative to a
+ *   full battery at the expected draw
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "managers/energy_ledger.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// CURVES
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_lipo_and_tx_curves() {
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, lipoPercent(4.25f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, lipoPercent(4.20f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, lipoPercent(3.84f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, lipoPercent(3.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 82.5f, lipoPercent(4.05f));   // Between 4.02 and 4.08
+    
+    // Monotonic over the whole range
+    float last = -1;
+    for (float v = 3.0f; v <= 4.3f; v += 0.005f) {
+        float p = lipoPercent(v);
+        TEST_ASSERT_TRUE(p >= last);
+        last = p;
+    }
+    
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 58.0f, loraTxMa(14));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 118.0f, loraTxMa(22));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 26.0f, loraTxMa(-5));
+    TEST_ASSERT_TRUE(loraTxMa(LORA_ADR_MIN_POWER) < loraTxMa(LORA_TX_POWER));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// CHARGE
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_rails_and_tx() {
+    EnergyLedger ledger;
+    // One hour of loop increments: 10 ms at 6 mA on the board rail
+    for (int i = 0; i < 360000; i++) ledger.charge(RAIL_BOARD, 10000, 6.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 6.0f, ledger.getChargeMah(RAIL_BOARD));
+    TEST_ASSERT_EQUAL(3600000000ULL, ledger.getTimeUs(RAIL_BOARD));
+    
+    // 1000 frames of 50 ms at 14 dBm
+    for (int i = 0; i < 1000; i++) ledger.chargeTx(50000, 14);
+    TEST_ASSERT_EQUAL(1000, ledger.getTxFrames());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 58.0f * 50.0f / 3600.0f, ledger.getChargeMah(RAIL_LORA_TX));
+    
+    ledger.charge(RAIL_DISPLAY, 1000000, 0);   // Display off: time, no charge
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, ledger.getChargeMah(RAIL_DISPLAY));
+    TEST_ASSERT_EQUAL(1000000, ledger.getTimeUs(RAIL_DISPLAY));
+    
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, ledger.getChargeMah(RAIL_BOARD) + ledger.getChargeMah(RAIL_LORA_TX),
+                             ledger.getTotalMah());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BATTERY
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_state_of_charge() {
+    EnergyLedger ledger;
+    TEST_ASSERT_FALSE(ledger.hasBattery());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -1.0f, ledger.getRemainingHours());
+    
+    ledger.onVoltage(3.84f, 0);                   // 50 % from the curve
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, ledger.getSocPercent());
+    
+    // 10 % of the capacity drawn: counted without a new reading
+    ledger.charge(RAIL_CPU, 3600000000UL / 10, BATTERY_CAPACITY_MAH / 10.0f * 10);   // 0.1 h at C
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 40.0f, ledger.getSocPercent());
+    
+    // A reading that disagrees only nudges the count
+    ledger.onVoltage(3.84f, 360000);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 40.0f + ENERGY_SOC_BLEND * 10.0f, ledger.getSocPercent());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, BATTERY_CAPACITY_MAH * 1.0f, ledger.getAverageMa());   // 1 C for 0.1 h
+    
+    // Empty is empty
+    ledger.charge(RAIL_CPU, 3600000000UL, BATTERY_CAPACITY_MAH * 2.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, ledger.getSocPercent());
+}
+
+void test_runtime_and_degrade() {
+    EnergyLedger ledger;
+    ledger.onVoltage(4.20f, 0);
+    TEST_ASSERT_EQUAL(0, ledger.degradeLevel());   // Average unknown yet
+    
+    // 10 mA for 10 minutes between readings
+    ledger.charge(RAIL_BOARD, 600000000UL, 10.0f);
+    ledger.onVoltage(4.20f, 600000);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 10.0f, ledger.getAverageMa());
+    float hours = ledger.getRemainingHours();
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, ledger.getRemainingMah() / 10.0f, hours);
+    TEST_ASSERT_EQUAL(hours < ENERGY_LOW_RUNTIME_FRAC * EnergyLedger::getBaselineHours() ? 1 : 0,
+                      ledger.degradeLevel());
+    
+    // Heavy load: the EMA follows, the runtime drops to critical
+    uint32_t now = 600000;
+    for (int i = 0; i < 30; i++) {
+        ledger.charge(RAIL_LORA_TX, 60000000UL, 200.0f);
+        now += 60000;
+        ledger.onVoltage(3.80f, now);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 200.0f, ledger.getAverageMa());
+    printf("[SIM] 1 h at 200 mA after 10 min at 10 mA: %.0f%%, %.1f h left, level %u\n",
+           ledger.getSocPercent(), ledger.getRemainingHours(), ledger.degradeLevel());
+    TEST_ASSERT_TRUE(ledger.getRemainingHours() < ENERGY_CRITICAL_RUNTIME_FRAC * EnergyLedger::getBaselineHours());
+    TEST_ASSERT_EQUAL(2, ledger.degradeLevel());
+}
+
+void test_full_battery_is_not_degraded() {
+    // Board, IMU and CPU clock-scaled to 40 MHz: ~33 mA, ~30 h on 1000 mAh
+    float cpuMa = POWER_CPU_BASE_MA + POWER_CPU_MA_PER_MHZ * POWER_MIN_MHZ;
+    EnergyLedger ledger;
+    ledger.onVoltage(4.20f, 0);
+    uint32_t now = 0;
+    for (int i = 0; i < 10; i++) {
+        ledger.charge(RAIL_BOARD, 60000000UL, POWER_BOARD_MA);
+        ledger.charge(RAIL_SENSOR, 60000000UL, ENERGY_IMU_MA);
+        ledger.charge(RAIL_CPU, 60000000UL, cpuMa);
+        now += 60000;
+        ledger.onVoltage(4.20f, now);
+    }
+    printf("[SIM] full battery at %.1f mA: %.0f%%, %.1f h left (baseline %.1f h), level %u\n",
+           ledger.getAverageMa(), ledger.getSocPercent(), ledger.getRemainingHours(),
+           EnergyLedger::getBaselineHours(), ledger.degradeLevel());
+    TEST_ASSERT_TRUE(ledger.getSocPercent() > 99.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, ENERGY_BASELINE_MA, ledger.getAverageMa());
+    TEST_ASSERT_TRUE(ledger.getRemainingHours() < 48.0f);   // The old absolute threshold
+    TEST_ASSERT_EQUAL(0, ledger.degradeLevel());
+    
+    // Same draw at a quarter of the charge: low, not yet critical
+    EnergyLedger low;
+    low.onVoltage(3.72f, 0);   // ~17% on the curve
+    now = 0;
+    for (int i = 0; i < 10; i++) {
+        low.charge(RAIL_BOARD, 60000000UL, POWER_BOARD_MA);
+        low.charge(RAIL_SENSOR, 60000000UL, ENERGY_IMU_MA);
+        low.charge(RAIL_CPU, 60000000UL, cpuMa);
+        now += 60000;
+        low.onVoltage(3.72f, now);
+    }
+    TEST_ASSERT_EQUAL(1, low.degradeLevel());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_lipo_and_tx_curves);
+    RUN_TEST(test_rails_and_tx);
+    RUN_TEST(test_state_of_charge);
+    RUN_TEST(test_runtime_and_degrade);
+    RUN_TEST(test_full_battery_is_not_degraded);
+    return UNITY_END();
+}
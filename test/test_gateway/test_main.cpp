@@ -0,0 +1,231 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    GATEWAY SIMULATION - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Replays a packet stream from hundreds of devices through the gateway RX
+ * path (LoRaRxRing → GatewayTable) on a simulated clock:
+ * - frames arrive back to back at SF7 airtime (the fastest the radio can)
+ * - the channel loses, duplicates (relays) and reorders frames
+ * - the forwarder drains a bounded batch per loop pass and the USB host
+ *   periodically stops reading
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+
+#include "lora/rx_ring.h"
+#include "lora/gateway_table.h"
+#include "lora/lora_airtime.h"
+#include "lora/telemetry_frame.h"
+
+static LoRaRxRing ring;
+static GatewayTable table;
+
+static uint32_t rngState = 12345;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+void setUp() {
+    ring = LoRaRxRing();
+    table.clear();
+    rngState = 12345;
+}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SEQUENCE TRACKING
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_sequence_gap_late_duplicate() {
+    uint16_t gap;
+    TEST_ASSERT_EQUAL(INGEST_NEW, table.ingest(7, 100, 0, -90, 5.0f));
+    TEST_ASSERT_EQUAL(INGEST_OK, table.ingest(7, 101, 1, -90, 5.0f));
+    TEST_ASSERT_EQUAL(INGEST_GAP, table.ingest(7, 104, 2, -90, 5.0f, &gap));
+    TEST_ASSERT_EQUAL(2, gap);
+    TEST_ASSERT_EQUAL(INGEST_LATE, table.ingest(7, 102, 3, -90, 5.0f));
+    TEST_ASSERT_EQUAL(INGEST_DUPLICATE, table.ingest(7, 102, 4, -90, 5.0f));
+    TEST_ASSERT_EQUAL(INGEST_DUPLICATE, table.ingest(7, 104, 5, -90, 5.0f));
+    // Further back than the window: the device rebooted
+    TEST_ASSERT_EQUAL(INGEST_RESTART, table.ingest(7, 0, 6, -90, 5.0f));
+    
+    const DeviceStats* d = table.find(7);
+    TEST_ASSERT_NOT_NULL(d);
+    TEST_ASSERT_EQUAL(1, d->lost);
+    TEST_ASSERT_EQUAL(2, d->duplicates);
+    TEST_ASSERT_EQUAL(1, d->restarts);
+}
+
+void test_sequence_wraps_at_16_bits() {
+    table.ingest(3, 65534, 0, -80, 9.0f);
+    TEST_ASSERT_EQUAL(INGEST_OK, table.ingest(3, 65535, 1, -80, 9.0f));
+    TEST_ASSERT_EQUAL(INGEST_OK, table.ingest(3, 0, 2, -80, 9.0f));
+    TEST_ASSERT_EQUAL(0, table.find(3)->lost);
+}
+
+void test_legacy_duplicate_window() {
+    uint8_t pkt[6] = {9, CTX_HELMET, STATUS_FALL, 0x10, 0x00, 80};
+    int32_t dev;
+    TEST_ASSERT_EQUAL(INGEST_NEW, table.ingestPayload(pkt, 6, 1000, -100, 1.0f, &dev));
+    TEST_ASSERT_EQUAL(9, dev);
+    TEST_ASSERT_EQUAL(INGEST_DUPLICATE, table.ingestPayload(pkt, 6, 1500, -100, 1.0f, &dev));
+    // Same reading long after: a new report, not a relay
+    TEST_ASSERT_EQUAL(INGEST_OK, table.ingestPayload(pkt, 6, 1500 + GATEWAY_DUP_WINDOW_MS, -100, 1.0f, &dev));
+}
+
+void test_table_holds_max_devices() {
+    for (uint32_t i = 0; i < GATEWAY_MAX_DEVICES; i++) {
+        TEST_ASSERT_EQUAL(INGEST_NEW, table.ingest((uint16_t)(i * 7 + 1), 0, 0, -90, 0));
+    }
+    TEST_ASSERT_EQUAL(GATEWAY_MAX_DEVICES, table.size());
+    TEST_ASSERT_EQUAL(INGEST_TABLE_FULL, table.ingest(60000, 0, 0, -90, 0));
+    TEST_ASSERT_EQUAL(INGEST_OK, table.ingest(1, 1, 1, -90, 0));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BURST SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+struct SimDevice {
+    uint16_t seq;
+    uint32_t sent;
+    uint32_t lost;
+};
+
+void test_burst_from_hundreds_of_devices() {
+    const int DEVICES = 400;
+    const int FRAMES = 20000;
+    const uint32_t LOOP_US = 2000;           // One gateway loop() pass
+    const int DRAIN_PER_PASS = 8;            // Matches forwardFrames()
+    const uint32_t STALL_EVERY_US = 5000000; // USB host stops reading...
+    const uint32_t STALL_US = 800000;        // ...for this long
+    
+    static SimDevice devs[DEVICES];
+    memset(devs, 0, sizeof(devs));
+    
+    // Shortest frame the firmware sends = worst case arrival rate
+    uint32_t airtimeUs = LoRaAirtime::timeOnAirUs(sizeof(UAD_Packet), LORA_SF, LORA_BW);
+    
+    TelemetryFrameBuilder builder;
+    uint8_t held[LORA_MAX_PAYLOAD];
+    size_t heldLen = 0;
+    
+    uint32_t now = 0;
+    uint32_t nextArrival = 0;
+    uint32_t nextLoop = 0;
+    uint32_t received = 0, forwarded = 0, dupsDropped = 0, injectedDups = 0;
+    int produced = 0;
+    
+    while (produced < FRAMES || ring.count() > 0 || heldLen > 0) {
+        if (produced < FRAMES || heldLen > 0) {
+            if (now >= nextArrival) {
+                const uint8_t* frame;
+                size_t len;
+                uint8_t buf[LORA_MAX_PAYLOAD];
+                bool onAir = true;
+                
+                if (heldLen > 0 && (rnd() % 3 == 0 || produced >= FRAMES)) {
+                    // Reordered / relayed copy arrives late
+                    memcpy(buf, held, heldLen);
+                    len = heldLen;
+                    heldLen = 0;
+                    frame = buf;
+                } else {
+                    int id = rnd() % DEVICES;
+                    SimDevice& d = devs[id];
+                    builder.begin(id + 1, d.seq++, CTX_HELMET, 90, now / 1000, 1000, 51);
+                    builder.addSample(rnd() & 0x3FF);
+                    d.sent++;
+                    produced++;
+                    frame = builder.data();
+                    len = builder.length();
+                    
+                    uint32_t roll = rnd() % 100;
+                    if (roll < 8) {
+                        // Lost on air
+                        d.lost++;
+                        onAir = false;
+                    } else if (roll < 13 && heldLen == 0) {
+                        // Delayed copy: reordered (the gap it opens closes
+                        // as LATE) or, in addition, relayed as a duplicate
+                        memcpy(held, frame, len);
+                        heldLen = len;
+                        if (roll < 10) onAir = false;
+                        else injectedDups++;
+                    }
+                }
+                
+                if (onAir) {
+                    TEST_ASSERT_TRUE(ring.push(frame, len, -90 - (int16_t)(rnd() % 30), 5.0f, now));
+                    received++;
+                }
+                nextArrival = now + airtimeUs;
+            }
+        }
+        
+        if (now >= nextLoop) {
+            bool stalled = (now % STALL_EVERY_US) < STALL_US;
+            // While the host is stalled the output buffer fills after a few
+            // passes and the forwarder stops draining; the ring absorbs it
+            int budget = stalled ? 0 : DRAIN_PER_PASS;
+            for (; budget > 0; budget--) {
+                const RxFrame* f = ring.peek();
+                if (!f) break;
+                int32_t dev;
+                IngestResult r = table.ingestPayload(f->data, f->length, now / 1000,
+                                                     f->rssi, f->snr, &dev);
+                TEST_ASSERT_NOT_EQUAL(INGEST_TABLE_FULL, r);
+                TEST_ASSERT_NOT_EQUAL(INGEST_UNKNOWN, r);
+                if (r == INGEST_DUPLICATE) dupsDropped++;
+                else forwarded++;
+                ring.pop();
+            }
+            nextLoop = now + LOOP_US;
+        }
+        
+        now += 100;
+    }
+    
+    uint32_t expectedLost = 0, tableLost = 0, tableFrames = 0;
+    for (int i = 0; i < DEVICES; i++) expectedLost += devs[i].lost;
+    for (uint16_t i = 0; i < GatewayTable::capacity(); i++) {
+        const DeviceStats& d = table.slot(i);
+        if (!d.used) continue;
+        tableLost += d.lost;
+        tableFrames += d.frames;
+    }
+    
+    printf("[SIM] %d devices, %lu frames on air, airtime %lu us, ring high water %u/%d\n",
+           DEVICES, (unsigned long)received, (unsigned long)airtimeUs,
+           ring.getHighWater(), GATEWAY_RX_RING_LEN);
+    printf("[SIM] forwarded %lu, duplicates dropped %lu, lost %lu\n",
+           (unsigned long)forwarded, (unsigned long)dupsDropped, (unsigned long)tableLost);
+    
+    TEST_ASSERT_EQUAL(0, ring.getOverflows());
+    TEST_ASSERT_EQUAL(DEVICES, table.size());
+    TEST_ASSERT_EQUAL(received, forwarded + dupsDropped);
+    TEST_ASSERT_EQUAL(injectedDups, dupsDropped);
+    TEST_ASSERT_EQUAL(tableFrames, forwarded);
+    // Losses at the tail of each device's stream have no later frame to
+    // reveal them, so the gateway can only undercount
+    TEST_ASSERT_TRUE(tableLost <= expectedLost);
+    TEST_ASSERT_TRUE(tableLost >= expectedLost * 9 / 10);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sequence_gap_late_duplicate);
+    RUN_TEST(test_sequence_wraps_at_16_bits);
+    RUN_TEST(test_legacy_duplicate_window);
+    RUN_TEST(test_table_holds_max_devices);
+    RUN_TEST(test_burst_from_hundreds_of_devices);
+    return UNITY_END();
+}
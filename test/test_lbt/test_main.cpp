@@ -0,0 +1,257 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LBT COLLISION MODEL - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * One dense site: 60 devices, SF7, 30-byte frames, every device on a naive
+ * 5 s timer (random phase, +-1% clock error) for 10 simulated minutes
+ * - Gateway hears everyone; overlapping frames on one channel are lost
+ * - 10% of device pairs cannot hear each other (hidden terminals)
+ * - CAD: 2 ms scan + 1 ms RX->TX turnaround (vulnerable window), a frame
+ *   already on air is detected with 95% probability
+ * - A device holds one frame; a new report overwrites an unsent one
+ * 
+ * Compares goodput (frames received / frames generated) for unslotted
+ * ALOHA, CAD + backoff, and CAD + backoff + 3-channel hopping
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lora/listen_before_talk.h"
+#include "lora/lora_airtime.h"
+
+static const int NODES = 60;
+static const uint32_t PERIOD_MS = 5000;
+static const uint32_t SIM_MS = 10 * 60000;
+static const int PAYLOAD_LEN = 30;
+static const uint32_t CAD_MS = 2;
+static const uint32_t TURNAROUND_MS = 1;
+static const uint32_t CAD_DETECT_PCT = 95;
+static const uint32_t HIDDEN_PCT = 10;
+
+enum SimMode { MODE_ALOHA, MODE_LBT, MODE_LBT_HOPPING };
+enum NodePhase { PHASE_IDLE, PHASE_WAIT, PHASE_CAD, PHASE_TURNAROUND, PHASE_TX };
+
+struct SimNode {
+    ListenBeforeTalk lbt;
+    NodePhase phase;
+    uint32_t period;
+    uint32_t nextReport;
+    uint32_t phaseEnd;
+    int channel;
+    bool pending;
+    bool corrupt;            // Overlapped another frame on its channel
+};
+
+struct SimResult {
+    uint32_t generated;
+    uint32_t delivered;
+    uint32_t overwritten;
+    uint32_t collisions;
+    float goodput() const { return generated ? (float)delivered / generated : 0; }
+};
+
+static SimNode nodes[NODES];
+static bool hidden[NODES][NODES];
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int channelIndex(float freq) {
+    static const float channels[LORA_CHANNEL_COUNT] = LORA_CHANNELS;
+    for (int c = 0; c < LORA_CHANNEL_COUNT; c++) {
+        if (channels[c] == freq) return c;
+    }
+    return 0;
+}
+
+// Someone that node i can hear is on air on its channel
+static bool channelBusyFor(int i) {
+    for (int j = 0; j < NODES; j++) {
+        if (j == i || nodes[j].phase != PHASE_TX) continue;
+        if (nodes[j].channel != nodes[i].channel || hidden[i][j]) continue;
+        if (rnd() % 100 < CAD_DETECT_PCT) return true;
+    }
+    return false;
+}
+
+static void startTx(int i, uint32_t now, uint32_t air, SimResult& res) {
+    SimNode& n = nodes[i];
+    n.phase = PHASE_TX;
+    n.phaseEnd = now + air;
+    n.corrupt = false;
+    
+    // Every overlap on the same channel kills both frames at the gateway
+    for (int j = 0; j < NODES; j++) {
+        if (j == i || nodes[j].phase != PHASE_TX || nodes[j].channel != n.channel) continue;
+        if (!nodes[j].corrupt) res.collisions++;
+        nodes[j].corrupt = true;
+        n.corrupt = true;
+    }
+}
+
+static SimResult simulate(SimMode mode) {
+    SimResult res;
+    memset(&res, 0, sizeof(res));
+    rngState = 0xC0FFEE11;
+    uint32_t air = LoRaAirtime::timeOnAirMs(PAYLOAD_LEN, 7, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+    
+    for (int i = 0; i < NODES; i++) {
+        for (int j = 0; j < i; j++) {
+            hidden[i][j] = hidden[j][i] = (rnd() % 100) < HIDDEN_PCT;
+        }
+        hidden[i][i] = false;
+        
+        SimNode& n = nodes[i];
+        n.lbt = ListenBeforeTalk();
+        n.lbt.seed(rnd());
+        n.lbt.setHopping(mode == MODE_LBT_HOPPING);
+        n.phase = PHASE_IDLE;
+        n.period = PERIOD_MS - PERIOD_MS / 100 + rnd() % (PERIOD_MS / 50 + 1);
+        n.nextReport = rnd() % PERIOD_MS;
+        n.pending = false;
+        n.channel = 0;
+    }
+    
+    for (uint32_t now = 0; now < SIM_MS; now++) {
+        for (int i = 0; i < NODES; i++) {
+            SimNode& n = nodes[i];
+            
+            if (n.phase == PHASE_TX && now >= n.phaseEnd) {
+                if (!n.corrupt) res.delivered++;
+                n.phase = PHASE_IDLE;
+                n.pending = false;
+            }
+            
+            if (now >= n.nextReport) {
+                n.nextReport += n.period;
+                res.generated++;
+                if (n.pending && n.phase != PHASE_TX) res.overwritten++;
+                
+                if (n.phase != PHASE_TX) {
+                    n.pending = true;
+                    n.channel = channelIndex(n.lbt.nextChannel());
+                    if (mode == MODE_ALOHA) {
+                        startTx(i, now, air, res);
+                    } else {
+                        n.phase = PHASE_WAIT;
+                        n.phaseEnd = now + n.lbt.initialDelayMs();
+                    }
+                }
+            }
+            
+            if (n.phase == PHASE_WAIT && now >= n.phaseEnd) {
+                n.phase = PHASE_CAD;
+                n.phaseEnd = now + CAD_MS;
+            } else if (n.phase == PHASE_CAD && now >= n.phaseEnd) {
+                uint32_t wait_ms;
+                if (n.lbt.onCadResult(channelBusyFor(i), wait_ms) == ListenBeforeTalk::LBT_TRANSMIT) {
+                    n.phase = PHASE_TURNAROUND;
+                    n.phaseEnd = now + TURNAROUND_MS;
+                } else {
+                    n.phase = PHASE_WAIT;
+                    n.phaseEnd = now + wait_ms;
+                }
+            } else if (n.phase == PHASE_TURNAROUND && now >= n.phaseEnd) {
+                startTx(i, now, air, res);
+            }
+        }
+    }
+    return res;
+}
+
+static void report(const char* name, const SimResult& r) {
+    printf("[SIM] %-12s goodput %4lu/%4lu (%5.1f%%), collisions %4lu, overwritten %lu\n",
+           name, (unsigned long)r.delivered, (unsigned long)r.generated, r.goodput() * 100,
+           (unsigned long)r.collisions, (unsigned long)r.overwritten);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {}
+void tearDown() {}
+
+void test_free_channel_transmits_at_once() {
+    ListenBeforeTalk lbt;
+    uint32_t wait_ms = 123;
+    TEST_ASSERT_TRUE(lbt.initialDelayMs() <= LORA_LBT_BACKOFF_MS / 4);
+    TEST_ASSERT_EQUAL(ListenBeforeTalk::LBT_TRANSMIT, lbt.onCadResult(false, wait_ms));
+    TEST_ASSERT_EQUAL(0, wait_ms);
+    TEST_ASSERT_EQUAL(1, lbt.getCadRuns());
+    TEST_ASSERT_EQUAL(0, lbt.getCadBusy());
+}
+
+void test_busy_channel_backs_off_then_forces() {
+    ListenBeforeTalk lbt;
+    lbt.seed(7);
+    lbt.initialDelayMs();
+    
+    uint32_t wait_ms;
+    for (int i = 0; i < LORA_LBT_MAX_TRIES - 1; i++) {
+        TEST_ASSERT_EQUAL(ListenBeforeTalk::LBT_BACKOFF, lbt.onCadResult(true, wait_ms));
+        int exp = (i < 4) ? i : 4;
+        TEST_ASSERT_TRUE(wait_ms >= 1);
+        TEST_ASSERT_TRUE(wait_ms <= ((uint32_t)LORA_LBT_BACKOFF_MS << exp));
+    }
+    
+    // Never starve: the last try goes out regardless
+    TEST_ASSERT_EQUAL(ListenBeforeTalk::LBT_TRANSMIT, lbt.onCadResult(true, wait_ms));
+    TEST_ASSERT_EQUAL(1, lbt.getForced());
+    TEST_ASSERT_EQUAL(LORA_LBT_MAX_TRIES, lbt.getCadBusy());
+}
+
+void test_hopping_never_repeats_a_channel() {
+    ListenBeforeTalk lbt;
+    TEST_ASSERT_TRUE(lbt.nextChannel() == (float)LORA_FREQ);
+    
+    lbt.setHopping(true);
+    int used[LORA_CHANNEL_COUNT] = {0};
+    int last = -1;
+    for (int i = 0; i < 300; i++) {
+        int ch = channelIndex(lbt.nextChannel());
+        TEST_ASSERT_NOT_EQUAL(last, ch);
+        used[ch]++;
+        last = ch;
+    }
+    for (int c = 0; c < LORA_CHANNEL_COUNT; c++) TEST_ASSERT_TRUE(used[c] > 50);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_lbt_raises_goodput_in_a_dense_site() {
+    SimResult aloha = simulate(MODE_ALOHA);
+    SimResult lbt = simulate(MODE_LBT);
+    SimResult hop = simulate(MODE_LBT_HOPPING);
+    
+    report("ALOHA", aloha);
+    report("CAD+backoff", lbt);
+    report("CAD+hopping", hop);
+    
+    // Hidden terminals cap what CAD alone can do at this load; spreading the
+    // same traffic over three channels takes most of the rest
+    TEST_ASSERT_TRUE(lbt.goodput() > 2 * aloha.goodput());
+    TEST_ASSERT_TRUE(hop.goodput() > lbt.goodput() + 0.3f);
+    TEST_ASSERT_TRUE(hop.goodput() > 0.8f);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_free_channel_transmits_at_once);
+    RUN_TEST(test_busy_channel_backs_off_then_forces);
+    RUN_TEST(test_hopping_never_repeats_a_channel);
+    RUN_TEST(test_lbt_raises_goodput_in_a_dense_site);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA ADR - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * TX power state machine (src/lora/lora_adr.h):
+ * - Surplus margin backs the power off in 3 dB steps, never below
+ *   LORA_ADR_MIN_POWER, and only after a few link reports
+ * - LORA_ADR_LOSS_LIMIT consecutive losses go back to full power
+ * - The spreading factor never leaves LORA_SF, whatever the losses, so
+ *   ACKs and beacons stay audible and the link can recover
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+
+#include "config.h"
+#include "lora/lora_adr.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// SNR that leaves `margin` dB above the floor at LORA_SF and full power
+static float snrFor(float margin) {
+    return LoRaADR::requiredSnr(LORA_SF) + LORA_ADR_MARGIN_DB + margin;
+}
+
+static void report(LoRaADR& adr, float snr, int n) {
+    for (int i = 0; i < n; i++) adr.onLinkReport(-90, snr);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// MARGIN
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_backs_off_on_margin() {
+    LoRaADR adr;
+    TEST_ASSERT_EQUAL(LORA_SF, adr.getSpreadingFactor());
+    TEST_ASSERT_EQUAL(LORA_TX_POWER, adr.getTxPower());
+    
+    // Too few samples: nothing traded yet
+    report(adr, snrFor(7.0f), 3);
+    TEST_ASSERT_FALSE(adr.takeChange());
+    
+    // 7 dB surplus: two 3 dB steps
+    report(adr, snrFor(7.0f), 1);
+    TEST_ASSERT_TRUE(adr.takeChange());
+    TEST_ASSERT_FALSE(adr.takeChange());   // Once per change
+    TEST_ASSERT_EQUAL(LORA_TX_POWER - 6, adr.getTxPower());
+    TEST_ASSERT_EQUAL(LORA_SF, adr.getSpreadingFactor());
+    
+    // A huge surplus stops at the floor, the SF stays
+    LoRaADR strong;
+    report(strong, snrFor(40.0f), 8);
+    TEST_ASSERT_TRUE(strong.getTxPower() >= LORA_ADR_MIN_POWER);
+    TEST_ASSERT_TRUE(strong.getTxPower() < LORA_ADR_MIN_POWER + 3);
+    TEST_ASSERT_EQUAL(LORA_SF, strong.getSpreadingFactor());
+    
+    // Margin gone: power comes back
+    report(strong, snrFor(-20.0f), 8);
+    TEST_ASSERT_EQUAL(LORA_TX_POWER, strong.getTxPower());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// LOSSES
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_loss_escalation_and_recovery() {
+    LoRaADR adr;
+    report(adr, snrFor(7.0f), 8);
+    adr.takeChange();
+    int8_t backedOff = adr.getTxPower();
+    TEST_ASSERT_TRUE(backedOff < LORA_TX_POWER);
+    
+    // A delivery in between resets the count
+    for (int i = 0; i < LORA_ADR_LOSS_LIMIT - 1; i++) adr.onUplinkResult(false);
+    adr.onUplinkResult(true);
+    for (int i = 0; i < LORA_ADR_LOSS_LIMIT - 1; i++) adr.onUplinkResult(false);
+    TEST_ASSERT_FALSE(adr.takeChange());
+    TEST_ASSERT_EQUAL(backedOff, adr.getTxPower());
+    
+    // LORA_ADR_LOSS_LIMIT in a row: full power
+    adr.onUplinkResult(false);
+    TEST_ASSERT_TRUE(adr.takeChange());
+    TEST_ASSERT_EQUAL(LORA_TX_POWER, adr.getTxPower());
+    
+    // Gateway out of reach for a long time: nothing left to change, and
+    // the node stays on the SF everyone listens on
+    for (int i = 0; i < 100; i++) adr.onUplinkResult(false);
+    TEST_ASSERT_FALSE(adr.takeChange());
+    TEST_ASSERT_EQUAL(LORA_TX_POWER, adr.getTxPower());
+    TEST_ASSERT_EQUAL(LORA_SF, adr.getSpreadingFactor());
+    
+    // Link back: old SNR history was dropped, fresh reports back off again
+    report(adr, snrFor(7.0f), 3);
+    TEST_ASSERT_FALSE(adr.takeChange());
+    report(adr, snrFor(7.0f), 1);
+    TEST_ASSERT_TRUE(adr.takeChange());
+    TEST_ASSERT_EQUAL(backedOff, adr.getTxPower());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_backs_off_on_margin);
+    RUN_TEST(test_loss_escalation_and_recovery);
+    return UNITY_END();
+}
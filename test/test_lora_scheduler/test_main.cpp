@@ -0,0 +1,258 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    LORA SCHEDULER - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * AirtimeLedger and LoRaScheduler (src/lora/lora_scheduler.h):
+ * - EU868 ledger: per sub-band budgets, rolling one-hour window, bucket
+ *   reuse, sub-bands charged independently
+ * - Priority: alerts before status before routine, routine frames wait
+ *   for their jitter, a full queue evicts the oldest less-urgent frame
+ * - Coalescing: a newer routine frame replaces the one with its key
+ * - Alert reserve: routine traffic stops at 1 - LORA_DC_ALERT_RESERVE of
+ *   the budget, alerts may use all of it
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <string.h>
+
+#include "config.h"
+#include "lora/lora_scheduler.h"
+
+static const float G1_MHZ = 868.1f;    // 1% sub-band (LORA_FREQ)
+static const uint32_t T0 = 10 * AirtimeLedger::WINDOW_MS;   // Well past the zeroed buckets
+
+static uint8_t payload[LORA_MAX_PAYLOAD];
+
+static uint32_t airtimeMs(size_t len) {
+    return LoRaAirtime::timeOnAirMs(len, LORA_SF, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+}
+
+static bool submitTagged(LoRaScheduler& s, uint8_t tag, LoRaPriority prio, uint32_t now,
+                         uint8_t key = 0) {
+    memset(payload, tag, 20);
+    return s.submit(payload, 20, prio, now, key);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// DUTY-CYCLE LEDGER
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_ledger_budgets_per_sub_band() {
+    AirtimeLedger l;
+    TEST_ASSERT_EQUAL(2, l.subBandFor(G1_MHZ));
+    TEST_ASSERT_EQUAL(36000, l.budgetMs(G1_MHZ));        // 1% of an hour
+    TEST_ASSERT_EQUAL(3600, l.budgetMs(863.5f));         // 0.1%
+    TEST_ASSERT_EQUAL(3600, l.budgetMs(868.9f));         // 0.1% (g2)
+    TEST_ASSERT_EQUAL(360000, l.budgetMs(869.525f));     // 10% (g3)
+    
+    // Gaps between sub-bands and outside EU868: nothing is legal
+    TEST_ASSERT_EQUAL(-1, l.subBandFor(868.65f));
+    TEST_ASSERT_EQUAL(-1, l.subBandFor(915.0f));
+    TEST_ASSERT_EQUAL(0, l.budgetMs(915.0f));
+    TEST_ASSERT_FALSE(l.canTransmit(915.0f, 1, T0));
+    l.charge(915.0f, 100, T0);
+    TEST_ASSERT_EQUAL(0, l.usedMs(915.0f, T0));
+}
+
+void test_ledger_rolling_window() {
+    AirtimeLedger l;
+    l.charge(G1_MHZ, 1000, T0);
+    l.charge(G1_MHZ, 500, T0 + 30 * AirtimeLedger::BUCKET_MS);
+    TEST_ASSERT_EQUAL(1500, l.usedMs(G1_MHZ, T0 + 30 * AirtimeLedger::BUCKET_MS));
+    
+    // The first minute leaves the window an hour later, the second stays
+    TEST_ASSERT_EQUAL(1500, l.usedMs(G1_MHZ, T0 + AirtimeLedger::WINDOW_MS - 1));
+    TEST_ASSERT_EQUAL(500, l.usedMs(G1_MHZ, T0 + AirtimeLedger::WINDOW_MS));
+    TEST_ASSERT_EQUAL(0, l.usedMs(G1_MHZ, T0 + AirtimeLedger::WINDOW_MS + 30 * AirtimeLedger::BUCKET_MS));
+    
+    // A bucket reused an hour later starts from zero
+    l.charge(G1_MHZ, 200, T0 + AirtimeLedger::WINDOW_MS);
+    TEST_ASSERT_EQUAL(700, l.usedMs(G1_MHZ, T0 + AirtimeLedger::WINDOW_MS));
+}
+
+void test_ledger_limit_and_sub_bands() {
+    AirtimeLedger l;
+    l.charge(G1_MHZ, 35900, T0);
+    TEST_ASSERT_TRUE(l.canTransmit(G1_MHZ, 100, T0));    // Exactly the budget
+    TEST_ASSERT_FALSE(l.canTransmit(G1_MHZ, 101, T0));
+    TEST_ASSERT_FALSE(l.canTransmit(G1_MHZ, 100, T0, 0.5f));
+    
+    // Another sub-band and another channel of the same sub-band
+    TEST_ASSERT_EQUAL(0, l.usedMs(869.525f, T0));
+    TEST_ASSERT_TRUE(l.canTransmit(869.525f, 10000, T0));
+    TEST_ASSERT_EQUAL(35900, l.usedMs(868.5f, T0));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// PRIORITY
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_priority_order() {
+    LoRaScheduler s;
+    TEST_ASSERT_TRUE(submitTagged(s, 'r', LORA_PRIO_ROUTINE, T0));
+    TEST_ASSERT_TRUE(submitTagged(s, 's', LORA_PRIO_STATUS, T0));
+    TEST_ASSERT_TRUE(submitTagged(s, 'a', LORA_PRIO_ALERT, T0));
+    TEST_ASSERT_TRUE(s.hasPendingAlert());
+    TEST_ASSERT_TRUE(s.hasDueAlert(T0));
+    
+    LoRaScheduler::Frame f;
+    TEST_ASSERT_TRUE(s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('a', f.data[0]);
+    TEST_ASSERT_EQUAL(LORA_PRIO_ALERT, f.priority);
+    TEST_ASSERT_TRUE(s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('s', f.data[0]);
+    TEST_ASSERT_TRUE(s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('r', f.data[0]);
+    TEST_ASSERT_FALSE(s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f));
+    TEST_ASSERT_EQUAL(3 * airtimeMs(20), s.getLedger().usedMs(G1_MHZ, T0 + LORA_TX_JITTER_MS));
+}
+
+void test_routine_waits_for_jitter() {
+    LoRaScheduler s;
+    s.seed(12345);
+    LoRaScheduler::Frame f;
+    
+    // Routine frames are not due at once (unless the jitter came out 0),
+    // alerts are; an explicit delay replaces the jitter
+    int heldBack = 0;
+    for (int i = 0; i < 8; i++) {
+        submitTagged(s, 'r', LORA_PRIO_ROUTINE, T0);
+        if (!s.pop(T0, G1_MHZ, f)) heldBack++;
+        TEST_ASSERT_TRUE(s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f) || s.pendingCount() == 0);
+    }
+    TEST_ASSERT_TRUE(heldBack >= 6);
+    
+    memset(payload, 'd', 20);
+    s.submit(payload, 20, LORA_PRIO_ALERT, T0, 0, 500);
+    TEST_ASSERT_FALSE(s.hasDueAlert(T0 + 499));
+    TEST_ASSERT_FALSE(s.pop(T0 + 499, G1_MHZ, f));
+    TEST_ASSERT_TRUE(s.pop(T0 + 500, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('d', f.data[0]);
+}
+
+void test_full_queue_evicts_less_urgent() {
+    LoRaScheduler s;
+    for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) {
+        TEST_ASSERT_TRUE(submitTagged(s, 'a' + i, LORA_PRIO_ROUTINE, T0 + i));
+    }
+    
+    // An alert takes the oldest routine slot
+    TEST_ASSERT_TRUE(submitTagged(s, 'X', LORA_PRIO_ALERT, T0 + 100));
+    TEST_ASSERT_EQUAL(LORA_SCHED_QUEUE_LEN, s.pendingCount());
+    TEST_ASSERT_EQUAL(1, s.getDropped());
+    
+    LoRaScheduler::Frame f;
+    TEST_ASSERT_TRUE(s.pop(T0 + 100, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('X', f.data[0]);
+    bool sawOldest = false;
+    while (s.pop(T0 + 100 + LORA_TX_JITTER_MS, G1_MHZ, f)) sawOldest |= (f.data[0] == 'a');
+    TEST_ASSERT_FALSE(sawOldest);
+    
+    // A queue of alerts has nothing to give a routine frame
+    for (int i = 0; i < LORA_SCHED_QUEUE_LEN; i++) submitTagged(s, 'A', LORA_PRIO_ALERT, T0 + 200);
+    TEST_ASSERT_FALSE(submitTagged(s, 'r', LORA_PRIO_ROUTINE, T0 + 200));
+    TEST_ASSERT_EQUAL(2, s.getDropped());
+}
+
+void test_stale_routine_expires() {
+    LoRaScheduler s;
+    submitTagged(s, 'r', LORA_PRIO_ROUTINE, T0);
+    submitTagged(s, 's', LORA_PRIO_STATUS, T0);
+    
+    LoRaScheduler::Frame f;
+    uint32_t late = T0 + LORA_ROUTINE_MAX_AGE_MS + 1;
+    TEST_ASSERT_TRUE(s.pop(late, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('s', f.data[0]);
+    TEST_ASSERT_FALSE(s.pop(late, G1_MHZ, f));
+    TEST_ASSERT_EQUAL(1, s.getDropped());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// COALESCING
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_coalescing_keeps_newest_data() {
+    LoRaScheduler s;
+    submitTagged(s, '1', LORA_PRIO_ROUTINE, T0, 5);
+    submitTagged(s, '2', LORA_PRIO_ROUTINE, T0 + 10, 5);
+    memset(payload, '3', sizeof(payload));
+    s.submit(payload, 12, LORA_PRIO_ROUTINE, T0 + 20, 5);
+    TEST_ASSERT_EQUAL(1, s.pendingCount());
+    TEST_ASSERT_EQUAL(2, s.getCoalesced());
+    
+    // Key 0 and other priorities never coalesce
+    submitTagged(s, 'x', LORA_PRIO_ROUTINE, T0, 0);
+    submitTagged(s, 'y', LORA_PRIO_ROUTINE, T0, 0);
+    submitTagged(s, 'z', LORA_PRIO_STATUS, T0, 5);
+    TEST_ASSERT_EQUAL(4, s.pendingCount());
+    TEST_ASSERT_EQUAL(2, s.getCoalesced());
+    
+    LoRaScheduler::Frame f;
+    bool sawNewest = false;
+    while (s.pop(T0 + LORA_TX_JITTER_MS, G1_MHZ, f)) {
+        if (f.key == 5 && f.priority == LORA_PRIO_ROUTINE) {
+            sawNewest = true;
+            TEST_ASSERT_EQUAL(12, f.length);
+            TEST_ASSERT_EQUAL('3', f.data[0]);
+            TEST_ASSERT_EQUAL(T0 + 20, f.enqueued_ms);
+        }
+    }
+    TEST_ASSERT_TRUE(sawNewest);
+    TEST_ASSERT_EQUAL(0, s.pendingCount());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// ALERT RESERVE
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_alert_reserve() {
+    LoRaScheduler s;
+    AirtimeLedger& l = s.getLedger();
+    uint32_t budget = l.budgetMs(G1_MHZ);
+    uint32_t routineLimit = (uint32_t)(budget * (1.0f - LORA_DC_ALERT_RESERVE));
+    l.charge(G1_MHZ, routineLimit - airtimeMs(20) + 1, T0);   // One routine frame too many
+    
+    LoRaScheduler::Frame f;
+    submitTagged(s, 'r', LORA_PRIO_ROUTINE, T0);
+    uint32_t now = T0 + LORA_TX_JITTER_MS;
+    TEST_ASSERT_FALSE(s.pop(now, G1_MHZ, f));
+    TEST_ASSERT_EQUAL(1, s.getDeferred());
+    TEST_ASSERT_EQUAL(1, s.pendingCount());                    // Held, not dropped
+    
+    // The reserve is there for alerts
+    submitTagged(s, 'a', LORA_PRIO_ALERT, now);
+    TEST_ASSERT_TRUE(s.pop(now, G1_MHZ, f));
+    TEST_ASSERT_EQUAL('a', f.data[0]);
+    
+    // The held routine frame is retried later, not on the next pass
+    TEST_ASSERT_FALSE(s.pop(now + 1, G1_MHZ, f));
+    TEST_ASSERT_EQUAL(1, s.getDeferred());
+    
+    // Nothing goes past the legal budget, alerts included
+    l.charge(G1_MHZ, budget - l.usedMs(G1_MHZ, now), now);
+    submitTagged(s, 'b', LORA_PRIO_ALERT, now);
+    TEST_ASSERT_FALSE(s.pop(now, G1_MHZ, f));
+    TEST_ASSERT_EQUAL(2, s.getDeferred());
+    TEST_ASSERT_TRUE(s.hasPendingAlert());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ledger_budgets_per_sub_band);
+    RUN_TEST(test_ledger_rolling_window);
+    RUN_TEST(test_ledger_limit_and_sub_bands);
+    RUN_TEST(test_priority_order);
+    RUN_TEST(test_routine_waits_for_jitter);
+    RUN_TEST(test_full_queue_evicts_less_urgent);
+    RUN_TEST(test_stale_routine_expires);
+    RUN_TEST(test_coalescing_keeps_newest_data);
+    RUN_TEST(test_alert_reserve);
+    return UNITY_END();
+}
@@ -0,0 +1,307 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MESH SIMULATION - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * 5x5 grid of nodes, 300 m apart, 450 m radio range (neighbours and
+ * diagonals only), gateway in one corner: the far corner is 4 hops away
+ * - Half-duplex radios, unslotted ALOHA, overlapping frames collide
+ * - 10% random link loss
+ * - Every node reports every 5 minutes for one simulated hour
+ * 
+ * Measures delivery ratio at the gateway and airtime per delivered frame
+ * for single hop, plain flooding and managed flooding
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "lora/mesh_relay.h"
+#include "lora/lora_airtime.h"
+
+static const int GRID = 5;
+static const int NODES = GRID * GRID;
+static const int GATEWAY = 0;
+static const float SPACING_M = 300.0f;
+static const float RANGE_M = 450.0f;
+static const uint32_t REPORT_MS = 300000;
+static const uint32_t SIM_MS = 60 * 60000;
+static const int PAYLOAD_LEN = 20;
+static const int MAX_SEQ = 16;
+
+struct SimNode {
+    MeshRelay relay;
+    float x, y;
+    
+    // Outgoing frames (own + relays), sent one at a time
+    uint8_t queue[8][LORA_MAX_PAYLOAD];
+    uint8_t queueLen[8];
+    int queued;
+    
+    bool transmitting;
+    uint32_t txEnd;
+    uint8_t txBuf[LORA_MAX_PAYLOAD];
+    uint8_t txLen;
+    
+    // Frame currently being received
+    bool receiving;
+    int rxFrom;
+    uint32_t rxEnd;
+    bool rxCorrupt;
+    uint8_t rxBuf[LORA_MAX_PAYLOAD];
+    uint8_t rxLen;
+    
+    uint32_t nextReport;
+    
+    SimNode() : relay(0) {}
+};
+
+struct SimResult {
+    uint32_t originated;
+    uint32_t delivered;
+    uint32_t airtimeMs;
+    uint32_t collisions;
+    float ratio() const { return originated ? (float)delivered / originated : 0; }
+    float airtimePerDelivered() const { return delivered ? (float)airtimeMs / delivered : 0; }
+};
+
+static SimNode nodes[NODES];
+static bool gatewayGot[NODES][MAX_SEQ];
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static float distance(int a, int b) {
+    float dx = nodes[a].x - nodes[b].x;
+    float dy = nodes[a].y - nodes[b].y;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+// -40 dBm next door, -120 dBm at the edge of range
+static int16_t rssiAt(float d) {
+    return (int16_t)(-40 - 80 * d / RANGE_M);
+}
+
+static void enqueue(SimNode& n, const uint8_t* data, size_t len) {
+    if (n.queued >= 8) return;
+    memcpy(n.queue[n.queued], data, len);
+    n.queueLen[n.queued] = (uint8_t)len;
+    n.queued++;
+}
+
+static SimResult simulate(uint8_t ttl, uint8_t suppressCount) {
+    SimResult res = {0, 0, 0, 0};
+    rngState = 0xC0FFEE;
+    memset(gatewayGot, 0, sizeof(gatewayGot));
+    
+    for (int i = 0; i < NODES; i++) {
+        SimNode& n = nodes[i];
+        n = SimNode();
+        n.relay = MeshRelay(i);
+        n.relay.seed(1000 + i * 7919);
+        n.relay.setSuppressCount(suppressCount);
+        n.x = (i % GRID) * SPACING_M;
+        n.y = (i / GRID) * SPACING_M;
+        n.nextReport = rnd() % REPORT_MS;
+    }
+    
+    for (uint32_t now = 0; now < SIM_MS + 10000; now++) {
+        // 1. Frames ending now
+        for (int r = 0; r < NODES; r++) {
+            SimNode& n = nodes[r];
+            if (n.transmitting && now >= n.txEnd) n.transmitting = false;
+            
+            if (!n.receiving || now < n.rxEnd) continue;
+            n.receiving = false;
+            if (n.rxCorrupt) continue;
+            if (rnd() % 100 < 10) continue;   // Link loss
+            
+            int16_t rssi = rssiAt(distance(r, n.rxFrom));
+            if (r == GATEWAY) {
+                MeshPacket pkt;
+                if (MeshRelay::parse(n.rxBuf, n.rxLen, pkt) && pkt.seq < MAX_SEQ &&
+                    !gatewayGot[pkt.origin][pkt.seq]) {
+                    gatewayGot[pkt.origin][pkt.seq] = true;
+                    res.delivered++;
+                }
+            } else {
+                n.relay.onReceive(n.rxBuf, n.rxLen, rssi, now);
+            }
+        }
+        
+        // 2. New reports and expired relay backoffs
+        for (int i = 1; i < NODES; i++) {
+            SimNode& n = nodes[i];
+            if (now < SIM_MS && now >= n.nextReport) {
+                uint8_t payload[PAYLOAD_LEN];
+                uint8_t frame[LORA_MAX_PAYLOAD];
+                memset(payload, i, sizeof(payload));
+                size_t len = n.relay.wrap(payload, sizeof(payload), LORA_PRIO_ROUTINE,
+                                          frame, sizeof(frame), ttl);
+                enqueue(n, frame, len);
+                res.originated++;
+                n.nextReport += REPORT_MS;
+            }
+            
+            MeshRelay::PendingRelay relay;
+            if (n.relay.pollRelay(now, relay)) enqueue(n, relay.data, relay.length);
+        }
+        
+        // 3. Start transmissions (no listen-before-talk)
+        for (int s = 1; s < NODES; s++) {
+            SimNode& n = nodes[s];
+            if (n.transmitting || n.queued == 0) continue;
+            
+            memcpy(n.txBuf, n.queue[0], n.queueLen[0]);
+            n.txLen = n.queueLen[0];
+            memmove(n.queue[0], n.queue[1], (n.queued - 1) * LORA_MAX_PAYLOAD);
+            memmove(n.queueLen, n.queueLen + 1, n.queued - 1);
+            n.queued--;
+            
+            uint32_t air = LoRaAirtime::timeOnAirMs(n.txLen, LORA_SF, LORA_BW);
+            n.transmitting = true;
+            n.txEnd = now + air;
+            n.receiving = false;   // Half duplex: abandons any reception
+            res.airtimeMs += air;
+            
+            for (int r = 0; r < NODES; r++) {
+                if (r == s || distance(r, s) > RANGE_M || nodes[r].transmitting) continue;
+                SimNode& rx = nodes[r];
+                if (rx.receiving) {
+                    rx.rxCorrupt = true;
+                    if (now + air > rx.rxEnd) rx.rxEnd = now + air;
+                    res.collisions++;
+                } else {
+                    rx.receiving = true;
+                    rx.rxFrom = s;
+                    rx.rxEnd = now + air;
+                    rx.rxCorrupt = false;
+                    memcpy(rx.rxBuf, n.txBuf, n.txLen);
+                    rx.rxLen = n.txLen;
+                }
+            }
+        }
+    }
+    return res;
+}
+
+static void report(const char* name, const SimResult& r) {
+    printf("[SIM] %-14s delivered %3lu/%3lu (%5.1f%%), airtime/delivered %6.1f ms, collisions %lu\n",
+           name, (unsigned long)r.delivered, (unsigned long)r.originated, r.ratio() * 100,
+           r.airtimePerDelivered(), (unsigned long)r.collisions);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {}
+void tearDown() {}
+
+void test_wrap_parse_roundtrip() {
+    MeshRelay relay(42);
+    uint8_t inner[6] = {42, CTX_HELMET, STATUS_FALL, 1, 0, 80};
+    uint8_t frame[32];
+    size_t len = relay.wrap(inner, sizeof(inner), LORA_PRIO_ALERT, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(MESH_HEADER_LEN + 6, len);
+    
+    MeshPacket pkt;
+    TEST_ASSERT_TRUE(MeshRelay::parse(frame, len, pkt));
+    TEST_ASSERT_EQUAL(42, pkt.origin);
+    TEST_ASSERT_EQUAL(MESH_DEFAULT_TTL, pkt.ttl);
+    TEST_ASSERT_EQUAL(0, pkt.hops);
+    TEST_ASSERT_EQUAL(LORA_PRIO_ALERT, pkt.priority);
+    TEST_ASSERT_EQUAL_MEMORY(inner, pkt.payload, 6);
+}
+
+void test_relay_decrements_ttl_and_drops_duplicates() {
+    MeshRelay origin(1), relay(2);
+    uint8_t inner[6] = {1, 0, 0, 0, 0, 90};
+    uint8_t frame[32];
+    size_t len = origin.wrap(inner, sizeof(inner), LORA_PRIO_ROUTINE, frame, sizeof(frame));
+    
+    TEST_ASSERT_TRUE(relay.onReceive(frame, len, -100, 0));
+    TEST_ASSERT_FALSE(relay.onReceive(frame, len, -100, 1));
+    TEST_ASSERT_EQUAL(1, relay.getDuplicates());
+    
+    MeshRelay::PendingRelay out;
+    TEST_ASSERT_FALSE(relay.pollRelay(0, out));
+    TEST_ASSERT_TRUE(relay.pollRelay(2 * MESH_RELAY_BACKOFF_MS, out));
+    
+    MeshPacket pkt;
+    TEST_ASSERT_TRUE(MeshRelay::parse(out.data, out.length, pkt));
+    TEST_ASSERT_EQUAL(MESH_DEFAULT_TTL - 1, pkt.ttl);
+    TEST_ASSERT_EQUAL(1, pkt.hops);
+    
+    // Own frame echoed back is never relayed
+    TEST_ASSERT_FALSE(origin.onReceive(out.data, out.length, -60, 0));
+    TEST_ASSERT_EQUAL(0, origin.pendingCount());
+}
+
+void test_overheard_relays_suppress_ours() {
+    MeshRelay origin(1), relay(2);
+    uint8_t inner[6] = {1, 0, 0, 0, 0, 90};
+    uint8_t frame[32];
+    size_t len = origin.wrap(inner, sizeof(inner), LORA_PRIO_ROUTINE, frame, sizeof(frame));
+    
+    relay.onReceive(frame, len, -100, 0);
+    for (int i = 0; i < MESH_SUPPRESS_COUNT; i++) relay.onReceive(frame, len, -100, 1);
+    
+    TEST_ASSERT_EQUAL(0, relay.pendingCount());
+    TEST_ASSERT_EQUAL(1, relay.getSuppressed());
+}
+
+void test_battery_gate_with_hysteresis() {
+    MeshRelay origin(1), relay(2);
+    uint8_t inner[6] = {1, 0, 0, 0, 0, 90};
+    uint8_t frame[32];
+    
+    relay.updateBattery(MESH_RELAY_MIN_BATT - 1);
+    TEST_ASSERT_FALSE(relay.isRelayEnabled());
+    size_t len = origin.wrap(inner, sizeof(inner), LORA_PRIO_ROUTINE, frame, sizeof(frame));
+    relay.onReceive(frame, len, -100, 0);
+    TEST_ASSERT_EQUAL(0, relay.pendingCount());
+    
+    relay.updateBattery(MESH_RELAY_MIN_BATT + 1);
+    TEST_ASSERT_FALSE(relay.isRelayEnabled());
+    relay.updateBattery(MESH_RELAY_MIN_BATT + 10);
+    TEST_ASSERT_TRUE(relay.isRelayEnabled());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// MULTI-NODE SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_managed_flood_reaches_the_whole_grid() {
+    SimResult single = simulate(1, 0);
+    SimResult flood = simulate(MESH_DEFAULT_TTL, 0);
+    SimResult managed = simulate(MESH_DEFAULT_TTL, MESH_SUPPRESS_COUNT);
+    
+    report("single hop", single);
+    report("plain flood", flood);
+    report("managed flood", managed);
+    
+    // Only the 3 gateway neighbours are reachable without relays
+    TEST_ASSERT_TRUE(single.ratio() < 0.2f);
+    TEST_ASSERT_TRUE(managed.ratio() > 0.9f);
+    TEST_ASSERT_TRUE(managed.ratio() >= flood.ratio() - 0.03f);
+    TEST_ASSERT_TRUE(managed.airtimePerDelivered() < 0.85f * flood.airtimePerDelivered());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_wrap_parse_roundtrip);
+    RUN_TEST(test_relay_decrements_ttl_and_drops_duplicates);
+    RUN_TEST(test_overheard_relays_suppress_ours);
+    RUN_TEST(test_battery_gate_with_hysteresis);
+    RUN_TEST(test_managed_flood_reaches_the_whole_grid);
+    return UNITY_END();
+}
@@ -0,0 +1,232 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE BATCH - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Batch kernels (src/modules/batch_kernels.h) and the batch form of the
+ * helmet fall detector (the shipped HelmetModule, built against the
+ * Arduino stub in test/stubs):
+ * - Scans find the same index as a sample-by-sample loop, for every
+ *   position and burst length (block tails included)
+ * - Batch and per-sample helmet report the same falls and impacts
+ * - ModuleBase's default updateBatch is update() per sample
+ * - [BENCH] per-sample update() vs updateBatch() over FIFO bursts
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#include "config.h"
+#include "modules/batch_kernels.h"
+#include "modules/module_registry.h"
+#include "modules/helmet_module.h"
+
+static const float G = 9.81f;
+
+// Falls reported since the last call (the module latches one at a time,
+// as main.cpp reads it once per loop)
+static int fallsSeen(HelmetModule& m) {
+    return m.isFallDetected() ? 1 : 0;
+}
+
+// 100 Hz stream: rest at 1 g with noise, a fall (free-fall then impact)
+// every `fallEvery` samples and a free-fall that times out in between
+static void makeStream(SensorData* out, size_t n, size_t fallEvery) {
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < n; i++) {
+        rng = rng * 1664525 + 1013904223;
+        float noise = ((rng >> 8) & 0xFF) / 255.0f * 0.4f - 0.2f;
+        float az = G + noise;
+        size_t phase = i % fallEvery;
+        if (phase >= 10 && phase < 25) az = 0.1f * G;                       // Free-fall (150 ms)
+        else if (phase == 30) az = 6.0f * G;                                // Impact
+        else if (phase >= fallEvery / 2 && phase < fallEvery / 2 + 5) az = 0.2f * G;   // Drop, no impact
+        else if (phase == fallEvery / 2 + 150) az = 5.0f * G;               // Knock after the window
+        out[i].accel_x = noise;
+        out[i].accel_y = -noise;
+        out[i].accel_z = az;
+        out[i].gyro_x = out[i].gyro_y = out[i].gyro_z = 0;
+        out[i].temperature = 25;
+        out[i].timestamp = (unsigned long)(i * 10);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// KERNELS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_scans_match_loop() {
+    float v[40];
+    for (size_t n = 0; n <= 40; n++) {
+        for (size_t at = 0; at <= n; at++) {
+            for (size_t i = 0; i < n; i++) v[i] = 1.0f;
+            if (at < n) v[at] = 0.5f;
+            TEST_ASSERT_EQUAL(at, firstBelow(v, n, 0.8f));
+            TEST_ASSERT_EQUAL(n, firstAbove(v, n, 1.0f));
+            if (at < n) v[at] = 2.0f;
+            TEST_ASSERT_EQUAL(at, firstAbove(v, n, 1.5f));
+            TEST_ASSERT_EQUAL(n, firstBelow(v, n, 1.0f));
+            if (n > 0) TEST_ASSERT_FLOAT_WITHIN(0.0001f, at < n ? 2.0f : 1.0f, maxOf(v, n));
+        }
+    }
+    
+    // Several hits: the first one
+    for (size_t i = 0; i < 40; i++) v[i] = (i == 13 || i == 17 || i == 30) ? 0.0f : 1.0f;
+    TEST_ASSERT_EQUAL(13, firstBelow(v, 40, 0.5f));
+    TEST_ASSERT_EQUAL(17, 14 + firstBelow(&v[14], 26, 0.5f));
+    
+    SensorData s[3] = {};
+    s[0].accel_x = 3; s[0].accel_y = 4;
+    s[1].accel_z = -2;
+    s[2].accel_x = 1; s[2].accel_y = 2; s[2].accel_z = 2;
+    float m[3];
+    accelMagnitudeSq(s, 3, m);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 25.0f, m[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0f, m[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 9.0f, m[2]);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// HELMET: BATCH = PER SAMPLE
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_helmet_batch_matches_per_sample() {
+    const size_t n = 4000;
+    static SensorData stream[n];
+    makeStream(stream, n, 400);
+    
+    HelmetModule single;
+    int singleFalls = 0;
+    for (size_t i = 0; i < n; i++) {
+        single.update(stream[i]);
+        singleFalls += fallsSeen(single);
+    }
+    TEST_ASSERT_EQUAL(10, singleFalls);
+    TelemetryData want = single.getTelemetry();
+    
+    // Burst sizes as a FIFO delivers them: uneven, across chunk borders
+    // (at most one fall per burst: falls are 400 samples apart)
+    const size_t bursts[] = {1, 7, 8, 9, 31, 32, 33, 100};
+    for (size_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+        HelmetModule batch;
+        int batchFalls = 0;
+        for (size_t i = 0; i < n; i += bursts[b]) {
+            batch.updateBatch(&stream[i], i + bursts[b] <= n ? bursts[b] : n - i);
+            batchFalls += fallsSeen(batch);
+        }
+        TEST_ASSERT_EQUAL(singleFalls, batchFalls);
+        TelemetryData got = batch.getTelemetry();
+        TEST_ASSERT_EQUAL(want.sensor_val, got.sensor_val);
+        TEST_ASSERT_EQUAL(want.status, got.status);
+    }
+    
+    // A window (100 ms, the minimum) shorter than the free-fall phase
+    // (150 ms) times out mid-fall and re-arms: both take the same path
+    HelmetModule shortSingle, shortBatch;
+    TEST_ASSERT_TRUE(shortSingle.setParam(HelmetModule::PARAM_FALL_WINDOW_MS, 100));
+    TEST_ASSERT_TRUE(shortBatch.setParam(HelmetModule::PARAM_FALL_WINDOW_MS, 100));
+    int shortSingleFalls = 0, shortBatchFalls = 0;
+    for (size_t i = 0; i < n; i++) {
+        shortSingle.update(stream[i]);
+        shortSingleFalls += fallsSeen(shortSingle);
+    }
+    for (size_t i = 0; i < n; i += 16) {
+        shortBatch.updateBatch(&stream[i], 16);
+        shortBatchFalls += fallsSeen(shortBatch);
+    }
+    TEST_ASSERT_EQUAL(shortSingleFalls, shortBatchFalls);
+    TEST_ASSERT_EQUAL(shortSingle.getTelemetry().sensor_val, shortBatch.getTelemetry().sensor_val);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// DEFAULT ADAPTER (ModuleBase)
+// ───────────────────────────────────────────────────────────────────────────
+
+class CountModule : public ModuleBase<CountModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_ASSET;
+    static constexpr const char* NAME = "COUNT";
+    uint32_t count = 0;
+    unsigned long last = 0;
+    void init() {}
+    void update(const SensorData& data) { count++; last = data.timestamp; }
+    TelemetryData getTelemetry() { return TelemetryData{(uint16_t)count, STATUS_OK}; }
+};
+
+void test_default_batch_adapter() {
+    SensorData s[5] = {};
+    for (int i = 0; i < 5; i++) s[i].timestamp = 100 + i;
+    
+    ModuleRegistry<ModuleStorage::RESIDENT, CountModule> reg;
+    reg.init();
+    reg.updateBatch(s, 5);
+    reg.updateBatch(s, 0);
+    TEST_ASSERT_EQUAL(5, reg.getTelemetry().sensor_val);
+    TEST_ASSERT_EQUAL(104, reg.getIf<CountModule>()->last);
+    
+    struct Plain {
+        uint32_t count = 0;
+        void init() {}
+        void update(const SensorData&) { count++; }
+        TelemetryData getTelemetry() { return TelemetryData{0, STATUS_OK}; }
+    } plain;
+    moduleUpdateBatch(plain, s, 5);
+    TEST_ASSERT_EQUAL(5, plain.count);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BENCH
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_batch_benchmark() {
+    const size_t n = 3200;
+    static SensorData stream[n];
+    makeStream(stream, n, 1600);
+    const int rounds = 2000;
+    const size_t burst = 16;   // 160 ms of FIFO at 100 Hz: a slow loop iteration
+    
+    HelmetModule single;
+    int singleFalls = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < n; i++) single.update(stream[i]);
+        singleFalls += fallsSeen(single);
+    }
+    double singleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+                      / ((double)rounds * n);
+    
+    HelmetModule batch;
+    int batchFalls = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < n; i += burst) batch.updateBatch(&stream[i], burst);
+        batchFalls += fallsSeen(batch);
+    }
+    double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+                     / ((double)rounds * n);
+    
+    printf("[BENCH] helmet: update() %.2f ns/sample, updateBatch(%u) %.2f ns/sample (%.1fx), %d falls\n",
+           singleNs, (unsigned)burst, batchNs, singleNs / batchNs, batchFalls / rounds);
+    TEST_ASSERT_EQUAL(rounds, singleFalls);
+    TEST_ASSERT_EQUAL(singleFalls, batchFalls);
+    // Loose: about 2x optimized, still ahead unoptimized; never slower by more than noise
+    TEST_ASSERT_TRUE(batchNs < singleNs * 1.25);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scans_match_loop);
+    RUN_TEST(test_helmet_batch_matches_per_sample);
+    RUN_TEST(test_default_batch_adapter);
+    RUN_TEST(test_batch_benchmark);
+    return UNITY_END();
+}
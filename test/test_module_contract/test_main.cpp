@@ -0,0 +1,122 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE CONTRACT - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * ModuleContract detection on stand-in modules (the real ones need Arduino;
+ * the firmware build asserts them in main.cpp):
+ * - Required methods: init, update(const SensorData&), getTelemetry
+ * - A by-value update or a foreign TelemetryData does not count
+ * - Optional hooks are detected, and checked only when declared
+ * - moduleSampleInterval() and the registry forward getSampleInterval
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "modules/module_contract.h"
+#include "modules/module_registry.h"
+
+using namespace module_contract;
+
+struct Minimal {
+    void init() {}
+    void update(const SensorData&) {}
+    TelemetryData getTelemetry() { return TelemetryData{0, STATUS_OK}; }
+};
+
+struct Full : Minimal {
+    uint32_t interval = 20;
+    size_t batched = 0;
+    uint32_t getSampleInterval() { return interval; }
+    void updateBatch(const SensorData*, size_t n) { batched += n; }
+};
+
+struct ByValue {
+    void init() {}
+    void update(SensorData) {}
+    TelemetryData getTelemetry() { return TelemetryData{0, STATUS_OK}; }
+};
+
+// As generated modules that bring their own types.h
+struct OwnTelemetry { float motionIntensity; };
+struct ForeignTypes {
+    void init() {}
+    void update(const SensorData&) {}
+    OwnTelemetry getTelemetry() { return OwnTelemetry{0}; }
+};
+
+struct BadHooks : Minimal {
+    uint32_t getSampleInterval(bool) { return 0; }
+    void updateBatch(const SensorData*) {}
+};
+
+class SlowModule : public ModuleBase<SlowModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_ASSET;
+    static constexpr const char* NAME = "SLOW";
+    void init() {}
+    void update(const SensorData&) {}
+    TelemetryData getTelemetry() { return TelemetryData{0, STATUS_OK}; }
+    uint32_t getSampleInterval() { return 1000; }
+};
+
+class FastModule : public ModuleBase<FastModule> {
+public:
+    static constexpr ContextType CONTEXT = CTX_VEHICLE;
+    static constexpr const char* NAME = "FAST";
+    void init() {}
+    void update(const SensorData&) {}
+    TelemetryData getTelemetry() { return TelemetryData{0, STATUS_OK}; }
+};
+
+typedef ModuleRegistry<ModuleStorage::RESIDENT, SlowModule, FastModule> Registry;
+
+// Compile time: what the firmware build asserts
+static_assert(ModuleContract<Minimal>::value, "minimal module");
+static_assert(!ModuleContract<Minimal>::hasSampleInterval && !ModuleContract<Minimal>::hasUpdateBatch, "no hooks");
+static_assert(ModuleContract<Full>::hasSampleInterval && ModuleContract<Full>::hasUpdateBatch, "both hooks");
+static_assert(ModuleContract<Registry>::value && ModuleContract<Registry>::hasSampleInterval, "registry");
+
+static_assert(!HasUpdate<ByValue>::value, "by-value update rejected");
+static_assert(HasInit<ByValue>::value && HasTelemetry<ByValue>::value, "rest of ByValue is fine");
+static_assert(!HasTelemetry<ForeignTypes>::value, "foreign TelemetryData rejected");
+static_assert(DeclaresSampleInterval<BadHooks>::value && !HasSampleInterval<BadHooks>::value, "bad interval");
+static_assert(DeclaresUpdateBatch<BadHooks>::value && !HasUpdateBatch<BadHooks>::value, "bad batch");
+static_assert(!DeclaresSampleInterval<Minimal>::value && !DeclaresUpdateBatch<Minimal>::value, "undeclared");
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RUNTIME
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_sample_interval() {
+    Minimal minimal;
+    Full full;
+    TEST_ASSERT_EQUAL(0, moduleSampleInterval(minimal));
+    TEST_ASSERT_EQUAL(20, moduleSampleInterval(full));
+    full.interval = 250;
+    TEST_ASSERT_EQUAL(250, moduleSampleInterval(full));
+}
+
+void test_registry_forwards_interval() {
+    Registry reg;
+    reg.init();
+    TEST_ASSERT_EQUAL(1000, reg.getSampleInterval());
+    TEST_ASSERT_EQUAL(1000, moduleSampleInterval(reg));
+    reg.activateContext(CTX_VEHICLE);
+    TEST_ASSERT_EQUAL(0, reg.getSampleInterval());   // FastModule: every loop
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_interval);
+    RUN_TEST(test_registry_forwards_interval);
+    return UNITY_END();
+}
@@ -0,0 +1,270 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE REGISTRY - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * ModuleRegistry with stand-in modules (the real ones need Arduino):
+ * - Calls reach only the active module; defaults cover missing hooks
+ * - Contexts map to modules; unknown ones leave the active module running
+ * - RESIDENT keeps every module's state, ARENA rebuilds the module
+ *   switched to and takes the size of the largest one
+ * - init() runs once per module, onActivate / onDeactivate on switches
+ * - [BENCH] update() through the registry vs a virtual interface, and the
+ *   cost of a switch
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "modules/module_registry.h"
+
+static int inits = 0, activations = 0, deactivations = 0, constructed = 0, destroyed = 0;
+
+struct Counted {
+    Counted() { constructed++; }
+    ~Counted() { destroyed++; }
+};
+
+// Counts samples; sensor_val = count
+class CountModule : public ModuleBase<CountModule>, Counted {
+public:
+    static constexpr ContextType CONTEXT = CTX_HELMET;
+    static constexpr const char* NAME = "COUNT";
+    
+    uint32_t count = 0;
+    
+    void init() { inits++; }
+    void update(const SensorData&) { count++; }
+    TelemetryData getTelemetry() {
+        TelemetryData t = {(uint16_t)count, STATUS_OK};
+        return t;
+    }
+    void onActivate() { activations++; }
+    void onDeactivate() { deactivations++; }
+};
+
+// Sums accel_x * 10 with a settable gain; status FALL above a limit
+class SumModule : public ModuleBase<SumModule>, Counted {
+public:
+    static constexpr ContextType CONTEXT = CTX_BICYCLE;
+    static constexpr const char* NAME = "SUM";
+    
+    int32_t sum = 0;
+    int32_t gain = 1;
+    uint8_t padding[64] = {0};
+    
+    void init() { inits++; }
+    void update(const SensorData& data) { sum += (int32_t)(data.accel_x * 10) * gain; }
+    TelemetryData getTelemetry() {
+        TelemetryData t = {(uint16_t)sum, sum > 100 ? STATUS_FALL : STATUS_OK};
+        return t;
+    }
+    bool setParam(uint8_t id, int32_t value) {
+        if (id != 1 || value < 1 || value > 10) return false;
+        gain = value;
+        return true;
+    }
+    bool getParam(uint8_t id, int32_t& value) {
+        if (id != 1) return false;
+        value = gain;
+        return true;
+    }
+};
+
+class IdleModule : public ModuleBase<IdleModule>, Counted {
+public:
+    static constexpr ContextType CONTEXT = CTX_ASSET;
+    static constexpr const char* NAME = "IDLE";
+    
+    void init() { inits++; }
+    void update(const SensorData&) {}
+    TelemetryData getTelemetry() {
+        TelemetryData t = {7, STATUS_OK};
+        return t;
+    }
+};
+
+typedef ModuleRegistry<ModuleStorage::RESIDENT, CountModule, SumModule, IdleModule> Resident;
+typedef ModuleRegistry<ModuleStorage::ARENA, CountModule, SumModule, IdleModule> Arena;
+
+static_assert(Resident::indexOf(CTX_BICYCLE) == 1, "context → index at compile time");
+static_assert(Resident::indexOf(CTX_VEHICLE) == Resident::NONE, "no vehicle module");
+static_assert(Arena::storageBytes() == sizeof(SumModule), "arena: the largest module");
+static_assert(Resident::storageBytes() >= sizeof(CountModule) + sizeof(SumModule) + sizeof(IdleModule),
+              "resident: all modules");
+
+static SensorData sample(float ax) {
+    SensorData d = {};
+    d.accel_x = ax;
+    return d;
+}
+
+void setUp() {
+    inits = activations = deactivations = constructed = destroyed = 0;
+}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// DISPATCH
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_dispatch_reaches_active_module() {
+    Resident reg;
+    TEST_ASSERT_EQUAL(Resident::NONE, reg.getActive());
+    reg.init();
+    TEST_ASSERT_EQUAL(3, inits);
+    TEST_ASSERT_EQUAL(1, activations);
+    TEST_ASSERT_EQUAL(0, reg.getActive());
+    TEST_ASSERT_EQUAL(CTX_HELMET, reg.getContext());
+    TEST_ASSERT_EQUAL_STRING("COUNT", reg.getName());
+    
+    for (int i = 0; i < 5; i++) reg.update(sample(1.0f));
+    TEST_ASSERT_EQUAL(5, reg.getTelemetry().sensor_val);
+    TEST_ASSERT_NOT_NULL(reg.getIf<CountModule>());
+    TEST_ASSERT_NULL(reg.getIf<SumModule>());
+    
+    // Defaults from ModuleBase: CountModule has no params
+    int32_t v = 0;
+    TEST_ASSERT_FALSE(reg.setParam(1, 3));
+    TEST_ASSERT_FALSE(reg.getParam(1, v));
+    
+    TEST_ASSERT_TRUE(reg.activateContext(CTX_BICYCLE));
+    TEST_ASSERT_EQUAL(1, deactivations);
+    TEST_ASSERT_EQUAL_STRING("SUM", reg.getName());
+    TEST_ASSERT_TRUE(reg.setParam(1, 3));
+    TEST_ASSERT_FALSE(reg.setParam(1, 11));
+    TEST_ASSERT_TRUE(reg.getParam(1, v));
+    TEST_ASSERT_EQUAL(3, v);
+    for (int i = 0; i < 5; i++) reg.update(sample(1.0f));
+    TelemetryData t = reg.getTelemetry();
+    TEST_ASSERT_EQUAL(150, t.sensor_val);
+    TEST_ASSERT_EQUAL(STATUS_FALL, t.status);
+    
+    // Unknown context or index: nothing changes
+    TEST_ASSERT_FALSE(reg.activateContext(CTX_VEHICLE));
+    TEST_ASSERT_FALSE(reg.activate(3));
+    TEST_ASSERT_EQUAL(1, reg.getActive());
+    TEST_ASSERT_TRUE(reg.activate(1));
+    TEST_ASSERT_EQUAL(1, reg.getSwitches());
+    TEST_ASSERT_EQUAL(3, inits);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// STORAGE
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_resident_keeps_state() {
+    Resident reg;
+    reg.init();
+    for (int i = 0; i < 4; i++) reg.update(sample(1.0f));
+    reg.activate(1);
+    reg.update(sample(2.0f));
+    reg.activate(2);
+    TEST_ASSERT_EQUAL(7, reg.getTelemetry().sensor_val);
+    reg.activate(0);
+    TEST_ASSERT_EQUAL(4, reg.getTelemetry().sensor_val);
+    reg.activate(1);
+    TEST_ASSERT_EQUAL(20, reg.getTelemetry().sensor_val);
+    TEST_ASSERT_EQUAL(3, constructed);
+    TEST_ASSERT_EQUAL(0, destroyed);
+}
+
+void test_arena_rebuilds_module() {
+    {
+        Arena reg;
+        reg.init();
+        // Each module built for its init(), then the first one for good
+        TEST_ASSERT_EQUAL(3, inits);
+        TEST_ASSERT_EQUAL(4, constructed);
+        TEST_ASSERT_EQUAL(3, destroyed);
+        
+        for (int i = 0; i < 4; i++) reg.update(sample(1.0f));
+        TEST_ASSERT_EQUAL(4, reg.getTelemetry().sensor_val);
+        reg.activate(1);
+        TEST_ASSERT_TRUE(reg.setParam(1, 2));
+        reg.update(sample(2.0f));
+        TEST_ASSERT_EQUAL(40, reg.getTelemetry().sensor_val);
+        
+        // Back to a module: fresh state, defaults again
+        reg.activate(0);
+        TEST_ASSERT_EQUAL(0, reg.getTelemetry().sensor_val);
+        reg.activate(1);
+        int32_t gain = 0;
+        TEST_ASSERT_TRUE(reg.getParam(1, gain));
+        TEST_ASSERT_EQUAL(1, gain);
+        TEST_ASSERT_EQUAL(2, activations);   // CountModule: init() and back
+        TEST_ASSERT_EQUAL(3, inits);
+    }
+    // Every module built was destroyed (the last one with the registry)
+    TEST_ASSERT_EQUAL(constructed, destroyed);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BENCH
+// ───────────────────────────────────────────────────────────────────────────
+
+struct IModule {
+    virtual ~IModule() {}
+    virtual void update(const SensorData& data) = 0;
+};
+
+struct VirtualSum : IModule {
+    int32_t sum = 0;
+    void update(const SensorData& data) override { sum += (int32_t)(data.accel_x * 10); }
+};
+
+struct VirtualCount : IModule {
+    uint32_t count = 0;
+    void update(const SensorData&) override { count++; }
+};
+
+void test_dispatch_benchmark() {
+    const uint32_t runs = 5000000;
+    static SensorData samples[64];
+    for (int i = 0; i < 64; i++) samples[i] = sample((float)(i % 7));
+    
+    // Index unknown to the compiler, as with a classifier result
+    volatile uint8_t pick = 1;
+    Resident reg;
+    reg.init();
+    reg.activate(pick);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runs; i++) reg.update(samples[i & 63]);
+    double staticNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+    
+    VirtualCount vc;
+    VirtualSum vs;
+    IModule* volatile active = pick ? (IModule*)&vs : (IModule*)&vc;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runs; i++) active->update(samples[i & 63]);
+    double virtualNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+    
+    const uint32_t switchRuns = 1000000;
+    Arena arena;
+    arena.init();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < switchRuns; i++) arena.activate(i % 3);
+    double switchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / switchRuns;
+    
+    printf("[BENCH] update: registry %.2f ns, virtual %.2f ns; ARENA switch %.1f ns; "
+           "RAM resident %u / arena %u bytes\n",
+           staticNs, virtualNs, switchNs, (unsigned)Resident::storageBytes(), (unsigned)Arena::storageBytes());
+    TEST_ASSERT_EQUAL((int32_t)vs.sum, reg.getIf<SumModule>()->sum);
+    TEST_ASSERT_EQUAL(switchRuns, arena.getSwitches() + 1);   // i = 0 was already active
+    // Loose: a switch is a few calls, far below the 1 µs budget even unoptimized
+    TEST_ASSERT_TRUE(switchNs < 1000);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_dispatch_reaches_active_module);
+    RUN_TEST(test_resident_keeps_state);
+    RUN_TEST(test_arena_rebuilds_module);
+    RUN_TEST(test_dispatch_benchmark);
+    return UNITY_END();
+}
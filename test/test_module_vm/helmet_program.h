@@ -0,0 +1,42 @@
+// GENERATED by backend/module-compiler.js from backend/vm_modules/helmet.uadm
+// 400 bytes, 72 instructions, 3 registers
+
+#pragma once
+#include <stdint.h>
+
+alignas(4) static const uint8_t HELMET_VM_PROGRAM[] = {
+    0x55, 0x41, 0x44, 0x4d, 0x01, 0x01, 0x03, 0x07, 0x03, 0x00, 0x48, 0x00,
+    0x00, 0x00, 0x3a, 0x00, 0x68, 0x65, 0x6c, 0x6d, 0x65, 0x74, 0x5f, 0x76,
+    0x6d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc3, 0xf5, 0x1c, 0x41,
+    0x00, 0x00, 0x7a, 0x44, 0x00, 0x00, 0xc8, 0x42, 0x90, 0x01, 0x00, 0x00,
+    0xa0, 0x0f, 0x00, 0x00, 0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 0xe8, 0x03, 0x00, 0x00,
+    0x02, 0x01, 0x00, 0x00, 0xe8, 0x03, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00,
+    0x03, 0x02, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00, 0x88, 0x13, 0x00, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x06, 0x01, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x01,
+    0x06, 0x01, 0x01, 0x00, 0x06, 0x02, 0x01, 0x00, 0x0f, 0x01, 0x01, 0x02,
+    0x0d, 0x00, 0x00, 0x01, 0x06, 0x01, 0x02, 0x00, 0x06, 0x02, 0x02, 0x00,
+    0x0f, 0x01, 0x01, 0x02, 0x0d, 0x00, 0x00, 0x01, 0x24, 0x00, 0x00, 0x00,
+    0x02, 0x01, 0x00, 0x00, 0x10, 0x00, 0x00, 0x01, 0x04, 0x01, 0x03, 0x00,
+    0x1f, 0x01, 0x01, 0x00, 0x26, 0x01, 0x0c, 0x00, 0x02, 0x01, 0x01, 0x00,
+    0x0f, 0x01, 0x00, 0x01, 0x04, 0x02, 0x00, 0x00, 0x20, 0x02, 0x02, 0x00,
+    0x15, 0x01, 0x01, 0x02, 0x26, 0x01, 0x05, 0x00, 0x03, 0x01, 0x01, 0x00,
+    0x05, 0x03, 0x01, 0x00, 0x06, 0x01, 0x07, 0x00, 0x05, 0x04, 0x01, 0x00,
+    0x28, 0x01, 0x00, 0x00, 0x25, 0x00, 0x1c, 0x00, 0x02, 0x01, 0x01, 0x00,
+    0x0f, 0x01, 0x00, 0x01, 0x04, 0x02, 0x01, 0x00, 0x20, 0x02, 0x02, 0x00,
+    0x15, 0x01, 0x02, 0x01, 0x26, 0x01, 0x0e, 0x00, 0x06, 0x01, 0x07, 0x00,
+    0x04, 0x02, 0x04, 0x00, 0x09, 0x01, 0x01, 0x02, 0x04, 0x02, 0x02, 0x00,
+    0x11, 0x01, 0x01, 0x02, 0x26, 0x01, 0x05, 0x00, 0x03, 0x01, 0x01, 0x00,
+    0x05, 0x05, 0x01, 0x00, 0x05, 0x06, 0x00, 0x00, 0x28, 0x01, 0x00, 0x00,
+    0x28, 0x03, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x05, 0x03, 0x01, 0x00,
+    0x25, 0x00, 0x08, 0x00, 0x06, 0x01, 0x07, 0x00, 0x04, 0x02, 0x04, 0x00,
+    0x09, 0x01, 0x01, 0x02, 0x04, 0x02, 0x02, 0x00, 0x11, 0x01, 0x02, 0x01,
+    0x26, 0x01, 0x02, 0x00, 0x03, 0x01, 0x00, 0x00, 0x05, 0x03, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x06, 0x00, 0x02, 0x01, 0x02, 0x00,
+    0x0f, 0x00, 0x00, 0x01, 0x21, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+    0x04, 0x01, 0x05, 0x00, 0x26, 0x01, 0x03, 0x00, 0x03, 0x01, 0x03, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x25, 0x00, 0x02, 0x00, 0x03, 0x01, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xa6, 0x7f, 0xc9, 0x70,
+};
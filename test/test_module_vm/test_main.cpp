@@ -0,0 +1,466 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    MODULE VM - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * ModuleVm and the program verifier:
+ * - Damaged programs (CRC, operands, jumps, fall-through, params) never load
+ * - Integer ops wrap, x / 0 = 0, float → int saturates
+ * - A looping module stops at VM_STEP_LIMIT instead of stalling the loop
+ * - Params are range-checked; loading another program resets all state
+ * - helmet_program.h (backend/vm_modules/helmet.uadm through the compiler)
+ *   matches HelmetModule's logic on a simulated trace with falls
+ * - [BENCH] interpreted vs native ns per update of the same module
+ * 
+ * Regenerate the fixture after a compiler change:
+ *   cd backend && node module-compiler.js vm_modules/helmet.uadm
+ *                  --header ../test/test_module_vm/helmet_program.h
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "vm/module_vm.h"
+#include "helmet_program.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// ───────────────────────────────────────────────────────────────────────────
+// ASSEMBLER (hand-built programs in the compiler's output format)
+// ───────────────────────────────────────────────────────────────────────────
+
+struct Asm {
+    std::vector<uint32_t> consts, cells, code;
+    std::vector<VmParam> params;
+    uint16_t updateEntry = 0, telemetryEntry = 0;
+    
+    void op(uint8_t o, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0) {
+        code.push_back(o | (a << 8) | (b << 16) | ((uint32_t)c << 24));
+    }
+    
+    void opBC(uint8_t o, uint8_t a, int16_t bc) {
+        code.push_back(o | (a << 8) | ((uint32_t)(uint16_t)bc << 16));
+    }
+    
+    void param(uint8_t id, uint8_t cell, int32_t min, int32_t max) {
+        VmParam p = {id, cell, 0, min, max};
+        params.push_back(p);
+    }
+    
+    Bytes build(const char* name = "test") const {
+        Bytes out(VM_HEADER_LEN, 0);
+        memcpy(out.data(), VM_MAGIC, 4);
+        out[4] = VM_VERSION;
+        out[6] = consts.size();
+        out[7] = cells.size();
+        out[8] = params.size();
+        out[10] = code.size() & 0xFF;
+        out[11] = code.size() >> 8;
+        out[12] = updateEntry & 0xFF;
+        out[13] = updateEntry >> 8;
+        out[14] = telemetryEntry & 0xFF;
+        out[15] = telemetryEntry >> 8;
+        memcpy(&out[16], name, strlen(name));
+        auto put = [&](const void* p, size_t n) {
+            const uint8_t* b = (const uint8_t*)p;
+            out.insert(out.end(), b, b + n);
+        };
+        for (uint32_t k : consts) put(&k, 4);
+        for (uint32_t c : cells) put(&c, 4);
+        for (const VmParam& p : params) put(&p, VM_PARAM_LEN);
+        for (uint32_t w : code) put(&w, 4);
+        uint32_t crc = vmCrc32(out.data(), out.size());
+        put(&crc, 4);
+        return out;
+    }
+};
+
+static void reseal(Bytes& p) {
+    uint32_t crc = vmCrc32(p.data(), p.size() - 4);
+    memcpy(&p[p.size() - 4], &crc, 4);
+}
+
+static uint32_t floatBits(float f) {
+    VmCell c;
+    c.f = f;
+    return c.u;
+}
+
+static ModuleVm vm;
+static VmCell inputs[VM_INPUTS];
+
+void setUp() {
+    vm.unload();
+    vm.setSyscall(nullptr, nullptr);
+    memset(inputs, 0, sizeof(inputs));
+}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// VERIFIER
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_verifier_rejects_bad_programs() {
+    Asm a;
+    a.cells = {0};
+    a.op(VM_LDI, 0, 7, 0);
+    a.op(VM_STS, 0, 0);
+    a.op(VM_RET);
+    Bytes good = a.build();
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(good.data(), good.size()));
+    
+    // Flipped byte, wrong length, misaligned buffer; the running program stays
+    Bytes bad = good;
+    bad[VM_HEADER_LEN + 1] ^= 1;
+    TEST_ASSERT_EQUAL(VM_ERR_CRC, vm.load(bad.data(), bad.size()));
+    TEST_ASSERT_TRUE(vm.isRunning());
+    TEST_ASSERT_EQUAL(VM_ERR_SIZE, vm.load(good.data(), good.size() - 4));
+    Bytes shifted(good.size() + 1);
+    memcpy(&shifted[1], good.data(), good.size());
+    TEST_ASSERT_EQUAL(VM_ERR_HEADER, vm.load(&shifted[1], good.size()));
+    
+    // Register, cell, input and opcode out of range
+    struct { uint8_t op, a, b, c; } operands[] = {
+        {VM_MOV, VM_REGISTERS, 0, 0}, {VM_ADDI, 0, 0, VM_REGISTERS}, {VM_STS, 1, 0, 0},
+        {VM_LDIN, 0, VM_INPUTS, 0}, {VM_OUT, VM_OUTPUTS, 0, 0}, {VM_SYS, VM_SYSCALLS, 0, 0},
+        {VM_LDK, 0, 0, 0}, {VM_RET, 1, 0, 0}, {VM_OP_COUNT, 0, 0, 0}
+    };
+    for (auto& o : operands) {
+        Asm b = a;
+        b.code[1] = o.op | (o.a << 8) | (o.b << 16) | ((uint32_t)o.c << 24);
+        Bytes p = b.build();
+        TEST_ASSERT_EQUAL(VM_ERR_OPERAND, vm.load(p.data(), p.size()));
+    }
+    
+    // Jumps out of the code, entry out of the code, no RET at the end
+    Asm j = a;
+    j.code[1] = VM_JMP | (5 << 16);
+    Bytes p = j.build();
+    TEST_ASSERT_EQUAL(VM_ERR_JUMP, vm.load(p.data(), p.size()));
+    j = a;
+    j.code[0] = VM_JZ | ((uint32_t)(uint16_t)-2 << 16);
+    p = j.build();
+    TEST_ASSERT_EQUAL(VM_ERR_JUMP, vm.load(p.data(), p.size()));
+    j = a;
+    j.telemetryEntry = 3;
+    p = j.build();
+    TEST_ASSERT_EQUAL(VM_ERR_JUMP, vm.load(p.data(), p.size()));
+    j = a;
+    j.code.pop_back();
+    p = j.build();
+    TEST_ASSERT_EQUAL(VM_ERR_FALLTHROUGH, vm.load(p.data(), p.size()));
+    
+    // Params: cell outside the state, empty range, default outside, duplicate id
+    Asm q = a;
+    q.param(1, 1, 0, 10);
+    p = q.build();
+    TEST_ASSERT_EQUAL(VM_ERR_PARAM, vm.load(p.data(), p.size()));
+    q = a;
+    q.param(1, 0, 10, 0);
+    p = q.build();
+    TEST_ASSERT_EQUAL(VM_ERR_PARAM, vm.load(p.data(), p.size()));
+    q = a;
+    q.param(1, 0, 5, 10);
+    p = q.build();
+    TEST_ASSERT_EQUAL(VM_ERR_PARAM, vm.load(p.data(), p.size()));
+    q = a;
+    q.cells = {0, 0};
+    q.param(1, 0, 0, 10);
+    q.param(1, 1, 0, 10);
+    p = q.build();
+    TEST_ASSERT_EQUAL(VM_ERR_PARAM, vm.load(p.data(), p.size()));
+    
+    // Random damage under a valid CRC: loads only if every operand checks out
+    uint32_t seed = 12345;
+    int loaded = 0;
+    for (int trial = 0; trial < 5000; trial++) {
+        Bytes d = good;
+        seed = seed * 1103515245 + 12345;
+        d[VM_HEADER_LEN + 4 + (seed >> 8) % (d.size() - VM_HEADER_LEN - 8)] = seed >> 24;
+        reseal(d);
+        if (vm.load(d.data(), d.size()) == VM_OK) {
+            loaded++;
+            vm.update(inputs);      // Must stay inside its arrays (ASan build)
+        }
+    }
+    printf("  5000 damaged programs under a valid CRC: %d passed the verifier and ran\n", loaded);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SEMANTICS
+// ───────────────────────────────────────────────────────────────────────────
+
+// cell[0..n) = results of r0 op r1 for int operands x, y
+static void intOps(int32_t x, int32_t y, int32_t out[7]) {
+    Asm a;
+    a.consts = {(uint32_t)x, (uint32_t)y};
+    a.cells.assign(7, 0);
+    a.opBC(VM_LDK, 0, 0);
+    a.opBC(VM_LDK, 1, 1);
+    const uint8_t ops[] = {VM_ADDI, VM_SUBI, VM_MULI, VM_DIVI, VM_MODI, VM_MINI, VM_LTI};
+    for (uint8_t i = 0; i < 7; i++) {
+        a.op(ops[i], 2, 0, 1);
+        a.op(VM_STS, i, 2);
+    }
+    a.op(VM_RET);
+    Bytes p = a.build();
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(p.data(), p.size()));
+    TEST_ASSERT_TRUE(vm.update(inputs));
+    for (uint8_t i = 0; i < 7; i++) out[i] = vm.getCell(i).i;
+}
+
+void test_arithmetic_semantics() {
+    int32_t r[7];
+    intOps(17, 5, r);
+    int32_t expect[7] = {22, 12, 85, 3, 2, 5, 0};
+    TEST_ASSERT_EQUAL_MEMORY(expect, r, sizeof(r));
+    
+    intOps(INT32_MAX, 1, r);
+    TEST_ASSERT_EQUAL(INT32_MIN, r[0]);
+    intOps(INT32_MIN, -1, r);
+    TEST_ASSERT_EQUAL(INT32_MIN, r[3]);   // Wraps instead of trapping
+    TEST_ASSERT_EQUAL(0, r[4]);
+    intOps(-7, 0, r);
+    TEST_ASSERT_EQUAL(0, r[3]);
+    TEST_ASSERT_EQUAL(0, r[4]);
+    TEST_ASSERT_EQUAL(1, r[6]);
+    
+    // Float → int truncates, saturates, NaN → 0; telemetry() reports the
+    // outputs, keeping ones its entry does not set
+    Asm f;
+    f.consts = {floatBits(-2.75f), floatBits(3e9f), floatBits(NAN)};
+    f.cells.assign(3, 0);
+    for (uint8_t i = 0; i < 3; i++) {
+        f.opBC(VM_LDK, 0, i);
+        f.op(VM_F2I, 1, 0);
+        f.op(VM_STS, i, 1);
+    }
+    f.op(VM_OUT, VM_OUT_STATUS, 1);
+    f.op(VM_RET);
+    f.telemetryEntry = f.code.size();
+    f.op(VM_LDS, 0, 0);
+    f.op(VM_OUT, VM_OUT_VALUE, 0);
+    f.op(VM_RET);
+    Bytes p = f.build();
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(p.data(), p.size()));
+    TEST_ASSERT_TRUE(vm.update(inputs));
+    TEST_ASSERT_EQUAL(-2, vm.getCell(0).i);
+    TEST_ASSERT_EQUAL(INT32_MAX, vm.getCell(1).i);
+    TEST_ASSERT_EQUAL(0, vm.getCell(2).i);
+    int32_t value = 1, status = 1;
+    TEST_ASSERT_TRUE(vm.telemetry(value, status));
+    TEST_ASSERT_EQUAL(-2, value);
+    TEST_ASSERT_EQUAL(0, status);         // From update()
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// STEP LIMIT, PARAMS, RELOAD
+// ───────────────────────────────────────────────────────────────────────────
+
+static int syscalls = 0;
+
+static void countSyscall(VmSyscall, VmCell, void*) {
+    syscalls++;
+}
+
+void test_step_limit_stops_module() {
+    // while (1) { log(r0) }
+    Asm a;
+    a.op(VM_SYS, VM_SYS_LOG_INT, 0);
+    a.opBC(VM_JMP, 0, -2);
+    a.op(VM_RET);
+    Bytes p = a.build();
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(p.data(), p.size()));
+    syscalls = 0;
+    vm.setSyscall(countSyscall, nullptr);
+    
+    TEST_ASSERT_FALSE(vm.update(inputs));
+    TEST_ASSERT_EQUAL(VM_ERR_STEPS, vm.getFault());
+    TEST_ASSERT_FALSE(vm.isRunning());
+    TEST_ASSERT_TRUE(vm.getLastSteps() <= VM_STEP_LIMIT + 2);
+    TEST_ASSERT_EQUAL(VM_STEP_LIMIT / 2 + 1, syscalls);
+    
+    // Stays stopped until a program is loaded again
+    TEST_ASSERT_FALSE(vm.update(inputs));
+    TEST_ASSERT_EQUAL(VM_STEP_LIMIT / 2 + 1, syscalls);
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(p.data(), p.size()));
+    TEST_ASSERT_TRUE(vm.isRunning());
+}
+
+void test_params_and_reload() {
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(HELMET_VM_PROGRAM, sizeof(HELMET_VM_PROGRAM)));
+    TEST_ASSERT_EQUAL_STRING("helmet_vm", vm.getProgram().name);
+    TEST_ASSERT_EQUAL(1, vm.getProgram().context);      // CTX_HELMET
+    
+    int32_t v = 0;
+    TEST_ASSERT_TRUE(vm.getParam(2, v));
+    TEST_ASSERT_EQUAL(4000, v);
+    TEST_ASSERT_TRUE(vm.setParam(2, 6000));
+    TEST_ASSERT_FALSE(vm.setParam(2, 999));
+    TEST_ASSERT_FALSE(vm.setParam(2, 16001));
+    TEST_ASSERT_FALSE(vm.setParam(9, 100));
+    TEST_ASSERT_TRUE(vm.getParam(2, v));
+    TEST_ASSERT_EQUAL(6000, v);
+    
+    // Swapping in another program and back starts from the defaults
+    Asm a;
+    a.op(VM_RET);
+    Bytes other = a.build("other");
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(other.data(), other.size()));
+    TEST_ASSERT_FALSE(vm.getParam(2, v));
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(HELMET_VM_PROGRAM, sizeof(HELMET_VM_PROGRAM)));
+    TEST_ASSERT_TRUE(vm.getParam(2, v));
+    TEST_ASSERT_EQUAL(4000, v);
+    
+    vm.unload();
+    TEST_ASSERT_FALSE(vm.update(inputs));
+    TEST_ASSERT_FALSE(vm.getParam(2, v));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// HELMET: COMPILED SCRIPT VS NATIVE
+// ───────────────────────────────────────────────────────────────────────────
+
+// HelmetModule::update / getTelemetry without Arduino (thresholds in mg as
+// the params are, so both sides compare the same floats)
+struct NativeHelmet {
+    int32_t freefallMg = 400, impactMg = 4000, windowMs = 1000;
+    bool inFreeFall = false, fallDetected = false;
+    int32_t freeFallStart = 0;
+    float lastImpact = 0;
+    int alerts = 0;
+    
+    void update(float ax, float ay, float az, int32_t now) {
+        float g = sqrtf(ax * ax + ay * ay + az * az) / 9.81f;
+        if (!inFreeFall) {
+            if (g * 1000.0f < (float)freefallMg) {
+                inFreeFall = true;
+                freeFallStart = now;
+            }
+        } else if (g * 1000.0f > (float)impactMg) {
+            if (now - freeFallStart < windowMs) {
+                fallDetected = true;
+                lastImpact = g;
+                alerts++;
+            }
+            inFreeFall = false;
+        } else if (now - freeFallStart > windowMs) {
+            inFreeFall = false;
+        }
+    }
+    
+    int32_t value() const { return (int32_t)(lastImpact * 100.0f); }
+    int32_t status() const { return fallDetected ? 3 : 0; }
+};
+
+static int alerts = 0;
+
+static void helmetSyscall(VmSyscall id, VmCell, void*) {
+    if (id == VM_SYS_ALERT) alerts++;
+}
+
+// 50 Hz accelerometer trace: standing, free-falls (some ending in an impact
+// inside the window, some after it) and bumps that are not falls
+static void helmetSample(uint32_t i, float& ax, float& ay, float& az) {
+    uint32_t phase = i % 500;
+    float noise = (float)((i * 2654435761u) >> 24) / 255.0f - 0.5f;
+    ax = 0.3f * noise;
+    ay = 0.2f * noise;
+    az = 9.81f + noise;
+    if (phase >= 100 && phase < 100 + (i / 500) % 70) az = 0.5f + noise * 0.2f;   // Free-fall
+    else if (phase == 100 + (i / 500) % 70) az = 45.0f + 10 * noise;               // Impact
+    else if (phase == 300) ax = 50.0f;                                             // Bump
+}
+
+void test_helmet_script_matches_native() {
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(HELMET_VM_PROGRAM, sizeof(HELMET_VM_PROGRAM)));
+    alerts = 0;
+    vm.setSyscall(helmetSyscall, nullptr);
+    NativeHelmet native;
+    
+    int falls = 0;
+    for (uint32_t i = 0; i < 50000; i++) {
+        float ax, ay, az;
+        helmetSample(i, ax, ay, az);
+        int32_t now = (int32_t)(i * 20);
+        inputs[VM_IN_AX].f = ax;
+        inputs[VM_IN_AY].f = ay;
+        inputs[VM_IN_AZ].f = az;
+        inputs[VM_IN_NOW].i = now;
+        native.update(ax, ay, az, now);
+        TEST_ASSERT_TRUE(vm.update(inputs));
+        
+        if (i % 97 == 0) {
+            int32_t value, status;
+            TEST_ASSERT_TRUE(vm.telemetry(value, status));
+            TEST_ASSERT_EQUAL(native.value(), value);
+            TEST_ASSERT_EQUAL(native.status(), status);
+        }
+        if (i == 25000) {
+            // Retuned mid-run over PARAM_SET
+            TEST_ASSERT_TRUE(vm.setParam(3, 600));
+            native.windowMs = 600;
+        }
+        falls = native.alerts;
+    }
+    TEST_ASSERT_EQUAL(native.alerts, alerts);
+    TEST_ASSERT_TRUE(falls > 20);
+    TEST_ASSERT_TRUE(vm.getMaxSteps() < 80);
+    printf("  50000 samples: %d falls, both sides agree; at most %u instructions per update\n",
+           falls, (unsigned)vm.getMaxSteps());
+}
+
+void test_interpreter_benchmark() {
+    TEST_ASSERT_EQUAL(VM_OK, vm.load(HELMET_VM_PROGRAM, sizeof(HELMET_VM_PROGRAM)));
+    vm.setSyscall(helmetSyscall, nullptr);
+    const uint32_t runs = 2000000;
+    static float trace[1024][3];
+    for (uint32_t i = 0; i < 1024; i++) helmetSample(i, trace[i][0], trace[i][1], trace[i][2]);
+    
+    NativeHelmet native;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runs; i++) {
+        const float* s = trace[i & 1023];
+        native.update(s[0], s[1], s[2], (int32_t)(i * 20));
+    }
+    double nativeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+    
+    uint64_t steps = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runs; i++) {
+        const float* s = trace[i & 1023];
+        inputs[VM_IN_AX].f = s[0];
+        inputs[VM_IN_AY].f = s[1];
+        inputs[VM_IN_AZ].f = s[2];
+        inputs[VM_IN_NOW].i = (int32_t)(i * 20);
+        vm.update(inputs);
+        steps += vm.getLastSteps();
+    }
+    double vmNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+    
+    printf("[BENCH] helmet update: native %.1f ns, VM %.1f ns (%.1f instructions, %.2f ns each) "
+           "→ VM runs at %.0f%% of native (%d alerts)\n",
+           nativeNs, vmNs, (double)steps / runs, vmNs * runs / steps, 100.0 * nativeNs / vmNs,
+           native.alerts);
+    TEST_ASSERT_TRUE(vm.isRunning());
+    // Loose: at 50 Hz even 10 µs per update is 0.05% of a core
+    TEST_ASSERT_TRUE(vmNs < 10000);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_verifier_rejects_bad_programs);
+    RUN_TEST(test_arithmetic_semantics);
+    RUN_TEST(test_step_limit_stops_module);
+    RUN_TEST(test_params_and_reload);
+    RUN_TEST(test_helmet_script_matches_native);
+    RUN_TEST(test_interpreter_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,429 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA DELTA + HEATSHRINK - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * DeltaPatcher, HeatshrinkDecoder and the OtaDecoder chain against a 256 KB
+ * "running image":
+ * - The new image is the old one with a module swapped in the middle and
+ *   every pointer behind it moved (what a mode switch does to firmware.bin)
+ * - Patches are built from that edit script, compressed with a plain LZSS
+ *   encoder writing the heatshrink bit format
+ * - Every input chunking and output buffer size gives the same image
+ * - Wrong base, truncated and corrupted patches fail without reading
+ *   outside the base or writing past the announced size
+ * - [BENCH] decoder throughput per encoding in the OTAHandler block loop,
+ *   on a code-like image (the test images above are random: incompressible)
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+#include "ota_decoder.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RUNNING IMAGE
+// ───────────────────────────────────────────────────────────────────────────
+
+static Bytes oldImage;
+static uint8_t oldSha[32];          // Any 32 bytes: the patcher only compares them
+static bool outOfRange;
+
+static bool readOld(uint32_t offset, uint8_t* out, size_t len) {
+    if (offset + len > oldImage.size()) {
+        outOfRange = true;
+        return false;
+    }
+    memcpy(out, &oldImage[offset], len);
+    return true;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// PATCH + LZSS BUILDERS
+// ───────────────────────────────────────────────────────────────────────────
+
+struct PatchBuilder {
+    Bytes out;
+    
+    void varint(uint32_t v) {
+        do {
+            uint8_t b = v & 0x7F;
+            v >>= 7;
+            out.push_back(v ? b | 0x80 : b);
+        } while (v);
+    }
+    
+    void header(uint32_t imageSize) {
+        out.insert(out.end(), DELTA_MAGIC, DELTA_MAGIC + 4);
+        out.push_back(DELTA_VERSION);
+        for (int i = 0; i < 4; i++) out.push_back((imageSize >> (8 * i)) & 0xFF);
+        for (int i = 0; i < 4; i++) out.push_back((oldImage.size() >> (8 * i)) & 0xFF);
+        out.insert(out.end(), oldSha, oldSha + 32);
+    }
+    
+    void op(uint8_t code, uint32_t n) {
+        out.push_back(code);
+        varint(n);
+    }
+    
+    void bytes(const uint8_t* p, size_t n) {
+        out.insert(out.end(), p, p + n);
+    }
+    
+    void seek(int32_t delta) {
+        op(DELTA_OP_SEEK, delta >= 0 ? (uint32_t)delta * 2 : (uint32_t)(-delta) * 2 - 1);
+    }
+};
+
+// Greedy LZSS in the heatshrink bit format (brute force window search)
+static Bytes lzss(const Bytes& in) {
+    const int W = OTA_HS_WINDOW_BITS, L = OTA_HS_LOOKAHEAD_BITS;
+    const size_t window = 1u << W, maxLen = 1u << L;
+    Bytes out;
+    uint32_t acc = 0;
+    int bits = 0;
+    auto put = [&](uint32_t v, int n) {
+        for (int i = n - 1; i >= 0; i--) {
+            acc = (acc << 1) | ((v >> i) & 1);
+            if (++bits == 8) {
+                out.push_back(acc & 0xFF);
+                bits = 0;
+            }
+        }
+    };
+    
+    size_t i = 0;
+    while (i < in.size()) {
+        size_t best = 0, bestOff = 0;
+        for (size_t off = 1; off <= window && off <= i; off++) {
+            size_t len = 0;
+            while (len < maxLen && i + len < in.size() && in[i + len - off] == in[i + len]) len++;
+            if (len > best) {
+                best = len;
+                bestOff = off;
+            }
+        }
+        if (best >= 2) {
+            put(0, 1);
+            put(bestOff - 1, W);
+            put(best - 1, L);
+            i += best;
+        } else {
+            put(1, 1);
+            put(in[i], 8);
+            i++;
+        }
+    }
+    if (bits) out.push_back((acc << (8 - bits)) & 0xFF);
+    return out;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TEST IMAGES
+// ───────────────────────────────────────────────────────────────────────────
+
+static const uint32_t MODULE_AT = 100000;
+static const uint32_t OLD_MODULE = 3000;
+static const uint32_t NEW_MODULE = 4200;
+
+static Bytes newImage;
+static Bytes rawPatch;
+
+// Code words, a literal pool word every 64 bytes pointing into the image,
+// some zero padding. Pointers behind the module move with it
+static void makeImages() {
+    rngState = 0x2468ACE1;
+    const uint32_t core = 256 * 1024 - OLD_MODULE;
+    Bytes base(core);
+    for (auto& b : base) b = rnd() & 0xFF;
+    for (int k = 0; k < 40; k++) {
+        uint32_t p = rnd() % (core - 300);
+        memset(&base[p], 0, 64 + rnd() % 200);
+    }
+    Bytes oldModule(OLD_MODULE), newModule(NEW_MODULE);
+    for (auto& b : oldModule) b = rnd() & 0xFF;
+    for (auto& b : newModule) b = rnd() & 0xFF;
+    
+    auto link = [&](const Bytes& module) {
+        Bytes img;
+        img.reserve(base.size() + module.size());
+        img.insert(img.end(), base.begin(), base.begin() + MODULE_AT);
+        img.insert(img.end(), module.begin(), module.end());
+        img.insert(img.end(), base.begin() + MODULE_AT, base.end());
+        for (uint32_t p = 32; p + 4 <= img.size(); p += 64) {
+            if (p >= MODULE_AT && p < MODULE_AT + module.size()) continue;
+            uint32_t target = (p * 7919) % 200000;
+            if (target >= MODULE_AT) target += module.size();
+            uint32_t word = 0x400D0000 + target;
+            memcpy(&img[p], &word, 4);
+        }
+        return img;
+    };
+    oldImage = link(oldModule);
+    newImage = link(newModule);
+    for (int i = 0; i < 32; i++) oldSha[i] = rnd() & 0xFF;
+    
+    // Patch from the edit script: aligned bytes as COPY / ADD, the module as INSERT
+    PatchBuilder pb;
+    pb.header(newImage.size());
+    auto aligned = [&](uint32_t n, uint32_t at, uint32_t from) {
+        uint32_t k = 0;
+        while (k < n) {
+            uint32_t e = k;
+            while (e < n && newImage[at + e] == oldImage[from + e]) e++;
+            if (e > k) {
+                pb.op(DELTA_OP_COPY, e - k);
+                k = e;
+                continue;
+            }
+            while (e < n && newImage[at + e] != oldImage[from + e]) e++;
+            pb.op(DELTA_OP_ADD, e - k);
+            for (uint32_t i = k; i < e; i++) pb.out.push_back(newImage[at + i] - oldImage[from + i]);
+            k = e;
+        }
+    };
+    aligned(MODULE_AT, 0, 0);
+    pb.op(DELTA_OP_INSERT, NEW_MODULE);
+    pb.bytes(&newImage[MODULE_AT], NEW_MODULE);
+    pb.seek(OLD_MODULE);
+    aligned(newImage.size() - MODULE_AT - NEW_MODULE, MODULE_AT + NEW_MODULE, MODULE_AT + OLD_MODULE);
+    pb.out.push_back(DELTA_OP_END);
+    rawPatch = pb.out;
+}
+
+// Instruction-like words from a small skewed vocabulary with random operands,
+// string tables and padding: compresses roughly like an ESP32 image
+static Bytes codeImage(size_t size) {
+    static const char* strings[] = { "[OTA] Download failed (HTTP %d)\n", "[BLE] Connected\n",
+                                     "helmet", "impact_mg", "[IMU] Calibration done\n" };
+    uint8_t vocab[64][3];
+    for (auto& v : vocab) for (auto& b : v) b = rnd() & 0xFF;
+    Bytes img;
+    img.reserve(size);
+    while (img.size() < size) {
+        uint32_t r = rnd();
+        if (r % 500 == 0) {
+            img.insert(img.end(), 16 + r % 48, 0);
+        } else if (r % 200 == 1) {
+            const char* str = strings[(r >> 8) % 5];
+            img.insert(img.end(), str, str + strlen(str) + 1);
+        } else {
+            uint32_t k = (r >> 8) % 64;
+            k = k * k / 64;                         // Few opcodes dominate
+            img.insert(img.end(), vocab[k], vocab[k] + 3);
+            if ((r >> 16) % 10 < 4) img.back() = (r >> 24) & 0xFF;
+        }
+    }
+    img.resize(size);
+    return img;
+}
+
+// Feeds `input` in chunks of 1..maxIn bytes into maxOut byte buffers
+static Bytes decode(OtaDecoder& dec, const Bytes& input, size_t maxIn, size_t maxOut) {
+    Bytes image;
+    std::vector<uint8_t> out(maxOut);
+    size_t pos = 0;
+    int idle = 0;
+    while (idle < 3 && !dec.failed()) {
+        size_t chunk = pos < input.size() ? 1 + rnd() % maxIn : 0;
+        if (chunk > input.size() - pos) chunk = input.size() - pos;
+        const uint8_t* in = input.data() + pos;
+        size_t inLen = chunk;
+        size_t n;
+        do {
+            size_t cap = 1 + rnd() % maxOut;
+            n = dec.run(&in, &inLen, out.data(), cap);
+            image.insert(image.end(), out.begin(), out.begin() + n);
+        } while (n > 0);
+        pos += chunk - inLen;
+        idle = (chunk == 0) ? idle + 1 : 0;
+    }
+    return image;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+static OtaDecoder decoder;
+
+void setUp() {
+    outOfRange = false;
+}
+
+void tearDown() {}
+
+void test_patch_any_chunking() {
+    const size_t chunks[][2] = { { 1, 1 }, { 7, 33 }, { 300, 4096 }, { 1 << 20, 4096 } };
+    for (auto& c : chunks) {
+        outOfRange = false;
+        decoder.begin(OTA_ENCODING_DELTA, readOld, oldSha, oldImage.size());
+        Bytes img = decode(decoder, rawPatch, c[0], c[1]);
+        TEST_ASSERT_FALSE(decoder.failed());
+        TEST_ASSERT_FALSE(outOfRange);
+        TEST_ASSERT_EQUAL(newImage.size(), img.size());
+        TEST_ASSERT_TRUE(img == newImage);
+    }
+}
+
+void test_heatshrink_round_trip() {
+    // Runs (copies overlapping their own output), text, noise
+    Bytes data;
+    for (int i = 0; i < 2000; i++) data.push_back(0);
+    const char* text = "UAD adaptive shell: helmet, bicycle, vehicle, asset. ";
+    for (int r = 0; r < 200; r++) data.insert(data.end(), text, text + strlen(text));
+    for (int i = 0; i < 5000; i++) data.push_back(rnd() & 0xFF);
+    for (int i = 0; i < 3000; i++) data.push_back(i % 3);
+    
+    Bytes packed = lzss(data);
+    printf("  heatshrink W%d L%d: %u → %u bytes\n", OTA_HS_WINDOW_BITS, OTA_HS_LOOKAHEAD_BITS,
+           (unsigned)data.size(), (unsigned)packed.size());
+    for (size_t maxIn : { (size_t)1, (size_t)5, (size_t)4096 }) {
+        decoder.begin(OTA_ENCODING_HEATSHRINK);
+        Bytes out = decode(decoder, packed, maxIn, 97);
+        TEST_ASSERT_EQUAL(data.size(), out.size());
+        TEST_ASSERT_TRUE(out == data);
+    }
+}
+
+void test_compressed_patch_chain() {
+    Bytes packed = lzss(rawPatch);
+    printf("  image %u bytes, patch %u (%.1f%%), compressed %u (%.1f%%)\n",
+           (unsigned)newImage.size(), (unsigned)rawPatch.size(), rawPatch.size() * 100.0 / newImage.size(),
+           (unsigned)packed.size(), packed.size() * 100.0 / newImage.size());
+    TEST_ASSERT_TRUE(rawPatch.size() * 4 < newImage.size());
+    TEST_ASSERT_TRUE(packed.size() < rawPatch.size());
+    
+    for (size_t maxIn : { (size_t)1, (size_t)244, (size_t)4096 }) {
+        outOfRange = false;
+        decoder.begin(OTA_ENCODING_DELTA | OTA_ENCODING_HEATSHRINK, readOld, oldSha, oldImage.size());
+        Bytes img = decode(decoder, packed, maxIn, 4096);
+        TEST_ASSERT_FALSE(decoder.failed());
+        TEST_ASSERT_FALSE(outOfRange);
+        TEST_ASSERT_TRUE(img == newImage);
+    }
+}
+
+void test_rejects_wrong_base_and_truncation() {
+    uint8_t otherSha[32];
+    memcpy(otherSha, oldSha, 32);
+    otherSha[31] ^= 1;
+    decoder.begin(OTA_ENCODING_DELTA, readOld, otherSha, oldImage.size());
+    Bytes img = decode(decoder, rawPatch, 4096, 4096);
+    TEST_ASSERT_TRUE(decoder.failed());
+    TEST_ASSERT_EQUAL(DELTA_BASE_MISMATCH, decoder.getError());
+    TEST_ASSERT_EQUAL(0, img.size());
+    
+    decoder.begin(OTA_ENCODING_DELTA, readOld, oldSha, oldImage.size() + 1);
+    decode(decoder, rawPatch, 4096, 4096);
+    TEST_ASSERT_EQUAL(DELTA_BASE_MISMATCH, decoder.getError());
+    
+    // Cut short: stops with less than the image, no END seen
+    Bytes cut(rawPatch.begin(), rawPatch.begin() + rawPatch.size() / 2);
+    decoder.begin(OTA_ENCODING_DELTA, readOld, oldSha, oldImage.size());
+    img = decode(decoder, cut, 4096, 4096);
+    TEST_ASSERT_FALSE(decoder.failed());
+    TEST_ASSERT_TRUE(img.size() < newImage.size());
+}
+
+void test_corrupt_patches_stay_in_bounds() {
+    int failed = 0, wrong = 0;
+    for (int trial = 0; trial < 3000; trial++) {
+        Bytes bad = rawPatch;
+        int flips = 1 + rnd() % 4;
+        for (int f = 0; f < flips; f++) {
+            size_t at = DELTA_HEADER_LEN + rnd() % (bad.size() - DELTA_HEADER_LEN);
+            bad[at] = rnd() & 0xFF;
+        }
+        outOfRange = false;
+        decoder.begin(OTA_ENCODING_DELTA, readOld, oldSha, oldImage.size());
+        Bytes img = decode(decoder, bad, 4096, 4096);
+        TEST_ASSERT_FALSE(outOfRange);
+        TEST_ASSERT_TRUE(img.size() <= newImage.size());
+        if (decoder.failed()) failed++;
+        else if (img != newImage) wrong++;     // Caught by the SHA-256 in OtaWriter
+    }
+    printf("  3000 corrupted patches: %d rejected by the patcher, %d left to the hash\n", failed, wrong);
+}
+
+// Image MB per second through OtaDecoder, fed and drained like OTAHandler
+// (0 if an image came out short)
+static double throughput(uint8_t enc, const Bytes& input, size_t imageSize) {
+    static uint8_t block[OTA_BLOCK_SIZE];
+    const int runs = 20;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; r++) {
+        decoder.begin(enc, readOld, oldSha, oldImage.size());
+        const uint8_t* in = input.data();
+        size_t left = input.size();
+        size_t produced = 0;
+        while (produced < imageSize) {
+            size_t inLen = left < OTA_ENCODED_INPUT ? left : OTA_ENCODED_INPUT;
+            const uint8_t* p = in;
+            size_t n = decoder.run(&p, &inLen, block, sizeof(block));
+            left -= p - in;
+            in = p;
+            produced += n;
+            if (n == 0 && p == in && left == 0) break;
+        }
+        total += produced;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total == imageSize * runs ? total / secs / (1024 * 1024) : 0;
+}
+
+void test_decoder_throughput() {
+    Bytes image = codeImage(256 * 1024);
+    Bytes packed = lzss(image);
+    Bytes patchPacked = lzss(rawPatch);
+    
+    decoder.begin(OTA_ENCODING_HEATSHRINK);
+    TEST_ASSERT_TRUE(decode(decoder, packed, 4096, 4096) == image);
+    
+    double raw = throughput(OTA_ENCODING_RAW, image, image.size());
+    double hs = throughput(OTA_ENCODING_HEATSHRINK, packed, image.size());
+    double delta = throughput(OTA_ENCODING_DELTA, rawPatch, newImage.size());
+    double chain = throughput(OTA_ENCODING_DELTA | OTA_ENCODING_HEATSHRINK, patchPacked, newImage.size());
+    printf("[BENCH] decoder RAM %u bytes (budget %u)\n", (unsigned)sizeof(OtaDecoder), OTA_DECODER_RAM_MAX);
+    printf("[BENCH] heatshrink W%d L%d on a code-like image: %u → %u bytes (%.1f%%)\n",
+           OTA_HS_WINDOW_BITS, OTA_HS_LOOKAHEAD_BITS, (unsigned)image.size(), (unsigned)packed.size(),
+           packed.size() * 100.0 / image.size());
+    printf("[BENCH] image MB/s on the host: raw %.0f, heatshrink %.0f, delta %.0f, delta+heatshrink %.0f\n",
+           raw, hs, delta, chain);
+    TEST_ASSERT_TRUE(packed.size() * 10 < image.size() * 8);
+    // Loose floor (unoptimized and sanitizer builds): a regression to
+    // per-byte rescans would land far below it
+    TEST_ASSERT_TRUE(raw > 4);
+    TEST_ASSERT_TRUE(hs > 4);
+    TEST_ASSERT_TRUE(delta > 4);
+    TEST_ASSERT_TRUE(chain > 4);
+}
+
+int main() {
+    makeImages();
+    UNITY_BEGIN();
+    RUN_TEST(test_patch_any_chunking);
+    RUN_TEST(test_heatshrink_round_trip);
+    RUN_TEST(test_compressed_patch_chain);
+    RUN_TEST(test_rejects_wrong_base_and_truncation);
+    RUN_TEST(test_corrupt_patches_stay_in_bounds);
+    RUN_TEST(test_decoder_throughput);
+    return UNITY_END();
+}
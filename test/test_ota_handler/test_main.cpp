@@ -0,0 +1,301 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    OTA HANDLER - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * The WiFi download path on the test/stubs platform:
+ * - Response header parsing (hash / signature hex, encoding names)
+ * - OtaWriter's gate before Update.end(): a wrong hash, a missing or a
+ *   wrong signature, a short image never become the boot partition
+ * - The double-buffered pipeline, with the flash task on its own thread:
+ *   a socket that returns odd chunks and stalls still lands the image
+ *   byte for byte in whole blocks; failures on either side stop both
+ *   tasks and free the buffers (run under ASan to check)
+ * 
+ * The build has a signing key, so every image must be signed. The stub
+ * pk verifies a signature whose bytes are the image's SHA-256
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#define OTA_SIGNING_PUBKEY "stub key"
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "ota_handler.h"
+
+void setUp() {
+    Update.reset();
+    stubHttp.reset();
+    stubRestarts = 0;
+    WiFi.sleep = true;
+}
+
+void tearDown() {}
+
+static std::vector<uint8_t> makeImage(size_t size) {
+    std::vector<uint8_t> image(size);
+    for (size_t i = 0; i < size; i++) image[i] = (uint8_t)(i * 31 + (i >> 9));
+    return image;
+}
+
+static void sha256(const std::vector<uint8_t>& data, uint8_t* out) {
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, data.data(), data.size());
+    mbedtls_sha256_finish(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+}
+
+static std::string hex(const uint8_t* data, size_t len) {
+    std::string s;
+    char b[3];
+    for (size_t i = 0; i < len; i++) {
+        snprintf(b, sizeof(b), "%02x", data[i]);
+        s += b;
+    }
+    return s;
+}
+
+// Backend response for image: raw, hashed and signed
+static void serve(const std::vector<uint8_t>& image) {
+    uint8_t sha[OTA_SHA256_LEN];
+    sha256(image, sha);
+    stubHttp.stream.load(image);
+    stubHttp.headers["X-Image-SHA256"] = hex(sha, sizeof(sha));
+    stubHttp.headers["X-Image-Signature"] = hex(sha, sizeof(sha));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RESPONSE HEADERS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_parse_hex_either_case() {
+    uint8_t out[4] = {};
+    TEST_ASSERT_EQUAL(3, OTAHandler::parseHex("00fF7a", out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x7A, out[2]);
+    
+    uint8_t sha[OTA_SHA256_LEN] = {0x12, 0xAB};
+    uint8_t back[OTA_SHA256_LEN];
+    TEST_ASSERT_EQUAL(OTA_SHA256_LEN, OTAHandler::parseHex(OTAHandler::toHex(sha, sizeof(sha)), back, sizeof(back)));
+    TEST_ASSERT_EQUAL_MEMORY(sha, back, OTA_SHA256_LEN);
+}
+
+void test_parse_hex_rejects_malformed() {
+    uint8_t out[2];
+    TEST_ASSERT_EQUAL(0, OTAHandler::parseHex("", out, sizeof(out)));        // Header missing
+    TEST_ASSERT_EQUAL(0, OTAHandler::parseHex("abc", out, sizeof(out)));     // Odd length
+    TEST_ASSERT_EQUAL(0, OTAHandler::parseHex("0g", out, sizeof(out)));      // Not hex
+    TEST_ASSERT_EQUAL(0, OTAHandler::parseHex("a b ", out, sizeof(out)));
+    TEST_ASSERT_EQUAL(0, OTAHandler::parseHex("010203", out, sizeof(out)));  // Too long
+    TEST_ASSERT_EQUAL(2, OTAHandler::parseHex("0102", out, sizeof(out)));
+}
+
+void test_parse_encoding_names() {
+    TEST_ASSERT_EQUAL(OTA_ENCODING_RAW, OTAHandler::parseEncoding(""));
+    TEST_ASSERT_EQUAL(OTA_ENCODING_RAW, OTAHandler::parseEncoding("raw"));
+    TEST_ASSERT_EQUAL(OTA_ENCODING_DELTA, OTAHandler::parseEncoding("delta"));
+    TEST_ASSERT_EQUAL(OTA_ENCODING_HEATSHRINK, OTAHandler::parseEncoding("heatshrink"));
+    TEST_ASSERT_EQUAL(OTA_ENCODING_DELTA | OTA_ENCODING_HEATSHRINK,
+                      OTAHandler::parseEncoding("delta+heatshrink"));
+    TEST_ASSERT_EQUAL(-1, OTAHandler::parseEncoding("gzip"));
+    TEST_ASSERT_EQUAL(-1, OTAHandler::parseEncoding("heatshrink+delta"));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// WRITER GATE
+// ───────────────────────────────────────────────────────────────────────────
+
+// Writes the first `written` bytes of image in blocks, returns finish()
+static OtaResult writeAndFinish(const std::vector<uint8_t>& image, size_t written,
+                                const uint8_t* sha, const uint8_t* sig, size_t sig_len) {
+    OtaWriter writer;
+    if (!writer.begin(image.size())) return OTA_RESULT_FLASH_ERROR;
+    for (size_t pos = 0; pos < written; pos += OTA_BLOCK_SIZE) {
+        size_t n = written - pos < OTA_BLOCK_SIZE ? written - pos : OTA_BLOCK_SIZE;
+        if (!writer.write(image.data() + pos, n)) return OTA_RESULT_FLASH_ERROR;
+    }
+    return writer.finish(sha, sig, sig_len);
+}
+
+void test_writer_ends_a_verified_image() {
+    std::vector<uint8_t> image = makeImage(10000);
+    uint8_t sha[OTA_SHA256_LEN];
+    sha256(image, sha);
+    
+    TEST_ASSERT_EQUAL(OTA_RESULT_OK, writeAndFinish(image, image.size(), sha, sha, sizeof(sha)));
+    TEST_ASSERT_TRUE(Update.ended);
+    TEST_ASSERT_FALSE(Update.aborted);
+    TEST_ASSERT_TRUE(Update.image == image);
+}
+
+void test_writer_refuses_wrong_hash() {
+    std::vector<uint8_t> image = makeImage(10000);
+    uint8_t sha[OTA_SHA256_LEN];
+    sha256(image, sha);
+    sha[5] ^= 1;
+    
+    TEST_ASSERT_EQUAL(OTA_RESULT_HASH_MISMATCH, writeAndFinish(image, image.size(), sha, sha, sizeof(sha)));
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+}
+
+void test_writer_refuses_missing_or_wrong_signature() {
+    std::vector<uint8_t> image = makeImage(10000);
+    uint8_t sha[OTA_SHA256_LEN];
+    sha256(image, sha);
+    TEST_ASSERT_TRUE(OtaWriter::signatureRequired());
+    
+    TEST_ASSERT_EQUAL(OTA_RESULT_BAD_SIGNATURE, writeAndFinish(image, image.size(), sha, nullptr, 0));
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+    
+    Update.reset();
+    uint8_t sig[OTA_SHA256_LEN];
+    memcpy(sig, sha, sizeof(sig));
+    sig[0] ^= 0x80;
+    TEST_ASSERT_EQUAL(OTA_RESULT_BAD_SIGNATURE, writeAndFinish(image, image.size(), sha, sig, sizeof(sig)));
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+}
+
+void test_writer_refuses_short_image() {
+    std::vector<uint8_t> image = makeImage(10000);
+    uint8_t sha[OTA_SHA256_LEN];
+    sha256(image, sha);
+    
+    TEST_ASSERT_EQUAL(OTA_RESULT_FLASH_ERROR, writeAndFinish(image, OTA_BLOCK_SIZE, sha, sha, sizeof(sha)));
+    TEST_ASSERT_FALSE(Update.ended);
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// DOWNLOAD PIPELINE
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_download_flashes_whole_blocks_on_the_flash_task() {
+    std::vector<uint8_t> image = makeImage(5 * OTA_BLOCK_SIZE + 1234);
+    serve(image);
+    stubHttp.stream.chunk = 700;         // Never block aligned
+    stubHttp.stream.emptyEvery = 7;      // Socket behind now and then
+    
+    OTAHandler ota;
+    TEST_ASSERT_TRUE(ota.downloadAndInstallModule("helmet"));
+    
+    TEST_ASSERT_TRUE(Update.image == image);
+    TEST_ASSERT_TRUE(Update.ended);
+    TEST_ASSERT_FALSE(Update.aborted);
+    TEST_ASSERT_EQUAL(6, Update.writes);
+    TEST_ASSERT_EQUAL(OTA_BLOCK_SIZE, Update.maxWrite);
+    TEST_ASSERT_TRUE(Update.writer != std::this_thread::get_id());
+    TEST_ASSERT_EQUAL(1, stubRestarts);
+    TEST_ASSERT_EQUAL(100, ota.getProgress());
+    
+    // Raw download without a base image, modem sleep back on
+    TEST_ASSERT_EQUAL(1, stubHttp.requestHeaders.count("X-Image-Accept"));
+    TEST_ASSERT_EQUAL(0, stubHttp.requestHeaders.count("X-Delta-Base"));
+    TEST_ASSERT_TRUE(WiFi.sleep);
+}
+
+void test_download_refuses_wrong_hash() {
+    std::vector<uint8_t> image = makeImage(3 * OTA_BLOCK_SIZE);
+    serve(image);
+    image[100] ^= 1;                    // Corrupted on the way
+    stubHttp.stream.load(image);
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_EQUAL(3 * OTA_BLOCK_SIZE, Update.image.size());
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_EQUAL(0, stubRestarts);
+}
+
+void test_download_refuses_unsigned_image() {
+    serve(makeImage(2 * OTA_BLOCK_SIZE));
+    stubHttp.headers.erase("X-Image-Signature");
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_EQUAL(0, stubRestarts);
+}
+
+void test_download_without_hash_never_starts() {
+    serve(makeImage(OTA_BLOCK_SIZE));
+    stubHttp.headers.erase("X-Image-SHA256");
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_FALSE(Update.began);
+}
+
+void test_delta_needs_a_running_image() {
+    serve(makeImage(OTA_BLOCK_SIZE));
+    stubHttp.headers["X-Image-Encoding"] = "delta";
+    stubHttp.headers["X-Image-Size"] = "4096";
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_FALSE(Update.began);
+}
+
+void test_flash_failure_stops_the_download() {
+    std::vector<uint8_t> image = makeImage(12 * OTA_BLOCK_SIZE);
+    serve(image);
+    Update.failWriteAt = 2 * OTA_BLOCK_SIZE;
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_EQUAL(0, stubRestarts);
+    
+    // At most the buffers in flight were read past the failed block
+    TEST_ASSERT_LESS_OR_EQUAL((3 + OTA_HTTP_BUFFERS) * OTA_BLOCK_SIZE, stubHttp.stream.pos);
+}
+
+void test_closed_connection_stops_the_flash_task() {
+    std::vector<uint8_t> image = makeImage(4 * OTA_BLOCK_SIZE);
+    serve(image);
+    stubHttp.stream.closeAt = OTA_BLOCK_SIZE + 500;
+    
+    OTAHandler ota;
+    TEST_ASSERT_FALSE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_EQUAL(OTA_BLOCK_SIZE, Update.image.size());
+    TEST_ASSERT_FALSE(Update.ended);
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_TRUE(WiFi.sleep);
+    
+    // The handler is reusable: the next download goes through
+    Update.reset();
+    serve(image);
+    TEST_ASSERT_TRUE(ota.downloadAndInstallModule("helmet"));
+    TEST_ASSERT_TRUE(Update.image == image);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_hex_either_case);
+    RUN_TEST(test_parse_hex_rejects_malformed);
+    RUN_TEST(test_parse_encoding_names);
+    RUN_TEST(test_writer_ends_a_verified_image);
+    RUN_TEST(test_writer_refuses_wrong_hash);
+    RUN_TEST(test_writer_refuses_missing_or_wrong_signature);
+    RUN_TEST(test_writer_refuses_short_image);
+    RUN_TEST(test_download_flashes_whole_blocks_on_the_flash_task);
+    RUN_TEST(test_download_refuses_wrong_hash);
+    RUN_TEST(test_download_refuses_unsigned_image);
+    RUN_TEST(test_download_without_hash_never_starts);
+    RUN_TEST(test_delta_needs_a_running_image);
+    RUN_TEST(test_flash_failure_stops_the_download);
+    RUN_TEST(test_closed_connection_stops_the_flash_task);
+    return UNITY_END();
+}
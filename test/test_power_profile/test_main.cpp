@@ -0,0 +1,130 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    POWER PROFILE - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Residency and average current per PowerMode
+ * (src/managers/power_profile.h):
+ * - Clock and current per mode, alerts never light-sleep
+ * - Averages weight awake and waiting time per mode and overall
+ * - What esp_pm accepted (none / clock scaling / light sleep) sets the
+ *   current while loop() waits
+ * - [SIM] parked tracker (sampling policy wakeups) vs the fixed 10 ms loop
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "managers/power_profile.h"
+#include "managers/sampling_policy.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// MODES
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_mode_clock_and_current() {
+    TEST_ASSERT_EQUAL(POWER_FULL_MHZ, PowerProfile::modeMhz(POWER_FULL));
+    TEST_ASSERT_EQUAL(POWER_IDLE_MHZ, PowerProfile::modeMhz(POWER_IDLE));
+    TEST_ASSERT_EQUAL(POWER_ALERT_MHZ, PowerProfile::modeMhz(POWER_ALERT));
+    TEST_ASSERT_EQUAL_STRING("ALERT", PowerProfile::modeName(POWER_ALERT));
+    
+    TEST_ASSERT_TRUE(PowerProfile::activeMa(240) > PowerProfile::activeMa(80));
+    TEST_ASSERT_TRUE(PowerProfile::activeMa(80) > PowerProfile::activeMa(POWER_MIN_MHZ));
+    
+    TEST_ASSERT_FALSE(PowerProfile::modeLightSleeps(POWER_ALERT));
+    TEST_ASSERT_EQUAL(POWER_LIGHT_SLEEP_ENABLED != 0, PowerProfile::modeLightSleeps(POWER_FULL));
+    
+    // Waiting: light sleep < lowest clock < mode clock
+    float sleepMa = PowerProfile::idleMa(POWER_FULL, PM_LIGHT_SLEEP);
+    float clockMa = PowerProfile::idleMa(POWER_FULL, PM_CLOCK);
+    float fixedMa = PowerProfile::idleMa(POWER_FULL, PM_NONE);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, POWER_BOARD_MA + POWER_LIGHT_SLEEP_MA, sleepMa);
+    TEST_ASSERT_TRUE(sleepMa < clockMa && clockMa < fixedMa);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, clockMa, PowerProfile::idleMa(POWER_ALERT, PM_LIGHT_SLEEP));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RESIDENCY
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_average_per_mode() {
+    PowerProfile p;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, p.averageMa(POWER_FULL, PM_LIGHT_SLEEP));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, p.averageMa(PM_LIGHT_SLEEP));
+    
+    // FULL: awake 25%
+    p.addAwake(POWER_FULL, 250000);
+    p.addIdle(POWER_FULL, 750000);
+    float full = 0.25f * PowerProfile::activeMa(POWER_FULL_MHZ) +
+                 0.75f * PowerProfile::idleMa(POWER_FULL, PM_LIGHT_SLEEP);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.25f, p.awakeFraction(POWER_FULL));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, full, p.averageMa(POWER_FULL, PM_LIGHT_SLEEP));
+    TEST_ASSERT_EQUAL(1, p.getWakeups(POWER_FULL));
+    TEST_ASSERT_EQUAL(1000000, p.getTimeUs(POWER_FULL));
+    
+    // ALERT: always awake, three times as long
+    p.addAwake(POWER_ALERT, 3000000);
+    float alert = PowerProfile::activeMa(POWER_ALERT_MHZ);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, alert, p.averageMa(POWER_ALERT, PM_LIGHT_SLEEP));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (full + 3 * alert) / 4, p.averageMa(PM_LIGHT_SLEEP));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, p.averageMa(POWER_IDLE, PM_LIGHT_SLEEP));
+    
+    // Without light sleep the same residency costs more
+    TEST_ASSERT_TRUE(p.averageMa(POWER_FULL, PM_CLOCK) > full);
+    
+    p.reset();
+    TEST_ASSERT_EQUAL(0, p.getTimeUs(POWER_ALERT));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIM
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_parked_tracker_current() {
+    // One minute parked (2000 ms interval), 2 ms of work per wake
+    const uint32_t workUs = 2000;
+    SamplingPolicy sampling;
+    PowerProfile adaptive;
+    uint32_t now = 0;
+    while (now < 60000) {
+        sampling.plan(2000, now);
+        if (sampling.batchDue(now)) sampling.batchDone(now);
+        uint32_t sleep = sampling.sleepMs(now, false);
+        adaptive.addAwake(POWER_IDLE, workUs);
+        adaptive.addIdle(POWER_IDLE, sleep * 1000);
+        now += sleep + workUs / 1000;
+    }
+    
+    // Before: delay(10) every loop, fixed clock
+    PowerProfile fixed;
+    for (int i = 0; i < 60000 / 12; i++) {
+        fixed.addAwake(POWER_IDLE, workUs);
+        fixed.addIdle(POWER_IDLE, 10000);
+    }
+    
+    float sleepMa = adaptive.averageMa(POWER_IDLE, PM_LIGHT_SLEEP);
+    float clockMa = adaptive.averageMa(POWER_IDLE, PM_CLOCK);
+    float fixedMa = fixed.averageMa(POWER_IDLE, PM_NONE);
+    printf("[SIM] parked tracker: %.2f mA light sleep, %.2f mA clock scaling, %.2f mA fixed 10 ms loop "
+           "(%lu vs %lu wakeups)\n", sleepMa, clockMa, fixedMa,
+           (unsigned long)adaptive.getWakeups(POWER_IDLE), (unsigned long)fixed.getWakeups(POWER_IDLE));
+    TEST_ASSERT_TRUE(sleepMa < clockMa && clockMa < fixedMa);
+    TEST_ASSERT_TRUE(sleepMa < POWER_BOARD_MA + 1.0f);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_mode_clock_and_current);
+    RUN_TEST(test_average_per_mode);
+    RUN_TEST(test_parked_tracker_current);
+    return UNITY_END();
+}
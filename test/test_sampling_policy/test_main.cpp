@@ -0,0 +1,238 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    SAMPLING POLICY - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Module interval -> FIFO rate, batch period and loop sleep
+ * (src/managers/sampling_policy.h):
+ * - Rates are exact 1 kHz dividers, one sample per interval at least
+ * - Long intervals are capped by the FIFO, short ones by the poll period
+ * - Triggers run the full rate for SAMPLING_BOOST_MS, shocks are found
+ * - The shipped modules (Arduino stub) slow the FIFO down at rest and
+ *   ask for the full rate when their event starts
+ * - [SIM] loop wakeups of an idle tracker vs the fixed 10 ms loop
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "managers/sampling_policy.h"
+#include "modules/module_contract.h"
+#include "modules/helmet_module.h"
+#include "modules/vehicle_module.h"
+#include "modules/bicycle_module.h"
+#include "modules/asset_module.h"
+
+static void fill(SensorData* out, size_t n, float g) {
+    for (size_t i = 0; i < n; i++) {
+        out[i].accel_x = 0.3f;
+        out[i].accel_y = -0.2f;
+        out[i].accel_z = g * 9.81f;
+        out[i].gyro_x = out[i].gyro_y = out[i].gyro_z = 0;
+        out[i].temperature = 25;
+        out[i].timestamp = (unsigned long)(i * 10);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// RATE & PERIOD
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_rate_for_interval() {
+    TEST_ASSERT_EQUAL(MODULE_BATCH_ODR_HZ, SamplingPolicy::odrFor(0));
+    TEST_ASSERT_EQUAL(100, SamplingPolicy::odrFor(10));
+    TEST_ASSERT_EQUAL(50, SamplingPolicy::odrFor(20));
+    TEST_ASSERT_EQUAL(40, SamplingPolicy::odrFor(30));     // 34 Hz needed
+    TEST_ASSERT_EQUAL(5, SamplingPolicy::odrFor(200));     // Tracker moving
+    TEST_ASSERT_EQUAL(SAMPLING_MIN_ODR_HZ, SamplingPolicy::odrFor(2000));   // Tracker parked
+    TEST_ASSERT_EQUAL(100, SamplingPolicy::odrFor(1));     // Capped
+    
+    // Every rate divides 1 kHz exactly (burst timestamps) and meets the interval
+    for (uint32_t interval = 1; interval <= 5000; interval++) {
+        uint16_t odr = SamplingPolicy::odrFor(interval);
+        TEST_ASSERT_EQUAL(0, 1000 % (1000 / odr));
+        TEST_ASSERT_TRUE(odr >= SAMPLING_MIN_ODR_HZ && odr <= MODULE_BATCH_ODR_HZ);
+        TEST_ASSERT_TRUE(odr == MODULE_BATCH_ODR_HZ || odr * interval >= 1000);
+    }
+}
+
+void test_plan_period_and_changes() {
+    SamplingPolicy p;
+    TEST_ASSERT_TRUE(p.plan(0, 0));             // First plan programs the FIFO
+    TEST_ASSERT_EQUAL(MODULE_BATCH_ODR_HZ, p.getOdr());
+    TEST_ASSERT_EQUAL(SAMPLING_POLL_MS, p.getPeriod());
+    TEST_ASSERT_FALSE(p.plan(0, 10));           // Same rate: nothing to reprogram
+    
+    TEST_ASSERT_TRUE(p.plan(2000, 20));
+    TEST_ASSERT_EQUAL(4, p.getOdr());
+    TEST_ASSERT_EQUAL(2000, p.getPeriod());
+    TEST_ASSERT_EQUAL(8, p.getWatermark());
+    
+    // Longer than the FIFO holds: woken before it fills
+    p.plan(60000, 30);
+    uint32_t fifoMs = (uint32_t)MPU_FIFO_SAMPLES * SAMPLING_FIFO_FILL / 100 * 1000 / p.getOdr();
+    TEST_ASSERT_EQUAL(fifoMs, p.getPeriod());
+    TEST_ASSERT_TRUE(p.getWatermark() < MPU_FIFO_SAMPLES);
+    
+    // Shorter than the poll period: the loop is not spun faster
+    p.plan(3, 40);
+    TEST_ASSERT_EQUAL(SAMPLING_POLL_MS, p.getPeriod());
+    TEST_ASSERT_EQUAL(3, p.getRateChanges());
+}
+
+void test_sleep_until_batch() {
+    SamplingPolicy p;
+    p.plan(2000, 0);
+    p.batchDone(1000);
+    TEST_ASSERT_FALSE(p.batchDue(2500));
+    TEST_ASSERT_TRUE(p.batchDue(3000));
+    TEST_ASSERT_EQUAL(SAMPLING_MAX_SLEEP_MS, p.sleepMs(1000, false));
+    TEST_ASSERT_EQUAL(300, p.sleepMs(2700, false));
+    TEST_ASSERT_EQUAL(1, p.sleepMs(3500, false));              // Overdue
+    TEST_ASSERT_EQUAL(SAMPLING_POLL_MS, p.sleepMs(1000, true));   // Radio / phone
+    TEST_ASSERT_EQUAL(4, p.getWakeups());
+    
+    // Across the millis() wrap
+    p.batchDone(0xFFFFFA00);
+    TEST_ASSERT_FALSE(p.batchDue(0x00000100));
+    TEST_ASSERT_EQUAL(2000 - 0x700, p.sleepMs(0x00000100, false));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// TRIGGERS
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_trigger_boost() {
+    SamplingPolicy p;
+    p.plan(2000, 0);
+    p.trigger(1000);
+    TEST_ASSERT_TRUE(p.plan(2000, 1000));
+    TEST_ASSERT_TRUE(p.isBoosted());
+    TEST_ASSERT_EQUAL(MODULE_BATCH_ODR_HZ, p.getOdr());
+    TEST_ASSERT_EQUAL(SAMPLING_POLL_MS, p.getPeriod());
+    
+    // A second trigger extends the boost
+    p.trigger(1000 + SAMPLING_BOOST_MS / 2);
+    TEST_ASSERT_FALSE(p.plan(2000, 1000 + SAMPLING_BOOST_MS));
+    TEST_ASSERT_TRUE(p.isBoosted());
+    
+    // Then back to what the module asked
+    TEST_ASSERT_TRUE(p.plan(2000, 1000 + SAMPLING_BOOST_MS * 3 / 2));
+    TEST_ASSERT_FALSE(p.isBoosted());
+    TEST_ASSERT_EQUAL(4, p.getOdr());
+    TEST_ASSERT_EQUAL(2, p.getTriggers());
+}
+
+void test_shock_detection() {
+    SensorData s[70];
+    fill(s, 70, 1.0f);
+    TEST_ASSERT_FALSE(SamplingPolicy::isShock(s, 70));
+    TEST_ASSERT_FALSE(SamplingPolicy::isShock(s, 0));
+    
+    s[45].accel_z = (1.0f + SAMPLING_TRIGGER_G + 0.2f) * 9.81f;   // Past the first chunk
+    TEST_ASSERT_TRUE(SamplingPolicy::isShock(s, 70));
+    TEST_ASSERT_FALSE(SamplingPolicy::isShock(s, 45));
+    
+    fill(s, 70, 1.0f);
+    s[3].accel_z = 0.1f * 9.81f;                                  // Free-fall
+    TEST_ASSERT_TRUE(SamplingPolicy::isShock(s, 4));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SHIPPED MODULES
+// ───────────────────────────────────────────────────────────────────────────
+
+// Feeds one burst, then plans from what the module asks afterwards
+template <typename M>
+static uint16_t odrAfter(M& m, SamplingPolicy& p, const SensorData* s, size_t n, uint32_t now) {
+    moduleUpdateBatch(m, s, n);
+    p.plan(moduleSampleInterval(m), now);
+    return p.getOdr();
+}
+
+void test_helmet_full_rate_while_falling() {
+    HelmetModule m;
+    SamplingPolicy p;
+    SensorData s[8];
+    fill(s, 8, 1.0f);
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(HELMET_SAMPLE_MS), odrAfter(m, p, s, 8, 0));
+    TEST_ASSERT_TRUE(p.getOdr() < MODULE_BATCH_ODR_HZ);
+    
+    fill(s, 8, 0.1f);                                             // Free-fall starts
+    TEST_ASSERT_EQUAL(MODULE_BATCH_ODR_HZ, odrAfter(m, p, s, 8, 100));
+    TEST_ASSERT_EQUAL(SAMPLING_POLL_MS, p.getPeriod());
+}
+
+void test_vehicle_slows_down_when_idle() {
+    VehicleModule m;
+    SamplingPolicy p;
+    SensorData s[8];
+    fill(s, 8, 1.0f);
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(VEHICLE_IDLE_SAMPLE_MS), odrAfter(m, p, s, 8, 0));
+    fill(s, 8, 1.6f);                                             // Driving
+    TEST_ASSERT_EQUAL(MODULE_BATCH_ODR_HZ, odrAfter(m, p, s, 8, 100));
+}
+
+void test_bicycle_and_asset_intervals() {
+    BicycleModule bike;
+    SamplingPolicy p;
+    SensorData s[4];
+    fill(s, 4, 1.0f);
+    for (SensorData& x : s) x.accel_x = x.accel_y = 0;
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(BICYCLE_STOPPED_SAMPLE_MS), odrAfter(bike, p, s, 4, 0));
+    for (SensorData& x : s) x.accel_x = 0.5f * 9.81f;             // Pedalling
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(BICYCLE_SAMPLE_MS), odrAfter(bike, p, s, 4, 100));
+    
+    AssetModule asset;
+    SamplingPolicy q;
+    fill(s, 4, 1.0f);
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(ASSET_SAMPLE_MS), odrAfter(asset, q, s, 4, 0));
+    TEST_ASSERT_EQUAL(SAMPLING_MIN_ODR_HZ, q.getOdr());
+    fill(s, 4, 1.6f);                                             // Carried off
+    TEST_ASSERT_EQUAL(SamplingPolicy::odrFor(ASSET_ALARM_SAMPLE_MS), odrAfter(asset, q, s, 4, 100));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIM
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_idle_wakeups() {
+    // One minute of a parked tracker (2000 ms interval), loop cost ignored
+    SamplingPolicy p;
+    uint32_t now = 0, samples = 0;
+    while (now < 60000) {
+        p.plan(2000, now);
+        if (p.batchDue(now)) {
+            samples += p.getWatermark();
+            p.batchDone(now);
+        }
+        now += p.sleepMs(now, false);
+    }
+    uint32_t fixedLoop = 60000 / 10;
+    printf("[SIM] parked tracker, 60 s: %lu wakeups (fixed 10 ms loop: %lu), %u Hz FIFO, %lu samples\n",
+           (unsigned long)p.getWakeups(), (unsigned long)fixedLoop, p.getOdr(), (unsigned long)samples);
+    TEST_ASSERT_TRUE(p.getWakeups() * 50 < fixedLoop);
+    TEST_ASSERT_TRUE(samples >= 60000 / 2000);   // At least one sample per interval
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rate_for_interval);
+    RUN_TEST(test_plan_period_and_changes);
+    RUN_TEST(test_sleep_until_batch);
+    RUN_TEST(test_trigger_boost);
+    RUN_TEST(test_shock_detection);
+    RUN_TEST(test_helmet_full_rate_while_falling);
+    RUN_TEST(test_vehicle_slows_down_when_idle);
+    RUN_TEST(test_bicycle_and_asset_intervals);
+    RUN_TEST(test_idle_wakeups);
+    return UNITY_END();
+}
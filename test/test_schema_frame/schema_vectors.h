@@ -0,0 +1,242 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    SCHEMA VECTORS - JS-Encoded Reference Frames
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * GENERATED by backend/schema-codegen.js from every schema in backend/schemas/
+ * Frames built by the JS codec (generated_schemas/index.js) and the records
+ * the JS decoder reads back; test_schema_frame decodes and re-encodes them
+ * with the C++ codec and expects the same bytes
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef SCHEMA_VECTORS_H
+#define SCHEMA_VECTORS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "lora/schemas/tracker_schema.h"
+#include "lora/schemas/vehicle_schema.h"
+
+template <class Schema>
+struct SchemaVector {
+    const uint8_t* frame;
+    size_t length;
+    const typename Schema::Record* records;
+    uint8_t count;
+};
+
+// tracker v1
+static const uint8_t TRACKER_FRAME_0[] = {
+    0xa2, 0x07, 0x00, 0x64, 0x00, 0x01, 0x01, 0x01, 0x54, 0x18, 0x54, 0xcb, 0x1b, 0x40, 0x66, 0xd8,
+    0x40, 0x78, 0xa1, 0x80
+};
+static const TrackerRecord TRACKER_RECORDS_0[] = {
+    {2, 80.0f, true, 2.66f, true, -23.44608, -45.19936, 241.0f, 201.0f, false, 0, 0}
+};
+static const uint8_t TRACKER_FRAME_1[] = {
+    0xa2, 0x07, 0x00, 0x65, 0x00, 0x01, 0x01, 0x06, 0x2b, 0x76, 0x7c, 0x34, 0x52, 0x65, 0x01, 0xc9,
+    0x6f, 0xff, 0xb1, 0xa7, 0x12, 0x90, 0xb1, 0xf2, 0x42, 0x1c, 0x0c, 0xc4, 0x53, 0x60, 0x62, 0x29,
+    0x26, 0xf0, 0xc4, 0x08, 0x15, 0x22, 0x61, 0x03, 0x88, 0xec, 0x60, 0x51, 0x96, 0xe0, 0x3b, 0x41,
+    0x70, 0x81, 0x33, 0x67, 0xe0, 0x43, 0x20, 0x52, 0x13, 0x4e, 0x03, 0xf3, 0x02, 0x91, 0x62, 0x12,
+    0x20, 0x5e, 0xa8, 0x68, 0x38, 0x10, 0x48, 0x10
+};
+static const TrackerRecord TRACKER_RECORDS_1[] = {
+    {1, 45.5f, true, 2.07f, true, -72.85518, 157.88639, 255.0f, 297.0f, true, -15.83925, -98.36537},
+    {0, 12.5f, true, 0.34f, true, -72.85532, 157.88637, 34.5f, 54.0f, true, -15.83878, -98.36461},
+    {0, 21.0f, false, 2.75f, false, 0, 0, 0, 0, false, 0, 0},
+    {1, 1.5f, true, 0.35f, true, -72.85621, 157.88672, 183.0f, 4.5f, true, -15.83852, -98.36473},
+    {0, 64.5f, false, 2.05f, true, -72.85701, 157.88742, 144.5f, 78.0f, true, -15.83804, -98.36505},
+    {3, 1.0f, true, 0.69f, true, -72.85697, 157.88842, 245.0f, 201.0f, true, -15.8387, -98.36439}
+};
+static const uint8_t TRACKER_FRAME_2[] = {
+    0xa2, 0x07, 0x00, 0x66, 0x00, 0x01, 0x01, 0x18, 0x02, 0x55, 0x0d, 0x9b, 0x00, 0x6c, 0x9a, 0x70,
+    0x2a, 0x6f, 0xf0, 0x00, 0xd3, 0x71, 0x8f, 0x37, 0x81, 0x1e, 0xf6, 0x26, 0x88, 0xfd, 0x51, 0xd8,
+    0x4f, 0x72, 0x28, 0x57, 0x72, 0x2f, 0xa8, 0x97, 0x6c, 0x98, 0xb4, 0x0a, 0x4e, 0xe0, 0x7e, 0x62,
+    0x4d, 0x05, 0x8c, 0x1c, 0x09, 0x34, 0x09, 0x8b, 0xb0, 0x51, 0x06, 0x41, 0x0e, 0xf5, 0x6c, 0x0a,
+    0x3c, 0x09, 0xcc, 0x0e, 0x11, 0x0b, 0x42, 0x7e, 0xa4, 0xb2, 0x48, 0xde, 0xd1, 0xf2, 0x49, 0x4d,
+    0x3a, 0x45, 0x14, 0x08, 0xbc, 0x08, 0x9c, 0x21, 0x3e, 0x63, 0x70, 0x2f, 0xaa, 0x70, 0x9c, 0xe0,
+    0xec, 0xa6, 0xa8, 0x12, 0x0f, 0x4b, 0xd6, 0xb0, 0x27, 0x30, 0x22, 0xba, 0x7d, 0xec, 0x40, 0xbb,
+    0x0a, 0xea, 0x50, 0xd0, 0x24, 0xd0, 0x25, 0x5a, 0x86, 0x59, 0x40, 0x88, 0x93, 0x60, 0xbb, 0xc8,
+    0xf0, 0x22, 0xd0, 0x00, 0x63, 0x0b, 0xc0, 0xa5, 0xb3, 0xd5, 0x50, 0x2d, 0x40, 0x3f, 0x9f, 0x44,
+    0x88, 0x40, 0x97, 0x65, 0xf0, 0x4f, 0x63, 0x2f, 0x78, 0x67, 0x99, 0x8f, 0xb1, 0xe1, 0x04, 0x7c,
+    0x26, 0xe0, 0x85, 0xe0, 0x41, 0x4a, 0x8b, 0xc4, 0x71, 0x7e, 0x86, 0x61, 0xe0, 0x47, 0xc5, 0xe7,
+    0x7e, 0x4e, 0xc0, 0xb1, 0x81, 0x28, 0x2c, 0x27, 0xc1, 0x34, 0x60, 0x29, 0x14, 0xdc, 0x13, 0xd8,
+    0x6f, 0xe1, 0x27, 0x04, 0x00, 0x15, 0x31, 0x8b, 0x5d, 0xf0, 0x46, 0x6f, 0x7b, 0xa4, 0xd1, 0xb4,
+    0xff, 0xd8, 0x1e, 0x04, 0xd5, 0x2a, 0x69, 0x86, 0xc5, 0xd5, 0xc6, 0xe6, 0x05, 0xc4
+};
+static const TrackerRecord TRACKER_RECORDS_2[] = {
+    {0, 9.0f, true, 1.61f, true, 44.67702, 22.42516, 223.5f, 288.0f, false, 0, 0},
+    {0, 26.0f, true, 3.69f, true, 44.67694, 22.42424, 61.5f, 324.0f, true, -21.47435, -102.61668},
+    {4, 40.0f, true, 1.87f, true, 44.67685, 22.42361, 137.0f, 355.5f, true, -21.47445, -102.61593},
+    {4, 78.5f, true, 2.59f, true, 44.67627, 22.4237, 208.0f, 265.5f, true, -21.47511, -102.6151},
+    {3, 11.5f, false, 3.86f, true, 44.67631, 22.42395, 16.5f, 333.0f, true, -21.47598, -102.6161},
+    {3, 76.0f, false, 1.12f, true, 44.67635, 22.4244, 39.5f, 318.0f, true, -21.47587, -102.61647},
+    {1, 94.5f, true, 1.43f, true, 44.67644, 22.42477, 211.5f, 108.0f, true, -21.47506, -102.61723},
+    {1, 28.0f, false, 2.65f, true, 44.67586, 22.42399, 250.5f, 117.0f, false, 0, 0},
+    {1, 28.5f, true, 2.63f, false, 0, 0, 0, 0, true, -21.47469, -102.61606},
+    {2, 7.5f, false, 3.03f, false, 0, 0, 0, 0, true, -21.4756, -102.61699},
+    {1, 46.5f, false, 2.51f, true, 44.67694, 22.42458, 43.5f, 123.0f, true, -21.47493, -102.61616},
+    {2, 86.5f, false, 2.68f, true, 44.67783, 22.42449, 77.5f, 7.5f, true, -21.47446, -102.61716},
+    {1, 52.0f, false, 0.0f, true, 44.67818, 22.42373, 150.5f, 237.0f, true, -21.47361, -102.61663},
+    {0, 15.5f, true, 3.18f, true, 44.67813, 22.42445, 93.5f, 70.5f, true, -21.4736, -102.61725},
+    {1, 75.5f, true, 2.4f, true, 44.67773, 22.42419, 62.5f, 214.5f, false, 0, 0},
+    {0, 65.0f, false, 2.48f, false, 0, 0, 0, 0, true, -21.47502, -102.61801},
+    {0, 41.0f, true, 1.39f, true, 44.67807, 22.42362, 253.0f, 37.5f, true, -21.4757, -102.61817},
+    {1, 60.5f, true, 3.82f, false, 0, 0, 0, 0, true, -21.47649, -102.61867},
+    {0, 18.5f, false, 0.22f, false, 0, 0, 0, 0, false, 0, 0},
+    {2, 62.0f, false, 0.77f, false, 0, 0, 0, 0, false, 0, 0},
+    {3, 0.5f, false, 2.9f, true, 44.67665, 22.423, 27.5f, 360.0f, true, -21.47787, -102.61867},
+    {0, 84.5f, true, 0.49f, false, 0, 0, 0, 0, true, -21.47831, -102.61805},
+    {1, 12.5f, true, 2.47f, true, 44.67694, 22.42261, 54.5f, 94.5f, true, -21.47772, -102.61873},
+    {3, 42.0f, true, 1.66f, true, 44.67706, 22.42315, 186.5f, 169.5f, true, -21.47865, -102.6193}
+};
+static const SchemaVector<TrackerSchema> TRACKER_VECTORS[] = {
+    {TRACKER_FRAME_0, sizeof(TRACKER_FRAME_0), TRACKER_RECORDS_0, 1},
+    {TRACKER_FRAME_1, sizeof(TRACKER_FRAME_1), TRACKER_RECORDS_1, 6},
+    {TRACKER_FRAME_2, sizeof(TRACKER_FRAME_2), TRACKER_RECORDS_2, 24}
+};
+
+// vehicle v1
+static const uint8_t VEHICLE_FRAME_0[] = {
+    0xa2, 0x07, 0x00, 0x64, 0x00, 0x02, 0x01, 0x01, 0x8d, 0x80
+};
+static const VehicleRecord VEHICLE_RECORDS_0[] = {
+    {5.66f, false, false, 0}
+};
+static const uint8_t VEHICLE_FRAME_1[] = {
+    0xa2, 0x07, 0x00, 0x65, 0x00, 0x02, 0x01, 0x06, 0xae, 0xd5, 0x02, 0xde, 0x87, 0xd3, 0x53, 0xce,
+    0x74, 0x98, 0x51, 0x87, 0x02
+};
+static const VehicleRecord VEHICLE_RECORDS_1[] = {
+    {6.99f, false, true, 8.0f},
+    {1.83f, true, false, 0},
+    {5.43f, false, true, 5.3f},
+    {2.43f, true, false, 0},
+    {4.66f, false, true, 13.3f},
+    {0.97f, true, true, 0.2f}
+};
+static const uint8_t VEHICLE_FRAME_2[] = {
+    0xa2, 0x07, 0x00, 0x66, 0x00, 0x02, 0x01, 0x62, 0x5b, 0x33, 0x00, 0x11, 0x74, 0xab, 0xb3, 0xc6,
+    0xf0, 0x46, 0x12, 0xe0, 0x8e, 0xbf, 0x48, 0x9c, 0x93, 0xb3, 0x0b, 0xca, 0x2b, 0x12, 0xf8, 0x3f,
+    0x68, 0x6b, 0xf4, 0x91, 0x4e, 0xc4, 0xb8, 0x57, 0xdd, 0x8f, 0x65, 0x38, 0x2a, 0x6c, 0x51, 0x41,
+    0x6e, 0x0e, 0x54, 0x62, 0xa5, 0x2a, 0x58, 0x17, 0x78, 0xc1, 0xa0, 0x1e, 0xe9, 0x6a, 0x1f, 0xb3,
+    0xe2, 0xf8, 0x19, 0x56, 0xc0, 0x53, 0x54, 0x30, 0x92, 0xd4, 0xc3, 0x7b, 0x26, 0xd9, 0xfb, 0x60,
+    0x06, 0xea, 0x87, 0x09, 0x95, 0x54, 0x63, 0xab, 0x53, 0x75, 0x83, 0x9b, 0x65, 0x9e, 0xb7, 0x51,
+    0x6d, 0x1e, 0x9b, 0xc7, 0x4b, 0x69, 0x70, 0x99, 0x8c, 0x40, 0x88, 0x33, 0xb5, 0x75, 0x65, 0xb5,
+    0x81, 0xcb, 0x1d, 0x79, 0x15, 0x61, 0xb1, 0x2c, 0x0a, 0xe4, 0xb3, 0x80, 0xac, 0xb5, 0xd6, 0x50,
+    0xb7, 0xb3, 0x9a, 0x06, 0x53, 0x74, 0x16, 0x2f, 0x87, 0x7c, 0xa1, 0x9b, 0x3f, 0x03, 0x12, 0x24,
+    0xd5, 0x1a, 0x36, 0x14, 0x73, 0x11, 0x56, 0x80, 0xb6, 0xf3, 0x9d, 0x02, 0x52, 0xd8, 0x4b, 0x41,
+    0x9b, 0x2c, 0x95, 0x98, 0x95, 0x85, 0x43, 0xab, 0xe7, 0x09, 0xb8, 0x73, 0x60, 0x13, 0x3e, 0x18,
+    0xca, 0xf8, 0x3a, 0xe7, 0xa1, 0x89, 0xb8, 0x36, 0xe6, 0x67, 0x0f, 0x56, 0x18, 0xca, 0xfd, 0x92,
+    0x79, 0x13, 0xb1, 0x12, 0x1b, 0x52, 0xd7, 0xcf, 0x8e, 0x9a, 0xcb, 0x74, 0x84, 0x71, 0x49, 0x9b,
+    0x43, 0xa8, 0x72, 0x81, 0x6b, 0x2c, 0x76, 0x90, 0x05, 0xe0, 0xb2, 0xd6, 0x12, 0xb6
+};
+static const VehicleRecord VEHICLE_RECORDS_2[] = {
+    {3.64f, true, true, 4.8f},
+    {0.04f, false, true, 11.6f},
+    {6.86f, true, true, 6.0f},
+    {4.44f, false, false, 0},
+    {2.8f, false, true, 4.6f},
+    {0.35f, true, false, 0},
+    {7.65f, false, false, 0},
+    {5.51f, false, false, 0},
+    {5.9f, true, true, 4.8f},
+    {7.54f, true, false, 0},
+    {1.72f, false, true, 4.7f},
+    {5.27f, true, true, 10.4f},
+    {4.31f, true, true, 7.3f},
+    {0.83f, true, false, 0},
+    {7.86f, true, true, 13.3f},
+    {5.03f, false, true, 14.3f},
+    {4.04f, true, true, 13.0f},
+    {6.67f, false, false, 0},
+    {3.25f, false, false, 0},
+    {0.91f, true, false, 0},
+    {0.57f, false, true, 7.0f},
+    {1.69f, false, true, 4.2f},
+    {3.52f, false, true, 11.9f},
+    {5.6f, false, true, 16.0f},
+    {1.23f, true, false, 0},
+    {6.02f, true, false, 0},
+    {1.26f, true, true, 6.2f},
+    {1.9f, false, false, 0},
+    {1.01f, false, true, 10.8f},
+    {0.2f, true, true, 8.4f},
+    {1.94f, false, true, 4.5f},
+    {3.04f, true, true, 12.3f},
+    {1.55f, false, true, 15.9f},
+    {7.28f, false, false, 0},
+    {0.27f, true, false, 0},
+    {6.73f, true, true, 0.9f},
+    {5.97f, false, true, 7.0f},
+    {2.34f, true, true, 8.3f},
+    {4.7f, false, false, 0},
+    {2.3f, true, true, 10.1f},
+    {6.34f, true, true, 11.7f},
+    {0.91f, false, true, 3.0f},
+    {6.23f, false, false, 0},
+    {4.66f, true, true, 10.5f},
+    {4.5f, false, true, 15.2f},
+    {7.84f, false, false, 0},
+    {5.44f, true, true, 5.9f},
+    {3.49f, false, true, 10.1f},
+    {7.26f, false, false, 0},
+    {1.14f, true, true, 2.9f},
+    {4.84f, false, true, 8.6f},
+    {1.08f, false, true, 4.4f},
+    {0.43f, true, false, 0},
+    {3.0f, true, true, 12.8f},
+    {6.9f, true, true, 9.3f},
+    {4.04f, false, false, 0},
+    {7.34f, true, true, 5.7f},
+    {6.41f, true, false, 0},
+    {3.33f, true, true, 6.5f},
+    {3.95f, true, true, 13.5f},
+    {4.98f, true, false, 0},
+    {1.02f, true, true, 6.3f},
+    {0.12f, false, true, 3.4f},
+    {3.09f, false, true, 2.6f},
+    {2.16f, false, true, 7.1f},
+    {1.96f, false, true, 8.6f},
+    {5.14f, true, true, 11.1f},
+    {2.31f, false, true, 0.2f},
+    {3.31f, false, true, 13.2f},
+    {7.2f, false, true, 15.5f},
+    {1.78f, false, true, 8.9f},
+    {5.49f, false, true, 13.3f},
+    {2.7f, true, false, 0},
+    {7.61f, true, true, 0.9f},
+    {7.37f, true, true, 5.4f},
+    {0.04f, true, true, 6.2f},
+    {0.99f, false, false, 0},
+    {7.02f, false, false, 0},
+    {2.35f, true, false, 0},
+    {4.88f, false, true, 13.7f},
+    {7.36f, true, true, 11.0f},
+    {4.09f, true, true, 1.5f},
+    {3.44f, false, true, 14.0f},
+    {7.03f, false, true, 14.6f},
+    {4.84f, false, true, 5.9f},
+    {0.68f, true, false, 0},
+    {1.09f, false, true, 4.5f},
+    {4.99f, true, true, 14.2f},
+    {6.19f, false, false, 0},
+    {7.33f, false, false, 0},
+    {5.29f, true, true, 2.0f},
+    {6.14f, true, true, 6.7f},
+    {6.73f, true, true, 4.0f},
+    {0.9f, true, true, 4.4f},
+    {4.74f, false, true, 0.0f},
+    {3.76f, false, false, 0},
+    {7.15f, false, true, 9.7f},
+    {1.73f, true, false, 0}
+};
+static const SchemaVector<VehicleSchema> VEHICLE_VECTORS[] = {
+    {VEHICLE_FRAME_0, sizeof(VEHICLE_FRAME_0), VEHICLE_RECORDS_0, 1},
+    {VEHICLE_FRAME_1, sizeof(VEHICLE_FRAME_1), VEHICLE_RECORDS_1, 6},
+    {VEHICLE_FRAME_2, sizeof(VEHICLE_FRAME_2), VEHICLE_RECORDS_2, 98}
+};
+
+#endif // SCHEMA_VECTORS_H
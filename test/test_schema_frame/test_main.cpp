@@ -0,0 +1,263 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    SCHEMA FRAME - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * Bit packing primitives, C++ round trips of the generated tracker and
+ * vehicle codecs, and agreement with the JS codec: every frame in
+ * schema_vectors.h was encoded by generated_schemas/index.js; the C++
+ * decoder must read the records the JS decoder read, and the C++ encoder
+ * must rebuild the frame byte for byte.
+ * 
+ * Regenerate the vectors with: cd backend && node schema-codegen.js
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <math.h>
+
+#include "lora/schema_frame.h"
+#include "lora/schemas/tracker_schema.h"
+#include "lora/schemas/vehicle_schema.h"
+#include "schema_vectors.h"
+
+void setUp() {}
+void tearDown() {}
+
+// ───────────────────────────────────────────────────────────────────────────
+// BIT PACKING
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_bits_msb_first_across_bytes() {
+    uint8_t buf[4];
+    BitWriter w;
+    w.begin(buf, sizeof(buf));
+    w.writeBits(0x5, 3);     // 101
+    w.writeBits(0x1FF, 9);   // 1 1111 1111
+    w.writeBool(false);
+    
+    TEST_ASSERT_EQUAL(13, w.bitLength());
+    TEST_ASSERT_EQUAL(2, w.byteLength());
+    TEST_ASSERT_EQUAL_HEX8(0xBF, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xF0, buf[1]);
+    
+    BitReader r;
+    r.begin(buf, w.byteLength());
+    TEST_ASSERT_EQUAL(0x5, r.readBits(3));
+    TEST_ASSERT_EQUAL(0x1FF, r.readBits(9));
+    TEST_ASSERT_FALSE(r.readBool());
+    TEST_ASSERT_TRUE(r.atEnd());
+}
+
+void test_varint_and_scaled_roundtrip() {
+    uint8_t buf[16];
+    BitWriter w;
+    w.begin(buf, sizeof(buf));
+    w.writeVarint(0, 4);
+    w.writeVarint(1000, 4);
+    w.writeScaled(2.66, 0.0, 0.01, 400, 9);
+    w.writeScaled(99.0, 0.0, 0.01, 400, 9);   // Clamped to max
+    
+    BitReader r;
+    r.begin(buf, w.byteLength());
+    TEST_ASSERT_EQUAL(0, r.readVarint(4));
+    TEST_ASSERT_EQUAL(1000, r.readVarint(4));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.66f, (float)r.readScaled(0.0, 0.01, 9));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, (float)r.readScaled(0.0, 0.01, 9));
+    TEST_ASSERT_FALSE(r.overran());
+}
+
+void test_overflow_and_rewind_leave_no_trace() {
+    uint8_t buf[2];
+    BitWriter w;
+    w.begin(buf, sizeof(buf));
+    w.writeBits(0x3, 2);
+    size_t m = w.mark();
+    w.writeBits(0xFFFF, 16);
+    TEST_ASSERT_TRUE(w.overflowed());
+    
+    w.rewind(m);
+    TEST_ASSERT_FALSE(w.overflowed());
+    TEST_ASSERT_EQUAL(2, w.bitLength());
+    TEST_ASSERT_EQUAL_HEX8(0xC0, buf[0]);
+}
+
+void test_reader_flags_overrun() {
+    uint8_t buf[1] = {0xFF};
+    BitReader r;
+    r.begin(buf, 1);
+    r.readBits(8);
+    TEST_ASSERT_FALSE(r.overran());
+    r.readBits(1);
+    TEST_ASSERT_TRUE(r.overran());
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// C++ ROUND TRIPS
+// ───────────────────────────────────────────────────────────────────────────
+
+static TrackerRecord trackerRecord(int i) {
+    TrackerRecord r = {};
+    r.state = i % 5;
+    r.battery = 90.0f - i * 0.5f;
+    r.alert = (i % 7) == 0;
+    r.motion = 0.01f * (i % 300);
+    r.gps_valid = (i % 4) != 3;
+    if (r.gps_valid) {
+        r.latitude = 48.13743 + i * 0.00012;
+        r.longitude = 11.57549 - i * 0.00007;
+        r.speed = 0.5f * (i % 100);
+        r.heading = 1.5f * (i % 200);
+    }
+    r.parked = (i % 5) == 0;
+    if (r.parked) {
+        r.parked_latitude = 48.13700;
+        r.parked_longitude = 11.57500;
+    }
+    return r;
+}
+
+void test_tracker_roundtrip_keeps_gps_precision() {
+    SchemaFrameBuilder<TrackerSchema> b;
+    b.begin(42, 9, LORA_MAX_PAYLOAD);
+    for (int i = 0; i < 10; i++) TEST_ASSERT_TRUE(b.add(trackerRecord(i)));
+    
+    SchemaFrameReader<TrackerSchema> rd;
+    TEST_ASSERT_TRUE(rd.open(b.data(), b.length()));
+    TEST_ASSERT_EQUAL(42, rd.header().device_id);
+    TEST_ASSERT_EQUAL(9, rd.header().seq);
+    TEST_ASSERT_EQUAL(10, rd.header().record_count);
+    
+    for (int i = 0; i < 10; i++) {
+        TrackerRecord want = trackerRecord(i), got;
+        TEST_ASSERT_TRUE(rd.next(got));
+        TEST_ASSERT_EQUAL(want.state, got.state);
+        TEST_ASSERT_EQUAL(want.gps_valid, got.gps_valid);
+        TEST_ASSERT_EQUAL(want.parked, got.parked);
+        TEST_ASSERT_FLOAT_WITHIN(0.26f, want.battery, got.battery);
+        if (want.gps_valid) {
+            // Within half a step: ~0.5 m
+            TEST_ASSERT_TRUE(fabs(want.latitude - got.latitude) <= 0.000005 + 1e-9);
+            TEST_ASSERT_TRUE(fabs(want.longitude - got.longitude) <= 0.000005 + 1e-9);
+        }
+    }
+    TEST_ASSERT_TRUE(rd.isComplete());
+}
+
+void test_full_frame_rolls_back_the_last_record() {
+    SchemaFrameBuilder<TrackerSchema> b;
+    b.begin(1, 1, 40);
+    int added = 0;
+    while (b.add(trackerRecord(added))) added++;
+    
+    TEST_ASSERT_TRUE(added > 0);
+    TEST_ASSERT_LESS_OR_EQUAL(40, b.length());
+    TEST_ASSERT_EQUAL(added, b.recordCount());
+    
+    SchemaFrameReader<TrackerSchema> rd;
+    TEST_ASSERT_TRUE(rd.open(b.data(), b.length()));
+    TrackerRecord got;
+    int read = 0;
+    while (rd.next(got)) read++;
+    TEST_ASSERT_EQUAL(added, read);
+    TEST_ASSERT_TRUE(rd.isComplete());
+}
+
+void test_vehicle_crash_peak_only_when_crashed() {
+    VehicleRecord calm = {1.25f, true, false, 0};
+    VehicleRecord crash = {3.5f, false, true, 7.3f};
+    
+    SchemaFrameBuilder<VehicleSchema> b;
+    b.begin(3, 4, LORA_MAX_PAYLOAD);
+    TEST_ASSERT_TRUE(b.add(calm));
+    size_t calmLen = b.length();
+    TEST_ASSERT_TRUE(b.add(crash));
+    
+    // 12 bits without the peak, 20 with it
+    TEST_ASSERT_EQUAL(SCHEMA_HEADER_LEN + 2, calmLen);
+    TEST_ASSERT_EQUAL(SCHEMA_HEADER_LEN + 4, b.length());
+    
+    SchemaFrameReader<VehicleSchema> rd;
+    TEST_ASSERT_TRUE(rd.open(b.data(), b.length()));
+    VehicleRecord got;
+    TEST_ASSERT_TRUE(rd.next(got));
+    TEST_ASSERT_FLOAT_WITHIN(0.006f, 1.25f, got.vibration);
+    TEST_ASSERT_TRUE(got.idle);
+    TEST_ASSERT_FALSE(got.crash);
+    TEST_ASSERT_TRUE(rd.next(got));
+    TEST_ASSERT_TRUE(got.crash);
+    TEST_ASSERT_FLOAT_WITHIN(0.051f, 7.3f, got.crash_peak);
+    TEST_ASSERT_TRUE(rd.isComplete());
+}
+
+void test_reader_rejects_other_schema() {
+    SchemaFrameBuilder<VehicleSchema> b;
+    b.begin(3, 4, LORA_MAX_PAYLOAD);
+    VehicleRecord r = {1.0f, false, false, 0};
+    b.add(r);
+    
+    SchemaFrameReader<TrackerSchema> rd;
+    TEST_ASSERT_FALSE(rd.open(b.data(), b.length()));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// C++ / JS AGREEMENT
+// ───────────────────────────────────────────────────────────────────────────
+
+// Decode a JS-encoded frame, then encode both what C++ read and what JS
+// read: all three must be the same bytes
+template <class Schema, size_t N>
+static void checkVectors(const SchemaVector<Schema> (&vectors)[N]) {
+    static typename Schema::Record decoded[255];
+    
+    for (size_t v = 0; v < N; v++) {
+        const SchemaVector<Schema>& vec = vectors[v];
+        
+        SchemaFrameReader<Schema> rd;
+        TEST_ASSERT_TRUE(rd.open(vec.frame, vec.length));
+        TEST_ASSERT_EQUAL(7, rd.header().device_id);
+        TEST_ASSERT_EQUAL(vec.count, rd.header().record_count);
+        
+        uint8_t n = 0;
+        while (rd.next(decoded[n])) n++;
+        TEST_ASSERT_EQUAL(vec.count, n);
+        TEST_ASSERT_TRUE(rd.isComplete());
+        
+        SchemaFrameBuilder<Schema> fromCpp, fromJs;
+        fromCpp.begin(7, rd.header().seq, LORA_MAX_PAYLOAD);
+        fromJs.begin(7, rd.header().seq, LORA_MAX_PAYLOAD);
+        for (uint8_t i = 0; i < n; i++) {
+            TEST_ASSERT_TRUE(fromCpp.add(decoded[i]));
+            TEST_ASSERT_TRUE(fromJs.add(vec.records[i]));
+        }
+        
+        TEST_ASSERT_EQUAL(vec.length, fromCpp.length());
+        TEST_ASSERT_EQUAL_MEMORY(vec.frame, fromCpp.data(), vec.length);
+        TEST_ASSERT_EQUAL(vec.length, fromJs.length());
+        TEST_ASSERT_EQUAL_MEMORY(vec.frame, fromJs.data(), vec.length);
+    }
+}
+
+void test_tracker_matches_js_codec() {
+    checkVectors(TRACKER_VECTORS);
+}
+
+void test_vehicle_matches_js_codec() {
+    checkVectors(VEHICLE_VECTORS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bits_msb_first_across_bytes);
+    RUN_TEST(test_varint_and_scaled_roundtrip);
+    RUN_TEST(test_overflow_and_rewind_leave_no_trace);
+    RUN_TEST(test_reader_flags_overrun);
+    RUN_TEST(test_tracker_roundtrip_keeps_gps_precision);
+    RUN_TEST(test_full_frame_rolls_back_the_last_record);
+    RUN_TEST(test_vehicle_crash_peak_only_when_crashed);
+    RUN_TEST(test_reader_rejects_other_schema);
+    RUN_TEST(test_tracker_matches_js_codec);
+    RUN_TEST(test_vehicle_matches_js_codec);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *                    TDMA SIMULATION - Host Test (pio test -e native)
+ * ═══════════════════════════════════════════════════════════════════════════
+ * 
+ * One gateway, 96 devices (a few DEVICE_IDs share a home slot), 51-byte
+ * frames at SF7, one frame per device per superframe, 30 simulated minutes
+ * - Every device clock is off by up to +-100 ppm and starts at a random
+ *   offset; loop() polls the radio every 10 ms
+ * - Each device misses 20% of the beacons, and only hears one while its
+ *   radio is listening (TdmaSync::shouldListen)
+ * - The gateway plans slot overrides from the devices it has heard
+ * 
+ * Checks: no two frames (or a frame and a beacon) overlap on air, and
+ * every frame leaves within one superframe of being queued
+ * 
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lora/tdma_sync.h"
+#include "lora/lora_airtime.h"
+
+static const int DEVICES = 96;
+static const uint32_t SIM_MS = 30 * 60000;
+static const int PAYLOAD_LEN = 51;
+static const int BEACON_LOSS_PCT = 20;
+static const int DRIFT_RANGE_PPM = 100;
+
+struct SimDevice {
+    TdmaSync sync;
+    uint16_t id;
+    int32_t ppm;                 // Local clock error
+    uint32_t offset;             // Local clock at t = 0
+    uint32_t pollPhase;
+    bool pending;
+    uint32_t queuedAt;
+    uint32_t txEnd;
+    uint32_t framesSent;
+    uint32_t worstLatency;
+    
+    SimDevice() : sync(0) {}
+};
+
+static SimDevice devices[DEVICES];
+static uint8_t onAir[SIM_MS + 1000];
+static uint32_t rngState;
+
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t localClock(const SimDevice& d, uint32_t t) {
+    return d.offset + t + (uint32_t)((int64_t)t * d.ppm / 1000000);
+}
+
+static void markAir(uint32_t start, uint32_t air) {
+    for (uint32_t t = start; t < start + air && t < sizeof(onAir); t++) onAir[t]++;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// UNIT TESTS
+// ───────────────────────────────────────────────────────────────────────────
+
+void setUp() {}
+void tearDown() {}
+
+void test_beacon_roundtrip() {
+    TdmaBeacon b;
+    b.superframe_ms = 0xDEAD1234;
+    b.tx_delay_ms = 7;
+    b.override_count = 2;
+    b.overrides[0] = {500, 3};
+    b.overrides[1] = {596, 4};
+    
+    uint8_t buf[TDMA_BEACON_MAX_LEN];
+    size_t len = b.encode(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(TDMA_BEACON_HEADER_LEN + 2 * TDMA_OVERRIDE_LEN, len);
+    TEST_ASSERT_EQUAL(FRAME_BEACON, buf[0]);
+    
+    TdmaBeacon d;
+    TEST_ASSERT_TRUE(d.decode(buf, len));
+    TEST_ASSERT_TRUE(d.superframe_ms == 0xDEAD1234);
+    TEST_ASSERT_EQUAL(TDMA_SLOT_COUNT, d.slot_count);
+    TEST_ASSERT_EQUAL(7, d.tx_delay_ms);
+    TEST_ASSERT_EQUAL(3, d.slotFor(500));
+    TEST_ASSERT_EQUAL(4, d.slotFor(596));
+    TEST_ASSERT_EQUAL(7 % TDMA_SLOT_COUNT, d.slotFor(7));
+    
+    // Truncated override list / schedule longer than its superframe
+    TEST_ASSERT_FALSE(d.decode(buf, len - 1));
+    buf[9] = 0xFF;
+    buf[10] = 0x7F;
+    TEST_ASSERT_FALSE(d.decode(buf, len));
+}
+
+void test_plan_moves_colliding_devices() {
+    TdmaBeacon b;
+    uint16_t ids[] = {5 + TDMA_SLOT_COUNT, 5, 6, 5 + 2 * TDMA_SLOT_COUNT};
+    TEST_ASSERT_EQUAL(0, b.plan(ids, 4));
+    TEST_ASSERT_EQUAL(2, b.override_count);
+    
+    // Lowest id keeps the home slot, the rest get distinct free ones
+    TEST_ASSERT_EQUAL(5, b.slotFor(5));
+    TEST_ASSERT_EQUAL(6, b.slotFor(6));
+    uint16_t a = b.slotFor(ids[0]);
+    uint16_t c = b.slotFor(ids[3]);
+    TEST_ASSERT_NOT_EQUAL(a, c);
+    TEST_ASSERT_TRUE(a != 5 && a != 6 && c != 5 && c != 6);
+}
+
+void test_drift_is_measured_and_corrected() {
+    TdmaSync sync(10);
+    TdmaBeacon b;
+    uint8_t buf[TDMA_BEACON_MAX_LEN];
+    const int32_t ppm = 80;
+    
+    for (uint32_t k = 0; k < 40; k++) {
+        uint32_t gw = 1000 + k * TDMA_BEACON_PERIOD_MS;
+        if (k % 3 == 2) continue;  // Lost beacons
+        b.superframe_ms = gw;
+        size_t len = b.encode(buf, sizeof(buf));
+        uint32_t local = 50000 + gw + (uint32_t)((int64_t)gw * ppm / 1000000);
+        TEST_ASSERT_TRUE(sync.onBeacon(buf, len, local));
+    }
+    
+    TEST_ASSERT_TRUE(sync.getDriftPpm() > ppm - 20 && sync.getDriftPpm() < ppm + 20);
+    TEST_ASSERT_TRUE(sync.getLastErrorMs() <= 1 && sync.getLastErrorMs() >= -1);
+    TEST_ASSERT_EQUAL(0, sync.getResyncs());
+    
+    // Gateway reboot (clock jumps back): resync instead of a bogus drift
+    b.superframe_ms = 500;
+    size_t len = b.encode(buf, sizeof(buf));
+    TEST_ASSERT_TRUE(sync.onBeacon(buf, len, 900000));
+    TEST_ASSERT_EQUAL(1, sync.getResyncs());
+    TEST_ASSERT_TRUE(sync.isSynced(900000 + TDMA_BEACON_PERIOD_MS));
+    TEST_ASSERT_FALSE(sync.isSynced(900000 + (TDMA_MAX_MISSED_BEACONS + 2) * TDMA_BEACON_PERIOD_MS));
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// SIMULATION
+// ───────────────────────────────────────────────────────────────────────────
+
+void test_slots_never_collide_at_scale() {
+    rngState = 0x7D3A11C5;
+    memset(onAir, 0, sizeof(onAir));
+    uint32_t air = LoRaAirtime::timeOnAirMs(PAYLOAD_LEN, 7, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+    uint32_t beaconAir = 0;
+    
+    uint16_t ids[DEVICES];
+    for (int i = 0; i < DEVICES; i++) {
+        SimDevice& d = devices[i];
+        // Mostly sequential ids, every 12th one aliases another's home slot
+        d.id = (i % 12 == 11) ? (uint16_t)(i - 1 + TDMA_SLOT_COUNT) : (uint16_t)(i + 1);
+        d.sync = TdmaSync(d.id);
+        d.ppm = (int32_t)(rnd() % (2 * DRIFT_RANGE_PPM + 1)) - DRIFT_RANGE_PPM;
+        d.offset = rnd();
+        d.pollPhase = rnd() % 10;
+        d.pending = false;
+        d.txEnd = 0;
+        d.framesSent = 0;
+        d.worstLatency = 0;
+        ids[i] = d.id;
+    }
+    
+    TdmaBeacon plan;
+    uint16_t shared = plan.plan(ids, DEVICES);
+    uint32_t frames = 0;
+    uint32_t contention = 0;
+    
+    for (uint32_t t = 0; t < SIM_MS; t++) {
+        // Gateway beacon, a few ms late now and then
+        if (t % TDMA_BEACON_PERIOD_MS == 0) {
+            uint8_t buf[TDMA_BEACON_MAX_LEN];
+            plan.superframe_ms = 100000 + t;
+            plan.tx_delay_ms = rnd() % 20;
+            size_t len = plan.encode(buf, sizeof(buf));
+            beaconAir = LoRaAirtime::timeOnAirMs(len, 7, LORA_BW, LORA_CR, LORA_PREAMBLE_LEN);
+            uint32_t start = t + plan.tx_delay_ms;
+            markAir(start, beaconAir);
+            
+            for (int i = 0; i < DEVICES; i++) {
+                SimDevice& d = devices[i];
+                uint32_t local = localClock(d, start);
+                if (!d.sync.shouldListen(local) || (int)(rnd() % 100) < BEACON_LOSS_PCT) continue;
+                d.sync.onBeacon(buf, len, local + (rnd() % 3) - 1);
+            }
+        }
+        
+        for (int i = 0; i < DEVICES; i++) {
+            SimDevice& d = devices[i];
+            if ((t + d.pollPhase) % 10 != 0) continue;
+            uint32_t local = localClock(d, t);
+            
+            // One telemetry frame per superframe, queued at a random moment
+            if (!d.pending && t > 2 * TDMA_BEACON_PERIOD_MS && rnd() % 1500 == 0) {
+                d.pending = true;
+                d.queuedAt = t;
+            }
+            if (!d.pending || t < d.txEnd || !d.sync.isSynced(local)) continue;
+            
+            if (!d.sync.fitsSlot(air, local)) {
+                contention++;
+                continue;
+            }
+            if (d.sync.canTransmit(local, air)) {
+                markAir(t, air);
+                d.txEnd = t + air;
+                uint32_t latency = t - d.queuedAt;
+                if (latency > d.worstLatency) d.worstLatency = latency;
+                d.pending = false;
+                d.framesSent++;
+                frames++;
+            }
+        }
+    }
+    
+    uint32_t overlaps = 0;
+    for (uint32_t t = 0; t < SIM_MS; t++) {
+        if (onAir[t] > 1) overlaps++;
+    }
+    
+    uint32_t worst = 0;
+    int32_t maxDrift = 0;
+    uint32_t maxError = 0;
+    for (int i = 0; i < DEVICES; i++) {
+        if (devices[i].worstLatency > worst) worst = devices[i].worstLatency;
+        int32_t err = devices[i].sync.getDriftPpm() - devices[i].ppm;
+        if (err < 0) err = -err;
+        if (err > maxDrift) maxDrift = err;
+        if (devices[i].sync.getMaxErrorMs() > maxError) maxError = devices[i].sync.getMaxErrorMs();
+    }
+    
+    printf("[SIM] TDMA: %lu frames, %lu ms overlapping on air, worst latency %lu ms\n",
+           (unsigned long)frames, (unsigned long)overlaps, (unsigned long)worst);
+    printf("[SIM] %u overrides, %u shared | drift estimate off by <= %ld ppm, "
+           "slot prediction error <= %lu ms | beacon %lu ms, frame %lu ms\n",
+           plan.override_count, shared, (long)maxDrift, (unsigned long)maxError,
+           (unsigned long)beaconAir, (unsigned long)air);
+    
+    TEST_ASSERT_EQUAL(0, shared);
+    TEST_ASSERT_EQUAL(0, contention);
+    TEST_ASSERT_TRUE(frames > DEVICES * 10);
+    TEST_ASSERT_EQUAL(0, overlaps);
+    TEST_ASSERT_TRUE(maxDrift <= 20);
+    TEST_ASSERT_TRUE(maxError < TDMA_GUARD_MS);
+    TEST_ASSERT_TRUE(worst <= TDMA_BEACON_PERIOD_MS + TDMA_SLOT_MS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_beacon_roundtrip);
+    RUN_TEST(test_plan_moves_colliding_devices);
+    RUN_TEST(test_drift_is_measured_and_corrected);
+    RUN_TEST(test_slots_never_collide_at_scale);
+    return UNITY_END();
+}